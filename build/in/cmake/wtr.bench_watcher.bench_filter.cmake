@@ -0,0 +1,31 @@
+# [filter bench]
+
+set(RUNTIME_TEST_FILES
+  "${BENCH_FILTER_SOURCES}")
+
+add_executable("${BENCH_PROJECT_NAME}.bench_filter"
+  "${BENCH_FILTER_SOURCES}")
+
+set_property(TARGET "${BENCH_PROJECT_NAME}.bench_filter" PROPERTY
+  CXX_STANDARD 20)
+
+target_compile_options("${BENCH_PROJECT_NAME}.bench_filter" PRIVATE
+  "${BENCH_COMPILE_OPTIONS}")
+target_link_options("${BENCH_PROJECT_NAME}.bench_filter" PRIVATE
+  "${BENCH_LINK_OPTIONS}")
+
+target_include_directories("${BENCH_PROJECT_NAME}.bench_filter" PUBLIC
+  "${BENCH_INCLUDE_PATH}")
+target_link_libraries("${BENCH_PROJECT_NAME}.bench_filter" PRIVATE
+  "${BENCH_LINK_LIBRARIES}")
+
+if(APPLE)
+  set_property(TARGET "${BENCH_PROJECT_NAME}.bench_filter" PROPERTY
+    XCODE_ATTRIBUTE_PRODUCT_BUNDLE_IDENTIFIER
+    "org.wtr.watcher.bench_filter")
+endif()
+
+install(TARGETS                    "${BENCH_PROJECT_NAME}.bench_filter"
+        LIBRARY DESTINATION        "${CMAKE_INSTALL_LIBDIR}"
+        BUNDLE DESTINATION         "${CMAKE_INSTALL_PREFIX}/bin"
+        PUBLIC_HEADER DESTINATION  "${CMAKE_INSTALL_INCLUDEDIR}")
@@ -0,0 +1,31 @@
+# [latency bench]
+
+set(RUNTIME_TEST_FILES
+  "${BENCH_LATENCY_SOURCES}")
+
+add_executable("${BENCH_PROJECT_NAME}.bench_latency"
+  "${BENCH_LATENCY_SOURCES}")
+
+set_property(TARGET "${BENCH_PROJECT_NAME}.bench_latency" PROPERTY
+  CXX_STANDARD 20)
+
+target_compile_options("${BENCH_PROJECT_NAME}.bench_latency" PRIVATE
+  "${BENCH_COMPILE_OPTIONS}")
+target_link_options("${BENCH_PROJECT_NAME}.bench_latency" PRIVATE
+  "${BENCH_LINK_OPTIONS}")
+
+target_include_directories("${BENCH_PROJECT_NAME}.bench_latency" PUBLIC
+  "${BENCH_INCLUDE_PATH}")
+target_link_libraries("${BENCH_PROJECT_NAME}.bench_latency" PRIVATE
+  "${BENCH_LINK_LIBRARIES}")
+
+if(APPLE)
+  set_property(TARGET "${BENCH_PROJECT_NAME}.bench_latency" PROPERTY
+    XCODE_ATTRIBUTE_PRODUCT_BUNDLE_IDENTIFIER
+    "org.wtr.watcher.bench_latency")
+endif()
+
+install(TARGETS                    "${BENCH_PROJECT_NAME}.bench_latency"
+        LIBRARY DESTINATION        "${CMAKE_INSTALL_LIBDIR}"
+        BUNDLE DESTINATION         "${CMAKE_INSTALL_PREFIX}/bin"
+        PUBLIC_HEADER DESTINATION  "${CMAKE_INSTALL_INCLUDEDIR}")
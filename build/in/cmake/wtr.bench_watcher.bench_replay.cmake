@@ -0,0 +1,31 @@
+# [replay bench]
+
+set(RUNTIME_TEST_FILES
+  "${BENCH_REPLAY_SOURCES}")
+
+add_executable("${BENCH_PROJECT_NAME}.bench_replay"
+  "${BENCH_REPLAY_SOURCES}")
+
+set_property(TARGET "${BENCH_PROJECT_NAME}.bench_replay" PROPERTY
+  CXX_STANDARD 20)
+
+target_compile_options("${BENCH_PROJECT_NAME}.bench_replay" PRIVATE
+  "${BENCH_COMPILE_OPTIONS}")
+target_link_options("${BENCH_PROJECT_NAME}.bench_replay" PRIVATE
+  "${BENCH_LINK_OPTIONS}")
+
+target_include_directories("${BENCH_PROJECT_NAME}.bench_replay" PUBLIC
+  "${BENCH_INCLUDE_PATH}")
+target_link_libraries("${BENCH_PROJECT_NAME}.bench_replay" PRIVATE
+  "${BENCH_LINK_LIBRARIES}")
+
+if(APPLE)
+  set_property(TARGET "${BENCH_PROJECT_NAME}.bench_replay" PROPERTY
+    XCODE_ATTRIBUTE_PRODUCT_BUNDLE_IDENTIFIER
+    "org.wtr.watcher.bench_replay")
+endif()
+
+install(TARGETS                    "${BENCH_PROJECT_NAME}.bench_replay"
+        LIBRARY DESTINATION        "${CMAKE_INSTALL_LIBDIR}"
+        BUNDLE DESTINATION         "${CMAKE_INSTALL_PREFIX}/bin"
+        PUBLIC_HEADER DESTINATION  "${CMAKE_INSTALL_INCLUDEDIR}")
@@ -11,6 +11,15 @@ FetchContent_MakeAvailable(snitch)
 # [target definitions]
 set(BENCH_PROJECT_NAME                     "wtr.bench_watcher")
 set(BENCH_CONCURRENT_WATCH_TARGETS_SOURCES "../../src/bench_watcher/bench_concurrent_watch_targets/bench_concurrent_watch_targets.cpp")
+set(BENCH_FILTER_SOURCES                   "../../src/bench_watcher/bench_filter/bench_filter.cpp")
+set(BENCH_DISPATCH_SOURCES                 "../../src/bench_watcher/bench_dispatch/bench_dispatch.cpp")
+set(BENCH_THROUGHPUT_SOURCES               "../../src/bench_watcher/bench_throughput/bench_throughput.cpp")
+set(BENCH_LATENCY_SOURCES                  "../../src/bench_watcher/bench_latency/bench_latency.cpp")
+set(BENCH_STARTUP_SOURCES                  "../../src/bench_watcher/bench_startup/bench_startup.cpp")
+set(BENCH_TEARDOWN_SOURCES                 "../../src/bench_watcher/bench_teardown/bench_teardown.cpp")
+set(BENCH_REPLAY_SOURCES                   "../../src/bench_watcher/bench_replay/bench_replay.cpp")
+set(BENCH_SYNTHETIC_SOURCES                "../../src/bench_watcher/bench_synthetic/bench_synthetic.cpp")
+set(BENCH_ROUTER_SOURCES                   "../../src/bench_watcher/bench_router/bench_router.cpp")
 set(BENCH_LINK_LIBRARIES                   "${LINK_LIBRARIES}" "snitch::snitch")
 set(BENCH_COMPILE_OPTIONS                  "${COMPILE_OPTIONS}")
 set(BENCH_LINK_OPTIONS                     "${LINK_OPTIONS}")
@@ -18,3 +27,12 @@ set(BENCH_INCLUDE_PATH                     "${INCLUDE_PATH}")
 
 # [targets]
 include("${BENCH_PROJECT_NAME}.bench_concurrent_watch_targets")
+include("${BENCH_PROJECT_NAME}.bench_filter")
+include("${BENCH_PROJECT_NAME}.bench_dispatch")
+include("${BENCH_PROJECT_NAME}.bench_throughput")
+include("${BENCH_PROJECT_NAME}.bench_latency")
+include("${BENCH_PROJECT_NAME}.bench_startup")
+include("${BENCH_PROJECT_NAME}.bench_teardown")
+include("${BENCH_PROJECT_NAME}.bench_replay")
+include("${BENCH_PROJECT_NAME}.bench_synthetic")
+include("${BENCH_PROJECT_NAME}.bench_router")
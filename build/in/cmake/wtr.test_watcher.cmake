@@ -17,6 +17,26 @@ set(TEST_CONCURRENT_WATCH_TARGETS_SOURCES "../../src/test_watcher/test_concurren
 set(TEST_WATCH_TARGETS_SOURCES            "../../src/test_watcher/test_watch_targets/test_watch_targets.cpp")
 set(TEST_NEW_DIRECTORIES_SOURCES          "../../src/test_watcher/test_new_directories/test_new_directories.cpp")
 set(TEST_SIMPLE_SOURCES                   "../../src/test_watcher/test_simple/test_simple.cpp")
+set(TEST_COLLAPSE_SOURCES                 "../../src/test_watcher/test_collapse/test_collapse.cpp")
+set(TEST_COALESCE_SOURCES                 "../../src/test_watcher/test_coalesce/test_coalesce.cpp")
+set(TEST_ATOMIC_SAVE_SOURCES              "../../src/test_watcher/test_atomic_save/test_atomic_save.cpp")
+set(TEST_FILTER_SOURCES                   "../../src/test_watcher/test_filter/test_filter.cpp")
+set(TEST_GITIGNORE_SOURCES                "../../src/test_watcher/test_gitignore/test_gitignore.cpp")
+set(TEST_COMPACT_SOURCES                  "../../src/test_watcher/test_compact/test_compact.cpp")
+set(TEST_BATCH_SOURCES                    "../../src/test_watcher/test_batch/test_batch.cpp")
+set(TEST_CLOCK_SOURCES                    "../../src/test_watcher/test_clock/test_clock.cpp")
+set(TEST_DIAG_SOURCES                     "../../src/test_watcher/test_diag/test_diag.cpp")
+set(TEST_METRICS_SOURCES                  "../../src/test_watcher/test_metrics/test_metrics.cpp")
+set(TEST_TRACE_SOURCES                    "../../src/test_watcher/test_trace/test_trace.cpp")
+set(TEST_GROUP_SOURCES                    "../../src/test_watcher/test_group/test_group.cpp")
+set(TEST_REPLAY_SOURCES                   "../../src/test_watcher/test_replay/test_replay.cpp")
+set(TEST_SYNTHETIC_SOURCES                "../../src/test_watcher/test_synthetic/test_synthetic.cpp")
+set(TEST_STRESS_SOURCES                   "../../src/test_watcher/test_stress/test_stress.cpp")
+set(TEST_MULTI_ROOT_SOURCES               "../../src/test_watcher/test_multi_root/test_multi_root.cpp")
+set(TEST_LIVE_ROOTS_SOURCES               "../../src/test_watcher/test_live_roots/test_live_roots.cpp")
+set(TEST_SHARE_SOURCES                    "../../src/test_watcher/test_share/test_share.cpp")
+set(TEST_ROUTER_SOURCES                   "../../src/test_watcher/test_router/test_router.cpp")
+set(TEST_POLICY_SOURCES                   "../../src/test_watcher/test_policy/test_policy.cpp")
 set(TEST_LINK_LIBRARIES                   "${LINK_LIBRARIES}" "snitch::snitch")
 set(TEST_COMPILE_OPTIONS                  "${COMPILE_OPTIONS}")
 set(TEST_LINK_OPTIONS                     "${LINK_OPTIONS}")
@@ -27,3 +47,23 @@ include("${TEST_PROJECT_NAME}.test_watch_targets")
 include("${TEST_PROJECT_NAME}.test_concurrent_watch_targets")
 include("${TEST_PROJECT_NAME}.test_new_directories")
 include("${TEST_PROJECT_NAME}.test_simple")
+include("${TEST_PROJECT_NAME}.test_collapse")
+include("${TEST_PROJECT_NAME}.test_coalesce")
+include("${TEST_PROJECT_NAME}.test_atomic_save")
+include("${TEST_PROJECT_NAME}.test_filter")
+include("${TEST_PROJECT_NAME}.test_gitignore")
+include("${TEST_PROJECT_NAME}.test_compact")
+include("${TEST_PROJECT_NAME}.test_batch")
+include("${TEST_PROJECT_NAME}.test_clock")
+include("${TEST_PROJECT_NAME}.test_diag")
+include("${TEST_PROJECT_NAME}.test_metrics")
+include("${TEST_PROJECT_NAME}.test_trace")
+include("${TEST_PROJECT_NAME}.test_group")
+include("${TEST_PROJECT_NAME}.test_replay")
+include("${TEST_PROJECT_NAME}.test_synthetic")
+include("${TEST_PROJECT_NAME}.test_stress")
+include("${TEST_PROJECT_NAME}.test_multi_root")
+include("${TEST_PROJECT_NAME}.test_live_roots")
+include("${TEST_PROJECT_NAME}.test_share")
+include("${TEST_PROJECT_NAME}.test_router")
+include("${TEST_PROJECT_NAME}.test_policy")
@@ -0,0 +1,31 @@
+# [collapse test]
+
+set(RUNTIME_TEST_FILES
+  "${TEST_COLLAPSE_SOURCES}")
+
+add_executable("${TEST_PROJECT_NAME}.test_collapse"
+  "${TEST_COLLAPSE_SOURCES}")
+
+set_property(TARGET "${TEST_PROJECT_NAME}.test_collapse" PROPERTY
+  CXX_STANDARD 20)
+
+target_compile_options("${TEST_PROJECT_NAME}.test_collapse" PRIVATE
+  "${TEST_COMPILE_OPTIONS}")
+target_link_options("${TEST_PROJECT_NAME}.test_collapse" PRIVATE
+  "${TEST_LINK_OPTIONS}")
+
+target_include_directories("${TEST_PROJECT_NAME}.test_collapse" PUBLIC
+  "${TEST_INCLUDE_PATH}")
+target_link_libraries("${TEST_PROJECT_NAME}.test_collapse" PRIVATE
+  "${TEST_LINK_LIBRARIES}")
+
+if(APPLE)
+  set_property(TARGET "${TEST_PROJECT_NAME}.test_collapse" PROPERTY
+    XCODE_ATTRIBUTE_PRODUCT_BUNDLE_IDENTIFIER
+    "org.wtr.watcher.test_collapse")
+endif()
+
+install(TARGETS                    "${TEST_PROJECT_NAME}.test_collapse"
+        LIBRARY DESTINATION        "${CMAKE_INSTALL_LIBDIR}"
+        BUNDLE DESTINATION         "${CMAKE_INSTALL_PREFIX}/bin"
+        PUBLIC_HEADER DESTINATION  "${CMAKE_INSTALL_INCLUDEDIR}")
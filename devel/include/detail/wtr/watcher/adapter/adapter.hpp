@@ -2,20 +2,42 @@
 
 /*  path */
 #include <filesystem>
+/*  function */
+#include <functional>
 /*  async
     future */
 #include <future>
+/*  atomic */
+#include <atomic>
+/*  milliseconds */
+#include <chrono>
+/*  exchange */
+#include <utility>
+/*  find */
+#include <algorithm>
+/*  sleep_for */
+#include <thread>
 /*  shared_ptr
     unique_ptr */
 #include <memory>
 /*  mutex
     scoped_lock */
 #include <mutex>
+/*  optional */
+#include <optional>
 /*  unordered_map */
 #include <unordered_map>
+/*  vector */
+#include <vector>
+/*  uint32_t */
+#include <cstdint>
+/*  is_invocable_v */
+#include <type_traits>
 /*  watch
     event
-    callback */
+    callback
+    filter
+    synthetic */
 #include <wtr/watcher.hpp>
 
 namespace detail {
@@ -23,51 +45,425 @@ namespace wtr {
 namespace watcher {
 namespace adapter {
 
+/*  @brief wtr/watcher/<d>/adapter/future
+    A watcher's work, whether it should stop, what it has
+    counted so far, the roots it watches (by their place,
+    which is empty once removed) and how they have changed
+    since the watcher last looked. */
 struct future {
   using shared = std::shared_ptr<future>;
 
   mutable std::mutex lk{};
   std::future<bool> work{};
   bool closed{false};
+  ::wtr::watcher::metrics counts{};
+  std::vector<std::filesystem::path> roots{};
+  changes_type changes{};
 };
 
-inline auto open(std::filesystem::path const& path,
-                 ::wtr::watcher::event::callback const& callback) noexcept
+/*  @brief wtr/watcher/<d>/adapter/to_sink
+    What the adapter for this platform sends to: compact
+    events (or whole batches) on Linux, where the adapters
+    have the paths in their own buffers, and events
+    elsewhere. Whichever the user's callback takes is made
+    from that.
+
+    A `std::function` is kept as one. Anything else keeps
+    its own type on Linux, so that the adapters can call
+    it (and the compiler can inline it) without going
+    through a `std::function` for every event. */
+#if defined(WATER_WATCHER_ADAPTER_LINUX_FANOTIFY) \
+  || defined(WATER_WATCHER_ADAPTER_LINUX_INOTIFY)
+
+using sink_type = sink<>;
+
+inline auto to_sink(::wtr::watcher::event::callback const& callback) noexcept
+  -> sink_type
+{
+  return {[callback](::wtr::watcher::event::compact const& ev) noexcept
+          { callback(::wtr::watcher::event{ev}); }};
+}
+
+inline auto
+to_sink(::wtr::watcher::event::compact::callback const& callback) noexcept
+  -> sink_type
+{
+  return {callback};
+}
+
+inline auto to_sink(::wtr::watcher::batch::callback const& callback) noexcept
+  -> sink_type
+{
+  return {[callback](::wtr::watcher::event::compact const& ev) noexcept
+          {
+            auto const owned = ::wtr::watcher::event{ev};
+            callback(::wtr::watcher::batch{owned});
+          },
+          callback};
+}
+
+template<class Callback>
+requires(std::is_invocable_v<Callback const&, ::wtr::watcher::event const&>)
+inline auto to_sink(Callback const& callback) noexcept
+{
+  auto each = [callback](::wtr::watcher::event::compact const& ev) noexcept
+  { callback(::wtr::watcher::event{ev}); };
+  return sink<decltype(each)>{each};
+}
+
+template<class Callback>
+requires(
+  std::is_invocable_v<Callback const&, ::wtr::watcher::event::compact const&>
+  and not std::is_invocable_v<Callback const&, ::wtr::watcher::event const&>)
+inline auto to_sink(Callback const& callback) noexcept -> sink<Callback>
+{
+  return {callback};
+}
+
+template<class Callback>
+requires(std::is_invocable_v<Callback const&, ::wtr::watcher::batch const&>
+         and not std::is_invocable_v<Callback const&,
+                                     ::wtr::watcher::event const&>)
+inline auto to_sink(Callback const& callback) noexcept -> sink_type
+{
+  return to_sink(::wtr::watcher::batch::callback{callback});
+}
+
+#else
+
+using sink_type = ::wtr::watcher::event::callback;
+
+inline auto to_sink(::wtr::watcher::event::callback const& callback) noexcept
+  -> sink_type
+{
+  return callback;
+}
+
+inline auto
+to_sink(::wtr::watcher::event::compact::callback const& callback) noexcept
+  -> sink_type
+{
+  return [callback](::wtr::watcher::event const& ev) noexcept
+  { callback(::wtr::watcher::event::compact{ev}); };
+}
+
+inline auto to_sink(::wtr::watcher::batch::callback const& callback) noexcept
+  -> sink_type
+{
+  return [callback](::wtr::watcher::event const& ev) noexcept
+  { callback(::wtr::watcher::batch{ev}); };
+}
+
+template<class Callback>
+requires(std::is_invocable_v<Callback const&, ::wtr::watcher::event const&>)
+inline auto to_sink(Callback const& callback) noexcept -> sink_type
+{
+  return callback;
+}
+
+template<class Callback>
+requires(
+  std::is_invocable_v<Callback const&, ::wtr::watcher::event::compact const&>
+  and not std::is_invocable_v<Callback const&, ::wtr::watcher::event const&>)
+inline auto to_sink(Callback const& callback) noexcept -> sink_type
+{
+  return to_sink(::wtr::watcher::event::compact::callback{callback});
+}
+
+template<class Callback>
+requires(std::is_invocable_v<Callback const&, ::wtr::watcher::batch const&>
+         and not std::is_invocable_v<Callback const&,
+                                     ::wtr::watcher::event const&>)
+inline auto to_sink(Callback const& callback) noexcept -> sink_type
+{
+  return to_sink(::wtr::watcher::batch::callback{callback});
+}
+
+#endif
+
+/*  @brief wtr/watcher/<d>/adapter/diags_of
+    The diagnostic callback which came with the user's
+    callback, if one did. See `with_diags`. */
+template<class Callback>
+inline auto diags_of(Callback const& callback) noexcept
+  -> ::wtr::watcher::diag::callback
+{
+  if constexpr (requires { callback.diags; })
+    return callback.diags;
+  else
+    return {};
+}
+
+/*  @brief wtr/watcher/<d>/adapter/synthetic_of
+    The stream a watcher makes up when every watcher is
+    synthetic: its policy's `synthetic`, if it has one. */
+template<class Policy>
+inline auto synthetic_of() noexcept -> ::wtr::watcher::synthetic
+{
+  if constexpr (requires { Policy::synthetic; })
+    return Policy::synthetic;
+  else
+    return {};
+}
+
+/*  @brief wtr/watcher/<d>/adapter/open
+    Starts a watcher on `roots` and gives back a way to
+    close it. On Linux, what is read from the kernel is
+    stamped from `clock`. Elsewhere, events are stamped
+    by the system clock as they are made, and say so.
+
+    Each event says which of `roots` it happened beneath.
+    On Linux, they are all watched with one kernel instance
+    (and one thread). Elsewhere, each is watched on its own
+    thread, and its events are stamped with its place among
+    them, while another thread looks for new roots. They
+    take turns with the callback: it is only ever called
+    from one of them at a time.
+
+    Roots can be added and removed while the watcher runs.
+    See `add` and `remove`.
+
+    The Linux adapters and `warthog` are compiled for
+    `Policy`. The others don't know about it, so only
+    our first message (that we are alive) follows it.
+
+    The Linux adapters `tell` a diagnostic callback what
+    they have to say, without putting messages together.
+    Elsewhere, the messages are read back for it.
+
+    What the watcher does is counted in the future. The
+    Linux adapters and `warthog` count what they read, and
+    every adapter counts what it sends.
+
+    Every adapter traces what it sends. The Linux adapters
+    and `warthog` trace the rest. See `trace`.
+
+    Given a `stream`, the watcher makes its events up,
+    with the synthetic adapter, beneath the first of
+    `roots`, instead of watching them. With
+    `WATER_WATCHER_USE_SYNTHETIC` defined, they all do.
+    See `synthetic`. */
+template<class Policy = ::wtr::watcher::policy, class Callback>
+inline auto open(std::vector<std::filesystem::path> const& roots,
+                 ::wtr::watcher::filter const& filter,
+                 Callback const& user_callback,
+                 enum ::wtr::watcher::event::clock clock = Policy::clock,
+                 std::optional<::wtr::watcher::synthetic> stream = {}) noexcept
   -> future::shared
 {
+#if defined(WATER_WATCHER_USE_SYNTHETIC)
+  if (! stream) stream = synthetic_of<Policy>();
+#endif
+
   auto fut = std::make_shared<future>();
+  fut->roots = roots;
+
+#if defined(WATER_WATCHER_ADAPTER_LINUX_FANOTIFY) \
+  || defined(WATER_WATCHER_ADAPTER_LINUX_INOTIFY)
+  auto const made = to_sink(user_callback);
+  auto const callback = sink<decltype(made.each), Policy>{made.each,
+                                                          made.batches,
+                                                          clock,
+                                                          diags_of(user_callback),
+                                                          &fut->counts};
+#else
+  using ev = ::wtr::watcher::event;
+  auto const callback = sink_type{
+    [made = to_sink(user_callback),
+     diags = diags_of(user_callback),
+     counts = &fut->counts](ev const& e) noexcept
+    {
+      using trace = typename Policy::trace;
+      if (e.kind != ev::kind::watcher) {
+        if constexpr (trace::on) trace::send_begin(e.what, e.kind);
+        auto const began = trace::on ? trace::now() : 0;
+        counts->sent([&]() noexcept { made(e); });
+        if constexpr (trace::on) trace::send_end(trace::now() - began);
+      }
+      else if (diags)
+        diags(::wtr::watcher::diag::of(e));
+      else
+        made(e);
+    }};
+#endif
+
+  if constexpr (Policy::status)
+    for (auto const& path : roots)
+#if defined(WATER_WATCHER_ADAPTER_LINUX_FANOTIFY) \
+  || defined(WATER_WATCHER_ADAPTER_LINUX_INOTIFY)
+      callback.tell({.level = ::wtr::watcher::diag::level::status,
+                     .code = ::wtr::watcher::diag::code::live,
+                     .where = path.native()});
+#else
+      callback({"s/self/live@" + path.string(),
+                ::wtr::watcher::event::what::create,
+                ::wtr::watcher::event::kind::watcher});
+#endif
 
-  callback({"s/self/live@" + path.string(),
-            ::wtr::watcher::event::what::create,
-            ::wtr::watcher::event::kind::watcher});
-
-  fut->work = std::async(std::launch::async,
-                         [path, callback, fut]() noexcept -> bool
-                         {
-                           return watch(path,
-                                        callback,
-                                        [fut]() noexcept -> bool
-                                        {
-                                          auto _ = std::scoped_lock{fut->lk};
-                                          return ! fut->closed;
-                                        });
-                         });
+  fut->work = std::async(
+    std::launch::async,
+    [roots, filter, callback, fut, clock, stream]() noexcept -> bool
+    {
+      auto is_living = [fut]() noexcept -> bool
+      {
+        auto _ = std::scoped_lock{fut->lk};
+        return ! fut->closed;
+      };
+      auto changes = [fut]() noexcept -> changes_type
+      {
+        auto _ = std::scoped_lock{fut->lk};
+        return std::exchange(fut->changes, {});
+      };
+      if (stream)
+        return synthetic::watch<Policy>(
+          roots.empty() ? std::filesystem::path{} : roots.front(),
+          filter,
+          *stream,
+          callback,
+          is_living,
+          clock,
+          &fut->counts);
+#if defined(WATER_WATCHER_ADAPTER_LINUX_FANOTIFY) \
+  || defined(WATER_WATCHER_ADAPTER_LINUX_INOTIFY)
+      return watch(roots, filter, callback, is_living, changes);
+#else
+      /* Held while any root's thread calls the callback. */
+      auto sending = std::mutex{};
+      /* Watches `path`, the `n`th root, until it is removed
+         (or we die), and says so in its events. */
+      auto const each = [&](std::uint32_t n,
+                            std::filesystem::path const& path,
+                            std::shared_ptr<std::atomic<bool>> const& kept)
+        noexcept -> bool
+      {
+        auto const living = [&]() noexcept { return *kept && is_living(); };
+        auto const stamped = sink_type{
+          [&callback, &sending, n](ev const& e)
+          {
+            auto _ = std::scoped_lock{sending};
+            if (n == 0)
+              callback(e);
+            else
+              callback({e.where, e.what, e.kind, e.when, e.clock, n});
+          }};
+#if defined(WATER_WATCHER_ADAPTER_WARTHOG)
+        return watch<Policy>(path, filter, stamped, living, &fut->counts);
+#else
+        return watch(path, filter, stamped, living);
+#endif
+      };
+      struct watching {
+        std::shared_ptr<std::atomic<bool>> kept;
+        std::future<bool> work;
+      };
+      auto all = std::vector<watching>{};
+      auto const start = [&](std::uint32_t n, std::filesystem::path const& p)
+      {
+        if (all.size() <= n) all.resize(n + 1);
+        auto kept = std::make_shared<std::atomic<bool>>(true);
+        all[n] = {kept, std::async(std::launch::async, each, n, p, kept)};
+      };
+      for (auto n = std::uint32_t{0}; n < roots.size(); ++n)
+        start(n, roots[n]);
+      /* Roots come and go while we live. */
+      while (is_living()) {
+        for (auto const& c : changes())
+          if (c.what == change::what::add)
+            start(c.root, c.path);
+          else if (c.root < all.size() && all[c.root].kept)
+            *all[c.root].kept = false;
+        std::this_thread::sleep_for(
+          std::chrono::milliseconds(std::max(Policy::delay_ms, 1)));
+      }
+      auto ok = true;
+      for (auto& one : all)
+        if (one.work.valid()) ok = one.work.get() && ok;
+      return ok;
+#endif
+    });
 
   return fut;
 };
 
-inline auto close(future::shared const& fut) noexcept -> bool
+/*  @brief wtr/watcher/<d>/adapter/open
+    The same, for one path. */
+template<class Policy = ::wtr::watcher::policy, class Callback>
+inline auto open(std::filesystem::path const& path,
+                 ::wtr::watcher::filter const& filter,
+                 Callback const& user_callback,
+                 enum ::wtr::watcher::event::clock clock = Policy::clock,
+                 std::optional<::wtr::watcher::synthetic> stream = {}) noexcept
+  -> future::shared
 {
-  if (! fut->closed) {
-    {
-      auto _ = std::scoped_lock{fut->lk};
-      fut->closed = true;
-    }
-    return fut->work.get();
-  }
+  return open<Policy>(std::vector<std::filesystem::path>{path},
+                      filter,
+                      user_callback,
+                      clock,
+                      stream);
+};
 
-  else
-    return false;
+/*  @brief wtr/watcher/<d>/adapter/add
+    Asks a running watcher to watch `path` as well, and
+    gives back its place among the watcher's roots, which
+    its events will say. Nothing, if the watcher was told
+    to stop. The watcher marks it on its own thread, the
+    next time it looks, which is after its next read or
+    within `Policy::delay_ms`. */
+inline auto add(future::shared const& fut,
+                std::filesystem::path const& path) noexcept
+  -> std::optional<std::uint32_t>
+{
+  auto _ = std::scoped_lock{fut->lk};
+  if (fut->closed) return std::nullopt;
+  auto const root = (std::uint32_t)fut->roots.size();
+  fut->roots.push_back(path);
+  fut->changes.push_back({change::what::add, root, path});
+  return root;
+};
+
+/*  @brief wtr/watcher/<d>/adapter/remove
+    Asks a running watcher to stop watching `path`, which
+    was one of its roots. Events for the other roots keep
+    coming as they were. Returns false if `path` isn't one
+    of its roots, or if the watcher was told to stop. */
+inline auto remove(future::shared const& fut,
+                   std::filesystem::path const& path) noexcept -> bool
+{
+  auto _ = std::scoped_lock{fut->lk};
+  if (fut->closed || path.empty()) return false;
+  auto const at = std::find(fut->roots.begin(), fut->roots.end(), path);
+  if (at == fut->roots.end()) return false;
+  at->clear();
+  fut->changes.push_back(
+    {change::what::remove, (std::uint32_t)(at - fut->roots.begin()), path});
+  return true;
+};
+
+/*  @brief wtr/watcher/<d>/adapter/stop
+    Tells a watcher to stop, without waiting for it to.
+    Returns false if it was already told. */
+inline auto stop(future::shared const& fut) noexcept -> bool
+{
+  auto _ = std::scoped_lock{fut->lk};
+  if (fut->closed) return false;
+  fut->closed = true;
+  return true;
+};
+
+/*  @brief wtr/watcher/<d>/adapter/join
+    Waits for a watcher which was told to stop to do so.
+    Returns whether it did so cleanly, or false if it was
+    already waited for. Only whoever stopped it (whose
+    `stop` said true) waits for it: its future can't be
+    waited on from two threads at once. */
+inline auto join(future::shared const& fut) noexcept -> bool
+{
+  return fut->work.valid() ? fut->work.get() : false;
+};
+
+inline auto close(future::shared const& fut) noexcept -> bool
+{
+  return stop(fut) ? join(fut) : false;
 };
 
 }  // namespace adapter
@@ -0,0 +1,41 @@
+#pragma once
+
+/*  uint32_t */
+#include <cstdint>
+/*  path */
+#include <filesystem>
+/*  function */
+#include <functional>
+/*  vector */
+#include <vector>
+
+namespace detail {
+namespace wtr {
+namespace watcher {
+namespace adapter {
+
+/*  @brief wtr/watcher/<d>/adapter/change
+    A root added to, or removed from, a watcher which is
+    running. `root` is its place among the watcher's roots,
+    which is what its events say. A removed root's place
+    isn't given to another, so the others keep theirs.
+
+    The adapters take what has changed as they go, between
+    reads, from `changes_fn`, and watch (or stop watching)
+    only the tree beneath that root. */
+struct change {
+  enum class what { add, remove };
+
+  enum what what {};
+  std::uint32_t root{};
+  std::filesystem::path path{};
+};
+
+using changes_type = std::vector<change>;
+
+using changes_fn = std::function<changes_type()>;
+
+} /* namespace adapter */
+} /* namespace watcher */
+} /* namespace wtr */
+} /* namespace detail */
@@ -20,7 +20,8 @@
 #include <chrono>
 /* function */
 #include <functional>
-/* path */
+/* path
+   weakly_canonical */
 #include <filesystem>
 /* numeric_limits */
 #include <limits>
@@ -31,6 +32,8 @@
 /* string
    to_string */
 #include <string>
+/* error_code */
+#include <system_error>
 /* sleep_for */
 #include <thread>
 /* tuple
@@ -43,7 +46,9 @@
 /* unordered_set */
 #include <unordered_set>
 /* event
-   callback */
+   callback
+   filter
+   beneath */
 #include <wtr/watcher.hpp>
 
 namespace detail {
@@ -55,6 +60,9 @@ namespace {
 struct argptr_type {
   ::wtr::watcher::event::callback const& callback;
   std::unordered_set<std::string>* seen_created_paths;
+  /* Our own copy, which reads the `.gitignore`s if it should. */
+  ::wtr::watcher::filter filter;
+  std::string root;
 };
 
 inline constexpr auto delay_ms = std::chrono::milliseconds(16);
@@ -168,8 +176,8 @@ inline bool event_stream_close(
     return false;
 }
 
-inline std::filesystem::path path_from_event_at(void* event_recv_paths,
-                                                unsigned long i) noexcept
+inline char const* path_from_event_at(void* event_recv_paths,
+                                      unsigned long i) noexcept
 {
   /*  We make a path from a C string...
       In an array, in a dictionary...
@@ -182,8 +190,6 @@ inline std::filesystem::path path_from_event_at(void* event_recv_paths,
       which it gave us. Nothing should be able to be null.
       We'll check anyway, just in case Darwin lies. */
 
-  namespace fs = std::filesystem;
-
   auto cstr =
     CFStringGetCStringPtr(static_cast<CFStringRef>(CFDictionaryGetValue(
                             static_cast<CFDictionaryRef>(CFArrayGetValueAtIndex(
@@ -192,7 +198,7 @@ inline std::filesystem::path path_from_event_at(void* event_recv_paths,
                             kFSEventStreamEventExtendedDataPathKey)),
                           kCFStringEncodingUTF8);
 
-  return cstr ? fs::path{cstr} : fs::path{};
+  return cstr;
 }
 
 /* @note
@@ -223,15 +229,15 @@ inline void event_recv(ConstFSEventStreamRef,    /* `ConstFS..` is important */
 
   if (arg_ptr && recv_paths) {
 
-    auto [callback, seen_created] = *static_cast<argptr_type*>(arg_ptr);
+    auto& [callback, seen_created, filter, root] =
+      *static_cast<argptr_type*>(arg_ptr);
 
-    for (unsigned long i = 0; i < recv_count; i++) {
-      auto path = path_from_event_at(recv_paths, i);
+    auto reload = false;
 
-      if (! path.empty()) {
-        /* `path` has no hash function, so we use a string. */
-        auto path_str = path.string();
+    for (unsigned long i = 0; i < recv_count; i++) {
+      auto cstr = path_from_event_at(recv_paths, i);
 
+      if (cstr && *cstr) {
         decltype(*recv_flags) flag = recv_flags[i];
 
         /* A single path won't have different "kinds". */
@@ -242,6 +248,17 @@ inline void event_recv(ConstFSEventStreamRef,    /* `ConstFS..` is important */
                  ? evk::hard_link
                  : evk::other;
 
+        /* Match the path before we make anything out of it. */
+        using ::detail::wtr::watcher::filter::beneath;
+        auto const rel = beneath<char>(cstr, root);
+        if (filter.reloads(rel.substr(rel.rfind('/') + 1))) reload = true;
+        if (! filter.keeps(rel, k)) continue;
+
+        auto path = std::filesystem::path{cstr};
+
+        /* `path` has no hash function, so we use a string. */
+        auto path_str = path.string();
+
         /* More than one thing might have happened to the same path.
            (Which is why we use non-exclusive `if`s.) */
         if (flag & kFSEventStreamEventFlagItemCreated) {
@@ -265,12 +282,16 @@ inline void event_recv(ConstFSEventStreamRef,    /* `ConstFS..` is important */
         }
       }
     }
+
+    /* A `.gitignore` changed. */
+    if (reload) filter = filter.loaded(root);
   }
 }
 
 } /* namespace */
 
 inline bool watch(std::filesystem::path const& path,
+                  ::wtr::watcher::filter const& filter,
                   ::wtr::watcher::event::callback const& callback,
                   std::function<bool()> const& is_living) noexcept
 {
@@ -279,7 +300,14 @@ inline bool watch(std::filesystem::path const& path,
   using std::this_thread::sleep_for;
 
   auto seen_created_paths = std::unordered_set<std::string>{};
-  auto event_recv_argptr = argptr_type{callback, &seen_created_paths};
+  /* Darwin tells us where things are without symlinks
+     or relative parts, so that is what we match beneath. */
+  auto ec = std::error_code{};
+  auto event_recv_argptr =
+    argptr_type{callback,
+                &seen_created_paths,
+                filter.loaded(path),
+                std::filesystem::weakly_canonical(path, ec).string()};
 
   auto stream_resources =
     event_stream_open(path, event_recv, event_recv_argptr);
@@ -31,32 +31,55 @@
 #include <unistd.h>
 /*  errno */
 #include <cerrno>
-/*  PATH_MAX */
+/*  uint32_t
+    uint64_t */
+#include <cstdint>
+/*  size_t */
+#include <cstddef>
+/*  PATH_MAX
+    NAME_MAX */
 #include <climits>
 /*  snprintf */
 #include <cstdio>
-/*  strerror */
+/*  strcmp */
 #include <cstring>
 /*  path
     is_directory
+    weakly_canonical
     directory_options
     recursive_directory_iterator */
 #include <filesystem>
-/*  function */
+/*  function
+    hash
+    equal_to
+    less */
 #include <functional>
+/*  multimap */
+#include <map>
 /*  optional */
 #include <optional>
+/*  string */
+#include <string>
+/*  string_view */
+#include <string_view>
 /*  error_code */
 #include <system_error>
 /*  unordered_map */
 #include <unordered_map>
 /*  unordered_set */
 #include <unordered_set>
+/*  vector */
+#include <vector>
 /*  tuple
     make_tuple */
 #include <tuple>
 /*  event
-    callback */
+    callback
+    filter
+    beneath
+    roots_type
+    root_of
+    change */
 #include <wtr/watcher.hpp>
 
 namespace detail {
@@ -66,33 +89,23 @@ namespace adapter {
 namespace fanotify {
 
 /*  @brief wtr/watcher/<d>/adapter/linux/fanotify/<a>/constants
-    - delay
-      The delay, in milliseconds, while `epoll_wait` will
-      'sleep' for until we are woken up. We usually check
-      if we're still alive at that point.
-
-    - event_wait_queue_max
-      Number of events allowed to be given to recv
-      (returned by `epoll_wait`). Any number between 1
-      and some large number should be fine. We don't
-      lose events if we 'miss' them, the events are
-      still waiting in the next call to `epoll_wait`.
-
-    - event_buf_len:
-      For our event buffer, 4096 is a typical page size
-      and sufficiently large to hold a great many events.
-      That's a good thumb-rule, and it might be the best
-      value to use because there will be a possibly long
-      character string (for the filename) in the event.
-      We can infer some things about the size we need for
-      the event buffer, but it's unlikely to be meaningful
-      because of the variably sized character string being
-      reported. We could use something like:
-          event_buf_len
-            = ((event_wait_queue_max + PATH_MAX)
-            * (3 * sizeof(fanotify_event_metadata)));
-      But that's a lot of flourish for 72 bytes that won't
-      be meaningful.
+    The delay, the size of our event buffer and how many
+    events we take from `epoll_wait` are in the policy.
+    For our event buffer, 4096 (the policy's default, and
+    `PATH_MAX`) is a typical page size and sufficiently
+    large to hold a great many events, each with a possibly
+    long file name. We could use something like:
+        buf_len
+          = ((wait_max + PATH_MAX)
+          * (3 * sizeof(fanotify_event_metadata)));
+    But that's a lot of flourish for 72 bytes that won't
+    be meaningful.
+
+    - fan_mark_mask:
+      Everything the policy watches. Creation, destruction
+      and moves are always asked for: we use them to mark
+      new directories and to keep our table of directories
+      up to date.
 
     - fan_init_flags:
       Post-event reporting, non-blocking IO and unlimited
@@ -104,17 +117,84 @@ namespace fanotify {
 
     - fan_init_opt_flags:
       Read-only, non-blocking, and close-on-exec. */
-inline constexpr auto delay_ms = 16;
-inline constexpr auto event_wait_queue_max = 1;
-inline constexpr auto event_buf_len = PATH_MAX;
+template<class Policy>
+inline constexpr std::uint64_t fan_mark_mask =
+  FAN_ONDIR | FAN_EVENT_ON_CHILD | FAN_CREATE | FAN_DELETE | FAN_MOVE
+  | FAN_DELETE_SELF | FAN_MOVE_SELF
+  | (Policy::watches(::wtr::watcher::event::what::modify) ? FAN_MODIFY : 0);
 inline constexpr auto fan_init_flags = FAN_CLASS_NOTIF | FAN_REPORT_DFID_NAME
                                      | FAN_UNLIMITED_QUEUE
                                      | FAN_UNLIMITED_MARKS;
 inline constexpr auto fan_init_opt_flags = O_RDONLY | O_NONBLOCK | O_CLOEXEC;
 
+/* @brief wtr/watcher/<d>/adapter/linux/fanotify/<a>/kernel
+   The calls we make to read events, to mark directories
+   and to find a directory's path from its handle. A
+   policy can make them instead. See `sys_of`. */
+struct kernel {
+  static auto read(int fd, void* buf, std::size_t len) noexcept -> ssize_t
+  {
+    return ::read(fd, buf, len);
+  }
+
+  static auto mark(int fd,
+                   unsigned flags,
+                   std::uint64_t mask,
+                   char const* path) noexcept -> int
+  {
+    return ::fanotify_mark(fd, flags, mask, AT_FDCWD, path);
+  }
+
+  /* Puts the path of the directory with the handle `fh`
+     into `into`, and returns its length, or 0 or less if
+     we couldn't find it. */
+  static auto dir_path(file_handle* fh, char* into, std::size_t len) noexcept
+    -> ssize_t
+  {
+    int fd = open_by_handle_at(AT_FDCWD,
+                               fh,
+                               O_RDONLY | O_CLOEXEC | O_PATH | O_NONBLOCK);
+    if (fd <= 0) return -1;
+    char fs_proc_path[128];
+    std::snprintf(fs_proc_path, sizeof(fs_proc_path), "/proc/self/fd/%d", fd);
+    ssize_t dirname_len = readlink(fs_proc_path, into, len);
+    close(fd);
+    return dirname_len;
+  }
+};
+
 /* @brief wtr/watcher/<d>/adapter/linux/fanotify/<a>/types
    - mark_set_type
        A set of file descriptors for fanotify resources.
+   - dir_table
+       The directories we have seen events in, interned by
+       their file handles. The kernel tells us which
+       directory something happened in by its handle, a few
+       bytes we can hash. Finding the directory's path
+       takes three syscalls (`open_by_handle_at`, `readlink`
+       and `close`), so we do that once per directory rather
+       than once per event. A directory's id is where its
+       path is in `paths`.
+         - ids
+             Ids by handle (with the filesystem's id first).
+         - paths
+             Paths by id. A handle is only interned once we
+             find its path. The path is emptied when the
+             directory (or one above it) is moved, and we
+             look again the next time we see its handle.
+         - roots
+             Which of the watcher's roots each directory is
+             beneath, by id. Found from its path, once, when
+             we first need it after finding the path.
+         - handles
+             Handles by id: views of the keys in `ids`.
+         - found
+             Ids by the paths we have found, in order, so
+             that a directory and everything beneath it are
+             next to each other.
+         - free
+             The ids of destroyed directories, whose handles
+             we have dropped, to be used again.
    - system_resources
        An object holding:
          - An fanotify file descriptor
@@ -122,27 +202,64 @@ inline constexpr auto fan_init_opt_flags = O_RDONLY | O_NONBLOCK | O_CLOEXEC;
          - An epoll configuration
          - A set of watch marks (as returned by fanotify_mark)
          - A map of (sub)path handles to filesystem paths (names)
-         - A boolean: whether or not the resources are valid */
+         - The mask we mark directories with
+         - A boolean: whether or not the resources are valid
+   - promoted_type
+       What we make of an event from the kernel:
+         - A boolean: whether or not we could make a path
+         - The path, in a buffer which the caller owns
+         - What happened
+         - The kind of thing it happened to
+         - A boolean: whether or not the filter keeps it
+         - Which root it happened beneath */
 using mark_set_type = std::unordered_set<int>;
 
+struct handle_hash {
+  using is_transparent = void;
+
+  auto operator()(std::string_view handle) const noexcept -> std::size_t
+  {
+    return std::hash<std::string_view>{}(handle);
+  }
+};
+
+struct dir_table {
+  std::unordered_map<std::string, std::size_t, handle_hash, std::equal_to<>>
+    ids;
+  std::vector<std::string> paths;
+  std::vector<std::uint32_t> roots;
+  std::vector<std::string_view> handles;
+  std::multimap<std::string, std::size_t, std::less<>> found;
+  std::vector<std::size_t> free;
+
+  static constexpr auto unknown = ~std::uint32_t{0};
+  static constexpr auto nowhere = ~std::size_t{0};
+};
+
+using promoted_type = std::tuple<bool,
+                                 std::string_view,
+                                 enum ::wtr::watcher::event::what,
+                                 enum ::wtr::watcher::event::kind,
+                                 bool,
+                                 std::uint32_t>;
+
 struct system_resources {
   bool valid;
   int watch_fd;
   int event_fd;
   epoll_event event_conf;
   mark_set_type mark_set;
+  dir_table dirs;
+  std::uint64_t mark_mask;
 };
 
+template<class Sys = kernel>
 inline auto mark(std::filesystem::path const& full_path,
                  int watch_fd,
-                 mark_set_type& ms) noexcept -> bool
+                 mark_set_type& ms,
+                 std::uint64_t mask) noexcept -> bool
 {
-  int wd = fanotify_mark(watch_fd,
-                         FAN_MARK_ADD,
-                         FAN_ONDIR | FAN_CREATE | FAN_MODIFY | FAN_DELETE
-                           | FAN_MOVE | FAN_DELETE_SELF | FAN_MOVE_SELF,
-                         AT_FDCWD,
-                         full_path.c_str());
+  int wd = Sys::mark(watch_fd, FAN_MARK_ADD, mask, full_path.c_str());
   if (wd >= 0) {
     ms.insert(wd);
     return true;
@@ -151,58 +268,261 @@ inline auto mark(std::filesystem::path const& full_path,
     return false;
 };
 
+template<class Sys = kernel>
 inline auto mark(std::filesystem::path const& full_path,
                  system_resources& sr) noexcept -> bool
 {
-  return mark(full_path, sr.watch_fd, sr.mark_set);
+  return mark<Sys>(full_path, sr.watch_fd, sr.mark_set, sr.mark_mask);
 };
 
 inline auto unmark(std::filesystem::path const& full_path,
                    int watch_fd,
-                   mark_set_type& mark_set) noexcept -> bool
+                   mark_set_type& mark_set,
+                   std::uint64_t mask) noexcept -> bool
 {
   int wd = fanotify_mark(watch_fd,
                          FAN_MARK_REMOVE,
-                         FAN_ONDIR | FAN_CREATE | FAN_MODIFY | FAN_DELETE
-                           | FAN_MOVE | FAN_DELETE_SELF | FAN_MOVE_SELF,
+                         mask,
                          AT_FDCWD,
                          full_path.c_str());
-  auto const& at = mark_set.find(wd);
 
-  if (wd >= 0 && at != mark_set.end()) {
-    mark_set.erase(at);
-    return true;
-  }
-  else
-    return false;
+  /* `fanotify_mark` gives back 0, not a descriptor, so
+     every mark is the same one in `mark_set`. We keep it,
+     because other directories are still marked. */
+  return wd >= 0 && mark_set.contains(wd);
 };
 
 inline auto unmark(std::filesystem::path const& full_path,
                    system_resources& sr) noexcept -> bool
 {
-  return unmark(full_path, sr.watch_fd, sr.mark_set);
+  return unmark(full_path, sr.watch_fd, sr.mark_set, sr.mark_mask);
+};
+
+/* @brief wtr/watcher/<d>/adapter/linux/fanotify/<a>/fns/mark_tree
+   Marks `base_path` and every directory beneath it, except
+   for those which `filter` drops everything in. Marking
+   what is already marked does nothing, so this is also how
+   we catch up when the filter changes. Invokes `callback`
+   on warnings. Returns how many directories were marked,
+   which is none if `base_path` wasn't. */
+template<class Sink>
+inline auto mark_tree(std::filesystem::path const& base_path,
+                      ::wtr::watcher::filter const& filter,
+                      int const watch_fd,
+                      mark_set_type& ms,
+                      Sink const& callback) noexcept
+  -> std::uint64_t
+{
+  namespace fs = ::std::filesystem;
+  using diag = ::wtr::watcher::diag;
+  using diter = fs::recursive_directory_iterator;
+
+  using trace = typename Sink::policy::trace;
+  using sys = sys_of<typename Sink::policy, kernel>;
+
+  static constexpr auto mask = fan_mark_mask<typename Sink::policy>;
+
+  /* Follow symlinks, ignore paths which we don't have permissions for. */
+  static constexpr auto dopt =
+    fs::directory_options::skip_permission_denied
+    & fs::directory_options::follow_directory_symlink;
+
+  auto not_watched = tally{};
+  auto marked = std::uint64_t{1};
+
+  trace::walk_begin(base_path);
+  auto const walk_began = trace::on ? trace::now() : 0;
+
+  /* Marks a directory, and tells the trace. */
+  auto const do_mark = [&](fs::path const& dir) noexcept -> bool
+  {
+    auto const ok = mark<sys>(dir, watch_fd, ms, mask);
+    trace::mark(dir, ok);
+    return ok;
+  };
+
+  try {
+    if (do_mark(base_path)) {
+      if (fs::is_directory(base_path))
+        for (auto dir = diter(base_path, dopt); dir != diter{}; ++dir)
+          if (fs::is_directory(*dir)) {
+            using ::detail::wtr::watcher::filter::beneath;
+            /* Nothing in here can be kept. */
+            if (! filter.empty()
+                && filter.prunes(filter.walk(
+                  filter.start(),
+                  beneath<char>(dir->path().native(), base_path.native())))) {
+              dir.disable_recursion_pending();
+              continue;
+            }
+            if (do_mark(dir->path()))
+              ++marked;
+            else if constexpr (Sink::policy::status)
+                not_watched(callback,
+                            {.level = diag::level::warning,
+                             .code = diag::code::not_watched,
+                             .error = errno,
+                             .where = base_path.native(),
+                             .also = dir->path().native()});
+          }
+      not_watched.done(callback);
+      trace::walk_end(base_path,
+                      marked,
+                      trace::on ? trace::now() - walk_began : 0);
+      return marked;
+    }
+  } catch (...) {}
+
+  not_watched.done(callback);
+  trace::walk_end(base_path, 0, trace::on ? trace::now() - walk_began : 0);
+  return 0;
+};
+
+/* @brief wtr/watcher/<d>/adapter/linux/fanotify/<a>/fns/mark_trees
+   The same, for every one of `roots`, with its own filter.
+   A directory beneath more than one of them is marked once.
+   A root which can't be marked is warned about, and the
+   others are watched without it. Returns how many roots
+   were marked. */
+template<class Sink>
+inline auto mark_trees(roots_type const& roots,
+                       int const watch_fd,
+                       mark_set_type& ms,
+                       Sink const& callback) noexcept
+  -> std::size_t
+{
+  using diag = ::wtr::watcher::diag;
+
+  auto marked_roots = std::size_t{0};
+  auto marked = std::uint64_t{0};
+
+  for (auto const& root : roots) {
+    if (root.path.empty()) continue;
+    auto const n = mark_tree(root.path, root.live, watch_fd, ms, callback);
+    if (n > 0)
+      ++marked_roots;
+    else if constexpr (Sink::policy::status)
+      if (roots.size() > 1)
+        callback.tell({.level = diag::level::warning,
+                       .code = diag::code::not_watched,
+                       .error = errno,
+                       .where = root.path.native()});
+    marked += n;
+  }
+
+  if (callback.counts)
+    callback.counts->marks.store(marked, std::memory_order_relaxed);
+
+  return marked_roots;
+};
+
+/* @brief wtr/watcher/<d>/adapter/linux/fanotify/<a>/fns/change_roots
+   Marks the roots added since we last looked, and unmarks
+   those removed, without touching the others. An added
+   root is marked as it would have been from the start. A
+   removed root's tree is unmarked, except for what is
+   beneath another root. Which root each directory is
+   beneath is found again, as it is next seen. */
+template<class Sink>
+inline auto change_roots(system_resources& sr,
+                         roots_type& roots,
+                         ::wtr::watcher::filter const& filter,
+                         changes_type const& changes,
+                         Sink const& callback) noexcept -> void
+{
+  namespace fs = ::std::filesystem;
+  using diag = ::wtr::watcher::diag;
+  using diter = fs::recursive_directory_iterator;
+  using policy = typename Sink::policy;
+  using trace = typename policy::trace;
+
+  static constexpr auto dopt =
+    fs::directory_options::skip_permission_denied
+    & fs::directory_options::follow_directory_symlink;
+
+  auto marks = callback.counts ? callback.counts->marks.load() : 0;
+
+  for (auto const& c : changes) {
+    if (c.root >= roots.size()) roots.resize(c.root + 1);
+
+    if (c.what == change::what::add) {
+      auto ec = std::error_code{};
+      roots[c.root] = {c.path,
+                       fs::weakly_canonical(c.path, ec).native(),
+                       filter.loaded(c.path)};
+      auto const& root = roots[c.root];
+      if constexpr (policy::status)
+        callback.tell({.level = diag::level::status,
+                       .code = diag::code::live,
+                       .where = root.path.native()});
+      auto const marked =
+        mark_tree(root.path, root.live, sr.watch_fd, sr.mark_set, callback);
+      if constexpr (policy::status)
+        if (marked == 0)
+          callback.tell({.level = diag::level::warning,
+                         .code = diag::code::not_watched,
+                         .error = errno,
+                         .where = root.path.native()});
+      marks += marked;
+    }
+
+    else if (! roots[c.root].path.empty()) {
+      auto const gone = std::move(roots[c.root]);
+      roots[c.root] = {};
+
+      /* What is beneath another root stays marked. */
+      auto const let_go = [&](fs::path const& dir) noexcept -> bool
+      {
+        if (root_of(dir.native(), roots) < roots.size()) return false;
+        auto const ok = unmark(dir, sr);
+        trace::unmark(dir, ok);
+        if (ok && marks > 0) --marks;
+        return true;
+      };
+
+      try {
+        if (let_go(gone.real) && fs::is_directory(gone.real))
+          for (auto dir = diter(gone.real, dopt); dir != diter{}; ++dir)
+            if (fs::is_directory(*dir) && ! let_go(dir->path()))
+              dir.disable_recursion_pending();
+      } catch (...) {}
+
+      if constexpr (policy::status)
+        callback.tell({.level = diag::level::status,
+                       .code = diag::code::die,
+                       .where = gone.path.native()});
+    }
+  }
+
+  for (auto& root : sr.dirs.roots) root = sr.dirs.unknown;
+
+  if (callback.counts)
+    callback.counts->marks.store(marks, std::memory_order_relaxed);
 };
 
 /* @brief wtr/watcher/<d>/adapter/linux/fanotify/<a>/fns/open_system_resources
    Produces a `system_resources` with the file descriptors from
    `fanotify_init` and `epoll_create`. Invokes `callback` on errors. */
+template<class Sink>
 inline auto
-open_system_resources(std::filesystem::path const& path,
-                      ::wtr::watcher::event::callback const& callback) noexcept
+open_system_resources(roots_type const& roots,
+                      Sink const& callback) noexcept
   -> system_resources
 {
-  namespace fs = ::std::filesystem;
-  using ev = ::wtr::watcher::event;
+  using diag = ::wtr::watcher::diag;
+
+  auto const& path = roots.empty() ? std::filesystem::path{}
+                                   : roots.front().path;
 
   auto do_error = [&path,
-                   &callback](char const* const msg,
+                   &callback](enum diag::code code,
                               int watch_fd,
                               int event_fd = -1) noexcept -> system_resources
   {
-    callback(
-      {std::string{msg} + "(" + std::strerror(errno) + ")@" + path.string(),
-       ev::what::other,
-       ev::kind::watcher});
+    callback.tell({.level = diag::level::error,
+                   .code = code,
+                   .error = errno,
+                   .where = path.native()});
 
     return system_resources{
       .valid = false,
@@ -210,45 +530,18 @@ open_system_resources(std::filesystem::path const& path,
       .event_fd = event_fd,
       .event_conf = {.events = 0, .data = {.fd = watch_fd}},
       .mark_set = {},
+      .dirs = {},
+      .mark_mask = 0,
     };
   };
 
-  auto do_path_map_container_create =
-    [](int const watch_fd,
-       fs::path const& base_path,
-       ::wtr::watcher::event::callback const& callback) -> mark_set_type
-  {
-    using diter = fs::recursive_directory_iterator;
-
-    /* Follow symlinks, ignore paths which we don't have permissions for. */
-    static constexpr auto dopt =
-      fs::directory_options::skip_permission_denied
-      & fs::directory_options::follow_directory_symlink;
-
-    static constexpr auto rsrv_count = 1024;
-
-    auto pmc = mark_set_type{};
-    pmc.reserve(rsrv_count);
-
-    try {
-      if (mark(base_path, watch_fd, pmc))
-        if (fs::is_directory(base_path))
-          for (auto& dir : diter(base_path, dopt))
-            if (fs::is_directory(dir))
-              if (! mark(dir.path(), watch_fd, pmc))
-                callback({"w/sys/not_watched@" + base_path.string() + "@"
-                            + dir.path().string(),
-                          ev::what::other,
-                          ev::kind::watcher});
-    } catch (...) {}
-
-    return pmc;
-  };
+  static constexpr auto rsrv_count = 1024;
 
   int watch_fd = fanotify_init(fan_init_flags, fan_init_opt_flags);
   if (watch_fd >= 0) {
-    auto pmc = do_path_map_container_create(watch_fd, path, callback);
-    if (! pmc.empty()) {
+    auto pmc = mark_set_type{};
+    pmc.reserve(rsrv_count);
+    if (mark_trees(roots, watch_fd, pmc, callback) > 0 || roots.empty()) {
       epoll_event event_conf{.events = EPOLLIN, .data{.fd = watch_fd}};
 
       int event_fd = epoll_create1(EPOLL_CLOEXEC);
@@ -267,17 +560,19 @@ open_system_resources(std::filesystem::path const& path,
             .event_fd = event_fd,
             .event_conf = event_conf,
             .mark_set = std::move(pmc),
+            .dirs = {},
+            .mark_mask = fan_mark_mask<typename Sink::policy>,
           };
         else
-          return do_error("e/sys/epoll_ctl", watch_fd, event_fd);
+          return do_error(diag::code::epoll_ctl, watch_fd, event_fd);
       else
-        return do_error("e/sys/epoll_create", watch_fd, event_fd);
+        return do_error(diag::code::epoll_create, watch_fd, event_fd);
     }
     else
-      return do_error("e/sys/fanotify_mark", watch_fd);
+      return do_error(diag::code::fanotify_mark, watch_fd);
   }
   else
-    return do_error("e/sys/fanotify_init", watch_fd);
+    return do_error(diag::code::fanotify_init, watch_fd);
 };
 
 /* @brief wtr/watcher/<d>/adapter/linux/fanotify/<a>/fns/close_system_resources
@@ -287,6 +582,127 @@ inline auto close_system_resources(system_resources&& sr) noexcept -> bool
   return close(sr.watch_fd) == 0 && close(sr.event_fd) == 0;
 };
 
+/*  @brief wtr/watcher/<d>/adapter/linux/fanotify/<a>/fns/decode
+    What happened, to what kind of thing, and the name of
+    that thing, from an event's metadata. The name follows
+    the directory's file handle, which is as long as it
+    says it is. */
+inline auto what_of(std::uint64_t mask) noexcept
+  -> enum ::wtr::watcher::event::what
+{
+  using evw = enum ::wtr::watcher::event::what;
+  return mask & FAN_CREATE ? evw::create
+       : mask & FAN_DELETE ? evw::destroy
+       : mask & FAN_MODIFY ? evw::modify
+       : mask & FAN_MOVE   ? evw::rename
+                           : evw::other;
+}
+
+inline auto kind_of(std::uint64_t mask) noexcept
+  -> enum ::wtr::watcher::event::kind
+{
+  return mask & FAN_ONDIR ? ::wtr::watcher::event::kind::dir
+                          : ::wtr::watcher::event::kind::file;
+}
+
+inline auto name_of(fanotify_event_metadata const* mtd) noexcept
+  -> char const*
+{
+  auto dfid_info = (fanotify_event_info_fid const*)(mtd + 1);
+  auto dir_fh = (file_handle const*)(dfid_info->handle);
+  return (char const*)(dir_fh->f_handle) + dir_fh->handle_bytes;
+}
+
+/*  @brief wtr/watcher/<d>/adapter/linux/fanotify/<a>/fns/dir_of
+    The directory an event happened in: its handle, which
+    is everything from the filesystem's id to the end of
+    the file handle, and its id in `dt`. Interns the handle
+    if we haven't seen it, and finds its path if we don't
+    have it. `forget` clears the paths of a directory and
+    everything beneath it, which we find again by their
+    handles when they are next seen. When they were
+    destroyed, it drops their handles too, and their ids
+    are used again. It only looks at the directories in
+    that tree.
+    A directory we can't find the path of (because it is
+    gone) isn't interned, and neither is one we don't know
+    which tells us about itself (as it is destroyed or
+    moved): such a record was about a directory we already
+    forgot. Those are `nowhere`. */
+inline auto handle_of(fanotify_event_metadata const* mtd) noexcept
+  -> std::string_view
+{
+  auto dfid_info = (fanotify_event_info_fid const*)(mtd + 1);
+  auto dir_fh = (file_handle const*)(dfid_info->handle);
+  auto from = (char const*)(&dfid_info->fsid);
+  auto to = (char const*)(dir_fh->f_handle) + dir_fh->handle_bytes;
+  return {from, (std::size_t)(to - from)};
+}
+
+template<class Sys = kernel>
+inline auto dir_of(fanotify_event_metadata const* mtd, dir_table& dt) noexcept
+  -> std::size_t
+{
+  auto const handle = handle_of(mtd);
+  auto const found = dt.ids.find(handle);
+  auto const known = found != dt.ids.end();
+  if (known && ! dt.paths[found->second].empty()) return found->second;
+  if (! known && std::strcmp(name_of(mtd), ".") == 0) return dt.nowhere;
+
+  auto dir_fh =
+    (file_handle*)(((fanotify_event_info_fid const*)(mtd + 1))->handle);
+  char dir_buf[PATH_MAX];
+  ssize_t dirname_len =
+    Sys::dir_path(dir_fh, dir_buf, sizeof(dir_buf) - sizeof('\0'));
+  if (dirname_len <= 0) return known ? found->second : dt.nowhere;
+
+  auto id = known ? found->second : dt.paths.size();
+  if (! known) {
+    if (! dt.free.empty()) {
+      id = dt.free.back();
+      dt.free.pop_back();
+    }
+    else {
+      dt.paths.emplace_back();
+      dt.roots.push_back(dt.unknown);
+      dt.handles.emplace_back();
+    }
+    dt.handles[id] = dt.ids.emplace(std::string{handle}, id).first->first;
+  }
+
+  dt.paths[id].assign(dir_buf, dirname_len);
+  dt.found.emplace(dt.paths[id], id);
+  dt.roots[id] = dt.unknown;
+  return id;
+}
+
+inline auto forget(dir_table& dt,
+                   std::string_view dir,
+                   bool destroyed = false) noexcept -> void
+{
+  if (dir.empty()) return;
+
+  auto const clear = [&](auto at) noexcept
+  {
+    auto const id = at->second;
+    dt.paths[id].clear();
+    dt.roots[id] = dt.unknown;
+    if (destroyed) {
+      dt.ids.erase(dt.ids.find(dt.handles[id]));
+      dt.handles[id] = {};
+      dt.free.push_back(id);
+    }
+    return dt.found.erase(at);
+  };
+
+  for (auto [at, end] = dt.found.equal_range(dir); at != end;) at = clear(at);
+
+  auto const beneath = std::string{dir} + '/';
+  for (auto at = dt.found.lower_bound(beneath);
+       at != dt.found.end() && at->first.starts_with(beneath);)
+    at = clear(at);
+}
+
 /*  @brief wtr/watcher/<d>/adapter/linux/fanotify/<a>/fns/promote
     Promotes an event's metadata to a full path.
 
@@ -323,27 +739,30 @@ inline auto close_system_resources(system_resources&& sr) noexcept -> bool
     The kernel guarentees that there is a null-terminated
     character string to the event's directory entry
     after the file handle to the directory.
-    Confusing, right? */
+    Confusing, right?
+
+    The directory's path comes from `dt`, which finds it
+    (with `readlink`) only for directories it hasn't seen.
+    The path is put together in `path_buf`, which the
+    caller owns and which we view, so nothing here (or in
+    sending the event) allocates once the directory is
+    known. So does the root the directory is beneath, whose
+    filter the path is matched against. */
 // clang-format off
 // note at the end of file re. clang format
-inline auto promote(fanotify_event_metadata const* mtd) noexcept
-  -> std::tuple<bool,
-                std::filesystem::path,
-                enum ::wtr::watcher::event::what,
-                enum ::wtr::watcher::event::kind>
+template<class Sys = kernel>
+inline auto promote(fanotify_event_metadata const* mtd,
+                    roots_type const& roots,
+                    dir_table& dt,
+                    char (&path_buf)[PATH_MAX]) noexcept
+  -> promoted_type
 {
-  namespace fs = ::std::filesystem;
   using ev = ::wtr::watcher::event;
 
-  auto path_imbue = [](char* path_accum,
-                       fanotify_event_info_fid const* dfid_info,
-                       file_handle* dir_fh,
-                       ssize_t dir_name_len = 0) noexcept -> void
+  auto path_imbue = [mtd](char* path_accum,
+                          ssize_t dir_name_len = 0) noexcept -> void
   {
-    char* name_info = (char*)(dfid_info + 1);
-    char* file_name = static_cast<char*>(
-      name_info + sizeof(file_handle) + sizeof(dir_fh->f_handle)
-      + sizeof(dir_fh->handle_bytes) + sizeof(dir_fh->handle_type));
+    char const* file_name = name_of(mtd);
 
     if (file_name && std::strcmp(file_name, ".") != 0)
       std::snprintf(path_accum + dir_name_len,
@@ -352,71 +771,82 @@ inline auto promote(fanotify_event_metadata const* mtd) noexcept
                     file_name);
   };
 
-  auto dir_fid_info = ((fanotify_event_info_fid const*)(mtd + 1));
+  auto what = what_of(mtd->mask);
 
-  auto dir_fh = (file_handle*)(dir_fid_info->handle);
+  auto kind = kind_of(mtd->mask);
 
-  auto what = mtd->mask & FAN_CREATE ? ev::what::create
-            : mtd->mask & FAN_DELETE ? ev::what::destroy
-            : mtd->mask & FAN_MODIFY ? ev::what::modify
-            : mtd->mask & FAN_MOVE   ? ev::what::rename
-                                     : ev::what::other;
+  auto const id = dir_of<Sys>(mtd, dt);
 
-  auto kind = mtd->mask & FAN_ONDIR ? ev::kind::dir : ev::kind::file;
+  /* We don't know where this happened. It isn't sent. */
+  if (id == dt.nowhere || dt.paths[id].empty()) {
+    path_buf[0] = '\0';
+    return std::make_tuple(false, std::string_view{}, what, kind, false,
+                           (std::uint32_t)roots.size());
+  }
 
-  /* We can get a path name, so get that and use it */
-  char path_buf[PATH_MAX];
-  int fd = open_by_handle_at(AT_FDCWD,
-                             dir_fh,
-                             O_RDONLY | O_CLOEXEC | O_PATH | O_NONBLOCK);
-  if (fd > 0) {
-    char fs_proc_path[128];
-    std::snprintf(fs_proc_path, sizeof(fs_proc_path), "/proc/self/fd/%d", fd);
-    ssize_t dirname_len =
-      readlink(fs_proc_path, path_buf, sizeof(path_buf) - sizeof('\0'));
-    close(fd);
+  auto const& dir = dt.paths[id];
+
+  if (dt.roots[id] == dt.unknown)
+    dt.roots[id] = root_of(dir, roots);
+
+  /* With one root, what we can't place (such as what is
+     still marked after being moved out) is sent as it
+     always was. With more, it is from a root which was
+     removed, or from none of them, and it isn't sent. */
+  auto const one = roots.size() == 1 && ! roots.front().real.empty();
+  auto const at = one                        ? 0
+                : dt.roots[id] == dt.unknown ? (std::uint32_t)roots.size()
+                                             : dt.roots[id];
+
+  /* Match the path before we make anything out of it.
+     New directories are marked whether or not we keep them,
+     unless everything in them is dropped. A `.gitignore`
+     is looked at in any case, because it changes the filter. */
+  auto promoted = [&](char const* path_accum) noexcept -> promoted_type
+  {
+    using ::detail::wtr::watcher::filter::beneath;
 
-    if (dirname_len > 0) {
-      /* Put the directory name in the path accumulator.
-         Passing `dirname_len` has the effect of putting
-         the event's filename in the path buffer as well. */
-      path_buf[dirname_len] = '\0';
-      path_imbue(path_buf, dir_fid_info, dir_fh, dirname_len);
-
-      return std::make_tuple(true,
-                             fs::path{std::move(path_buf)},
-                             what,
-                             kind);
-    }
+    if (at >= roots.size())
+      return std::make_tuple(false, std::string_view{}, what, kind, false, at);
 
-    else
-      return std::make_tuple(false, fs::path{}, what, kind);
-  }
-  else {
-    path_imbue(path_buf, dir_fid_info, dir_fh);
+    auto const& filter = roots[at].live;
 
-    return std::make_tuple(true,
-                           fs::path{std::move(path_buf)},
-                           what,
-                           kind);
-  }
+    if (filter.empty())
+      return std::make_tuple(true, std::string_view{path_accum}, what, kind, true, at);
+
+    auto const rel = beneath<char>(path_accum, roots[at].real);
+    auto const state = filter.walk(filter.start(), rel);
+    auto const keep = filter.keeps(state, kind);
+    auto const name = rel.substr(rel.rfind('/') + 1);
+
+    return keep
+        || (kind == ev::kind::dir && what == ev::what::create
+            && ! filter.prunes(state))
+        || (kind == ev::kind::file && filter.reloads(name))
+         ? std::make_tuple(true, std::string_view{path_accum}, what, kind, keep, at)
+         : std::make_tuple(false, std::string_view{}, what, kind, keep, at);
+  };
+
+  /* Put the directory name in the path accumulator.
+     Passing its length has the effect of putting the
+     event's filename in the path buffer as well. */
+  auto const dirname_len = dir.copy(path_buf, sizeof(path_buf) - sizeof('\0'));
+  path_buf[dirname_len] = '\0';
+  path_imbue(path_buf, (ssize_t)dirname_len);
+
+  return promoted(path_buf);
 };
 
 // clang-format on
 
+template<class Sys = kernel>
 inline auto
-check_and_update(std::tuple<bool,
-                            std::filesystem::path,
-                            enum ::wtr::watcher::event::what,
-                            enum ::wtr::watcher::event::kind> const& r,
+check_and_update(promoted_type const& r,
                  system_resources& sr) noexcept
-  -> std::tuple<bool,
-                std::filesystem::path,
-                enum ::wtr::watcher::event::what,
-                enum ::wtr::watcher::event::kind> {
+  -> promoted_type {
     using ev = ::wtr::watcher::event;
 
-    auto [valid, path, what, kind] = r;
+    auto [valid, path, what, kind, keep, root] = r;
 
     return std::make_tuple(
 
@@ -424,9 +854,11 @@ check_and_update(std::tuple<bool,
 
         ? kind == ev::kind::dir
 
-          ? what == ev::what::create  ? mark(path, sr)
-          : what == ev::what::destroy ? unmark(path, sr)
-                                 : true
+          /* The kernel drops the marks on a destroyed directory
+             (and everything beneath it) along with its inode.
+             We don't `unmark` here: the path is already gone. */
+          ? what == ev::what::create  ? mark<Sys>(std::filesystem::path{path}, sr)
+                                      : true
 
           : true
 
@@ -436,9 +868,96 @@ check_and_update(std::tuple<bool,
 
       what,
 
-      kind);
+      kind,
+
+      keep,
+
+      root);
   };
 
+/*  @brief wtr/watcher/<d>/adapter/linux/fanotify/<a>/batch_decoder
+    Reads the `fanotify_event_metadata` in our buffer for a
+    `batch`. Records which `recv` wouldn't send are skipped.
+    The batch's context is the table of directories, which
+    `recv` brings up to date with everything in the batch
+    before sending it. Paths are put together from it, and
+    only when asked for. */
+inline auto first_event(char const* at, char const* end) noexcept
+  -> char const*
+{
+  for (;; at += ((fanotify_event_metadata const*)at)->event_len) {
+    auto const mtd = (fanotify_event_metadata const*)at;
+    if (! FAN_EVENT_OK(mtd, end - at)) return end;
+    if (mtd->fd == FAN_NOFD && mtd->vers == FANOTIFY_METADATA_VERSION
+        && ! (mtd->mask & FAN_Q_OVERFLOW)
+        && ((fanotify_event_info_fid const*)(mtd + 1))->hdr.info_type
+             == FAN_EVENT_INFO_TYPE_DFID_NAME)
+      return at;
+  }
+}
+
+inline constexpr auto batch_decoder = ::wtr::watcher::batch::decoder{
+  .first = first_event,
+  .next = [](char const* at, char const* end) noexcept -> char const*
+  { return first_event(at + ((fanotify_event_metadata const*)at)->event_len,
+                       end); },
+  .what = [](char const* at) noexcept
+  { return what_of(((fanotify_event_metadata const*)at)->mask); },
+  .kind = [](char const* at) noexcept
+  { return kind_of(((fanotify_event_metadata const*)at)->mask); },
+  .name = [](char const* at) noexcept
+  {
+    auto const name = std::string_view{
+      name_of((fanotify_event_metadata const*)at)};
+    return name == "." ? std::string_view{} : name;
+  },
+  .dir = [](void const* context, char const* at) noexcept
+  {
+    auto const& dt = *static_cast<dir_table const*>(context);
+    auto const found =
+      dt.ids.find(handle_of((fanotify_event_metadata const*)at));
+    return found != dt.ids.end() ? found->second : dt.paths.size();
+  },
+  .dir_path = [](void const* context, std::size_t id) noexcept
+  {
+    auto const& dt = *static_cast<dir_table const*>(context);
+    return id < dt.paths.size() ? std::string_view{dt.paths[id]}
+                                : std::string_view{};
+  },
+  .where = [](void const* context, char const* at, std::string& into) noexcept
+  {
+    auto const& dt = *static_cast<dir_table const*>(context);
+    auto const mtd = (fanotify_event_metadata const*)at;
+    auto const found = dt.ids.find(handle_of(mtd));
+    if (found == dt.ids.end() || dt.paths[found->second].empty()) return false;
+    auto const name = std::string_view{name_of(mtd)};
+    into.assign(dt.paths[found->second]);
+    if (name != ".") (into += '/').append(name);
+    return true;
+  },
+};
+
+/*  @brief wtr/watcher/<d>/adapter/linux/fanotify/<a>/fns/tends
+    Whether we have to look at a record ourselves when what
+    we read goes out in batches: a new directory, to mark
+    it; a moved or destroyed one, to forget where it was;
+    and anything with a name which changes a filter. The
+    rest is left to whoever takes the batch. */
+inline auto tends(fanotify_event_metadata const* mtd,
+                  roots_type const& roots) noexcept -> bool
+{
+  using ev = ::wtr::watcher::event;
+  if (kind_of(mtd->mask) == ev::kind::dir) {
+    auto const what = what_of(mtd->mask);
+    return what == ev::what::create || what == ev::what::rename
+        || what == ev::what::destroy;
+  }
+  auto const name = std::string_view{name_of(mtd)};
+  for (auto const& root : roots)
+    if (root.live.reloads(name)) return true;
+  return false;
+}
+
 /*  @brief wtr/watcher/<d>/adapter/linux/fanotify/<a>/fns/send
     Send events to the user.
 
@@ -446,22 +965,28 @@ check_and_update(std::tuple<bool,
     Most of the other code is
     a layer of translation
     between us and the kernel. */
+template<class Sink>
 inline auto
-send(std::tuple<bool,
-                std::filesystem::path,
-                enum ::wtr::watcher::event::what,
-                enum ::wtr::watcher::event::kind> const& from_kernel,
-     ::wtr::watcher::event::callback const& callback) noexcept -> bool
+send(promoted_type const& from_kernel,
+     long long when,
+     Sink const& callback) noexcept -> bool
 {
-  auto [ok, path, what, kind] = from_kernel;
+  auto [ok, path, what, kind, keep, root] = from_kernel;
 
-  return ok ? (callback({path, what, kind}), ok) : ok;
+  /* What the policy doesn't watch was only asked for to
+     follow directories. */
+  return ok && keep && Sink::policy::watches(what)
+         ? (callback({path, what, kind, when, callback.clock, root}), ok)
+         : ok;
 };
 
 /* @brief wtr/watcher/<d>/adapter/linux/fanotify/<a>/fns/recv
    Reads through available (fanotify) filesystem events.
    Discerns their path and type.
-   Calls the callback.
+   Calls the callback. When it takes batches, only what
+   we have to look at ourselves is discerned. See `tends`.
+   Loads the filters again, and marks what they no longer
+   drop, if one of them says to when something happens.
    Returns false on eventful errors.
    @note
    The `metadata->fd` field contains either a file
@@ -475,32 +1000,78 @@ send(std::tuple<bool,
    The `metadata->vers` field may differ between kernel
    versions, so we check it against what we have been
    compiled with. */
+template<class Sink>
 inline auto recv(system_resources& sr,
-                 std::filesystem::path const& base_path,
-                 ::wtr::watcher::event::callback const& callback) noexcept
+                 roots_type& roots,
+                 Sink const& callback) noexcept
   -> bool
 {
+  using diag = ::wtr::watcher::diag;
+  using trace = typename Sink::policy::trace;
+  using sys = sys_of<typename Sink::policy, kernel>;
+
   enum class state { ok, none, err };
 
-  auto do_error = [&base_path,
-                   &callback](char const* const msg) noexcept -> bool
+  auto reload = false;
+
+  auto const& base_path = roots.front().path;
+
+  auto do_error = [&base_path, &callback](enum diag::code code,
+                                          int error = 0) noexcept -> bool
   {
-    return (callback({std::string{msg} + "@" + base_path.string(),
-                      ::wtr::watcher::event::what::other,
-                      ::wtr::watcher::event::kind::watcher}),
+    return (callback.tell({.level = diag::level::error,
+                           .code = code,
+                           .error = error,
+                           .where = base_path.native()}),
             false);
   };
 
+  /* What we couldn't make sense of in this read. */
+  auto unknown_info = tally{};
+
   /* Read some events. */
-  alignas(fanotify_event_metadata) char event_buf[event_buf_len];
-  auto event_read = read(sr.watch_fd, event_buf, sizeof(event_buf));
+  alignas(fanotify_event_metadata) char event_buf[Sink::policy::buf_len];
+  /* Where the paths we send are put together. */
+  char path_buf[PATH_MAX];
+  auto const read_began = trace::on ? trace::now() : 0;
+  auto event_read = sys::read(sr.watch_fd, event_buf, sizeof(event_buf));
+  trace::read(event_read, trace::on ? trace::now() - read_began : 0);
+
+  /* The longest record has the longest handle and name. */
+  auto const counted = counted_read{
+    callback.counts,
+    event_read,
+    sizeof(event_buf),
+    sizeof(fanotify_event_metadata) + sizeof(fanotify_event_info_fid)
+      + MAX_HANDLE_SZ + NAME_MAX + 1};
 
   switch (event_read > 0    ? state::ok
           : event_read == 0 ? state::none
           : errno == EAGAIN ? state::none
                             : state::err) {
     case state::ok : {
-      /* Loop over everything in the event buffer. */
+      /* Everything in this read happened by now. */
+      auto const when = ::wtr::watcher::event::now(callback.clock);
+
+      /* Whoever takes batches gets the buffer as it is,
+         once we know every directory in it. */
+      if (callback.batches) {
+        auto const end = event_buf + event_read;
+        for (auto at = first_event(event_buf, end); at != end;
+             at = batch_decoder.next(at, end))
+          dir_of<sys>((fanotify_event_metadata const*)at, sr.dirs);
+        callback.batches(
+          ::wtr::watcher::batch{event_buf,
+                                end,
+                                batch_decoder,
+                                &sr.dirs,
+                                when,
+                                callback.clock});
+      }
+
+      /* Loop over everything in the event buffer.
+         A single read may hold many events, such as
+         when a large tree is removed. We send them all. */
       for (auto* mtd = (fanotify_event_metadata const*)event_buf;
            FAN_EVENT_OK(mtd, event_read);
            mtd = FAN_EVENT_NEXT(mtd, event_read))
@@ -508,24 +1079,88 @@ inline auto recv(system_resources& sr,
           if (mtd->vers == FANOTIFY_METADATA_VERSION) [[likely]]
             if (! (mtd->mask & FAN_Q_OVERFLOW)) [[likely]]
               if (((fanotify_event_info_fid*)(mtd + 1))->hdr.info_type
-                  == FAN_EVENT_INFO_TYPE_DFID_NAME) [[likely]]
+                  == FAN_EVENT_INFO_TYPE_DFID_NAME) [[likely]] {
+
+                /* The batch has been sent. What is left is ours. */
+                if (callback.batches && ! tends(mtd, roots)) continue;
 
                 /* Send the events we receive. */
-                return send(check_and_update(promote(mtd), sr), callback);
+                auto const p = check_and_update<sys>(
+                  promote<sys>(mtd, roots, sr.dirs, path_buf),
+                  sr);
+
+                using ev = ::wtr::watcher::event;
+                if constexpr (trace::on) {
+                  auto const [ok, path, what, kind, keep, root] = p;
+                  trace::decoded(what, kind, path.size());
+                  /* New directories are marked as they are checked. */
+                  if (kind == ev::kind::dir && what == ev::what::create)
+                    trace::mark(std::filesystem::path{path}, ok);
+                }
+
+                if (! callback.batches) send(p, when, callback);
+
+                auto const where = std::get<1>(p);
+
+                /* What we knew about where this directory (and
+                   everything beneath it) is might be wrong now.
+                   If it was destroyed, there is nothing left to
+                   know. The path is in `path_buf`, kept or not. */
+                if (std::get<3>(p) == ev::kind::dir
+                    && (std::get<2>(p) == ev::what::rename
+                        || std::get<2>(p) == ev::what::destroy))
+                  forget(sr.dirs,
+                         std::string_view{path_buf},
+                         std::get<2>(p) == ev::what::destroy);
+
+                /* The kernel drops the mark on a destroyed
+                   directory, and we see each one destroyed. */
+                if (callback.counts && std::get<3>(p) == ev::kind::dir) {
+                  auto& marks = callback.counts->marks;
+                  auto const n = marks.load(std::memory_order_relaxed);
+                  if (std::get<2>(p) == ev::what::create && std::get<0>(p))
+                    marks.store(n + 1, std::memory_order_relaxed);
+                  else if (std::get<2>(p) == ev::what::destroy && n > 0)
+                    marks.store(n - 1, std::memory_order_relaxed);
+                }
+
+                if (std::get<0>(p)
+                    && roots[std::get<5>(p)].live.reloads(
+                      where.substr(where.rfind('/') + 1)))
+                  reload = true;
+              }
 
               else
-                return ! do_error("w/self/event_info");
-            else
-              return do_error("e/sys/overflow");
+                unknown_info(callback,
+                             {.level = diag::level::warning,
+                              .code = diag::code::event_info,
+                              .where = base_path.native()});
+            else {
+              if (callback.counts)
+                ::wtr::watcher::metrics::add(callback.counts->overflows);
+              return do_error(diag::code::overflow);
+            }
           else
-            return do_error("e/sys/kernel_version");
+            return do_error(diag::code::kernel_version);
         else
-          return do_error("e/sys/wrong_event_fd");
+          return do_error(diag::code::wrong_event_fd);
+
+      unknown_info.done(callback);
+      counted.done();
+
+      /* A `.gitignore` changed. What is newly dropped stays
+         marked, but what happens to it isn't sent. */
+      if (reload) {
+        for (auto& root : roots) root.live = root.live.loaded(root.path);
+        mark_trees(roots, sr.watch_fd, sr.mark_set, callback);
+      }
+
+      return true;
     } break;
 
     case state::none : return true; break;
 
-    case state::err : return do_error("e/sys/read"); break;
+    case state::err : return do_error(diag::code::read, errno); break;
   }
 
   /* Unreachable */
@@ -533,45 +1168,65 @@ inline auto recv(system_resources& sr,
 };
 
 /*  @brief wtr/watcher/<d>/adapter/watch
-    Monitors `path` for changes.
+    Monitors `paths` for changes, all with one `fanotify`
+    instance.
     Invokes `callback` with an `event` when they happen.
     `watch` stops when asked to or irrecoverable errors occur.
     All events, including errors, are passed to `callback`.
 
-    @param path
-    A filesystem path to watch for events.
+    @param paths
+    The filesystem paths to watch for events. Each event
+    says which of them it happened beneath.
+
+    @param filter
+    Which paths, beneath each of `paths`, to send events for.
 
     @param callback
     A function to invoke with an `event` object
     when the files being watched change.
 
     @param is_living
-    A function to decide whether we're dead. */
-inline bool watch(std::filesystem::path const& path,
-                  ::wtr::watcher::event::callback const& callback,
-                  std::function<bool()> const& is_living) noexcept
+    A function to decide whether we're dead.
+
+    @param changes
+    A function which gives us the roots added or removed
+    since we last asked. See `change`. */
+template<class Sink>
+inline bool watch(std::vector<std::filesystem::path> const& paths,
+                  ::wtr::watcher::filter const& filter,
+                  Sink const& callback,
+                  std::function<bool()> const& is_living,
+                  changes_fn const& changes = {}) noexcept
 {
-  using ev = ::wtr::watcher::event;
+  using diag = ::wtr::watcher::diag;
+  using policy = typename Sink::policy;
+
+  /* What we say about ourselves is said of the first. */
+  auto const path = paths.empty() ? std::filesystem::path{} : paths.front();
 
   auto done = [&path, &callback](system_resources&& sr) noexcept -> bool
   {
-    return
-
-      close_system_resources(std::move(sr))
-
-        ? (callback({"s/self/die@" + path.string(), ev::what::other, ev::kind::watcher}),
-           true)
+    if (close_system_resources(std::move(sr))) {
+      if constexpr (policy::status)
+        callback.tell({.level = diag::level::status,
+                       .code = diag::code::die,
+                       .where = path.native()});
+      return true;
+    }
 
-        : (callback({"e/self/die@" + path.string(), ev::what::other, ev::kind::watcher}),
-           false);
+    else
+      return (callback.tell({.level = diag::level::error,
+                             .code = diag::code::die,
+                             .where = path.native()}),
+              false);
   };
 
   auto do_error = [&path, &callback, &done](system_resources&& sr,
-                                            char const* const msg) -> bool
+                                            enum diag::code code) -> bool
   {
     return (
-      callback(
-        {std::string{msg} + "@" + path.string(), ev::what::other, ev::kind::watcher}),
+      callback.tell(
+        {.level = diag::level::error, .code = code, .where = path.native()}),
 
       done(std::move(sr)),
 
@@ -586,34 +1241,44 @@ inline bool watch(std::filesystem::path const& path,
       - Await filesystem events
       - Invoke `callback` on errors and events */
 
-  auto sr = open_system_resources(path, callback);
+  /* Our own copies, which read the `.gitignore`s if they
+     should. The kernel tells us where things are without
+     symlinks or relative parts, so that is what we match
+     beneath. */
+  auto roots = roots_of(paths, filter);
 
-  epoll_event event_recv_list[event_wait_queue_max];
+  auto sr = open_system_resources(roots, callback);
+
+  epoll_event event_recv_list[policy::wait_max];
 
   if (sr.valid) [[likely]] {
     while (is_living()) [[likely]]
 
     {
+      if (changes)
+        if (auto const changed = changes(); ! changed.empty())
+          change_roots(sr, roots, filter, changed, callback);
+
       int event_count = epoll_wait(sr.event_fd,
                                    event_recv_list,
-                                   event_wait_queue_max,
-                                   delay_ms);
+                                   policy::wait_max,
+                                   policy::delay_ms);
       if (event_count < 0)
-        return do_error(std::move(sr), "e/sys/epoll_wait");
+        return do_error(std::move(sr), diag::code::epoll_wait);
 
       else if (event_count > 0) [[likely]]
         for (int n = 0; n < event_count; n++)
           if (event_recv_list[n].data.fd == sr.watch_fd) [[likely]]
             if (is_living()) [[likely]]
-              if (! recv(sr, path, callback)) [[unlikely]]
-                return do_error(std::move(sr), "e/self/event_recv");
+              if (! recv(sr, roots, callback)) [[unlikely]]
+                return do_error(std::move(sr), diag::code::event_recv);
     }
 
     return done(std::move(sr));
   }
 
   else
-    return do_error(std::move(sr), "e/self/sys_resource");
+    return do_error(std::move(sr), diag::code::sys_resource);
 };
 
 // clang-format off
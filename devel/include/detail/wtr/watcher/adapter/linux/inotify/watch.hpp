@@ -23,7 +23,8 @@
     inotify_init
     inotify_init1
     inotify_event
-    inotify_add_watch */
+    inotify_add_watch
+    inotify_rm_watch */
 #include <sys/inotify.h>
 /* open
    read
@@ -34,6 +35,8 @@
     directory_options
     recursive_directory_iterator */
 #include <filesystem>
+/*  sort */
+#include <algorithm>
 /*  function */
 #include <functional>
 /*  tuple
@@ -41,12 +44,32 @@
 #include <tuple>
 /*  error_code */
 #include <system_error>
+/*  string */
+#include <string>
+/*  string_view */
+#include <string_view>
 /*  unordered_map */
 #include <unordered_map>
 /*  memcpy */
 #include <cstring>
+/*  uint32_t */
+#include <cstdint>
+/*  size_t */
+#include <cstddef>
+/*  move */
+#include <utility>
+/*  vector */
+#include <vector>
+/*  NAME_MAX */
+#include <climits>
 /*  event
-    callback */
+    callback
+    filter
+    policy
+    diag
+    beneath
+    roots_type
+    change */
 #include <wtr/watcher.hpp>
 
 namespace detail {
@@ -56,44 +79,63 @@ namespace adapter {
 namespace inotify {
 
 /*  @brief wtr/watcher/<d>/adapter/linux/inotify/<a>/constants
-    - delay
-        The delay, in milliseconds, while `epoll_wait` will
-        'sleep' for until we are woken up. We usually check
-        if we're still alive at that point.
-    - event_wait_queue_max
-        Number of events allowed to be given to do_event_recv
-        (returned by `epoll_wait`). Any number between 1
-        and some large number should be fine. We don't
-        lose events if we 'miss' them, the events are
-        still waiting in the next call to `epoll_wait`.
-    - event_buf_len:
-        For our event buffer, 4096 is a typical page size
-        and sufficiently large to hold a great many events.
-        That's a good thumb-rule.
+    The delay, the size of our event buffer and how many
+    events we take from `epoll_wait` are in the policy.
     - in_init_opt
         Use non-blocking IO.
     - in_watch_opt
-        Everything we can get.
+        Everything the policy watches. Both halves of a move
+        are watched, so a rename is seen on the old path and
+        then on the new one, as on the other platforms. We
+        always watch for creation, to watch new directories.
     @todo
-    - Measure perf of IN_ALL_EVENTS
-    - Handle move events properly.
-      - Use IN_MOVED_TO
-      - Use event::<something> */
-inline constexpr auto delay_ms = 16;
-inline constexpr auto event_wait_queue_max = 1;
-inline constexpr auto event_buf_len = 4096;
+    - Measure perf of IN_ALL_EVENTS */
 inline constexpr auto in_init_opt = IN_NONBLOCK;
-inline constexpr auto in_watch_opt =
-  IN_CREATE | IN_MODIFY | IN_DELETE | IN_MOVED_FROM | IN_Q_OVERFLOW;
+
+template<class Policy>
+inline constexpr std::uint32_t in_watch_opt =
+  IN_CREATE | IN_Q_OVERFLOW
+  | (Policy::watches(::wtr::watcher::event::what::modify) ? IN_MODIFY : 0)
+  | (Policy::watches(::wtr::watcher::event::what::destroy) ? IN_DELETE : 0)
+  | (Policy::watches(::wtr::watcher::event::what::rename)
+       ? IN_MOVED_FROM | IN_MOVED_TO
+       : 0);
+
+/*  @brief wtr/watcher/<d>/adapter/linux/inotify/<a>/kernel
+    The calls we make to read events and to watch new
+    directories. A policy can make them instead. See
+    `sys_of`. */
+struct kernel {
+  static auto read(int fd, void* buf, std::size_t len) noexcept -> ssize_t
+  {
+    return ::read(fd, buf, len);
+  }
+
+  static auto
+  add_watch(int fd, char const* path, std::uint32_t mask) noexcept -> int
+  {
+    return ::inotify_add_watch(fd, path, mask);
+  }
+};
 
 /*  @brief wtr/watcher/<d>/adapter/linux/inotify/<a>/types
+    - watched_dir
+        A directory's path, where the names in it start
+        from in its root's filter, and which root that is.
     - path_map_type
-        An alias for a map of file descriptors to paths.
+        An alias for a map of file descriptors to the
+        directories we watch.
     - sys_resource_type
         An object representing an inotify file descriptor,
         an epoll file descriptor, an epoll configuration,
         and whether or not the resources are valid */
-using path_map_type = std::unordered_map<int, std::filesystem::path>;
+struct watched_dir {
+  std::filesystem::path path;
+  ::wtr::watcher::filter::state state;
+  std::uint32_t root{};
+};
+
+using path_map_type = std::unordered_map<int, watched_dir>;
 
 struct sys_resource_type {
   bool valid;
@@ -106,18 +148,26 @@ struct sys_resource_type {
     If the path given is a directory
       - find all directories above the base path given.
       - ignore nonexistent directories.
+      - skip directories which `filter` drops everything in.
       - return a map of watch descriptors -> directories.
     If `path` is a file
       - return it as the only value in a map.
-      - the watch descriptor key should always be 1. */
+      - the watch descriptor key should always be 1.
+    Each directory is from the `root`th of the watcher's
+    roots. */
+template<class Sink>
 inline auto path_map(std::filesystem::path const& base_path,
-                     ::wtr::watcher::event::callback const& callback,
-                     sys_resource_type const& sr) noexcept -> path_map_type
+                     ::wtr::watcher::filter const& filter,
+                     Sink const& callback,
+                     sys_resource_type const& sr,
+                     std::uint32_t root = 0) noexcept -> path_map_type
 {
   namespace fs = ::std::filesystem;
-  using ev = ::wtr::watcher::event;
+  using diag = ::wtr::watcher::diag;
   using diter = fs::recursive_directory_iterator;
   using dopt = fs::directory_options;
+  using trace = typename Sink::policy::trace;
+  using sys = sys_of<typename Sink::policy, kernel>;
 
   /* Follow symlinks, ignore paths which we don't have permissions for. */
   static constexpr auto fs_dir_opt =
@@ -128,42 +178,220 @@ inline auto path_map(std::filesystem::path const& base_path,
   auto pm = path_map_type{};
   pm.reserve(path_map_reserve_count);
 
-  auto do_mark = [&](fs::path const& d) noexcept -> bool
+  auto not_watched = tally{};
+
+  trace::walk_begin(base_path);
+  auto const walk_began = trace::on ? trace::now() : 0;
+
+  auto do_mark = [&](fs::path const& d, ::wtr::watcher::filter::state state)
+    noexcept -> bool
   {
-    int wd = inotify_add_watch(sr.watch_fd, d.c_str(), in_watch_opt);
-    return wd > 0 ? pm.emplace(wd, d).first != pm.end() : false;
+    int wd = sys::add_watch(sr.watch_fd,
+                            d.c_str(),
+                            in_watch_opt<typename Sink::policy>);
+    trace::mark(d, wd >= 0);
+    return wd >= 0
+           ? pm.insert_or_assign(wd, watched_dir{d, state, root}).first
+               != pm.end()
+           : false;
   };
 
   try {
     if (sr.valid)
-      if (do_mark(base_path))
+      if (do_mark(base_path, filter.start()))
         if (fs::is_directory(base_path))
-          for (auto dir : diter(base_path, fs_dir_opt))
-            if (fs::is_directory(dir))
-              if (! do_mark(dir.path()))
-                callback({"w/sys/not_watched@" + base_path.string() + "@"
-                            + dir.path().string(),
-                          ev::what::other,
-                          ev::kind::watcher});
+          for (auto dir = diter(base_path, fs_dir_opt); dir != diter{}; ++dir)
+            if (fs::is_directory(*dir)) {
+              using ::detail::wtr::watcher::filter::beneath;
+              auto state = filter.start();
+              if (! filter.empty()) {
+                state = filter.walk(
+                  state,
+                  beneath<char>(dir->path().native(), base_path.native()));
+                /* Nothing in here can be kept. */
+                if (filter.prunes(state)) {
+                  dir.disable_recursion_pending();
+                  continue;
+                }
+                state = filter.walk(state, "/");
+              }
+              if (! do_mark(dir->path(), state))
+                if constexpr (Sink::policy::status)
+                  not_watched(callback,
+                              {.level = diag::level::warning,
+                               .code = diag::code::not_watched,
+                               .error = errno,
+                               .where = base_path.native(),
+                               .also = dir->path().native()});
+            }
   } catch (...) {}
 
+  not_watched.done(callback);
+
+  if (callback.counts)
+    callback.counts->marks.store(pm.size(),
+                                 std::memory_order_relaxed);
+
+  trace::walk_end(base_path,
+                  pm.size(),
+                  trace::on ? trace::now() - walk_began : 0);
+
   return pm;
 };
 
+/*  @brief wtr/watcher/<d>/adapter/linux/inotify/<a>/fns/do_path_map_create
+    The same, for every one of `roots`, in one map. The
+    kernel gives a directory which is beneath more than one
+    of them the same watch descriptor, so where they overlap,
+    the deepest root is marked last and keeps it. A root
+    which can't be watched is warned about, and the others
+    are watched without it. */
+template<class Sink>
+inline auto path_map(roots_type const& roots,
+                     Sink const& callback,
+                     sys_resource_type const& sr) noexcept -> path_map_type
+{
+  using diag = ::wtr::watcher::diag;
+
+  if (roots.size() == 1)
+    return path_map(roots.front().path, roots.front().live, callback, sr);
+
+  auto order = std::vector<std::uint32_t>(roots.size());
+  for (auto n = std::uint32_t{0}; n < roots.size(); ++n) order[n] = n;
+  std::sort(order.begin(),
+            order.end(),
+            [&roots](auto l, auto r) noexcept
+            { return roots[l].real.size() < roots[r].real.size(); });
+
+  auto pm = path_map_type{};
+  for (auto const n : order) {
+    auto const& root = roots[n];
+    if (root.path.empty()) continue;
+    auto each = path_map(root.path, root.live, callback, sr, n);
+    if constexpr (Sink::policy::status)
+      if (each.empty())
+        callback.tell({.level = diag::level::warning,
+                       .code = diag::code::not_watched,
+                       .where = root.path.native()});
+    for (auto& [wd, dir] : each) pm.insert_or_assign(wd, std::move(dir));
+  }
+
+  if (callback.counts)
+    callback.counts->marks.store(pm.size(), std::memory_order_relaxed);
+
+  return pm;
+};
+
+/*  @brief wtr/watcher/<d>/adapter/linux/inotify/<a>/fns/adopt
+    Takes the directories in `fresh` into `pm`, except for
+    those which a deeper root already has. */
+inline auto adopt(path_map_type& pm,
+                  path_map_type&& fresh,
+                  roots_type const& roots) noexcept -> void
+{
+  for (auto& [wd, dir] : fresh) {
+    auto const had = pm.find(wd);
+    if (had == pm.end()
+        || roots[had->second.root].real.size() <= roots[dir.root].real.size())
+      pm.insert_or_assign(wd, std::move(dir));
+  }
+}
+
+/*  @brief wtr/watcher/<d>/adapter/linux/inotify/<a>/fns/change_roots
+    Watches the roots added since we last looked, and stops
+    watching those removed, without touching the others.
+    An added root is watched as it would have been from the
+    start. A removed root's directories are let go, unless
+    another root is above them, in which case that root
+    takes them back (after a walk through its tree). */
+template<class Sink>
+inline auto change_roots(sys_resource_type const& sr,
+                         path_map_type& pm,
+                         roots_type& roots,
+                         ::wtr::watcher::filter const& filter,
+                         changes_type const& changes,
+                         Sink const& callback) noexcept -> void
+{
+  namespace fs = ::std::filesystem;
+  using diag = ::wtr::watcher::diag;
+  using policy = typename Sink::policy;
+  using trace = typename policy::trace;
+
+  for (auto const& c : changes) {
+    if (c.root >= roots.size()) roots.resize(c.root + 1);
+
+    if (c.what == change::what::add) {
+      auto ec = std::error_code{};
+      roots[c.root] = {c.path,
+                       fs::weakly_canonical(c.path, ec).native(),
+                       filter.loaded(c.path)};
+      auto const& root = roots[c.root];
+      if constexpr (policy::status)
+        callback.tell({.level = diag::level::status,
+                       .code = diag::code::live,
+                       .where = root.path.native()});
+      auto fresh = path_map(root.path, root.live, callback, sr, c.root);
+      if constexpr (policy::status)
+        if (fresh.empty())
+          callback.tell({.level = diag::level::warning,
+                         .code = diag::code::not_watched,
+                         .where = root.path.native()});
+      adopt(pm, std::move(fresh), roots);
+    }
+
+    else if (! roots[c.root].path.empty()) {
+      auto const gone = std::move(roots[c.root]);
+      roots[c.root] = {};
+
+      auto dropped = path_map_type{};
+      for (auto at = pm.begin(); at != pm.end();)
+        if (at->second.root == c.root) {
+          dropped.insert(std::move(*at));
+          at = pm.erase(at);
+        }
+        else
+          ++at;
+
+      for (auto n = std::uint32_t{0}; n < roots.size(); ++n) {
+        auto const& above = roots[n].real;
+        if (! above.empty() && above.size() < gone.real.size()
+            && gone.real.starts_with(above)
+            && (above.ends_with('/') || gone.real[above.size()] == '/'))
+          adopt(pm, path_map(roots[n].path, roots[n].live, callback, sr, n),
+                roots);
+      }
+
+      for (auto const& [wd, dir] : dropped)
+        if (! pm.contains(wd))
+          trace::unmark(dir.path, inotify_rm_watch(sr.watch_fd, wd) == 0);
+
+      if constexpr (policy::status)
+        callback.tell({.level = diag::level::status,
+                       .code = diag::code::die,
+                       .where = gone.path.native()});
+    }
+  }
+
+  if (callback.counts)
+    callback.counts->marks.store(pm.size(), std::memory_order_relaxed);
+}
+
 /*  @brief wtr/watcher/<d>/adapter/linux/inotify/<a>/fns/system_unfold
     Produces a `sys_resource_type` with the file descriptors from
     `inotify_init` and `epoll_create`. Invokes `callback` on errors. */
+template<class Sink>
 inline auto
-system_unfold(::wtr::watcher::event::callback const& callback) noexcept
+system_unfold(Sink const& callback) noexcept
   -> sys_resource_type
 {
-  auto do_error = [&callback](char const* const msg,
+  using diag = ::wtr::watcher::diag;
+
+  auto do_error = [&callback](enum diag::code code,
                               int watch_fd,
                               int event_fd = -1) noexcept -> sys_resource_type
   {
-    callback({msg,
-              ::wtr::watcher::event::what::other,
-              ::wtr::watcher::event::kind::watcher});
+    callback.tell(
+      {.level = diag::level::error, .code = code, .error = errno});
     return sys_resource_type{
       .valid = false,
       .watch_fd = watch_fd,
@@ -184,7 +412,7 @@ system_unfold(::wtr::watcher::event::callback const& callback) noexcept
 
     int event_fd
 #if defined(WATER_WATCHER_PLATFORM_ANDROID_ANY)
-      = epoll_create(event_wait_queue_max);
+      = epoll_create(Sink::policy::wait_max);
 #elif defined(WATER_WATCHER_PLATFORM_LINUX_KERNEL_ANY)
       = epoll_create1(EPOLL_CLOEXEC);
 #endif
@@ -196,12 +424,12 @@ system_unfold(::wtr::watcher::event::callback const& callback) noexcept
                                  .event_fd = event_fd,
                                  .event_conf = event_conf};
       else
-        return do_error("e/sys/epoll_ctl", watch_fd, event_fd);
+        return do_error(diag::code::epoll_ctl, watch_fd, event_fd);
     else
-      return do_error("e/sys/epoll_create", watch_fd, event_fd);
+      return do_error(diag::code::epoll_create, watch_fd, event_fd);
   }
   else
-    return do_error("e/sys/inotify_init", watch_fd);
+    return do_error(diag::code::inotify_init, watch_fd);
 }
 
 /*  @brief wtr/watcher/<d>/adapter/linux/inotify/<a>/fns/system_fold
@@ -211,25 +439,116 @@ inline auto system_fold(sys_resource_type& sr) noexcept -> bool
   return ! (close(sr.watch_fd) && close(sr.event_fd));
 }
 
+/*  @brief wtr/watcher/<d>/adapter/linux/inotify/<a>/fns/decode
+    What happened, and to what kind of thing, from the
+    mask of an `inotify_event`. */
+inline auto what_of(std::uint32_t mask) noexcept
+  -> enum ::wtr::watcher::event::what
+{
+  using evw = enum ::wtr::watcher::event::what;
+  return mask & IN_CREATE   ? evw::create
+       : mask & IN_DELETE   ? evw::destroy
+       : mask & IN_MOVE     ? evw::rename
+       : mask & IN_MODIFY   ? evw::modify
+                            : evw::other;
+}
+
+inline auto kind_of(std::uint32_t mask) noexcept
+  -> enum ::wtr::watcher::event::kind
+{
+  return mask & IN_ISDIR ? ::wtr::watcher::event::kind::dir
+                         : ::wtr::watcher::event::kind::file;
+}
+
+/*  @brief wtr/watcher/<d>/adapter/linux/inotify/<a>/batch_decoder
+    Reads the `inotify_event`s in our buffer for a `batch`.
+    Records for dropped watches and overflows are skipped.
+    The batch's context is the path map, which is already
+    a table of directories by their watch descriptors. The
+    descriptor is the directory's id. */
+inline auto first_event(char const* at, char const* end) noexcept
+  -> char const*
+{
+  while (at < end
+         && ((inotify_event const*)at)->mask & (IN_IGNORED | IN_Q_OVERFLOW))
+    at += sizeof(inotify_event) + ((inotify_event const*)at)->len;
+  return at < end ? at : end;
+}
+
+inline constexpr auto batch_decoder = ::wtr::watcher::batch::decoder{
+  .first = first_event,
+  .next = [](char const* at, char const* end) noexcept -> char const*
+  {
+    return first_event(
+      at + sizeof(inotify_event) + ((inotify_event const*)at)->len,
+      end);
+  },
+  .what = [](char const* at) noexcept
+  { return what_of(((inotify_event const*)at)->mask); },
+  .kind = [](char const* at) noexcept
+  { return kind_of(((inotify_event const*)at)->mask); },
+  .name = [](char const* at) noexcept
+  {
+    auto const e = (inotify_event const*)at;
+    return e->len > 0 ? std::string_view{e->name} : std::string_view{};
+  },
+  .dir = [](void const*, char const* at) noexcept
+  { return (std::size_t)((inotify_event const*)at)->wd; },
+  .dir_path = [](void const* context, std::size_t wd) noexcept
+  {
+    auto const& pm = *static_cast<path_map_type const*>(context);
+    auto const dir = pm.find((int)wd);
+    return dir == pm.end() ? std::string_view{}
+                           : std::string_view{dir->second.path.native()};
+  },
+  .where = [](void const* context, char const* at, std::string& into) noexcept
+  {
+    auto const e = (inotify_event const*)at;
+    auto const& pm = *static_cast<path_map_type const*>(context);
+    auto const dir = pm.find(e->wd);
+    if (dir == pm.end()) return false;
+    into.assign(dir->second.path.native());
+    into += '/';
+    if (e->len > 0) into.append(e->name);
+    return true;
+  },
+};
+
 /*  @brief wtr/watcher/<d>/adapter/linux/inotify/<a>/fns/do_event_recv
     Reads through available (inotify) filesystem events.
     Discerns their path and type.
-    Calls the callback.
+    Calls the callback with a view of `where`, which holds
+    the path until the callback returns, or with a view of
+    the whole buffer, if it takes batches.
+    Matches names against the filter of the root their
+    directory is beneath, and says which root that is.
+    Loads the filters again, and watches (or forgets about)
+    the directories they now keep (or drop), if one of them
+    says to when something happens.
     Returns false on eventful errors.
 
     @todo
     Return new directories when they appear,
-    Consider running and returning `find_dirs` from here.
-    Remove destroyed watches. */
+    Consider running and returning `find_dirs` from here. */
+template<class Sink>
 inline auto
-do_event_recv(int watch_fd,
+do_event_recv(sys_resource_type const& sr,
               path_map_type& pm,
-              std::filesystem::path const& base_path,
-              ::wtr::watcher::event::callback const& callback) noexcept -> bool
+              std::string& where,
+              roots_type& roots,
+              Sink const& callback) noexcept -> bool
 {
   namespace fs = ::std::filesystem;
 
-  alignas(inotify_event) char buf[event_buf_len];
+  using policy = typename Sink::policy;
+  using trace = typename policy::trace;
+  using sys = sys_of<policy, kernel>;
+
+  auto const watch_fd = sr.watch_fd;
+
+  auto reload = false;
+
+  alignas(inotify_event) char buf[policy::buf_len];
 
   enum class state { eventful, eventless, error };
 
@@ -250,60 +569,151 @@ do_event_recv(int watch_fd,
 
 recurse:
 
-  ssize_t read_len = read(watch_fd, buf, event_buf_len);
+  auto const read_began = trace::on ? trace::now() : 0;
+
+  ssize_t read_len = sys::read(watch_fd, buf, sizeof(buf));
+
+  trace::read(read_len, trace::on ? trace::now() - read_began : 0);
+
+  auto const counted = counted_read{callback.counts,
+                                    read_len,
+                                    sizeof(buf),
+                                    sizeof(inotify_event) + NAME_MAX + 1};
 
   switch (read_len > 0      ? state::eventful
           : read_len == 0   ? state::eventless
           : errno == EAGAIN ? state::eventless
                             : state::error) {
     case state::eventful : {
-      /* Loop over all events in the buffer. */
+      /* Everything in this read happened by now. */
+      auto const when = ::wtr::watcher::event::now(callback.clock);
+
+      /* Whoever takes batches gets the buffer as it is,
+         before we forget about any of the watches in it. */
+      if (callback.batches)
+        callback.batches(::wtr::watcher::batch{buf,
+                                               buf + read_len,
+                                               batch_decoder,
+                                               &pm,
+                                               when,
+                                               callback.clock});
+
+      /* Directories created in this read which we couldn't
+         watch, as the initial walk counts them. */
+      auto not_watched = tally{};
+
+      /* Loop over all events in the buffer.
+         Events are variably sized: the name follows the
+         header and is `len` bytes long, padding included. */
       auto this_event = (inotify_event*)buf;
       while (this_event < (inotify_event*)(buf + read_len)) {
-        if (! (this_event->mask & IN_Q_OVERFLOW)) [[likely]] {
-          auto path =
-            pm.find(this_event->wd)->second / fs::path(this_event->name);
+        /* The kernel has already dropped this watch, either
+           because its directory was destroyed or because we
+           asked it to. We only need to forget about it. There
+           is one of these for every directory in a destroyed
+           subtree, so cleaning up here (without a syscall)
+           is cheaper than calling `inotify_rm_watch`. */
+        if (this_event->mask & IN_IGNORED)
+          pm.erase(this_event->wd);
+
+        else if (! (this_event->mask & IN_Q_OVERFLOW)) [[likely]] {
+          /* A watch we just forgot about, on a reload. */
+          auto const found = pm.find(this_event->wd);
+          if (found == pm.end()) [[unlikely]] {
+            this_event = (inotify_event*)((char*)this_event
+                                          + sizeof(inotify_event)
+                                          + this_event->len);
+            continue;
+          }
+          auto const& dir = found->second;
+          auto const& filter = roots[dir.root].live;
 
-          auto kind = this_event->mask & IN_ISDIR
-                      ? ::wtr::watcher::event::kind::dir
-                      : ::wtr::watcher::event::kind::file;
+          auto name = this_event->len > 0 ? std::string_view{this_event->name}
+                                          : std::string_view{};
 
-          auto what =
-            this_event->mask & IN_CREATE ? ::wtr::watcher::event::what::create
-            : this_event->mask & IN_DELETE
-              ? ::wtr::watcher::event::what::destroy
-            : this_event->mask & IN_MOVE   ? ::wtr::watcher::event::what::rename
-            : this_event->mask & IN_MODIFY ? ::wtr::watcher::event::what::modify
-                                           : ::wtr::watcher::event::what::other;
+          auto kind = kind_of(this_event->mask);
 
-          callback({path, what, kind});
+          auto what = what_of(this_event->mask);
 
-          if (kind == ::wtr::watcher::event::kind::dir
-              && what == ::wtr::watcher::event::what::create)
-            pm[inotify_add_watch(watch_fd, path.c_str(), in_watch_opt)] = path;
+          trace::decoded(what, kind, name.size());
 
-          else if (kind == ::wtr::watcher::event::kind::dir
-                   && what == ::wtr::watcher::event::what::destroy) {
-            inotify_rm_watch(watch_fd, this_event->wd);
-            pm.erase(this_event->wd);
+          /* Match the name before we make anything out of it. */
+          auto state = filter.empty() ? dir.state : filter.walk(dir.state, name);
+
+          /* The path is put together in a buffer which we
+             reuse, so that sending an event allocates nothing.
+             What the policy doesn't watch was only asked for
+             to follow directories. */
+          if (! callback.batches && policy::watches(what)
+              && (filter.empty() || filter.keeps(state, kind))) {
+            where.assign(dir.path.native());
+            where += '/';
+            where.append(name);
+            callback({where, what, kind, when, callback.clock, dir.root});
+          }
+
+          if (filter.reloads(name)) reload = true;
+
+          if (kind == ::wtr::watcher::event::kind::dir
+              && what == ::wtr::watcher::event::what::create
+              && (filter.empty() || ! filter.prunes(state))) {
+            auto path = dir.path / name;
+            auto wd = sys::add_watch(watch_fd,
+                                     path.c_str(),
+                                     in_watch_opt<policy>);
+            trace::mark(path, wd >= 0);
+            if (wd >= 0)
+              pm[wd] = watched_dir{std::move(path),
+                                   filter.empty() ? state
+                                                  : filter.walk(state, "/"),
+                                   dir.root};
+            else if constexpr (policy::status)
+              not_watched(callback,
+                          {.level = ::wtr::watcher::diag::level::warning,
+                           .code = ::wtr::watcher::diag::code::not_watched,
+                           .error = errno,
+                           .where = roots[dir.root].path.native(),
+                           .also = path.native()});
           }
         }
-        else
-          callback({"e/self/overflow@" + base_path.string(),
-                    ::wtr::watcher::event::what::other,
-                    ::wtr::watcher::event::kind::watcher});
+        else {
+          if (callback.counts)
+            ::wtr::watcher::metrics::add(callback.counts->overflows);
+          callback.tell({.level = ::wtr::watcher::diag::level::error,
+                         .code = ::wtr::watcher::diag::code::overflow,
+                         .where = roots.front().path.native()});
+        }
 
-        this_event += sizeof(inotify_event);
+        this_event = (inotify_event*)((char*)this_event + sizeof(inotify_event)
+                                      + this_event->len);
+      }
+      not_watched.done(callback);
+      /* A `.gitignore` changed. Watching the tree again
+         watches what is newly kept and updates what we
+         have. What is newly dropped is let go. */
+      if (reload) {
+        reload = false;
+        for (auto& root : roots) root.live = root.live.loaded(root.path);
+        auto fresh = path_map(roots, callback, sr);
+        for (auto const& [wd, dir] : pm)
+          if (! fresh.contains(wd))
+            trace::unmark(dir.path, inotify_rm_watch(watch_fd, wd) == 0);
+        pm = std::move(fresh);
       }
+      counted.done();
+      if (callback.counts)
+        callback.counts->marks.store(pm.size(),
+                                     std::memory_order_relaxed);
       /* Same as `return do_event_recv(..., buf)`.
          Our stopping condition is `eventless` or `error`. */
       goto recurse;
     }
 
     case state::error :
-      callback({"e/sys/read@" + base_path.string(),
-                ::wtr::watcher::event::what::other,
-                ::wtr::watcher::event::kind::watcher});
+      callback.tell({.level = ::wtr::watcher::diag::level::error,
+                     .code = ::wtr::watcher::diag::code::read,
+                     .error = errno,
+                     .where = roots.front().path.native()});
       return false;
 
     case state::eventless : return true;
@@ -314,35 +724,58 @@ recurse:
 }
 
 /*  @brief wtr/watcher/<d>/adapter/watch
-    Monitors `path` for changes.
+    Monitors `paths` for changes, all with one `inotify`
+    instance.
     Invokes `callback` with an `event` when they happen.
     `watch` stops when asked to or irrecoverable errors occur.
     All events, including errors, are passed to `callback`.
 
-    @param path
-    A filesystem path to watch for events.
+    @param paths
+    The filesystem paths to watch for events. Each event
+    says which of them it happened beneath.
+
+    @param filter
+    Which paths, beneath each of `paths`, to send events for.
 
     @param callback
     A function to invoke with an `event` object
     when the files being watched change.
 
     @param is_living
-    A function to decide whether we're dead. */
-inline bool watch(std::filesystem::path const& path,
-                  ::wtr::watcher::event::callback const& callback,
-                  std::function<bool()> const& is_living) noexcept
+    A function to decide whether we're dead.
+
+    @param changes
+    A function which gives us the roots added or removed
+    since we last asked. See `change`. */
+template<class Sink>
+inline bool watch(std::vector<std::filesystem::path> const& paths,
+                  ::wtr::watcher::filter const& filter,
+                  Sink const& callback,
+                  std::function<bool()> const& is_living,
+                  changes_fn const& changes = {}) noexcept
 {
-  using ev = ::wtr::watcher::event;
+  using diag = ::wtr::watcher::diag;
+  using policy = typename Sink::policy;
 
-  auto do_error = [&path, &callback](bool clean, std::string&& msg) -> bool
-  {
-    callback({msg + path.string(), ev::what::other, ev::kind::watcher});
+  /* What we say about ourselves is said of the first. */
+  auto const path = paths.empty() ? std::filesystem::path{} : paths.front();
 
-    if (clean)
-      callback({"s/self/die@" + path.string(), ev::what::other, ev::kind::watcher});
+  auto do_error = [&path, &callback](bool clean, enum diag::code code) -> bool
+  {
+    callback.tell(
+      {.level = diag::level::error, .code = code, .where = path.native()});
+
+    if (clean) {
+      if constexpr (policy::status)
+        callback.tell({.level = diag::level::status,
+                       .code = diag::code::die,
+                       .where = path.native()});
+    }
 
     else
-      callback({"e/self/die@" + path.string(), ev::what::other, ev::kind::watcher});
+      callback.tell({.level = diag::level::error,
+                     .code = diag::code::die,
+                     .where = path.native()});
 
     return false;
   };
@@ -360,39 +793,52 @@ inline bool watch(std::filesystem::path const& path,
 
   sys_resource_type sr = system_unfold(callback);
 
-  epoll_event event_recv_list[event_wait_queue_max];
+  epoll_event event_recv_list[policy::wait_max];
+
+  /* Our own copies, which read the `.gitignore`s if they should. */
+  auto roots = roots_of(paths, filter);
 
-  auto pm = path_map(path, callback, sr);
+  auto pm = path_map(roots, callback, sr);
+
+  /* Where the paths we send are put together. */
+  auto where = std::string{};
 
   if (sr.valid) [[likely]]
 
-    if (pm.size() > 0) [[likely]] {
+    if (pm.size() > 0 || paths.empty()) [[likely]] {
       while (is_living()) [[likely]]
 
       {
+        if (changes)
+          if (auto const changed = changes(); ! changed.empty())
+            change_roots(sr, pm, roots, filter, changed, callback);
+
         int event_count = epoll_wait(sr.event_fd,
                                      event_recv_list,
-                                     event_wait_queue_max,
-                                     delay_ms);
+                                     policy::wait_max,
+                                     policy::delay_ms);
 
         if (event_count < 0)
-          return do_error(system_fold(sr), "e/sys/epoll_wait@");
+          return do_error(system_fold(sr), diag::code::epoll_wait);
 
         else if (event_count > 0) [[likely]]
           for (int n = 0; n < event_count; n++)
             if (event_recv_list[n].data.fd == sr.watch_fd) [[likely]]
-              if (! do_event_recv(sr.watch_fd, pm, path, callback)) [[unlikely]]
-                return do_error(system_fold(sr), "e/self/event_recv@");
+              if (! do_event_recv(sr, pm, where, roots, callback)) [[unlikely]]
+                return do_error(system_fold(sr), diag::code::event_recv);
       }
 
-      callback({"s/self/die@" + path.string(), ev::what::destroy, ev::kind::watcher});
+      if constexpr (policy::status)
+        callback.tell({.level = diag::level::status,
+                       .code = diag::code::die,
+                       .where = path.native()});
       return system_fold(sr);
     }
     else
-      return do_error(system_fold(sr), "e/self/path_map@");
+      return do_error(system_fold(sr), diag::code::path_map);
 
   else
-    return do_error(system_fold(sr), "e/self/sys_resource@");
+    return do_error(system_fold(sr), diag::code::sys_resource);
 }
 
 } /* namespace inotify */
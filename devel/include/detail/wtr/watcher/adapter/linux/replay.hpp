@@ -0,0 +1,355 @@
+#pragma once
+
+/*  WATER_WATCHER_PLATFORM_* */
+#include <detail/wtr/watcher/platform.hpp>
+
+#if defined(WATER_WATCHER_PLATFORM_LINUX_KERNEL_GTE_2_7_0) \
+  || defined(WATER_WATCHER_PLATFORM_ANDROID_ANY)
+#if ! defined(WATER_WATCHER_USE_WARTHOG)
+
+/*  errno
+    EAGAIN */
+#include <cerrno>
+/*  int64_t
+    uint32_t */
+#include <cstdint>
+/*  FILE
+    fopen
+    fread
+    fwrite
+    fclose */
+#include <cstdio>
+/*  memcpy
+    strlen */
+#include <cstring>
+/*  path */
+#include <filesystem>
+/*  mutex
+    scoped_lock */
+#include <mutex>
+/*  string */
+#include <string>
+/*  string_view */
+#include <string_view>
+/*  vector */
+#include <vector>
+/*  event
+    filter
+    policy
+    metrics
+    sink
+    inotify::kernel
+    fanotify::kernel */
+#include <wtr/watcher.hpp>
+
+namespace detail {
+namespace wtr {
+namespace watcher {
+namespace adapter {
+
+/*  @brief wtr/watcher/<d>/adapter/linux/recording
+    What the kernel told an adapter, in the order it did:
+      - read
+          The bytes from a read which gave us some.
+      - watch
+          A directory given to `inotify_add_watch`. The
+          value is the watch descriptor we got back.
+      - mark
+          A directory given to `fanotify_mark`. The value
+          is what it returned.
+      - dir
+          The path of a directory we found by its handle.
+          The value is its length, or 0 or less if we
+          couldn't find it.
+    Everything which is watched or marked before the first
+    read is the tree we started with.
+
+    In a file, each entry is its type (a byte), its value
+    (eight bytes), the length of its bytes (four) and then
+    its bytes, in the byte order of the host which wrote it. */
+struct recording {
+  enum class type : char {
+    read = 'r',
+    watch = 'w',
+    mark = 'm',
+    dir = 'd',
+  };
+
+  struct entry {
+    enum type type {};
+    std::int64_t value{};
+    std::string bytes{};
+  };
+
+  std::vector<entry> entries{};
+
+  static auto put(std::FILE* to,
+                  enum type t,
+                  std::int64_t value,
+                  void const* bytes,
+                  std::uint32_t len) noexcept -> bool
+  {
+    return std::fwrite(&t, sizeof(t), 1, to) == 1
+        && std::fwrite(&value, sizeof(value), 1, to) == 1
+        && std::fwrite(&len, sizeof(len), 1, to) == 1
+        && (len == 0 || std::fwrite(bytes, len, 1, to) == 1);
+  }
+
+  /*  Reads a recording from a file, or returns an empty
+      one if we can't. */
+  static auto load(std::filesystem::path const& from) noexcept -> recording
+  {
+    auto r = recording{};
+    auto in = std::fopen(from.c_str(), "rb");
+    if (! in) return r;
+    try {
+      for (auto e = entry{};;) {
+        auto len = std::uint32_t{};
+        if (std::fread(&e.type, sizeof(e.type), 1, in) != 1
+            || std::fread(&e.value, sizeof(e.value), 1, in) != 1
+            || std::fread(&len, sizeof(len), 1, in) != 1)
+          break;
+        e.bytes.resize(len);
+        if (len > 0 && std::fread(e.bytes.data(), len, 1, in) != 1) break;
+        r.entries.push_back(e);
+      }
+    } catch (...) {
+      r.entries.clear();
+    }
+    std::fclose(in);
+    return r;
+  }
+
+  /*  Where the first read is, after the tree we started
+      with. */
+  auto first_read() const noexcept -> std::size_t
+  {
+    auto at = std::size_t{0};
+    while (at < this->entries.size() && this->entries[at].type != type::read)
+      ++at;
+    return at;
+  }
+
+  /*  The path we watched: the first one we marked. */
+  auto root() const noexcept -> std::string_view
+  {
+    for (auto const& e : this->entries)
+      if (e.type == type::watch || e.type == type::mark) return e.bytes;
+    return {};
+  }
+
+  /*  Whether this came from `inotify` (or else `fanotify`). */
+  auto from_inotify() const noexcept -> bool
+  {
+    for (auto const& e : this->entries)
+      if (e.type == type::watch) return true;
+    return false;
+  }
+};
+
+/*  @brief wtr/watcher/<d>/adapter/linux/record
+    Makes the calls an adapter makes to the kernel, and
+    writes what it said to `to`, if it isn't null. Give it
+    to a watcher as its policy's `sys`:
+
+      struct recorded : policy {
+        using sys = ::detail::wtr::watcher::adapter::record;
+      };
+      record::to = std::fopen("events.rec", "wb");
+      auto w = watch<recorded>(".", callback);
+      ...
+      w.close();
+      std::fclose(record::to);
+
+    Every watcher with this policy writes to the same file,
+    so there should only be one at a time. */
+struct record {
+  static inline std::FILE* to = nullptr;
+  static inline std::mutex lk{};
+
+  static auto put(enum recording::type t,
+                  std::int64_t value,
+                  void const* bytes,
+                  std::size_t len) noexcept -> void
+  {
+    auto _ = std::scoped_lock{lk};
+    if (to) recording::put(to, t, value, bytes, (std::uint32_t)len);
+  }
+
+  static auto read(int fd, void* buf, std::size_t len) noexcept -> ssize_t
+  {
+    auto const n = ::read(fd, buf, len);
+    if (n > 0) put(recording::type::read, n, buf, (std::size_t)n);
+    return n;
+  }
+
+#if defined(WATER_WATCHER_ADAPTER_LINUX_INOTIFY)
+  static auto
+  add_watch(int fd, char const* path, std::uint32_t mask) noexcept -> int
+  {
+    auto const wd = inotify::kernel::add_watch(fd, path, mask);
+    put(recording::type::watch, wd, path, std::strlen(path));
+    return wd;
+  }
+#endif
+
+#if defined(WATER_WATCHER_ADAPTER_LINUX_FANOTIFY)
+  static auto mark(int fd,
+                   unsigned flags,
+                   std::uint64_t mask,
+                   char const* path) noexcept -> int
+  {
+    auto const r = fanotify::kernel::mark(fd, flags, mask, path);
+    put(recording::type::mark, r, path, std::strlen(path));
+    return r;
+  }
+
+  static auto dir_path(file_handle* fh, char* into, std::size_t len) noexcept
+    -> ssize_t
+  {
+    auto const n = fanotify::kernel::dir_path(fh, into, len);
+    put(recording::type::dir, n, into, n > 0 ? (std::size_t)n : 0);
+    return n;
+  }
+#endif
+};
+
+/*  @brief wtr/watcher/<d>/adapter/linux/replay
+    Says what the kernel said in a `recording`, instead of
+    asking it. Each call is answered by the next entry of
+    its type. When the reads run out, there is nothing more
+    to read (`EAGAIN`). One recording is played at a time on
+    each thread. See `play`. */
+struct replay {
+  static inline thread_local recording const* from = nullptr;
+  static inline thread_local std::size_t next_read = 0;
+  static inline thread_local std::size_t next_watch = 0;
+  static inline thread_local std::size_t next_mark = 0;
+  static inline thread_local std::size_t next_dir = 0;
+
+  static auto next(enum recording::type t, std::size_t& at) noexcept
+    -> recording::entry const*
+  {
+    if (! from) return nullptr;
+    while (at < from->entries.size() && from->entries[at].type != t) ++at;
+    return at < from->entries.size() ? &from->entries[at++] : nullptr;
+  }
+
+  static auto read(int, void* buf, std::size_t len) noexcept -> ssize_t
+  {
+    auto const e = next(recording::type::read, next_read);
+    if (! e) {
+      errno = EAGAIN;
+      return -1;
+    }
+    auto const n = e->bytes.size() < len ? e->bytes.size() : len;
+    std::memcpy(buf, e->bytes.data(), n);
+    return (ssize_t)n;
+  }
+
+  static auto add_watch(int, char const*, std::uint32_t) noexcept -> int
+  {
+    auto const e = next(recording::type::watch, next_watch);
+    return e ? (int)e->value : -1;
+  }
+
+  static auto mark(int, unsigned, std::uint64_t, char const*) noexcept -> int
+  {
+    auto const e = next(recording::type::mark, next_mark);
+    return e ? (int)e->value : -1;
+  }
+
+  template<class Handle>
+  static auto dir_path(Handle*, char* into, std::size_t len) noexcept
+    -> ssize_t
+  {
+    auto const e = next(recording::type::dir, next_dir);
+    if (! e || e->value <= 0 || e->bytes.size() > len) return -1;
+    std::memcpy(into, e->bytes.data(), e->bytes.size());
+    return (ssize_t)e->bytes.size();
+  }
+};
+
+/*  @brief wtr/watcher/<d>/adapter/linux/replayed
+    `Policy`, played back. */
+template<class Policy>
+struct replayed : Policy {
+  using sys = replay;
+};
+
+/*  @brief wtr/watcher/<d>/adapter/linux/play
+    Plays `from` back through the adapter which recorded it,
+    as fast as it can be read, and sends what it makes of
+    it to `each`, counted in `counts`. Nothing is asked of
+    the kernel, so this measures what we do with what it
+    says: decoding, putting paths together and sending.
+    Returns false if there was nothing to play, or if it
+    came from an adapter which isn't here. */
+template<class Policy = ::wtr::watcher::policy, class Each>
+inline auto play(recording const& from,
+                 Each const& each,
+                 ::wtr::watcher::metrics* counts = nullptr) noexcept -> bool
+{
+  auto const sink =
+    adapter::sink<Each, replayed<Policy>>{.each = each,
+                                          .clock = Policy::clock,
+                                          .counts = counts};
+  auto const first_read = from.first_read();
+  auto const base_path = std::filesystem::path{from.root()};
+  auto const live = ::wtr::watcher::filter{};
+  auto roots = roots_type{{base_path, base_path.native(), live}};
+
+  if (from.entries.empty()) return false;
+
+  replay::from = &from;
+  replay::next_read = first_read;
+  replay::next_watch = first_read;
+  replay::next_mark = first_read;
+  replay::next_dir = 0;
+
+  auto ok = false;
+
+  if (from.from_inotify()) {
+#if defined(WATER_WATCHER_ADAPTER_LINUX_INOTIFY)
+    auto pm = inotify::path_map_type{};
+    for (auto at = std::size_t{0}; at < first_read; ++at)
+      if (from.entries[at].type == recording::type::watch)
+        pm[(int)from.entries[at].value] =
+          inotify::watched_dir{from.entries[at].bytes, live.start()};
+    auto const sr = inotify::sys_resource_type{.valid = true,
+                                               .watch_fd = -1,
+                                               .event_fd = -1,
+                                               .event_conf = {}};
+    auto where = std::string{};
+    ok = inotify::do_event_recv(sr, pm, where, roots, sink);
+#endif
+  }
+  else {
+#if defined(WATER_WATCHER_ADAPTER_LINUX_FANOTIFY)
+    auto sr = fanotify::system_resources{
+      .valid = true,
+      .watch_fd = -1,
+      .event_fd = -1,
+      .event_conf = {},
+      .mark_set = {},
+      .dirs = {},
+      .mark_mask = fanotify::fan_mark_mask<replayed<Policy>>,
+    };
+    ok = true;
+    while (ok && replay::next_read < from.entries.size())
+      ok = fanotify::recv(sr, roots, sink);
+#endif
+  }
+
+  replay::from = nullptr;
+  return ok;
+}
+
+} /* namespace adapter */
+} /* namespace watcher */
+} /* namespace wtr */
+} /* namespace detail */
+
+#endif /* !defined(WATER_WATCHER_USE_WARTHOG) */
+#endif /* defined(WATER_WATCHER_PLATFORM_LINUX_KERNEL_GTE_2_7_0) \
+          || defined(WATER_WATCHER_PLATFORM_ANDROID_ANY) */
@@ -0,0 +1,259 @@
+#pragma once
+
+/*  WATER_WATCHER_PLATFORM_* */
+#include <detail/wtr/watcher/platform.hpp>
+
+#if defined(WATER_WATCHER_PLATFORM_LINUX_KERNEL_GTE_2_7_0) \
+  || defined(WATER_WATCHER_PLATFORM_ANDROID_ANY)
+#if ! defined(WATER_WATCHER_USE_WARTHOG)
+
+/*  size_t */
+#include <cstddef>
+/*  uint32_t
+    uint64_t */
+#include <cstdint>
+/*  path
+    weakly_canonical */
+#include <filesystem>
+/*  string */
+#include <string>
+/*  string_view */
+#include <string_view>
+/*  error_code */
+#include <system_error>
+/*  vector */
+#include <vector>
+/*  event
+    batch
+    policy
+    trace
+    diag
+    metrics
+    filter */
+#include <wtr/watcher.hpp>
+
+namespace detail {
+namespace wtr {
+namespace watcher {
+namespace adapter {
+
+/*  @brief wtr/watcher/<d>/adapter/linux/sys_of
+    What an adapter calls to read from the kernel and to
+    mark what it watches: the `sys` in `Policy`, if there
+    is one, or the adapter's own `Kernel`, which makes
+    those calls. A policy's `sys` can record what the
+    kernel says, or play it back. See `replay`. */
+template<class Policy, class Kernel>
+struct sys_of_type {
+  using type = Kernel;
+};
+
+template<class Policy, class Kernel>
+requires requires { typename Policy::sys; }
+struct sys_of_type<Policy, Kernel> {
+  using type = typename Policy::sys;
+};
+
+template<class Policy, class Kernel>
+using sys_of = typename sys_of_type<Policy, Kernel>::type;
+
+/*  @brief wtr/watcher/<d>/adapter/linux/sink
+    Where the Linux adapters send what they read.
+
+    Events go to `each`, one at a time. If there is a
+    callback for `batches`, each read from the kernel goes
+    to it instead, as it is, and only the messages from
+    the watcher go to `each`.
+
+    Everything from one read is stamped once, from `clock`.
+
+    What the watcher says about itself is `tell`'d. It goes
+    to `diags`, if there is a callback for them, or to
+    `each` as a message, if there isn't.
+
+    What is sent to `each` is counted in `counts`, if we
+    have somewhere to count it. See `metrics`.
+
+    `Each` is whatever the user gave us (or a small wrapper
+    around it), so that the adapters, which are templates
+    on their sink, call it directly. It is only a
+    `std::function` when that's what we were given.
+
+    `Policy` is what the adapters were told when they were
+    compiled. See `policy`. Its `trace` hears about each
+    event sent. See `trace`. */
+template<class Each = ::wtr::watcher::event::compact::callback,
+         class Policy = ::wtr::watcher::policy>
+struct sink {
+  using policy = Policy;
+
+  Each each{};
+  ::wtr::watcher::batch::callback batches{};
+  enum ::wtr::watcher::event::clock clock {};
+  ::wtr::watcher::diag::callback diags{};
+  ::wtr::watcher::metrics* counts{};
+
+  auto operator()(::wtr::watcher::event::compact const& ev) const noexcept
+    -> void
+  {
+    using trace = typename Policy::trace;
+
+    auto const send = [&]() noexcept
+    {
+      if (this->counts)
+        this->counts->sent([&]() noexcept { this->each(ev); });
+      else
+        this->each(ev);
+    };
+
+    if constexpr (trace::on) {
+      trace::send_begin(ev.what, ev.kind);
+      auto const began = trace::now();
+      send();
+      trace::send_end(trace::now() - began);
+    }
+    else
+      send();
+  }
+
+  auto tell(::wtr::watcher::diag const& d) const noexcept -> void
+  {
+    if (this->diags)
+      this->diags(d);
+    else
+      this->each(::wtr::watcher::event::compact{
+        d.message(),
+        d.what(),
+        ::wtr::watcher::event::kind::watcher});
+  }
+};
+
+/*  @brief wtr/watcher/<d>/adapter/linux/counted_read
+    Counts a read of `len` bytes from the kernel into our
+    buffer of `cap` bytes. The read is full if a record of
+    `longest` bytes might not have fit after it. When we
+    are `done` with what was read, the events sent from it
+    are counted as well. */
+struct counted_read {
+  ::wtr::watcher::metrics* counts{};
+  std::uint64_t events_before{};
+
+  counted_read(::wtr::watcher::metrics* counts,
+               long len,
+               std::size_t cap,
+               std::size_t longest) noexcept
+      : counts{counts}
+  {
+    using ::wtr::watcher::metrics;
+    if (! counts) return;
+    metrics::add(counts->reads);
+    if (len > 0) {
+      metrics::add(counts->bytes_read, (std::uint64_t)len);
+      if ((std::size_t)len + longest > cap) metrics::add(counts->full_reads);
+    }
+    this->events_before = counts->events.load(std::memory_order_relaxed);
+  }
+
+  auto done() const noexcept -> void
+  {
+    if (! this->counts) return;
+    this->counts->read_events.record(
+      this->counts->events.load(std::memory_order_relaxed)
+      - this->events_before);
+  }
+};
+
+/*  @brief wtr/watcher/<d>/adapter/linux/tally
+    Warnings of one sort, from one walk through a tree,
+    such as every directory we couldn't watch. As messages,
+    each is sent as it happens. To a diagnostic callback,
+    they are counted and sent once, with the first of them,
+    when the walk is `done`. */
+struct tally {
+  ::wtr::watcher::diag first{};
+  std::string also{};
+  std::size_t count{0};
+
+  template<class Sink>
+  auto operator()(Sink const& sink, ::wtr::watcher::diag const& d) noexcept
+    -> void
+  {
+    if (! sink.diags) return sink.tell(d);
+    if (this->count++ == 0) {
+      this->first = d;
+      this->also.assign(d.also);
+    }
+  }
+
+  template<class Sink>
+  auto done(Sink const& sink) noexcept -> void
+  {
+    if (this->count == 0) return;
+    auto d = this->first;
+    d.also = this->also;
+    d.count = this->count;
+    this->count = 0;
+    sink.tell(d);
+  }
+};
+
+/*  @brief wtr/watcher/<d>/adapter/linux/watched_root
+    One of the paths a watcher was given, with its own copy
+    of the filter, which reads the `.gitignore`s beneath it
+    if it should, and where it really is, without symlinks
+    or relative parts, which is what the kernel tells us.
+    A root's place among them is what its events say they
+    happened beneath. See `event::root`. */
+struct watched_root {
+  std::filesystem::path path{};
+  std::string real{};
+  ::wtr::watcher::filter live{};
+};
+
+using roots_type = std::vector<watched_root>;
+
+inline auto roots_of(std::vector<std::filesystem::path> const& paths,
+                     ::wtr::watcher::filter const& filter) noexcept
+  -> roots_type
+{
+  auto roots = roots_type{};
+  roots.reserve(paths.size());
+  for (auto const& path : paths) {
+    auto ec = std::error_code{};
+    roots.push_back({path,
+                     std::filesystem::weakly_canonical(path, ec).native(),
+                     filter.loaded(path)});
+  }
+  return roots;
+}
+
+/*  @brief wtr/watcher/<d>/adapter/linux/root_of
+    Which of `roots` the directory `dir` is beneath (or is).
+    Where roots overlap, the deepest of them. As many as
+    there are roots, if none of them. Roots which were
+    removed are empty, and nothing is beneath them. */
+inline auto root_of(std::string_view dir, roots_type const& roots) noexcept
+  -> std::uint32_t
+{
+  auto found = (std::uint32_t)roots.size();
+  auto depth = std::size_t{0};
+  for (auto n = std::uint32_t{0}; n < roots.size(); ++n) {
+    auto const real = std::string_view{roots[n].real};
+    if (! real.empty() && real.size() >= depth && dir.starts_with(real)
+        && (dir.size() == real.size() || dir[real.size()] == '/'
+            || real.ends_with('/'))) {
+      found = n;
+      depth = real.size();
+    }
+  }
+  return found;
+}
+
+} /* namespace adapter */
+} /* namespace watcher */
+} /* namespace wtr */
+} /* namespace detail */
+
+#endif /* !defined(WATER_WATCHER_USE_WARTHOG) */
+#endif /* defined(WATER_WATCHER_PLATFORM_LINUX_KERNEL_GTE_2_7_0) \
+          || defined(WATER_WATCHER_PLATFORM_ANDROID_ANY) */
@@ -15,10 +15,13 @@
 
 /* function */
 #include <functional>
+/* vector */
+#include <vector>
 /* geteuid */
 #include <unistd.h>
 /* event
    callback
+   filter
    inotify::watch
    fanotify::watch */
 #include <wtr/watcher.hpp>
@@ -31,13 +34,18 @@ namespace adapter {
 /*
   @brief detail/wtr/watcher/adapter/watch
 
-  Monitors `path` for changes.
+  Monitors `paths` for changes, all with one kernel
+  instance.
   Invokes `callback` with an `event` when they happen.
   `watch` stops when asked to or unrecoverable errors occur.
   All events, including errors, are passed to `callback`.
 
-  @param path
-    A filesystem path to watch for events.
+  @param paths
+    The filesystem paths to watch for events. Each event
+    says which of them it happened beneath.
+
+  @param filter
+    Which paths, beneath each of `paths`, to send events for.
 
   @param callback
     A function to invoke with an `event` object
@@ -46,6 +54,10 @@ namespace adapter {
   @param is_living
     A function to decide whether we're dead.
 
+  @param changes
+    A function to say which roots were added or removed
+    since we last asked. We ask between reads.
+
   @note
   If we have a kernel that can use either `fanotify` or
   `inotify`, then we will use `fanotify` if the user is
@@ -58,25 +70,29 @@ namespace adapter {
   but not `inotify`. It's just here for completeness.
 */
 
-inline bool watch(std::filesystem::path const& path,
-                  ::wtr::watcher::event::callback const& callback,
-                  std::function<bool()> const& is_living) noexcept
+template<class Sink>
+inline bool watch(std::vector<std::filesystem::path> const& paths,
+                  ::wtr::watcher::filter const& filter,
+                  Sink const& callback,
+                  std::function<bool()> const& is_living,
+                  changes_fn const& changes = {}) noexcept
 {
   return
 
 #if defined(WATER_WATCHER_ADAPTER_LINUX_FANOTIFY) \
   && defined(WATER_WATCHER_ADAPTER_LINUX_INOTIFY)
 
-    geteuid() == 0 ? fanotify::watch(path, callback, is_living)
-                   : inotify::watch(path, callback, is_living);
+    geteuid() == 0
+      ? fanotify::watch(paths, filter, callback, is_living, changes)
+      : inotify::watch(paths, filter, callback, is_living, changes);
 
 #elif defined(WATER_WATCHER_ADAPTER_LINUX_FANOTIFY)
 
-    fanotify::watch(path, callback, is_living);
+    fanotify::watch(paths, filter, callback, is_living, changes);
 
 #elif defined(WATER_WATCHER_ADAPTER_LINUX_INOTIFY)
 
-    inotify::watch(path, callback, is_living);
+    inotify::watch(paths, filter, callback, is_living, changes);
 
 #else
 
@@ -0,0 +1,350 @@
+#pragma once
+
+/*
+  @brief watcher/adapter/synthetic
+
+  An adapter which makes its events up, on any platform.
+
+  Nothing is read from the kernel and nothing on disk is
+  touched, so whatever is measured downstream of it (the
+  filter, the callback, the stages after it) is ours. See
+  `synthetic` for the shape of what it makes.
+*/
+
+/* log,
+   pow */
+#include <cmath>
+/* size_t */
+#include <cstddef>
+/* uint32_t,
+   uint64_t */
+#include <cstdint>
+/* path */
+#include <filesystem>
+/* function */
+#include <functional>
+/* string */
+#include <string>
+/* string_view */
+#include <string_view>
+/* steady_clock,
+   duration,
+   milliseconds */
+#include <chrono>
+/* this_thread::sleep_until */
+#include <thread>
+/* is_invocable_v */
+#include <type_traits>
+/* vector */
+#include <vector>
+/* event
+   diag
+   filter
+   policy
+   metrics
+   synthetic */
+#include <wtr/watcher.hpp>
+
+namespace detail {
+namespace wtr {
+namespace watcher {
+namespace adapter {
+namespace synthetic {
+
+/*  @brief watcher/adapter/synthetic/rng
+    A small, quick generator (splitmix64). The same seed
+    makes the same numbers everywhere. */
+struct rng {
+  std::uint64_t s{};
+
+  auto next() noexcept -> std::uint64_t
+  {
+    auto z = (this->s += 0x9e3779b97f4a7c15ull);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return z ^ (z >> 31);
+  }
+
+  /*  In [0, n). */
+  auto below(std::uint64_t n) noexcept -> std::uint64_t
+  {
+#if defined(__SIZEOF_INT128__)
+    return (std::uint64_t)(((unsigned __int128)this->next() * n) >> 64);
+#else
+    return this->next() % n;
+#endif
+  }
+
+  /*  In (0, 1]. */
+  auto unit() noexcept -> double
+  {
+    return (double)((this->next() >> 11) + 1) * 0x1.0p-53;
+  }
+};
+
+/*  @brief watcher/adapter/synthetic/tree
+    The files we make events for, each with its full path
+    and its name, and the directory it is in. Directories
+    have the state which their things start from in the
+    filter, or are pruned. With some `skew`, `pick` maps a
+    uniform number to a file, which is hotter the lower
+    its index. */
+struct tree {
+  std::vector<std::filesystem::path::string_type> paths{};
+  std::vector<std::string> names{};
+  std::vector<std::uint32_t> dir_of{};
+  std::vector<::wtr::watcher::filter::state> dir_states{};
+  std::vector<bool> dir_pruned{};
+  std::vector<std::uint32_t> pick{};
+};
+
+inline auto tree_of(std::filesystem::path const& root,
+                    ::wtr::watcher::synthetic const& s,
+                    ::wtr::watcher::filter const& filter) -> tree
+{
+  static constexpr char const* exts[] = {".txt", ".cpp", ".hpp", ".o"};
+
+  auto t = tree{};
+  auto const dir_count = s.depth > 0 && s.dirs > 0 ? s.dirs : 1;
+  auto const file_count = s.files > 0 ? s.files : 1;
+
+  auto dirs = std::vector<std::filesystem::path>{};
+  dirs.reserve(dir_count);
+  for (std::size_t d = 0; d < dir_count; ++d) {
+    auto rel = std::string{};
+    for (std::size_t level = 0; level < s.depth; ++level) {
+      if (level > 0) rel += '/';
+      rel += level == 0 ? "d" + std::to_string(d)
+                        : "s" + std::to_string(level);
+    }
+    auto state = filter.start();
+    auto pruned = false;
+    if (! filter.empty() && ! rel.empty()) {
+      state = filter.walk(state, rel);
+      pruned = filter.prunes(state);
+      state = filter.walk(state, "/");
+    }
+    dirs.push_back(rel.empty() ? root : root / rel);
+    t.dir_states.push_back(state);
+    t.dir_pruned.push_back(pruned);
+  }
+
+  t.paths.reserve(file_count);
+  t.names.reserve(file_count);
+  t.dir_of.reserve(file_count);
+  for (std::size_t f = 0; f < file_count; ++f) {
+    auto const d = f % dir_count;
+    t.names.push_back("f" + std::to_string(f) + exts[f % 4]);
+    t.paths.push_back((dirs[d] / t.names.back()).native());
+    t.dir_of.push_back((std::uint32_t)d);
+  }
+
+  /* The inverse of the distribution, at the middle of each
+     of a few buckets for each file. */
+  if (s.skew > 0) {
+    auto cdf = std::vector<double>(file_count);
+    auto sum = 0.0;
+    for (std::size_t f = 0; f < file_count; ++f)
+      cdf[f] = (sum += 1.0 / std::pow((double)(f + 1), s.skew));
+    auto const buckets = file_count * 4 < 65536 ? 65536 : file_count * 4;
+    t.pick.resize(buckets);
+    auto f = std::size_t{0};
+    for (std::size_t b = 0; b < buckets; ++b) {
+      auto const u = ((double)b + 0.5) / (double)buckets * sum;
+      while (f + 1 < file_count && cdf[f] < u) ++f;
+      t.pick[b] = (std::uint32_t)f;
+    }
+  }
+
+  return t;
+}
+
+/*
+  @brief watcher/adapter/synthetic/watch
+
+  @param path:
+   Where the files we make up are, beneath.
+
+  @param filter:
+   Which paths, beneath `path`, to send events for. The
+   `.gitignore`s beneath `path` aren't read.
+
+  @param stream:
+   What to make. See `synthetic`.
+
+  @param callback:
+   Where to send what we make: a Linux adapter's sink, or
+   an event callback.
+
+  @param is_living:
+   A function to decide whether we're dead.
+
+  @param clock:
+   What to stamp events with.
+
+  @param counts:
+   Where to count each chunk of events as a read, or
+   nothing. Sends are counted by the callback.
+
+  @param Policy:
+   Whether to send our status, which changes to send and
+   what to trace. See `policy` and `trace`.
+
+  Makes events until it is closed, or has made `count`.
+*/
+
+template<class Policy = ::wtr::watcher::policy, class Sink>
+inline bool watch(std::filesystem::path const& path,
+                  ::wtr::watcher::filter const& filter,
+                  ::wtr::watcher::synthetic const& stream,
+                  Sink const& callback,
+                  std::function<bool()> const& is_living,
+                  enum ::wtr::watcher::event::clock clock,
+                  ::wtr::watcher::metrics* counts = nullptr) noexcept
+{
+  using evk = enum ::wtr::watcher::event::kind;
+  using evw = enum ::wtr::watcher::event::what;
+  using ev = ::wtr::watcher::event;
+  using diag = ::wtr::watcher::diag;
+  using shape = enum ::wtr::watcher::synthetic::shape;
+  using trace = typename Policy::trace;
+  using steady = std::chrono::steady_clock;
+
+  auto const die = [&](bool clean) noexcept -> bool
+  {
+    if (clean && ! Policy::status) return clean;
+    if constexpr (requires { callback.tell(diag{}); })
+      callback.tell({.level = clean ? diag::level::status : diag::level::error,
+                     .code = diag::code::die,
+                     .where = path.native()});
+    else
+      callback({(clean ? "s/self/die@" : "e/self/die/bad_fs@") + path.string(),
+                evw::destroy,
+                evk::watcher});
+    return clean;
+  };
+
+  auto const send = [&callback](ev::compact const& e) noexcept
+  {
+    if constexpr (std::is_invocable_v<Sink const&, ev::compact const&>)
+      callback(e);
+    else
+      callback(ev{e});
+  };
+
+  trace::walk_begin(path);
+  auto const walk_began = trace::on ? trace::now() : 0;
+
+  auto t = tree{};
+  try {
+    t = tree_of(path, stream, filter);
+  } catch (...) {
+    return die(false);
+  }
+
+  trace::walk_end(path,
+                  t.dir_states.size(),
+                  trace::on ? trace::now() - walk_began : 0);
+
+  if (counts)
+    counts->marks.store(t.dir_states.size(), std::memory_order_relaxed);
+
+  /* What happens, in proportion. */
+  evw const whats[] = {evw::create, evw::modify, evw::destroy, evw::rename};
+  std::uint64_t const weights[] = {stream.create,
+                                   stream.modify,
+                                   stream.destroy,
+                                   stream.rename};
+  auto const weight_sum = weights[0] + weights[1] + weights[2] + weights[3];
+
+  auto r = rng{stream.seed};
+  auto const file_count = t.paths.size();
+  auto const per_ms = stream.rate / 1000.0;
+  auto const chunk_len = stream.rate > 0 && per_ms < stream.chunk
+                         ? (per_ms < 1 ? std::size_t{1} : (std::size_t)per_ms)
+                         : stream.chunk;
+
+  auto const burst_len = stream.burst > 0 ? stream.burst : 1;
+
+  auto made = std::uint64_t{0};
+  auto in_burst = std::size_t{0};
+  /* When the next chunk is due, in seconds after we began. */
+  auto due = 0.0;
+  auto const began = steady::now();
+
+  while (is_living() && (stream.count == 0 || made < stream.count)) {
+    auto n = chunk_len;
+    if (stream.count > 0 && stream.count - made < n)
+      n = (std::size_t)(stream.count - made);
+    if (stream.shape == shape::bursts && burst_len - in_burst < n)
+      n = burst_len - in_burst;
+
+    if (due > 0) {
+      auto const at = began
+                    + std::chrono::duration_cast<steady::duration>(
+                      std::chrono::duration<double>(due));
+      if (at > steady::now()) std::this_thread::sleep_until(at);
+    }
+
+    auto const when = ev::now(clock);
+    auto const events_before =
+      counts ? counts->events.load(std::memory_order_relaxed) : 0;
+
+    for (std::size_t i = 0; i < n; ++i) {
+      auto const f = t.pick.empty() ? (std::size_t)r.below(file_count)
+                                    : t.pick[r.below(t.pick.size())];
+      auto what = whats[0];
+      if (weight_sum > 0) {
+        auto w = r.below(weight_sum);
+        for (std::size_t k = 0; k < 4; ++k) {
+          if (w < weights[k]) {
+            what = whats[k];
+            break;
+          }
+          w -= weights[k];
+        }
+      }
+      auto const& name = t.names[f];
+      auto const d = t.dir_of[f];
+      trace::decoded(what, evk::file, name.size());
+      if (! Policy::watches(what) || t.dir_pruned[d]) continue;
+      if (! filter.empty()
+          && ! filter.keeps(filter.walk(t.dir_states[d], name), evk::file))
+        continue;
+      send(ev::compact{t.paths[f], what, evk::file, when, clock});
+    }
+
+    made += n;
+    in_burst += n;
+
+    if (counts) {
+      ::wtr::watcher::metrics::add(counts->reads);
+      counts->read_events.record(
+        counts->events.load(std::memory_order_relaxed) - events_before);
+    }
+
+    if (stream.rate > 0) {
+      if (stream.shape == shape::poisson)
+        for (std::size_t i = 0; i < n; ++i)
+          due -= std::log(r.unit()) / stream.rate;
+      else
+        due += (double)n / stream.rate;
+    }
+    /* The pause is from the end of the burst, or from when
+       it should have ended, whichever is later. */
+    if (stream.shape == shape::bursts && in_burst >= burst_len) {
+      auto const now =
+        std::chrono::duration<double>(steady::now() - began).count();
+      in_burst = 0;
+      due = (due > now ? due : now) + stream.pause_ms / 1000.0;
+    }
+  }
+
+  return die(true);
+}
+
+} /* namespace synthetic */
+} /* namespace adapter */
+} /* namespace watcher */
+} /* namespace wtr */
+} /* namespace detail */
@@ -6,6 +6,8 @@
 #if defined(WATER_WATCHER_PLATFORM_UNKNOWN) \
   || defined(WATER_WATCHER_USE_WARTHOG)
 
+#define WATER_WATCHER_ADAPTER_WARTHOG
+
 /*
   @brief watcher/adapter/warthog
 
@@ -21,8 +23,12 @@
 
 /* milliseconds */
 #include <chrono>
+/* uint64_t */
+#include <cstdint>
 /* string */
 #include <string>
+/* string_view */
+#include <string_view>
 /* filesystem::* */
 #include <filesystem>
 /* function */
@@ -34,7 +40,10 @@
 /* unordered_map */
 #include <unordered_map>
 /* event
-   callback */
+   callback
+   filter
+   policy
+   metrics */
 #include <wtr/watcher.hpp>
 
 namespace detail {
@@ -232,10 +241,24 @@ inline bool tend_bucket(std::filesystem::path const& path,
   @param path:
    A path to watch for changes.
 
+  @param filter:
+   Which paths, beneath `path`, to send events for.
+
   @param callback:
    A callback to perform when the files
    being watched change.
 
+  @param counts:
+   Where to count our scans, how many events each one
+   sends and how many files we know about, or nothing.
+   Other roots may be counted there too, from their own
+   threads, so we only add (and take back) our own.
+
+  @param Policy:
+   How long to sleep between scans, whether to send our
+   status, which changes to send and what to trace. See
+   `policy` and `trace`.
+
   Monitors `path` for changes.
 
   Calls `callback` with an `event` when they happen.
@@ -243,11 +266,17 @@ inline bool tend_bucket(std::filesystem::path const& path,
   Unless it should stop, or errors present, `watch` recurses.
 */
 
+template<class Policy = ::wtr::watcher::policy>
 inline bool watch(std::filesystem::path const& path,
+                  ::wtr::watcher::filter const& filter,
                   ::wtr::watcher::event::callback const& callback,
-                  std::function<bool()> const& is_living) noexcept
+                  std::function<bool()> const& is_living,
+                  ::wtr::watcher::metrics* counts = nullptr) noexcept
 {
+  using evk = enum ::wtr::watcher::event::kind;
+  using evw = enum ::wtr::watcher::event::what;
   using std::this_thread::sleep_for, std::chrono::milliseconds;
+  using trace = typename Policy::trace;
   /* Sleep for `delay_ms`.
 
      Then, keep running if
@@ -259,11 +288,55 @@ inline bool watch(std::filesystem::path const& path,
 
   bucket_type bucket;
 
-  static constexpr auto delay_ms = 16;
+  /* Our own copy, which reads the `.gitignore`s if it should. */
+  auto live = filter.loaded(path);
+
+  /* What we sent, and how many files we have counted as
+     known, so far. */
+  auto sent = std::uint64_t{0};
+  auto known = std::uint64_t{0};
+
+  /* We scan paths, not names, so we match them as we send.
+     When a `.gitignore` changes, we read them again. */
+  auto const send_event = [&](::wtr::watcher::event const& e) noexcept
+  {
+    if (live.reloads(std::string_view{e.where.filename().native()}))
+      live = live.loaded(path);
+    if (! Policy::watches(e.what)) return;
+    trace::decoded(e.what, e.kind, e.where.native().size());
+    if (live.empty()
+        || live.keeps(e.where.lexically_relative(path).generic_string(),
+                      e.kind)) {
+      ++sent;
+      callback(e);
+    }
+  };
+
+  /* Counts a scan, and what it sent. */
+  auto const count = [&](std::uint64_t sent_before) noexcept
+  {
+    if (! counts) return;
+    ::wtr::watcher::metrics::add(counts->reads);
+    counts->read_events.record(sent - sent_before);
+    ::wtr::watcher::metrics::add(counts->marks, bucket.size() - known);
+    known = bucket.size();
+  };
+
+  static constexpr auto delay_ms = Policy::delay_ms;
 
   while (is_living()) {
-    if (! tend_bucket(path, callback, bucket)
-        || ! scan(path, callback, bucket)) {
+    /* An empty bucket is filled by walking the tree. */
+    auto const walking = trace::on && bucket.empty();
+    if (walking) trace::walk_begin(path);
+    auto const walk_began = walking ? trace::now() : 0;
+    auto const tended = tend_bucket(path, send_event, bucket);
+    if (walking)
+      trace::walk_end(path, bucket.size(), trace::now() - walk_began);
+    auto const sent_before = sent;
+    auto const scanned = tended && scan(path, send_event, bucket);
+    count(sent_before);
+    if (! scanned) {
+      if (counts) counts->marks.fetch_sub(known, std::memory_order_relaxed);
       callback(
         {"e/self/die/bad_fs@" + path.string(), evw::destroy, evk::watcher});
 
@@ -274,7 +347,10 @@ inline bool watch(std::filesystem::path const& path,
     }
   }
 
-  callback({"s/self/die@" + path.string(), evw::destroy, evk::watcher});
+  if (counts) counts->marks.fetch_sub(known, std::memory_order_relaxed);
+
+  if constexpr (Policy::status)
+    callback({"s/self/die@" + path.string(), evw::destroy, evk::watcher});
 
   return true;
 }
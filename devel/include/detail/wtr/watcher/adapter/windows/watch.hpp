@@ -26,10 +26,13 @@
 /* string
    wstring */
 #include <string>
+/* string_view */
+#include <string_view>
 /* this_thread::sleep_for */
 #include <thread>
 /* event
-   callback */
+   callback
+   filter */
 #include <wtr/watcher.hpp>
 
 namespace detail {
@@ -155,8 +158,27 @@ do_event_recv(watch_event_proxy& w,
   }
 }
 
+/*  The name, relative to the watched path, as utf8 with
+    forward slashes, which is what filters match. */
+inline auto filter_name(FILE_NOTIFY_INFORMATION const* buf) noexcept
+  -> std::string
+{
+  auto const len = static_cast<int>(buf->FileNameLength / 2);
+  auto name = std::string{};
+  auto n =
+    WideCharToMultiByte(CP_UTF8, 0, buf->FileName, len, nullptr, 0, 0, 0);
+  if (n > 0) {
+    name.resize(static_cast<std::size_t>(n));
+    WideCharToMultiByte(CP_UTF8, 0, buf->FileName, len, name.data(), n, 0, 0);
+    for (auto& c : name)
+      if (c == '\\') c = '/';
+  }
+  return name;
+}
+
 inline bool
 do_event_send(watch_event_proxy& w,
+              ::wtr::watcher::filter& filter,
               ::wtr::watcher::event::callback const& callback) noexcept
 {
   using namespace ::wtr::watcher;
@@ -166,7 +188,18 @@ do_event_send(watch_event_proxy& w,
   if (is_valid(w)) {
     while (buf + sizeof(FILE_NOTIFY_INFORMATION)
            <= buf + w.event_buf_len_ready) {
-      if (buf->FileNameLength % 2 == 0) {
+      /* Match the name before we make anything out of it.
+         We don't know its kind yet, so we can only skip it
+         if it isn't kept either way. */
+      auto name = filter.empty() ? std::string{} : filter_name(buf);
+      auto state = filter.walk(filter.start(), name);
+      auto maybe_kept = filter.empty()
+                     || filter.keeps(state, event::kind::file)
+                     || filter.keeps(state, event::kind::dir);
+      auto reload = filter.reloads(
+        std::string_view{name}.substr(name.rfind('/') + 1));
+
+      if (buf->FileNameLength % 2 == 0 && maybe_kept) {
         auto where =
           w.path / std::wstring{buf->FileName, buf->FileNameLength / 2};
 
@@ -192,14 +225,17 @@ do_event_send(watch_event_proxy& w,
           }
         }();
 
-        callback({where, what, kind});
-
-        if (buf->NextEntryOffset == 0)
-          break;
-        else
-          buf =
-            (FILE_NOTIFY_INFORMATION*)((uint8_t*)buf + buf->NextEntryOffset);
+        if (filter.empty() || filter.keeps(state, kind))
+          callback({where, what, kind});
       }
+
+      /* A `.gitignore` changed. */
+      if (reload) filter = filter.loaded(w.path);
+
+      if (buf->NextEntryOffset == 0)
+        break;
+      else
+        buf = (FILE_NOTIFY_INFORMATION*)((uint8_t*)buf + buf->NextEntryOffset);
     }
     return true;
   }
@@ -217,6 +253,7 @@ do_event_send(watch_event_proxy& w,
    true if no errors */
 
 inline bool watch(std::filesystem::path const& path,
+                  ::wtr::watcher::filter const& filter,
                   ::wtr::watcher::event::callback const& callback,
                   std::function<bool()> const& is_living) noexcept
 {
@@ -224,10 +261,13 @@ inline bool watch(std::filesystem::path const& path,
 
   auto w = watch_event_proxy{path};
 
+  /* Our own copy, which reads the `.gitignore`s if it should. */
+  auto live = filter.loaded(path);
+
   if (is_valid(w)) {
     do_event_recv(w, callback);
 
-    while (is_valid(w) && has_event(w)) { do_event_send(w, callback); }
+    while (is_valid(w) && has_event(w)) { do_event_send(w, live, callback); }
 
     while (is_living()) {
       ULONG_PTR completion_key{0};
@@ -241,7 +281,7 @@ inline bool watch(std::filesystem::path const& path,
 
       if (complete && overlap) {
         while (is_valid(w) && has_event(w)) {
-          do_event_send(w, callback);
+          do_event_send(w, live, callback);
           do_event_recv(w, callback);
         }
       }
@@ -0,0 +1,154 @@
+#pragma once
+
+/*  istreambuf_iterator */
+#include <iterator>
+/*  path
+    exists
+    is_directory
+    directory_options
+    recursive_directory_iterator */
+#include <filesystem>
+/*  ifstream */
+#include <fstream>
+/*  string */
+#include <string>
+/*  string_view */
+#include <string_view>
+/*  error_code */
+#include <system_error>
+/*  pair */
+#include <utility>
+/*  vector */
+#include <vector>
+/*  glob
+    beneath */
+#include <detail/wtr/watcher/filter/glob.hpp>
+
+namespace detail {
+namespace wtr {
+namespace watcher {
+namespace filter {
+namespace gitignore {
+
+using rule_list = std::vector<std::pair<std::string, glob::verdict>>;
+
+/*  @brief wtr/watcher/<d>/filter/gitignore/parse
+    The patterns in a `.gitignore` file, in order, with what
+    git does with what they match: ignore (drop) it or, for
+    a pattern starting with `!`, not ignore (keep) it.
+
+    Blank lines and lines starting with `#` are skipped, and
+    trailing spaces are trimmed unless they are escaped. */
+inline auto parse(std::string_view text) noexcept -> rule_list
+{
+  auto rules = rule_list{};
+  while (! text.empty()) {
+    auto const eol = text.find('\n');
+    auto line = text.substr(0, eol);
+    text.remove_prefix(eol == std::string_view::npos ? text.size() : eol + 1);
+
+    if (! line.empty() && line.back() == '\r') line.remove_suffix(1);
+    while (! line.empty() && line.back() == ' '
+           && ! (line.size() > 1 && line[line.size() - 2] == '\\'))
+      line.remove_suffix(1);
+    if (line.empty() || line.front() == '#') continue;
+
+    if (line.front() == '!')
+      rules.emplace_back(line.substr(1), glob::verdict::keep);
+    else
+      rules.emplace_back(line, glob::verdict::drop);
+  }
+  return rules;
+}
+
+/*  @brief wtr/watcher/<d>/filter/gitignore/rebase
+    A pattern from the `.gitignore` in `dir` (relative to
+    the root, with forward slashes), as a pattern which is
+    relative to the root. */
+inline auto rebase(std::string_view dir, std::string_view pattern) noexcept
+  -> std::string
+{
+  if (dir.empty()) return std::string{pattern};
+
+  auto rebased = std::string{};
+  for (auto c : dir) {
+    if (c == '*' || c == '?' || c == '[' || c == '\\') rebased += '\\';
+    rebased += c;
+  }
+
+  auto const trimmed = pattern.size() > 1 && pattern.back() == '/'
+                       ? pattern.substr(0, pattern.size() - 1)
+                       : pattern;
+  auto const anchored = trimmed.find('/') != std::string_view::npos;
+  if (! pattern.empty() && pattern.front() == '/') pattern.remove_prefix(1);
+
+  rebased += anchored ? "/" : "/**/";
+  rebased += pattern;
+  return rebased;
+}
+
+/*  @brief wtr/watcher/<d>/filter/gitignore/load
+    The rules from every `.gitignore` file beneath `root`
+    which git would read, as patterns relative to `root`.
+
+    The rules from a directory come after the rules from
+    its parents, so that they win, as they do for git.
+
+    Git never looks inside `.git`, so neither do we. Nor do
+    we look inside directories which are ignored, because
+    nothing beneath them can be un-ignored. That is also
+    where most of the work would be. */
+inline auto load(std::filesystem::path const& root) noexcept -> rule_list
+{
+  namespace fs = ::std::filesystem;
+
+  static constexpr auto dopt = fs::directory_options::skip_permission_denied
+                             | fs::directory_options::follow_directory_symlink;
+
+  auto rules = rule_list{{".git/", glob::verdict::drop}};
+
+  auto read = [&rules](fs::path const& dir, std::string_view rel) noexcept
+  {
+    auto file = std::ifstream{dir / ".gitignore", std::ios::binary};
+    if (file.is_open()) {
+      auto text = std::string{std::istreambuf_iterator<char>{file},
+                              std::istreambuf_iterator<char>{}};
+      for (auto& [pattern, verdict] : parse(text))
+        rules.emplace_back(rebase(rel, pattern), verdict);
+      return true;
+    }
+    return false;
+  };
+
+  try {
+    read(root, "");
+    auto matcher = glob{rules};
+
+    auto ec = std::error_code{};
+    if (fs::is_directory(root, ec))
+      for (auto it = fs::recursive_directory_iterator{root, dopt, ec};
+           ! ec && it != fs::recursive_directory_iterator{};
+           it.increment(ec)) {
+        if (! it->is_directory(ec)) continue;
+
+        auto const generic = it->path().generic_string();
+        auto const rel = beneath<char>(generic, root.generic_string());
+
+        if (matcher.decides(matcher.walk(glob::start(), rel), true)
+            == glob::verdict::drop) {
+          it.disable_recursion_pending();
+          continue;
+        }
+
+        if (read(it->path(), rel)) matcher = glob{rules};
+      }
+  } catch (...) {}
+
+  return rules;
+}
+
+} /* namespace gitignore */
+} /* namespace filter */
+} /* namespace watcher */
+} /* namespace wtr */
+} /* namespace detail */
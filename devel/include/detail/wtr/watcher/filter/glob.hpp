@@ -0,0 +1,328 @@
+#pragma once
+
+/*  find
+    sort
+    unique */
+#include <algorithm>
+/*  array */
+#include <array>
+/*  size_t */
+#include <cstddef>
+/*  uint8_t
+    uint32_t */
+#include <cstdint>
+/*  map */
+#include <map>
+/*  string */
+#include <string>
+/*  string_view */
+#include <string_view>
+/*  move */
+#include <utility>
+/*  vector */
+#include <vector>
+
+namespace detail {
+namespace wtr {
+namespace watcher {
+namespace filter {
+
+/*  @brief wtr/watcher/<d>/filter/glob
+    Matches paths against a list of glob patterns.
+
+    The patterns are compiled into one (nondeterministic)
+    automaton. We walk it one byte at a time, building a
+    deterministic automaton as we go: each set of places we
+    can be in the patterns becomes a state, and each state
+    remembers where every byte takes it. After a short
+    warm-up, walking a path is a table lookup per byte.
+
+    States can be kept. The state after "a/b/" is where
+    every name in "a/b" starts, so adapters keep one per
+    directory and only walk the names of what happens.
+
+    The syntax is that of `.gitignore`:
+      - `*` matches anything but a `/`.
+      - `?` matches one thing which isn't a `/`.
+      - `[a-z]`, `[!a-z]` and `[^a-z]` match (or don't
+        match) one thing in a set.
+      - `**` as a whole directory name matches any number
+        of directories (including none). At the end, it
+        matches anything beneath a directory.
+      - `\` makes the next character literal.
+      - A pattern with no `/` in it (besides at the end)
+        matches names at any depth. Otherwise, it matches
+        from the root. A leading `/` only anchors it.
+      - A pattern ending in `/` only matches directories.
+
+    When more than one pattern matches, the last one wins.
+    Anything beneath a directory which is dropped is dropped
+    as well, and that can't be undone by a later pattern. We
+    know this as soon as we walk past the directory's `/`,
+    so we go to a state which never leaves.
+
+    Building the automaton is not thread safe. Each watcher
+    has its own copy. */
+class glob {
+public:
+  using state = std::uint32_t;
+
+  enum class verdict : std::uint8_t { none, keep, drop };
+
+private:
+  enum class op : std::uint8_t { byte, any, set, star, rest, dirs, end };
+
+  struct token {
+    op o;
+    /* The byte, the set or the pattern, by `o`. */
+    std::uint32_t arg;
+  };
+
+  struct rule {
+    verdict on_match;
+    bool dir_only;
+  };
+
+  using positions = std::vector<std::uint32_t>;
+
+  static constexpr auto unknown = ~state{0};
+
+  std::vector<token> tokens{};
+  std::vector<std::array<bool, 256>> sets{};
+  std::vector<rule> rules{};
+  positions starts{};
+
+  /*  The lazily built automaton. */
+  struct node {
+    std::array<state, 256> next;
+    std::array<verdict, 2> decides;
+  };
+
+  std::vector<node> nodes{};
+  std::vector<positions> places{};
+  std::map<positions, state> known{};
+
+  /*  Follows the places which can match nothing. Any number
+      of directories end where a name starts: at the root, or
+      after a `/`, which is what `at_name` says. */
+  auto close(positions& at, bool at_name) const noexcept -> void
+  {
+    for (auto i = std::size_t{0}; i < at.size(); ++i) {
+      auto const o = this->tokens[at[i]].o;
+      if (o == op::star || o == op::rest || (o == op::dirs && at_name))
+        if (std::find(at.begin(), at.end(), at[i] + 1) == at.end())
+          at.push_back(at[i] + 1);
+    }
+    std::sort(at.begin(), at.end());
+    at.erase(std::unique(at.begin(), at.end()), at.end());
+  }
+
+  auto intern(positions&& at) -> state
+  {
+    if (auto s = this->known.find(at); s != this->known.end())
+      return s->second;
+
+    auto n = node{};
+    n.next.fill(unknown);
+    n.decides.fill(verdict::none);
+    /* Later patterns win, and positions are in pattern order. */
+    for (auto p : at)
+      if (this->tokens[p].o == op::end) {
+        auto const& r = this->rules[this->tokens[p].arg];
+        n.decides[1] = r.on_match;
+        if (! r.dir_only) n.decides[0] = r.on_match;
+      }
+
+    auto const s = static_cast<state>(this->nodes.size());
+    this->nodes.push_back(n);
+    this->places.push_back(at);
+    this->known.emplace(std::move(at), s);
+    return s;
+  }
+
+  auto build(state from, unsigned char b) -> state
+  {
+    auto at = positions{};
+    for (auto p : this->places[from]) {
+      auto const& t = this->tokens[p];
+      switch (t.o) {
+        case op::byte :
+          if (b == t.arg) at.push_back(p + 1);
+          break;
+        case op::any :
+          if (b != '/') at.push_back(p + 1);
+          break;
+        case op::set :
+          if (b != '/' && this->sets[t.arg][b]) at.push_back(p + 1);
+          break;
+        case op::star :
+          if (b != '/') at.push_back(p);
+          break;
+        case op::rest : at.push_back(p); break;
+        case op::dirs : at.push_back(p); break;
+        case op::end : break;
+      }
+    }
+    this->close(at, b == '/');
+    auto const to = b == '/' && this->nodes[from].decides[1] == verdict::drop
+                    ? pruned()
+                    : this->intern(std::move(at));
+    this->nodes[from].next[b] = to;
+    return to;
+  }
+
+  /*  Reads `[...]` from `p` at `i`, which is past the `[`.
+      Returns false, and leaves `i` alone, if it isn't a set. */
+  auto parse_set(std::string_view p, std::size_t& i) -> bool
+  {
+    auto s = std::array<bool, 256>{};
+    auto j = i;
+    auto negate = j < p.size() && (p[j] == '!' || p[j] == '^');
+    if (negate) ++j;
+    auto first = true;
+    for (; j < p.size() && (first || p[j] != ']'); ++j, first = false) {
+      auto lo = static_cast<unsigned char>(p[j]);
+      if (p[j] == '\\' && j + 1 < p.size())
+        lo = static_cast<unsigned char>(p[++j]);
+      auto hi = lo;
+      if (j + 2 < p.size() && p[j + 1] == '-' && p[j + 2] != ']') {
+        hi = static_cast<unsigned char>(p[j + 2]);
+        j += 2;
+      }
+      for (auto c = unsigned{lo}; c <= hi; ++c) s[c] = true;
+    }
+    if (j >= p.size()) return false;
+    if (negate)
+      for (auto& c : s) c = ! c;
+    this->tokens.push_back(
+      {op::set, static_cast<std::uint32_t>(this->sets.size())});
+    this->sets.push_back(s);
+    i = j + 1;
+    return true;
+  }
+
+  auto compile(std::string_view p, verdict on_match) -> void
+  {
+    auto const dir_only = p.size() > 1 && p.back() == '/'
+                       && p[p.size() - 2] != '\\';
+    if (dir_only) p.remove_suffix(1);
+    auto const anchored = p.find('/') != std::string_view::npos;
+    if (! p.empty() && p.front() == '/') p.remove_prefix(1);
+
+    this->starts.push_back(static_cast<std::uint32_t>(this->tokens.size()));
+    if (! anchored) this->tokens.push_back({op::dirs, 0});
+
+    for (auto i = std::size_t{0}; i < p.size();) {
+      auto const c = p[i];
+      if (c == '*') {
+        auto n = std::size_t{0};
+        while (i + n < p.size() && p[i + n] == '*') ++n;
+        auto const after_sep = i == 0 || p[i - 1] == '/';
+        auto const at_end = i + n == p.size();
+        auto const before_sep = ! at_end && p[i + n] == '/';
+        if (n >= 2 && after_sep && before_sep) {
+          this->tokens.push_back({op::dirs, 0});
+          i += n + 1;
+        }
+        else if (n >= 2 && after_sep && at_end) {
+          this->tokens.push_back({op::rest, 0});
+          i += n;
+        }
+        else {
+          this->tokens.push_back({op::star, 0});
+          i += n;
+        }
+      }
+      else if (c == '?') {
+        this->tokens.push_back({op::any, 0});
+        ++i;
+      }
+      else if (c == '[') {
+        if (! this->parse_set(p, ++i)) this->tokens.push_back({op::byte, '['});
+      }
+      else {
+        if (c == '\\' && i + 1 < p.size()) ++i;
+        this->tokens.push_back(
+          {op::byte, static_cast<unsigned char>(p[i++])});
+      }
+    }
+
+    this->tokens.push_back(
+      {op::end, static_cast<std::uint32_t>(this->rules.size())});
+    this->rules.push_back({on_match, dir_only});
+  }
+
+  /*  Makes the start state and, after it, the pruned state. */
+  auto begin(positions&& at) -> void
+  {
+    this->intern(std::move(at));
+    auto n = node{};
+    n.next.fill(pruned());
+    n.decides.fill(verdict::drop);
+    this->nodes.push_back(n);
+    this->places.push_back({});
+  }
+
+public:
+  glob() noexcept { this->begin(positions{}); }
+
+  /*  Each pattern is matched with what to do with what it
+      matches: keep it or drop it. */
+  glob(std::vector<std::pair<std::string, verdict>> const& patterns) noexcept
+  {
+    for (auto const& [p, v] : patterns) this->compile(p, v);
+    auto at = this->starts;
+    this->close(at, true);
+    this->begin(std::move(at));
+  }
+
+  auto empty() const noexcept -> bool { return this->rules.empty(); }
+
+  /*  Where every path starts: the root. */
+  static constexpr auto start() noexcept -> state { return 0; }
+
+  /*  Where everything beneath a dropped directory is. */
+  static constexpr auto pruned() noexcept -> state { return 1; }
+
+  /*  Walks `bytes` from `from`. */
+  auto walk(state from, std::string_view bytes) noexcept -> state
+  {
+    auto s = from;
+    for (auto c : bytes) {
+      auto const b = static_cast<unsigned char>(c);
+      auto const to = this->nodes[s].next[b];
+      s = to != unknown ? to : this->build(s, b);
+    }
+    return s;
+  }
+
+  /*  What the last pattern to match a path which ends
+      at `at` says to do with it. */
+  auto decides(state at, bool is_dir) const noexcept -> verdict
+  {
+    return this->nodes[at].decides[is_dir ? 1 : 0];
+  }
+
+  /*  The number of states built so far. */
+  auto size() const noexcept -> std::size_t { return this->nodes.size(); }
+};
+
+/*  @brief wtr/watcher/<d>/filter/beneath
+    The part of `path` which is beneath `root`, without a
+    leading separator. All of `path`, if it isn't beneath
+    `root`. */
+template<class Char>
+inline auto beneath(std::basic_string_view<Char> path,
+                    std::basic_string_view<Char> root) noexcept
+  -> std::basic_string_view<Char>
+{
+  if (path.substr(0, root.size()) == root) path.remove_prefix(root.size());
+  while (! path.empty() && (path.front() == '/' || path.front() == '\\'))
+    path.remove_prefix(1);
+  return path;
+}
+
+} /* namespace filter */
+} /* namespace watcher */
+} /* namespace wtr */
+} /* namespace detail */
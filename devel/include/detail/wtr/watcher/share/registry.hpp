@@ -0,0 +1,265 @@
+#pragma once
+
+/*  sort,
+    find,
+    find_if,
+    min */
+#include <algorithm>
+/*  uint64_t */
+#include <cstdint>
+/*  path,
+    weakly_canonical */
+#include <filesystem>
+/*  function */
+#include <functional>
+/*  mutex
+    scoped_lock */
+#include <mutex>
+/*  basic_string_view */
+#include <string_view>
+/*  error_code */
+#include <system_error>
+/*  exchange
+    move */
+#include <utility>
+/*  vector */
+#include <vector>
+/*  stage::route */
+#include <detail/wtr/watcher/stage/route.hpp>
+/*  event
+    diag
+    with_diags
+    filter
+    adapter */
+#include <wtr/watcher.hpp>
+
+namespace detail {
+namespace wtr {
+namespace watcher {
+namespace share {
+
+/*  @brief wtr/watcher/<d>/share/registry
+    The shared watches in this process, and the one watcher
+    which they share.
+
+    The watcher watches as few roots as cover everyone's
+    paths: none of them is beneath another. A path beneath
+    one which is already watched costs nothing more than a
+    place in the list. A path above some which are watched
+    is added to the watcher, and those beneath it are then
+    removed from it, so their trees are never unwatched.
+    When a watch is closed, the roots are worked out again,
+    the same way, and the last one to close closes the
+    watcher.
+
+    Events are sent to each watch whose path they happened
+    beneath, and which wants what happened to that kind of
+    path, after its filter (relative to that path). They
+    find those watches by walking down a `stage::route`
+    along their path, past the watches they aren't for.
+    Warnings and errors from the watcher are sent to each
+    watch whose path they are about (above or beneath), or
+    to everyone if they aren't about a path. Whether the
+    watcher is alive, or not, is for us, not for them: it
+    is watching other roots than they asked for, which come
+    and go as they join and leave.
+
+    Everyone's callbacks are called on the watcher's thread,
+    one after another, while we hold our lock. A callback
+    can't open or close a shared watch.
+
+    There is one of these for each `Policy`. */
+template<class Policy>
+class registry {
+public:
+  using callback_type = ::wtr::watcher::event::compact::callback;
+
+private:
+  using ev = ::wtr::watcher::event;
+  using string_type = std::filesystem::path::string_type;
+  using view_type =
+    std::basic_string_view<std::filesystem::path::value_type>;
+
+  static constexpr auto sep = std::filesystem::path::preferred_separator;
+
+  using route = ::detail::wtr::watcher::stage::route;
+
+  struct subscriber {
+    std::uint64_t id{};
+    string_type path{};
+    route::mask wants{};
+    callback_type callback{};
+    ::wtr::watcher::diag::callback diags{};
+  };
+
+  std::mutex lk{};
+  ::detail::wtr::watcher::adapter::future::shared watcher{};
+  std::vector<string_type> roots{};
+  std::vector<subscriber> subscribers{};
+  route routes{};
+
+  /*  Whether `path` is `root`, or beneath it. */
+  static auto beneath(view_type path, view_type root) noexcept -> bool
+  {
+    return path.starts_with(root)
+        && (path.size() == root.size() || path[root.size()] == sep
+            || root.ends_with(sep));
+  }
+
+  /*  As few paths as cover everyone's, none of them beneath
+      another. The shallowest are taken first. */
+  auto cover() const noexcept -> std::vector<string_type>
+  {
+    auto paths = std::vector<string_type>{};
+    for (auto const& s : this->subscribers) paths.push_back(s.path);
+    std::sort(paths.begin(),
+              paths.end(),
+              [](auto const& a, auto const& b)
+              {
+                return a.size() < b.size()
+                    || (a.size() == b.size() && a < b);
+              });
+    auto covered = std::vector<string_type>{};
+    for (auto const& p : paths) {
+      auto above = false;
+      for (auto const& c : covered) above = above || beneath(p, c);
+      if (! above) covered.push_back(p);
+    }
+    return covered;
+  }
+
+  /*  Asks the watcher to watch the roots which now cover
+      everyone's paths, adding before removing. */
+  auto recover() noexcept -> void
+  {
+    using ::detail::wtr::watcher::adapter::add;
+    using ::detail::wtr::watcher::adapter::remove;
+    auto const covered = this->cover();
+    auto const has = [](auto const& in, auto const& p)
+    { return std::find(in.begin(), in.end(), p) != in.end(); };
+    for (auto const& p : covered)
+      if (! has(this->roots, p)) add(this->watcher, p);
+    for (auto const& p : this->roots)
+      if (! has(covered, p)) remove(this->watcher, p);
+    this->roots = covered;
+  }
+
+  /*  Sends `e` to everyone it is for. */
+  auto send(ev::compact const& e) noexcept -> void
+  {
+    auto _ = std::scoped_lock{this->lk};
+    auto mine = e;
+    mine.root = 0;
+    this->routes(mine);
+  }
+
+  /*  Sends what the watcher says to everyone it is about. */
+  auto say(::wtr::watcher::diag const& d) noexcept -> void
+  {
+    if (d.level == ::wtr::watcher::diag::level::status) return;
+    auto _ = std::scoped_lock{this->lk};
+    auto const message = d.message();
+    for (auto const& s : this->subscribers) {
+      if (! d.where.empty() && ! beneath(d.where, s.path)
+          && ! beneath(s.path, d.where))
+        continue;
+      if (! s.wants.has(d.what(), ev::kind::watcher)) continue;
+      if (s.diags)
+        s.diags(d);
+      else
+        s.callback({message, d.what(), ev::kind::watcher});
+    }
+  }
+
+  registry() noexcept = default;
+
+public:
+  registry(registry const&) = delete;
+  registry& operator=(registry const&) = delete;
+
+  ~registry() noexcept
+  {
+    if (this->watcher) ::detail::wtr::watcher::adapter::close(this->watcher);
+  }
+
+  static auto instance() noexcept -> registry&
+  {
+    static auto r = registry{};
+    return r;
+  }
+
+  /*  Adds a watch on `path`, for what `wants` has, and
+      gives back what it is known by, to `leave` with. What
+      the watcher says goes to `diags`, if there are any, or
+      to `callback`. */
+  auto join(std::filesystem::path const& path,
+            ::wtr::watcher::filter const& filter,
+            callback_type callback,
+            ::wtr::watcher::diag::callback diags = {},
+            route::mask wants = {}) noexcept -> std::uint64_t
+  {
+    auto ec = std::error_code{};
+    auto real = std::filesystem::weakly_canonical(path, ec).native();
+    if (real.empty()) real = path.native();
+    while (real.size() > 1 && real.ends_with(sep)) real.pop_back();
+
+    /* Matched relative to `real`. */
+    auto const filtered =
+      [live = filter.loaded(real), skip = real.size(), callback](
+        ev::compact const& e) noexcept
+    {
+      auto rel = e.where.substr(std::min(skip, e.where.size()));
+      while (rel.starts_with(sep)) rel.remove_prefix(1);
+      if (live.keeps(rel, e.kind)) callback(e);
+    };
+
+    auto _ = std::scoped_lock{this->lk};
+    auto const id = filter.empty() ? this->routes.add(real, callback, wants)
+                                   : this->routes.add(real, filtered, wants);
+    this->subscribers.push_back(
+      {id, real, wants, std::move(callback), std::move(diags)});
+    /* Opened with nothing to watch, it has nothing to say
+       yet, so it doesn't call us back while we hold the
+       lock. Its roots are added as they would be later. */
+    if (! this->watcher)
+      this->watcher = ::detail::wtr::watcher::adapter::open<Policy>(
+        std::vector<std::filesystem::path>{},
+        ::wtr::watcher::filter{},
+        ::wtr::watcher::with_diags(
+          [this](ev::compact const& e) noexcept { this->send(e); },
+          [this](::wtr::watcher::diag const& d) noexcept { this->say(d); }));
+    this->recover();
+    return id;
+  }
+
+  /*  Closes the watch known by `id`. The last one closes
+      the watcher, and says whether it closed cleanly. The
+      others say true. Anything closed already says false. */
+  auto leave(std::uint64_t id) noexcept -> bool
+  {
+    auto last = ::detail::wtr::watcher::adapter::future::shared{};
+    {
+      auto _ = std::scoped_lock{this->lk};
+      auto const at = std::find_if(this->subscribers.begin(),
+                                   this->subscribers.end(),
+                                   [id](auto const& s) { return s.id == id; });
+      if (at == this->subscribers.end()) return false;
+      this->subscribers.erase(at);
+      this->routes.remove(id);
+      if (! this->subscribers.empty()) {
+        this->recover();
+        return true;
+      }
+      this->roots.clear();
+      last = std::exchange(this->watcher, {});
+    }
+    /* Not while we hold the lock, which the watcher takes
+       to send what it has left. */
+    return ::detail::wtr::watcher::adapter::close(last);
+  }
+};
+
+} /* namespace share */
+} /* namespace watcher */
+} /* namespace wtr */
+} /* namespace detail */
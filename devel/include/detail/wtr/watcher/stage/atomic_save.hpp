@@ -0,0 +1,413 @@
+#pragma once
+
+/*  max */
+#include <algorithm>
+/*  milliseconds
+    steady_clock */
+#include <chrono>
+/*  uint32_t
+    uint64_t */
+#include <cstdint>
+/*  path */
+#include <filesystem>
+/*  function */
+#include <functional>
+/*  mutex
+    scoped_lock */
+#include <mutex>
+/*  optional */
+#include <optional>
+/*  basic_string_view */
+#include <string_view>
+/*  unordered_map */
+#include <unordered_map>
+/*  exchange
+    move */
+#include <utility>
+/*  vector */
+#include <vector>
+/*  ticker */
+#include <detail/wtr/watcher/stage/ticker.hpp>
+/*  wheel */
+#include <detail/wtr/watcher/stage/wheel.hpp>
+/*  event
+    callback */
+#include <wtr/watcher.hpp>
+
+namespace detail {
+namespace wtr {
+namespace watcher {
+namespace stage {
+
+/*  @brief wtr/watcher/<d>/stage/atomic_save
+    Folds the ways in which programs save a file "atomically"
+    into one `modify` event for the file which was saved.
+
+    Most programs save by writing a temporary file and then
+    renaming it over the target:
+
+      create  foo.tmp~
+      modify  foo.tmp~
+      rename  foo.tmp~
+      rename  foo        -> modify foo
+
+    Some (such as Vim, by default) move the target aside,
+    write a new one, and then remove the old one:
+
+      rename  foo
+      rename  foo~
+      create  foo
+      modify  foo
+      destroy foo~       -> modify foo
+
+    Whether a path is temporary is up to `is_temp`. Events on
+    temporary paths are held back. A rename is held back until
+    the next event, which is usually its other half.
+
+    Whatever has not turned into a save within `window` is let
+    go as it happened. So is everything, before the watcher's
+    last event. A temporary file which is created and then
+    destroyed within `window` is dropped, as is what happens
+    to a target just after it was saved (such as the `create`
+    some platforms report alongside the rename).
+
+    Kernels which merge the events for a name while they are
+    queued (fanotify) may leave nothing to recognize when the
+    steps of a save happen all at once. Those events are let
+    go as we see them. */
+class atomic_save {
+  using ev = ::wtr::watcher::event;
+  using clock = std::chrono::steady_clock;
+  using string_type = std::filesystem::path::string_type;
+
+public:
+  using predicate = std::function<bool(std::filesystem::path const&)>;
+
+private:
+  struct seen {
+    string_type where;
+    enum ev::what what;
+    enum ev::kind kind;
+    long long when;
+    enum ev::clock clock;
+    std::uint32_t root;
+  };
+
+  /*  A temporary file, and what happened to it (and, if it
+      is a backup, what happened to the file it was moved
+      away from). */
+  struct held {
+    std::vector<seen> events;
+    std::uint64_t at;
+    bool created{false};
+    std::optional<string_type> replaces{};
+    bool replaced{false};
+  };
+
+  struct moving {
+    seen from;
+    std::uint64_t at;
+  };
+
+  std::mutex lk{};
+  ev::callback const callback;
+  predicate const is_temp;
+  clock::time_point const epoch{clock::now()};
+  clock::duration const resolution;
+  std::uint64_t const window_ticks;
+  /*  Temporary paths in flight. */
+  std::unordered_map<string_type, held> temps{};
+  /*  Targets which were moved aside, to their backup. */
+  std::unordered_map<string_type, string_type> backups{};
+  /*  Targets which were just saved, until when. */
+  std::unordered_map<string_type, std::uint64_t> saved{};
+  /*  The first half of a rename. */
+  std::optional<moving> move{};
+  /*  The temporary path we saw last, if it was the last
+      thing we saw. */
+  std::optional<string_type> last_temp{};
+  wheel<string_type> deadlines{};
+  /* Declared last, so that it is stopped first. */
+  ticker tick;
+
+  auto ticks(clock::time_point t) const noexcept -> std::uint64_t
+  {
+    return static_cast<std::uint64_t>((t - this->epoch) / this->resolution);
+  }
+
+  auto deadline() noexcept -> std::uint64_t
+  {
+    return this->ticks(clock::now()) + this->window_ticks;
+  }
+
+  auto send(seen const& s) noexcept -> void
+  {
+    this->callback({s.where, s.what, s.kind, s.when, s.clock, s.root});
+  }
+
+  auto send_saved(string_type const& p,
+                  enum ev::kind kind,
+                  long long when,
+                  enum ev::clock clock,
+                  std::uint32_t root) noexcept -> void
+  {
+    auto const at = this->deadline();
+    this->saved.insert_or_assign(p, at);
+    this->deadlines.schedule(at, p);
+    this->callback({p, ev::what::modify, kind, when, clock, root});
+  }
+
+  /*  Ends the life of a temporary path. If it was a backup
+      for a target which came back, the target was saved.
+      Otherwise, what happened is let go as it happened. */
+  auto let_go(std::unordered_map<string_type, held>::iterator h) noexcept
+    -> void
+  {
+    auto& t = h->second;
+    if (t.replaces.has_value()) this->backups.erase(t.replaces.value());
+    if (t.replaces.has_value() && t.replaced)
+      this->send_saved(t.replaces.value(),
+                       t.events.front().kind,
+                       t.events.back().when,
+                       t.events.back().clock,
+                       t.events.back().root);
+    else
+      for (auto const& s : t.events) this->send(s);
+    this->temps.erase(h);
+  }
+
+  auto let_go_move() noexcept -> void
+  {
+    if (this->move.has_value()) {
+      auto m = std::move(this->move.value());
+      this->move.reset();
+      auto h = this->temps.find(m.from.where);
+      if (h != this->temps.end()) {
+        h->second.events.push_back(std::move(m.from));
+        this->let_go(h);
+      }
+      else
+        this->send(m.from);
+    }
+  }
+
+  auto let_go_until(std::uint64_t to) noexcept -> void
+  {
+    this->deadlines.advance(
+      to,
+      [this](std::uint64_t at, string_type&& p)
+      {
+        if (this->move.has_value() && this->move->at == at
+            && this->move->from.where == p)
+          this->let_go_move();
+        if (auto h = this->temps.find(p);
+            h != this->temps.end() && h->second.at == at)
+          this->let_go(h);
+        if (auto s = this->saved.find(p);
+            s != this->saved.end() && s->second == at)
+          this->saved.erase(s);
+      });
+  }
+
+  auto let_go_all() noexcept -> void
+  {
+    this->let_go_move();
+    while (! this->temps.empty()) this->let_go(this->temps.begin());
+    this->saved.clear();
+  }
+
+  /*  Both halves of a rename, from `from` to `to`. */
+  auto renamed(seen&& from, ev const& to) noexcept -> void
+  {
+    auto const& p = to.where.native();
+
+    /* A temporary file became the target. */
+    if (auto h = this->temps.find(from.where); h != this->temps.end()) {
+      if (h->second.replaces.has_value())
+        this->backups.erase(h->second.replaces.value());
+      this->temps.erase(h);
+      this->send_saved(p, to.kind, to.when, to.clock, to.root);
+    }
+    else if (this->is_temp(from.where))
+      this->send_saved(p, to.kind, to.when, to.clock, to.root);
+
+    /* The target was moved aside, to a backup. */
+    else if (this->is_temp(to.where) && ! this->backups.contains(from.where)) {
+      auto const at = this->deadline();
+      auto t = held{
+        {std::move(from), {p, to.what, to.kind, to.when, to.clock, to.root}},
+        at};
+      t.replaces = t.events.front().where;
+      /* Something else was moved here before. Whatever it
+         was, it isn't coming back as a save. */
+      if (auto h = this->temps.find(p); h != this->temps.end())
+        this->let_go(h);
+      this->backups.insert_or_assign(t.events.front().where, p);
+      this->temps.emplace(p, std::move(t));
+      this->deadlines.schedule(at, p);
+    }
+
+    else {
+      this->send(from);
+      this->callback(to);
+    }
+  }
+
+public:
+  atomic_save(ev::callback const& callback,
+              std::chrono::milliseconds const& window,
+              predicate const& is_temp) noexcept
+      : callback{callback},
+        is_temp{is_temp},
+        resolution{std::max<clock::duration>(window / 8,
+                                             std::chrono::milliseconds(1))},
+        window_ticks{static_cast<std::uint64_t>(
+          (window + resolution - clock::duration{1}) / resolution)},
+        tick{std::chrono::duration_cast<std::chrono::milliseconds>(
+               resolution),
+             [this]
+             {
+               auto _ = std::scoped_lock{this->lk};
+               this->let_go_until(this->ticks(clock::now()));
+             }}
+  {}
+
+  /*  Names which editors, downloaders, version control and
+      configuration management tools commonly write to
+      before renaming into place. */
+  static auto looks_temporary(std::filesystem::path const& p) noexcept -> bool
+  {
+    using view_type =
+      std::basic_string_view<std::filesystem::path::value_type>;
+    auto const& s = p.native();
+    auto const sep = s.rfind(std::filesystem::path::preferred_separator);
+    auto const name =
+      view_type{s}.substr(sep == string_type::npos ? 0 : sep + 1);
+    auto const is = [name](char const* ascii) noexcept -> bool
+    {
+      auto i = std::size_t{0};
+      for (; ascii[i] != 0; ++i)
+        if (i >= name.size() || name[i] != ascii[i]) return false;
+      return i == name.size();
+    };
+    auto const starts = [name](char const* ascii) noexcept -> bool
+    {
+      for (auto i = std::size_t{0}; ascii[i] != 0; ++i)
+        if (i >= name.size() || name[i] != ascii[i]) return false;
+      return true;
+    };
+    auto const ends = [name](char const* ascii) noexcept -> bool
+    {
+      auto n = std::char_traits<char>::length(ascii);
+      if (n > name.size()) return false;
+      for (auto i = std::size_t{0}; i < n; ++i)
+        if (name[name.size() - n + i] != ascii[i]) return false;
+      return true;
+    };
+    auto const has = [name](char const* ascii) noexcept -> bool
+    {
+      auto n = std::char_traits<char>::length(ascii);
+      for (auto at = std::size_t{0}; at + n <= name.size(); ++at) {
+        auto i = std::size_t{0};
+        while (i < n && name[at + i] == ascii[i]) ++i;
+        if (i == n) return true;
+      }
+      return false;
+    };
+    return ends("~") || ends(".swp") || ends(".swx") || ends(".tmp")
+        || ends(".temp") || ends(".part") || has(".tmp.")
+        || starts(".#") || starts(".~") || starts(".goutputstream-")
+        || starts("tmp_obj_") || is("4913");
+  }
+
+  auto operator()(ev const& e) noexcept -> void
+  {
+    auto _ = std::scoped_lock{this->lk};
+
+    if (e.kind == ev::kind::watcher) {
+      if (e.what == ev::what::destroy) this->let_go_all();
+      return this->callback(e);
+    }
+
+    auto const& p = e.where.native();
+    auto after = std::exchange(this->last_temp, std::nullopt);
+
+    if (this->move.has_value()) {
+      if (e.what == ev::what::rename && this->move->from.where != p) {
+        auto from = std::move(this->move->from);
+        this->move.reset();
+        return this->renamed(std::move(from), e);
+      }
+      this->let_go_move();
+    }
+
+    /* Echoes of a save, such as the target's `create`. */
+    if (auto s = this->saved.find(p); s != this->saved.end()) {
+      if (e.what == ev::what::create || e.what == ev::what::modify) return;
+      this->saved.erase(s);
+    }
+
+    /* The target of a backup came back. */
+    if (auto b = this->backups.find(p); b != this->backups.end()) {
+      auto h = this->temps.find(b->second);
+      if (h == this->temps.end())
+        this->backups.erase(b);
+      else if (e.what == ev::what::create || e.what == ev::what::modify) {
+        h->second.replaced = true;
+        return;
+      }
+      else
+        this->let_go(h);
+    }
+
+    /* Some kernels merge the first half of a rename into the
+       temporary path's `create`. A rename which comes right
+       after a temporary path (and isn't of that path) is the
+       second half. */
+    if (e.what == ev::what::rename && after.has_value() && after != p) {
+      auto h = this->temps.find(after.value());
+      if (h != this->temps.end() && ! h->second.replaces.has_value()) {
+        this->temps.erase(h);
+        return this->send_saved(p, e.kind, e.when, e.clock, e.root);
+      }
+    }
+
+    if (e.what == ev::what::rename) {
+      auto const at = this->deadline();
+      this->move = moving{{p, e.what, e.kind, e.when, e.clock, e.root}, at};
+      return this->deadlines.schedule(at, p);
+    }
+
+    auto h = this->temps.find(p);
+    if (h == this->temps.end()) {
+      if (e.what == ev::what::destroy || ! this->is_temp(e.where))
+        return this->callback(e);
+      auto const at = this->deadline();
+      h = this->temps.emplace(p, held{{}, at}).first;
+      this->deadlines.schedule(at, p);
+    }
+
+    auto& t = h->second;
+
+    if (e.what == ev::what::destroy) {
+      if (t.replaces.has_value() || ! t.created) {
+        t.events.push_back({p, e.what, e.kind, e.when, e.clock, e.root});
+        this->let_go(h);
+      }
+      else
+        this->temps.erase(h);
+      return;
+    }
+
+    this->last_temp = p;
+    if (e.what == ev::what::create) t.created = true;
+    if (t.events.empty() || t.events.back().what != e.what
+        || t.events.back().kind != e.kind)
+      t.events.push_back({p, e.what, e.kind, e.when, e.clock, e.root});
+  }
+};
+
+} /* namespace stage */
+} /* namespace watcher */
+} /* namespace wtr */
+} /* namespace detail */
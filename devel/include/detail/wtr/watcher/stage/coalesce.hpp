@@ -0,0 +1,189 @@
+#pragma once
+
+/*  max */
+#include <algorithm>
+/*  milliseconds
+    steady_clock */
+#include <chrono>
+/*  uint32_t
+    uint64_t */
+#include <cstdint>
+/*  path */
+#include <filesystem>
+/*  mutex
+    scoped_lock */
+#include <mutex>
+/*  optional */
+#include <optional>
+/*  unordered_map */
+#include <unordered_map>
+/*  ticker */
+#include <detail/wtr/watcher/stage/ticker.hpp>
+/*  wheel */
+#include <detail/wtr/watcher/stage/wheel.hpp>
+/*  event
+    callback */
+#include <wtr/watcher.hpp>
+
+namespace detail {
+namespace wtr {
+namespace watcher {
+namespace stage {
+
+/*  @brief wtr/watcher/<d>/stage/coalesce
+    Merges the events for a path which happen within
+    `window` of the first one into (at most) one event.
+
+    The merged event is sent `window` after the first
+    event for its path, with the first event's time.
+
+      create  + modify  -> create
+      create  + destroy -> (nothing)
+      modify  + modify  -> modify
+      modify  + destroy -> destroy
+      destroy + create  -> modify
+
+    Anything else (a rename, a change of kind, or something
+    from the watcher) lets the held event go first and then
+    passes through. Nothing is held past the watcher's last
+    event.
+
+    Deadlines are kept on a timing wheel, ticking every
+    `window / 8`. Merging and scheduling are constant time. */
+class coalesce {
+  using ev = ::wtr::watcher::event;
+  using clock = std::chrono::steady_clock;
+  using string_type = std::filesystem::path::string_type;
+
+  struct held {
+    enum ev::what what;
+    enum ev::kind kind;
+    long long when;
+    enum ev::clock clock;
+    std::uint32_t root;
+    std::uint64_t at;
+  };
+
+  std::mutex lk{};
+  ev::callback const callback;
+  clock::time_point const epoch{clock::now()};
+  clock::duration const resolution;
+  std::uint64_t const window_ticks;
+  std::unordered_map<string_type, held> pending{};
+  wheel<string_type> deadlines{};
+  /* Declared last, so that it is stopped first. */
+  ticker tick;
+
+  static auto merge(enum ev::what before, enum ev::what after) noexcept
+    -> std::optional<enum ev::what>
+  {
+    using w = enum ev::what;
+    /* clang-format off */
+    if      (before == w::create  && after == w::destroy) return std::nullopt;
+    else if (before == w::create  && after == w::modify)  return w::create;
+    else if (before == w::modify  && after == w::destroy) return w::destroy;
+    else if (before == w::destroy && after == w::create)  return w::modify;
+    else if (before == after)                             return before;
+    else                                                  return after;
+    /* clang-format on */
+  }
+
+  static auto mergeable(enum ev::what w) noexcept -> bool
+  {
+    return w == ev::what::create || w == ev::what::modify
+        || w == ev::what::destroy;
+  }
+
+  auto ticks(clock::time_point t) const noexcept -> std::uint64_t
+  {
+    return static_cast<std::uint64_t>((t - this->epoch) / this->resolution);
+  }
+
+  auto let_go(string_type const& p, held const& h) noexcept -> void
+  {
+    this->callback({p, h.what, h.kind, h.when, h.clock, h.root});
+  }
+
+  /*  Sends what has expired. Anything we see from the wheel
+      which we don't hold (anymore), or which was scheduled
+      for a different tick, was already let go. */
+  auto let_go_until(std::uint64_t to) noexcept -> void
+  {
+    this->deadlines.advance(
+      to,
+      [this](std::uint64_t at, string_type&& p)
+      {
+        auto h = this->pending.find(p);
+        if (h != this->pending.end() && h->second.at == at) {
+          this->let_go(h->first, h->second);
+          this->pending.erase(h);
+        }
+      });
+  }
+
+  auto let_go_all() noexcept -> void
+  {
+    this->let_go_until(this->ticks(clock::now()) + this->window_ticks + 1);
+  }
+
+public:
+  coalesce(ev::callback const& callback,
+           std::chrono::milliseconds const& window) noexcept
+      : callback{callback},
+        resolution{std::max<clock::duration>(window / 8,
+                                             std::chrono::milliseconds(1))},
+        window_ticks{static_cast<std::uint64_t>(
+          (window + resolution - clock::duration{1}) / resolution)},
+        tick{std::chrono::duration_cast<std::chrono::milliseconds>(
+               resolution),
+             [this]
+             {
+               auto _ = std::scoped_lock{this->lk};
+               this->let_go_until(this->ticks(clock::now()));
+             }}
+  {}
+
+  auto operator()(ev const& e) noexcept -> void
+  {
+    auto _ = std::scoped_lock{this->lk};
+
+    if (e.kind == ev::kind::watcher) {
+      if (e.what == ev::what::destroy) this->let_go_all();
+      return this->callback(e);
+    }
+
+    auto const& p = e.where.native();
+    auto h = this->pending.find(p);
+
+    if (h != this->pending.end()) {
+      if (mergeable(e.what) && h->second.kind == e.kind) {
+        auto merged = merge(h->second.what, e.what);
+        if (merged.has_value())
+          h->second.what = merged.value();
+        else
+          this->pending.erase(h);
+        return;
+      }
+      else {
+        this->let_go(h->first, h->second);
+        this->pending.erase(h);
+      }
+    }
+
+    if (mergeable(e.what)) {
+      auto const at = this->ticks(clock::now()) + this->window_ticks;
+      this->pending.emplace(
+        p,
+        held{e.what, e.kind, e.when, e.clock, e.root, at});
+      this->deadlines.schedule(at, p);
+    }
+
+    else
+      this->callback(e);
+  }
+};
+
+} /* namespace stage */
+} /* namespace watcher */
+} /* namespace wtr */
+} /* namespace detail */
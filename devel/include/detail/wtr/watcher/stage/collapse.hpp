@@ -0,0 +1,212 @@
+#pragma once
+
+/*  max,
+    min */
+#include <algorithm>
+/*  milliseconds
+    steady_clock */
+#include <chrono>
+/*  uint32_t */
+#include <cstdint>
+/*  path */
+#include <filesystem>
+/*  less */
+#include <functional>
+/*  map */
+#include <map>
+/*  mutex
+    scoped_lock */
+#include <mutex>
+/*  basic_string_view */
+#include <string_view>
+/*  ticker */
+#include <detail/wtr/watcher/stage/ticker.hpp>
+/*  event
+    callback */
+#include <wtr/watcher.hpp>
+
+namespace detail {
+namespace wtr {
+namespace watcher {
+namespace stage {
+
+/*  @brief wtr/watcher/<d>/stage/collapse
+    Folds the events in a destroyed, or newly created,
+    subtree into a single event for the subtree's root.
+
+    Destruction is reported from the leaves up, so we
+    hold `destroy` events back. When a directory is
+    destroyed, the (held) events beneath it are dropped
+    and the directory takes their place.
+
+    Creation is reported from the root down, so the
+    first directory we see created becomes a root, and
+    what is created beneath it is dropped. Anything else
+    which happens beneath it, such as a file being
+    written, is passed through.
+
+    Roots are let go when nothing has been folded into
+    them for `window`, when something other than what we
+    fold happens to them, or when the watcher dies. They
+    are never held for more than `window * longest` after
+    they were first seen, however busy their tree is.
+
+    Other events are passed through as they arrive, so
+    they may be seen before a (held) root. */
+class collapse {
+  using ev = ::wtr::watcher::event;
+  using clock = std::chrono::steady_clock;
+  using string_type = std::filesystem::path::string_type;
+  using view_type =
+    std::basic_string_view<std::filesystem::path::value_type>;
+
+  static constexpr auto sep = std::filesystem::path::preferred_separator;
+
+  struct root {
+    enum ev::kind kind;
+    long long when;
+    enum ev::clock clock;
+    std::uint32_t root_of;
+    clock::time_point deadline;
+    /* The latest `deadline` may be. */
+    clock::time_point until;
+
+    /* Holds on, for as long as we may, after what was
+       just folded into us. */
+    auto hold(clock::time_point deadline) noexcept -> void
+    {
+      this->deadline = std::min(deadline, this->until);
+    }
+  };
+
+  /* How many windows a root may be held for, at most. */
+  static constexpr auto longest = 4;
+
+  using root_map = std::map<string_type, root, std::less<>>;
+
+  std::mutex lk{};
+  ev::callback const callback;
+  std::chrono::milliseconds const window;
+  root_map destroyed{};
+  root_map created{};
+  /* Declared last, so that it is stopped first. */
+  ticker tick;
+
+  /*  The root at, or above, `p`. */
+  static auto covering(root_map& m, view_type p) noexcept
+    -> root_map::iterator
+  {
+    if (! m.empty())
+      for (auto n = p.size(); n > 0 && n != view_type::npos;
+           n = p.rfind(sep, n - 1))
+        if (auto at = m.find(p.substr(0, n)); at != m.end()) return at;
+    return m.end();
+  }
+
+  /*  Drops the roots strictly beneath `p`. */
+  static auto absorb(root_map& m, view_type p) noexcept -> void
+  {
+    auto beneath = string_type{p} + sep;
+    auto at = m.lower_bound(beneath);
+    while (at != m.end() && view_type{at->first}.starts_with(beneath))
+      at = m.erase(at);
+  }
+
+  auto let_go(root_map& m, root_map::iterator at, enum ev::what what) noexcept
+    -> void
+  {
+    if (at != m.end()) {
+      auto const& r = at->second;
+      this->callback({at->first, what, r.kind, r.when, r.clock, r.root_of});
+      m.erase(at);
+    }
+  }
+
+  auto let_go_all(clock::time_point until) noexcept -> void
+  {
+    for (auto at = this->created.begin(); at != this->created.end();)
+      if (at->second.deadline <= until)
+        this->let_go(this->created, at++, ev::what::create);
+      else
+        ++at;
+    for (auto at = this->destroyed.begin(); at != this->destroyed.end();)
+      if (at->second.deadline <= until)
+        this->let_go(this->destroyed, at++, ev::what::destroy);
+      else
+        ++at;
+  }
+
+public:
+  collapse(ev::callback const& callback,
+           std::chrono::milliseconds const& window) noexcept
+      : callback{callback},
+        window{window},
+        tick{std::max(window / 4, std::chrono::milliseconds(1)),
+             [this]
+             {
+               auto _ = std::scoped_lock{this->lk};
+               this->let_go_all(clock::now());
+             }}
+  {}
+
+  auto operator()(ev const& e) noexcept -> void
+  {
+    auto _ = std::scoped_lock{this->lk};
+
+    /* The last event is always from the watcher, and
+       it is always a `destroy` event. Nothing is held
+       past then. */
+    if (e.kind == ev::kind::watcher) {
+      if (e.what == ev::what::destroy)
+        this->let_go_all(clock::time_point::max());
+      return this->callback(e);
+    }
+
+    auto const p = view_type{e.where.native()};
+    auto const now = clock::now();
+    auto const deadline = now + this->window;
+    auto const until = now + this->window * longest;
+
+    /* What is created strictly beneath a new root is part
+       of it. */
+    auto c = covering(this->created, p);
+    if (c != this->created.end()) {
+      if (c->first.size() == p.size())
+        this->let_go(this->created, c, ev::what::create);
+      else if (e.what == ev::what::create)
+        return c->second.hold(deadline);
+    }
+
+    auto d = covering(this->destroyed, p);
+
+    if (e.what == ev::what::destroy) {
+      if (d != this->destroyed.end()) return d->second.hold(deadline);
+      absorb(this->destroyed, p);
+      this->destroyed.insert_or_assign(
+        string_type{p},
+        root{e.kind, e.when, e.clock, e.root, deadline, until});
+      return;
+    }
+
+    /* Some kernels tell us about a destroyed directory
+       twice: once from its parent and once from itself. */
+    if (e.what == ev::what::other && d != this->destroyed.end()) return;
+
+    /* Something came back. It happened after the root
+       was destroyed, so the root must be seen first. */
+    this->let_go(this->destroyed, d, ev::what::destroy);
+
+    if (e.what == ev::what::create && e.kind == ev::kind::dir)
+      this->created.emplace(
+        string_type{p},
+        root{e.kind, e.when, e.clock, e.root, deadline, until});
+
+    else
+      this->callback(e);
+  }
+};
+
+} /* namespace stage */
+} /* namespace watcher */
+} /* namespace wtr */
+} /* namespace detail */
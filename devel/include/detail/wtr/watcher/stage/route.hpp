@@ -0,0 +1,208 @@
+#pragma once
+
+/*  size_t */
+#include <cstddef>
+/*  uint32_t,
+    uint64_t */
+#include <cstdint>
+/*  path */
+#include <filesystem>
+/*  function,
+    less */
+#include <functional>
+/*  map */
+#include <map>
+/*  unique_ptr,
+    make_unique */
+#include <memory>
+/*  basic_string_view */
+#include <string_view>
+/*  unordered_map */
+#include <unordered_map>
+/*  move */
+#include <utility>
+/*  vector */
+#include <vector>
+/*  event */
+#include <wtr/watcher.hpp>
+
+namespace detail {
+namespace wtr {
+namespace watcher {
+namespace stage {
+
+/*  @brief wtr/watcher/<d>/stage/route
+    Sends each event to those who subscribed to a path it
+    happened beneath (or to the path itself), if they asked
+    for what happened and the kind of path it happened to.
+
+    Subscriptions are kept in a tree, one level for each
+    component of their paths. An event walks down it along
+    its own path, and is sent to who is at each level it
+    passes. How long that takes depends on how deep the
+    path is, and on how many it is sent to, but not on how
+    many have subscribed.
+
+    Messages from the watcher aren't beneath any path. They
+    are sent to everyone who asked for `kind::watcher`.
+
+    Paths are matched as they are, component by component:
+    they should be written the same way as the watcher's.
+
+    This isn't locked. Whoever has one does that. */
+class route {
+public:
+  using callback_type = ::wtr::watcher::event::compact::callback;
+
+  /*  What happened, and to which kinds of path, someone
+      wants to hear about. Everything, unless they say. */
+  struct mask {
+    std::uint32_t whats{~0u};
+    std::uint32_t kinds{~0u};
+
+    static auto of(std::vector<enum ::wtr::watcher::event::what> const& whats,
+                   std::vector<enum ::wtr::watcher::event::kind> const& kinds)
+      noexcept -> mask
+    {
+      auto m = mask{whats.empty() ? ~0u : 0u, kinds.empty() ? ~0u : 0u};
+      for (auto const w : whats) m.whats |= 1u << (unsigned)w;
+      for (auto const k : kinds) m.kinds |= 1u << (unsigned)k;
+      return m;
+    }
+
+    auto has(enum ::wtr::watcher::event::what w,
+             enum ::wtr::watcher::event::kind k) const noexcept -> bool
+    {
+      return (this->whats & 1u << (unsigned)w)
+          && (this->kinds & 1u << (unsigned)k);
+    }
+  };
+
+private:
+  using ev = ::wtr::watcher::event;
+  using string_type = std::filesystem::path::string_type;
+  using view_type =
+    std::basic_string_view<std::filesystem::path::value_type>;
+
+  static constexpr auto sep = std::filesystem::path::preferred_separator;
+
+  struct entry {
+    std::uint64_t id{};
+    mask wants{};
+    callback_type callback{};
+  };
+
+  struct node {
+    std::map<string_type, std::unique_ptr<node>, std::less<>> children{};
+    std::vector<entry> here{};
+    node* parent{};
+    string_type name{};
+  };
+
+  node top{};
+  std::unordered_map<std::uint64_t, node*> nodes{};
+  std::uint64_t last_id{0};
+
+  /*  Calls `fn` with each component of `path`, from the
+      top: the root directory, if it has one, and then each
+      name. Stops, and says false, when `fn` does. */
+  template<class Fn>
+  static auto each_part(view_type path, Fn const& fn) noexcept -> bool
+  {
+    if (path.starts_with(sep) && ! fn(path.substr(0, 1))) return false;
+    while (! path.empty()) {
+      auto const end = path.find(sep);
+      auto const part = path.substr(0, end);
+      if (! part.empty() && ! fn(part)) return false;
+      if (end == view_type::npos) break;
+      path.remove_prefix(end + 1);
+    }
+    return true;
+  }
+
+  /*  Sends `e` to everyone at `at`, and beneath it. */
+  static auto send_all(node const& at, ev::compact const& e) noexcept -> void
+  {
+    for (auto const& s : at.here)
+      if (s.wants.has(e.what, e.kind)) s.callback(e);
+    for (auto const& [_, child] : at.children) send_all(*child, e);
+  }
+
+public:
+  route() noexcept = default;
+  route(route const&) = delete;
+  route& operator=(route const&) = delete;
+
+  /*  Subscribes `callback` to what happens beneath `path`,
+      which `wants` has. Gives back what the subscription
+      is known by, to `remove` it with. */
+  auto add(view_type path,
+           callback_type callback,
+           mask wants = {~0u, ~0u}) noexcept
+    -> std::uint64_t
+  {
+    auto* at = &this->top;
+    each_part(path,
+              [&](view_type part) noexcept
+              {
+                auto found = at->children.find(part);
+                if (found == at->children.end())
+                  found = at->children
+                            .emplace(string_type{part},
+                                     std::make_unique<node>(
+                                       node{{}, {}, at, string_type{part}}))
+                            .first;
+                at = found->second.get();
+                return true;
+              });
+    auto const id = ++this->last_id;
+    at->here.push_back({id, wants, std::move(callback)});
+    this->nodes[id] = at;
+    return id;
+  }
+
+  /*  Removes the subscription known by `id`, and whatever
+      part of the tree only it needed. Says false if there
+      was no such subscription. */
+  auto remove(std::uint64_t id) noexcept -> bool
+  {
+    auto const found = this->nodes.find(id);
+    if (found == this->nodes.end()) return false;
+    auto* at = found->second;
+    this->nodes.erase(found);
+    std::erase_if(at->here, [id](auto const& s) { return s.id == id; });
+    while (at->parent && at->here.empty() && at->children.empty()) {
+      auto* const parent = at->parent;
+      auto const name = at->name;
+      parent->children.erase(name);
+      at = parent;
+    }
+    return true;
+  }
+
+  /*  How many have subscribed. */
+  auto size() const noexcept -> std::size_t { return this->nodes.size(); }
+
+  auto operator()(ev::compact const& e) const noexcept -> void
+  {
+    if (e.kind == ev::kind::watcher) return send_all(this->top, e);
+    auto const* at = &this->top;
+    for (auto const& s : at->here)
+      if (s.wants.has(e.what, e.kind)) s.callback(e);
+    each_part(e.where,
+              [&](view_type part) noexcept
+              {
+                auto const found = at->children.find(part);
+                if (found == at->children.end()) return false;
+                at = found->second.get();
+                for (auto const& s : at->here)
+                  if (s.wants.has(e.what, e.kind)) s.callback(e);
+                return true;
+              });
+  }
+};
+
+} /* namespace stage */
+} /* namespace watcher */
+} /* namespace wtr */
+} /* namespace detail */
@@ -0,0 +1,70 @@
+#pragma once
+
+/*  milliseconds */
+#include <chrono>
+/*  condition_variable */
+#include <condition_variable>
+/*  function */
+#include <functional>
+/*  mutex
+    unique_lock */
+#include <mutex>
+/*  thread */
+#include <thread>
+
+namespace detail {
+namespace wtr {
+namespace watcher {
+namespace stage {
+
+/*  @brief wtr/watcher/<d>/stage/ticker
+    Calls `tick` every `period` on its own thread
+    until it is destroyed.
+
+    Stages hold events back for some time. The adapters
+    only call us when there are events, so something
+    else needs to let the held events go when it gets
+    quiet. That's this.
+
+    The thread is joined on destruction. The owner must
+    be sure that `tick` doesn't destroy the ticker. */
+class ticker {
+  std::mutex lk{};
+  std::condition_variable cv{};
+  bool stopped{false};
+  std::thread worker{};
+
+public:
+  ticker(std::chrono::milliseconds period, std::function<void()> tick) noexcept
+      : worker{[this, period, tick{std::move(tick)}]
+               {
+                 auto lock = std::unique_lock{this->lk};
+                 while (! this->cv.wait_for(lock,
+                                            period,
+                                            [this] { return this->stopped; }))
+                 {
+                   lock.unlock();
+                   tick();
+                   lock.lock();
+                 }
+               }}
+  {}
+
+  ticker(ticker const&) = delete;
+  ticker& operator=(ticker const&) = delete;
+
+  ~ticker() noexcept
+  {
+    {
+      auto _ = std::scoped_lock{this->lk};
+      this->stopped = true;
+    }
+    this->cv.notify_all();
+    if (this->worker.joinable()) this->worker.join();
+  }
+};
+
+} /* namespace stage */
+} /* namespace watcher */
+} /* namespace wtr */
+} /* namespace detail */
@@ -0,0 +1,127 @@
+#pragma once
+
+/*  array */
+#include <array>
+/*  size_t */
+#include <cstddef>
+/*  uint64_t */
+#include <cstdint>
+/*  move */
+#include <utility>
+/*  vector */
+#include <vector>
+
+namespace detail {
+namespace wtr {
+namespace watcher {
+namespace stage {
+
+/*  @brief wtr/watcher/<d>/stage/wheel
+    A hierarchical timing wheel.
+
+    Each level is a ring of `slot_count` slots. A slot on
+    level `n` spans `slot_count ^ n` ticks. Things which
+    expire soon are put on the lowest level. Things which
+    expire later are put higher up, and are moved down a
+    level (cascaded) whenever the level below comes around.
+
+    Scheduling is constant time. Advancing by a tick is
+    constant time, plus the time to expire or cascade what
+    is in that tick's slots. This holds up to (many)
+    millions of pending things, which a sorted container
+    or a list of timers would not.
+
+    There are `slot_count ^ level_count` ticks (about 16
+    million) within reach. Anything further out is put in
+    the furthest slot and rescheduled when it comes down. */
+template<class T>
+class wheel {
+  static constexpr unsigned level_bits = 6;
+  static constexpr unsigned level_count = 4;
+  static constexpr std::uint64_t slot_count = 1 << level_bits;
+  static constexpr std::uint64_t slot_mask = slot_count - 1;
+  static constexpr std::uint64_t reach = std::uint64_t{1}
+                                      << (level_bits * level_count);
+
+  struct entry {
+    std::uint64_t at;
+    T value;
+  };
+
+  using slot_type = std::vector<entry>;
+
+  std::array<std::array<slot_type, slot_count>, level_count> levels{};
+  std::uint64_t now{0};
+  std::size_t count{0};
+
+  auto place(entry&& e) noexcept -> void
+  {
+    auto const delta = e.at - this->now;
+    auto const at = delta < reach ? e.at : this->now + reach - 1;
+    auto level = 0u;
+    while (level + 1 < level_count
+           && delta >= (std::uint64_t{1} << (level_bits * (level + 1))))
+      ++level;
+    auto const slot = (at >> (level_bits * level)) & slot_mask;
+    this->levels[level][slot].emplace_back(std::move(e));
+  }
+
+  /*  Move everything in the current slot of `level` down. */
+  auto cascade(unsigned level) noexcept -> void
+  {
+    auto const slot = (this->now >> (level_bits * level)) & slot_mask;
+    auto moving = slot_type{};
+    moving.swap(this->levels[level][slot]);
+    for (auto& e : moving) this->place(std::move(e));
+  }
+
+public:
+  /*  The number of pending things. */
+  auto size() const noexcept -> std::size_t { return this->count; }
+
+  /*  The current tick. */
+  auto tick() const noexcept -> std::uint64_t { return this->now; }
+
+  /*  Schedule `value` to expire at tick `at`.
+      Ticks in the past expire on the next tick. */
+  auto schedule(std::uint64_t at, T value) noexcept -> void
+  {
+    this->place({at > this->now ? at : this->now + 1, std::move(value)});
+    ++this->count;
+  }
+
+  /*  Advance to tick `to`, calling `expire(at, value)`
+      for everything which expires on the way. Things
+      expire in the order of their ticks. */
+  template<class Fn>
+  auto advance(std::uint64_t to, Fn&& expire) noexcept -> void
+  {
+    while (this->now < to) {
+      if (this->count == 0) {
+        this->now = to;
+        return;
+      }
+
+      ++this->now;
+
+      auto highest = 0u;
+      while (highest + 1 < level_count
+             && (this->now & ((std::uint64_t{1}
+                               << (level_bits * (highest + 1)))
+                              - 1))
+                  == 0)
+        ++highest;
+      for (auto level = highest; level > 0; --level) this->cascade(level);
+
+      auto expiring = slot_type{};
+      expiring.swap(this->levels[0][this->now & slot_mask]);
+      this->count -= expiring.size();
+      for (auto& e : expiring) expire(e.at, std::move(e.value));
+    }
+  }
+};
+
+} /* namespace stage */
+} /* namespace watcher */
+} /* namespace wtr */
+} /* namespace detail */
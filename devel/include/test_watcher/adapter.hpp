@@ -0,0 +1,201 @@
+#pragma once
+
+/* atomic */
+#include <atomic>
+/* milliseconds,
+   steady_clock */
+#include <chrono>
+/* clock_gettime,
+   CLOCK_THREAD_CPUTIME_ID */
+#include <ctime>
+/* path,
+   directory_iterator,
+   read_symlink */
+#include <filesystem>
+/* string_view */
+#include <string_view>
+/* error_code */
+#include <system_error>
+/* thread,
+   this_thread::sleep_for */
+#include <thread>
+/* vector */
+#include <vector>
+/* event,
+   filter,
+   policy,
+   metrics,
+   sink,
+   inotify::watch,
+   fanotify::watch */
+#include <wtr/watcher.hpp>
+
+#if defined(WATER_WATCHER_ADAPTER_LINUX_FANOTIFY)
+/* geteuid */
+#include <unistd.h>
+#endif
+
+namespace wtr {
+namespace test_watcher {
+
+/* @brief
+     The adapters we can run here, by name. `fanotify` is
+     only here for root. */
+inline auto adapter_names() -> std::vector<std::string_view>
+{
+  auto names = std::vector<std::string_view>{};
+#if defined(WATER_WATCHER_ADAPTER_LINUX_INOTIFY)
+  names.push_back("inotify");
+#endif
+#if defined(WATER_WATCHER_ADAPTER_LINUX_FANOTIFY)
+  if (geteuid() == 0) names.push_back("fanotify");
+#endif
+#if defined(WATER_WATCHER_ADAPTER_WARTHOG)
+  names.push_back("warthog");
+#endif
+  return names;
+}
+
+/* @brief
+     The CPU time this thread has used, in nanoseconds, or
+     0 where we can't tell. */
+inline auto thread_cpu_ns() noexcept -> long long
+{
+#if defined(CLOCK_THREAD_CPUTIME_ID)
+  auto ts = timespec{};
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+  return ts.tv_sec * 1'000'000'000ll + ts.tv_nsec;
+#else
+  return 0;
+#endif
+}
+
+/* @brief
+     How many inotify or fanotify instances we have open. */
+inline auto kernel_instances() -> int
+{
+  auto n = 0;
+#if defined(__linux__)
+  namespace fs = ::std::filesystem;
+  auto ec = std::error_code{};
+  for (auto const& fd : fs::directory_iterator{"/proc/self/fd", ec}) {
+    auto const to = fs::read_symlink(fd.path(), ec).native();
+    if (to.find("inotify") != to.npos || to.find("fanotify") != to.npos) ++n;
+  }
+#endif
+  return n;
+}
+
+/* @brief
+     Runs the adapter called `name` on `path`, on a thread
+     of its own, without `watch`, so that we can measure one
+     adapter in particular. Events are counted in `counts`
+     and sent to `callback` as they would be from `watch`.
+     Messages from the watcher aren't sent.
+
+     The adapter is `ready` once it is watching something.
+     When it is `close`d, we have the CPU time its thread
+     used, callback included, in `cpu_ns`. */
+template<class Callback, class Policy = ::wtr::watcher::policy>
+class adapter_run {
+  std::atomic<bool> living{true};
+  std::atomic<long long> used_ns{0};
+  std::thread thread{};
+
+public:
+  ::wtr::watcher::metrics counts{};
+
+  adapter_run(std::string_view name,
+              std::filesystem::path const& path,
+              Callback const& callback)
+  {
+    this->thread = std::thread(
+      [this, name, path, callback]()
+      {
+        namespace adapter = ::detail::wtr::watcher::adapter;
+        using ::wtr::watcher::event;
+        auto const is_living = [this]() noexcept { return this->living.load(); };
+        auto const filter = ::wtr::watcher::filter{};
+        [[maybe_unused]] auto const each =
+          [&callback](event::compact const& e) noexcept
+        {
+          if (e.kind != event::kind::watcher) callback(e);
+        };
+#if defined(WATER_WATCHER_ADAPTER_LINUX_FANOTIFY) \
+  || defined(WATER_WATCHER_ADAPTER_LINUX_INOTIFY)
+        auto const sink = adapter::sink<decltype(each), Policy>{
+          .each = each,
+          .clock = Policy::clock,
+          .counts = &this->counts};
+#endif
+#if defined(WATER_WATCHER_ADAPTER_LINUX_INOTIFY)
+        if (name == "inotify")
+          adapter::inotify::watch({path}, filter, sink, is_living);
+#endif
+#if defined(WATER_WATCHER_ADAPTER_LINUX_FANOTIFY)
+        if (name == "fanotify")
+          adapter::fanotify::watch({path}, filter, sink, is_living);
+#endif
+#if defined(WATER_WATCHER_ADAPTER_WARTHOG)
+        if (name == "warthog")
+          adapter::watch<Policy>(
+            path,
+            filter,
+            [this, &each](event const& e) noexcept
+            {
+              if (e.kind != event::kind::watcher)
+                this->counts.sent([&]() noexcept { each(event::compact{e}); });
+            },
+            is_living,
+            &this->counts);
+#endif
+        this->used_ns = thread_cpu_ns();
+      });
+  }
+
+  adapter_run(adapter_run const&) = delete;
+  adapter_run& operator=(adapter_run const&) = delete;
+
+  ~adapter_run() { this->close(); }
+
+  /* Waits up to `for_at_most` for the adapter to watch
+     something. */
+  auto ready(std::chrono::milliseconds for_at_most =
+               std::chrono::milliseconds(10'000)) const -> bool
+  {
+    auto const until = std::chrono::steady_clock::now() + for_at_most;
+    while (this->counts.marks.load() == 0) {
+      if (std::chrono::steady_clock::now() > until) return false;
+      std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+    return true;
+  }
+
+  /* Waits for events to stop coming, for `quiet_for`, or
+     until `for_at_most` has passed. */
+  auto settle(std::chrono::milliseconds quiet_for =
+                std::chrono::milliseconds(200),
+              std::chrono::milliseconds for_at_most =
+                std::chrono::milliseconds(5'000)) const -> void
+  {
+    auto const until = std::chrono::steady_clock::now() + for_at_most;
+    auto seen = this->counts.events.load();
+    while (std::chrono::steady_clock::now() < until) {
+      std::this_thread::sleep_for(quiet_for);
+      auto const now_seen = this->counts.events.load();
+      if (now_seen == seen) return;
+      seen = now_seen;
+    }
+  }
+
+  auto close() -> void
+  {
+    this->living = false;
+    if (this->thread.joinable()) this->thread.join();
+  }
+
+  auto cpu_ns() const -> long long { return this->used_ns.load(); }
+};
+
+} /* namespace test_watcher */
+} /* namespace wtr */
@@ -38,7 +38,9 @@ inline bool str_eq(char const* a, char const* b)
 /* Make Events
    Mirror what the Watcher should see
    Half are creation events
-   Half are destruction */
+   Half are destruction
+   One at a time, in order, for the tests which compare
+   what was seen in order. For load, see `stress`. */
 auto mk_events(std::filesystem::path const& base_path,
                auto const& path_count,
                std::vector<wtr::watcher::event>* event_list,
@@ -66,20 +68,12 @@ auto mk_events(std::filesystem::path const& base_path,
       auto ev = event{path, event::what::create, event::kind::file};
       event_list->push_back(ev);
       std::ofstream{path}; /* NOLINT */
-      auto has = false;
-      for (auto& i : *event_list)
-        if (i == ev) has = true;
-      if (! has) assert(has);
       assert(std::filesystem::exists(path));
     }
     else {
       auto ev = event{path, event::what::destroy, event::kind::file};
       event_list->push_back(ev);
       std::filesystem::remove(path);
-      auto has = false;
-      for (auto& i : *event_list)
-        if (i == ev) has = true;
-      if (! has) assert(has);
       assert(! std::filesystem::exists(path));
     }
   }
@@ -89,10 +83,6 @@ auto mk_events(std::filesystem::path const& base_path,
                     event::what::destroy,
                     event::kind::watcher};
     event_list->push_back(ev);
-    auto has = false;
-    for (auto& i : *event_list)
-      if (i == ev) has = true;
-    if (! has) assert(has);
   }
 }
 
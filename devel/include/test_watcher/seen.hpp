@@ -0,0 +1,74 @@
+#pragma once
+
+/* milliseconds,
+   steady_clock */
+#include <chrono>
+/* uint32_t */
+#include <cstdint>
+/* path */
+#include <filesystem>
+/* mutex,
+   scoped_lock */
+#include <mutex>
+/* string */
+#include <string>
+/* sleep_for */
+#include <thread>
+/* unordered_map */
+#include <unordered_map>
+/* vector */
+#include <vector>
+/* event */
+#include <wtr/watcher.hpp>
+
+namespace wtr {
+namespace test_watcher {
+
+/* What a callback was sent: each path, in order, and which
+   roots each was seen from. */
+struct seen_type {
+  std::mutex lk{};
+  std::vector<std::string> paths{};
+  std::unordered_map<std::string, std::vector<std::uint32_t>> roots{};
+
+  auto callback()
+  {
+    return [this](::wtr::watcher::event::compact const& e)
+    {
+      auto _ = std::scoped_lock{this->lk};
+      this->paths.emplace_back(e.where);
+      this->roots[this->paths.back()].push_back(e.root);
+    };
+  }
+
+  auto has(std::filesystem::path const& p)
+  {
+    auto _ = std::scoped_lock{this->lk};
+    return this->roots.contains(p.native());
+  }
+
+  auto of(std::filesystem::path const& p)
+  {
+    auto _ = std::scoped_lock{this->lk};
+    return this->roots[p.native()];
+  }
+
+  auto count()
+  {
+    auto _ = std::scoped_lock{this->lk};
+    return this->paths.size();
+  }
+};
+
+/* Waits, a while, for `p` to be seen. */
+inline auto wait_for(seen_type& seen, std::filesystem::path const& p) -> bool
+{
+  auto const until =
+    std::chrono::steady_clock::now() + std::chrono::milliseconds(5'000);
+  while (! seen.has(p) && std::chrono::steady_clock::now() < until)
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  return seen.has(p);
+}
+
+} /* namespace test_watcher */
+} /* namespace wtr */
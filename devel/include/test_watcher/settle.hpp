@@ -0,0 +1,36 @@
+#pragma once
+
+/* milliseconds */
+#include <chrono>
+/* path,
+   create_directories */
+#include <filesystem>
+/* ofstream */
+#include <fstream>
+/* sleep_for */
+#include <thread>
+
+namespace wtr {
+namespace test_watcher {
+
+/* Makes `dir`, and whatever is above it, with a file in it.
+   The polling adapter takes what it first sees in an empty
+   directory as what was already there, so it would miss
+   the first things we do in one. */
+inline auto seeded(std::filesystem::path const& dir) -> std::filesystem::path
+{
+  std::filesystem::create_directories(dir);
+  std::ofstream{dir / "0.txt"};
+  return dir;
+}
+
+/* Long enough for a watcher which was just opened to be
+   watching, or for one to take what was just changed. */
+inline auto settle(
+  std::chrono::milliseconds for_ms = std::chrono::milliseconds(100)) -> void
+{
+  std::this_thread::sleep_for(for_ms);
+}
+
+} /* namespace test_watcher */
+} /* namespace wtr */
@@ -0,0 +1,335 @@
+#pragma once
+
+/* atomic */
+#include <atomic>
+/* milliseconds,
+   steady_clock,
+   duration */
+#include <chrono>
+/* size_t */
+#include <cstddef>
+/* uint8_t,
+   uint64_t */
+#include <cstdint>
+/* path,
+   create_directories,
+   rename,
+   remove */
+#include <filesystem>
+/* ofstream */
+#include <fstream>
+/* mutex,
+   scoped_lock */
+#include <mutex>
+/* string,
+   to_string */
+#include <string>
+/* string_view */
+#include <string_view>
+/* thread,
+   this_thread::sleep_until */
+#include <thread>
+/* unordered_map */
+#include <unordered_map>
+/* move */
+#include <utility>
+/* vector */
+#include <vector>
+/* event */
+#include <wtr/watcher.hpp>
+
+namespace wtr {
+namespace test_watcher {
+
+/* @brief
+     How many writers a `stress` run has, how many cycles
+     each does and at what rate, and what is in a cycle. */
+struct stress_options {
+  int threads{4};
+  int ops{1'000};
+  double rate{0};
+  bool writes{true};
+  bool renames{true};
+  bool removes{true};
+  bool strict_writes{false};
+  bool merged{false};
+  std::chrono::milliseconds settle{std::chrono::milliseconds(5'000)};
+  std::size_t listed{10};
+};
+
+/* @brief
+     What a `stress` run did, and what was seen of it. */
+struct stress_report {
+  std::size_t expected{};
+  std::size_t seen{};
+  std::size_t missing{};
+  std::size_t unexpected{};
+  unsigned long long ops{};
+  double run_s{};
+  double settle_s{};
+  std::vector<std::string> missing_list{};
+  std::vector<std::string> unexpected_list{};
+
+  auto ok() const noexcept -> bool
+  {
+    return this->missing == 0 && this->unexpected == 0;
+  }
+};
+
+/* @brief
+     Drives `threads` writers, each in a directory of its own
+     beneath `root`, through `ops` cycles of creating a file,
+     writing to it, renaming it and removing it (whichever of
+     those are asked for), at `rate` cycles per second between
+     them, or as fast as they can. What the watcher should see
+     is kept, by path, as it is done.
+
+     Give the watcher `callback()`. Then `run()`, and `verify()`
+     what it saw, which waits up to `settle` for what hasn't
+     arrived yet. What was done to each path, and what was
+     seen, are a few bits in a hash table, so checking an
+     event takes as long whether there were ten or a million.
+
+       auto s = stress{root, {.threads = 8, .ops = 10'000}};
+       auto w = watch(root, s.callback());
+       s.run();
+       auto r = s.verify();
+       REQUIRE(r.ok());
+
+     The kernel merges some events on the same file while
+     they wait in its queue, so a write to a file which was
+     just made may be seen as only its creation. Writes are
+     expected, but not required, unless `strict_writes` is
+     set. `fanotify` goes further: everything which happened
+     to one name while it waited is one event, which says one
+     of those things. With `merged`, each path we touched must
+     be seen at least once, as any of what we did to it.
+
+     A missing event is one we did, but which wasn't seen.
+     An unexpected event is one which was seen, but on a path
+     we didn't touch or of a sort we didn't do. */
+class stress {
+  using what = enum ::wtr::watcher::event::what;
+
+  static constexpr auto bit(what w) noexcept -> std::uint8_t
+  {
+    switch (w) {
+      case what::create : return 1;
+      case what::modify : return 2;
+      case what::rename : return 4;
+      case what::destroy : return 8;
+      default : return 16;
+    }
+  }
+
+  /* What must be seen on a path, what may be, and what was.
+     If `any`, one of what may be must be. */
+  struct marks {
+    std::uint8_t must{};
+    std::uint8_t may{};
+    std::uint8_t seen{};
+    bool any{};
+  };
+
+  using table = std::unordered_map<std::string, marks>;
+
+public:
+  using options = stress_options;
+  using report = stress_report;
+
+private:
+  std::filesystem::path root{};
+  options opts{};
+  mutable std::mutex lk{};
+  table paths{};
+  std::size_t outstanding{0};
+  bool verifying{false};
+  std::atomic<std::size_t> seen_count{0};
+  double run_s{0};
+  unsigned long long ops_done{0};
+
+  auto thread_dir(int t) const -> std::filesystem::path
+  {
+    return this->root / ("t" + std::to_string(t));
+  }
+
+  static auto outstanding_of(marks const& m) noexcept -> std::size_t
+  {
+    if (m.any) return m.seen & m.may ? 0 : 1;
+    auto n = std::size_t{0};
+    for (std::uint8_t b = 1; b < 32; b <<= 1)
+      if ((m.must & b) && ! (m.seen & b)) ++n;
+    return n;
+  }
+
+  static auto listed_as(std::string const& where, std::uint8_t bits)
+    -> std::string
+  {
+    static constexpr char const* names[] =
+      {"create", "modify", "rename", "destroy", "other"};
+    auto s = where + " (";
+    for (auto n = 0; n < 5; ++n)
+      if (bits & (1 << n))
+        s.append(s.back() == '(' ? "" : " ").append(names[n]);
+    return s + ")";
+  }
+
+public:
+  stress(std::filesystem::path root, options opts = {})
+      : root{std::move(root)}
+      , opts{opts}
+  {
+    for (auto t = 0; t < this->opts.threads; ++t)
+      std::filesystem::create_directories(this->thread_dir(t));
+  }
+
+  stress(stress const&) = delete;
+  stress& operator=(stress const&) = delete;
+
+  /* Records what the watcher saw. */
+  auto saw(std::string_view where, what w) -> void
+  {
+    auto _ = std::scoped_lock{this->lk};
+    this->seen_count.fetch_add(1, std::memory_order_relaxed);
+    auto& m = this->paths[std::string{where}];
+    auto const before = this->verifying ? outstanding_of(m) : 0;
+    m.seen |= bit(w);
+    if (this->verifying) this->outstanding -= before - outstanding_of(m);
+  }
+
+  /* Something to give the watcher. Messages from the
+     watcher aren't events we made. */
+  auto callback()
+  {
+    return [this](::wtr::watcher::event::compact const& e)
+    {
+      if (e.kind != ::wtr::watcher::event::kind::watcher)
+        this->saw({e.where.data(), e.where.size()}, e.what);
+    };
+  }
+
+  /* Does everything, from every thread, and returns once
+     they are all done. Returns how many cycles were done. */
+  auto run() -> unsigned long long
+  {
+    using clock = std::chrono::steady_clock;
+
+    auto done = std::atomic<unsigned long long>{0};
+    auto tables = std::vector<table>(this->opts.threads);
+    auto const began = clock::now();
+
+    auto threads = std::vector<std::thread>{};
+    for (auto t = 0; t < this->opts.threads; ++t)
+      threads.emplace_back(
+        [&, t]()
+        {
+          auto& expect = tables[t];
+          auto const dir = this->thread_dir(t);
+          auto const interval =
+            this->opts.rate > 0
+              ? std::chrono::duration<double>(this->opts.threads
+                                              / this->opts.rate)
+              : std::chrono::duration<double>(0);
+          expect.reserve(this->opts.ops * 2);
+          for (auto k = 0; k < this->opts.ops; ++k) {
+            if (this->opts.rate > 0)
+              std::this_thread::sleep_until(
+                began
+                + std::chrono::duration_cast<clock::duration>(interval * k));
+            auto file = dir / std::to_string(k);
+            auto& made = expect[file.native()];
+            made.must |= bit(what::create);
+            std::ofstream{file};
+            if (this->opts.writes) {
+              (this->opts.strict_writes ? made.must : made.may) |=
+                bit(what::modify);
+              std::ofstream{file, std::ios::app} << "x";
+            }
+            if (this->opts.renames) {
+              auto to = dir / (std::to_string(k) + ".r");
+              made.must |= bit(what::rename);
+              expect[to.native()].must |= bit(what::rename);
+              std::filesystem::rename(file, to);
+              file = std::move(to);
+            }
+            if (this->opts.removes) {
+              expect[file.native()].must |= bit(what::destroy);
+              std::filesystem::remove(file);
+            }
+          }
+          done += this->opts.ops;
+        });
+    for (auto& t : threads) t.join();
+
+    this->run_s =
+      std::chrono::duration<double>(clock::now() - began).count();
+    this->ops_done = done.load();
+
+    auto _ = std::scoped_lock{this->lk};
+    for (auto const& expect : tables)
+      for (auto const& [where, made] : expect) {
+        auto& m = this->paths[where];
+        if (this->opts.merged) {
+          m.may |= made.must | made.may;
+          m.any = true;
+        }
+        else {
+          m.must |= made.must;
+          m.may |= made.may;
+        }
+      }
+    this->outstanding = 0;
+    for (auto const& [where, m] : this->paths)
+      this->outstanding += outstanding_of(m);
+    this->verifying = true;
+
+    return this->ops_done;
+  }
+
+  /* Waits up to `settle` for everything we did to be seen,
+     then says what wasn't, and what was seen which we
+     didn't do. */
+  auto verify() -> report
+  {
+    using clock = std::chrono::steady_clock;
+
+    auto const began = clock::now();
+    auto const until = began + this->opts.settle;
+    for (;;) {
+      {
+        auto _ = std::scoped_lock{this->lk};
+        if (this->outstanding == 0) break;
+      }
+      if (clock::now() > until) break;
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    auto r = report{};
+    r.ops = this->ops_done;
+    r.run_s = this->run_s;
+    r.settle_s = std::chrono::duration<double>(clock::now() - began).count();
+    r.seen = this->seen_count.load();
+
+    auto _ = std::scoped_lock{this->lk};
+    for (auto const& [where, m] : this->paths) {
+      r.expected += outstanding_of({m.must, m.may, 0, m.any});
+      auto const missing = outstanding_of(m);
+      auto const unexpected = (std::uint8_t)(m.seen & ~(m.must | m.may));
+      if (missing > 0) {
+        r.missing += missing;
+        if (r.missing_list.size() < this->opts.listed)
+          r.missing_list.push_back(
+            listed_as(where, m.any ? m.may : m.must & ~m.seen));
+      }
+      if (unexpected) {
+        r.unexpected += 1;
+        if (r.unexpected_list.size() < this->opts.listed)
+          r.unexpected_list.push_back(listed_as(where, unexpected));
+      }
+    }
+    return r;
+  }
+};
+
+} /* namespace test_watcher */
+} /* namespace wtr */
@@ -1,8 +1,12 @@
 #pragma once
 
+#include <test_watcher/adapter.hpp>
 #include <test_watcher/chrono.hpp>
 #include <test_watcher/conf.hpp>
 #include <test_watcher/constant.hpp>
 #include <test_watcher/event.hpp>
 #include <test_watcher/filesystem.hpp>
+#include <test_watcher/seen.hpp>
+#include <test_watcher/settle.hpp>
+#include <test_watcher/stress.hpp>
 #include <test_watcher/watch_gather.hpp>
@@ -0,0 +1,66 @@
+#pragma once
+
+/*  milliseconds */
+#include <chrono>
+/*  make_shared */
+#include <memory>
+/*  stage::atomic_save */
+#include <detail/wtr/watcher/stage/atomic_save.hpp>
+/*  event
+    callback */
+#include <wtr/watcher.hpp>
+
+namespace wtr {
+inline namespace watcher {
+
+/*  @brief wtr/watcher/atomic_save
+
+    Returns a callback which calls `callback` once, with a
+    `modify` event, when a file is saved "atomically".
+
+    Editors and configuration management tools tend to
+    save a file by writing a temporary file and renaming
+    it over the original, or by moving the original aside
+    and writing a new one. That is three to five events,
+    most of them for a path nobody cares about. Through
+    `atomic_save`, it is one `modify` event for the file
+    which was saved.
+
+    Events for temporary paths, and renames, are held back
+    for up to `window`. If they don't turn out to be part of
+    a save, they are let go as they happened. Events from
+    the watcher are never held back, and everything is let
+    go before the watcher's last event.
+
+    Typical use looks like this:
+
+    auto w = watch(".", atomic_save([](event const& e) {
+      if (e.what == event::what::modify) reload(e.where);
+    }));
+
+    @param callback:
+      Something to call with the events.
+
+    @param window (optional):
+      How long a save may take.
+
+    @param is_temp (optional):
+      Whether a path is temporary. By default, names such
+      as `foo~`, `foo.tmp`, `.foo.swp` and `.#foo` are. */
+inline auto atomic_save(
+  event::callback const& callback,
+  std::chrono::milliseconds const& window = std::chrono::milliseconds(100),
+  ::detail::wtr::watcher::stage::atomic_save::predicate const& is_temp =
+    ::detail::wtr::watcher::stage::atomic_save::looks_temporary) noexcept
+  -> event::callback
+{
+  auto self =
+    std::make_shared<::detail::wtr::watcher::stage::atomic_save>(callback,
+                                                                  window,
+                                                                  is_temp);
+
+  return [self](event const& ev) noexcept { (*self)(ev); };
+};
+
+} /* namespace watcher */
+} /* namespace wtr   */
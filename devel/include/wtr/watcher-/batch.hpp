@@ -0,0 +1,268 @@
+#pragma once
+
+/*  ptrdiff_t */
+#include <cstddef>
+/*  path */
+#include <filesystem>
+/*  function
+    hash */
+#include <functional>
+/*  forward_iterator_tag */
+#include <iterator>
+/*  basic_string_view */
+#include <string_view>
+/*  event */
+#include <wtr/watcher-/event.hpp>
+
+namespace wtr {
+inline namespace watcher {
+
+/*  @brief wtr/watcher/batch
+    A view of what the kernel gave the watcher in one read,
+    for callbacks which only look at a little of it.
+
+    Nothing is decoded until it is asked for. Iterating
+    steps from one record to the next in the adapter's own
+    buffer. The name of what happened is a view into that
+    buffer. The full path is only put together when asked
+    for, into a string which the caller can reuse.
+
+    Each entry is also addressed by its directory and its
+    name. A directory's id stays the same for as long as
+    the watcher knows about that directory, and `dir(id)`
+    finds its path without building anything, so callbacks
+    which group or hash by directory can use the id instead
+    of the path.
+
+    The view (and everything from it) is good until the
+    callback returns. Messages from the watcher are not in
+    batches: they are sent as one-entry batches of their
+    own, as are the events on platforms which don't read
+    records from the kernel in bulk.
+
+    Typical use looks like this:
+
+    auto w = watch(".", [](batch const& b) {
+      for (auto e : b)
+        if (e.what() == event::what::create) ++created;
+    }); */
+class batch {
+public:
+  using callback = std::function<void(batch const&)>;
+  using string_type = std::filesystem::path::string_type;
+  using view_type = std::basic_string_view<std::filesystem::path::value_type>;
+  using dir_id = std::size_t;
+
+  /*  How to read the records in a buffer. The adapters
+      have one of these for their kernel's records.
+      - first
+          The first record at or after `at` which is an
+          event, or `end`.
+      - next
+          The record after `at` which is an event, or `end`.
+      - what, kind
+          What happened, and to what kind of thing.
+      - name
+          The name of what it happened to.
+      - dir
+          The id of the directory it happened in.
+      - dir_path
+          The path of a directory, by its id, or nothing if
+          the directory is gone.
+      - where
+          Puts the full path in `into`. The `context` is
+          whatever the adapter gave the batch. Returns false
+          if the path is gone. */
+  struct decoder {
+    char const* (*first)(char const* at, char const* end) noexcept;
+    char const* (*next)(char const* at, char const* end) noexcept;
+    enum event::what (*what)(char const* at) noexcept;
+    enum event::kind (*kind)(char const* at) noexcept;
+    view_type (*name)(char const* at) noexcept;
+    dir_id (*dir)(void const* context, char const* at) noexcept;
+    view_type (*dir_path)(void const* context, dir_id dir) noexcept;
+    bool (*where)(void const* context,
+                  char const* at,
+                  string_type& into) noexcept;
+  };
+
+  /*  One record, decoded as it is asked about. */
+  class entry {
+    batch const* in;
+    char const* at;
+
+  public:
+    entry(batch const* in, char const* at) noexcept
+        : in{in},
+          at{at}
+    {}
+
+    auto what() const noexcept -> enum event::what
+    {
+      return this->in->decode->what(this->at);
+    }
+
+    auto kind() const noexcept -> enum event::kind
+    {
+      return this->in->decode->kind(this->at);
+    }
+
+    auto name() const noexcept -> view_type
+    {
+      return this->in->decode->name(this->at);
+    }
+
+    auto dir() const noexcept -> dir_id
+    {
+      return this->in->decode->dir(this->in->context, this->at);
+    }
+
+    /*  Puts the full path in `into`, reusing its storage.
+        Returns false if the path can't be found. */
+    auto where(string_type& into) const noexcept -> bool
+    {
+      return this->in->decode->where(this->in->context, this->at, into);
+    }
+
+    /*  The full path. Allocates. */
+    auto where() const noexcept -> std::filesystem::path
+    {
+      auto into = string_type{};
+      return this->where(into) ? std::filesystem::path{std::move(into)}
+                               : std::filesystem::path{};
+    }
+  };
+
+  class iterator {
+    batch const* in{nullptr};
+    char const* at{nullptr};
+
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = entry;
+    using difference_type = std::ptrdiff_t;
+    using pointer = void;
+    using reference = entry;
+
+    iterator() noexcept = default;
+
+    iterator(batch const* in, char const* at) noexcept
+        : in{in},
+          at{at}
+    {}
+
+    auto operator*() const noexcept -> entry { return {this->in, this->at}; }
+
+    auto operator++() noexcept -> iterator&
+    {
+      this->at = this->in->decode->next(this->at, this->in->tail);
+      return *this;
+    }
+
+    auto operator++(int) noexcept -> iterator
+    {
+      auto was = *this;
+      ++*this;
+      return was;
+    }
+
+    auto operator==(iterator const& r) const noexcept -> bool
+    {
+      return this->at == r.at;
+    }
+  };
+
+private:
+  char const* head;
+  char const* tail;
+  decoder const* decode;
+  void const* context;
+  long long stamp;
+  enum event::clock stamped_by;
+
+public:
+  batch(char const* head,
+        char const* tail,
+        decoder const& decode,
+        void const* context = nullptr,
+        long long when = 0,
+        enum event::clock clock = event::clock::none) noexcept
+      : head{head},
+        tail{tail},
+        decode{&decode},
+        context{context},
+        stamp{when},
+        stamped_by{clock}
+  {}
+
+  /*  When everything in here was read, and from which
+      clock. See `event::clock`. */
+  auto when() const noexcept -> long long { return this->stamp; }
+
+  auto clock() const noexcept -> enum event::clock { return this->stamped_by; }
+
+  auto begin() const noexcept -> iterator
+  {
+    return {this, this->decode->first(this->head, this->tail)};
+  }
+
+  auto end() const noexcept -> iterator { return {this, this->tail}; }
+
+  auto empty() const noexcept -> bool { return this->begin() == this->end(); }
+
+  /*  The path of the directory with this id. */
+  auto dir(dir_id dir) const noexcept -> view_type
+  {
+    return this->decode->dir_path(this->context, dir);
+  }
+
+private:
+  static auto parent_of(void const* ev) noexcept -> view_type
+  {
+    auto const& p = static_cast<event const*>(ev)->where.native();
+    auto const sep = p.rfind(std::filesystem::path::preferred_separator);
+    return view_type{p}.substr(0, sep == string_type::npos ? 0 : sep);
+  }
+
+public:
+  /*  Reads one event as a batch of one. This is how
+      events which weren't read in bulk are sent. There is
+      no table of directories behind these, so a directory's
+      id is a hash of its path. */
+  static constexpr auto of_event = decoder{
+    .first = [](char const* at, char const*) noexcept { return at; },
+    .next = [](char const*, char const* end) noexcept { return end; },
+    .what = [](char const* at) noexcept
+    { return reinterpret_cast<event const*>(at)->what; },
+    .kind = [](char const* at) noexcept
+    { return reinterpret_cast<event const*>(at)->kind; },
+    .name = [](char const* at) noexcept -> view_type
+    {
+      auto const& p = reinterpret_cast<event const*>(at)->where.native();
+      auto const sep = p.rfind(std::filesystem::path::preferred_separator);
+      return view_type{p}.substr(sep == string_type::npos ? 0 : sep + 1);
+    },
+    .dir = [](void const* context, char const*) noexcept -> dir_id
+    { return std::hash<view_type>{}(parent_of(context)); },
+    .dir_path = [](void const* context, dir_id) noexcept -> view_type
+    { return parent_of(context); },
+    .where = [](void const*, char const* at, string_type& into) noexcept
+    {
+      into.assign(reinterpret_cast<event const*>(at)->where.native());
+      return true;
+    },
+  };
+
+  /*  A batch of one event. */
+  explicit batch(event const& ev) noexcept
+      : batch{reinterpret_cast<char const*>(&ev),
+              reinterpret_cast<char const*>(&ev + 1),
+              of_event,
+              &ev,
+              ev.when,
+              ev.clock}
+  {}
+};
+
+} /* namespace watcher */
+} /* namespace wtr   */
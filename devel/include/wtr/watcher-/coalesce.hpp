@@ -0,0 +1,58 @@
+#pragma once
+
+/*  milliseconds */
+#include <chrono>
+/*  make_shared */
+#include <memory>
+/*  stage::coalesce */
+#include <detail/wtr/watcher/stage/coalesce.hpp>
+/*  event
+    callback */
+#include <wtr/watcher.hpp>
+
+namespace wtr {
+inline namespace watcher {
+
+/*  @brief wtr/watcher/coalesce
+
+    Returns a callback which calls `callback` once for
+    a burst of events on the same path.
+
+    Editors and build tools tend to write to a file a
+    few times in a row. Through `coalesce`, a `create`
+    and a few `modify` events on a path within `window`
+    of each other are one `create` event.
+
+    Each path's (merged) event is sent `window` after the
+    first event on that path. Events from the watcher are
+    never held back, and everything is let go before the
+    watcher's last event.
+
+    This works with every adapter. It can be stacked
+    with the other stages, such as `collapse`.
+
+    Typical use looks like this:
+
+    auto w = watch(".", coalesce([](event const& e) {
+      std::cout << e << std::endl;
+    }));
+
+    @param callback:
+      Something to call with the merged events.
+
+    @param window (optional):
+      How long to wait for more events on the same path. */
+inline auto coalesce(event::callback const& callback,
+                     std::chrono::milliseconds const& window =
+                       std::chrono::milliseconds(50)) noexcept
+  -> event::callback
+{
+  auto self =
+    std::make_shared<::detail::wtr::watcher::stage::coalesce>(callback,
+                                                               window);
+
+  return [self](event const& ev) noexcept { (*self)(ev); };
+};
+
+} /* namespace watcher */
+} /* namespace wtr   */
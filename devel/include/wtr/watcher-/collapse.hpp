@@ -0,0 +1,62 @@
+#pragma once
+
+/*  milliseconds */
+#include <chrono>
+/*  make_shared */
+#include <memory>
+/*  stage::collapse */
+#include <detail/wtr/watcher/stage/collapse.hpp>
+/*  event
+    callback */
+#include <wtr/watcher.hpp>
+
+namespace wtr {
+inline namespace watcher {
+
+/*  @brief wtr/watcher/collapse
+
+    Returns a callback which calls `callback` once for
+    a subtree which is destroyed, or created, all at once.
+
+    Removing a tree with half a million paths in it is
+    half a million `destroy` events. Through `collapse`,
+    it is one `destroy` event for the tree's root.
+    The same goes for `create` events when a tree is
+    populated, such as by extracting an archive.
+
+    Events are held back for up to `window` after the
+    last thing was folded into their root, and for no
+    more than four times that in all, so a tree which is
+    busy for a long while (a new directory which a log is
+    written to, say) is still seen. What happens in a new
+    tree, other than creation, is passed through as it
+    happens. Events from the watcher are never held back,
+    and everything is let go before the watcher's last
+    event.
+
+    Typical use looks like this:
+
+    auto w = watch(".", collapse([](event const& e) {
+      std::cout << e << std::endl;
+    }));
+
+    @param callback:
+      Something to call with the collapsed events.
+
+    @param window (optional):
+      How long to wait for more events beneath a root.
+      A root is let go within four of these. */
+inline auto collapse(event::callback const& callback,
+                     std::chrono::milliseconds const& window =
+                       std::chrono::milliseconds(100)) noexcept
+  -> event::callback
+{
+  auto self =
+    std::make_shared<::detail::wtr::watcher::stage::collapse>(callback,
+                                                               window);
+
+  return [self](event const& ev) noexcept { (*self)(ev); };
+};
+
+} /* namespace watcher */
+} /* namespace wtr   */
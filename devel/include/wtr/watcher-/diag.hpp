@@ -0,0 +1,210 @@
+#pragma once
+
+/*  equal */
+#include <algorithm>
+/*  size_t */
+#include <cstddef>
+/*  strerror */
+#include <cstring>
+/*  function */
+#include <functional>
+/*  string */
+#include <string>
+/*  string_view */
+#include <string_view>
+/*  is_invocable_v */
+#include <type_traits>
+/*  event */
+#include <wtr/watcher-/event.hpp>
+
+namespace wtr {
+inline namespace watcher {
+
+/*  @brief wtr/watcher/diag
+    Something the watcher says about itself: that it is
+    alive or dead, what it couldn't watch, and what went
+    wrong. Without a diagnostic callback, these are sent
+    as events of `kind::watcher`, with a message such as
+    `e/sys/epoll_wait@/some/path` for where. With one, they
+    are sent to it instead, and nothing is put together:
+      - level
+          A status, a warning or an error (the `s`, `w` and
+          `e` which begin a message).
+      - code
+          What this is about. `name()` is its part of the
+          message, such as `sys/epoll_wait`.
+      - error
+          The `errno` from the call which failed, or 0.
+      - where
+          The path being watched.
+      - also
+          Another path, such as a directory we couldn't
+          watch, or nothing.
+      - count
+          How many of these there were. Warnings about the
+          directories in a tree are counted as we go through
+          it, and sent once, with the first of them in `also`.
+
+    The paths are viewed, and last as long as the callback. */
+struct diag {
+  enum class level : unsigned char { status, warning, error };
+
+  enum class code : unsigned char {
+    live,
+    die,
+    not_watched,
+    overflow,
+    event_info,
+    read,
+    epoll_create,
+    epoll_ctl,
+    epoll_wait,
+    inotify_init,
+    fanotify_init,
+    fanotify_mark,
+    kernel_version,
+    wrong_event_fd,
+    event_recv,
+    path_map,
+    sys_resource,
+    bad_fs,
+    other,
+  };
+
+  using callback = std::function<void(diag const&)>;
+
+  enum level level {};
+  enum code code {};
+  int error{0};
+  std::string_view where{};
+  std::string_view also{};
+  std::size_t count{1};
+
+  static constexpr auto name(enum code c) noexcept -> std::string_view
+  {
+    switch (c) {
+      case code::live : return "self/live";
+      case code::die : return "self/die";
+      case code::not_watched : return "sys/not_watched";
+      case code::overflow : return "sys/overflow";
+      case code::event_info : return "self/event_info";
+      case code::read : return "sys/read";
+      case code::epoll_create : return "sys/epoll_create";
+      case code::epoll_ctl : return "sys/epoll_ctl";
+      case code::epoll_wait : return "sys/epoll_wait";
+      case code::inotify_init : return "sys/inotify_init";
+      case code::fanotify_init : return "sys/fanotify_init";
+      case code::fanotify_mark : return "sys/fanotify_mark";
+      case code::kernel_version : return "sys/kernel_version";
+      case code::wrong_event_fd : return "sys/wrong_event_fd";
+      case code::event_recv : return "self/event_recv";
+      case code::path_map : return "self/path_map";
+      case code::sys_resource : return "self/sys_resource";
+      case code::bad_fs : return "self/die/bad_fs";
+      case code::other : return "other";
+    }
+    return "other";
+  }
+
+  auto name() const noexcept -> std::string_view { return name(this->code); }
+
+  /*  What happened, as an event would say: the watcher is
+      created when it is alive and destroyed when it dies. */
+  auto what() const noexcept -> enum event::what
+  {
+    return this->code == code::live ? event::what::create
+         : this->code == code::die || this->code == code::bad_fs
+           ? event::what::destroy
+           : event::what::other;
+  }
+
+  /*  The message which is sent as an event's path when
+      there is no diagnostic callback. */
+  auto message() const -> std::string
+  {
+    auto m = std::string{this->level == level::status    ? "s/"
+                         : this->level == level::warning ? "w/"
+                                                         : "e/"};
+    m += this->name();
+    if (this->error != 0) {
+      m += '(';
+      m += std::strerror(this->error);
+      m += ')';
+    }
+    if (! this->where.empty()) {
+      m += '@';
+      m += this->where;
+    }
+    if (! this->also.empty()) {
+      m += '@';
+      m += this->also;
+    }
+    return m;
+  }
+
+  /*  Reads a message back, from an event of
+      `kind::watcher`. The paths view the event's. */
+  static auto of(event const& ev) noexcept -> diag
+  {
+    auto const& m = ev.where.native();
+    auto const msg = std::basic_string_view<std::filesystem::path::value_type>{m};
+    auto d = diag{};
+    d.level = msg.starts_with('s') ? level::status
+            : msg.starts_with('w') ? level::warning
+                                   : level::error;
+    auto const head = msg.substr(0, msg.find('@'));
+    auto const named = head.substr(head.find('/') + 1);
+    auto const name_only = named.substr(0, named.find('('));
+    d.code = code::other;
+    for (auto c = 0; c < (int)code::other; ++c)
+      if (std::equal(name_only.begin(),
+                     name_only.end(),
+                     name((enum code)c).begin(),
+                     name((enum code)c).end()))
+        d.code = (enum code)c;
+    /* Paths which aren't made of `char`s aren't viewed. */
+    auto const view_paths = [&d](auto rest) noexcept
+    {
+      if constexpr (std::is_same_v<decltype(rest), std::string_view>) {
+        auto const at = rest.find('@');
+        d.where = rest.substr(0, at);
+        if (at != rest.npos) d.also = rest.substr(at + 1);
+      }
+    };
+    if (head.size() < msg.size()) view_paths(msg.substr(head.size() + 1));
+    return d;
+  }
+};
+
+/*  @brief wtr/watcher/with_diags
+    A callback for events, along with one for diagnostics.
+    Give this to `watch` to have what the watcher says about
+    itself sent to `diags`, instead of to `callback` as
+    events of `kind::watcher`.
+
+    auto w = watch(".", with_diags(callback, [](diag const& d) {
+      if (d.level == diag::level::error) std::cerr << d.message();
+    })); */
+template<class Callback>
+struct diagnosed {
+  Callback callback;
+  diag::callback diags;
+
+  template<class Event>
+  requires(std::is_invocable_v<Callback const&, Event const&>)
+  auto operator()(Event const& ev) const noexcept -> void
+  {
+    this->callback(ev);
+  }
+};
+
+template<class Callback>
+inline auto
+with_diags(Callback const& callback, diag::callback const& diags) noexcept
+  -> diagnosed<Callback>
+{
+  return {callback, diags};
+}
+
+} /* namespace watcher */
+} /* namespace wtr */
@@ -3,15 +3,24 @@
 /* std::basic_ostream */
 #include <ios>
 /* std::chrono::system_clock::now
+   std::chrono::steady_clock::now
    std::chrono::duration_cast
-   std::chrono::system_clock
-   std::chrono::nanoseconds
-   std::chrono::time_point */
+   std::chrono::nanoseconds */
 #include <chrono>
+/* clock_gettime
+   timespec
+   CLOCK_*_COARSE */
+#include <time.h>
+/* std::uint32_t */
+#include <cstdint>
 /* std::filesystem::path */
 #include <filesystem>
 /* std::function */
 #include <functional>
+/* std::basic_string_view */
+#include <string_view>
+/* std::is_trivially_copyable_v */
+#include <type_traits>
 
 namespace wtr {
 inline namespace watcher {
@@ -42,12 +51,26 @@ inline namespace watcher {
         - destroy
         - owner
         - other
-      - Event time in nanoseconds since epoch
+      - Event time in nanoseconds, since the epoch of the
+        clock it was read from
+      - Which clock that was, one of:
+        - system
+        - realtime_coarse
+        - monotonic_coarse
+        - none
+      - Which of the watcher's roots it happened beneath,
+        by its place among them (always 0 for a watcher
+        of one path)
 
     The `watcher` type is special.
     Events with this type will include messages from
     the watcher. You may recieve error messages or
-    important status updates.  */
+    important status updates.
+
+    Each `event` owns its path, which is (usually) an
+    allocation. An `event::compact` doesn't: it is a view
+    of a path which the adapter owns, and can be made into
+    an `event` when the path needs to outlive the callback. */
 
 struct event {
 
@@ -57,8 +80,6 @@ private:
      'event kind' */
   using path_type = std::filesystem::path;
   using ns = std::chrono::nanoseconds;
-  using clock = std::chrono::system_clock;
-  using time_point = std::chrono::time_point<clock>;
 
 public:
   /*  @brief watcher/event/callback
@@ -96,14 +117,125 @@ public:
     other,
   };
 
+  /*  @brief wtr/watcher/event/clock
+      Where an event's time came from.
+      - system
+          The system clock, read for each event (as it
+          always has been) or, on Linux, for each read from
+          the kernel. Nanoseconds since the Unix epoch.
+      - realtime_coarse
+          The same, but only as fine as the last tick of
+          the kernel (a few milliseconds), which is much
+          cheaper to read. Linux only: elsewhere, the same
+          as `system`.
+      - monotonic_coarse
+          A coarse clock which never goes backwards, counted
+          from some point (usually boot). Only meaningful
+          against other times from the same clock. Linux
+          only: elsewhere, a steady clock.
+      - none
+          Not read at all. The time is zero. */
+  enum class clock {
+    system,
+    realtime_coarse,
+    monotonic_coarse,
+    none,
+  };
+
+  /*  @brief wtr/watcher/event/now
+      The time, from `clock`, in nanoseconds. */
+  static auto now(enum clock clock) noexcept -> long long
+  {
+    using std::chrono::duration_cast;
+    auto const since = [](auto t) noexcept -> long long
+    { return duration_cast<ns>(t.time_since_epoch()).count(); };
+#if defined(CLOCK_REALTIME_COARSE) && defined(CLOCK_MONOTONIC_COARSE)
+    auto const coarse = [](clockid_t id) noexcept -> long long
+    {
+      auto ts = timespec{};
+      clock_gettime(id, &ts);
+      return ts.tv_sec * 1'000'000'000ll + ts.tv_nsec;
+    };
+#endif
+    switch (clock) {
+      case clock::system : return since(std::chrono::system_clock::now());
+#if defined(CLOCK_REALTIME_COARSE) && defined(CLOCK_MONOTONIC_COARSE)
+      case clock::realtime_coarse  : return coarse(CLOCK_REALTIME_COARSE);
+      case clock::monotonic_coarse : return coarse(CLOCK_MONOTONIC_COARSE);
+#else
+      case clock::realtime_coarse :
+        return since(std::chrono::system_clock::now());
+      case clock::monotonic_coarse :
+        return since(std::chrono::steady_clock::now());
+#endif
+      case clock::none : return 0;
+      default          : return 0;
+    }
+  }
+
+  /*  @brief wtr/watcher/event/compact
+      An event which views its path instead of owning it.
+      The view is good until the callback returns. Copying
+      one (or a vector of them) copies a few words.
+
+      The adapters make these from their own buffers, so
+      none of them allocates. On Linux, that is what the
+      adapters send, and an `event` is made from them only
+      for callbacks which take one. */
+  struct compact {
+    using view_type = std::basic_string_view<path_type::value_type>;
+
+    /*  @brief watcher/event/compact/callback
+        A callback which is given compact events. */
+    using callback = std::function<void(compact const&)>;
+
+    view_type where{};
+
+    enum what what {};
+
+    enum kind kind {};
+
+    long long when{now(clock::system)};
+
+    enum clock clock {};
+
+    std::uint32_t root{};
+
+    compact() noexcept = default;
+
+    compact(view_type where, enum what what, enum kind kind) noexcept
+        : where{where},
+          what{what},
+          kind{kind} {};
+
+    compact(view_type where,
+            enum what what,
+            enum kind kind,
+            long long when,
+            enum clock clock = clock::system,
+            std::uint32_t root = 0) noexcept
+        : where{where},
+          what{what},
+          kind{kind},
+          when{when},
+          clock{clock},
+          root{root} {};
+
+    /*  Views an event's path. */
+    explicit compact(event const& from) noexcept;
+  };
+
   path_type const where{};
 
   enum what const what {};
 
   enum kind const kind {};
 
-  long long const when{
-    duration_cast<ns>(time_point{clock::now()}.time_since_epoch()).count()};
+  long long const when{now(clock::system)};
+
+  enum clock const clock {};
+
+  std::uint32_t const root{};
 
   event(std::filesystem::path const& where,
         enum what const& what,
@@ -112,9 +244,43 @@ public:
         what{what},
         kind{kind} {};
 
+  /*  Keeps the time of an event which happened earlier,
+      such as one which was held back and then let go. */
+  event(std::filesystem::path const& where,
+        enum what const& what,
+        enum kind const& kind,
+        long long const& when,
+        enum clock const& clock = clock::system,
+        std::uint32_t root = 0) noexcept
+      : where{where},
+        what{what},
+        kind{kind},
+        when{when},
+        clock{clock},
+        root{root} {};
+
+  /*  Copies the path out of a compact event. */
+  explicit event(compact const& from) noexcept
+      : where{from.where},
+        what{from.what},
+        kind{from.kind},
+        when{from.when},
+        clock{from.clock},
+        root{from.root} {};
+
   ~event() noexcept = default;
 };
 
+inline event::compact::compact(event const& from) noexcept
+    : where{from.where.native()},
+      what{from.what},
+      kind{from.kind},
+      when{from.when},
+      clock{from.clock},
+      root{from.root} {};
+
+static_assert(std::is_trivially_copyable_v<event::compact>);
+
 /*  @brief wtr/watcher/event/<<
     Streams out a `what` value. */
 template<class Char, class CharTraits>
@@ -177,9 +343,19 @@ inline constexpr auto operator<<(std::basic_ostream<Char, CharTraits>& os,
   /* clang-format on */
 };
 
+/*  @brief wtr/watcher/event/compact/<<
+    Streams out a compact event, as above. */
+template<class Char, class CharTraits>
+inline auto operator<<(std::basic_ostream<Char, CharTraits>& os,
+                       event::compact const& ev) noexcept
+  -> std::basic_ostream<Char, CharTraits>&
+{
+  return os << event{ev};
+};
+
 /*  @brief wtr/watcher/event/==
     A "strict" comparison of an event's `when`,
-    `where`, `what` and `kind` values.
+    `where`, `what`, `kind` and `root` values.
     Keep in mind that this compares `when`,
     which might not be desireable. */
 inline auto operator==(event const& l, event const& r) noexcept -> bool
@@ -188,7 +364,8 @@ inline auto operator==(event const& l, event const& r) noexcept -> bool
   return l.where == r.where
       && l.what  == r.what
       && l.kind  == r.kind
-      && l.when  == r.when;
+      && l.when  == r.when
+      && l.root  == r.root;
   /* clang-format on */
 };
 
@@ -0,0 +1,193 @@
+#pragma once
+
+/*  size_t */
+#include <cstddef>
+/*  path */
+#include <filesystem>
+/*  initializer_list */
+#include <initializer_list>
+/*  string */
+#include <string>
+/*  string_view */
+#include <string_view>
+/*  pair */
+#include <utility>
+/*  vector */
+#include <vector>
+/*  glob */
+#include <detail/wtr/watcher/filter/glob.hpp>
+/*  gitignore::load */
+#include <detail/wtr/watcher/filter/gitignore.hpp>
+/*  event */
+#include <wtr/watcher-/event.hpp>
+
+namespace wtr {
+inline namespace watcher {
+
+/*  @brief wtr/watcher/filter
+    Decides which paths we send events for.
+
+    A filter is a list of glob patterns, with the syntax
+    of `.gitignore`. Paths are matched relative to the
+    path being watched. A pattern keeps what it matches,
+    unless it starts with `!`, in which case it drops
+    what it matches. The last pattern to match a path
+    decides.
+
+    If any pattern keeps things, then nothing else is
+    kept. Otherwise, everything which isn't dropped is.
+    Everything beneath a directory which is dropped is
+    dropped, too.
+
+    Events from the watcher are always sent.
+
+    The adapters match the names which the system gives
+    them, before anything is made out of them, so paths
+    which are dropped cost (almost) nothing.
+
+    Typical use looks like this:
+
+    // Object files, but not the ones in `vendor`
+    auto w = watch(".", filter{"*.o", "!vendor/"}, callback);
+
+    // Everything but `.git` and `build`
+    auto w = watch(".", filter{"!.git/", "!build/"}, callback);
+
+    // What git would track, and nothing in `build`
+    auto w = watch(".", filter::gitignore({"!build/"}), callback);
+
+    A filter made with `gitignore` reads the `.gitignore`
+    files beneath the path being watched, in the way that
+    git does, and drops what they ignore (and `.git`).
+    Those rules come first, so the patterns given to it win.
+    Whether it keeps everything which isn't dropped depends
+    on those patterns alone. When a `.gitignore` changes,
+    the adapters read them again.
+
+    Directories are watched whether or not they are kept,
+    so the things in them can be, unless everything in them
+    is dropped. Then, where it is up to us, the directory
+    isn't watched at all. */
+class filter {
+  using glob = ::detail::wtr::watcher::filter::glob;
+
+  /* The automaton is built as it is walked. */
+  mutable glob compiled{};
+  glob::verdict otherwise{glob::verdict::keep};
+  /* What we were given, for when the `.gitignore`s change. */
+  std::vector<std::string> patterns{};
+  bool from_gitignore{false};
+
+  static auto parse(std::vector<std::string> const& patterns) noexcept
+    -> std::vector<std::pair<std::string, glob::verdict>>
+  {
+    auto parsed = std::vector<std::pair<std::string, glob::verdict>>{};
+    for (auto const& p : patterns)
+      if (! p.empty() && p.front() == '!')
+        parsed.emplace_back(p.substr(1), glob::verdict::drop);
+      else if (! p.empty())
+        parsed.emplace_back(p, glob::verdict::keep);
+    return parsed;
+  }
+
+public:
+  using state = glob::state;
+
+  /*  Keeps everything. */
+  filter() noexcept = default;
+
+  filter(std::vector<std::string> const& patterns) noexcept
+      : compiled{parse(patterns)},
+        patterns{patterns}
+  {
+    for (auto const& p : patterns)
+      if (! p.empty() && p.front() != '!') this->otherwise = glob::verdict::drop;
+  }
+
+  filter(std::initializer_list<std::string_view> patterns) noexcept
+      : filter{std::vector<std::string>(patterns.begin(), patterns.end())}
+  {}
+
+  /*  Drops what the `.gitignore` files beneath the path
+      being watched ignore, and then does what `patterns`
+      say. */
+  static auto gitignore(std::vector<std::string> const& patterns = {}) noexcept
+    -> filter
+  {
+    auto f = filter{patterns};
+    f.from_gitignore = true;
+    return f;
+  }
+
+  static auto gitignore(std::initializer_list<std::string_view> patterns) noexcept
+    -> filter
+  {
+    return gitignore(std::vector<std::string>(patterns.begin(), patterns.end()));
+  }
+
+  /*  This filter, with the `.gitignore` files beneath `root`
+      read, if it was made with `gitignore`. The adapters
+      use this when they start, and when `reloads` says so. */
+  auto loaded(std::filesystem::path const& root) const noexcept -> filter
+  {
+    if (! this->from_gitignore) return *this;
+    auto rules = ::detail::wtr::watcher::filter::gitignore::load(root);
+    for (auto&& r : parse(this->patterns)) rules.push_back(std::move(r));
+    auto f = *this;
+    f.compiled = glob{rules};
+    return f;
+  }
+
+  /*  Whether something happening to `name` means that
+      this filter should be loaded again. */
+  template<class Char>
+  auto reloads(std::basic_string_view<Char> name) const noexcept -> bool
+  {
+    constexpr char gitignore_name[] = ".gitignore";
+    if (! this->from_gitignore || name.size() != sizeof gitignore_name - 1)
+      return false;
+    for (auto i = std::size_t{0}; i < name.size(); ++i)
+      if (name[i] != static_cast<Char>(gitignore_name[i])) return false;
+    return true;
+  }
+
+  /*  Whether this filter keeps everything. */
+  auto empty() const noexcept -> bool { return this->compiled.empty(); }
+
+  /*  The state at the root, before anything is walked. */
+  static constexpr auto start() noexcept -> state { return glob::start(); }
+
+  /*  The state after walking `bytes`. Walk a directory's
+      name and a `/` to get a state which its things start
+      from. */
+  auto walk(state from, std::string_view bytes) const noexcept -> state
+  {
+    return this->compiled.walk(from, bytes);
+  }
+
+  /*  Whether everything beneath the directory which was
+      walked to `at` is dropped. */
+  auto prunes(state at) const noexcept -> bool
+  {
+    return at == glob::pruned()
+        || this->compiled.decides(at, true) == glob::verdict::drop;
+  }
+
+  /*  Whether the path which was walked to `at` is kept. */
+  auto keeps(state at, enum event::kind kind) const noexcept -> bool
+  {
+    auto const v = this->compiled.decides(at, kind == event::kind::dir);
+    return (v == glob::verdict::none ? this->otherwise : v)
+        == glob::verdict::keep;
+  }
+
+  /*  Whether `path`, relative to the root, is kept. */
+  auto keeps(std::string_view path, enum event::kind kind) const noexcept
+    -> bool
+  {
+    return this->empty() || this->keeps(this->walk(start(), path), kind);
+  }
+};
+
+} /* namespace watcher */
+} /* namespace wtr   */
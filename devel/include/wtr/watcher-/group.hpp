@@ -0,0 +1,68 @@
+#pragma once
+
+/*  size_t */
+#include <cstddef>
+/*  vector */
+#include <vector>
+/*  watch
+    adapter */
+#include <wtr/watcher.hpp>
+
+namespace wtr {
+inline namespace watcher {
+
+/*  @brief wtr/watcher/group
+    Watchers which are closed together.
+
+    Closing a watcher waits for it to notice, which takes
+    as long as its policy's `delay_ms`, at most. Closing
+    watchers one after another waits that long for each.
+    A group tells every one of them to stop before it waits
+    for any, so they all notice at once, and closing a
+    thousand takes about as long as closing one.
+
+      auto g = group{};
+      for (auto const& p : paths) g.add(watch(p, callback));
+      auto closed = g.close();
+
+    A watcher in a group can still be closed on its own,
+    even from another thread while the group is closing.
+    Whichever of them stops it first waits for it. Closing
+    one twice, either way, does nothing the second time,
+    and says false. */
+class group {
+  std::vector<::detail::wtr::watcher::adapter::future::shared> members{};
+
+public:
+  template<class Fn>
+  auto add(_<Fn> const& watcher) -> group&
+  {
+    if (watcher.adapter) this->members.push_back(watcher.adapter);
+    return *this;
+  }
+
+  auto size() const noexcept -> std::size_t { return this->members.size(); }
+
+  /*  Stops every watcher in the group, then waits for them.
+      Returns whether they all stopped cleanly. The group
+      is empty afterwards. */
+  auto close() noexcept -> bool
+  {
+    using ::detail::wtr::watcher::adapter::join;
+    using ::detail::wtr::watcher::adapter::stop;
+    auto stopped = std::vector<bool>{};
+    for (auto const& m : this->members) stopped.push_back(stop(m));
+    /* Only what we stopped is ours to wait for. Whoever
+       stopped the others waits for them. */
+    auto ok = true;
+    for (auto n = std::size_t{0}; n < this->members.size(); ++n)
+      ok = stopped[n] && join(this->members[n]) && ok;
+    this->members.clear();
+    return ok;
+  }
+
+  auto operator()() noexcept -> bool { return this->close(); }
+};
+
+} /* namespace watcher */
+} /* namespace wtr */
@@ -0,0 +1,162 @@
+#pragma once
+
+/*  array */
+#include <array>
+/*  atomic
+    memory_order_relaxed */
+#include <atomic>
+/*  bit_width */
+#include <bit>
+/*  steady_clock
+    duration_cast */
+#include <chrono>
+/*  size_t */
+#include <cstddef>
+/*  uint64_t */
+#include <cstdint>
+
+namespace wtr {
+inline namespace watcher {
+
+/*  @brief wtr/watcher/metrics
+    What a watcher has done so far. Every watcher counts
+    as it goes, with relaxed atomics, and `snapshot` reads
+    the counts while it runs. The counts in a snapshot are
+    each up to date, but not necessarily with each other.
+
+    From `auto w = watch(...)`, `w.metrics()` is a snapshot.
+
+    - events
+        Events sent to the callback. (Batches aren't
+        counted as events.)
+    - reads
+        Calls to `read` on the kernel's queue, including
+        those which found nothing. (The polling adapter
+        counts its scans.)
+    - bytes_read
+        What those reads gave us.
+    - full_reads
+        Reads which (nearly) filled our buffer. Many of
+        these mean the kernel's queue is backing up, and a
+        bigger buffer (see `policy`) might help.
+    - overflows
+        Times the kernel's queue overflowed.
+    - marks
+        Directories we are watching now. (The polling
+        adapter counts the files it knows about.)
+    - callback_ns
+        How long the callback takes, in nanoseconds. One
+        event in every `callback_sample` is timed.
+    - read_events
+        Events sent from each read (or scan).
+
+    Histograms have a bucket for each power of two: bucket
+    `n` counts values which need `n` bits. */
+struct metrics {
+  static constexpr std::size_t bucket_count = 65;
+  static constexpr std::uint64_t callback_sample = 64;
+
+  /*  Adds to a counter. A watcher with many roots may
+      count from a thread for each of them (off Linux), so
+      this is a locked add, though a relaxed one. */
+  static auto add(std::atomic<std::uint64_t>& counter,
+                  std::uint64_t n = 1) noexcept -> void
+  {
+    counter.fetch_add(n, std::memory_order_relaxed);
+  }
+
+  struct histogram {
+    std::array<std::atomic<std::uint64_t>, bucket_count> buckets{};
+
+    auto record(std::uint64_t value) noexcept -> void
+    {
+      add(this->buckets[std::bit_width(value)]);
+    }
+  };
+
+  struct snapshot_type {
+    struct histogram {
+      std::array<std::uint64_t, bucket_count> buckets{};
+
+      auto count() const noexcept -> std::uint64_t
+      {
+        auto n = std::uint64_t{0};
+        for (auto b : this->buckets) n += b;
+        return n;
+      }
+
+      /*  An upper bound on the value which `q` (from 0 to 1)
+          of what was recorded are at or below, or 0. */
+      auto quantile(double q) const noexcept -> std::uint64_t
+      {
+        auto const total = this->count();
+        if (total == 0) return 0;
+        auto const want = q * (double)total;
+        auto seen = std::uint64_t{0};
+        for (std::size_t n = 0; n < bucket_count; ++n) {
+          seen += this->buckets[n];
+          if ((double)seen >= want && this->buckets[n] > 0)
+            return n == 0 ? 0
+                 : n >= 64 ? ~std::uint64_t{0}
+                           : (std::uint64_t{1} << n) - 1;
+        }
+        return ~std::uint64_t{0};
+      }
+    };
+
+    std::uint64_t events{};
+    std::uint64_t reads{};
+    std::uint64_t bytes_read{};
+    std::uint64_t full_reads{};
+    std::uint64_t overflows{};
+    std::uint64_t marks{};
+    histogram callback_ns{};
+    histogram read_events{};
+  };
+
+  std::atomic<std::uint64_t> events{};
+  std::atomic<std::uint64_t> reads{};
+  std::atomic<std::uint64_t> bytes_read{};
+  std::atomic<std::uint64_t> full_reads{};
+  std::atomic<std::uint64_t> overflows{};
+  std::atomic<std::uint64_t> marks{};
+  histogram callback_ns{};
+  histogram read_events{};
+
+  /*  Calls `send`, which sends an event, and counts it.
+      Every `callback_sample`th one is timed. */
+  template<class Send>
+  auto sent(Send const& send) noexcept -> void
+  {
+    using clock = std::chrono::steady_clock;
+
+    auto const n = this->events.fetch_add(1, std::memory_order_relaxed);
+    if (n % callback_sample != 0) return send();
+
+    auto const then = clock::now();
+    send();
+    this->callback_ns.record(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - then)
+        .count());
+  }
+
+  auto snapshot() const noexcept -> snapshot_type
+  {
+    constexpr auto r = std::memory_order_relaxed;
+    auto s = snapshot_type{};
+    s.events = this->events.load(r);
+    s.reads = this->reads.load(r);
+    s.bytes_read = this->bytes_read.load(r);
+    s.full_reads = this->full_reads.load(r);
+    s.overflows = this->overflows.load(r);
+    s.marks = this->marks.load(r);
+    for (std::size_t n = 0; n < bucket_count; ++n) {
+      s.callback_ns.buckets[n] = this->callback_ns.buckets[n].load(r);
+      s.read_events.buckets[n] = this->read_events.buckets[n].load(r);
+    }
+    return s;
+  }
+};
+
+} /* namespace watcher */
+} /* namespace wtr */
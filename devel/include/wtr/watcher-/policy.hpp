@@ -0,0 +1,75 @@
+#pragma once
+
+/*  event */
+#include <wtr/watcher-/event.hpp>
+/*  trace */
+#include <wtr/watcher-/trace.hpp>
+
+namespace wtr {
+inline namespace watcher {
+
+/*  @brief wtr/watcher/policy
+    What a watcher can be told when it is compiled, rather
+    than when it runs. A policy is a type: derive from this
+    one and hide whatever should be different.
+
+      struct quiet : policy {
+        static constexpr auto status = false;
+        static constexpr auto watches(enum event::what w) noexcept
+        { return w != event::what::modify; }
+      };
+      auto w = watch<quiet>(".", callback);
+
+    - buf_len
+        The size, in bytes, of the buffer which each read
+        from the kernel goes into. (Linux)
+    - wait_max
+        How many ready descriptors we take from one call
+        to `epoll_wait`. (Linux)
+    - delay_ms
+        How long we wait for something to happen before we
+        check whether we should stop. The polling adapter
+        sleeps this long between scans.
+    - clock
+        Where the time of each event comes from, unless the
+        watcher is given a clock.
+    - status
+        Whether the watcher tells us about itself: when it
+        is alive and dead (`s/...`) and what it couldn't
+        watch (`w/...`). Errors (`e/...`) are always sent.
+        Without status, none of those messages is made, and
+        the code which makes them isn't compiled.
+    - watches
+        Which changes are sent. The kernel isn't asked for
+        modifications unless they are watched. Whatever an
+        adapter needs to follow directories (such as their
+        creation) is always asked for, and what isn't
+        watched is dropped before it is sent.
+    - trace
+        Hooks for profilers, on the hot path. See `trace`.
+        The default does nothing, and costs nothing.
+    - sys
+        What the Linux adapters call to read from the kernel
+        and to mark directories. A policy needn't have one:
+        without it, they call the kernel. One which records
+        what the kernel says, and one which plays it back,
+        are in `<d>/adapter/linux/replay`.
+
+    The defaults are what a watcher does without a policy. */
+struct policy {
+  static constexpr auto buf_len = 4096;
+  static constexpr auto wait_max = 1;
+  static constexpr auto delay_ms = 16;
+  static constexpr auto clock = event::clock::system;
+  static constexpr auto status = true;
+
+  using trace = ::wtr::watcher::trace;
+
+  static constexpr auto watches(enum event::what) noexcept -> bool
+  {
+    return true;
+  }
+};
+
+} /* namespace watcher */
+} /* namespace wtr */
@@ -0,0 +1,118 @@
+#pragma once
+
+/*  size_t */
+#include <cstddef>
+/*  uint64_t */
+#include <cstdint>
+/*  path */
+#include <filesystem>
+/*  make_shared,
+    shared_ptr */
+#include <memory>
+/*  mutex,
+    scoped_lock */
+#include <mutex>
+/*  is_invocable_v */
+#include <type_traits>
+/*  vector */
+#include <vector>
+/*  stage::route */
+#include <detail/wtr/watcher/stage/route.hpp>
+/*  event */
+#include <wtr/watcher.hpp>
+
+namespace wtr {
+inline namespace watcher {
+
+/*  @brief wtr/watcher/router
+    A callback which sends each event on to those who
+    subscribed to a path it happened beneath, and to what
+    happened and the kind of path it happened to.
+
+    Giving every consumer every event, and having each
+    throw away what it doesn't want, takes as long as there
+    are consumers. A router keeps them in a tree of path
+    components, so an event is sent on after a walk as deep
+    as its path, past everyone who didn't want it.
+
+      auto r = router{};
+      auto w = watch("/srv", r);
+      auto id = r.subscribe("/srv/app/config", callback,
+                            {.what = {event::what::modify}});
+      r.unsubscribe(id);
+
+    Paths are matched as they are written, component by
+    component, so subscribe to them in the same form as the
+    watcher's path. Messages from the watcher go to everyone
+    whose mask has `kind::watcher`, which it does unless it
+    says what kinds it wants.
+
+    A router can be copied. The copies are the same router,
+    so one can be given to `watch` and the other kept to
+    subscribe with. Events are sent on while it is locked,
+    so a callback can't subscribe, or unsubscribe, through
+    the router which called it. */
+class router {
+public:
+  /*  What happened, and to which kinds of path, someone
+      wants to hear about. Anything, where they don't say. */
+  struct mask {
+    std::vector<enum event::what> what{};
+    std::vector<enum event::kind> kind{};
+  };
+
+private:
+  using route = ::detail::wtr::watcher::stage::route;
+
+  struct state {
+    mutable std::mutex lk{};
+    route routes{};
+  };
+
+  std::shared_ptr<state> self{std::make_shared<state>()};
+
+public:
+  /*  Subscribes `callback` to what happens beneath `path`,
+      which `wants` has. Gives back what the subscription is
+      known by, to `unsubscribe` with. */
+  template<class Callback>
+  requires(std::is_invocable_v<Callback const&, event const&>
+           or std::is_invocable_v<Callback const&, event::compact const&>)
+  auto subscribe(std::filesystem::path const& path,
+                 Callback const& callback,
+                 mask const& wants = {}) const noexcept -> std::uint64_t
+  {
+    auto each = event::compact::callback{};
+    if constexpr (std::is_invocable_v<Callback const&, event const&>)
+      each = [callback](event::compact const& e) { callback(event{e}); };
+    else
+      each = callback;
+
+    auto _ = std::scoped_lock{this->self->lk};
+    return this->self->routes.add(path.native(),
+                                  std::move(each),
+                                  route::mask::of(wants.what, wants.kind));
+  }
+
+  /*  Says false if there was no such subscription. */
+  auto unsubscribe(std::uint64_t id) const noexcept -> bool
+  {
+    auto _ = std::scoped_lock{this->self->lk};
+    return this->self->routes.remove(id);
+  }
+
+  auto size() const noexcept -> std::size_t
+  {
+    auto _ = std::scoped_lock{this->self->lk};
+    return this->self->routes.size();
+  }
+
+  auto operator()(event::compact const& e) const noexcept -> void
+  {
+    auto _ = std::scoped_lock{this->self->lk};
+    this->self->routes(e);
+  }
+};
+
+} /* namespace watcher */
+} /* namespace wtr */
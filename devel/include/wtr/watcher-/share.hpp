@@ -0,0 +1,132 @@
+#pragma once
+
+/*  uint64_t */
+#include <cstdint>
+/*  path */
+#include <filesystem>
+/*  is_invocable_v */
+#include <type_traits>
+/*  share::registry */
+#include <detail/wtr/watcher/share/registry.hpp>
+/*  event
+    filter
+    router
+    policy
+    adapter */
+#include <wtr/watcher.hpp>
+
+namespace wtr {
+inline namespace watcher {
+
+/*  @brief wtr/watcher/subscription
+    A way to close a shared watch. See `share`.
+
+    Closing one twice does nothing the second time, and
+    says false. */
+struct subscription {
+  std::uint64_t const id{};
+  bool (*const leave)(std::uint64_t) noexcept {};
+
+  inline auto close() const noexcept -> bool
+  {
+    return this->leave && this->leave(this->id);
+  };
+
+  inline auto operator()() const noexcept -> bool { return this->close(); };
+};
+
+/*  @brief wtr/watcher/share
+    Watches `path`, as `watch` does, but with the one
+    watcher this process shares among everything which
+    `share`s.
+
+    Parts of a program which don't know about each other
+    may watch the same trees, or trees inside each other,
+    such as `/srv/app` and `/srv/app/config`. With `watch`,
+    each of them has its own kernel instance, its own marks
+    on every directory and its own thread. With `share`,
+    they have one of each, and the marks are made once, for
+    the shallowest of the trees. Each is sent the events
+    beneath its own path, which its filter keeps (relative
+    to that path). The watcher is opened for the first one,
+    and closed when the last one is.
+
+    auto app = share("/srv/app", callback);
+    auto config = share("/srv/app/config", filter{"*.toml"}, other);
+    app.close(); // `config` keeps watching, without a gap
+
+    Events are sent from the watcher's thread, to one
+    callback after another. A callback can't open or close
+    a shared watch. Whether the watcher is alive isn't sent:
+    it changes what it is watching as others come and go.
+    Its warnings and errors are, to everyone they are about.
+
+    Shared watches with a different `Policy` share another
+    watcher, among themselves.
+
+    Events find the watches they are for by their path, so
+    sending one takes about as long with a thousand shared
+    watches as with one. See `router`. A watch can also ask
+    for only some of what happens, to some kinds of path:
+
+    auto s = share("/srv/app", filter{},
+                   {.what = {event::what::create}}, callback); */
+template<class Policy = policy, class Callback>
+requires(std::is_invocable_v<Callback const&, event const&>
+         or std::is_invocable_v<Callback const&, event::compact const&>)
+[[nodiscard("Returns a way to close this watch, for example: "
+            "auto s = share(p, f, m, cb) ; s.close() // or s();")]]
+
+inline auto
+share(std::filesystem::path const& path,
+      filter const& filter,
+      router::mask const& wants,
+      Callback const& callback) noexcept -> subscription
+{
+  using registry = ::detail::wtr::watcher::share::registry<Policy>;
+
+  auto each = event::compact::callback{};
+  if constexpr (std::is_invocable_v<Callback const&, event const&>)
+    each = [callback](event::compact const& e) { callback(event{e}); };
+  else
+    each = callback;
+
+  return {
+    registry::instance().join(
+      path,
+      filter,
+      each,
+      ::detail::wtr::watcher::adapter::diags_of(callback),
+      ::detail::wtr::watcher::stage::route::mask::of(wants.what, wants.kind)),
+    [](std::uint64_t id) noexcept { return registry::instance().leave(id); }};
+};
+
+template<class Policy = policy, class Callback>
+requires(std::is_invocable_v<Callback const&, event const&>
+         or std::is_invocable_v<Callback const&, event::compact const&>)
+[[nodiscard("Returns a way to close this watch, for example: "
+            "auto s = share(p, cb) ; s.close() // or s();")]]
+
+inline auto
+share(std::filesystem::path const& path,
+      filter const& filter,
+      Callback const& callback) noexcept -> subscription
+{
+  return share<Policy>(path, filter, {}, callback);
+};
+
+template<class Policy = policy, class Callback>
+requires(std::is_invocable_v<Callback const&, event const&>
+         or std::is_invocable_v<Callback const&, event::compact const&>)
+[[nodiscard("Returns a way to close this watch, for example: "
+            "auto s = share(p, cb) ; s.close() // or s();")]]
+
+inline auto
+share(std::filesystem::path const& path, Callback const& callback) noexcept
+  -> subscription
+{
+  return share<Policy>(path, filter{}, {}, callback);
+};
+
+} /* namespace watcher */
+} /* namespace wtr   */
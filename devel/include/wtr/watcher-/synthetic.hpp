@@ -0,0 +1,75 @@
+#pragma once
+
+/*  size_t */
+#include <cstddef>
+/*  uint64_t */
+#include <cstdint>
+
+namespace wtr {
+inline namespace watcher {
+
+/*  @brief wtr/watcher/synthetic
+    A stream of made up events, for measuring everything
+    after the kernel: filters, collapsing and coalescing,
+    the callback and whatever it does. Nothing is read from
+    the kernel and nothing on disk is touched. The paths are
+    beneath the path being watched, which needn't exist.
+
+      auto w = watch(".", synthetic{.rate = 1e6, .skew = 1}, callback);
+
+    Or, with `WATER_WATCHER_USE_SYNTHETIC` defined, every
+    watcher is synthetic, and its stream is its policy's
+    `synthetic`, if it has one, or this one as it is.
+
+    - rate
+        Events per second, or 0 for as many as we can make.
+    - count
+        How many to make before stopping, or 0 for as many
+        as we can until the watcher is closed.
+    - files, dirs, depth
+        How many files there are, spread over how many
+        directories, each this many directories deep. Files
+        end in `.txt`, `.cpp`, `.hpp` or `.o`, in turn.
+    - skew
+        How some files are changed more than others: 0 for
+        all the same, or the exponent of a Zipf distribution,
+        where 1 is what a source tree under an editor and a
+        build looks like, and more is hotter still.
+    - shape, burst, pause_ms
+        How events are spaced: `steady`ly; in `bursts` of
+        `burst` events, at `rate`, with `pause_ms` between
+        them; or as a `poisson` process at `rate`.
+    - create, modify, destroy, rename
+        How often, relative to each other, each happens.
+    - seed
+        The same seed makes the same stream.
+
+    Events are stamped once for each `chunk` of them, like
+    those from one read of the kernel's queue. */
+struct synthetic {
+  enum class shape : unsigned char {
+    steady,
+    bursts,
+    poisson,
+  };
+
+  static constexpr std::size_t chunk = 256;
+
+  double rate{0};
+  std::uint64_t count{0};
+  std::size_t files{4096};
+  std::size_t dirs{64};
+  std::size_t depth{2};
+  double skew{0};
+  enum shape shape { shape::steady };
+  std::size_t burst{1000};
+  unsigned pause_ms{10};
+  unsigned create{1};
+  unsigned modify{6};
+  unsigned destroy{1};
+  unsigned rename{1};
+  std::uint64_t seed{1};
+};
+
+} /* namespace watcher */
+} /* namespace wtr */
@@ -0,0 +1,155 @@
+#pragma once
+
+/*  steady_clock
+    duration_cast */
+#include <chrono>
+/*  size_t */
+#include <cstddef>
+/*  path */
+#include <filesystem>
+/*  event */
+#include <wtr/watcher-/event.hpp>
+
+#if defined(WATER_WATCHER_USE_USDT)
+/*  DTRACE_PROBE* */
+#include <sys/sdt.h>
+#endif
+
+namespace wtr {
+inline namespace watcher {
+
+/*  @brief wtr/watcher/trace
+    Hooks on the watcher's hot path, for profilers. A trace
+    is a type, given to the watcher through its policy. Each
+    hook is a static function, and this one's do nothing.
+    Derive from it, hide whichever hooks you want and turn
+    it `on`:
+
+      struct timed : trace {
+        static constexpr auto on = true;
+        static auto read(long long bytes, long long ns) noexcept
+        { ... }
+      };
+      struct traced : policy { using trace = timed; };
+      auto w = watch<traced>(".", callback);
+
+    Unless a trace is `on`, nothing is timed, and the hooks
+    are empty and inlined away. The watcher compiles to the
+    same thing with this trace as without any.
+
+    - read
+        After each read from the kernel, with what it gave
+        us (0, or less on an error) and how long it took.
+        (Linux)
+    - decoded
+        For each event we make sense of, whether or not it
+        is sent, with the length of its name or path.
+    - send_begin, send_end
+        Before and after the callback is given an event,
+        with how long it took.
+    - mark, unmark
+        When we start or stop watching a directory (or, for
+        the polling adapter, nothing), and whether we could.
+    - walk_begin, walk_end
+        Around each walk through the tree, when we start
+        watching and when a `.gitignore` changes, with how
+        many directories (or, for the polling adapter, files)
+        we know of after it and how long it took.
+
+    Durations are in nanoseconds, from a steady clock. The
+    hooks are called from the watcher's own thread, so they
+    should be quick, and must not throw.
+
+    With `WATER_WATCHER_USE_USDT` defined, `usdt` is a trace
+    which fires a USDT probe (`wtr_watcher:<hook>`) for each
+    hook, for `bpftrace`, `perf` and friends. It needs
+    `<sys/sdt.h>`. */
+struct trace {
+  static constexpr auto on = false;
+
+  static auto now() noexcept -> long long
+  {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+  }
+
+  static auto read(long long, long long) noexcept -> void {}
+
+  static auto
+  decoded(enum event::what, enum event::kind, std::size_t) noexcept -> void
+  {}
+
+  static auto send_begin(enum event::what, enum event::kind) noexcept -> void
+  {}
+
+  static auto send_end(long long) noexcept -> void {}
+
+  static auto mark(std::filesystem::path const&, bool) noexcept -> void {}
+
+  static auto unmark(std::filesystem::path const&, bool) noexcept -> void {}
+
+  static auto walk_begin(std::filesystem::path const&) noexcept -> void {}
+
+  static auto
+  walk_end(std::filesystem::path const&, std::size_t, long long) noexcept
+    -> void
+  {}
+};
+
+#if defined(WATER_WATCHER_USE_USDT)
+
+struct usdt : trace {
+  static constexpr auto on = true;
+
+  static auto read(long long bytes, long long ns) noexcept -> void
+  {
+    DTRACE_PROBE2(wtr_watcher, read, bytes, ns);
+  }
+
+  static auto decoded(enum event::what what,
+                      enum event::kind kind,
+                      std::size_t len) noexcept -> void
+  {
+    DTRACE_PROBE3(wtr_watcher, decoded, (int)what, (int)kind, len);
+  }
+
+  static auto send_begin(enum event::what what, enum event::kind kind) noexcept
+    -> void
+  {
+    DTRACE_PROBE2(wtr_watcher, send_begin, (int)what, (int)kind);
+  }
+
+  static auto send_end(long long ns) noexcept -> void
+  {
+    DTRACE_PROBE1(wtr_watcher, send_end, ns);
+  }
+
+  static auto mark(std::filesystem::path const& dir, bool ok) noexcept -> void
+  {
+    DTRACE_PROBE2(wtr_watcher, mark, dir.c_str(), (int)ok);
+  }
+
+  static auto unmark(std::filesystem::path const& dir, bool ok) noexcept
+    -> void
+  {
+    DTRACE_PROBE2(wtr_watcher, unmark, dir.c_str(), (int)ok);
+  }
+
+  static auto walk_begin(std::filesystem::path const& root) noexcept -> void
+  {
+    DTRACE_PROBE1(wtr_watcher, walk_begin, root.c_str());
+  }
+
+  static auto walk_end(std::filesystem::path const& root,
+                       std::size_t marks,
+                       long long ns) noexcept -> void
+  {
+    DTRACE_PROBE3(wtr_watcher, walk_end, root.c_str(), marks, ns);
+  }
+};
+
+#endif
+
+} /* namespace watcher */
+} /* namespace wtr */
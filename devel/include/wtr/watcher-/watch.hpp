@@ -4,11 +4,23 @@
 #include <filesystem>
 /*  function */
 #include <functional>
+/*  shared_ptr */
+#include <memory>
+/*  optional */
+#include <optional>
+/*  uint32_t */
+#include <cstdint>
+/*  move */
+#include <utility>
+/*  vector */
+#include <vector>
 /*  is_*,
     invoke_result */
 #include <type_traits>
 /*  event
     callback
+    filter
+    synthetic
     adapter */
 #include <wtr/watcher.hpp>
 
@@ -24,7 +36,19 @@ inline namespace watcher {
     we can't template a type inside a function.
 
     This thing is similar to an unnamed function object
-    containing a named method. */
+    containing a named method.
+
+    It also has a way to see what the watcher has done so
+    far, with `.metrics()`. See `metrics`.
+
+    It keeps the watcher's `adapter`, so that a `group` can
+    stop it along with others. See `group`.
+
+    Roots can be added to, and removed from, the watcher
+    while it runs, with `.add_path()` and `.remove_path()`.
+    Adding gives back the new root's place among the roots,
+    which its events say in `root`. Nothing else is watched
+    again, or stops being watched, when they change. */
 
 template<class Fn>
 requires(std::is_nothrow_invocable_v<Fn>
@@ -32,17 +56,61 @@ requires(std::is_nothrow_invocable_v<Fn>
 struct _ {
   Fn const close{};
 
+  std::shared_ptr<::wtr::watcher::metrics const> const counts{};
+
+  ::detail::wtr::watcher::adapter::future::shared const adapter{};
+
   inline constexpr auto operator()() const noexcept -> bool
   {
     return this->close();
   };
 
-  inline constexpr _(Fn&& fn) noexcept
-      : close{std::forward<Fn>(fn)} {};
+  inline auto metrics() const noexcept
+    -> ::wtr::watcher::metrics::snapshot_type
+  {
+    return this->counts ? this->counts->snapshot()
+                        : ::wtr::watcher::metrics::snapshot_type{};
+  };
+
+  inline auto add_path(std::filesystem::path const& path) const noexcept
+    -> std::optional<std::uint32_t>
+  {
+    return this->adapter ? ::detail::wtr::watcher::adapter::add(this->adapter,
+                                                                 path)
+                         : std::nullopt;
+  };
+
+  inline auto remove_path(std::filesystem::path const& path) const noexcept
+    -> bool
+  {
+    return this->adapter
+        && ::detail::wtr::watcher::adapter::remove(this->adapter, path);
+  };
+
+  inline constexpr _(
+    Fn&& fn,
+    std::shared_ptr<::wtr::watcher::metrics const> counts = {},
+    ::detail::wtr::watcher::adapter::future::shared adapter = {}) noexcept
+      : close{std::forward<Fn>(fn)}
+      , counts{std::move(counts)}
+      , adapter{std::move(adapter)} {};
 
   inline constexpr ~_() = default;
 };
 
+/*  How every `watch()` makes its `_`. There is one of these,
+    so every watcher has the same type, whichever callback
+    (or filter) it was given. */
+inline auto
+_from(::detail::wtr::watcher::adapter::future::shared adapter) noexcept
+{
+  return _{[adapter]() noexcept -> bool
+           { return ::detail::wtr::watcher::adapter::close(adapter); },
+           std::shared_ptr<::wtr::watcher::metrics const>{adapter,
+                                                          &adapter->counts},
+           adapter};
+}
+
 /*  @brief wtr/watcher/watch
 
     Returns an asyncronous filesystem watcher as a function
@@ -58,6 +126,16 @@ struct _ {
       Something (such as a closure) to be called when events
       occur in the path being watched.
 
+    @param clock (optional):
+      Where the time of each event comes from. The system
+      clock, by default. See `event::clock`.
+
+    @param Policy (optional):
+      What the watcher is told when it is compiled, such
+      as the size of its buffers and which changes it
+      sends. Given as `watch<Policy>(path, callback)`. See
+      `policy`.
+
     This is an adaptor "switch" that chooses the ideal adaptor
     for the host platform.
 
@@ -86,17 +164,244 @@ struct _ {
 
     Happy hacking. */
 
+template<class Policy = policy>
+[[nodiscard("Returns a way to stop this watcher, for example: "
+            "auto w = watch(p, cb) ; w.close() // or w();")]]
+
+inline auto
+watch(std::filesystem::path const& path,
+      event::callback const& callback,
+      enum event::clock clock = Policy::clock) noexcept
+{
+  using namespace ::detail::wtr::watcher::adapter;
+
+  return _from(open<Policy>(path, filter{}, callback, clock));
+};
+
+/*  @brief wtr/watcher/watch
+    Same as above, but only for the paths which `filter`
+    keeps. Paths are matched relative to `path`.
+
+    auto w = watch(".", filter{"*.cpp", "*.hpp"}, callback); */
+
+template<class Policy = policy>
+[[nodiscard("Returns a way to stop this watcher, for example: "
+            "auto w = watch(p, f, cb) ; w.close() // or w();")]]
+
+inline auto
+watch(std::filesystem::path const& path,
+      filter const& filter,
+      event::callback const& callback,
+      enum event::clock clock = Policy::clock) noexcept
+{
+  using namespace ::detail::wtr::watcher::adapter;
+
+  return _from(open<Policy>(path, filter, callback, clock));
+};
+
+/*  @brief wtr/watcher/watch
+    Same as above, for callbacks which aren't a
+    `std::function`, such as lambdas. The callback keeps
+    its own type all the way to the adapter, which calls
+    it directly, so a small one can be inlined into the
+    loop which reads events. (On Linux. Elsewhere, it is
+    kept in an `event::callback`.) Pass an `event::callback`
+    to use the overloads above instead. */
+
+template<class Policy = policy, class Callback>
+requires(std::is_invocable_v<Callback const&, event const&>
+         and not std::is_same_v<Callback, event::callback>)
+[[nodiscard("Returns a way to stop this watcher, for example: "
+            "auto w = watch(p, cb) ; w.close() // or w();")]]
+
+inline auto
+watch(std::filesystem::path const& path,
+      Callback const& callback,
+      enum event::clock clock = Policy::clock) noexcept
+{
+  using namespace ::detail::wtr::watcher::adapter;
+
+  return _from(open<Policy>(path, filter{}, callback, clock));
+};
+
+template<class Policy = policy, class Callback>
+requires(std::is_invocable_v<Callback const&, event const&>
+         and not std::is_same_v<Callback, event::callback>)
+[[nodiscard("Returns a way to stop this watcher, for example: "
+            "auto w = watch(p, f, cb) ; w.close() // or w();")]]
+
+inline auto
+watch(std::filesystem::path const& path,
+      filter const& filter,
+      Callback const& callback,
+      enum event::clock clock = Policy::clock) noexcept
+{
+  using namespace ::detail::wtr::watcher::adapter;
+
+  return _from(open<Policy>(path, filter, callback, clock));
+};
+
+/*  @brief wtr/watcher/watch
+    Same as above, but `callback` is given compact events,
+    which view their paths instead of owning them. Nothing
+    is allocated for them on Linux. Copy a path out (or make
+    an `event` from it) if it needs to outlive the callback.
+
+    auto w = watch(".", [](event::compact const& e) {
+      std::cout << e.where << "\n";
+    }); */
+
+template<class Policy = policy, class Callback>
+requires(std::is_invocable_v<Callback const&, event::compact const&>
+         and not std::is_invocable_v<Callback const&, event const&>)
+[[nodiscard("Returns a way to stop this watcher, for example: "
+            "auto w = watch(p, cb) ; w.close() // or w();")]]
+
+inline auto
+watch(std::filesystem::path const& path,
+      Callback const& callback,
+      enum event::clock clock = Policy::clock) noexcept
+{
+  using namespace ::detail::wtr::watcher::adapter;
+
+  return _from(open<Policy>(path, filter{}, callback, clock));
+};
+
+template<class Policy = policy, class Callback>
+requires(std::is_invocable_v<Callback const&, event::compact const&>
+         and not std::is_invocable_v<Callback const&, event const&>)
+[[nodiscard("Returns a way to stop this watcher, for example: "
+            "auto w = watch(p, f, cb) ; w.close() // or w();")]]
+
+inline auto
+watch(std::filesystem::path const& path,
+      filter const& filter,
+      Callback const& callback,
+      enum event::clock clock = Policy::clock) noexcept
+{
+  using namespace ::detail::wtr::watcher::adapter;
+
+  return _from(open<Policy>(path, filter, callback, clock));
+};
+
+/*  @brief wtr/watcher/watch
+    Same as above, but `callback` is given a view of each
+    read from the kernel, which is decoded as it is looked
+    at. See `batch`. There is no filter for batches: they
+    are what the kernel gave us.
+
+    auto w = watch(".", [](batch const& b) {
+      for (auto e : b) std::cout << e.name() << "\n";
+    }); */
+
+template<class Policy = policy, class Callback>
+requires(std::is_invocable_v<Callback, batch const&>
+         and not std::is_invocable_v<Callback, event const&>)
 [[nodiscard("Returns a way to stop this watcher, for example: "
             "auto w = watch(p, cb) ; w.close() // or w();")]]
 
 inline auto
 watch(std::filesystem::path const& path,
-      event::callback const& callback) noexcept
+      Callback const& callback,
+      enum event::clock clock = Policy::clock) noexcept
+{
+  using namespace ::detail::wtr::watcher::adapter;
+
+  return _from(open<Policy>(path, filter{}, callback, clock));
+};
+
+/*  @brief wtr/watcher/watch
+    Same as above, for many paths at once, with one watcher.
+    On Linux, they share one kernel instance (and thread),
+    so a few hundred of them don't run into the limit on
+    how many of those we may have. Each event's `root` is
+    the place, in `roots`, of the path it happened beneath.
+    The filter is matched relative to each of them. The
+    callback can be any of the above, but one for batches
+    can't be given a filter.
+
+    auto const roots = std::vector<std::filesystem::path>{"a", "b"};
+    auto w = watch(roots, [&](event const& e) {
+      std::cout << roots[e.root] << ": " << e.where << "\n";
+    });
+
+    Where they overlap, an event is sent once, for the
+    deepest of them. Elsewhere, each path is watched on its
+    own thread, and its events are stamped the same way.
+    Either way, the callback is called from one thread at a
+    time, and needs no lock of its own for that. */
+template<class Policy = policy, class Callback>
+[[nodiscard("Returns a way to stop this watcher, for example: "
+            "auto w = watch(ps, cb) ; w.close() // or w();")]]
+
+inline auto
+watch(std::vector<std::filesystem::path> const& roots,
+      Callback const& callback,
+      enum event::clock clock = Policy::clock) noexcept
+{
+  using namespace ::detail::wtr::watcher::adapter;
+
+  return _from(open<Policy>(roots, filter{}, callback, clock));
+};
+
+template<class Policy = policy, class Callback>
+requires(std::is_invocable_v<Callback const&, event const&>
+         or std::is_invocable_v<Callback const&, event::compact const&>)
+[[nodiscard("Returns a way to stop this watcher, for example: "
+            "auto w = watch(ps, f, cb) ; w.close() // or w();")]]
+
+inline auto
+watch(std::vector<std::filesystem::path> const& roots,
+      filter const& filter,
+      Callback const& callback,
+      enum event::clock clock = Policy::clock) noexcept
+{
+  using namespace ::detail::wtr::watcher::adapter;
+
+  return _from(open<Policy>(roots, filter, callback, clock));
+};
+
+/*  @brief wtr/watcher/watch
+    Same as above, but the events are made up, as `stream`
+    describes, beneath `path`, instead of read from the
+    kernel. The callback can be any of the above. Which
+    watcher to make can be decided when we run: both have
+    the same type. See `synthetic`. Here too, a callback
+    for batches can't be given a filter.
+
+    auto w = fake ? watch(".", synthetic{.rate = 1e6}, callback)
+                  : watch(".", callback); */
+template<class Policy = policy, class Callback>
+[[nodiscard("Returns a way to stop this watcher, for example: "
+            "auto w = watch(p, s, cb) ; w.close() // or w();")]]
+
+inline auto
+watch(std::filesystem::path const& path,
+      synthetic const& stream,
+      Callback const& callback,
+      enum event::clock clock = Policy::clock) noexcept
+{
+  using namespace ::detail::wtr::watcher::adapter;
+
+  return _from(open<Policy>(path, filter{}, callback, clock, stream));
+};
+
+template<class Policy = policy, class Callback>
+requires(std::is_invocable_v<Callback const&, event const&>
+         or std::is_invocable_v<Callback const&, event::compact const&>)
+[[nodiscard("Returns a way to stop this watcher, for example: "
+            "auto w = watch(p, f, s, cb) ; w.close() // or w();")]]
+
+inline auto
+watch(std::filesystem::path const& path,
+      filter const& filter,
+      synthetic const& stream,
+      Callback const& callback,
+      enum event::clock clock = Policy::clock) noexcept
 {
   using namespace ::detail::wtr::watcher::adapter;
 
-  return _{[adapter{open(path, callback)}]() noexcept -> bool
-           { return close(adapter); }};
+  return _from(open<Policy>(path, filter, callback, clock, stream));
 };
 
 } /* namespace watcher */
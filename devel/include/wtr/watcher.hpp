@@ -10,13 +10,39 @@
 /* clang-format off */
 #include <detail/wtr/watcher/platform.hpp>
 #include <wtr/watcher-/event.hpp>
+#include <wtr/watcher-/trace.hpp>
+#include <wtr/watcher-/policy.hpp>
+#include <wtr/watcher-/diag.hpp>
+#include <wtr/watcher-/metrics.hpp>
+#include <wtr/watcher-/batch.hpp>
+#include <wtr/watcher-/synthetic.hpp>
+#include <detail/wtr/watcher/filter/glob.hpp>
+#include <detail/wtr/watcher/filter/gitignore.hpp>
+#include <wtr/watcher-/filter.hpp>
+#include <detail/wtr/watcher/adapter/change.hpp>
+#include <detail/wtr/watcher/adapter/linux/sink.hpp>
 #include <detail/wtr/watcher/adapter/windows/watch.hpp>
 #include <detail/wtr/watcher/adapter/darwin/watch.hpp>
 #include <detail/wtr/watcher/adapter/linux/fanotify/watch.hpp>
 #include <detail/wtr/watcher/adapter/linux/inotify/watch.hpp>
 #include <detail/wtr/watcher/adapter/linux/watch.hpp>
+#include <detail/wtr/watcher/adapter/linux/replay.hpp>
 #include <detail/wtr/watcher/adapter/android/watch.hpp>
 #include <detail/wtr/watcher/adapter/warthog/watch.hpp>
+#include <detail/wtr/watcher/adapter/synthetic/watch.hpp>
 #include <detail/wtr/watcher/adapter/adapter.hpp>
 #include <wtr/watcher-/watch.hpp>
+#include <wtr/watcher-/group.hpp>
+#include <detail/wtr/watcher/stage/route.hpp>
+#include <wtr/watcher-/router.hpp>
+#include <detail/wtr/watcher/share/registry.hpp>
+#include <wtr/watcher-/share.hpp>
+#include <detail/wtr/watcher/stage/ticker.hpp>
+#include <detail/wtr/watcher/stage/collapse.hpp>
+#include <wtr/watcher-/collapse.hpp>
+#include <detail/wtr/watcher/stage/wheel.hpp>
+#include <detail/wtr/watcher/stage/coalesce.hpp>
+#include <wtr/watcher-/coalesce.hpp>
+#include <detail/wtr/watcher/stage/atomic_save.hpp>
+#include <wtr/watcher-/atomic_save.hpp>
 /* clang-format on */
@@ -107,15 +107,24 @@ inline constexpr platform_type platform
 /* std::basic_ostream */
 #include <ios>
 /* std::chrono::system_clock::now
+   std::chrono::steady_clock::now
    std::chrono::duration_cast
-   std::chrono::system_clock
-   std::chrono::nanoseconds
-   std::chrono::time_point */
+   std::chrono::nanoseconds */
 #include <chrono>
+/* clock_gettime
+   timespec
+   CLOCK_*_COARSE */
+#include <time.h>
+/* std::uint32_t */
+#include <cstdint>
 /* std::filesystem::path */
 #include <filesystem>
 /* std::function */
 #include <functional>
+/* std::basic_string_view */
+#include <string_view>
+/* std::is_trivially_copyable_v */
+#include <type_traits>
 
 namespace wtr {
 inline namespace watcher {
@@ -146,12 +155,26 @@ inline namespace watcher {
         - destroy
         - owner
         - other
-      - Event time in nanoseconds since epoch
+      - Event time in nanoseconds, since the epoch of the
+        clock it was read from
+      - Which clock that was, one of:
+        - system
+        - realtime_coarse
+        - monotonic_coarse
+        - none
+      - Which of the watcher's roots it happened beneath,
+        by its place among them (always 0 for a watcher
+        of one path)
 
     The `watcher` type is special.
     Events with this type will include messages from
     the watcher. You may recieve error messages or
-    important status updates.  */
+    important status updates.
+
+    Each `event` owns its path, which is (usually) an
+    allocation. An `event::compact` doesn't: it is a view
+    of a path which the adapter owns, and can be made into
+    an `event` when the path needs to outlive the callback. */
 
 struct event {
 
@@ -161,8 +184,6 @@ private:
      'event kind' */
   using path_type = std::filesystem::path;
   using ns = std::chrono::nanoseconds;
-  using clock = std::chrono::system_clock;
-  using time_point = std::chrono::time_point<clock>;
 
 public:
   /*  @brief watcher/event/callback
@@ -200,14 +221,125 @@ public:
     other,
   };
 
+  /*  @brief wtr/watcher/event/clock
+      Where an event's time came from.
+      - system
+          The system clock, read for each event (as it
+          always has been) or, on Linux, for each read from
+          the kernel. Nanoseconds since the Unix epoch.
+      - realtime_coarse
+          The same, but only as fine as the last tick of
+          the kernel (a few milliseconds), which is much
+          cheaper to read. Linux only: elsewhere, the same
+          as `system`.
+      - monotonic_coarse
+          A coarse clock which never goes backwards, counted
+          from some point (usually boot). Only meaningful
+          against other times from the same clock. Linux
+          only: elsewhere, a steady clock.
+      - none
+          Not read at all. The time is zero. */
+  enum class clock {
+    system,
+    realtime_coarse,
+    monotonic_coarse,
+    none,
+  };
+
+  /*  @brief wtr/watcher/event/now
+      The time, from `clock`, in nanoseconds. */
+  static auto now(enum clock clock) noexcept -> long long
+  {
+    using std::chrono::duration_cast;
+    auto const since = [](auto t) noexcept -> long long
+    { return duration_cast<ns>(t.time_since_epoch()).count(); };
+#if defined(CLOCK_REALTIME_COARSE) && defined(CLOCK_MONOTONIC_COARSE)
+    auto const coarse = [](clockid_t id) noexcept -> long long
+    {
+      auto ts = timespec{};
+      clock_gettime(id, &ts);
+      return ts.tv_sec * 1'000'000'000ll + ts.tv_nsec;
+    };
+#endif
+    switch (clock) {
+      case clock::system : return since(std::chrono::system_clock::now());
+#if defined(CLOCK_REALTIME_COARSE) && defined(CLOCK_MONOTONIC_COARSE)
+      case clock::realtime_coarse  : return coarse(CLOCK_REALTIME_COARSE);
+      case clock::monotonic_coarse : return coarse(CLOCK_MONOTONIC_COARSE);
+#else
+      case clock::realtime_coarse :
+        return since(std::chrono::system_clock::now());
+      case clock::monotonic_coarse :
+        return since(std::chrono::steady_clock::now());
+#endif
+      case clock::none : return 0;
+      default          : return 0;
+    }
+  }
+
+  /*  @brief wtr/watcher/event/compact
+      An event which views its path instead of owning it.
+      The view is good until the callback returns. Copying
+      one (or a vector of them) copies a few words.
+
+      The adapters make these from their own buffers, so
+      none of them allocates. On Linux, that is what the
+      adapters send, and an `event` is made from them only
+      for callbacks which take one. */
+  struct compact {
+    using view_type = std::basic_string_view<path_type::value_type>;
+
+    /*  @brief watcher/event/compact/callback
+        A callback which is given compact events. */
+    using callback = std::function<void(compact const&)>;
+
+    view_type where{};
+
+    enum what what {};
+
+    enum kind kind {};
+
+    long long when{now(clock::system)};
+
+    enum clock clock {};
+
+    std::uint32_t root{};
+
+    compact() noexcept = default;
+
+    compact(view_type where, enum what what, enum kind kind) noexcept
+        : where{where},
+          what{what},
+          kind{kind} {};
+
+    compact(view_type where,
+            enum what what,
+            enum kind kind,
+            long long when,
+            enum clock clock = clock::system,
+            std::uint32_t root = 0) noexcept
+        : where{where},
+          what{what},
+          kind{kind},
+          when{when},
+          clock{clock},
+          root{root} {};
+
+    /*  Views an event's path. */
+    explicit compact(event const& from) noexcept;
+  };
+
   path_type const where{};
 
   enum what const what {};
 
   enum kind const kind {};
 
-  long long const when{
-    duration_cast<ns>(time_point{clock::now()}.time_since_epoch()).count()};
+  long long const when{now(clock::system)};
+
+  enum clock const clock {};
+
+  std::uint32_t const root{};
 
   event(std::filesystem::path const& where,
         enum what const& what,
@@ -216,9 +348,43 @@ public:
         what{what},
         kind{kind} {};
 
+  /*  Keeps the time of an event which happened earlier,
+      such as one which was held back and then let go. */
+  event(std::filesystem::path const& where,
+        enum what const& what,
+        enum kind const& kind,
+        long long const& when,
+        enum clock const& clock = clock::system,
+        std::uint32_t root = 0) noexcept
+      : where{where},
+        what{what},
+        kind{kind},
+        when{when},
+        clock{clock},
+        root{root} {};
+
+  /*  Copies the path out of a compact event. */
+  explicit event(compact const& from) noexcept
+      : where{from.where},
+        what{from.what},
+        kind{from.kind},
+        when{from.when},
+        clock{from.clock},
+        root{from.root} {};
+
   ~event() noexcept = default;
 };
 
+inline event::compact::compact(event const& from) noexcept
+    : where{from.where.native()},
+      what{from.what},
+      kind{from.kind},
+      when{from.when},
+      clock{from.clock},
+      root{from.root} {};
+
+static_assert(std::is_trivially_copyable_v<event::compact>);
+
 /*  @brief wtr/watcher/event/<<
     Streams out a `what` value. */
 template<class Char, class CharTraits>
@@ -281,9 +447,19 @@ inline constexpr auto operator<<(std::basic_ostream<Char, CharTraits>& os,
   /* clang-format on */
 };
 
+/*  @brief wtr/watcher/event/compact/<<
+    Streams out a compact event, as above. */
+template<class Char, class CharTraits>
+inline auto operator<<(std::basic_ostream<Char, CharTraits>& os,
+                       event::compact const& ev) noexcept
+  -> std::basic_ostream<Char, CharTraits>&
+{
+  return os << event{ev};
+};
+
 /*  @brief wtr/watcher/event/==
     A "strict" comparison of an event's `when`,
-    `where`, `what` and `kind` values.
+    `where`, `what`, `kind` and `root` values.
     Keep in mind that this compares `when`,
     which might not be desireable. */
 inline auto operator==(event const& l, event const& r) noexcept -> bool
@@ -292,7 +468,8 @@ inline auto operator==(event const& l, event const& r) noexcept -> bool
   return l.where == r.where
       && l.what  == r.what
       && l.kind  == r.kind
-      && l.when  == r.when;
+      && l.when  == r.when
+      && l.root  == r.root;
   /* clang-format on */
 };
 
@@ -306,2165 +483,8688 @@ inline auto operator!=(event const& l, event const& r) noexcept -> bool
 } /* namespace watcher */
 } /* namespace wtr   */
 
-/*
-  @brief watcher/adapter/windows
+/*  steady_clock
+    duration_cast */
+#include <chrono>
+/*  size_t */
+#include <cstddef>
+/*  path */
+#include <filesystem>
+/*  event */
 
-  The Windows `ReadDirectoryChangesW` adapter.
-*/
+#if defined(WATER_WATCHER_USE_USDT)
+/*  DTRACE_PROBE* */
+#include <sys/sdt.h>
+#endif
 
+namespace wtr {
+inline namespace watcher {
 
-#if defined(WATER_WATCHER_PLATFORM_WINDOWS_ANY)
+/*  @brief wtr/watcher/trace
+    Hooks on the watcher's hot path, for profilers. A trace
+    is a type, given to the watcher through its policy. Each
+    hook is a static function, and this one's do nothing.
+    Derive from it, hide whichever hooks you want and turn
+    it `on`:
+
+      struct timed : trace {
+        static constexpr auto on = true;
+        static auto read(long long bytes, long long ns) noexcept
+        { ... }
+      };
+      struct traced : policy { using trace = timed; };
+      auto w = watch<traced>(".", callback);
+
+    Unless a trace is `on`, nothing is timed, and the hooks
+    are empty and inlined away. The watcher compiles to the
+    same thing with this trace as without any.
+
+    - read
+        After each read from the kernel, with what it gave
+        us (0, or less on an error) and how long it took.
+        (Linux)
+    - decoded
+        For each event we make sense of, whether or not it
+        is sent, with the length of its name or path.
+    - send_begin, send_end
+        Before and after the callback is given an event,
+        with how long it took.
+    - mark, unmark
+        When we start or stop watching a directory (or, for
+        the polling adapter, nothing), and whether we could.
+    - walk_begin, walk_end
+        Around each walk through the tree, when we start
+        watching and when a `.gitignore` changes, with how
+        many directories (or, for the polling adapter, files)
+        we know of after it and how long it took.
+
+    Durations are in nanoseconds, from a steady clock. The
+    hooks are called from the watcher's own thread, so they
+    should be quick, and must not throw.
+
+    With `WATER_WATCHER_USE_USDT` defined, `usdt` is a trace
+    which fires a USDT probe (`wtr_watcher:<hook>`) for each
+    hook, for `bpftrace`, `perf` and friends. It needs
+    `<sys/sdt.h>`. */
+struct trace {
+  static constexpr auto on = false;
+
+  static auto now() noexcept -> long long
+  {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+  }
 
-/* ReadDirectoryChangesW
-   CreateIoCompletionPort
-   CreateFileW
-   CreateEventW
-   GetQueuedCompletionStatus
-   ResetEvent
-   GetLastError
-   WideCharToMultiByte */
-#include <windows.h>
-/* milliseconds */
-#include <chrono>
-/* path */
-#include <filesystem>
-/* string
-   wstring */
-#include <string>
-/* this_thread::sleep_for */
-#include <thread>
-/* event
-   callback */
+  static auto read(long long, long long) noexcept -> void {}
 
-namespace detail {
-namespace wtr {
-namespace watcher {
-namespace adapter {
-namespace {
+  static auto
+  decoded(enum event::what, enum event::kind, std::size_t) noexcept -> void
+  {}
 
-inline constexpr auto delay_ms = std::chrono::milliseconds(16);
-inline constexpr auto delay_ms_dw = static_cast<DWORD>(delay_ms.count());
-inline constexpr auto has_delay = delay_ms > std::chrono::milliseconds(0);
-/* I think the default page size in Windows is 64kb,
-   so 65536 might also work well. */
-inline constexpr auto event_buf_len_max = 8192;
+  static auto send_begin(enum event::what, enum event::kind) noexcept -> void
+  {}
 
-/* Hold resources necessary to recieve and send filesystem events. */
-class watch_event_proxy {
-public:
-  bool is_valid{true};
+  static auto send_end(long long) noexcept -> void {}
 
-  std::filesystem::path path{};
+  static auto mark(std::filesystem::path const&, bool) noexcept -> void {}
 
-  wchar_t path_name[256]{L""};
+  static auto unmark(std::filesystem::path const&, bool) noexcept -> void {}
 
-  HANDLE path_handle{nullptr};
+  static auto walk_begin(std::filesystem::path const&) noexcept -> void {}
 
-  HANDLE event_completion_token{nullptr};
+  static auto
+  walk_end(std::filesystem::path const&, std::size_t, long long) noexcept
+    -> void
+  {}
+};
 
-  HANDLE event_token{CreateEventW(nullptr, true, false, nullptr)};
+#if defined(WATER_WATCHER_USE_USDT)
 
-  OVERLAPPED event_overlap{};
+struct usdt : trace {
+  static constexpr auto on = true;
 
-  FILE_NOTIFY_INFORMATION event_buf[event_buf_len_max];
+  static auto read(long long bytes, long long ns) noexcept -> void
+  {
+    DTRACE_PROBE2(wtr_watcher, read, bytes, ns);
+  }
 
-  DWORD event_buf_len_ready{0};
+  static auto decoded(enum event::what what,
+                      enum event::kind kind,
+                      std::size_t len) noexcept -> void
+  {
+    DTRACE_PROBE3(wtr_watcher, decoded, (int)what, (int)kind, len);
+  }
 
-  watch_event_proxy(std::filesystem::path const& path) noexcept
-      : path{path}
+  static auto send_begin(enum event::what what, enum event::kind kind) noexcept
+    -> void
   {
-    memcpy(path_name, path.c_str(), path.string().size());
+    DTRACE_PROBE2(wtr_watcher, send_begin, (int)what, (int)kind);
+  }
 
-    path_handle =
-      CreateFileW(path.c_str(),
-                  FILE_LIST_DIRECTORY,
-                  FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
-                  nullptr,
-                  OPEN_EXISTING,
-                  FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED,
-                  nullptr);
+  static auto send_end(long long ns) noexcept -> void
+  {
+    DTRACE_PROBE1(wtr_watcher, send_end, ns);
+  }
 
-    if (path_handle)
-      event_completion_token =
-        CreateIoCompletionPort(INVALID_HANDLE_VALUE, nullptr, 0, 0);
+  static auto mark(std::filesystem::path const& dir, bool ok) noexcept -> void
+  {
+    DTRACE_PROBE2(wtr_watcher, mark, dir.c_str(), (int)ok);
+  }
 
-    if (event_completion_token)
-      is_valid = CreateIoCompletionPort(path_handle,
-                                        event_completion_token,
-                                        (ULONG_PTR)path_handle,
-                                        1)
-              && ResetEvent(event_token);
+  static auto unmark(std::filesystem::path const& dir, bool ok) noexcept
+    -> void
+  {
+    DTRACE_PROBE2(wtr_watcher, unmark, dir.c_str(), (int)ok);
   }
 
-  ~watch_event_proxy() noexcept
+  static auto walk_begin(std::filesystem::path const& root) noexcept -> void
   {
-    if (event_token) CloseHandle(event_token);
-    if (event_completion_token) CloseHandle(event_completion_token);
+    DTRACE_PROBE1(wtr_watcher, walk_begin, root.c_str());
+  }
+
+  static auto walk_end(std::filesystem::path const& root,
+                       std::size_t marks,
+                       long long ns) noexcept -> void
+  {
+    DTRACE_PROBE3(wtr_watcher, walk_end, root.c_str(), marks, ns);
   }
 };
 
-inline bool is_valid(watch_event_proxy& w) noexcept
-{
-  return w.is_valid && w.event_buf != nullptr;
-}
+#endif
 
-inline bool has_event(watch_event_proxy& w) noexcept
-{
-  return w.event_buf_len_ready != 0;
-}
+} /* namespace watcher */
+} /* namespace wtr */
 
-inline bool
-do_event_recv(watch_event_proxy& w,
-              ::wtr::watcher::event::callback const& callback) noexcept
-{
-  using namespace ::wtr::watcher;
+/*  event */
+/*  trace */
 
-  w.event_buf_len_ready = 0;
-  DWORD bytes_returned = 0;
-  memset(&w.event_overlap, 0, sizeof(OVERLAPPED));
+namespace wtr {
+inline namespace watcher {
 
-  auto read_ok = ReadDirectoryChangesW(
-    w.path_handle,
-    w.event_buf,
-    event_buf_len_max,
-    true,
-    FILE_NOTIFY_CHANGE_SECURITY | FILE_NOTIFY_CHANGE_CREATION
-      | FILE_NOTIFY_CHANGE_LAST_ACCESS | FILE_NOTIFY_CHANGE_LAST_WRITE
-      | FILE_NOTIFY_CHANGE_SIZE | FILE_NOTIFY_CHANGE_ATTRIBUTES
-      | FILE_NOTIFY_CHANGE_DIR_NAME | FILE_NOTIFY_CHANGE_FILE_NAME,
-    &bytes_returned,
-    &w.event_overlap,
-    nullptr);
+/*  @brief wtr/watcher/policy
+    What a watcher can be told when it is compiled, rather
+    than when it runs. A policy is a type: derive from this
+    one and hide whatever should be different.
+
+      struct quiet : policy {
+        static constexpr auto status = false;
+        static constexpr auto watches(enum event::what w) noexcept
+        { return w != event::what::modify; }
+      };
+      auto w = watch<quiet>(".", callback);
+
+    - buf_len
+        The size, in bytes, of the buffer which each read
+        from the kernel goes into. (Linux)
+    - wait_max
+        How many ready descriptors we take from one call
+        to `epoll_wait`. (Linux)
+    - delay_ms
+        How long we wait for something to happen before we
+        check whether we should stop. The polling adapter
+        sleeps this long between scans.
+    - clock
+        Where the time of each event comes from, unless the
+        watcher is given a clock.
+    - status
+        Whether the watcher tells us about itself: when it
+        is alive and dead (`s/...`) and what it couldn't
+        watch (`w/...`). Errors (`e/...`) are always sent.
+        Without status, none of those messages is made, and
+        the code which makes them isn't compiled.
+    - watches
+        Which changes are sent. The kernel isn't asked for
+        modifications unless they are watched. Whatever an
+        adapter needs to follow directories (such as their
+        creation) is always asked for, and what isn't
+        watched is dropped before it is sent.
+    - trace
+        Hooks for profilers, on the hot path. See `trace`.
+        The default does nothing, and costs nothing.
+    - sys
+        What the Linux adapters call to read from the kernel
+        and to mark directories. A policy needn't have one:
+        without it, they call the kernel. One which records
+        what the kernel says, and one which plays it back,
+        are in `<d>/adapter/linux/replay`.
+
+    The defaults are what a watcher does without a policy. */
+struct policy {
+  static constexpr auto buf_len = 4096;
+  static constexpr auto wait_max = 1;
+  static constexpr auto delay_ms = 16;
+  static constexpr auto clock = event::clock::system;
+  static constexpr auto status = true;
 
-  if (w.event_buf && read_ok) {
-    w.event_buf_len_ready = bytes_returned > 0 ? bytes_returned : 0;
+  using trace = ::wtr::watcher::trace;
+
+  static constexpr auto watches(enum event::what) noexcept -> bool
+  {
     return true;
   }
-  else {
-    switch (GetLastError()) {
-      case ERROR_IO_PENDING :
-        w.event_buf_len_ready = 0;
-        w.is_valid = false;
-        callback({"e/sys/read/pending",
-                  ::wtr::event::what::other,
-                  ::wtr::event::kind::watcher});
-        break;
-      default :
-        callback({"e/sys/read",
-                  ::wtr::event::what::other,
-                  ::wtr::event::kind::watcher});
-        break;
-    }
-    return false;
-  }
-}
+};
 
-inline bool
-do_event_send(watch_event_proxy& w,
-              ::wtr::watcher::event::callback const& callback) noexcept
-{
-  using namespace ::wtr::watcher;
+} /* namespace watcher */
+} /* namespace wtr */
 
-  FILE_NOTIFY_INFORMATION* buf = w.event_buf;
+/*  equal */
+#include <algorithm>
+/*  size_t */
+#include <cstddef>
+/*  strerror */
+#include <cstring>
+/*  function */
+#include <functional>
+/*  string */
+#include <string>
+/*  string_view */
+#include <string_view>
+/*  is_invocable_v */
+#include <type_traits>
+/*  event */
 
-  if (is_valid(w)) {
-    while (buf + sizeof(FILE_NOTIFY_INFORMATION)
-           <= buf + w.event_buf_len_ready) {
-      if (buf->FileNameLength % 2 == 0) {
-        auto where =
-          w.path / std::wstring{buf->FileName, buf->FileNameLength / 2};
+namespace wtr {
+inline namespace watcher {
 
-        auto what = [&buf]() noexcept
-        {
-          switch (buf->Action) {
-            case FILE_ACTION_MODIFIED : return event::what::modify;
-            case FILE_ACTION_ADDED : return event::what::create;
-            case FILE_ACTION_REMOVED : return event::what::destroy;
-            case FILE_ACTION_RENAMED_OLD_NAME : return event::what::rename;
-            case FILE_ACTION_RENAMED_NEW_NAME : return event::what::rename;
-            default : return event::what::other;
-          }
-        }();
+/*  @brief wtr/watcher/diag
+    Something the watcher says about itself: that it is
+    alive or dead, what it couldn't watch, and what went
+    wrong. Without a diagnostic callback, these are sent
+    as events of `kind::watcher`, with a message such as
+    `e/sys/epoll_wait@/some/path` for where. With one, they
+    are sent to it instead, and nothing is put together:
+      - level
+          A status, a warning or an error (the `s`, `w` and
+          `e` which begin a message).
+      - code
+          What this is about. `name()` is its part of the
+          message, such as `sys/epoll_wait`.
+      - error
+          The `errno` from the call which failed, or 0.
+      - where
+          The path being watched.
+      - also
+          Another path, such as a directory we couldn't
+          watch, or nothing.
+      - count
+          How many of these there were. Warnings about the
+          directories in a tree are counted as we go through
+          it, and sent once, with the first of them in `also`.
+
+    The paths are viewed, and last as long as the callback. */
+struct diag {
+  enum class level : unsigned char { status, warning, error };
+
+  enum class code : unsigned char {
+    live,
+    die,
+    not_watched,
+    overflow,
+    event_info,
+    read,
+    epoll_create,
+    epoll_ctl,
+    epoll_wait,
+    inotify_init,
+    fanotify_init,
+    fanotify_mark,
+    kernel_version,
+    wrong_event_fd,
+    event_recv,
+    path_map,
+    sys_resource,
+    bad_fs,
+    other,
+  };
 
-        auto kind = [&where]()
-        {
-          try {
-            return std::filesystem::is_directory(where) ? event::kind::dir
-                                                        : event::kind::file;
-          } catch (...) {
-            return event::kind::other;
-          }
-        }();
+  using callback = std::function<void(diag const&)>;
 
-        callback({where, what, kind});
+  enum level level {};
+  enum code code {};
+  int error{0};
+  std::string_view where{};
+  std::string_view also{};
+  std::size_t count{1};
 
-        if (buf->NextEntryOffset == 0)
-          break;
-        else
-          buf =
-            (FILE_NOTIFY_INFORMATION*)((uint8_t*)buf + buf->NextEntryOffset);
-      }
+  static constexpr auto name(enum code c) noexcept -> std::string_view
+  {
+    switch (c) {
+      case code::live : return "self/live";
+      case code::die : return "self/die";
+      case code::not_watched : return "sys/not_watched";
+      case code::overflow : return "sys/overflow";
+      case code::event_info : return "self/event_info";
+      case code::read : return "sys/read";
+      case code::epoll_create : return "sys/epoll_create";
+      case code::epoll_ctl : return "sys/epoll_ctl";
+      case code::epoll_wait : return "sys/epoll_wait";
+      case code::inotify_init : return "sys/inotify_init";
+      case code::fanotify_init : return "sys/fanotify_init";
+      case code::fanotify_mark : return "sys/fanotify_mark";
+      case code::kernel_version : return "sys/kernel_version";
+      case code::wrong_event_fd : return "sys/wrong_event_fd";
+      case code::event_recv : return "self/event_recv";
+      case code::path_map : return "self/path_map";
+      case code::sys_resource : return "self/sys_resource";
+      case code::bad_fs : return "self/die/bad_fs";
+      case code::other : return "other";
     }
-    return true;
+    return "other";
   }
 
-  else {
-    return false;
-  }
-}  // namespace
+  auto name() const noexcept -> std::string_view { return name(this->code); }
 
-}  // namespace
+  /*  What happened, as an event would say: the watcher is
+      created when it is alive and destroyed when it dies. */
+  auto what() const noexcept -> enum event::what
+  {
+    return this->code == code::live ? event::what::create
+         : this->code == code::die || this->code == code::bad_fs
+           ? event::what::destroy
+           : event::what::other;
+  }
 
-/* while living
-   watch for events
-   return when dead
-   true if no errors */
+  /*  The message which is sent as an event's path when
+      there is no diagnostic callback. */
+  auto message() const -> std::string
+  {
+    auto m = std::string{this->level == level::status    ? "s/"
+                         : this->level == level::warning ? "w/"
+                                                         : "e/"};
+    m += this->name();
+    if (this->error != 0) {
+      m += '(';
+      m += std::strerror(this->error);
+      m += ')';
+    }
+    if (! this->where.empty()) {
+      m += '@';
+      m += this->where;
+    }
+    if (! this->also.empty()) {
+      m += '@';
+      m += this->also;
+    }
+    return m;
+  }
 
-inline bool watch(std::filesystem::path const& path,
-                  ::wtr::watcher::event::callback const& callback,
-                  std::function<bool()> const& is_living) noexcept
+  /*  Reads a message back, from an event of
+      `kind::watcher`. The paths view the event's. */
+  static auto of(event const& ev) noexcept -> diag
+  {
+    auto const& m = ev.where.native();
+    auto const msg = std::basic_string_view<std::filesystem::path::value_type>{m};
+    auto d = diag{};
+    d.level = msg.starts_with('s') ? level::status
+            : msg.starts_with('w') ? level::warning
+                                   : level::error;
+    auto const head = msg.substr(0, msg.find('@'));
+    auto const named = head.substr(head.find('/') + 1);
+    auto const name_only = named.substr(0, named.find('('));
+    d.code = code::other;
+    for (auto c = 0; c < (int)code::other; ++c)
+      if (std::equal(name_only.begin(),
+                     name_only.end(),
+                     name((enum code)c).begin(),
+                     name((enum code)c).end()))
+        d.code = (enum code)c;
+    /* Paths which aren't made of `char`s aren't viewed. */
+    auto const view_paths = [&d](auto rest) noexcept
+    {
+      if constexpr (std::is_same_v<decltype(rest), std::string_view>) {
+        auto const at = rest.find('@');
+        d.where = rest.substr(0, at);
+        if (at != rest.npos) d.also = rest.substr(at + 1);
+      }
+    };
+    if (head.size() < msg.size()) view_paths(msg.substr(head.size() + 1));
+    return d;
+  }
+};
+
+/*  @brief wtr/watcher/with_diags
+    A callback for events, along with one for diagnostics.
+    Give this to `watch` to have what the watcher says about
+    itself sent to `diags`, instead of to `callback` as
+    events of `kind::watcher`.
+
+    auto w = watch(".", with_diags(callback, [](diag const& d) {
+      if (d.level == diag::level::error) std::cerr << d.message();
+    })); */
+template<class Callback>
+struct diagnosed {
+  Callback callback;
+  diag::callback diags;
+
+  template<class Event>
+  requires(std::is_invocable_v<Callback const&, Event const&>)
+  auto operator()(Event const& ev) const noexcept -> void
+  {
+    this->callback(ev);
+  }
+};
+
+template<class Callback>
+inline auto
+with_diags(Callback const& callback, diag::callback const& diags) noexcept
+  -> diagnosed<Callback>
 {
-  using namespace ::wtr::watcher;
+  return {callback, diags};
+}
 
-  auto w = watch_event_proxy{path};
+} /* namespace watcher */
+} /* namespace wtr */
 
-  if (is_valid(w)) {
-    do_event_recv(w, callback);
+/*  array */
+#include <array>
+/*  atomic
+    memory_order_relaxed */
+#include <atomic>
+/*  bit_width */
+#include <bit>
+/*  steady_clock
+    duration_cast */
+#include <chrono>
+/*  size_t */
+#include <cstddef>
+/*  uint64_t */
+#include <cstdint>
 
-    while (is_valid(w) && has_event(w)) { do_event_send(w, callback); }
+namespace wtr {
+inline namespace watcher {
 
-    while (is_living()) {
-      ULONG_PTR completion_key{0};
-      LPOVERLAPPED overlap{nullptr};
+/*  @brief wtr/watcher/metrics
+    What a watcher has done so far. Every watcher counts
+    as it goes, with relaxed atomics, and `snapshot` reads
+    the counts while it runs. The counts in a snapshot are
+    each up to date, but not necessarily with each other.
+
+    From `auto w = watch(...)`, `w.metrics()` is a snapshot.
+
+    - events
+        Events sent to the callback. (Batches aren't
+        counted as events.)
+    - reads
+        Calls to `read` on the kernel's queue, including
+        those which found nothing. (The polling adapter
+        counts its scans.)
+    - bytes_read
+        What those reads gave us.
+    - full_reads
+        Reads which (nearly) filled our buffer. Many of
+        these mean the kernel's queue is backing up, and a
+        bigger buffer (see `policy`) might help.
+    - overflows
+        Times the kernel's queue overflowed.
+    - marks
+        Directories we are watching now. (The polling
+        adapter counts the files it knows about.)
+    - callback_ns
+        How long the callback takes, in nanoseconds. One
+        event in every `callback_sample` is timed.
+    - read_events
+        Events sent from each read (or scan).
+
+    Histograms have a bucket for each power of two: bucket
+    `n` counts values which need `n` bits. */
+struct metrics {
+  static constexpr std::size_t bucket_count = 65;
+  static constexpr std::uint64_t callback_sample = 64;
+
+  /*  Adds to a counter. A watcher with many roots may
+      count from a thread for each of them (off Linux), so
+      this is a locked add, though a relaxed one. */
+  static auto add(std::atomic<std::uint64_t>& counter,
+                  std::uint64_t n = 1) noexcept -> void
+  {
+    counter.fetch_add(n, std::memory_order_relaxed);
+  }
 
-      bool complete = GetQueuedCompletionStatus(w.event_completion_token,
-                                                &w.event_buf_len_ready,
-                                                &completion_key,
-                                                &overlap,
-                                                delay_ms_dw);
+  struct histogram {
+    std::array<std::atomic<std::uint64_t>, bucket_count> buckets{};
 
-      if (complete && overlap) {
-        while (is_valid(w) && has_event(w)) {
-          do_event_send(w, callback);
-          do_event_recv(w, callback);
-        }
-      }
+    auto record(std::uint64_t value) noexcept -> void
+    {
+      add(this->buckets[std::bit_width(value)]);
     }
+  };
 
-    callback({"s/self/die@" + path.string(),
-              ::wtr::event::what::destroy,
-              ::wtr::event::kind::watcher});
+  struct snapshot_type {
+    struct histogram {
+      std::array<std::uint64_t, bucket_count> buckets{};
 
-    return true;
-  }
-  else {
-    callback({"s/self/die@" + path.string(),
-              ::wtr::event::what::destroy,
-              ::wtr::event::kind::watcher});
-    return false;
-  }
-}
+      auto count() const noexcept -> std::uint64_t
+      {
+        auto n = std::uint64_t{0};
+        for (auto b : this->buckets) n += b;
+        return n;
+      }
 
-}  // namespace adapter
-}  // namespace watcher
-}  // namespace wtr
-} /* namespace detail */
+      /*  An upper bound on the value which `q` (from 0 to 1)
+          of what was recorded are at or below, or 0. */
+      auto quantile(double q) const noexcept -> std::uint64_t
+      {
+        auto const total = this->count();
+        if (total == 0) return 0;
+        auto const want = q * (double)total;
+        auto seen = std::uint64_t{0};
+        for (std::size_t n = 0; n < bucket_count; ++n) {
+          seen += this->buckets[n];
+          if ((double)seen >= want && this->buckets[n] > 0)
+            return n == 0 ? 0
+                 : n >= 64 ? ~std::uint64_t{0}
+                           : (std::uint64_t{1} << n) - 1;
+        }
+        return ~std::uint64_t{0};
+      }
+    };
 
-#endif /* defined(WATER_WATCHER_PLATFORM_WINDOWS_ANY) */
+    std::uint64_t events{};
+    std::uint64_t reads{};
+    std::uint64_t bytes_read{};
+    std::uint64_t full_reads{};
+    std::uint64_t overflows{};
+    std::uint64_t marks{};
+    histogram callback_ns{};
+    histogram read_events{};
+  };
 
-/* WATER_WATCHER_PLATFORM_* */
+  std::atomic<std::uint64_t> events{};
+  std::atomic<std::uint64_t> reads{};
+  std::atomic<std::uint64_t> bytes_read{};
+  std::atomic<std::uint64_t> full_reads{};
+  std::atomic<std::uint64_t> overflows{};
+  std::atomic<std::uint64_t> marks{};
+  histogram callback_ns{};
+  histogram read_events{};
+
+  /*  Calls `send`, which sends an event, and counts it.
+      Every `callback_sample`th one is timed. */
+  template<class Send>
+  auto sent(Send const& send) noexcept -> void
+  {
+    using clock = std::chrono::steady_clock;
 
-#if defined(WATER_WATCHER_PLATFORM_MAC_ANY)
+    auto const n = this->events.fetch_add(1, std::memory_order_relaxed);
+    if (n % callback_sample != 0) return send();
 
-/*
-  @brief watcher/adapter/darwin
+    auto const then = clock::now();
+    send();
+    this->callback_ns.record(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - then)
+        .count());
+  }
 
-  The Darwin `FSEvent` adapter.
-*/
+  auto snapshot() const noexcept -> snapshot_type
+  {
+    constexpr auto r = std::memory_order_relaxed;
+    auto s = snapshot_type{};
+    s.events = this->events.load(r);
+    s.reads = this->reads.load(r);
+    s.bytes_read = this->bytes_read.load(r);
+    s.full_reads = this->full_reads.load(r);
+    s.overflows = this->overflows.load(r);
+    s.marks = this->marks.load(r);
+    for (std::size_t n = 0; n < bucket_count; ++n) {
+      s.callback_ns.buckets[n] = this->callback_ns.buckets[n].load(r);
+      s.read_events.buckets[n] = this->read_events.buckets[n].load(r);
+    }
+    return s;
+  }
+};
 
-/* kFS*
-   FS*
-   CF*
-   dispatch_queue* */
-#include <CoreServices/CoreServices.h>
-/* milliseconds */
-#include <chrono>
-/* function */
-#include <functional>
-/* path */
+} /* namespace watcher */
+} /* namespace wtr */
+
+/*  ptrdiff_t */
+#include <cstddef>
+/*  path */
 #include <filesystem>
-/* numeric_limits */
-#include <limits>
-/* mt19937
-   random_device
-   uniform_int_distribution */
-#include <random>
-/* string
-   to_string */
-#include <string>
-/* sleep_for */
-#include <thread>
-/* tuple
-   make_tuple */
-#include <tuple>
-/* vector */
-#include <vector>
-/* snprintf */
-#include <cstdio>
-/* unordered_set */
-#include <unordered_set>
-/* event
-   callback */
+/*  function
+    hash */
+#include <functional>
+/*  forward_iterator_tag */
+#include <iterator>
+/*  basic_string_view */
+#include <string_view>
+/*  event */
 
-namespace detail {
 namespace wtr {
-namespace watcher {
-namespace adapter {
-namespace {
+inline namespace watcher {
 
-struct argptr_type {
-  ::wtr::watcher::event::callback const& callback;
-  std::unordered_set<std::string>* seen_created_paths;
-};
+/*  @brief wtr/watcher/batch
+    A view of what the kernel gave the watcher in one read,
+    for callbacks which only look at a little of it.
+
+    Nothing is decoded until it is asked for. Iterating
+    steps from one record to the next in the adapter's own
+    buffer. The name of what happened is a view into that
+    buffer. The full path is only put together when asked
+    for, into a string which the caller can reuse.
+
+    Each entry is also addressed by its directory and its
+    name. A directory's id stays the same for as long as
+    the watcher knows about that directory, and `dir(id)`
+    finds its path without building anything, so callbacks
+    which group or hash by directory can use the id instead
+    of the path.
+
+    The view (and everything from it) is good until the
+    callback returns. Messages from the watcher are not in
+    batches: they are sent as one-entry batches of their
+    own, as are the events on platforms which don't read
+    records from the kernel in bulk.
 
-inline constexpr auto delay_ms = std::chrono::milliseconds(16);
-inline constexpr auto delay_s =
-  std::chrono::duration_cast<std::chrono::seconds>(delay_ms);
-inline constexpr auto has_delay = delay_ms.count() > 0;
+    Typical use looks like this:
 
-inline constexpr auto time_flag = kFSEventStreamEventIdSinceNow;
+    auto w = watch(".", [](batch const& b) {
+      for (auto e : b)
+        if (e.what() == event::what::create) ++created;
+    }); */
+class batch {
+public:
+  using callback = std::function<void(batch const&)>;
+  using string_type = std::filesystem::path::string_type;
+  using view_type = std::basic_string_view<std::filesystem::path::value_type>;
+  using dir_id = std::size_t;
+
+  /*  How to read the records in a buffer. The adapters
+      have one of these for their kernel's records.
+      - first
+          The first record at or after `at` which is an
+          event, or `end`.
+      - next
+          The record after `at` which is an event, or `end`.
+      - what, kind
+          What happened, and to what kind of thing.
+      - name
+          The name of what it happened to.
+      - dir
+          The id of the directory it happened in.
+      - dir_path
+          The path of a directory, by its id, or nothing if
+          the directory is gone.
+      - where
+          Puts the full path in `into`. The `context` is
+          whatever the adapter gave the batch. Returns false
+          if the path is gone. */
+  struct decoder {
+    char const* (*first)(char const* at, char const* end) noexcept;
+    char const* (*next)(char const* at, char const* end) noexcept;
+    enum event::what (*what)(char const* at) noexcept;
+    enum event::kind (*kind)(char const* at) noexcept;
+    view_type (*name)(char const* at) noexcept;
+    dir_id (*dir)(void const* context, char const* at) noexcept;
+    view_type (*dir_path)(void const* context, dir_id dir) noexcept;
+    bool (*where)(void const* context,
+                  char const* at,
+                  string_type& into) noexcept;
+  };
 
-/* We could OR `event_stream_flags` with `kFSEventStreamCreateFlagNoDefer` if we
-   want less "sleepy" time after a period of no filesystem events. But we're
-   talking about saving a maximum latency of `delay_ms` after some period of
-   inactivity -- very small. (Not sure what the inactivity period is.) */
-inline constexpr unsigned event_stream_flags =
-  kFSEventStreamCreateFlagFileEvents | kFSEventStreamCreateFlagUseExtendedData
-  | kFSEventStreamCreateFlagUseCFTypes;
+  /*  One record, decoded as it is asked about. */
+  class entry {
+    batch const* in;
+    char const* at;
 
-inline constexpr unsigned kFSEventStreamEventFlagItemIsAnyHardLink =
-  kFSEventStreamEventFlagItemIsHardlink
-  | kFSEventStreamEventFlagItemIsLastHardlink;
+  public:
+    entry(batch const* in, char const* at) noexcept
+        : in{in},
+          at{at}
+    {}
 
-inline std::tuple<FSEventStreamRef, dispatch_queue_t>
-event_stream_open(std::filesystem::path const& path,
-                  FSEventStreamCallback funcptr,
-                  argptr_type const& funcptr_args) noexcept
-{
-  static constexpr CFIndex path_array_size = 1;
-  static constexpr auto queue_priority = -10;
+    auto what() const noexcept -> enum event::what
+    {
+      return this->in->decode->what(this->at);
+    }
 
-  auto funcptr_context =
-    FSEventStreamContext{0, (void*)&funcptr_args, nullptr, nullptr, nullptr};
-  /* Creating this untyped array of strings is unavoidable.
-     `path_cfstring` and `path_cfarray_cfstring` must be temporaries because
-     `CFArrayCreate` takes the address of a string and `FSEventStreamCreate` the
-     address of an array (of strings). There might be some UB around here. */
-  void const* path_cfstring =
-    CFStringCreateWithCString(nullptr, path.c_str(), kCFStringEncodingUTF8);
-  CFArrayRef path_array = CFArrayCreate(nullptr,
-                                        &path_cfstring,
-                                        path_array_size,
-                                        &kCFTypeArrayCallBacks);
+    auto kind() const noexcept -> enum event::kind
+    {
+      return this->in->decode->kind(this->at);
+    }
 
-  /* The event queue name doesn't seem to need to be unique.
-     We try to make a unique name anyway, just in case.
-     The event queue name will be:
-       = "wtr" + [0, 28) character number
-     And will always be a string between 5 and 32-characters long:
-       = 3 (prefix) + [1, 28] (digits) + 1 (null char from snprintf) */
-  char queue_name[3 + 28 + 1]{};
-  std::mt19937 gen(std::random_device{}());
-  std::snprintf(queue_name,
-                sizeof(queue_name),
-                "wtr%zu",
-                std::uniform_int_distribution<size_t>(
-                  0,
-                  std::numeric_limits<size_t>::max())(gen));
+    auto name() const noexcept -> view_type
+    {
+      return this->in->decode->name(this->at);
+    }
 
-  /* Request a file event stream for `path` from the kernel
-     which invokes `funcptr` with `funcptr_context` on events. */
-  FSEventStreamRef stream = FSEventStreamCreate(
-    nullptr,           /* Custom allocator, optional */
-    funcptr,           /* A callable to invoke on changes */
-    &funcptr_context,  /* The callable's arguments (context). */
-    path_array,        /* The path we were asked to watch */
-    time_flag,         /* The time "since when" we receive events */
-    delay_s.count(),   /* The time between scans after inactivity */
-    event_stream_flags /* The event stream flags */
-  );
+    auto dir() const noexcept -> dir_id
+    {
+      return this->in->decode->dir(this->in->context, this->at);
+    }
 
-  /* Request a (very) high priority queue. */
-  dispatch_queue_t queue = dispatch_queue_create(
-    queue_name,
-    dispatch_queue_attr_make_with_qos_class(DISPATCH_QUEUE_SERIAL,
-                                            QOS_CLASS_USER_INITIATED,
-                                            queue_priority));
+    /*  Puts the full path in `into`, reusing its storage.
+        Returns false if the path can't be found. */
+    auto where(string_type& into) const noexcept -> bool
+    {
+      return this->in->decode->where(this->in->context, this->at, into);
+    }
 
-  FSEventStreamSetDispatchQueue(stream, queue);
+    /*  The full path. Allocates. */
+    auto where() const noexcept -> std::filesystem::path
+    {
+      auto into = string_type{};
+      return this->where(into) ? std::filesystem::path{std::move(into)}
+                               : std::filesystem::path{};
+    }
+  };
 
-  FSEventStreamStart(stream);
+  class iterator {
+    batch const* in{nullptr};
+    char const* at{nullptr};
 
-  return std::make_tuple(stream, queue);
-}
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = entry;
+    using difference_type = std::ptrdiff_t;
+    using pointer = void;
+    using reference = entry;
 
-/* @note
-   The functions we use to close the stream and queue take `_Nonnull`
-   parameters, so we should be able to take `const&` for our arguments.
-   We don't because it would be misleading. `stream` and `queue` are
-   eventually null (and always invalid) after the calls we make here.
+    iterator() noexcept = default;
 
-   @note
-   Assuming macOS > 10.8 or iOS > 6.0, we don't need to check for null on the
-   dispatch queue after we release it:
-     https://developer.apple.com/documentation/dispatch/1496328-dispatch_release
-*/
-inline bool event_stream_close(
-  std::tuple<FSEventStreamRef, dispatch_queue_t>&& resources) noexcept
-{
-  auto [stream, queue] = resources;
-  if (stream) {
-    FSEventStreamStop(stream);
-    FSEventStreamInvalidate(stream);
-    FSEventStreamRelease(stream);
-    if (queue) {
-      dispatch_release(queue);
-      return true;
+    iterator(batch const* in, char const* at) noexcept
+        : in{in},
+          at{at}
+    {}
+
+    auto operator*() const noexcept -> entry { return {this->in, this->at}; }
+
+    auto operator++() noexcept -> iterator&
+    {
+      this->at = this->in->decode->next(this->at, this->in->tail);
+      return *this;
     }
-    else
-      return false;
-  }
-  else
-    return false;
-}
 
-inline std::filesystem::path path_from_event_at(void* event_recv_paths,
-                                                unsigned long i) noexcept
-{
-  /*  We make a path from a C string...
-      In an array, in a dictionary...
-      Without type safety...
-      Because most of darwin's apis are `void*`-typed.
+    auto operator++(int) noexcept -> iterator
+    {
+      auto was = *this;
+      ++*this;
+      return was;
+    }
 
-      We should be guarenteed that nothing in here is
-      or can be null, but I'm skeptical. We ask Darwin
-      for utf8 strings from a dictionary of utf8 strings
-      which it gave us. Nothing should be able to be null.
-      We'll check anyway, just in case Darwin lies. */
+    auto operator==(iterator const& r) const noexcept -> bool
+    {
+      return this->at == r.at;
+    }
+  };
 
-  namespace fs = std::filesystem;
+private:
+  char const* head;
+  char const* tail;
+  decoder const* decode;
+  void const* context;
+  long long stamp;
+  enum event::clock stamped_by;
 
-  auto cstr =
-    CFStringGetCStringPtr(static_cast<CFStringRef>(CFDictionaryGetValue(
-                            static_cast<CFDictionaryRef>(CFArrayGetValueAtIndex(
-                              static_cast<CFArrayRef>(event_recv_paths),
-                              static_cast<CFIndex>(i))),
-                            kFSEventStreamEventExtendedDataPathKey)),
-                          kCFStringEncodingUTF8);
+public:
+  batch(char const* head,
+        char const* tail,
+        decoder const& decode,
+        void const* context = nullptr,
+        long long when = 0,
+        enum event::clock clock = event::clock::none) noexcept
+      : head{head},
+        tail{tail},
+        decode{&decode},
+        context{context},
+        stamp{when},
+        stamped_by{clock}
+  {}
+
+  /*  When everything in here was read, and from which
+      clock. See `event::clock`. */
+  auto when() const noexcept -> long long { return this->stamp; }
+
+  auto clock() const noexcept -> enum event::clock { return this->stamped_by; }
+
+  auto begin() const noexcept -> iterator
+  {
+    return {this, this->decode->first(this->head, this->tail)};
+  }
 
-  return cstr ? fs::path{cstr} : fs::path{};
-}
+  auto end() const noexcept -> iterator { return {this, this->tail}; }
 
-/* @note
-   Sometimes events are batched together and re-sent
-   (despite having already been sent).
-   Example:
-     [first batch of events from the os]
-     file 'a' created
-     -> create event for 'a' is sent
-     [some tiny delay, 1 ms or so]
-     [second batch of events from the os]
-     file 'a' destroyed
-     -> create event for 'a' is sent
-     -> destroy event for 'a' is sent
-   So, we filter out duplicate events when they're sent
-   in a batch. We do this by storing and pruning the
-   set of paths which we've seen created. */
-inline void event_recv(ConstFSEventStreamRef,    /* `ConstFS..` is important */
-                       void* arg_ptr,            /* Arguments passed to us */
-                       unsigned long recv_count, /* Event count */
-                       void* recv_paths,         /* Paths with events */
-                       unsigned int const* recv_flags, /* Event flags */
-                       FSEventStreamEventId const*     /* event stream id */
-                       ) noexcept
-{
-  using evk = enum ::wtr::watcher::event::kind;
-  using evw = enum ::wtr::watcher::event::what;
+  auto empty() const noexcept -> bool { return this->begin() == this->end(); }
 
-  if (arg_ptr && recv_paths) {
+  /*  The path of the directory with this id. */
+  auto dir(dir_id dir) const noexcept -> view_type
+  {
+    return this->decode->dir_path(this->context, dir);
+  }
 
-    auto [callback, seen_created] = *static_cast<argptr_type*>(arg_ptr);
+private:
+  static auto parent_of(void const* ev) noexcept -> view_type
+  {
+    auto const& p = static_cast<event const*>(ev)->where.native();
+    auto const sep = p.rfind(std::filesystem::path::preferred_separator);
+    return view_type{p}.substr(0, sep == string_type::npos ? 0 : sep);
+  }
 
-    for (unsigned long i = 0; i < recv_count; i++) {
-      auto path = path_from_event_at(recv_paths, i);
+public:
+  /*  Reads one event as a batch of one. This is how
+      events which weren't read in bulk are sent. There is
+      no table of directories behind these, so a directory's
+      id is a hash of its path. */
+  static constexpr auto of_event = decoder{
+    .first = [](char const* at, char const*) noexcept { return at; },
+    .next = [](char const*, char const* end) noexcept { return end; },
+    .what = [](char const* at) noexcept
+    { return reinterpret_cast<event const*>(at)->what; },
+    .kind = [](char const* at) noexcept
+    { return reinterpret_cast<event const*>(at)->kind; },
+    .name = [](char const* at) noexcept -> view_type
+    {
+      auto const& p = reinterpret_cast<event const*>(at)->where.native();
+      auto const sep = p.rfind(std::filesystem::path::preferred_separator);
+      return view_type{p}.substr(sep == string_type::npos ? 0 : sep + 1);
+    },
+    .dir = [](void const* context, char const*) noexcept -> dir_id
+    { return std::hash<view_type>{}(parent_of(context)); },
+    .dir_path = [](void const* context, dir_id) noexcept -> view_type
+    { return parent_of(context); },
+    .where = [](void const*, char const* at, string_type& into) noexcept
+    {
+      into.assign(reinterpret_cast<event const*>(at)->where.native());
+      return true;
+    },
+  };
 
-      if (! path.empty()) {
-        /* `path` has no hash function, so we use a string. */
-        auto path_str = path.string();
+  /*  A batch of one event. */
+  explicit batch(event const& ev) noexcept
+      : batch{reinterpret_cast<char const*>(&ev),
+              reinterpret_cast<char const*>(&ev + 1),
+              of_event,
+              &ev,
+              ev.when,
+              ev.clock}
+  {}
+};
 
-        decltype(*recv_flags) flag = recv_flags[i];
+} /* namespace watcher */
+} /* namespace wtr   */
 
-        /* A single path won't have different "kinds". */
-        auto k = flag & kFSEventStreamEventFlagItemIsFile    ? evk::file
-               : flag & kFSEventStreamEventFlagItemIsDir     ? evk::dir
-               : flag & kFSEventStreamEventFlagItemIsSymlink ? evk::sym_link
-               : flag & kFSEventStreamEventFlagItemIsAnyHardLink
-                 ? evk::hard_link
-                 : evk::other;
+/*  size_t */
+#include <cstddef>
+/*  uint64_t */
+#include <cstdint>
 
-        /* More than one thing might have happened to the same path.
-           (Which is why we use non-exclusive `if`s.) */
-        if (flag & kFSEventStreamEventFlagItemCreated) {
-          if (seen_created->find(path_str) == seen_created->end()) {
-            seen_created->emplace(path_str);
-            callback({path, evw::create, k});
-          }
-        }
-        if (flag & kFSEventStreamEventFlagItemRemoved) {
-          auto const& seen_created_at = seen_created->find(path_str);
-          if (seen_created_at != seen_created->end()) {
-            seen_created->erase(seen_created_at);
-            callback({path, evw::destroy, k});
-          }
+namespace wtr {
+inline namespace watcher {
+
+/*  @brief wtr/watcher/synthetic
+    A stream of made up events, for measuring everything
+    after the kernel: filters, collapsing and coalescing,
+    the callback and whatever it does. Nothing is read from
+    the kernel and nothing on disk is touched. The paths are
+    beneath the path being watched, which needn't exist.
+
+      auto w = watch(".", synthetic{.rate = 1e6, .skew = 1}, callback);
+
+    Or, with `WATER_WATCHER_USE_SYNTHETIC` defined, every
+    watcher is synthetic, and its stream is its policy's
+    `synthetic`, if it has one, or this one as it is.
+
+    - rate
+        Events per second, or 0 for as many as we can make.
+    - count
+        How many to make before stopping, or 0 for as many
+        as we can until the watcher is closed.
+    - files, dirs, depth
+        How many files there are, spread over how many
+        directories, each this many directories deep. Files
+        end in `.txt`, `.cpp`, `.hpp` or `.o`, in turn.
+    - skew
+        How some files are changed more than others: 0 for
+        all the same, or the exponent of a Zipf distribution,
+        where 1 is what a source tree under an editor and a
+        build looks like, and more is hotter still.
+    - shape, burst, pause_ms
+        How events are spaced: `steady`ly; in `bursts` of
+        `burst` events, at `rate`, with `pause_ms` between
+        them; or as a `poisson` process at `rate`.
+    - create, modify, destroy, rename
+        How often, relative to each other, each happens.
+    - seed
+        The same seed makes the same stream.
+
+    Events are stamped once for each `chunk` of them, like
+    those from one read of the kernel's queue. */
+struct synthetic {
+  enum class shape : unsigned char {
+    steady,
+    bursts,
+    poisson,
+  };
+
+  static constexpr std::size_t chunk = 256;
+
+  double rate{0};
+  std::uint64_t count{0};
+  std::size_t files{4096};
+  std::size_t dirs{64};
+  std::size_t depth{2};
+  double skew{0};
+  enum shape shape { shape::steady };
+  std::size_t burst{1000};
+  unsigned pause_ms{10};
+  unsigned create{1};
+  unsigned modify{6};
+  unsigned destroy{1};
+  unsigned rename{1};
+  std::uint64_t seed{1};
+};
+
+} /* namespace watcher */
+} /* namespace wtr */
+
+/*  find
+    sort
+    unique */
+#include <algorithm>
+/*  array */
+#include <array>
+/*  size_t */
+#include <cstddef>
+/*  uint8_t
+    uint32_t */
+#include <cstdint>
+/*  map */
+#include <map>
+/*  string */
+#include <string>
+/*  string_view */
+#include <string_view>
+/*  move */
+#include <utility>
+/*  vector */
+#include <vector>
+
+namespace detail {
+namespace wtr {
+namespace watcher {
+namespace filter {
+
+/*  @brief wtr/watcher/<d>/filter/glob
+    Matches paths against a list of glob patterns.
+
+    The patterns are compiled into one (nondeterministic)
+    automaton. We walk it one byte at a time, building a
+    deterministic automaton as we go: each set of places we
+    can be in the patterns becomes a state, and each state
+    remembers where every byte takes it. After a short
+    warm-up, walking a path is a table lookup per byte.
+
+    States can be kept. The state after "a/b/" is where
+    every name in "a/b" starts, so adapters keep one per
+    directory and only walk the names of what happens.
+
+    The syntax is that of `.gitignore`:
+      - `*` matches anything but a `/`.
+      - `?` matches one thing which isn't a `/`.
+      - `[a-z]`, `[!a-z]` and `[^a-z]` match (or don't
+        match) one thing in a set.
+      - `**` as a whole directory name matches any number
+        of directories (including none). At the end, it
+        matches anything beneath a directory.
+      - `\` makes the next character literal.
+      - A pattern with no `/` in it (besides at the end)
+        matches names at any depth. Otherwise, it matches
+        from the root. A leading `/` only anchors it.
+      - A pattern ending in `/` only matches directories.
+
+    When more than one pattern matches, the last one wins.
+    Anything beneath a directory which is dropped is dropped
+    as well, and that can't be undone by a later pattern. We
+    know this as soon as we walk past the directory's `/`,
+    so we go to a state which never leaves.
+
+    Building the automaton is not thread safe. Each watcher
+    has its own copy. */
+class glob {
+public:
+  using state = std::uint32_t;
+
+  enum class verdict : std::uint8_t { none, keep, drop };
+
+private:
+  enum class op : std::uint8_t { byte, any, set, star, rest, dirs, end };
+
+  struct token {
+    op o;
+    /* The byte, the set or the pattern, by `o`. */
+    std::uint32_t arg;
+  };
+
+  struct rule {
+    verdict on_match;
+    bool dir_only;
+  };
+
+  using positions = std::vector<std::uint32_t>;
+
+  static constexpr auto unknown = ~state{0};
+
+  std::vector<token> tokens{};
+  std::vector<std::array<bool, 256>> sets{};
+  std::vector<rule> rules{};
+  positions starts{};
+
+  /*  The lazily built automaton. */
+  struct node {
+    std::array<state, 256> next;
+    std::array<verdict, 2> decides;
+  };
+
+  std::vector<node> nodes{};
+  std::vector<positions> places{};
+  std::map<positions, state> known{};
+
+  /*  Follows the places which can match nothing. Any number
+      of directories end where a name starts: at the root, or
+      after a `/`, which is what `at_name` says. */
+  auto close(positions& at, bool at_name) const noexcept -> void
+  {
+    for (auto i = std::size_t{0}; i < at.size(); ++i) {
+      auto const o = this->tokens[at[i]].o;
+      if (o == op::star || o == op::rest || (o == op::dirs && at_name))
+        if (std::find(at.begin(), at.end(), at[i] + 1) == at.end())
+          at.push_back(at[i] + 1);
+    }
+    std::sort(at.begin(), at.end());
+    at.erase(std::unique(at.begin(), at.end()), at.end());
+  }
+
+  auto intern(positions&& at) -> state
+  {
+    if (auto s = this->known.find(at); s != this->known.end())
+      return s->second;
+
+    auto n = node{};
+    n.next.fill(unknown);
+    n.decides.fill(verdict::none);
+    /* Later patterns win, and positions are in pattern order. */
+    for (auto p : at)
+      if (this->tokens[p].o == op::end) {
+        auto const& r = this->rules[this->tokens[p].arg];
+        n.decides[1] = r.on_match;
+        if (! r.dir_only) n.decides[0] = r.on_match;
+      }
+
+    auto const s = static_cast<state>(this->nodes.size());
+    this->nodes.push_back(n);
+    this->places.push_back(at);
+    this->known.emplace(std::move(at), s);
+    return s;
+  }
+
+  auto build(state from, unsigned char b) -> state
+  {
+    auto at = positions{};
+    for (auto p : this->places[from]) {
+      auto const& t = this->tokens[p];
+      switch (t.o) {
+        case op::byte :
+          if (b == t.arg) at.push_back(p + 1);
+          break;
+        case op::any :
+          if (b != '/') at.push_back(p + 1);
+          break;
+        case op::set :
+          if (b != '/' && this->sets[t.arg][b]) at.push_back(p + 1);
+          break;
+        case op::star :
+          if (b != '/') at.push_back(p);
+          break;
+        case op::rest : at.push_back(p); break;
+        case op::dirs : at.push_back(p); break;
+        case op::end : break;
+      }
+    }
+    this->close(at, b == '/');
+    auto const to = b == '/' && this->nodes[from].decides[1] == verdict::drop
+                    ? pruned()
+                    : this->intern(std::move(at));
+    this->nodes[from].next[b] = to;
+    return to;
+  }
+
+  /*  Reads `[...]` from `p` at `i`, which is past the `[`.
+      Returns false, and leaves `i` alone, if it isn't a set. */
+  auto parse_set(std::string_view p, std::size_t& i) -> bool
+  {
+    auto s = std::array<bool, 256>{};
+    auto j = i;
+    auto negate = j < p.size() && (p[j] == '!' || p[j] == '^');
+    if (negate) ++j;
+    auto first = true;
+    for (; j < p.size() && (first || p[j] != ']'); ++j, first = false) {
+      auto lo = static_cast<unsigned char>(p[j]);
+      if (p[j] == '\\' && j + 1 < p.size())
+        lo = static_cast<unsigned char>(p[++j]);
+      auto hi = lo;
+      if (j + 2 < p.size() && p[j + 1] == '-' && p[j + 2] != ']') {
+        hi = static_cast<unsigned char>(p[j + 2]);
+        j += 2;
+      }
+      for (auto c = unsigned{lo}; c <= hi; ++c) s[c] = true;
+    }
+    if (j >= p.size()) return false;
+    if (negate)
+      for (auto& c : s) c = ! c;
+    this->tokens.push_back(
+      {op::set, static_cast<std::uint32_t>(this->sets.size())});
+    this->sets.push_back(s);
+    i = j + 1;
+    return true;
+  }
+
+  auto compile(std::string_view p, verdict on_match) -> void
+  {
+    auto const dir_only = p.size() > 1 && p.back() == '/'
+                       && p[p.size() - 2] != '\\';
+    if (dir_only) p.remove_suffix(1);
+    auto const anchored = p.find('/') != std::string_view::npos;
+    if (! p.empty() && p.front() == '/') p.remove_prefix(1);
+
+    this->starts.push_back(static_cast<std::uint32_t>(this->tokens.size()));
+    if (! anchored) this->tokens.push_back({op::dirs, 0});
+
+    for (auto i = std::size_t{0}; i < p.size();) {
+      auto const c = p[i];
+      if (c == '*') {
+        auto n = std::size_t{0};
+        while (i + n < p.size() && p[i + n] == '*') ++n;
+        auto const after_sep = i == 0 || p[i - 1] == '/';
+        auto const at_end = i + n == p.size();
+        auto const before_sep = ! at_end && p[i + n] == '/';
+        if (n >= 2 && after_sep && before_sep) {
+          this->tokens.push_back({op::dirs, 0});
+          i += n + 1;
         }
-        if (flag & kFSEventStreamEventFlagItemModified) {
-          callback({path, evw::modify, k});
+        else if (n >= 2 && after_sep && at_end) {
+          this->tokens.push_back({op::rest, 0});
+          i += n;
         }
-        if (flag & kFSEventStreamEventFlagItemRenamed) {
-          callback({path, evw::rename, k});
+        else {
+          this->tokens.push_back({op::star, 0});
+          i += n;
         }
       }
+      else if (c == '?') {
+        this->tokens.push_back({op::any, 0});
+        ++i;
+      }
+      else if (c == '[') {
+        if (! this->parse_set(p, ++i)) this->tokens.push_back({op::byte, '['});
+      }
+      else {
+        if (c == '\\' && i + 1 < p.size()) ++i;
+        this->tokens.push_back(
+          {op::byte, static_cast<unsigned char>(p[i++])});
+      }
+    }
+
+    this->tokens.push_back(
+      {op::end, static_cast<std::uint32_t>(this->rules.size())});
+    this->rules.push_back({on_match, dir_only});
+  }
+
+  /*  Makes the start state and, after it, the pruned state. */
+  auto begin(positions&& at) -> void
+  {
+    this->intern(std::move(at));
+    auto n = node{};
+    n.next.fill(pruned());
+    n.decides.fill(verdict::drop);
+    this->nodes.push_back(n);
+    this->places.push_back({});
+  }
+
+public:
+  glob() noexcept { this->begin(positions{}); }
+
+  /*  Each pattern is matched with what to do with what it
+      matches: keep it or drop it. */
+  glob(std::vector<std::pair<std::string, verdict>> const& patterns) noexcept
+  {
+    for (auto const& [p, v] : patterns) this->compile(p, v);
+    auto at = this->starts;
+    this->close(at, true);
+    this->begin(std::move(at));
+  }
+
+  auto empty() const noexcept -> bool { return this->rules.empty(); }
+
+  /*  Where every path starts: the root. */
+  static constexpr auto start() noexcept -> state { return 0; }
+
+  /*  Where everything beneath a dropped directory is. */
+  static constexpr auto pruned() noexcept -> state { return 1; }
+
+  /*  Walks `bytes` from `from`. */
+  auto walk(state from, std::string_view bytes) noexcept -> state
+  {
+    auto s = from;
+    for (auto c : bytes) {
+      auto const b = static_cast<unsigned char>(c);
+      auto const to = this->nodes[s].next[b];
+      s = to != unknown ? to : this->build(s, b);
     }
+    return s;
+  }
+
+  /*  What the last pattern to match a path which ends
+      at `at` says to do with it. */
+  auto decides(state at, bool is_dir) const noexcept -> verdict
+  {
+    return this->nodes[at].decides[is_dir ? 1 : 0];
   }
+
+  /*  The number of states built so far. */
+  auto size() const noexcept -> std::size_t { return this->nodes.size(); }
+};
+
+/*  @brief wtr/watcher/<d>/filter/beneath
+    The part of `path` which is beneath `root`, without a
+    leading separator. All of `path`, if it isn't beneath
+    `root`. */
+template<class Char>
+inline auto beneath(std::basic_string_view<Char> path,
+                    std::basic_string_view<Char> root) noexcept
+  -> std::basic_string_view<Char>
+{
+  if (path.substr(0, root.size()) == root) path.remove_prefix(root.size());
+  while (! path.empty() && (path.front() == '/' || path.front() == '\\'))
+    path.remove_prefix(1);
+  return path;
 }
 
-} /* namespace */
+} /* namespace filter */
+} /* namespace watcher */
+} /* namespace wtr */
+} /* namespace detail */
 
-inline bool watch(std::filesystem::path const& path,
-                  ::wtr::watcher::event::callback const& callback,
-                  std::function<bool()> const& is_living) noexcept
+/*  istreambuf_iterator */
+#include <iterator>
+/*  path
+    exists
+    is_directory
+    directory_options
+    recursive_directory_iterator */
+#include <filesystem>
+/*  ifstream */
+#include <fstream>
+/*  string */
+#include <string>
+/*  string_view */
+#include <string_view>
+/*  error_code */
+#include <system_error>
+/*  pair */
+#include <utility>
+/*  vector */
+#include <vector>
+/*  glob
+    beneath */
+
+namespace detail {
+namespace wtr {
+namespace watcher {
+namespace filter {
+namespace gitignore {
+
+using rule_list = std::vector<std::pair<std::string, glob::verdict>>;
+
+/*  @brief wtr/watcher/<d>/filter/gitignore/parse
+    The patterns in a `.gitignore` file, in order, with what
+    git does with what they match: ignore (drop) it or, for
+    a pattern starting with `!`, not ignore (keep) it.
+
+    Blank lines and lines starting with `#` are skipped, and
+    trailing spaces are trimmed unless they are escaped. */
+inline auto parse(std::string_view text) noexcept -> rule_list
 {
-  using evk = enum ::wtr::watcher::event::kind;
-  using evw = enum ::wtr::watcher::event::what;
-  using std::this_thread::sleep_for;
+  auto rules = rule_list{};
+  while (! text.empty()) {
+    auto const eol = text.find('\n');
+    auto line = text.substr(0, eol);
+    text.remove_prefix(eol == std::string_view::npos ? text.size() : eol + 1);
+
+    if (! line.empty() && line.back() == '\r') line.remove_suffix(1);
+    while (! line.empty() && line.back() == ' '
+           && ! (line.size() > 1 && line[line.size() - 2] == '\\'))
+      line.remove_suffix(1);
+    if (line.empty() || line.front() == '#') continue;
+
+    if (line.front() == '!')
+      rules.emplace_back(line.substr(1), glob::verdict::keep);
+    else
+      rules.emplace_back(line, glob::verdict::drop);
+  }
+  return rules;
+}
 
-  auto seen_created_paths = std::unordered_set<std::string>{};
-  auto event_recv_argptr = argptr_type{callback, &seen_created_paths};
+/*  @brief wtr/watcher/<d>/filter/gitignore/rebase
+    A pattern from the `.gitignore` in `dir` (relative to
+    the root, with forward slashes), as a pattern which is
+    relative to the root. */
+inline auto rebase(std::string_view dir, std::string_view pattern) noexcept
+  -> std::string
+{
+  if (dir.empty()) return std::string{pattern};
 
-  auto stream_resources =
-    event_stream_open(path, event_recv, event_recv_argptr);
+  auto rebased = std::string{};
+  for (auto c : dir) {
+    if (c == '*' || c == '?' || c == '[' || c == '\\') rebased += '\\';
+    rebased += c;
+  }
 
-  while (is_living())
-    if constexpr (has_delay) sleep_for(delay_ms);
+  auto const trimmed = pattern.size() > 1 && pattern.back() == '/'
+                       ? pattern.substr(0, pattern.size() - 1)
+                       : pattern;
+  auto const anchored = trimmed.find('/') != std::string_view::npos;
+  if (! pattern.empty() && pattern.front() == '/') pattern.remove_prefix(1);
 
-  auto died_ok = event_stream_close(std::move(stream_resources));
+  rebased += anchored ? "/" : "/**/";
+  rebased += pattern;
+  return rebased;
+}
 
-  if (died_ok)
-    callback({"s/self/die@" + path.string(), evw::destroy, evk::watcher});
+/*  @brief wtr/watcher/<d>/filter/gitignore/load
+    The rules from every `.gitignore` file beneath `root`
+    which git would read, as patterns relative to `root`.
 
-  else
-    callback({"e/self/die@" + path.string(), evw::destroy, evk::watcher});
+    The rules from a directory come after the rules from
+    its parents, so that they win, as they do for git.
 
-  return died_ok;
+    Git never looks inside `.git`, so neither do we. Nor do
+    we look inside directories which are ignored, because
+    nothing beneath them can be un-ignored. That is also
+    where most of the work would be. */
+inline auto load(std::filesystem::path const& root) noexcept -> rule_list
+{
+  namespace fs = ::std::filesystem;
+
+  static constexpr auto dopt = fs::directory_options::skip_permission_denied
+                             | fs::directory_options::follow_directory_symlink;
+
+  auto rules = rule_list{{".git/", glob::verdict::drop}};
+
+  auto read = [&rules](fs::path const& dir, std::string_view rel) noexcept
+  {
+    auto file = std::ifstream{dir / ".gitignore", std::ios::binary};
+    if (file.is_open()) {
+      auto text = std::string{std::istreambuf_iterator<char>{file},
+                              std::istreambuf_iterator<char>{}};
+      for (auto& [pattern, verdict] : parse(text))
+        rules.emplace_back(rebase(rel, pattern), verdict);
+      return true;
+    }
+    return false;
+  };
+
+  try {
+    read(root, "");
+    auto matcher = glob{rules};
+
+    auto ec = std::error_code{};
+    if (fs::is_directory(root, ec))
+      for (auto it = fs::recursive_directory_iterator{root, dopt, ec};
+           ! ec && it != fs::recursive_directory_iterator{};
+           it.increment(ec)) {
+        if (! it->is_directory(ec)) continue;
+
+        auto const generic = it->path().generic_string();
+        auto const rel = beneath<char>(generic, root.generic_string());
+
+        if (matcher.decides(matcher.walk(glob::start(), rel), true)
+            == glob::verdict::drop) {
+          it.disable_recursion_pending();
+          continue;
+        }
+
+        if (read(it->path(), rel)) matcher = glob{rules};
+      }
+  } catch (...) {}
+
+  return rules;
 }
 
-} /* namespace adapter */
+} /* namespace gitignore */
+} /* namespace filter */
 } /* namespace watcher */
-} /* namespace wtr   */
+} /* namespace wtr */
 } /* namespace detail */
 
-#endif /* if defined(WATER_WATCHER_PLATFORM_MAC_ANY) */
+/*  size_t */
+#include <cstddef>
+/*  path */
+#include <filesystem>
+/*  initializer_list */
+#include <initializer_list>
+/*  string */
+#include <string>
+/*  string_view */
+#include <string_view>
+/*  pair */
+#include <utility>
+/*  vector */
+#include <vector>
+/*  glob */
+/*  gitignore::load */
+/*  event */
 
-/*  @brief wtr/watcher/<d>/adapter/linux/fanotify
-    The Linux `fanotify` adapter. */
+namespace wtr {
+inline namespace watcher {
 
-/*  WATER_WATCHER_PLATFORM_* */
+/*  @brief wtr/watcher/filter
+    Decides which paths we send events for.
 
-#if defined(WATER_WATCHER_PLATFORM_LINUX_KERNEL_GTE_5_9_0) \
-  && ! defined(WATER_WATCHER_PLATFORM_ANDROID_ANY)
-#if ! defined(WATER_WATCHER_USE_WARTHOG)
+    A filter is a list of glob patterns, with the syntax
+    of `.gitignore`. Paths are matched relative to the
+    path being watched. A pattern keeps what it matches,
+    unless it starts with `!`, in which case it drops
+    what it matches. The last pattern to match a path
+    decides.
 
-#define WATER_WATCHER_ADAPTER_LINUX_FANOTIFY
+    If any pattern keeps things, then nothing else is
+    kept. Otherwise, everything which isn't dropped is.
+    Everything beneath a directory which is dropped is
+    dropped, too.
 
-/*  O_* */
-#include <fcntl.h>
-/*  EPOLL*
-    epoll_ctl
-    epoll_wait
-    epoll_event
-    epoll_create1 */
-#include <sys/epoll.h>
-/*  FAN_*
-    fanotify_mark
-    fanotify_init
-    fanotify_event_metadata */
-#include <sys/fanotify.h>
-/*  open
-    close
-    readlink */
-#include <unistd.h>
-/*  errno */
-#include <cerrno>
-/*  PATH_MAX */
-#include <climits>
-/*  snprintf */
-#include <cstdio>
-/*  strerror */
-#include <cstring>
+    Events from the watcher are always sent.
+
+    The adapters match the names which the system gives
+    them, before anything is made out of them, so paths
+    which are dropped cost (almost) nothing.
+
+    Typical use looks like this:
+
+    // Object files, but not the ones in `vendor`
+    auto w = watch(".", filter{"*.o", "!vendor/"}, callback);
+
+    // Everything but `.git` and `build`
+    auto w = watch(".", filter{"!.git/", "!build/"}, callback);
+
+    // What git would track, and nothing in `build`
+    auto w = watch(".", filter::gitignore({"!build/"}), callback);
+
+    A filter made with `gitignore` reads the `.gitignore`
+    files beneath the path being watched, in the way that
+    git does, and drops what they ignore (and `.git`).
+    Those rules come first, so the patterns given to it win.
+    Whether it keeps everything which isn't dropped depends
+    on those patterns alone. When a `.gitignore` changes,
+    the adapters read them again.
+
+    Directories are watched whether or not they are kept,
+    so the things in them can be, unless everything in them
+    is dropped. Then, where it is up to us, the directory
+    isn't watched at all. */
+class filter {
+  using glob = ::detail::wtr::watcher::filter::glob;
+
+  /* The automaton is built as it is walked. */
+  mutable glob compiled{};
+  glob::verdict otherwise{glob::verdict::keep};
+  /* What we were given, for when the `.gitignore`s change. */
+  std::vector<std::string> patterns{};
+  bool from_gitignore{false};
+
+  static auto parse(std::vector<std::string> const& patterns) noexcept
+    -> std::vector<std::pair<std::string, glob::verdict>>
+  {
+    auto parsed = std::vector<std::pair<std::string, glob::verdict>>{};
+    for (auto const& p : patterns)
+      if (! p.empty() && p.front() == '!')
+        parsed.emplace_back(p.substr(1), glob::verdict::drop);
+      else if (! p.empty())
+        parsed.emplace_back(p, glob::verdict::keep);
+    return parsed;
+  }
+
+public:
+  using state = glob::state;
+
+  /*  Keeps everything. */
+  filter() noexcept = default;
+
+  filter(std::vector<std::string> const& patterns) noexcept
+      : compiled{parse(patterns)},
+        patterns{patterns}
+  {
+    for (auto const& p : patterns)
+      if (! p.empty() && p.front() != '!') this->otherwise = glob::verdict::drop;
+  }
+
+  filter(std::initializer_list<std::string_view> patterns) noexcept
+      : filter{std::vector<std::string>(patterns.begin(), patterns.end())}
+  {}
+
+  /*  Drops what the `.gitignore` files beneath the path
+      being watched ignore, and then does what `patterns`
+      say. */
+  static auto gitignore(std::vector<std::string> const& patterns = {}) noexcept
+    -> filter
+  {
+    auto f = filter{patterns};
+    f.from_gitignore = true;
+    return f;
+  }
+
+  static auto gitignore(std::initializer_list<std::string_view> patterns) noexcept
+    -> filter
+  {
+    return gitignore(std::vector<std::string>(patterns.begin(), patterns.end()));
+  }
+
+  /*  This filter, with the `.gitignore` files beneath `root`
+      read, if it was made with `gitignore`. The adapters
+      use this when they start, and when `reloads` says so. */
+  auto loaded(std::filesystem::path const& root) const noexcept -> filter
+  {
+    if (! this->from_gitignore) return *this;
+    auto rules = ::detail::wtr::watcher::filter::gitignore::load(root);
+    for (auto&& r : parse(this->patterns)) rules.push_back(std::move(r));
+    auto f = *this;
+    f.compiled = glob{rules};
+    return f;
+  }
+
+  /*  Whether something happening to `name` means that
+      this filter should be loaded again. */
+  template<class Char>
+  auto reloads(std::basic_string_view<Char> name) const noexcept -> bool
+  {
+    constexpr char gitignore_name[] = ".gitignore";
+    if (! this->from_gitignore || name.size() != sizeof gitignore_name - 1)
+      return false;
+    for (auto i = std::size_t{0}; i < name.size(); ++i)
+      if (name[i] != static_cast<Char>(gitignore_name[i])) return false;
+    return true;
+  }
+
+  /*  Whether this filter keeps everything. */
+  auto empty() const noexcept -> bool { return this->compiled.empty(); }
+
+  /*  The state at the root, before anything is walked. */
+  static constexpr auto start() noexcept -> state { return glob::start(); }
+
+  /*  The state after walking `bytes`. Walk a directory's
+      name and a `/` to get a state which its things start
+      from. */
+  auto walk(state from, std::string_view bytes) const noexcept -> state
+  {
+    return this->compiled.walk(from, bytes);
+  }
+
+  /*  Whether everything beneath the directory which was
+      walked to `at` is dropped. */
+  auto prunes(state at) const noexcept -> bool
+  {
+    return at == glob::pruned()
+        || this->compiled.decides(at, true) == glob::verdict::drop;
+  }
+
+  /*  Whether the path which was walked to `at` is kept. */
+  auto keeps(state at, enum event::kind kind) const noexcept -> bool
+  {
+    auto const v = this->compiled.decides(at, kind == event::kind::dir);
+    return (v == glob::verdict::none ? this->otherwise : v)
+        == glob::verdict::keep;
+  }
+
+  /*  Whether `path`, relative to the root, is kept. */
+  auto keeps(std::string_view path, enum event::kind kind) const noexcept
+    -> bool
+  {
+    return this->empty() || this->keeps(this->walk(start(), path), kind);
+  }
+};
+
+} /* namespace watcher */
+} /* namespace wtr   */
+
+/*  uint32_t */
+#include <cstdint>
+/*  path */
+#include <filesystem>
+/*  function */
+#include <functional>
+/*  vector */
+#include <vector>
+
+namespace detail {
+namespace wtr {
+namespace watcher {
+namespace adapter {
+
+/*  @brief wtr/watcher/<d>/adapter/change
+    A root added to, or removed from, a watcher which is
+    running. `root` is its place among the watcher's roots,
+    which is what its events say. A removed root's place
+    isn't given to another, so the others keep theirs.
+
+    The adapters take what has changed as they go, between
+    reads, from `changes_fn`, and watch (or stop watching)
+    only the tree beneath that root. */
+struct change {
+  enum class what { add, remove };
+
+  enum what what {};
+  std::uint32_t root{};
+  std::filesystem::path path{};
+};
+
+using changes_type = std::vector<change>;
+
+using changes_fn = std::function<changes_type()>;
+
+} /* namespace adapter */
+} /* namespace watcher */
+} /* namespace wtr */
+} /* namespace detail */
+
+/*  WATER_WATCHER_PLATFORM_* */
+
+#if defined(WATER_WATCHER_PLATFORM_LINUX_KERNEL_GTE_2_7_0) \
+  || defined(WATER_WATCHER_PLATFORM_ANDROID_ANY)
+#if ! defined(WATER_WATCHER_USE_WARTHOG)
+
+/*  size_t */
+#include <cstddef>
+/*  uint32_t
+    uint64_t */
+#include <cstdint>
 /*  path
-    is_directory
-    directory_options
-    recursive_directory_iterator */
+    weakly_canonical */
+#include <filesystem>
+/*  string */
+#include <string>
+/*  string_view */
+#include <string_view>
+/*  error_code */
+#include <system_error>
+/*  vector */
+#include <vector>
+/*  event
+    batch
+    policy
+    trace
+    diag
+    metrics
+    filter */
+
+namespace detail {
+namespace wtr {
+namespace watcher {
+namespace adapter {
+
+/*  @brief wtr/watcher/<d>/adapter/linux/sys_of
+    What an adapter calls to read from the kernel and to
+    mark what it watches: the `sys` in `Policy`, if there
+    is one, or the adapter's own `Kernel`, which makes
+    those calls. A policy's `sys` can record what the
+    kernel says, or play it back. See `replay`. */
+template<class Policy, class Kernel>
+struct sys_of_type {
+  using type = Kernel;
+};
+
+template<class Policy, class Kernel>
+requires requires { typename Policy::sys; }
+struct sys_of_type<Policy, Kernel> {
+  using type = typename Policy::sys;
+};
+
+template<class Policy, class Kernel>
+using sys_of = typename sys_of_type<Policy, Kernel>::type;
+
+/*  @brief wtr/watcher/<d>/adapter/linux/sink
+    Where the Linux adapters send what they read.
+
+    Events go to `each`, one at a time. If there is a
+    callback for `batches`, each read from the kernel goes
+    to it instead, as it is, and only the messages from
+    the watcher go to `each`.
+
+    Everything from one read is stamped once, from `clock`.
+
+    What the watcher says about itself is `tell`'d. It goes
+    to `diags`, if there is a callback for them, or to
+    `each` as a message, if there isn't.
+
+    What is sent to `each` is counted in `counts`, if we
+    have somewhere to count it. See `metrics`.
+
+    `Each` is whatever the user gave us (or a small wrapper
+    around it), so that the adapters, which are templates
+    on their sink, call it directly. It is only a
+    `std::function` when that's what we were given.
+
+    `Policy` is what the adapters were told when they were
+    compiled. See `policy`. Its `trace` hears about each
+    event sent. See `trace`. */
+template<class Each = ::wtr::watcher::event::compact::callback,
+         class Policy = ::wtr::watcher::policy>
+struct sink {
+  using policy = Policy;
+
+  Each each{};
+  ::wtr::watcher::batch::callback batches{};
+  enum ::wtr::watcher::event::clock clock {};
+  ::wtr::watcher::diag::callback diags{};
+  ::wtr::watcher::metrics* counts{};
+
+  auto operator()(::wtr::watcher::event::compact const& ev) const noexcept
+    -> void
+  {
+    using trace = typename Policy::trace;
+
+    auto const send = [&]() noexcept
+    {
+      if (this->counts)
+        this->counts->sent([&]() noexcept { this->each(ev); });
+      else
+        this->each(ev);
+    };
+
+    if constexpr (trace::on) {
+      trace::send_begin(ev.what, ev.kind);
+      auto const began = trace::now();
+      send();
+      trace::send_end(trace::now() - began);
+    }
+    else
+      send();
+  }
+
+  auto tell(::wtr::watcher::diag const& d) const noexcept -> void
+  {
+    if (this->diags)
+      this->diags(d);
+    else
+      this->each(::wtr::watcher::event::compact{
+        d.message(),
+        d.what(),
+        ::wtr::watcher::event::kind::watcher});
+  }
+};
+
+/*  @brief wtr/watcher/<d>/adapter/linux/counted_read
+    Counts a read of `len` bytes from the kernel into our
+    buffer of `cap` bytes. The read is full if a record of
+    `longest` bytes might not have fit after it. When we
+    are `done` with what was read, the events sent from it
+    are counted as well. */
+struct counted_read {
+  ::wtr::watcher::metrics* counts{};
+  std::uint64_t events_before{};
+
+  counted_read(::wtr::watcher::metrics* counts,
+               long len,
+               std::size_t cap,
+               std::size_t longest) noexcept
+      : counts{counts}
+  {
+    using ::wtr::watcher::metrics;
+    if (! counts) return;
+    metrics::add(counts->reads);
+    if (len > 0) {
+      metrics::add(counts->bytes_read, (std::uint64_t)len);
+      if ((std::size_t)len + longest > cap) metrics::add(counts->full_reads);
+    }
+    this->events_before = counts->events.load(std::memory_order_relaxed);
+  }
+
+  auto done() const noexcept -> void
+  {
+    if (! this->counts) return;
+    this->counts->read_events.record(
+      this->counts->events.load(std::memory_order_relaxed)
+      - this->events_before);
+  }
+};
+
+/*  @brief wtr/watcher/<d>/adapter/linux/tally
+    Warnings of one sort, from one walk through a tree,
+    such as every directory we couldn't watch. As messages,
+    each is sent as it happens. To a diagnostic callback,
+    they are counted and sent once, with the first of them,
+    when the walk is `done`. */
+struct tally {
+  ::wtr::watcher::diag first{};
+  std::string also{};
+  std::size_t count{0};
+
+  template<class Sink>
+  auto operator()(Sink const& sink, ::wtr::watcher::diag const& d) noexcept
+    -> void
+  {
+    if (! sink.diags) return sink.tell(d);
+    if (this->count++ == 0) {
+      this->first = d;
+      this->also.assign(d.also);
+    }
+  }
+
+  template<class Sink>
+  auto done(Sink const& sink) noexcept -> void
+  {
+    if (this->count == 0) return;
+    auto d = this->first;
+    d.also = this->also;
+    d.count = this->count;
+    this->count = 0;
+    sink.tell(d);
+  }
+};
+
+/*  @brief wtr/watcher/<d>/adapter/linux/watched_root
+    One of the paths a watcher was given, with its own copy
+    of the filter, which reads the `.gitignore`s beneath it
+    if it should, and where it really is, without symlinks
+    or relative parts, which is what the kernel tells us.
+    A root's place among them is what its events say they
+    happened beneath. See `event::root`. */
+struct watched_root {
+  std::filesystem::path path{};
+  std::string real{};
+  ::wtr::watcher::filter live{};
+};
+
+using roots_type = std::vector<watched_root>;
+
+inline auto roots_of(std::vector<std::filesystem::path> const& paths,
+                     ::wtr::watcher::filter const& filter) noexcept
+  -> roots_type
+{
+  auto roots = roots_type{};
+  roots.reserve(paths.size());
+  for (auto const& path : paths) {
+    auto ec = std::error_code{};
+    roots.push_back({path,
+                     std::filesystem::weakly_canonical(path, ec).native(),
+                     filter.loaded(path)});
+  }
+  return roots;
+}
+
+/*  @brief wtr/watcher/<d>/adapter/linux/root_of
+    Which of `roots` the directory `dir` is beneath (or is).
+    Where roots overlap, the deepest of them. As many as
+    there are roots, if none of them. Roots which were
+    removed are empty, and nothing is beneath them. */
+inline auto root_of(std::string_view dir, roots_type const& roots) noexcept
+  -> std::uint32_t
+{
+  auto found = (std::uint32_t)roots.size();
+  auto depth = std::size_t{0};
+  for (auto n = std::uint32_t{0}; n < roots.size(); ++n) {
+    auto const real = std::string_view{roots[n].real};
+    if (! real.empty() && real.size() >= depth && dir.starts_with(real)
+        && (dir.size() == real.size() || dir[real.size()] == '/'
+            || real.ends_with('/'))) {
+      found = n;
+      depth = real.size();
+    }
+  }
+  return found;
+}
+
+} /* namespace adapter */
+} /* namespace watcher */
+} /* namespace wtr */
+} /* namespace detail */
+
+#endif /* !defined(WATER_WATCHER_USE_WARTHOG) */
+#endif /* defined(WATER_WATCHER_PLATFORM_LINUX_KERNEL_GTE_2_7_0) \
+          || defined(WATER_WATCHER_PLATFORM_ANDROID_ANY) */
+
+/*
+  @brief watcher/adapter/windows
+
+  The Windows `ReadDirectoryChangesW` adapter.
+*/
+
+
+#if defined(WATER_WATCHER_PLATFORM_WINDOWS_ANY)
+
+/* ReadDirectoryChangesW
+   CreateIoCompletionPort
+   CreateFileW
+   CreateEventW
+   GetQueuedCompletionStatus
+   ResetEvent
+   GetLastError
+   WideCharToMultiByte */
+#include <windows.h>
+/* milliseconds */
+#include <chrono>
+/* path */
+#include <filesystem>
+/* string
+   wstring */
+#include <string>
+/* string_view */
+#include <string_view>
+/* this_thread::sleep_for */
+#include <thread>
+/* event
+   callback
+   filter */
+
+namespace detail {
+namespace wtr {
+namespace watcher {
+namespace adapter {
+namespace {
+
+inline constexpr auto delay_ms = std::chrono::milliseconds(16);
+inline constexpr auto delay_ms_dw = static_cast<DWORD>(delay_ms.count());
+inline constexpr auto has_delay = delay_ms > std::chrono::milliseconds(0);
+/* I think the default page size in Windows is 64kb,
+   so 65536 might also work well. */
+inline constexpr auto event_buf_len_max = 8192;
+
+/* Hold resources necessary to recieve and send filesystem events. */
+class watch_event_proxy {
+public:
+  bool is_valid{true};
+
+  std::filesystem::path path{};
+
+  wchar_t path_name[256]{L""};
+
+  HANDLE path_handle{nullptr};
+
+  HANDLE event_completion_token{nullptr};
+
+  HANDLE event_token{CreateEventW(nullptr, true, false, nullptr)};
+
+  OVERLAPPED event_overlap{};
+
+  FILE_NOTIFY_INFORMATION event_buf[event_buf_len_max];
+
+  DWORD event_buf_len_ready{0};
+
+  watch_event_proxy(std::filesystem::path const& path) noexcept
+      : path{path}
+  {
+    memcpy(path_name, path.c_str(), path.string().size());
+
+    path_handle =
+      CreateFileW(path.c_str(),
+                  FILE_LIST_DIRECTORY,
+                  FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                  nullptr,
+                  OPEN_EXISTING,
+                  FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED,
+                  nullptr);
+
+    if (path_handle)
+      event_completion_token =
+        CreateIoCompletionPort(INVALID_HANDLE_VALUE, nullptr, 0, 0);
+
+    if (event_completion_token)
+      is_valid = CreateIoCompletionPort(path_handle,
+                                        event_completion_token,
+                                        (ULONG_PTR)path_handle,
+                                        1)
+              && ResetEvent(event_token);
+  }
+
+  ~watch_event_proxy() noexcept
+  {
+    if (event_token) CloseHandle(event_token);
+    if (event_completion_token) CloseHandle(event_completion_token);
+  }
+};
+
+inline bool is_valid(watch_event_proxy& w) noexcept
+{
+  return w.is_valid && w.event_buf != nullptr;
+}
+
+inline bool has_event(watch_event_proxy& w) noexcept
+{
+  return w.event_buf_len_ready != 0;
+}
+
+inline bool
+do_event_recv(watch_event_proxy& w,
+              ::wtr::watcher::event::callback const& callback) noexcept
+{
+  using namespace ::wtr::watcher;
+
+  w.event_buf_len_ready = 0;
+  DWORD bytes_returned = 0;
+  memset(&w.event_overlap, 0, sizeof(OVERLAPPED));
+
+  auto read_ok = ReadDirectoryChangesW(
+    w.path_handle,
+    w.event_buf,
+    event_buf_len_max,
+    true,
+    FILE_NOTIFY_CHANGE_SECURITY | FILE_NOTIFY_CHANGE_CREATION
+      | FILE_NOTIFY_CHANGE_LAST_ACCESS | FILE_NOTIFY_CHANGE_LAST_WRITE
+      | FILE_NOTIFY_CHANGE_SIZE | FILE_NOTIFY_CHANGE_ATTRIBUTES
+      | FILE_NOTIFY_CHANGE_DIR_NAME | FILE_NOTIFY_CHANGE_FILE_NAME,
+    &bytes_returned,
+    &w.event_overlap,
+    nullptr);
+
+  if (w.event_buf && read_ok) {
+    w.event_buf_len_ready = bytes_returned > 0 ? bytes_returned : 0;
+    return true;
+  }
+  else {
+    switch (GetLastError()) {
+      case ERROR_IO_PENDING :
+        w.event_buf_len_ready = 0;
+        w.is_valid = false;
+        callback({"e/sys/read/pending",
+                  ::wtr::event::what::other,
+                  ::wtr::event::kind::watcher});
+        break;
+      default :
+        callback({"e/sys/read",
+                  ::wtr::event::what::other,
+                  ::wtr::event::kind::watcher});
+        break;
+    }
+    return false;
+  }
+}
+
+/*  The name, relative to the watched path, as utf8 with
+    forward slashes, which is what filters match. */
+inline auto filter_name(FILE_NOTIFY_INFORMATION const* buf) noexcept
+  -> std::string
+{
+  auto const len = static_cast<int>(buf->FileNameLength / 2);
+  auto name = std::string{};
+  auto n =
+    WideCharToMultiByte(CP_UTF8, 0, buf->FileName, len, nullptr, 0, 0, 0);
+  if (n > 0) {
+    name.resize(static_cast<std::size_t>(n));
+    WideCharToMultiByte(CP_UTF8, 0, buf->FileName, len, name.data(), n, 0, 0);
+    for (auto& c : name)
+      if (c == '\\') c = '/';
+  }
+  return name;
+}
+
+inline bool
+do_event_send(watch_event_proxy& w,
+              ::wtr::watcher::filter& filter,
+              ::wtr::watcher::event::callback const& callback) noexcept
+{
+  using namespace ::wtr::watcher;
+
+  FILE_NOTIFY_INFORMATION* buf = w.event_buf;
+
+  if (is_valid(w)) {
+    while (buf + sizeof(FILE_NOTIFY_INFORMATION)
+           <= buf + w.event_buf_len_ready) {
+      /* Match the name before we make anything out of it.
+         We don't know its kind yet, so we can only skip it
+         if it isn't kept either way. */
+      auto name = filter.empty() ? std::string{} : filter_name(buf);
+      auto state = filter.walk(filter.start(), name);
+      auto maybe_kept = filter.empty()
+                     || filter.keeps(state, event::kind::file)
+                     || filter.keeps(state, event::kind::dir);
+      auto reload = filter.reloads(
+        std::string_view{name}.substr(name.rfind('/') + 1));
+
+      if (buf->FileNameLength % 2 == 0 && maybe_kept) {
+        auto where =
+          w.path / std::wstring{buf->FileName, buf->FileNameLength / 2};
+
+        auto what = [&buf]() noexcept
+        {
+          switch (buf->Action) {
+            case FILE_ACTION_MODIFIED : return event::what::modify;
+            case FILE_ACTION_ADDED : return event::what::create;
+            case FILE_ACTION_REMOVED : return event::what::destroy;
+            case FILE_ACTION_RENAMED_OLD_NAME : return event::what::rename;
+            case FILE_ACTION_RENAMED_NEW_NAME : return event::what::rename;
+            default : return event::what::other;
+          }
+        }();
+
+        auto kind = [&where]()
+        {
+          try {
+            return std::filesystem::is_directory(where) ? event::kind::dir
+                                                        : event::kind::file;
+          } catch (...) {
+            return event::kind::other;
+          }
+        }();
+
+        if (filter.empty() || filter.keeps(state, kind))
+          callback({where, what, kind});
+      }
+
+      /* A `.gitignore` changed. */
+      if (reload) filter = filter.loaded(w.path);
+
+      if (buf->NextEntryOffset == 0)
+        break;
+      else
+        buf = (FILE_NOTIFY_INFORMATION*)((uint8_t*)buf + buf->NextEntryOffset);
+    }
+    return true;
+  }
+
+  else {
+    return false;
+  }
+}  // namespace
+
+}  // namespace
+
+/* while living
+   watch for events
+   return when dead
+   true if no errors */
+
+inline bool watch(std::filesystem::path const& path,
+                  ::wtr::watcher::filter const& filter,
+                  ::wtr::watcher::event::callback const& callback,
+                  std::function<bool()> const& is_living) noexcept
+{
+  using namespace ::wtr::watcher;
+
+  auto w = watch_event_proxy{path};
+
+  /* Our own copy, which reads the `.gitignore`s if it should. */
+  auto live = filter.loaded(path);
+
+  if (is_valid(w)) {
+    do_event_recv(w, callback);
+
+    while (is_valid(w) && has_event(w)) { do_event_send(w, live, callback); }
+
+    while (is_living()) {
+      ULONG_PTR completion_key{0};
+      LPOVERLAPPED overlap{nullptr};
+
+      bool complete = GetQueuedCompletionStatus(w.event_completion_token,
+                                                &w.event_buf_len_ready,
+                                                &completion_key,
+                                                &overlap,
+                                                delay_ms_dw);
+
+      if (complete && overlap) {
+        while (is_valid(w) && has_event(w)) {
+          do_event_send(w, live, callback);
+          do_event_recv(w, callback);
+        }
+      }
+    }
+
+    callback({"s/self/die@" + path.string(),
+              ::wtr::event::what::destroy,
+              ::wtr::event::kind::watcher});
+
+    return true;
+  }
+  else {
+    callback({"s/self/die@" + path.string(),
+              ::wtr::event::what::destroy,
+              ::wtr::event::kind::watcher});
+    return false;
+  }
+}
+
+}  // namespace adapter
+}  // namespace watcher
+}  // namespace wtr
+} /* namespace detail */
+
+#endif /* defined(WATER_WATCHER_PLATFORM_WINDOWS_ANY) */
+
+/* WATER_WATCHER_PLATFORM_* */
+
+#if defined(WATER_WATCHER_PLATFORM_MAC_ANY)
+
+/*
+  @brief watcher/adapter/darwin
+
+  The Darwin `FSEvent` adapter.
+*/
+
+/* kFS*
+   FS*
+   CF*
+   dispatch_queue* */
+#include <CoreServices/CoreServices.h>
+/* milliseconds */
+#include <chrono>
+/* function */
+#include <functional>
+/* path
+   weakly_canonical */
+#include <filesystem>
+/* numeric_limits */
+#include <limits>
+/* mt19937
+   random_device
+   uniform_int_distribution */
+#include <random>
+/* string
+   to_string */
+#include <string>
+/* error_code */
+#include <system_error>
+/* sleep_for */
+#include <thread>
+/* tuple
+   make_tuple */
+#include <tuple>
+/* vector */
+#include <vector>
+/* snprintf */
+#include <cstdio>
+/* unordered_set */
+#include <unordered_set>
+/* event
+   callback
+   filter
+   beneath */
+
+namespace detail {
+namespace wtr {
+namespace watcher {
+namespace adapter {
+namespace {
+
+struct argptr_type {
+  ::wtr::watcher::event::callback const& callback;
+  std::unordered_set<std::string>* seen_created_paths;
+  /* Our own copy, which reads the `.gitignore`s if it should. */
+  ::wtr::watcher::filter filter;
+  std::string root;
+};
+
+inline constexpr auto delay_ms = std::chrono::milliseconds(16);
+inline constexpr auto delay_s =
+  std::chrono::duration_cast<std::chrono::seconds>(delay_ms);
+inline constexpr auto has_delay = delay_ms.count() > 0;
+
+inline constexpr auto time_flag = kFSEventStreamEventIdSinceNow;
+
+/* We could OR `event_stream_flags` with `kFSEventStreamCreateFlagNoDefer` if we
+   want less "sleepy" time after a period of no filesystem events. But we're
+   talking about saving a maximum latency of `delay_ms` after some period of
+   inactivity -- very small. (Not sure what the inactivity period is.) */
+inline constexpr unsigned event_stream_flags =
+  kFSEventStreamCreateFlagFileEvents | kFSEventStreamCreateFlagUseExtendedData
+  | kFSEventStreamCreateFlagUseCFTypes;
+
+inline constexpr unsigned kFSEventStreamEventFlagItemIsAnyHardLink =
+  kFSEventStreamEventFlagItemIsHardlink
+  | kFSEventStreamEventFlagItemIsLastHardlink;
+
+inline std::tuple<FSEventStreamRef, dispatch_queue_t>
+event_stream_open(std::filesystem::path const& path,
+                  FSEventStreamCallback funcptr,
+                  argptr_type const& funcptr_args) noexcept
+{
+  static constexpr CFIndex path_array_size = 1;
+  static constexpr auto queue_priority = -10;
+
+  auto funcptr_context =
+    FSEventStreamContext{0, (void*)&funcptr_args, nullptr, nullptr, nullptr};
+  /* Creating this untyped array of strings is unavoidable.
+     `path_cfstring` and `path_cfarray_cfstring` must be temporaries because
+     `CFArrayCreate` takes the address of a string and `FSEventStreamCreate` the
+     address of an array (of strings). There might be some UB around here. */
+  void const* path_cfstring =
+    CFStringCreateWithCString(nullptr, path.c_str(), kCFStringEncodingUTF8);
+  CFArrayRef path_array = CFArrayCreate(nullptr,
+                                        &path_cfstring,
+                                        path_array_size,
+                                        &kCFTypeArrayCallBacks);
+
+  /* The event queue name doesn't seem to need to be unique.
+     We try to make a unique name anyway, just in case.
+     The event queue name will be:
+       = "wtr" + [0, 28) character number
+     And will always be a string between 5 and 32-characters long:
+       = 3 (prefix) + [1, 28] (digits) + 1 (null char from snprintf) */
+  char queue_name[3 + 28 + 1]{};
+  std::mt19937 gen(std::random_device{}());
+  std::snprintf(queue_name,
+                sizeof(queue_name),
+                "wtr%zu",
+                std::uniform_int_distribution<size_t>(
+                  0,
+                  std::numeric_limits<size_t>::max())(gen));
+
+  /* Request a file event stream for `path` from the kernel
+     which invokes `funcptr` with `funcptr_context` on events. */
+  FSEventStreamRef stream = FSEventStreamCreate(
+    nullptr,           /* Custom allocator, optional */
+    funcptr,           /* A callable to invoke on changes */
+    &funcptr_context,  /* The callable's arguments (context). */
+    path_array,        /* The path we were asked to watch */
+    time_flag,         /* The time "since when" we receive events */
+    delay_s.count(),   /* The time between scans after inactivity */
+    event_stream_flags /* The event stream flags */
+  );
+
+  /* Request a (very) high priority queue. */
+  dispatch_queue_t queue = dispatch_queue_create(
+    queue_name,
+    dispatch_queue_attr_make_with_qos_class(DISPATCH_QUEUE_SERIAL,
+                                            QOS_CLASS_USER_INITIATED,
+                                            queue_priority));
+
+  FSEventStreamSetDispatchQueue(stream, queue);
+
+  FSEventStreamStart(stream);
+
+  return std::make_tuple(stream, queue);
+}
+
+/* @note
+   The functions we use to close the stream and queue take `_Nonnull`
+   parameters, so we should be able to take `const&` for our arguments.
+   We don't because it would be misleading. `stream` and `queue` are
+   eventually null (and always invalid) after the calls we make here.
+
+   @note
+   Assuming macOS > 10.8 or iOS > 6.0, we don't need to check for null on the
+   dispatch queue after we release it:
+     https://developer.apple.com/documentation/dispatch/1496328-dispatch_release
+*/
+inline bool event_stream_close(
+  std::tuple<FSEventStreamRef, dispatch_queue_t>&& resources) noexcept
+{
+  auto [stream, queue] = resources;
+  if (stream) {
+    FSEventStreamStop(stream);
+    FSEventStreamInvalidate(stream);
+    FSEventStreamRelease(stream);
+    if (queue) {
+      dispatch_release(queue);
+      return true;
+    }
+    else
+      return false;
+  }
+  else
+    return false;
+}
+
+inline char const* path_from_event_at(void* event_recv_paths,
+                                      unsigned long i) noexcept
+{
+  /*  We make a path from a C string...
+      In an array, in a dictionary...
+      Without type safety...
+      Because most of darwin's apis are `void*`-typed.
+
+      We should be guarenteed that nothing in here is
+      or can be null, but I'm skeptical. We ask Darwin
+      for utf8 strings from a dictionary of utf8 strings
+      which it gave us. Nothing should be able to be null.
+      We'll check anyway, just in case Darwin lies. */
+
+  auto cstr =
+    CFStringGetCStringPtr(static_cast<CFStringRef>(CFDictionaryGetValue(
+                            static_cast<CFDictionaryRef>(CFArrayGetValueAtIndex(
+                              static_cast<CFArrayRef>(event_recv_paths),
+                              static_cast<CFIndex>(i))),
+                            kFSEventStreamEventExtendedDataPathKey)),
+                          kCFStringEncodingUTF8);
+
+  return cstr;
+}
+
+/* @note
+   Sometimes events are batched together and re-sent
+   (despite having already been sent).
+   Example:
+     [first batch of events from the os]
+     file 'a' created
+     -> create event for 'a' is sent
+     [some tiny delay, 1 ms or so]
+     [second batch of events from the os]
+     file 'a' destroyed
+     -> create event for 'a' is sent
+     -> destroy event for 'a' is sent
+   So, we filter out duplicate events when they're sent
+   in a batch. We do this by storing and pruning the
+   set of paths which we've seen created. */
+inline void event_recv(ConstFSEventStreamRef,    /* `ConstFS..` is important */
+                       void* arg_ptr,            /* Arguments passed to us */
+                       unsigned long recv_count, /* Event count */
+                       void* recv_paths,         /* Paths with events */
+                       unsigned int const* recv_flags, /* Event flags */
+                       FSEventStreamEventId const*     /* event stream id */
+                       ) noexcept
+{
+  using evk = enum ::wtr::watcher::event::kind;
+  using evw = enum ::wtr::watcher::event::what;
+
+  if (arg_ptr && recv_paths) {
+
+    auto& [callback, seen_created, filter, root] =
+      *static_cast<argptr_type*>(arg_ptr);
+
+    auto reload = false;
+
+    for (unsigned long i = 0; i < recv_count; i++) {
+      auto cstr = path_from_event_at(recv_paths, i);
+
+      if (cstr && *cstr) {
+        decltype(*recv_flags) flag = recv_flags[i];
+
+        /* A single path won't have different "kinds". */
+        auto k = flag & kFSEventStreamEventFlagItemIsFile    ? evk::file
+               : flag & kFSEventStreamEventFlagItemIsDir     ? evk::dir
+               : flag & kFSEventStreamEventFlagItemIsSymlink ? evk::sym_link
+               : flag & kFSEventStreamEventFlagItemIsAnyHardLink
+                 ? evk::hard_link
+                 : evk::other;
+
+        /* Match the path before we make anything out of it. */
+        using ::detail::wtr::watcher::filter::beneath;
+        auto const rel = beneath<char>(cstr, root);
+        if (filter.reloads(rel.substr(rel.rfind('/') + 1))) reload = true;
+        if (! filter.keeps(rel, k)) continue;
+
+        auto path = std::filesystem::path{cstr};
+
+        /* `path` has no hash function, so we use a string. */
+        auto path_str = path.string();
+
+        /* More than one thing might have happened to the same path.
+           (Which is why we use non-exclusive `if`s.) */
+        if (flag & kFSEventStreamEventFlagItemCreated) {
+          if (seen_created->find(path_str) == seen_created->end()) {
+            seen_created->emplace(path_str);
+            callback({path, evw::create, k});
+          }
+        }
+        if (flag & kFSEventStreamEventFlagItemRemoved) {
+          auto const& seen_created_at = seen_created->find(path_str);
+          if (seen_created_at != seen_created->end()) {
+            seen_created->erase(seen_created_at);
+            callback({path, evw::destroy, k});
+          }
+        }
+        if (flag & kFSEventStreamEventFlagItemModified) {
+          callback({path, evw::modify, k});
+        }
+        if (flag & kFSEventStreamEventFlagItemRenamed) {
+          callback({path, evw::rename, k});
+        }
+      }
+    }
+
+    /* A `.gitignore` changed. */
+    if (reload) filter = filter.loaded(root);
+  }
+}
+
+} /* namespace */
+
+inline bool watch(std::filesystem::path const& path,
+                  ::wtr::watcher::filter const& filter,
+                  ::wtr::watcher::event::callback const& callback,
+                  std::function<bool()> const& is_living) noexcept
+{
+  using evk = enum ::wtr::watcher::event::kind;
+  using evw = enum ::wtr::watcher::event::what;
+  using std::this_thread::sleep_for;
+
+  auto seen_created_paths = std::unordered_set<std::string>{};
+  /* Darwin tells us where things are without symlinks
+     or relative parts, so that is what we match beneath. */
+  auto ec = std::error_code{};
+  auto event_recv_argptr =
+    argptr_type{callback,
+                &seen_created_paths,
+                filter.loaded(path),
+                std::filesystem::weakly_canonical(path, ec).string()};
+
+  auto stream_resources =
+    event_stream_open(path, event_recv, event_recv_argptr);
+
+  while (is_living())
+    if constexpr (has_delay) sleep_for(delay_ms);
+
+  auto died_ok = event_stream_close(std::move(stream_resources));
+
+  if (died_ok)
+    callback({"s/self/die@" + path.string(), evw::destroy, evk::watcher});
+
+  else
+    callback({"e/self/die@" + path.string(), evw::destroy, evk::watcher});
+
+  return died_ok;
+}
+
+} /* namespace adapter */
+} /* namespace watcher */
+} /* namespace wtr   */
+} /* namespace detail */
+
+#endif /* if defined(WATER_WATCHER_PLATFORM_MAC_ANY) */
+
+/*  @brief wtr/watcher/<d>/adapter/linux/fanotify
+    The Linux `fanotify` adapter. */
+
+/*  WATER_WATCHER_PLATFORM_* */
+
+#if defined(WATER_WATCHER_PLATFORM_LINUX_KERNEL_GTE_5_9_0) \
+  && ! defined(WATER_WATCHER_PLATFORM_ANDROID_ANY)
+#if ! defined(WATER_WATCHER_USE_WARTHOG)
+
+#define WATER_WATCHER_ADAPTER_LINUX_FANOTIFY
+
+/*  O_* */
+#include <fcntl.h>
+/*  EPOLL*
+    epoll_ctl
+    epoll_wait
+    epoll_event
+    epoll_create1 */
+#include <sys/epoll.h>
+/*  FAN_*
+    fanotify_mark
+    fanotify_init
+    fanotify_event_metadata */
+#include <sys/fanotify.h>
+/*  open
+    close
+    readlink */
+#include <unistd.h>
+/*  errno */
+#include <cerrno>
+/*  uint32_t
+    uint64_t */
+#include <cstdint>
+/*  size_t */
+#include <cstddef>
+/*  PATH_MAX
+    NAME_MAX */
+#include <climits>
+/*  snprintf */
+#include <cstdio>
+/*  strcmp */
+#include <cstring>
+/*  path
+    is_directory
+    weakly_canonical
+    directory_options
+    recursive_directory_iterator */
+#include <filesystem>
+/*  function
+    hash
+    equal_to
+    less */
+#include <functional>
+/*  multimap */
+#include <map>
+/*  optional */
+#include <optional>
+/*  string */
+#include <string>
+/*  string_view */
+#include <string_view>
+/*  error_code */
+#include <system_error>
+/*  unordered_map */
+#include <unordered_map>
+/*  unordered_set */
+#include <unordered_set>
+/*  vector */
+#include <vector>
+/*  tuple
+    make_tuple */
+#include <tuple>
+/*  event
+    callback
+    filter
+    beneath
+    roots_type
+    root_of
+    change */
+
+namespace detail {
+namespace wtr {
+namespace watcher {
+namespace adapter {
+namespace fanotify {
+
+/*  @brief wtr/watcher/<d>/adapter/linux/fanotify/<a>/constants
+    The delay, the size of our event buffer and how many
+    events we take from `epoll_wait` are in the policy.
+    For our event buffer, 4096 (the policy's default, and
+    `PATH_MAX`) is a typical page size and sufficiently
+    large to hold a great many events, each with a possibly
+    long file name. We could use something like:
+        buf_len
+          = ((wait_max + PATH_MAX)
+          * (3 * sizeof(fanotify_event_metadata)));
+    But that's a lot of flourish for 72 bytes that won't
+    be meaningful.
+
+    - fan_mark_mask:
+      Everything the policy watches. Creation, destruction
+      and moves are always asked for: we use them to mark
+      new directories and to keep our table of directories
+      up to date.
+
+    - fan_init_flags:
+      Post-event reporting, non-blocking IO and unlimited
+      marks. We need sudo mode for the unlimited marks.
+      If we were making a filesystem auditor, we might use:
+          FAN_CLASS_PRE_CONTENT
+          | FAN_UNLIMITED_QUEUE
+          | FAN_UNLIMITED_MARKS
+
+    - fan_init_opt_flags:
+      Read-only, non-blocking, and close-on-exec. */
+template<class Policy>
+inline constexpr std::uint64_t fan_mark_mask =
+  FAN_ONDIR | FAN_EVENT_ON_CHILD | FAN_CREATE | FAN_DELETE | FAN_MOVE
+  | FAN_DELETE_SELF | FAN_MOVE_SELF
+  | (Policy::watches(::wtr::watcher::event::what::modify) ? FAN_MODIFY : 0);
+inline constexpr auto fan_init_flags = FAN_CLASS_NOTIF | FAN_REPORT_DFID_NAME
+                                     | FAN_UNLIMITED_QUEUE
+                                     | FAN_UNLIMITED_MARKS;
+inline constexpr auto fan_init_opt_flags = O_RDONLY | O_NONBLOCK | O_CLOEXEC;
+
+/* @brief wtr/watcher/<d>/adapter/linux/fanotify/<a>/kernel
+   The calls we make to read events, to mark directories
+   and to find a directory's path from its handle. A
+   policy can make them instead. See `sys_of`. */
+struct kernel {
+  static auto read(int fd, void* buf, std::size_t len) noexcept -> ssize_t
+  {
+    return ::read(fd, buf, len);
+  }
+
+  static auto mark(int fd,
+                   unsigned flags,
+                   std::uint64_t mask,
+                   char const* path) noexcept -> int
+  {
+    return ::fanotify_mark(fd, flags, mask, AT_FDCWD, path);
+  }
+
+  /* Puts the path of the directory with the handle `fh`
+     into `into`, and returns its length, or 0 or less if
+     we couldn't find it. */
+  static auto dir_path(file_handle* fh, char* into, std::size_t len) noexcept
+    -> ssize_t
+  {
+    int fd = open_by_handle_at(AT_FDCWD,
+                               fh,
+                               O_RDONLY | O_CLOEXEC | O_PATH | O_NONBLOCK);
+    if (fd <= 0) return -1;
+    char fs_proc_path[128];
+    std::snprintf(fs_proc_path, sizeof(fs_proc_path), "/proc/self/fd/%d", fd);
+    ssize_t dirname_len = readlink(fs_proc_path, into, len);
+    close(fd);
+    return dirname_len;
+  }
+};
+
+/* @brief wtr/watcher/<d>/adapter/linux/fanotify/<a>/types
+   - mark_set_type
+       A set of file descriptors for fanotify resources.
+   - dir_table
+       The directories we have seen events in, interned by
+       their file handles. The kernel tells us which
+       directory something happened in by its handle, a few
+       bytes we can hash. Finding the directory's path
+       takes three syscalls (`open_by_handle_at`, `readlink`
+       and `close`), so we do that once per directory rather
+       than once per event. A directory's id is where its
+       path is in `paths`.
+         - ids
+             Ids by handle (with the filesystem's id first).
+         - paths
+             Paths by id. A handle is only interned once we
+             find its path. The path is emptied when the
+             directory (or one above it) is moved, and we
+             look again the next time we see its handle.
+         - roots
+             Which of the watcher's roots each directory is
+             beneath, by id. Found from its path, once, when
+             we first need it after finding the path.
+         - handles
+             Handles by id: views of the keys in `ids`.
+         - found
+             Ids by the paths we have found, in order, so
+             that a directory and everything beneath it are
+             next to each other.
+         - free
+             The ids of destroyed directories, whose handles
+             we have dropped, to be used again.
+   - system_resources
+       An object holding:
+         - An fanotify file descriptor
+         - An epoll file descriptor
+         - An epoll configuration
+         - A set of watch marks (as returned by fanotify_mark)
+         - A map of (sub)path handles to filesystem paths (names)
+         - The mask we mark directories with
+         - A boolean: whether or not the resources are valid
+   - promoted_type
+       What we make of an event from the kernel:
+         - A boolean: whether or not we could make a path
+         - The path, in a buffer which the caller owns
+         - What happened
+         - The kind of thing it happened to
+         - A boolean: whether or not the filter keeps it
+         - Which root it happened beneath */
+using mark_set_type = std::unordered_set<int>;
+
+struct handle_hash {
+  using is_transparent = void;
+
+  auto operator()(std::string_view handle) const noexcept -> std::size_t
+  {
+    return std::hash<std::string_view>{}(handle);
+  }
+};
+
+struct dir_table {
+  std::unordered_map<std::string, std::size_t, handle_hash, std::equal_to<>>
+    ids;
+  std::vector<std::string> paths;
+  std::vector<std::uint32_t> roots;
+  std::vector<std::string_view> handles;
+  std::multimap<std::string, std::size_t, std::less<>> found;
+  std::vector<std::size_t> free;
+
+  static constexpr auto unknown = ~std::uint32_t{0};
+  static constexpr auto nowhere = ~std::size_t{0};
+};
+
+using promoted_type = std::tuple<bool,
+                                 std::string_view,
+                                 enum ::wtr::watcher::event::what,
+                                 enum ::wtr::watcher::event::kind,
+                                 bool,
+                                 std::uint32_t>;
+
+struct system_resources {
+  bool valid;
+  int watch_fd;
+  int event_fd;
+  epoll_event event_conf;
+  mark_set_type mark_set;
+  dir_table dirs;
+  std::uint64_t mark_mask;
+};
+
+template<class Sys = kernel>
+inline auto mark(std::filesystem::path const& full_path,
+                 int watch_fd,
+                 mark_set_type& ms,
+                 std::uint64_t mask) noexcept -> bool
+{
+  int wd = Sys::mark(watch_fd, FAN_MARK_ADD, mask, full_path.c_str());
+  if (wd >= 0) {
+    ms.insert(wd);
+    return true;
+  }
+  else
+    return false;
+};
+
+template<class Sys = kernel>
+inline auto mark(std::filesystem::path const& full_path,
+                 system_resources& sr) noexcept -> bool
+{
+  return mark<Sys>(full_path, sr.watch_fd, sr.mark_set, sr.mark_mask);
+};
+
+inline auto unmark(std::filesystem::path const& full_path,
+                   int watch_fd,
+                   mark_set_type& mark_set,
+                   std::uint64_t mask) noexcept -> bool
+{
+  int wd = fanotify_mark(watch_fd,
+                         FAN_MARK_REMOVE,
+                         mask,
+                         AT_FDCWD,
+                         full_path.c_str());
+
+  /* `fanotify_mark` gives back 0, not a descriptor, so
+     every mark is the same one in `mark_set`. We keep it,
+     because other directories are still marked. */
+  return wd >= 0 && mark_set.contains(wd);
+};
+
+inline auto unmark(std::filesystem::path const& full_path,
+                   system_resources& sr) noexcept -> bool
+{
+  return unmark(full_path, sr.watch_fd, sr.mark_set, sr.mark_mask);
+};
+
+/* @brief wtr/watcher/<d>/adapter/linux/fanotify/<a>/fns/mark_tree
+   Marks `base_path` and every directory beneath it, except
+   for those which `filter` drops everything in. Marking
+   what is already marked does nothing, so this is also how
+   we catch up when the filter changes. Invokes `callback`
+   on warnings. Returns how many directories were marked,
+   which is none if `base_path` wasn't. */
+template<class Sink>
+inline auto mark_tree(std::filesystem::path const& base_path,
+                      ::wtr::watcher::filter const& filter,
+                      int const watch_fd,
+                      mark_set_type& ms,
+                      Sink const& callback) noexcept
+  -> std::uint64_t
+{
+  namespace fs = ::std::filesystem;
+  using diag = ::wtr::watcher::diag;
+  using diter = fs::recursive_directory_iterator;
+
+  using trace = typename Sink::policy::trace;
+  using sys = sys_of<typename Sink::policy, kernel>;
+
+  static constexpr auto mask = fan_mark_mask<typename Sink::policy>;
+
+  /* Follow symlinks, ignore paths which we don't have permissions for. */
+  static constexpr auto dopt =
+    fs::directory_options::skip_permission_denied
+    & fs::directory_options::follow_directory_symlink;
+
+  auto not_watched = tally{};
+  auto marked = std::uint64_t{1};
+
+  trace::walk_begin(base_path);
+  auto const walk_began = trace::on ? trace::now() : 0;
+
+  /* Marks a directory, and tells the trace. */
+  auto const do_mark = [&](fs::path const& dir) noexcept -> bool
+  {
+    auto const ok = mark<sys>(dir, watch_fd, ms, mask);
+    trace::mark(dir, ok);
+    return ok;
+  };
+
+  try {
+    if (do_mark(base_path)) {
+      if (fs::is_directory(base_path))
+        for (auto dir = diter(base_path, dopt); dir != diter{}; ++dir)
+          if (fs::is_directory(*dir)) {
+            using ::detail::wtr::watcher::filter::beneath;
+            /* Nothing in here can be kept. */
+            if (! filter.empty()
+                && filter.prunes(filter.walk(
+                  filter.start(),
+                  beneath<char>(dir->path().native(), base_path.native())))) {
+              dir.disable_recursion_pending();
+              continue;
+            }
+            if (do_mark(dir->path()))
+              ++marked;
+            else if constexpr (Sink::policy::status)
+                not_watched(callback,
+                            {.level = diag::level::warning,
+                             .code = diag::code::not_watched,
+                             .error = errno,
+                             .where = base_path.native(),
+                             .also = dir->path().native()});
+          }
+      not_watched.done(callback);
+      trace::walk_end(base_path,
+                      marked,
+                      trace::on ? trace::now() - walk_began : 0);
+      return marked;
+    }
+  } catch (...) {}
+
+  not_watched.done(callback);
+  trace::walk_end(base_path, 0, trace::on ? trace::now() - walk_began : 0);
+  return 0;
+};
+
+/* @brief wtr/watcher/<d>/adapter/linux/fanotify/<a>/fns/mark_trees
+   The same, for every one of `roots`, with its own filter.
+   A directory beneath more than one of them is marked once.
+   A root which can't be marked is warned about, and the
+   others are watched without it. Returns how many roots
+   were marked. */
+template<class Sink>
+inline auto mark_trees(roots_type const& roots,
+                       int const watch_fd,
+                       mark_set_type& ms,
+                       Sink const& callback) noexcept
+  -> std::size_t
+{
+  using diag = ::wtr::watcher::diag;
+
+  auto marked_roots = std::size_t{0};
+  auto marked = std::uint64_t{0};
+
+  for (auto const& root : roots) {
+    if (root.path.empty()) continue;
+    auto const n = mark_tree(root.path, root.live, watch_fd, ms, callback);
+    if (n > 0)
+      ++marked_roots;
+    else if constexpr (Sink::policy::status)
+      if (roots.size() > 1)
+        callback.tell({.level = diag::level::warning,
+                       .code = diag::code::not_watched,
+                       .error = errno,
+                       .where = root.path.native()});
+    marked += n;
+  }
+
+  if (callback.counts)
+    callback.counts->marks.store(marked, std::memory_order_relaxed);
+
+  return marked_roots;
+};
+
+/* @brief wtr/watcher/<d>/adapter/linux/fanotify/<a>/fns/change_roots
+   Marks the roots added since we last looked, and unmarks
+   those removed, without touching the others. An added
+   root is marked as it would have been from the start. A
+   removed root's tree is unmarked, except for what is
+   beneath another root. Which root each directory is
+   beneath is found again, as it is next seen. */
+template<class Sink>
+inline auto change_roots(system_resources& sr,
+                         roots_type& roots,
+                         ::wtr::watcher::filter const& filter,
+                         changes_type const& changes,
+                         Sink const& callback) noexcept -> void
+{
+  namespace fs = ::std::filesystem;
+  using diag = ::wtr::watcher::diag;
+  using diter = fs::recursive_directory_iterator;
+  using policy = typename Sink::policy;
+  using trace = typename policy::trace;
+
+  static constexpr auto dopt =
+    fs::directory_options::skip_permission_denied
+    & fs::directory_options::follow_directory_symlink;
+
+  auto marks = callback.counts ? callback.counts->marks.load() : 0;
+
+  for (auto const& c : changes) {
+    if (c.root >= roots.size()) roots.resize(c.root + 1);
+
+    if (c.what == change::what::add) {
+      auto ec = std::error_code{};
+      roots[c.root] = {c.path,
+                       fs::weakly_canonical(c.path, ec).native(),
+                       filter.loaded(c.path)};
+      auto const& root = roots[c.root];
+      if constexpr (policy::status)
+        callback.tell({.level = diag::level::status,
+                       .code = diag::code::live,
+                       .where = root.path.native()});
+      auto const marked =
+        mark_tree(root.path, root.live, sr.watch_fd, sr.mark_set, callback);
+      if constexpr (policy::status)
+        if (marked == 0)
+          callback.tell({.level = diag::level::warning,
+                         .code = diag::code::not_watched,
+                         .error = errno,
+                         .where = root.path.native()});
+      marks += marked;
+    }
+
+    else if (! roots[c.root].path.empty()) {
+      auto const gone = std::move(roots[c.root]);
+      roots[c.root] = {};
+
+      /* What is beneath another root stays marked. */
+      auto const let_go = [&](fs::path const& dir) noexcept -> bool
+      {
+        if (root_of(dir.native(), roots) < roots.size()) return false;
+        auto const ok = unmark(dir, sr);
+        trace::unmark(dir, ok);
+        if (ok && marks > 0) --marks;
+        return true;
+      };
+
+      try {
+        if (let_go(gone.real) && fs::is_directory(gone.real))
+          for (auto dir = diter(gone.real, dopt); dir != diter{}; ++dir)
+            if (fs::is_directory(*dir) && ! let_go(dir->path()))
+              dir.disable_recursion_pending();
+      } catch (...) {}
+
+      if constexpr (policy::status)
+        callback.tell({.level = diag::level::status,
+                       .code = diag::code::die,
+                       .where = gone.path.native()});
+    }
+  }
+
+  for (auto& root : sr.dirs.roots) root = sr.dirs.unknown;
+
+  if (callback.counts)
+    callback.counts->marks.store(marks, std::memory_order_relaxed);
+};
+
+/* @brief wtr/watcher/<d>/adapter/linux/fanotify/<a>/fns/open_system_resources
+   Produces a `system_resources` with the file descriptors from
+   `fanotify_init` and `epoll_create`. Invokes `callback` on errors. */
+template<class Sink>
+inline auto
+open_system_resources(roots_type const& roots,
+                      Sink const& callback) noexcept
+  -> system_resources
+{
+  using diag = ::wtr::watcher::diag;
+
+  auto const& path = roots.empty() ? std::filesystem::path{}
+                                   : roots.front().path;
+
+  auto do_error = [&path,
+                   &callback](enum diag::code code,
+                              int watch_fd,
+                              int event_fd = -1) noexcept -> system_resources
+  {
+    callback.tell({.level = diag::level::error,
+                   .code = code,
+                   .error = errno,
+                   .where = path.native()});
+
+    return system_resources{
+      .valid = false,
+      .watch_fd = watch_fd,
+      .event_fd = event_fd,
+      .event_conf = {.events = 0, .data = {.fd = watch_fd}},
+      .mark_set = {},
+      .dirs = {},
+      .mark_mask = 0,
+    };
+  };
+
+  static constexpr auto rsrv_count = 1024;
+
+  int watch_fd = fanotify_init(fan_init_flags, fan_init_opt_flags);
+  if (watch_fd >= 0) {
+    auto pmc = mark_set_type{};
+    pmc.reserve(rsrv_count);
+    if (mark_trees(roots, watch_fd, pmc, callback) > 0 || roots.empty()) {
+      epoll_event event_conf{.events = EPOLLIN, .data{.fd = watch_fd}};
+
+      int event_fd = epoll_create1(EPOLL_CLOEXEC);
+
+      /* @note We could make the epoll and fanotify file descriptors
+         non-blocking with `fcntl`. It's not clear if we can do this
+         from their `*_init` calls. */
+      /* fcntl(watch_fd, F_SETFL, O_NONBLOCK); */
+      /* fcntl(event_fd, F_SETFL, O_NONBLOCK); */
+
+      if (event_fd >= 0)
+        if (epoll_ctl(event_fd, EPOLL_CTL_ADD, watch_fd, &event_conf) >= 0)
+          return system_resources{
+            .valid = true,
+            .watch_fd = watch_fd,
+            .event_fd = event_fd,
+            .event_conf = event_conf,
+            .mark_set = std::move(pmc),
+            .dirs = {},
+            .mark_mask = fan_mark_mask<typename Sink::policy>,
+          };
+        else
+          return do_error(diag::code::epoll_ctl, watch_fd, event_fd);
+      else
+        return do_error(diag::code::epoll_create, watch_fd, event_fd);
+    }
+    else
+      return do_error(diag::code::fanotify_mark, watch_fd);
+  }
+  else
+    return do_error(diag::code::fanotify_init, watch_fd);
+};
+
+/* @brief wtr/watcher/<d>/adapter/linux/fanotify/<a>/fns/close_system_resources
+   Close the file descriptors `watch_fd` and `event_fd`. */
+inline auto close_system_resources(system_resources&& sr) noexcept -> bool
+{
+  return close(sr.watch_fd) == 0 && close(sr.event_fd) == 0;
+};
+
+/*  @brief wtr/watcher/<d>/adapter/linux/fanotify/<a>/fns/decode
+    What happened, to what kind of thing, and the name of
+    that thing, from an event's metadata. The name follows
+    the directory's file handle, which is as long as it
+    says it is. */
+inline auto what_of(std::uint64_t mask) noexcept
+  -> enum ::wtr::watcher::event::what
+{
+  using evw = enum ::wtr::watcher::event::what;
+  return mask & FAN_CREATE ? evw::create
+       : mask & FAN_DELETE ? evw::destroy
+       : mask & FAN_MODIFY ? evw::modify
+       : mask & FAN_MOVE   ? evw::rename
+                           : evw::other;
+}
+
+inline auto kind_of(std::uint64_t mask) noexcept
+  -> enum ::wtr::watcher::event::kind
+{
+  return mask & FAN_ONDIR ? ::wtr::watcher::event::kind::dir
+                          : ::wtr::watcher::event::kind::file;
+}
+
+inline auto name_of(fanotify_event_metadata const* mtd) noexcept
+  -> char const*
+{
+  auto dfid_info = (fanotify_event_info_fid const*)(mtd + 1);
+  auto dir_fh = (file_handle const*)(dfid_info->handle);
+  return (char const*)(dir_fh->f_handle) + dir_fh->handle_bytes;
+}
+
+/*  @brief wtr/watcher/<d>/adapter/linux/fanotify/<a>/fns/dir_of
+    The directory an event happened in: its handle, which
+    is everything from the filesystem's id to the end of
+    the file handle, and its id in `dt`. Interns the handle
+    if we haven't seen it, and finds its path if we don't
+    have it. `forget` clears the paths of a directory and
+    everything beneath it, which we find again by their
+    handles when they are next seen. When they were
+    destroyed, it drops their handles too, and their ids
+    are used again. It only looks at the directories in
+    that tree.
+    A directory we can't find the path of (because it is
+    gone) isn't interned, and neither is one we don't know
+    which tells us about itself (as it is destroyed or
+    moved): such a record was about a directory we already
+    forgot. Those are `nowhere`. */
+inline auto handle_of(fanotify_event_metadata const* mtd) noexcept
+  -> std::string_view
+{
+  auto dfid_info = (fanotify_event_info_fid const*)(mtd + 1);
+  auto dir_fh = (file_handle const*)(dfid_info->handle);
+  auto from = (char const*)(&dfid_info->fsid);
+  auto to = (char const*)(dir_fh->f_handle) + dir_fh->handle_bytes;
+  return {from, (std::size_t)(to - from)};
+}
+
+template<class Sys = kernel>
+inline auto dir_of(fanotify_event_metadata const* mtd, dir_table& dt) noexcept
+  -> std::size_t
+{
+  auto const handle = handle_of(mtd);
+  auto const found = dt.ids.find(handle);
+  auto const known = found != dt.ids.end();
+  if (known && ! dt.paths[found->second].empty()) return found->second;
+  if (! known && std::strcmp(name_of(mtd), ".") == 0) return dt.nowhere;
+
+  auto dir_fh =
+    (file_handle*)(((fanotify_event_info_fid const*)(mtd + 1))->handle);
+  char dir_buf[PATH_MAX];
+  ssize_t dirname_len =
+    Sys::dir_path(dir_fh, dir_buf, sizeof(dir_buf) - sizeof('\0'));
+  if (dirname_len <= 0) return known ? found->second : dt.nowhere;
+
+  auto id = known ? found->second : dt.paths.size();
+  if (! known) {
+    if (! dt.free.empty()) {
+      id = dt.free.back();
+      dt.free.pop_back();
+    }
+    else {
+      dt.paths.emplace_back();
+      dt.roots.push_back(dt.unknown);
+      dt.handles.emplace_back();
+    }
+    dt.handles[id] = dt.ids.emplace(std::string{handle}, id).first->first;
+  }
+
+  dt.paths[id].assign(dir_buf, dirname_len);
+  dt.found.emplace(dt.paths[id], id);
+  dt.roots[id] = dt.unknown;
+  return id;
+}
+
+inline auto forget(dir_table& dt,
+                   std::string_view dir,
+                   bool destroyed = false) noexcept -> void
+{
+  if (dir.empty()) return;
+
+  auto const clear = [&](auto at) noexcept
+  {
+    auto const id = at->second;
+    dt.paths[id].clear();
+    dt.roots[id] = dt.unknown;
+    if (destroyed) {
+      dt.ids.erase(dt.ids.find(dt.handles[id]));
+      dt.handles[id] = {};
+      dt.free.push_back(id);
+    }
+    return dt.found.erase(at);
+  };
+
+  for (auto [at, end] = dt.found.equal_range(dir); at != end;) at = clear(at);
+
+  auto const beneath = std::string{dir} + '/';
+  for (auto at = dt.found.lower_bound(beneath);
+       at != dt.found.end() && at->first.starts_with(beneath);)
+    at = clear(at);
+}
+
+/*  @brief wtr/watcher/<d>/adapter/linux/fanotify/<a>/fns/promote
+    Promotes an event's metadata to a full path.
+
+    The shenanigans we do here depend on this event being
+    `FAN_EVENT_INFO_TYPE_DFID_NAME`. The kernel passes us
+    some info about the directory and the directory entry
+    (the filename) of this event that doesn't exist when
+    other event types are reported. In particular, we need
+    a file descriptor to the directory (which we use
+    `readlink` on) and a character string representing the
+    name of the directory entry.
+    TLDR: We need information for the full path of the event,
+    information which is only reported inside this `if`.
+
+    From the kernel:
+      Variable size struct for
+      dir file handle + child file handle + name
+
+      [ Omitting definition of `fanotify_info` here ]
+
+      (struct fanotify_fh) dir_fh starts at
+      buf[0]
+
+      (optional) dir2_fh starts at
+      buf[dir_fh_totlen]
+
+      (optional) file_fh starts at
+      buf[dir_fh_totlen + dir2_fh_totlen]
+
+      name starts at
+      buf[dir_fh_totlen + dir2_fh_totlen + file_fh_totlen]
+      ...
+
+    The kernel guarentees that there is a null-terminated
+    character string to the event's directory entry
+    after the file handle to the directory.
+    Confusing, right?
+
+    The directory's path comes from `dt`, which finds it
+    (with `readlink`) only for directories it hasn't seen.
+    The path is put together in `path_buf`, which the
+    caller owns and which we view, so nothing here (or in
+    sending the event) allocates once the directory is
+    known. So does the root the directory is beneath, whose
+    filter the path is matched against. */
+// clang-format off
+// note at the end of file re. clang format
+template<class Sys = kernel>
+inline auto promote(fanotify_event_metadata const* mtd,
+                    roots_type const& roots,
+                    dir_table& dt,
+                    char (&path_buf)[PATH_MAX]) noexcept
+  -> promoted_type
+{
+  using ev = ::wtr::watcher::event;
+
+  auto path_imbue = [mtd](char* path_accum,
+                          ssize_t dir_name_len = 0) noexcept -> void
+  {
+    char const* file_name = name_of(mtd);
+
+    if (file_name && std::strcmp(file_name, ".") != 0)
+      std::snprintf(path_accum + dir_name_len,
+                    PATH_MAX - dir_name_len,
+                    "/%s",
+                    file_name);
+  };
+
+  auto what = what_of(mtd->mask);
+
+  auto kind = kind_of(mtd->mask);
+
+  auto const id = dir_of<Sys>(mtd, dt);
+
+  /* We don't know where this happened. It isn't sent. */
+  if (id == dt.nowhere || dt.paths[id].empty()) {
+    path_buf[0] = '\0';
+    return std::make_tuple(false, std::string_view{}, what, kind, false,
+                           (std::uint32_t)roots.size());
+  }
+
+  auto const& dir = dt.paths[id];
+
+  if (dt.roots[id] == dt.unknown)
+    dt.roots[id] = root_of(dir, roots);
+
+  /* With one root, what we can't place (such as what is
+     still marked after being moved out) is sent as it
+     always was. With more, it is from a root which was
+     removed, or from none of them, and it isn't sent. */
+  auto const one = roots.size() == 1 && ! roots.front().real.empty();
+  auto const at = one                        ? 0
+                : dt.roots[id] == dt.unknown ? (std::uint32_t)roots.size()
+                                             : dt.roots[id];
+
+  /* Match the path before we make anything out of it.
+     New directories are marked whether or not we keep them,
+     unless everything in them is dropped. A `.gitignore`
+     is looked at in any case, because it changes the filter. */
+  auto promoted = [&](char const* path_accum) noexcept -> promoted_type
+  {
+    using ::detail::wtr::watcher::filter::beneath;
+
+    if (at >= roots.size())
+      return std::make_tuple(false, std::string_view{}, what, kind, false, at);
+
+    auto const& filter = roots[at].live;
+
+    if (filter.empty())
+      return std::make_tuple(true, std::string_view{path_accum}, what, kind, true, at);
+
+    auto const rel = beneath<char>(path_accum, roots[at].real);
+    auto const state = filter.walk(filter.start(), rel);
+    auto const keep = filter.keeps(state, kind);
+    auto const name = rel.substr(rel.rfind('/') + 1);
+
+    return keep
+        || (kind == ev::kind::dir && what == ev::what::create
+            && ! filter.prunes(state))
+        || (kind == ev::kind::file && filter.reloads(name))
+         ? std::make_tuple(true, std::string_view{path_accum}, what, kind, keep, at)
+         : std::make_tuple(false, std::string_view{}, what, kind, keep, at);
+  };
+
+  /* Put the directory name in the path accumulator.
+     Passing its length has the effect of putting the
+     event's filename in the path buffer as well. */
+  auto const dirname_len = dir.copy(path_buf, sizeof(path_buf) - sizeof('\0'));
+  path_buf[dirname_len] = '\0';
+  path_imbue(path_buf, (ssize_t)dirname_len);
+
+  return promoted(path_buf);
+};
+
+// clang-format on
+
+template<class Sys = kernel>
+inline auto
+check_and_update(promoted_type const& r,
+                 system_resources& sr) noexcept
+  -> promoted_type {
+    using ev = ::wtr::watcher::event;
+
+    auto [valid, path, what, kind, keep, root] = r;
+
+    return std::make_tuple(
+
+      valid
+
+        ? kind == ev::kind::dir
+
+          /* The kernel drops the marks on a destroyed directory
+             (and everything beneath it) along with its inode.
+             We don't `unmark` here: the path is already gone. */
+          ? what == ev::what::create  ? mark<Sys>(std::filesystem::path{path}, sr)
+                                      : true
+
+          : true
+
+        : false,
+
+      path,
+
+      what,
+
+      kind,
+
+      keep,
+
+      root);
+  };
+
+/*  @brief wtr/watcher/<d>/adapter/linux/fanotify/<a>/batch_decoder
+    Reads the `fanotify_event_metadata` in our buffer for a
+    `batch`. Records which `recv` wouldn't send are skipped.
+    The batch's context is the table of directories, which
+    `recv` brings up to date with everything in the batch
+    before sending it. Paths are put together from it, and
+    only when asked for. */
+inline auto first_event(char const* at, char const* end) noexcept
+  -> char const*
+{
+  for (;; at += ((fanotify_event_metadata const*)at)->event_len) {
+    auto const mtd = (fanotify_event_metadata const*)at;
+    if (! FAN_EVENT_OK(mtd, end - at)) return end;
+    if (mtd->fd == FAN_NOFD && mtd->vers == FANOTIFY_METADATA_VERSION
+        && ! (mtd->mask & FAN_Q_OVERFLOW)
+        && ((fanotify_event_info_fid const*)(mtd + 1))->hdr.info_type
+             == FAN_EVENT_INFO_TYPE_DFID_NAME)
+      return at;
+  }
+}
+
+inline constexpr auto batch_decoder = ::wtr::watcher::batch::decoder{
+  .first = first_event,
+  .next = [](char const* at, char const* end) noexcept -> char const*
+  { return first_event(at + ((fanotify_event_metadata const*)at)->event_len,
+                       end); },
+  .what = [](char const* at) noexcept
+  { return what_of(((fanotify_event_metadata const*)at)->mask); },
+  .kind = [](char const* at) noexcept
+  { return kind_of(((fanotify_event_metadata const*)at)->mask); },
+  .name = [](char const* at) noexcept
+  {
+    auto const name = std::string_view{
+      name_of((fanotify_event_metadata const*)at)};
+    return name == "." ? std::string_view{} : name;
+  },
+  .dir = [](void const* context, char const* at) noexcept
+  {
+    auto const& dt = *static_cast<dir_table const*>(context);
+    auto const found =
+      dt.ids.find(handle_of((fanotify_event_metadata const*)at));
+    return found != dt.ids.end() ? found->second : dt.paths.size();
+  },
+  .dir_path = [](void const* context, std::size_t id) noexcept
+  {
+    auto const& dt = *static_cast<dir_table const*>(context);
+    return id < dt.paths.size() ? std::string_view{dt.paths[id]}
+                                : std::string_view{};
+  },
+  .where = [](void const* context, char const* at, std::string& into) noexcept
+  {
+    auto const& dt = *static_cast<dir_table const*>(context);
+    auto const mtd = (fanotify_event_metadata const*)at;
+    auto const found = dt.ids.find(handle_of(mtd));
+    if (found == dt.ids.end() || dt.paths[found->second].empty()) return false;
+    auto const name = std::string_view{name_of(mtd)};
+    into.assign(dt.paths[found->second]);
+    if (name != ".") (into += '/').append(name);
+    return true;
+  },
+};
+
+/*  @brief wtr/watcher/<d>/adapter/linux/fanotify/<a>/fns/tends
+    Whether we have to look at a record ourselves when what
+    we read goes out in batches: a new directory, to mark
+    it; a moved or destroyed one, to forget where it was;
+    and anything with a name which changes a filter. The
+    rest is left to whoever takes the batch. */
+inline auto tends(fanotify_event_metadata const* mtd,
+                  roots_type const& roots) noexcept -> bool
+{
+  using ev = ::wtr::watcher::event;
+  if (kind_of(mtd->mask) == ev::kind::dir) {
+    auto const what = what_of(mtd->mask);
+    return what == ev::what::create || what == ev::what::rename
+        || what == ev::what::destroy;
+  }
+  auto const name = std::string_view{name_of(mtd)};
+  for (auto const& root : roots)
+    if (root.live.reloads(name)) return true;
+  return false;
+}
+
+/*  @brief wtr/watcher/<d>/adapter/linux/fanotify/<a>/fns/send
+    Send events to the user.
+
+    This is the important part.
+    Most of the other code is
+    a layer of translation
+    between us and the kernel. */
+template<class Sink>
+inline auto
+send(promoted_type const& from_kernel,
+     long long when,
+     Sink const& callback) noexcept -> bool
+{
+  auto [ok, path, what, kind, keep, root] = from_kernel;
+
+  /* What the policy doesn't watch was only asked for to
+     follow directories. */
+  return ok && keep && Sink::policy::watches(what)
+         ? (callback({path, what, kind, when, callback.clock, root}), ok)
+         : ok;
+};
+
+/* @brief wtr/watcher/<d>/adapter/linux/fanotify/<a>/fns/recv
+   Reads through available (fanotify) filesystem events.
+   Discerns their path and type.
+   Calls the callback. When it takes batches, only what
+   we have to look at ourselves is discerned. See `tends`.
+   Loads the filters again, and marks what they no longer
+   drop, if one of them says to when something happens.
+   Returns false on eventful errors.
+   @note
+   The `metadata->fd` field contains either a file
+   descriptor or the value `FAN_NOFD`. File descriptors
+   are always greater than 0. `FAN_NOFD` represents an
+   event queue overflow for `fanotify` listeners which
+   are _not_ monitoring file handles, such as mount
+   monitors. The file handle is in the metadata when an
+   `fanotify` listener is monitoring events by their
+   file handles.
+   The `metadata->vers` field may differ between kernel
+   versions, so we check it against what we have been
+   compiled with. */
+template<class Sink>
+inline auto recv(system_resources& sr,
+                 roots_type& roots,
+                 Sink const& callback) noexcept
+  -> bool
+{
+  using diag = ::wtr::watcher::diag;
+  using trace = typename Sink::policy::trace;
+  using sys = sys_of<typename Sink::policy, kernel>;
+
+  enum class state { ok, none, err };
+
+  auto reload = false;
+
+  auto const& base_path = roots.front().path;
+
+  auto do_error = [&base_path, &callback](enum diag::code code,
+                                          int error = 0) noexcept -> bool
+  {
+    return (callback.tell({.level = diag::level::error,
+                           .code = code,
+                           .error = error,
+                           .where = base_path.native()}),
+            false);
+  };
+
+  /* What we couldn't make sense of in this read. */
+  auto unknown_info = tally{};
+
+  /* Read some events. */
+  alignas(fanotify_event_metadata) char event_buf[Sink::policy::buf_len];
+  /* Where the paths we send are put together. */
+  char path_buf[PATH_MAX];
+  auto const read_began = trace::on ? trace::now() : 0;
+  auto event_read = sys::read(sr.watch_fd, event_buf, sizeof(event_buf));
+  trace::read(event_read, trace::on ? trace::now() - read_began : 0);
+
+  /* The longest record has the longest handle and name. */
+  auto const counted = counted_read{
+    callback.counts,
+    event_read,
+    sizeof(event_buf),
+    sizeof(fanotify_event_metadata) + sizeof(fanotify_event_info_fid)
+      + MAX_HANDLE_SZ + NAME_MAX + 1};
+
+  switch (event_read > 0    ? state::ok
+          : event_read == 0 ? state::none
+          : errno == EAGAIN ? state::none
+                            : state::err) {
+    case state::ok : {
+      /* Everything in this read happened by now. */
+      auto const when = ::wtr::watcher::event::now(callback.clock);
+
+      /* Whoever takes batches gets the buffer as it is,
+         once we know every directory in it. */
+      if (callback.batches) {
+        auto const end = event_buf + event_read;
+        for (auto at = first_event(event_buf, end); at != end;
+             at = batch_decoder.next(at, end))
+          dir_of<sys>((fanotify_event_metadata const*)at, sr.dirs);
+        callback.batches(
+          ::wtr::watcher::batch{event_buf,
+                                end,
+                                batch_decoder,
+                                &sr.dirs,
+                                when,
+                                callback.clock});
+      }
+
+      /* Loop over everything in the event buffer.
+         A single read may hold many events, such as
+         when a large tree is removed. We send them all. */
+      for (auto* mtd = (fanotify_event_metadata const*)event_buf;
+           FAN_EVENT_OK(mtd, event_read);
+           mtd = FAN_EVENT_NEXT(mtd, event_read))
+        if (mtd->fd == FAN_NOFD) [[likely]]
+          if (mtd->vers == FANOTIFY_METADATA_VERSION) [[likely]]
+            if (! (mtd->mask & FAN_Q_OVERFLOW)) [[likely]]
+              if (((fanotify_event_info_fid*)(mtd + 1))->hdr.info_type
+                  == FAN_EVENT_INFO_TYPE_DFID_NAME) [[likely]] {
+
+                /* The batch has been sent. What is left is ours. */
+                if (callback.batches && ! tends(mtd, roots)) continue;
+
+                /* Send the events we receive. */
+                auto const p = check_and_update<sys>(
+                  promote<sys>(mtd, roots, sr.dirs, path_buf),
+                  sr);
+
+                using ev = ::wtr::watcher::event;
+                if constexpr (trace::on) {
+                  auto const [ok, path, what, kind, keep, root] = p;
+                  trace::decoded(what, kind, path.size());
+                  /* New directories are marked as they are checked. */
+                  if (kind == ev::kind::dir && what == ev::what::create)
+                    trace::mark(std::filesystem::path{path}, ok);
+                }
+
+                if (! callback.batches) send(p, when, callback);
+
+                auto const where = std::get<1>(p);
+
+                /* What we knew about where this directory (and
+                   everything beneath it) is might be wrong now.
+                   If it was destroyed, there is nothing left to
+                   know. The path is in `path_buf`, kept or not. */
+                if (std::get<3>(p) == ev::kind::dir
+                    && (std::get<2>(p) == ev::what::rename
+                        || std::get<2>(p) == ev::what::destroy))
+                  forget(sr.dirs,
+                         std::string_view{path_buf},
+                         std::get<2>(p) == ev::what::destroy);
+
+                /* The kernel drops the mark on a destroyed
+                   directory, and we see each one destroyed. */
+                if (callback.counts && std::get<3>(p) == ev::kind::dir) {
+                  auto& marks = callback.counts->marks;
+                  auto const n = marks.load(std::memory_order_relaxed);
+                  if (std::get<2>(p) == ev::what::create && std::get<0>(p))
+                    marks.store(n + 1, std::memory_order_relaxed);
+                  else if (std::get<2>(p) == ev::what::destroy && n > 0)
+                    marks.store(n - 1, std::memory_order_relaxed);
+                }
+
+                if (std::get<0>(p)
+                    && roots[std::get<5>(p)].live.reloads(
+                      where.substr(where.rfind('/') + 1)))
+                  reload = true;
+              }
+
+              else
+                unknown_info(callback,
+                             {.level = diag::level::warning,
+                              .code = diag::code::event_info,
+                              .where = base_path.native()});
+            else {
+              if (callback.counts)
+                ::wtr::watcher::metrics::add(callback.counts->overflows);
+              return do_error(diag::code::overflow);
+            }
+          else
+            return do_error(diag::code::kernel_version);
+        else
+          return do_error(diag::code::wrong_event_fd);
+
+      unknown_info.done(callback);
+      counted.done();
+
+      /* A `.gitignore` changed. What is newly dropped stays
+         marked, but what happens to it isn't sent. */
+      if (reload) {
+        for (auto& root : roots) root.live = root.live.loaded(root.path);
+        mark_trees(roots, sr.watch_fd, sr.mark_set, callback);
+      }
+
+      return true;
+    } break;
+
+    case state::none : return true; break;
+
+    case state::err : return do_error(diag::code::read, errno); break;
+  }
+
+  /* Unreachable */
+  return false;
+};
+
+/*  @brief wtr/watcher/<d>/adapter/watch
+    Monitors `paths` for changes, all with one `fanotify`
+    instance.
+    Invokes `callback` with an `event` when they happen.
+    `watch` stops when asked to or irrecoverable errors occur.
+    All events, including errors, are passed to `callback`.
+
+    @param paths
+    The filesystem paths to watch for events. Each event
+    says which of them it happened beneath.
+
+    @param filter
+    Which paths, beneath each of `paths`, to send events for.
+
+    @param callback
+    A function to invoke with an `event` object
+    when the files being watched change.
+
+    @param is_living
+    A function to decide whether we're dead.
+
+    @param changes
+    A function which gives us the roots added or removed
+    since we last asked. See `change`. */
+template<class Sink>
+inline bool watch(std::vector<std::filesystem::path> const& paths,
+                  ::wtr::watcher::filter const& filter,
+                  Sink const& callback,
+                  std::function<bool()> const& is_living,
+                  changes_fn const& changes = {}) noexcept
+{
+  using diag = ::wtr::watcher::diag;
+  using policy = typename Sink::policy;
+
+  /* What we say about ourselves is said of the first. */
+  auto const path = paths.empty() ? std::filesystem::path{} : paths.front();
+
+  auto done = [&path, &callback](system_resources&& sr) noexcept -> bool
+  {
+    if (close_system_resources(std::move(sr))) {
+      if constexpr (policy::status)
+        callback.tell({.level = diag::level::status,
+                       .code = diag::code::die,
+                       .where = path.native()});
+      return true;
+    }
+
+    else
+      return (callback.tell({.level = diag::level::error,
+                             .code = diag::code::die,
+                             .where = path.native()}),
+              false);
+  };
+
+  auto do_error = [&path, &callback, &done](system_resources&& sr,
+                                            enum diag::code code) -> bool
+  {
+    return (
+      callback.tell(
+        {.level = diag::level::error, .code = code, .where = path.native()}),
+
+      done(std::move(sr)),
+
+      false);
+  };
+
+  /*  While living, with
+      - System resources for fanotify and epoll
+      - An event list for receiving epoll events
+
+      Do
+      - Await filesystem events
+      - Invoke `callback` on errors and events */
+
+  /* Our own copies, which read the `.gitignore`s if they
+     should. The kernel tells us where things are without
+     symlinks or relative parts, so that is what we match
+     beneath. */
+  auto roots = roots_of(paths, filter);
+
+  auto sr = open_system_resources(roots, callback);
+
+  epoll_event event_recv_list[policy::wait_max];
+
+  if (sr.valid) [[likely]] {
+    while (is_living()) [[likely]]
+
+    {
+      if (changes)
+        if (auto const changed = changes(); ! changed.empty())
+          change_roots(sr, roots, filter, changed, callback);
+
+      int event_count = epoll_wait(sr.event_fd,
+                                   event_recv_list,
+                                   policy::wait_max,
+                                   policy::delay_ms);
+      if (event_count < 0)
+        return do_error(std::move(sr), diag::code::epoll_wait);
+
+      else if (event_count > 0) [[likely]]
+        for (int n = 0; n < event_count; n++)
+          if (event_recv_list[n].data.fd == sr.watch_fd) [[likely]]
+            if (is_living()) [[likely]]
+              if (! recv(sr, roots, callback)) [[unlikely]]
+                return do_error(std::move(sr), diag::code::event_recv);
+    }
+
+    return done(std::move(sr));
+  }
+
+  else
+    return do_error(std::move(sr), diag::code::sys_resource);
+};
+
+// clang-format off
+// returning tuples is confusing clang format
+
+}  // namespace fanotify
+}  // namespace adapter
+}  // namespace watcher
+}  // namespace wtr
+}  // namespace detail
+
+// clang-format on
+
+#endif /* !defined(WATER_WATCHER_USE_WARTHOG) */
+#endif /* defined(WATER_WATCHER_PLATFORM_LINUX_KERNEL_GTE_5_9_0) \
+          && !defined(WATER_WATCHER_PLATFORM_ANDROID_ANY) */
+
+/*  @brief wtr/watcher/<d>/adapter/linux/inotify
+    The Linux `inotify` adapter. */
+
+/*  WATER_WATCHER_PLATFORM_* */
+
+#if defined(WATER_WATCHER_PLATFORM_LINUX_KERNEL_GTE_2_7_0) \
+  || defined(WATER_WATCHER_PLATFORM_ANDROID_ANY)
+#if ! defined(WATER_WATCHER_USE_WARTHOG)
+
+#define WATER_WATCHER_ADAPTER_LINUX_INOTIFY
+
+/*  EPOLL*
+    epoll_ctl
+    epoll_wait
+    epoll_event
+    epoll_create
+    epoll_create1 */
+#include <sys/epoll.h>
+/*  IN_*
+    inotify_init
+    inotify_init1
+    inotify_event
+    inotify_add_watch
+    inotify_rm_watch */
+#include <sys/inotify.h>
+/* open
+   read
+   close */
+#include <unistd.h>
+/*  path
+    is_directory
+    directory_options
+    recursive_directory_iterator */
+#include <filesystem>
+/*  sort */
+#include <algorithm>
+/*  function */
+#include <functional>
+/*  tuple
+    make_tuple */
+#include <tuple>
+/*  error_code */
+#include <system_error>
+/*  string */
+#include <string>
+/*  string_view */
+#include <string_view>
+/*  unordered_map */
+#include <unordered_map>
+/*  memcpy */
+#include <cstring>
+/*  uint32_t */
+#include <cstdint>
+/*  size_t */
+#include <cstddef>
+/*  move */
+#include <utility>
+/*  vector */
+#include <vector>
+/*  NAME_MAX */
+#include <climits>
+/*  event
+    callback
+    filter
+    policy
+    diag
+    beneath
+    roots_type
+    change */
+
+namespace detail {
+namespace wtr {
+namespace watcher {
+namespace adapter {
+namespace inotify {
+
+/*  @brief wtr/watcher/<d>/adapter/linux/inotify/<a>/constants
+    The delay, the size of our event buffer and how many
+    events we take from `epoll_wait` are in the policy.
+    - in_init_opt
+        Use non-blocking IO.
+    - in_watch_opt
+        Everything the policy watches. Both halves of a move
+        are watched, so a rename is seen on the old path and
+        then on the new one, as on the other platforms. We
+        always watch for creation, to watch new directories.
+    @todo
+    - Measure perf of IN_ALL_EVENTS */
+inline constexpr auto in_init_opt = IN_NONBLOCK;
+
+template<class Policy>
+inline constexpr std::uint32_t in_watch_opt =
+  IN_CREATE | IN_Q_OVERFLOW
+  | (Policy::watches(::wtr::watcher::event::what::modify) ? IN_MODIFY : 0)
+  | (Policy::watches(::wtr::watcher::event::what::destroy) ? IN_DELETE : 0)
+  | (Policy::watches(::wtr::watcher::event::what::rename)
+       ? IN_MOVED_FROM | IN_MOVED_TO
+       : 0);
+
+/*  @brief wtr/watcher/<d>/adapter/linux/inotify/<a>/kernel
+    The calls we make to read events and to watch new
+    directories. A policy can make them instead. See
+    `sys_of`. */
+struct kernel {
+  static auto read(int fd, void* buf, std::size_t len) noexcept -> ssize_t
+  {
+    return ::read(fd, buf, len);
+  }
+
+  static auto
+  add_watch(int fd, char const* path, std::uint32_t mask) noexcept -> int
+  {
+    return ::inotify_add_watch(fd, path, mask);
+  }
+};
+
+/*  @brief wtr/watcher/<d>/adapter/linux/inotify/<a>/types
+    - watched_dir
+        A directory's path, where the names in it start
+        from in its root's filter, and which root that is.
+    - path_map_type
+        An alias for a map of file descriptors to the
+        directories we watch.
+    - sys_resource_type
+        An object representing an inotify file descriptor,
+        an epoll file descriptor, an epoll configuration,
+        and whether or not the resources are valid */
+struct watched_dir {
+  std::filesystem::path path;
+  ::wtr::watcher::filter::state state;
+  std::uint32_t root{};
+};
+
+using path_map_type = std::unordered_map<int, watched_dir>;
+
+struct sys_resource_type {
+  bool valid;
+  int watch_fd;
+  int event_fd;
+  epoll_event event_conf;
+};
+
+/*  @brief wtr/watcher/<d>/adapter/linux/inotify/<a>/fns/do_path_map_create
+    If the path given is a directory
+      - find all directories above the base path given.
+      - ignore nonexistent directories.
+      - skip directories which `filter` drops everything in.
+      - return a map of watch descriptors -> directories.
+    If `path` is a file
+      - return it as the only value in a map.
+      - the watch descriptor key should always be 1.
+    Each directory is from the `root`th of the watcher's
+    roots. */
+template<class Sink>
+inline auto path_map(std::filesystem::path const& base_path,
+                     ::wtr::watcher::filter const& filter,
+                     Sink const& callback,
+                     sys_resource_type const& sr,
+                     std::uint32_t root = 0) noexcept -> path_map_type
+{
+  namespace fs = ::std::filesystem;
+  using diag = ::wtr::watcher::diag;
+  using diter = fs::recursive_directory_iterator;
+  using dopt = fs::directory_options;
+  using trace = typename Sink::policy::trace;
+  using sys = sys_of<typename Sink::policy, kernel>;
+
+  /* Follow symlinks, ignore paths which we don't have permissions for. */
+  static constexpr auto fs_dir_opt =
+    dopt::skip_permission_denied & dopt::follow_directory_symlink;
+
+  static constexpr auto path_map_reserve_count = 256;
+
+  auto pm = path_map_type{};
+  pm.reserve(path_map_reserve_count);
+
+  auto not_watched = tally{};
+
+  trace::walk_begin(base_path);
+  auto const walk_began = trace::on ? trace::now() : 0;
+
+  auto do_mark = [&](fs::path const& d, ::wtr::watcher::filter::state state)
+    noexcept -> bool
+  {
+    int wd = sys::add_watch(sr.watch_fd,
+                            d.c_str(),
+                            in_watch_opt<typename Sink::policy>);
+    trace::mark(d, wd >= 0);
+    return wd >= 0
+           ? pm.insert_or_assign(wd, watched_dir{d, state, root}).first
+               != pm.end()
+           : false;
+  };
+
+  try {
+    if (sr.valid)
+      if (do_mark(base_path, filter.start()))
+        if (fs::is_directory(base_path))
+          for (auto dir = diter(base_path, fs_dir_opt); dir != diter{}; ++dir)
+            if (fs::is_directory(*dir)) {
+              using ::detail::wtr::watcher::filter::beneath;
+              auto state = filter.start();
+              if (! filter.empty()) {
+                state = filter.walk(
+                  state,
+                  beneath<char>(dir->path().native(), base_path.native()));
+                /* Nothing in here can be kept. */
+                if (filter.prunes(state)) {
+                  dir.disable_recursion_pending();
+                  continue;
+                }
+                state = filter.walk(state, "/");
+              }
+              if (! do_mark(dir->path(), state))
+                if constexpr (Sink::policy::status)
+                  not_watched(callback,
+                              {.level = diag::level::warning,
+                               .code = diag::code::not_watched,
+                               .error = errno,
+                               .where = base_path.native(),
+                               .also = dir->path().native()});
+            }
+  } catch (...) {}
+
+  not_watched.done(callback);
+
+  if (callback.counts)
+    callback.counts->marks.store(pm.size(),
+                                 std::memory_order_relaxed);
+
+  trace::walk_end(base_path,
+                  pm.size(),
+                  trace::on ? trace::now() - walk_began : 0);
+
+  return pm;
+};
+
+/*  @brief wtr/watcher/<d>/adapter/linux/inotify/<a>/fns/do_path_map_create
+    The same, for every one of `roots`, in one map. The
+    kernel gives a directory which is beneath more than one
+    of them the same watch descriptor, so where they overlap,
+    the deepest root is marked last and keeps it. A root
+    which can't be watched is warned about, and the others
+    are watched without it. */
+template<class Sink>
+inline auto path_map(roots_type const& roots,
+                     Sink const& callback,
+                     sys_resource_type const& sr) noexcept -> path_map_type
+{
+  using diag = ::wtr::watcher::diag;
+
+  if (roots.size() == 1)
+    return path_map(roots.front().path, roots.front().live, callback, sr);
+
+  auto order = std::vector<std::uint32_t>(roots.size());
+  for (auto n = std::uint32_t{0}; n < roots.size(); ++n) order[n] = n;
+  std::sort(order.begin(),
+            order.end(),
+            [&roots](auto l, auto r) noexcept
+            { return roots[l].real.size() < roots[r].real.size(); });
+
+  auto pm = path_map_type{};
+  for (auto const n : order) {
+    auto const& root = roots[n];
+    if (root.path.empty()) continue;
+    auto each = path_map(root.path, root.live, callback, sr, n);
+    if constexpr (Sink::policy::status)
+      if (each.empty())
+        callback.tell({.level = diag::level::warning,
+                       .code = diag::code::not_watched,
+                       .where = root.path.native()});
+    for (auto& [wd, dir] : each) pm.insert_or_assign(wd, std::move(dir));
+  }
+
+  if (callback.counts)
+    callback.counts->marks.store(pm.size(), std::memory_order_relaxed);
+
+  return pm;
+};
+
+/*  @brief wtr/watcher/<d>/adapter/linux/inotify/<a>/fns/adopt
+    Takes the directories in `fresh` into `pm`, except for
+    those which a deeper root already has. */
+inline auto adopt(path_map_type& pm,
+                  path_map_type&& fresh,
+                  roots_type const& roots) noexcept -> void
+{
+  for (auto& [wd, dir] : fresh) {
+    auto const had = pm.find(wd);
+    if (had == pm.end()
+        || roots[had->second.root].real.size() <= roots[dir.root].real.size())
+      pm.insert_or_assign(wd, std::move(dir));
+  }
+}
+
+/*  @brief wtr/watcher/<d>/adapter/linux/inotify/<a>/fns/change_roots
+    Watches the roots added since we last looked, and stops
+    watching those removed, without touching the others.
+    An added root is watched as it would have been from the
+    start. A removed root's directories are let go, unless
+    another root is above them, in which case that root
+    takes them back (after a walk through its tree). */
+template<class Sink>
+inline auto change_roots(sys_resource_type const& sr,
+                         path_map_type& pm,
+                         roots_type& roots,
+                         ::wtr::watcher::filter const& filter,
+                         changes_type const& changes,
+                         Sink const& callback) noexcept -> void
+{
+  namespace fs = ::std::filesystem;
+  using diag = ::wtr::watcher::diag;
+  using policy = typename Sink::policy;
+  using trace = typename policy::trace;
+
+  for (auto const& c : changes) {
+    if (c.root >= roots.size()) roots.resize(c.root + 1);
+
+    if (c.what == change::what::add) {
+      auto ec = std::error_code{};
+      roots[c.root] = {c.path,
+                       fs::weakly_canonical(c.path, ec).native(),
+                       filter.loaded(c.path)};
+      auto const& root = roots[c.root];
+      if constexpr (policy::status)
+        callback.tell({.level = diag::level::status,
+                       .code = diag::code::live,
+                       .where = root.path.native()});
+      auto fresh = path_map(root.path, root.live, callback, sr, c.root);
+      if constexpr (policy::status)
+        if (fresh.empty())
+          callback.tell({.level = diag::level::warning,
+                         .code = diag::code::not_watched,
+                         .where = root.path.native()});
+      adopt(pm, std::move(fresh), roots);
+    }
+
+    else if (! roots[c.root].path.empty()) {
+      auto const gone = std::move(roots[c.root]);
+      roots[c.root] = {};
+
+      auto dropped = path_map_type{};
+      for (auto at = pm.begin(); at != pm.end();)
+        if (at->second.root == c.root) {
+          dropped.insert(std::move(*at));
+          at = pm.erase(at);
+        }
+        else
+          ++at;
+
+      for (auto n = std::uint32_t{0}; n < roots.size(); ++n) {
+        auto const& above = roots[n].real;
+        if (! above.empty() && above.size() < gone.real.size()
+            && gone.real.starts_with(above)
+            && (above.ends_with('/') || gone.real[above.size()] == '/'))
+          adopt(pm, path_map(roots[n].path, roots[n].live, callback, sr, n),
+                roots);
+      }
+
+      for (auto const& [wd, dir] : dropped)
+        if (! pm.contains(wd))
+          trace::unmark(dir.path, inotify_rm_watch(sr.watch_fd, wd) == 0);
+
+      if constexpr (policy::status)
+        callback.tell({.level = diag::level::status,
+                       .code = diag::code::die,
+                       .where = gone.path.native()});
+    }
+  }
+
+  if (callback.counts)
+    callback.counts->marks.store(pm.size(), std::memory_order_relaxed);
+}
+
+/*  @brief wtr/watcher/<d>/adapter/linux/inotify/<a>/fns/system_unfold
+    Produces a `sys_resource_type` with the file descriptors from
+    `inotify_init` and `epoll_create`. Invokes `callback` on errors. */
+template<class Sink>
+inline auto
+system_unfold(Sink const& callback) noexcept
+  -> sys_resource_type
+{
+  using diag = ::wtr::watcher::diag;
+
+  auto do_error = [&callback](enum diag::code code,
+                              int watch_fd,
+                              int event_fd = -1) noexcept -> sys_resource_type
+  {
+    callback.tell(
+      {.level = diag::level::error, .code = code, .error = errno});
+    return sys_resource_type{
+      .valid = false,
+      .watch_fd = watch_fd,
+      .event_fd = event_fd,
+      .event_conf = {.events = 0, .data = {.fd = watch_fd}}
+    };
+  };
+
+  int watch_fd
+#if defined(WATER_WATCHER_PLATFORM_ANDROID_ANY)
+    = inotify_init();
+#elif defined(WATER_WATCHER_PLATFORM_LINUX_KERNEL_ANY)
+    = inotify_init1(in_init_opt);
+#endif
+
+  if (watch_fd >= 0) {
+    epoll_event event_conf{.events = EPOLLIN, .data{.fd = watch_fd}};
+
+    int event_fd
+#if defined(WATER_WATCHER_PLATFORM_ANDROID_ANY)
+      = epoll_create(Sink::policy::wait_max);
+#elif defined(WATER_WATCHER_PLATFORM_LINUX_KERNEL_ANY)
+      = epoll_create1(EPOLL_CLOEXEC);
+#endif
+
+    if (event_fd >= 0)
+      if (epoll_ctl(event_fd, EPOLL_CTL_ADD, watch_fd, &event_conf) >= 0)
+        return sys_resource_type{.valid = true,
+                                 .watch_fd = watch_fd,
+                                 .event_fd = event_fd,
+                                 .event_conf = event_conf};
+      else
+        return do_error(diag::code::epoll_ctl, watch_fd, event_fd);
+    else
+      return do_error(diag::code::epoll_create, watch_fd, event_fd);
+  }
+  else
+    return do_error(diag::code::inotify_init, watch_fd);
+}
+
+/*  @brief wtr/watcher/<d>/adapter/linux/inotify/<a>/fns/system_fold
+    Close the file descriptors `watch_fd` and `event_fd`. */
+inline auto system_fold(sys_resource_type& sr) noexcept -> bool
+{
+  return ! (close(sr.watch_fd) && close(sr.event_fd));
+}
+
+/*  @brief wtr/watcher/<d>/adapter/linux/inotify/<a>/fns/decode
+    What happened, and to what kind of thing, from the
+    mask of an `inotify_event`. */
+inline auto what_of(std::uint32_t mask) noexcept
+  -> enum ::wtr::watcher::event::what
+{
+  using evw = enum ::wtr::watcher::event::what;
+  return mask & IN_CREATE   ? evw::create
+       : mask & IN_DELETE   ? evw::destroy
+       : mask & IN_MOVE     ? evw::rename
+       : mask & IN_MODIFY   ? evw::modify
+                            : evw::other;
+}
+
+inline auto kind_of(std::uint32_t mask) noexcept
+  -> enum ::wtr::watcher::event::kind
+{
+  return mask & IN_ISDIR ? ::wtr::watcher::event::kind::dir
+                         : ::wtr::watcher::event::kind::file;
+}
+
+/*  @brief wtr/watcher/<d>/adapter/linux/inotify/<a>/batch_decoder
+    Reads the `inotify_event`s in our buffer for a `batch`.
+    Records for dropped watches and overflows are skipped.
+    The batch's context is the path map, which is already
+    a table of directories by their watch descriptors. The
+    descriptor is the directory's id. */
+inline auto first_event(char const* at, char const* end) noexcept
+  -> char const*
+{
+  while (at < end
+         && ((inotify_event const*)at)->mask & (IN_IGNORED | IN_Q_OVERFLOW))
+    at += sizeof(inotify_event) + ((inotify_event const*)at)->len;
+  return at < end ? at : end;
+}
+
+inline constexpr auto batch_decoder = ::wtr::watcher::batch::decoder{
+  .first = first_event,
+  .next = [](char const* at, char const* end) noexcept -> char const*
+  {
+    return first_event(
+      at + sizeof(inotify_event) + ((inotify_event const*)at)->len,
+      end);
+  },
+  .what = [](char const* at) noexcept
+  { return what_of(((inotify_event const*)at)->mask); },
+  .kind = [](char const* at) noexcept
+  { return kind_of(((inotify_event const*)at)->mask); },
+  .name = [](char const* at) noexcept
+  {
+    auto const e = (inotify_event const*)at;
+    return e->len > 0 ? std::string_view{e->name} : std::string_view{};
+  },
+  .dir = [](void const*, char const* at) noexcept
+  { return (std::size_t)((inotify_event const*)at)->wd; },
+  .dir_path = [](void const* context, std::size_t wd) noexcept
+  {
+    auto const& pm = *static_cast<path_map_type const*>(context);
+    auto const dir = pm.find((int)wd);
+    return dir == pm.end() ? std::string_view{}
+                           : std::string_view{dir->second.path.native()};
+  },
+  .where = [](void const* context, char const* at, std::string& into) noexcept
+  {
+    auto const e = (inotify_event const*)at;
+    auto const& pm = *static_cast<path_map_type const*>(context);
+    auto const dir = pm.find(e->wd);
+    if (dir == pm.end()) return false;
+    into.assign(dir->second.path.native());
+    into += '/';
+    if (e->len > 0) into.append(e->name);
+    return true;
+  },
+};
+
+/*  @brief wtr/watcher/<d>/adapter/linux/inotify/<a>/fns/do_event_recv
+    Reads through available (inotify) filesystem events.
+    Discerns their path and type.
+    Calls the callback with a view of `where`, which holds
+    the path until the callback returns, or with a view of
+    the whole buffer, if it takes batches.
+    Matches names against the filter of the root their
+    directory is beneath, and says which root that is.
+    Loads the filters again, and watches (or forgets about)
+    the directories they now keep (or drop), if one of them
+    says to when something happens.
+    Returns false on eventful errors.
+
+    @todo
+    Return new directories when they appear,
+    Consider running and returning `find_dirs` from here. */
+template<class Sink>
+inline auto
+do_event_recv(sys_resource_type const& sr,
+              path_map_type& pm,
+              std::string& where,
+              roots_type& roots,
+              Sink const& callback) noexcept -> bool
+{
+  namespace fs = ::std::filesystem;
+
+  using policy = typename Sink::policy;
+  using trace = typename policy::trace;
+  using sys = sys_of<policy, kernel>;
+
+  auto const watch_fd = sr.watch_fd;
+
+  auto reload = false;
+
+  alignas(inotify_event) char buf[policy::buf_len];
+
+  enum class state { eventful, eventless, error };
+
+  /*  While inotify has events pending, read them.
+      There might be several events from a single read.
+
+      Three possible states:
+       - eventful: there are events to read
+       - eventless: there are no events to read
+       - error: there was an error reading events
+
+      The EAGAIN "error" means there is nothing
+      to read. We count that as 'eventless'.
+
+      Forward events and errors to the user.
+
+      Return when eventless. */
+
+recurse:
+
+  auto const read_began = trace::on ? trace::now() : 0;
+
+  ssize_t read_len = sys::read(watch_fd, buf, sizeof(buf));
+
+  trace::read(read_len, trace::on ? trace::now() - read_began : 0);
+
+  auto const counted = counted_read{callback.counts,
+                                    read_len,
+                                    sizeof(buf),
+                                    sizeof(inotify_event) + NAME_MAX + 1};
+
+  switch (read_len > 0      ? state::eventful
+          : read_len == 0   ? state::eventless
+          : errno == EAGAIN ? state::eventless
+                            : state::error) {
+    case state::eventful : {
+      /* Everything in this read happened by now. */
+      auto const when = ::wtr::watcher::event::now(callback.clock);
+
+      /* Whoever takes batches gets the buffer as it is,
+         before we forget about any of the watches in it. */
+      if (callback.batches)
+        callback.batches(::wtr::watcher::batch{buf,
+                                               buf + read_len,
+                                               batch_decoder,
+                                               &pm,
+                                               when,
+                                               callback.clock});
+
+      /* Directories created in this read which we couldn't
+         watch, as the initial walk counts them. */
+      auto not_watched = tally{};
+
+      /* Loop over all events in the buffer.
+         Events are variably sized: the name follows the
+         header and is `len` bytes long, padding included. */
+      auto this_event = (inotify_event*)buf;
+      while (this_event < (inotify_event*)(buf + read_len)) {
+        /* The kernel has already dropped this watch, either
+           because its directory was destroyed or because we
+           asked it to. We only need to forget about it. There
+           is one of these for every directory in a destroyed
+           subtree, so cleaning up here (without a syscall)
+           is cheaper than calling `inotify_rm_watch`. */
+        if (this_event->mask & IN_IGNORED)
+          pm.erase(this_event->wd);
+
+        else if (! (this_event->mask & IN_Q_OVERFLOW)) [[likely]] {
+          /* A watch we just forgot about, on a reload. */
+          auto const found = pm.find(this_event->wd);
+          if (found == pm.end()) [[unlikely]] {
+            this_event = (inotify_event*)((char*)this_event
+                                          + sizeof(inotify_event)
+                                          + this_event->len);
+            continue;
+          }
+          auto const& dir = found->second;
+          auto const& filter = roots[dir.root].live;
+
+          auto name = this_event->len > 0 ? std::string_view{this_event->name}
+                                          : std::string_view{};
+
+          auto kind = kind_of(this_event->mask);
+
+          auto what = what_of(this_event->mask);
+
+          trace::decoded(what, kind, name.size());
+
+          /* Match the name before we make anything out of it. */
+          auto state = filter.empty() ? dir.state : filter.walk(dir.state, name);
+
+          /* The path is put together in a buffer which we
+             reuse, so that sending an event allocates nothing.
+             What the policy doesn't watch was only asked for
+             to follow directories. */
+          if (! callback.batches && policy::watches(what)
+              && (filter.empty() || filter.keeps(state, kind))) {
+            where.assign(dir.path.native());
+            where += '/';
+            where.append(name);
+            callback({where, what, kind, when, callback.clock, dir.root});
+          }
+
+          if (filter.reloads(name)) reload = true;
+
+          if (kind == ::wtr::watcher::event::kind::dir
+              && what == ::wtr::watcher::event::what::create
+              && (filter.empty() || ! filter.prunes(state))) {
+            auto path = dir.path / name;
+            auto wd = sys::add_watch(watch_fd,
+                                     path.c_str(),
+                                     in_watch_opt<policy>);
+            trace::mark(path, wd >= 0);
+            if (wd >= 0)
+              pm[wd] = watched_dir{std::move(path),
+                                   filter.empty() ? state
+                                                  : filter.walk(state, "/"),
+                                   dir.root};
+            else if constexpr (policy::status)
+              not_watched(callback,
+                          {.level = ::wtr::watcher::diag::level::warning,
+                           .code = ::wtr::watcher::diag::code::not_watched,
+                           .error = errno,
+                           .where = roots[dir.root].path.native(),
+                           .also = path.native()});
+          }
+        }
+        else {
+          if (callback.counts)
+            ::wtr::watcher::metrics::add(callback.counts->overflows);
+          callback.tell({.level = ::wtr::watcher::diag::level::error,
+                         .code = ::wtr::watcher::diag::code::overflow,
+                         .where = roots.front().path.native()});
+        }
+
+        this_event = (inotify_event*)((char*)this_event + sizeof(inotify_event)
+                                      + this_event->len);
+      }
+      not_watched.done(callback);
+      /* A `.gitignore` changed. Watching the tree again
+         watches what is newly kept and updates what we
+         have. What is newly dropped is let go. */
+      if (reload) {
+        reload = false;
+        for (auto& root : roots) root.live = root.live.loaded(root.path);
+        auto fresh = path_map(roots, callback, sr);
+        for (auto const& [wd, dir] : pm)
+          if (! fresh.contains(wd))
+            trace::unmark(dir.path, inotify_rm_watch(watch_fd, wd) == 0);
+        pm = std::move(fresh);
+      }
+      counted.done();
+      if (callback.counts)
+        callback.counts->marks.store(pm.size(),
+                                     std::memory_order_relaxed);
+      /* Same as `return do_event_recv(..., buf)`.
+         Our stopping condition is `eventless` or `error`. */
+      goto recurse;
+    }
+
+    case state::error :
+      callback.tell({.level = ::wtr::watcher::diag::level::error,
+                     .code = ::wtr::watcher::diag::code::read,
+                     .error = errno,
+                     .where = roots.front().path.native()});
+      return false;
+
+    case state::eventless : return true;
+  }
+
+  /* Unreachable */
+  return false;
+}
+
+/*  @brief wtr/watcher/<d>/adapter/watch
+    Monitors `paths` for changes, all with one `inotify`
+    instance.
+    Invokes `callback` with an `event` when they happen.
+    `watch` stops when asked to or irrecoverable errors occur.
+    All events, including errors, are passed to `callback`.
+
+    @param paths
+    The filesystem paths to watch for events. Each event
+    says which of them it happened beneath.
+
+    @param filter
+    Which paths, beneath each of `paths`, to send events for.
+
+    @param callback
+    A function to invoke with an `event` object
+    when the files being watched change.
+
+    @param is_living
+    A function to decide whether we're dead.
+
+    @param changes
+    A function which gives us the roots added or removed
+    since we last asked. See `change`. */
+template<class Sink>
+inline bool watch(std::vector<std::filesystem::path> const& paths,
+                  ::wtr::watcher::filter const& filter,
+                  Sink const& callback,
+                  std::function<bool()> const& is_living,
+                  changes_fn const& changes = {}) noexcept
+{
+  using diag = ::wtr::watcher::diag;
+  using policy = typename Sink::policy;
+
+  /* What we say about ourselves is said of the first. */
+  auto const path = paths.empty() ? std::filesystem::path{} : paths.front();
+
+  auto do_error = [&path, &callback](bool clean, enum diag::code code) -> bool
+  {
+    callback.tell(
+      {.level = diag::level::error, .code = code, .where = path.native()});
+
+    if (clean) {
+      if constexpr (policy::status)
+        callback.tell({.level = diag::level::status,
+                       .code = diag::code::die,
+                       .where = path.native()});
+    }
+
+    else
+      callback.tell({.level = diag::level::error,
+                     .code = diag::code::die,
+                     .where = path.native()});
+
+    return false;
+  };
+
+  /*  While living, with
+      - A lifetime the user hasn't ended
+      - A historical map of watch descriptors
+        to long paths (for event reporting)
+      - System resources for inotify and epoll
+      - An event buffer for events from epoll
+
+      Do
+      - Await filesystem events
+      - Invoke `callback` on errors and events */
+
+  sys_resource_type sr = system_unfold(callback);
+
+  epoll_event event_recv_list[policy::wait_max];
+
+  /* Our own copies, which read the `.gitignore`s if they should. */
+  auto roots = roots_of(paths, filter);
+
+  auto pm = path_map(roots, callback, sr);
+
+  /* Where the paths we send are put together. */
+  auto where = std::string{};
+
+  if (sr.valid) [[likely]]
+
+    if (pm.size() > 0 || paths.empty()) [[likely]] {
+      while (is_living()) [[likely]]
+
+      {
+        if (changes)
+          if (auto const changed = changes(); ! changed.empty())
+            change_roots(sr, pm, roots, filter, changed, callback);
+
+        int event_count = epoll_wait(sr.event_fd,
+                                     event_recv_list,
+                                     policy::wait_max,
+                                     policy::delay_ms);
+
+        if (event_count < 0)
+          return do_error(system_fold(sr), diag::code::epoll_wait);
+
+        else if (event_count > 0) [[likely]]
+          for (int n = 0; n < event_count; n++)
+            if (event_recv_list[n].data.fd == sr.watch_fd) [[likely]]
+              if (! do_event_recv(sr, pm, where, roots, callback)) [[unlikely]]
+                return do_error(system_fold(sr), diag::code::event_recv);
+      }
+
+      if constexpr (policy::status)
+        callback.tell({.level = diag::level::status,
+                       .code = diag::code::die,
+                       .where = path.native()});
+      return system_fold(sr);
+    }
+    else
+      return do_error(system_fold(sr), diag::code::path_map);
+
+  else
+    return do_error(system_fold(sr), diag::code::sys_resource);
+}
+
+} /* namespace inotify */
+} /* namespace adapter */
+} /* namespace watcher */
+} /* namespace wtr */
+} /* namespace detail */
+
+#endif /* !defined(WATER_WATCHER_USE_WARTHOG) */
+#endif /* defined(WATER_WATCHER_PLATFORM_LINUX_KERNEL_GTE_2_7_0) \
+          || defined(WATER_WATCHER_PLATFORM_ANDROID_ANY) */
+
+/*
+  @brief wtr/detail/wtr/watcher/adapter/linux
+
+  The Linux adapters.
+*/
+
+/* WATER_WATCHER_PLATFORM_* */
+
+#if defined(WATER_WATCHER_PLATFORM_LINUX_KERNEL_GTE_2_7_0) \
+  || defined(WATER_WATCHER_PLATFORM_ANDROID_ANY)
+#if ! defined(WATER_WATCHER_USE_WARTHOG)
+
+/* function */
+#include <functional>
+/* vector */
+#include <vector>
+/* geteuid */
+#include <unistd.h>
+/* event
+   callback
+   filter
+   inotify::watch
+   fanotify::watch */
+
+namespace detail {
+namespace wtr {
+namespace watcher {
+namespace adapter {
+
+/*
+  @brief detail/wtr/watcher/adapter/watch
+
+  Monitors `paths` for changes, all with one kernel
+  instance.
+  Invokes `callback` with an `event` when they happen.
+  `watch` stops when asked to or unrecoverable errors occur.
+  All events, including errors, are passed to `callback`.
+
+  @param paths
+    The filesystem paths to watch for events. Each event
+    says which of them it happened beneath.
+
+  @param filter
+    Which paths, beneath each of `paths`, to send events for.
+
+  @param callback
+    A function to invoke with an `event` object
+    when the files being watched change.
+
+  @param is_living
+    A function to decide whether we're dead.
+
+  @param changes
+    A function to say which roots were added or removed
+    since we last asked. We ask between reads.
+
+  @note
+  If we have a kernel that can use either `fanotify` or
+  `inotify`, then we will use `fanotify` if the user is
+  (effectively) root.
+
+  If we can only use `fanotify` or `inotify`, then we'll
+  use them. We only use `inotify` on Android.
+
+  There should never be a system that can use `fanotify`,
+  but not `inotify`. It's just here for completeness.
+*/
+
+template<class Sink>
+inline bool watch(std::vector<std::filesystem::path> const& paths,
+                  ::wtr::watcher::filter const& filter,
+                  Sink const& callback,
+                  std::function<bool()> const& is_living,
+                  changes_fn const& changes = {}) noexcept
+{
+  return
+
+#if defined(WATER_WATCHER_ADAPTER_LINUX_FANOTIFY) \
+  && defined(WATER_WATCHER_ADAPTER_LINUX_INOTIFY)
+
+    geteuid() == 0
+      ? fanotify::watch(paths, filter, callback, is_living, changes)
+      : inotify::watch(paths, filter, callback, is_living, changes);
+
+#elif defined(WATER_WATCHER_ADAPTER_LINUX_FANOTIFY)
+
+    fanotify::watch(paths, filter, callback, is_living, changes);
+
+#elif defined(WATER_WATCHER_ADAPTER_LINUX_INOTIFY)
+
+    inotify::watch(paths, filter, callback, is_living, changes);
+
+#else
+
+#error "Define 'WATER_WATCHER_USE_WARTHOG' on kernel versions < 2.7"
+
+#endif
+}
+
+} /* namespace adapter */
+} /* namespace watcher */
+} /* namespace wtr */
+} /* namespace detail */
+
+#endif /* defined(WATER_WATCHER_PLATFORM_LINUX_KERNEL_GTE_2_7_0) \
+          || defined(WATER_WATCHER_PLATFORM_ANDROID_ANY) */
+#endif /* !defined(WATER_WATCHER_USE_WARTHOG) */
+
+/*  WATER_WATCHER_PLATFORM_* */
+
+#if defined(WATER_WATCHER_PLATFORM_LINUX_KERNEL_GTE_2_7_0) \
+  || defined(WATER_WATCHER_PLATFORM_ANDROID_ANY)
+#if ! defined(WATER_WATCHER_USE_WARTHOG)
+
+/*  errno
+    EAGAIN */
+#include <cerrno>
+/*  int64_t
+    uint32_t */
+#include <cstdint>
+/*  FILE
+    fopen
+    fread
+    fwrite
+    fclose */
+#include <cstdio>
+/*  memcpy
+    strlen */
+#include <cstring>
+/*  path */
+#include <filesystem>
+/*  mutex
+    scoped_lock */
+#include <mutex>
+/*  string */
+#include <string>
+/*  string_view */
+#include <string_view>
+/*  vector */
+#include <vector>
+/*  event
+    filter
+    policy
+    metrics
+    sink
+    inotify::kernel
+    fanotify::kernel */
+
+namespace detail {
+namespace wtr {
+namespace watcher {
+namespace adapter {
+
+/*  @brief wtr/watcher/<d>/adapter/linux/recording
+    What the kernel told an adapter, in the order it did:
+      - read
+          The bytes from a read which gave us some.
+      - watch
+          A directory given to `inotify_add_watch`. The
+          value is the watch descriptor we got back.
+      - mark
+          A directory given to `fanotify_mark`. The value
+          is what it returned.
+      - dir
+          The path of a directory we found by its handle.
+          The value is its length, or 0 or less if we
+          couldn't find it.
+    Everything which is watched or marked before the first
+    read is the tree we started with.
+
+    In a file, each entry is its type (a byte), its value
+    (eight bytes), the length of its bytes (four) and then
+    its bytes, in the byte order of the host which wrote it. */
+struct recording {
+  enum class type : char {
+    read = 'r',
+    watch = 'w',
+    mark = 'm',
+    dir = 'd',
+  };
+
+  struct entry {
+    enum type type {};
+    std::int64_t value{};
+    std::string bytes{};
+  };
+
+  std::vector<entry> entries{};
+
+  static auto put(std::FILE* to,
+                  enum type t,
+                  std::int64_t value,
+                  void const* bytes,
+                  std::uint32_t len) noexcept -> bool
+  {
+    return std::fwrite(&t, sizeof(t), 1, to) == 1
+        && std::fwrite(&value, sizeof(value), 1, to) == 1
+        && std::fwrite(&len, sizeof(len), 1, to) == 1
+        && (len == 0 || std::fwrite(bytes, len, 1, to) == 1);
+  }
+
+  /*  Reads a recording from a file, or returns an empty
+      one if we can't. */
+  static auto load(std::filesystem::path const& from) noexcept -> recording
+  {
+    auto r = recording{};
+    auto in = std::fopen(from.c_str(), "rb");
+    if (! in) return r;
+    try {
+      for (auto e = entry{};;) {
+        auto len = std::uint32_t{};
+        if (std::fread(&e.type, sizeof(e.type), 1, in) != 1
+            || std::fread(&e.value, sizeof(e.value), 1, in) != 1
+            || std::fread(&len, sizeof(len), 1, in) != 1)
+          break;
+        e.bytes.resize(len);
+        if (len > 0 && std::fread(e.bytes.data(), len, 1, in) != 1) break;
+        r.entries.push_back(e);
+      }
+    } catch (...) {
+      r.entries.clear();
+    }
+    std::fclose(in);
+    return r;
+  }
+
+  /*  Where the first read is, after the tree we started
+      with. */
+  auto first_read() const noexcept -> std::size_t
+  {
+    auto at = std::size_t{0};
+    while (at < this->entries.size() && this->entries[at].type != type::read)
+      ++at;
+    return at;
+  }
+
+  /*  The path we watched: the first one we marked. */
+  auto root() const noexcept -> std::string_view
+  {
+    for (auto const& e : this->entries)
+      if (e.type == type::watch || e.type == type::mark) return e.bytes;
+    return {};
+  }
+
+  /*  Whether this came from `inotify` (or else `fanotify`). */
+  auto from_inotify() const noexcept -> bool
+  {
+    for (auto const& e : this->entries)
+      if (e.type == type::watch) return true;
+    return false;
+  }
+};
+
+/*  @brief wtr/watcher/<d>/adapter/linux/record
+    Makes the calls an adapter makes to the kernel, and
+    writes what it said to `to`, if it isn't null. Give it
+    to a watcher as its policy's `sys`:
+
+      struct recorded : policy {
+        using sys = ::detail::wtr::watcher::adapter::record;
+      };
+      record::to = std::fopen("events.rec", "wb");
+      auto w = watch<recorded>(".", callback);
+      ...
+      w.close();
+      std::fclose(record::to);
+
+    Every watcher with this policy writes to the same file,
+    so there should only be one at a time. */
+struct record {
+  static inline std::FILE* to = nullptr;
+  static inline std::mutex lk{};
+
+  static auto put(enum recording::type t,
+                  std::int64_t value,
+                  void const* bytes,
+                  std::size_t len) noexcept -> void
+  {
+    auto _ = std::scoped_lock{lk};
+    if (to) recording::put(to, t, value, bytes, (std::uint32_t)len);
+  }
+
+  static auto read(int fd, void* buf, std::size_t len) noexcept -> ssize_t
+  {
+    auto const n = ::read(fd, buf, len);
+    if (n > 0) put(recording::type::read, n, buf, (std::size_t)n);
+    return n;
+  }
+
+#if defined(WATER_WATCHER_ADAPTER_LINUX_INOTIFY)
+  static auto
+  add_watch(int fd, char const* path, std::uint32_t mask) noexcept -> int
+  {
+    auto const wd = inotify::kernel::add_watch(fd, path, mask);
+    put(recording::type::watch, wd, path, std::strlen(path));
+    return wd;
+  }
+#endif
+
+#if defined(WATER_WATCHER_ADAPTER_LINUX_FANOTIFY)
+  static auto mark(int fd,
+                   unsigned flags,
+                   std::uint64_t mask,
+                   char const* path) noexcept -> int
+  {
+    auto const r = fanotify::kernel::mark(fd, flags, mask, path);
+    put(recording::type::mark, r, path, std::strlen(path));
+    return r;
+  }
+
+  static auto dir_path(file_handle* fh, char* into, std::size_t len) noexcept
+    -> ssize_t
+  {
+    auto const n = fanotify::kernel::dir_path(fh, into, len);
+    put(recording::type::dir, n, into, n > 0 ? (std::size_t)n : 0);
+    return n;
+  }
+#endif
+};
+
+/*  @brief wtr/watcher/<d>/adapter/linux/replay
+    Says what the kernel said in a `recording`, instead of
+    asking it. Each call is answered by the next entry of
+    its type. When the reads run out, there is nothing more
+    to read (`EAGAIN`). One recording is played at a time on
+    each thread. See `play`. */
+struct replay {
+  static inline thread_local recording const* from = nullptr;
+  static inline thread_local std::size_t next_read = 0;
+  static inline thread_local std::size_t next_watch = 0;
+  static inline thread_local std::size_t next_mark = 0;
+  static inline thread_local std::size_t next_dir = 0;
+
+  static auto next(enum recording::type t, std::size_t& at) noexcept
+    -> recording::entry const*
+  {
+    if (! from) return nullptr;
+    while (at < from->entries.size() && from->entries[at].type != t) ++at;
+    return at < from->entries.size() ? &from->entries[at++] : nullptr;
+  }
+
+  static auto read(int, void* buf, std::size_t len) noexcept -> ssize_t
+  {
+    auto const e = next(recording::type::read, next_read);
+    if (! e) {
+      errno = EAGAIN;
+      return -1;
+    }
+    auto const n = e->bytes.size() < len ? e->bytes.size() : len;
+    std::memcpy(buf, e->bytes.data(), n);
+    return (ssize_t)n;
+  }
+
+  static auto add_watch(int, char const*, std::uint32_t) noexcept -> int
+  {
+    auto const e = next(recording::type::watch, next_watch);
+    return e ? (int)e->value : -1;
+  }
+
+  static auto mark(int, unsigned, std::uint64_t, char const*) noexcept -> int
+  {
+    auto const e = next(recording::type::mark, next_mark);
+    return e ? (int)e->value : -1;
+  }
+
+  template<class Handle>
+  static auto dir_path(Handle*, char* into, std::size_t len) noexcept
+    -> ssize_t
+  {
+    auto const e = next(recording::type::dir, next_dir);
+    if (! e || e->value <= 0 || e->bytes.size() > len) return -1;
+    std::memcpy(into, e->bytes.data(), e->bytes.size());
+    return (ssize_t)e->bytes.size();
+  }
+};
+
+/*  @brief wtr/watcher/<d>/adapter/linux/replayed
+    `Policy`, played back. */
+template<class Policy>
+struct replayed : Policy {
+  using sys = replay;
+};
+
+/*  @brief wtr/watcher/<d>/adapter/linux/play
+    Plays `from` back through the adapter which recorded it,
+    as fast as it can be read, and sends what it makes of
+    it to `each`, counted in `counts`. Nothing is asked of
+    the kernel, so this measures what we do with what it
+    says: decoding, putting paths together and sending.
+    Returns false if there was nothing to play, or if it
+    came from an adapter which isn't here. */
+template<class Policy = ::wtr::watcher::policy, class Each>
+inline auto play(recording const& from,
+                 Each const& each,
+                 ::wtr::watcher::metrics* counts = nullptr) noexcept -> bool
+{
+  auto const sink =
+    adapter::sink<Each, replayed<Policy>>{.each = each,
+                                          .clock = Policy::clock,
+                                          .counts = counts};
+  auto const first_read = from.first_read();
+  auto const base_path = std::filesystem::path{from.root()};
+  auto const live = ::wtr::watcher::filter{};
+  auto roots = roots_type{{base_path, base_path.native(), live}};
+
+  if (from.entries.empty()) return false;
+
+  replay::from = &from;
+  replay::next_read = first_read;
+  replay::next_watch = first_read;
+  replay::next_mark = first_read;
+  replay::next_dir = 0;
+
+  auto ok = false;
+
+  if (from.from_inotify()) {
+#if defined(WATER_WATCHER_ADAPTER_LINUX_INOTIFY)
+    auto pm = inotify::path_map_type{};
+    for (auto at = std::size_t{0}; at < first_read; ++at)
+      if (from.entries[at].type == recording::type::watch)
+        pm[(int)from.entries[at].value] =
+          inotify::watched_dir{from.entries[at].bytes, live.start()};
+    auto const sr = inotify::sys_resource_type{.valid = true,
+                                               .watch_fd = -1,
+                                               .event_fd = -1,
+                                               .event_conf = {}};
+    auto where = std::string{};
+    ok = inotify::do_event_recv(sr, pm, where, roots, sink);
+#endif
+  }
+  else {
+#if defined(WATER_WATCHER_ADAPTER_LINUX_FANOTIFY)
+    auto sr = fanotify::system_resources{
+      .valid = true,
+      .watch_fd = -1,
+      .event_fd = -1,
+      .event_conf = {},
+      .mark_set = {},
+      .dirs = {},
+      .mark_mask = fanotify::fan_mark_mask<replayed<Policy>>,
+    };
+    ok = true;
+    while (ok && replay::next_read < from.entries.size())
+      ok = fanotify::recv(sr, roots, sink);
+#endif
+  }
+
+  replay::from = nullptr;
+  return ok;
+}
+
+} /* namespace adapter */
+} /* namespace watcher */
+} /* namespace wtr */
+} /* namespace detail */
+
+#endif /* !defined(WATER_WATCHER_USE_WARTHOG) */
+#endif /* defined(WATER_WATCHER_PLATFORM_LINUX_KERNEL_GTE_2_7_0) \
+          || defined(WATER_WATCHER_PLATFORM_ANDROID_ANY) */
+
+/*
+  @brief watcher/adapter/android
+
+  The Android (Linux) `inotify` adapter.
+*/
+
+/* WATER_WATCHER_PLATFORM_* */
+
+#if defined(WATER_WATCHER_PLATFORM_ANDROID_ANY)
+#endif
+
+/* WATER_WATCHER_PLATFORM_* */
+
+#if defined(WATER_WATCHER_PLATFORM_UNKNOWN) \
+  || defined(WATER_WATCHER_USE_WARTHOG)
+
+#define WATER_WATCHER_ADAPTER_WARTHOG
+
+/*
+  @brief watcher/adapter/warthog
+
+  A reasonably dumb adapter that works on any platform.
+
+  This adapter beats `kqueue`, but it doesn't bean recieving
+  filesystem events directly from the OS.
+
+  This is the fallback adapter on platforms that either
+    - Only support `kqueue` (`warthog` beats `kqueue`)
+    - Only support the C++ standard library
+*/
+
+/* milliseconds */
+#include <chrono>
+/* uint64_t */
+#include <cstdint>
+/* string */
+#include <string>
+/* string_view */
+#include <string_view>
+/* filesystem::* */
+#include <filesystem>
+/* function */
+#include <functional>
+/* error_code */
+#include <system_error>
+/* this_thread::sleep_for */
+#include <thread>
+/* unordered_map */
+#include <unordered_map>
+/* event
+   callback
+   filter
+   policy
+   metrics */
+
+namespace detail {
+namespace wtr {
+namespace watcher {
+namespace adapter {
+namespace {
+
+/* clang-format off */
+
+inline constexpr std::filesystem::directory_options
+  scan_dir_options = 
+    /* This is ridiculous */
+    std::filesystem::directory_options::skip_permission_denied 
+    & std::filesystem::directory_options::follow_directory_symlink;
+
+using bucket_type = std::unordered_map<std::string, std::filesystem::file_time_type>;
+
+/* clang-format on */
+
+/*  @brief watcher/adapter/warthog/scan
+    - Scans `path` for changes.
+    - Updates our bucket to match the changes.
+    - Calls `send_event` when changes happen.
+    - Returns false if the file tree cannot be scanned. */
+inline bool scan(std::filesystem::path const& path,
+                 auto const& send_event,
+                 bucket_type& bucket) noexcept
+{
+  /* @brief watcher/adapter/warthog/scan_file
+     - Scans a (single) file for changes.
+     - Updates our bucket to match the changes.
+     - Calls `send_event` when changes happen.
+     - Returns false if the file cannot be scanned. */
+  auto const& scan_file = [&](std::filesystem::path const& file,
+                              auto const& send_event) -> bool
+  {
+    using namespace ::wtr::watcher;
+    using std::filesystem::exists, std::filesystem::is_regular_file,
+      std::filesystem::last_write_time;
+
+    if (exists(file) && is_regular_file(file)) {
+      auto ec = std::error_code{};
+      /* grabbing the file's last write time */
+      auto const& timestamp = last_write_time(file, ec);
+      if (ec) {
+        /* the file changed while we were looking at it. so, we call the
+         * closure, indicating destruction, and remove it from the bucket. */
+        send_event(event{file, event::what::destroy, event::kind::file});
+        if (bucket.contains(file)) bucket.erase(file);
+      }
+      /* if it's not in our bucket, */
+      else if (! bucket.contains(file)) {
+        /* we put it in there and call the closure, indicating creation. */
+        bucket[file] = timestamp;
+        send_event(event{file, event::what::create, event::kind::file});
+      }
+      /* otherwise, it is already in our bucket. */
+      else {
+        /* we update the file's last write time, */
+        if (bucket[file] != timestamp) {
+          bucket[file] = timestamp;
+          /* and call the closure on them, indicating modification */
+          send_event(event{file, event::what::modify, event::kind::file});
+        }
+      }
+      return true;
+    } /* if the path doesn't exist, we nudge the callee with `false` */
+    else
+      return false;
+  };
+
+  /* @brief watcher/adapter/warthog/scan_directory
+     - Scans a (single) directory for changes.
+     - Updates our bucket to match the changes.
+     - Calls `send_event` when changes happen.
+     - Returns false if the directory cannot be scanned. */
+  auto const& scan_directory = [&](std::filesystem::path const& dir,
+                                   auto const& send_event) -> bool
+  {
+    using std::filesystem::recursive_directory_iterator,
+      std::filesystem::is_directory;
+    /* if this thing is a directory */
+    if (is_directory(dir)) {
+      /* try to iterate through its contents */
+      auto dir_it_ec = std::error_code{};
+      for (auto const& file :
+           recursive_directory_iterator(dir, scan_dir_options, dir_it_ec))
+        /* while handling errors */
+        if (dir_it_ec)
+          return false;
+        else
+          scan_file(file.path(), send_event);
+      return true;
+    }
+    else
+      return false;
+  };
+
+  return scan_directory(path, send_event) ? true
+       : scan_file(path, send_event)      ? true
+                                          : false;
+};
+
+/* @brief wtr/watcher/warthog/tend_bucket
+   If the bucket is empty, try to populate it.
+   otherwise, prune it. */
+inline bool tend_bucket(std::filesystem::path const& path,
+                        auto const& send_event,
+                        bucket_type& bucket) noexcept
+{
+  /*  @brief watcher/adapter/warthog/populate
+      @param path - path to monitor for
+      Creates a file map, the "bucket", from `path`. */
+  auto const& populate = [&](std::filesystem::path const& path) -> bool
+  {
+    using std::filesystem::exists, std::filesystem::is_directory,
+      std::filesystem::recursive_directory_iterator,
+      std::filesystem::last_write_time;
+    /* this happens when a path was changed while we were reading it.
+     there is nothing to do here; we prune later. */
+    auto dir_it_ec = std::error_code{};
+    auto lwt_ec = std::error_code{};
+    if (exists(path)) {
+      /* this is a directory */
+      if (is_directory(path)) {
+        for (auto const& file :
+             recursive_directory_iterator(path, scan_dir_options, dir_it_ec)) {
+          if (! dir_it_ec) {
+            auto const& lwt = last_write_time(file, lwt_ec);
+            if (! lwt_ec)
+              bucket[file.path()] = lwt;
+            else
+              /* @todo use this practice elsewhere or make a fn for it
+                 otherwise, this might be confusing and inconsistent. */
+              bucket[file.path()] = last_write_time(path);
+          }
+        }
+      }
+      /* this is a file */
+      else {
+        bucket[path] = last_write_time(path);
+      }
+    }
+    else {
+      return false;
+    }
+    return true;
+  };
+
+  /*  @brief watcher/adapter/warthog/prune
+      Removes files which no longer exist from our bucket. */
+  auto const& prune = [&](std::filesystem::path const& path,
+                          auto const& send_event) -> bool
+  {
+    using namespace ::wtr::watcher;
+    using std::filesystem::exists, std::filesystem::is_regular_file,
+      std::filesystem::is_directory, std::filesystem::is_symlink;
+
+    auto bucket_it = bucket.begin();
+    /* while looking through the bucket's contents, */
+    while (bucket_it != bucket.end()) {
+      /* check if the stuff in our bucket exists anymore. */
+      exists(bucket_it->first)
+        /* if so, move on. */
+        ? std::advance(bucket_it, 1)
+        /* if not, call the closure, indicating destruction,
+           and remove it from our bucket. */
+        : [&]()
+      {
+        send_event(event{bucket_it->first,
+                         event::what::destroy,
+                         is_regular_file(path) ? event::kind::file
+                         : is_directory(path)  ? event::kind::dir
+                         : is_symlink(path)    ? event::kind::sym_link
+                                               : event::kind::other});
+        /* bucket, erase it! */
+        bucket_it = bucket.erase(bucket_it);
+      }();
+    }
+    return true;
+  };
+
+  return bucket.empty() ? populate(path)          ? true
+                        : prune(path, send_event) ? true
+                                                  : false
+                        : true;
+};
+
+} /* namespace */
+
+/*
+  @brief watcher/adapter/warthog/watch
+
+  @param path:
+   A path to watch for changes.
+
+  @param filter:
+   Which paths, beneath `path`, to send events for.
+
+  @param callback:
+   A callback to perform when the files
+   being watched change.
+
+  @param counts:
+   Where to count our scans, how many events each one
+   sends and how many files we know about, or nothing.
+   Other roots may be counted there too, from their own
+   threads, so we only add (and take back) our own.
+
+  @param Policy:
+   How long to sleep between scans, whether to send our
+   status, which changes to send and what to trace. See
+   `policy` and `trace`.
+
+  Monitors `path` for changes.
+
+  Calls `callback` with an `event` when they happen.
+
+  Unless it should stop, or errors present, `watch` recurses.
+*/
+
+template<class Policy = ::wtr::watcher::policy>
+inline bool watch(std::filesystem::path const& path,
+                  ::wtr::watcher::filter const& filter,
+                  ::wtr::watcher::event::callback const& callback,
+                  std::function<bool()> const& is_living,
+                  ::wtr::watcher::metrics* counts = nullptr) noexcept
+{
+  using evk = enum ::wtr::watcher::event::kind;
+  using evw = enum ::wtr::watcher::event::what;
+  using std::this_thread::sleep_for, std::chrono::milliseconds;
+  using trace = typename Policy::trace;
+  /* Sleep for `delay_ms`.
+
+     Then, keep running if
+       - We are alive
+       - The bucket is doing well
+       - No errors occured while scanning
+
+     Otherwise, stop and return false. */
+
+  bucket_type bucket;
+
+  /* Our own copy, which reads the `.gitignore`s if it should. */
+  auto live = filter.loaded(path);
+
+  /* What we sent, and how many files we have counted as
+     known, so far. */
+  auto sent = std::uint64_t{0};
+  auto known = std::uint64_t{0};
+
+  /* We scan paths, not names, so we match them as we send.
+     When a `.gitignore` changes, we read them again. */
+  auto const send_event = [&](::wtr::watcher::event const& e) noexcept
+  {
+    if (live.reloads(std::string_view{e.where.filename().native()}))
+      live = live.loaded(path);
+    if (! Policy::watches(e.what)) return;
+    trace::decoded(e.what, e.kind, e.where.native().size());
+    if (live.empty()
+        || live.keeps(e.where.lexically_relative(path).generic_string(),
+                      e.kind)) {
+      ++sent;
+      callback(e);
+    }
+  };
+
+  /* Counts a scan, and what it sent. */
+  auto const count = [&](std::uint64_t sent_before) noexcept
+  {
+    if (! counts) return;
+    ::wtr::watcher::metrics::add(counts->reads);
+    counts->read_events.record(sent - sent_before);
+    ::wtr::watcher::metrics::add(counts->marks, bucket.size() - known);
+    known = bucket.size();
+  };
+
+  static constexpr auto delay_ms = Policy::delay_ms;
+
+  while (is_living()) {
+    /* An empty bucket is filled by walking the tree. */
+    auto const walking = trace::on && bucket.empty();
+    if (walking) trace::walk_begin(path);
+    auto const walk_began = walking ? trace::now() : 0;
+    auto const tended = tend_bucket(path, send_event, bucket);
+    if (walking)
+      trace::walk_end(path, bucket.size(), trace::now() - walk_began);
+    auto const sent_before = sent;
+    auto const scanned = tended && scan(path, send_event, bucket);
+    count(sent_before);
+    if (! scanned) {
+      if (counts) counts->marks.fetch_sub(known, std::memory_order_relaxed);
+      callback(
+        {"e/self/die/bad_fs@" + path.string(), evw::destroy, evk::watcher});
+
+      return false;
+    }
+    else {
+      if constexpr (delay_ms > 0) sleep_for(milliseconds(delay_ms));
+    }
+  }
+
+  if (counts) counts->marks.fetch_sub(known, std::memory_order_relaxed);
+
+  if constexpr (Policy::status)
+    callback({"s/self/die@" + path.string(), evw::destroy, evk::watcher});
+
+  return true;
+}
+
+} /* namespace adapter */
+} /* namespace watcher */
+} /* namespace wtr */
+} /* namespace detail */
+
+#endif /* defined(WATER_WATCHER_PLATFORM_UNKNOWN) \
+          || defined(WATER_WATCHER_USE_WARTHOG) */
+
+/*
+  @brief watcher/adapter/synthetic
+
+  An adapter which makes its events up, on any platform.
+
+  Nothing is read from the kernel and nothing on disk is
+  touched, so whatever is measured downstream of it (the
+  filter, the callback, the stages after it) is ours. See
+  `synthetic` for the shape of what it makes.
+*/
+
+/* log,
+   pow */
+#include <cmath>
+/* size_t */
+#include <cstddef>
+/* uint32_t,
+   uint64_t */
+#include <cstdint>
+/* path */
+#include <filesystem>
+/* function */
+#include <functional>
+/* string */
+#include <string>
+/* string_view */
+#include <string_view>
+/* steady_clock,
+   duration,
+   milliseconds */
+#include <chrono>
+/* this_thread::sleep_until */
+#include <thread>
+/* is_invocable_v */
+#include <type_traits>
+/* vector */
+#include <vector>
+/* event
+   diag
+   filter
+   policy
+   metrics
+   synthetic */
+
+namespace detail {
+namespace wtr {
+namespace watcher {
+namespace adapter {
+namespace synthetic {
+
+/*  @brief watcher/adapter/synthetic/rng
+    A small, quick generator (splitmix64). The same seed
+    makes the same numbers everywhere. */
+struct rng {
+  std::uint64_t s{};
+
+  auto next() noexcept -> std::uint64_t
+  {
+    auto z = (this->s += 0x9e3779b97f4a7c15ull);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return z ^ (z >> 31);
+  }
+
+  /*  In [0, n). */
+  auto below(std::uint64_t n) noexcept -> std::uint64_t
+  {
+#if defined(__SIZEOF_INT128__)
+    return (std::uint64_t)(((unsigned __int128)this->next() * n) >> 64);
+#else
+    return this->next() % n;
+#endif
+  }
+
+  /*  In (0, 1]. */
+  auto unit() noexcept -> double
+  {
+    return (double)((this->next() >> 11) + 1) * 0x1.0p-53;
+  }
+};
+
+/*  @brief watcher/adapter/synthetic/tree
+    The files we make events for, each with its full path
+    and its name, and the directory it is in. Directories
+    have the state which their things start from in the
+    filter, or are pruned. With some `skew`, `pick` maps a
+    uniform number to a file, which is hotter the lower
+    its index. */
+struct tree {
+  std::vector<std::filesystem::path::string_type> paths{};
+  std::vector<std::string> names{};
+  std::vector<std::uint32_t> dir_of{};
+  std::vector<::wtr::watcher::filter::state> dir_states{};
+  std::vector<bool> dir_pruned{};
+  std::vector<std::uint32_t> pick{};
+};
+
+inline auto tree_of(std::filesystem::path const& root,
+                    ::wtr::watcher::synthetic const& s,
+                    ::wtr::watcher::filter const& filter) -> tree
+{
+  static constexpr char const* exts[] = {".txt", ".cpp", ".hpp", ".o"};
+
+  auto t = tree{};
+  auto const dir_count = s.depth > 0 && s.dirs > 0 ? s.dirs : 1;
+  auto const file_count = s.files > 0 ? s.files : 1;
+
+  auto dirs = std::vector<std::filesystem::path>{};
+  dirs.reserve(dir_count);
+  for (std::size_t d = 0; d < dir_count; ++d) {
+    auto rel = std::string{};
+    for (std::size_t level = 0; level < s.depth; ++level) {
+      if (level > 0) rel += '/';
+      rel += level == 0 ? "d" + std::to_string(d)
+                        : "s" + std::to_string(level);
+    }
+    auto state = filter.start();
+    auto pruned = false;
+    if (! filter.empty() && ! rel.empty()) {
+      state = filter.walk(state, rel);
+      pruned = filter.prunes(state);
+      state = filter.walk(state, "/");
+    }
+    dirs.push_back(rel.empty() ? root : root / rel);
+    t.dir_states.push_back(state);
+    t.dir_pruned.push_back(pruned);
+  }
+
+  t.paths.reserve(file_count);
+  t.names.reserve(file_count);
+  t.dir_of.reserve(file_count);
+  for (std::size_t f = 0; f < file_count; ++f) {
+    auto const d = f % dir_count;
+    t.names.push_back("f" + std::to_string(f) + exts[f % 4]);
+    t.paths.push_back((dirs[d] / t.names.back()).native());
+    t.dir_of.push_back((std::uint32_t)d);
+  }
+
+  /* The inverse of the distribution, at the middle of each
+     of a few buckets for each file. */
+  if (s.skew > 0) {
+    auto cdf = std::vector<double>(file_count);
+    auto sum = 0.0;
+    for (std::size_t f = 0; f < file_count; ++f)
+      cdf[f] = (sum += 1.0 / std::pow((double)(f + 1), s.skew));
+    auto const buckets = file_count * 4 < 65536 ? 65536 : file_count * 4;
+    t.pick.resize(buckets);
+    auto f = std::size_t{0};
+    for (std::size_t b = 0; b < buckets; ++b) {
+      auto const u = ((double)b + 0.5) / (double)buckets * sum;
+      while (f + 1 < file_count && cdf[f] < u) ++f;
+      t.pick[b] = (std::uint32_t)f;
+    }
+  }
+
+  return t;
+}
+
+/*
+  @brief watcher/adapter/synthetic/watch
+
+  @param path:
+   Where the files we make up are, beneath.
+
+  @param filter:
+   Which paths, beneath `path`, to send events for. The
+   `.gitignore`s beneath `path` aren't read.
+
+  @param stream:
+   What to make. See `synthetic`.
+
+  @param callback:
+   Where to send what we make: a Linux adapter's sink, or
+   an event callback.
+
+  @param is_living:
+   A function to decide whether we're dead.
+
+  @param clock:
+   What to stamp events with.
+
+  @param counts:
+   Where to count each chunk of events as a read, or
+   nothing. Sends are counted by the callback.
+
+  @param Policy:
+   Whether to send our status, which changes to send and
+   what to trace. See `policy` and `trace`.
+
+  Makes events until it is closed, or has made `count`.
+*/
+
+template<class Policy = ::wtr::watcher::policy, class Sink>
+inline bool watch(std::filesystem::path const& path,
+                  ::wtr::watcher::filter const& filter,
+                  ::wtr::watcher::synthetic const& stream,
+                  Sink const& callback,
+                  std::function<bool()> const& is_living,
+                  enum ::wtr::watcher::event::clock clock,
+                  ::wtr::watcher::metrics* counts = nullptr) noexcept
+{
+  using evk = enum ::wtr::watcher::event::kind;
+  using evw = enum ::wtr::watcher::event::what;
+  using ev = ::wtr::watcher::event;
+  using diag = ::wtr::watcher::diag;
+  using shape = enum ::wtr::watcher::synthetic::shape;
+  using trace = typename Policy::trace;
+  using steady = std::chrono::steady_clock;
+
+  auto const die = [&](bool clean) noexcept -> bool
+  {
+    if (clean && ! Policy::status) return clean;
+    if constexpr (requires { callback.tell(diag{}); })
+      callback.tell({.level = clean ? diag::level::status : diag::level::error,
+                     .code = diag::code::die,
+                     .where = path.native()});
+    else
+      callback({(clean ? "s/self/die@" : "e/self/die/bad_fs@") + path.string(),
+                evw::destroy,
+                evk::watcher});
+    return clean;
+  };
+
+  auto const send = [&callback](ev::compact const& e) noexcept
+  {
+    if constexpr (std::is_invocable_v<Sink const&, ev::compact const&>)
+      callback(e);
+    else
+      callback(ev{e});
+  };
+
+  trace::walk_begin(path);
+  auto const walk_began = trace::on ? trace::now() : 0;
+
+  auto t = tree{};
+  try {
+    t = tree_of(path, stream, filter);
+  } catch (...) {
+    return die(false);
+  }
+
+  trace::walk_end(path,
+                  t.dir_states.size(),
+                  trace::on ? trace::now() - walk_began : 0);
+
+  if (counts)
+    counts->marks.store(t.dir_states.size(), std::memory_order_relaxed);
+
+  /* What happens, in proportion. */
+  evw const whats[] = {evw::create, evw::modify, evw::destroy, evw::rename};
+  std::uint64_t const weights[] = {stream.create,
+                                   stream.modify,
+                                   stream.destroy,
+                                   stream.rename};
+  auto const weight_sum = weights[0] + weights[1] + weights[2] + weights[3];
+
+  auto r = rng{stream.seed};
+  auto const file_count = t.paths.size();
+  auto const per_ms = stream.rate / 1000.0;
+  auto const chunk_len = stream.rate > 0 && per_ms < stream.chunk
+                         ? (per_ms < 1 ? std::size_t{1} : (std::size_t)per_ms)
+                         : stream.chunk;
+
+  auto const burst_len = stream.burst > 0 ? stream.burst : 1;
+
+  auto made = std::uint64_t{0};
+  auto in_burst = std::size_t{0};
+  /* When the next chunk is due, in seconds after we began. */
+  auto due = 0.0;
+  auto const began = steady::now();
+
+  while (is_living() && (stream.count == 0 || made < stream.count)) {
+    auto n = chunk_len;
+    if (stream.count > 0 && stream.count - made < n)
+      n = (std::size_t)(stream.count - made);
+    if (stream.shape == shape::bursts && burst_len - in_burst < n)
+      n = burst_len - in_burst;
+
+    if (due > 0) {
+      auto const at = began
+                    + std::chrono::duration_cast<steady::duration>(
+                      std::chrono::duration<double>(due));
+      if (at > steady::now()) std::this_thread::sleep_until(at);
+    }
+
+    auto const when = ev::now(clock);
+    auto const events_before =
+      counts ? counts->events.load(std::memory_order_relaxed) : 0;
+
+    for (std::size_t i = 0; i < n; ++i) {
+      auto const f = t.pick.empty() ? (std::size_t)r.below(file_count)
+                                    : t.pick[r.below(t.pick.size())];
+      auto what = whats[0];
+      if (weight_sum > 0) {
+        auto w = r.below(weight_sum);
+        for (std::size_t k = 0; k < 4; ++k) {
+          if (w < weights[k]) {
+            what = whats[k];
+            break;
+          }
+          w -= weights[k];
+        }
+      }
+      auto const& name = t.names[f];
+      auto const d = t.dir_of[f];
+      trace::decoded(what, evk::file, name.size());
+      if (! Policy::watches(what) || t.dir_pruned[d]) continue;
+      if (! filter.empty()
+          && ! filter.keeps(filter.walk(t.dir_states[d], name), evk::file))
+        continue;
+      send(ev::compact{t.paths[f], what, evk::file, when, clock});
+    }
+
+    made += n;
+    in_burst += n;
+
+    if (counts) {
+      ::wtr::watcher::metrics::add(counts->reads);
+      counts->read_events.record(
+        counts->events.load(std::memory_order_relaxed) - events_before);
+    }
+
+    if (stream.rate > 0) {
+      if (stream.shape == shape::poisson)
+        for (std::size_t i = 0; i < n; ++i)
+          due -= std::log(r.unit()) / stream.rate;
+      else
+        due += (double)n / stream.rate;
+    }
+    /* The pause is from the end of the burst, or from when
+       it should have ended, whichever is later. */
+    if (stream.shape == shape::bursts && in_burst >= burst_len) {
+      auto const now =
+        std::chrono::duration<double>(steady::now() - began).count();
+      in_burst = 0;
+      due = (due > now ? due : now) + stream.pause_ms / 1000.0;
+    }
+  }
+
+  return die(true);
+}
+
+} /* namespace synthetic */
+} /* namespace adapter */
+} /* namespace watcher */
+} /* namespace wtr */
+} /* namespace detail */
+
+/*  path */
 #include <filesystem>
 /*  function */
 #include <functional>
+/*  async
+    future */
+#include <future>
+/*  atomic */
+#include <atomic>
+/*  milliseconds */
+#include <chrono>
+/*  exchange */
+#include <utility>
+/*  find */
+#include <algorithm>
+/*  sleep_for */
+#include <thread>
+/*  shared_ptr
+    unique_ptr */
+#include <memory>
+/*  mutex
+    scoped_lock */
+#include <mutex>
 /*  optional */
 #include <optional>
-/*  error_code */
-#include <system_error>
 /*  unordered_map */
 #include <unordered_map>
-/*  unordered_set */
-#include <unordered_set>
-/*  tuple
-    make_tuple */
-#include <tuple>
-/*  event
-    callback */
+/*  vector */
+#include <vector>
+/*  uint32_t */
+#include <cstdint>
+/*  is_invocable_v */
+#include <type_traits>
+/*  watch
+    event
+    callback
+    filter
+    synthetic */
 
 namespace detail {
 namespace wtr {
 namespace watcher {
 namespace adapter {
-namespace fanotify {
 
-/*  @brief wtr/watcher/<d>/adapter/linux/fanotify/<a>/constants
-    - delay
-      The delay, in milliseconds, while `epoll_wait` will
-      'sleep' for until we are woken up. We usually check
-      if we're still alive at that point.
-
-    - event_wait_queue_max
-      Number of events allowed to be given to recv
-      (returned by `epoll_wait`). Any number between 1
-      and some large number should be fine. We don't
-      lose events if we 'miss' them, the events are
-      still waiting in the next call to `epoll_wait`.
-
-    - event_buf_len:
-      For our event buffer, 4096 is a typical page size
-      and sufficiently large to hold a great many events.
-      That's a good thumb-rule, and it might be the best
-      value to use because there will be a possibly long
-      character string (for the filename) in the event.
-      We can infer some things about the size we need for
-      the event buffer, but it's unlikely to be meaningful
-      because of the variably sized character string being
-      reported. We could use something like:
-          event_buf_len
-            = ((event_wait_queue_max + PATH_MAX)
-            * (3 * sizeof(fanotify_event_metadata)));
-      But that's a lot of flourish for 72 bytes that won't
-      be meaningful.
+/*  @brief wtr/watcher/<d>/adapter/future
+    A watcher's work, whether it should stop, what it has
+    counted so far, the roots it watches (by their place,
+    which is empty once removed) and how they have changed
+    since the watcher last looked. */
+struct future {
+  using shared = std::shared_ptr<future>;
 
-    - fan_init_flags:
-      Post-event reporting, non-blocking IO and unlimited
-      marks. We need sudo mode for the unlimited marks.
-      If we were making a filesystem auditor, we might use:
-          FAN_CLASS_PRE_CONTENT
-          | FAN_UNLIMITED_QUEUE
-          | FAN_UNLIMITED_MARKS
+  mutable std::mutex lk{};
+  std::future<bool> work{};
+  bool closed{false};
+  ::wtr::watcher::metrics counts{};
+  std::vector<std::filesystem::path> roots{};
+  changes_type changes{};
+};
 
-    - fan_init_opt_flags:
-      Read-only, non-blocking, and close-on-exec. */
-inline constexpr auto delay_ms = 16;
-inline constexpr auto event_wait_queue_max = 1;
-inline constexpr auto event_buf_len = PATH_MAX;
-inline constexpr auto fan_init_flags = FAN_CLASS_NOTIF | FAN_REPORT_DFID_NAME
-                                     | FAN_UNLIMITED_QUEUE
-                                     | FAN_UNLIMITED_MARKS;
-inline constexpr auto fan_init_opt_flags = O_RDONLY | O_NONBLOCK | O_CLOEXEC;
+/*  @brief wtr/watcher/<d>/adapter/to_sink
+    What the adapter for this platform sends to: compact
+    events (or whole batches) on Linux, where the adapters
+    have the paths in their own buffers, and events
+    elsewhere. Whichever the user's callback takes is made
+    from that.
+
+    A `std::function` is kept as one. Anything else keeps
+    its own type on Linux, so that the adapters can call
+    it (and the compiler can inline it) without going
+    through a `std::function` for every event. */
+#if defined(WATER_WATCHER_ADAPTER_LINUX_FANOTIFY) \
+  || defined(WATER_WATCHER_ADAPTER_LINUX_INOTIFY)
 
-/* @brief wtr/watcher/<d>/adapter/linux/fanotify/<a>/types
-   - mark_set_type
-       A set of file descriptors for fanotify resources.
-   - system_resources
-       An object holding:
-         - An fanotify file descriptor
-         - An epoll file descriptor
-         - An epoll configuration
-         - A set of watch marks (as returned by fanotify_mark)
-         - A map of (sub)path handles to filesystem paths (names)
-         - A boolean: whether or not the resources are valid */
-using mark_set_type = std::unordered_set<int>;
+using sink_type = sink<>;
 
-struct system_resources {
-  bool valid;
-  int watch_fd;
-  int event_fd;
-  epoll_event event_conf;
-  mark_set_type mark_set;
-};
+inline auto to_sink(::wtr::watcher::event::callback const& callback) noexcept
+  -> sink_type
+{
+  return {[callback](::wtr::watcher::event::compact const& ev) noexcept
+          { callback(::wtr::watcher::event{ev}); }};
+}
 
-inline auto mark(std::filesystem::path const& full_path,
-                 int watch_fd,
-                 mark_set_type& ms) noexcept -> bool
+inline auto
+to_sink(::wtr::watcher::event::compact::callback const& callback) noexcept
+  -> sink_type
 {
-  int wd = fanotify_mark(watch_fd,
-                         FAN_MARK_ADD,
-                         FAN_ONDIR | FAN_CREATE | FAN_MODIFY | FAN_DELETE
-                           | FAN_MOVE | FAN_DELETE_SELF | FAN_MOVE_SELF,
-                         AT_FDCWD,
-                         full_path.c_str());
-  if (wd >= 0) {
-    ms.insert(wd);
-    return true;
-  }
-  else
-    return false;
-};
+  return {callback};
+}
 
-inline auto mark(std::filesystem::path const& full_path,
-                 system_resources& sr) noexcept -> bool
+inline auto to_sink(::wtr::watcher::batch::callback const& callback) noexcept
+  -> sink_type
 {
-  return mark(full_path, sr.watch_fd, sr.mark_set);
-};
+  return {[callback](::wtr::watcher::event::compact const& ev) noexcept
+          {
+            auto const owned = ::wtr::watcher::event{ev};
+            callback(::wtr::watcher::batch{owned});
+          },
+          callback};
+}
 
-inline auto unmark(std::filesystem::path const& full_path,
-                   int watch_fd,
-                   mark_set_type& mark_set) noexcept -> bool
+template<class Callback>
+requires(std::is_invocable_v<Callback const&, ::wtr::watcher::event const&>)
+inline auto to_sink(Callback const& callback) noexcept
 {
-  int wd = fanotify_mark(watch_fd,
-                         FAN_MARK_REMOVE,
-                         FAN_ONDIR | FAN_CREATE | FAN_MODIFY | FAN_DELETE
-                           | FAN_MOVE | FAN_DELETE_SELF | FAN_MOVE_SELF,
-                         AT_FDCWD,
-                         full_path.c_str());
-  auto const& at = mark_set.find(wd);
+  auto each = [callback](::wtr::watcher::event::compact const& ev) noexcept
+  { callback(::wtr::watcher::event{ev}); };
+  return sink<decltype(each)>{each};
+}
 
-  if (wd >= 0 && at != mark_set.end()) {
-    mark_set.erase(at);
-    return true;
-  }
-  else
-    return false;
-};
+template<class Callback>
+requires(
+  std::is_invocable_v<Callback const&, ::wtr::watcher::event::compact const&>
+  and not std::is_invocable_v<Callback const&, ::wtr::watcher::event const&>)
+inline auto to_sink(Callback const& callback) noexcept -> sink<Callback>
+{
+  return {callback};
+}
 
-inline auto unmark(std::filesystem::path const& full_path,
-                   system_resources& sr) noexcept -> bool
+template<class Callback>
+requires(std::is_invocable_v<Callback const&, ::wtr::watcher::batch const&>
+         and not std::is_invocable_v<Callback const&,
+                                     ::wtr::watcher::event const&>)
+inline auto to_sink(Callback const& callback) noexcept -> sink_type
 {
-  return unmark(full_path, sr.watch_fd, sr.mark_set);
-};
+  return to_sink(::wtr::watcher::batch::callback{callback});
+}
 
-/* @brief wtr/watcher/<d>/adapter/linux/fanotify/<a>/fns/open_system_resources
-   Produces a `system_resources` with the file descriptors from
-   `fanotify_init` and `epoll_create`. Invokes `callback` on errors. */
-inline auto
-open_system_resources(std::filesystem::path const& path,
-                      ::wtr::watcher::event::callback const& callback) noexcept
-  -> system_resources
+#else
+
+using sink_type = ::wtr::watcher::event::callback;
+
+inline auto to_sink(::wtr::watcher::event::callback const& callback) noexcept
+  -> sink_type
 {
-  namespace fs = ::std::filesystem;
-  using ev = ::wtr::watcher::event;
+  return callback;
+}
 
-  auto do_error = [&path,
-                   &callback](char const* const msg,
-                              int watch_fd,
-                              int event_fd = -1) noexcept -> system_resources
-  {
-    callback(
-      {std::string{msg} + "(" + std::strerror(errno) + ")@" + path.string(),
-       ev::what::other,
-       ev::kind::watcher});
+inline auto
+to_sink(::wtr::watcher::event::compact::callback const& callback) noexcept
+  -> sink_type
+{
+  return [callback](::wtr::watcher::event const& ev) noexcept
+  { callback(::wtr::watcher::event::compact{ev}); };
+}
 
-    return system_resources{
-      .valid = false,
-      .watch_fd = watch_fd,
-      .event_fd = event_fd,
-      .event_conf = {.events = 0, .data = {.fd = watch_fd}},
-      .mark_set = {},
-    };
-  };
+inline auto to_sink(::wtr::watcher::batch::callback const& callback) noexcept
+  -> sink_type
+{
+  return [callback](::wtr::watcher::event const& ev) noexcept
+  { callback(::wtr::watcher::batch{ev}); };
+}
 
-  auto do_path_map_container_create =
-    [](int const watch_fd,
-       fs::path const& base_path,
-       ::wtr::watcher::event::callback const& callback) -> mark_set_type
-  {
-    using diter = fs::recursive_directory_iterator;
+template<class Callback>
+requires(std::is_invocable_v<Callback const&, ::wtr::watcher::event const&>)
+inline auto to_sink(Callback const& callback) noexcept -> sink_type
+{
+  return callback;
+}
 
-    /* Follow symlinks, ignore paths which we don't have permissions for. */
-    static constexpr auto dopt =
-      fs::directory_options::skip_permission_denied
-      & fs::directory_options::follow_directory_symlink;
+template<class Callback>
+requires(
+  std::is_invocable_v<Callback const&, ::wtr::watcher::event::compact const&>
+  and not std::is_invocable_v<Callback const&, ::wtr::watcher::event const&>)
+inline auto to_sink(Callback const& callback) noexcept -> sink_type
+{
+  return to_sink(::wtr::watcher::event::compact::callback{callback});
+}
 
-    static constexpr auto rsrv_count = 1024;
+template<class Callback>
+requires(std::is_invocable_v<Callback const&, ::wtr::watcher::batch const&>
+         and not std::is_invocable_v<Callback const&,
+                                     ::wtr::watcher::event const&>)
+inline auto to_sink(Callback const& callback) noexcept -> sink_type
+{
+  return to_sink(::wtr::watcher::batch::callback{callback});
+}
 
-    auto pmc = mark_set_type{};
-    pmc.reserve(rsrv_count);
+#endif
 
-    try {
-      if (mark(base_path, watch_fd, pmc))
-        if (fs::is_directory(base_path))
-          for (auto& dir : diter(base_path, dopt))
-            if (fs::is_directory(dir))
-              if (! mark(dir.path(), watch_fd, pmc))
-                callback({"w/sys/not_watched@" + base_path.string() + "@"
-                            + dir.path().string(),
-                          ev::what::other,
-                          ev::kind::watcher});
-    } catch (...) {}
-
-    return pmc;
-  };
+/*  @brief wtr/watcher/<d>/adapter/diags_of
+    The diagnostic callback which came with the user's
+    callback, if one did. See `with_diags`. */
+template<class Callback>
+inline auto diags_of(Callback const& callback) noexcept
+  -> ::wtr::watcher::diag::callback
+{
+  if constexpr (requires { callback.diags; })
+    return callback.diags;
+  else
+    return {};
+}
 
-  int watch_fd = fanotify_init(fan_init_flags, fan_init_opt_flags);
-  if (watch_fd >= 0) {
-    auto pmc = do_path_map_container_create(watch_fd, path, callback);
-    if (! pmc.empty()) {
-      epoll_event event_conf{.events = EPOLLIN, .data{.fd = watch_fd}};
+/*  @brief wtr/watcher/<d>/adapter/synthetic_of
+    The stream a watcher makes up when every watcher is
+    synthetic: its policy's `synthetic`, if it has one. */
+template<class Policy>
+inline auto synthetic_of() noexcept -> ::wtr::watcher::synthetic
+{
+  if constexpr (requires { Policy::synthetic; })
+    return Policy::synthetic;
+  else
+    return {};
+}
 
-      int event_fd = epoll_create1(EPOLL_CLOEXEC);
+/*  @brief wtr/watcher/<d>/adapter/open
+    Starts a watcher on `roots` and gives back a way to
+    close it. On Linux, what is read from the kernel is
+    stamped from `clock`. Elsewhere, events are stamped
+    by the system clock as they are made, and say so.
+
+    Each event says which of `roots` it happened beneath.
+    On Linux, they are all watched with one kernel instance
+    (and one thread). Elsewhere, each is watched on its own
+    thread, and its events are stamped with its place among
+    them, while another thread looks for new roots. They
+    take turns with the callback: it is only ever called
+    from one of them at a time.
+
+    Roots can be added and removed while the watcher runs.
+    See `add` and `remove`.
+
+    The Linux adapters and `warthog` are compiled for
+    `Policy`. The others don't know about it, so only
+    our first message (that we are alive) follows it.
+
+    The Linux adapters `tell` a diagnostic callback what
+    they have to say, without putting messages together.
+    Elsewhere, the messages are read back for it.
+
+    What the watcher does is counted in the future. The
+    Linux adapters and `warthog` count what they read, and
+    every adapter counts what it sends.
+
+    Every adapter traces what it sends. The Linux adapters
+    and `warthog` trace the rest. See `trace`.
+
+    Given a `stream`, the watcher makes its events up,
+    with the synthetic adapter, beneath the first of
+    `roots`, instead of watching them. With
+    `WATER_WATCHER_USE_SYNTHETIC` defined, they all do.
+    See `synthetic`. */
+template<class Policy = ::wtr::watcher::policy, class Callback>
+inline auto open(std::vector<std::filesystem::path> const& roots,
+                 ::wtr::watcher::filter const& filter,
+                 Callback const& user_callback,
+                 enum ::wtr::watcher::event::clock clock = Policy::clock,
+                 std::optional<::wtr::watcher::synthetic> stream = {}) noexcept
+  -> future::shared
+{
+#if defined(WATER_WATCHER_USE_SYNTHETIC)
+  if (! stream) stream = synthetic_of<Policy>();
+#endif
 
-      /* @note We could make the epoll and fanotify file descriptors
-         non-blocking with `fcntl`. It's not clear if we can do this
-         from their `*_init` calls. */
-      /* fcntl(watch_fd, F_SETFL, O_NONBLOCK); */
-      /* fcntl(event_fd, F_SETFL, O_NONBLOCK); */
+  auto fut = std::make_shared<future>();
+  fut->roots = roots;
 
-      if (event_fd >= 0)
-        if (epoll_ctl(event_fd, EPOLL_CTL_ADD, watch_fd, &event_conf) >= 0)
-          return system_resources{
-            .valid = true,
-            .watch_fd = watch_fd,
-            .event_fd = event_fd,
-            .event_conf = event_conf,
-            .mark_set = std::move(pmc),
-          };
-        else
-          return do_error("e/sys/epoll_ctl", watch_fd, event_fd);
+#if defined(WATER_WATCHER_ADAPTER_LINUX_FANOTIFY) \
+  || defined(WATER_WATCHER_ADAPTER_LINUX_INOTIFY)
+  auto const made = to_sink(user_callback);
+  auto const callback = sink<decltype(made.each), Policy>{made.each,
+                                                          made.batches,
+                                                          clock,
+                                                          diags_of(user_callback),
+                                                          &fut->counts};
+#else
+  using ev = ::wtr::watcher::event;
+  auto const callback = sink_type{
+    [made = to_sink(user_callback),
+     diags = diags_of(user_callback),
+     counts = &fut->counts](ev const& e) noexcept
+    {
+      using trace = typename Policy::trace;
+      if (e.kind != ev::kind::watcher) {
+        if constexpr (trace::on) trace::send_begin(e.what, e.kind);
+        auto const began = trace::on ? trace::now() : 0;
+        counts->sent([&]() noexcept { made(e); });
+        if constexpr (trace::on) trace::send_end(trace::now() - began);
+      }
+      else if (diags)
+        diags(::wtr::watcher::diag::of(e));
       else
-        return do_error("e/sys/epoll_create", watch_fd, event_fd);
-    }
-    else
-      return do_error("e/sys/fanotify_mark", watch_fd);
-  }
-  else
-    return do_error("e/sys/fanotify_init", watch_fd);
+        made(e);
+    }};
+#endif
+
+  if constexpr (Policy::status)
+    for (auto const& path : roots)
+#if defined(WATER_WATCHER_ADAPTER_LINUX_FANOTIFY) \
+  || defined(WATER_WATCHER_ADAPTER_LINUX_INOTIFY)
+      callback.tell({.level = ::wtr::watcher::diag::level::status,
+                     .code = ::wtr::watcher::diag::code::live,
+                     .where = path.native()});
+#else
+      callback({"s/self/live@" + path.string(),
+                ::wtr::watcher::event::what::create,
+                ::wtr::watcher::event::kind::watcher});
+#endif
+
+  fut->work = std::async(
+    std::launch::async,
+    [roots, filter, callback, fut, clock, stream]() noexcept -> bool
+    {
+      auto is_living = [fut]() noexcept -> bool
+      {
+        auto _ = std::scoped_lock{fut->lk};
+        return ! fut->closed;
+      };
+      auto changes = [fut]() noexcept -> changes_type
+      {
+        auto _ = std::scoped_lock{fut->lk};
+        return std::exchange(fut->changes, {});
+      };
+      if (stream)
+        return synthetic::watch<Policy>(
+          roots.empty() ? std::filesystem::path{} : roots.front(),
+          filter,
+          *stream,
+          callback,
+          is_living,
+          clock,
+          &fut->counts);
+#if defined(WATER_WATCHER_ADAPTER_LINUX_FANOTIFY) \
+  || defined(WATER_WATCHER_ADAPTER_LINUX_INOTIFY)
+      return watch(roots, filter, callback, is_living, changes);
+#else
+      /* Held while any root's thread calls the callback. */
+      auto sending = std::mutex{};
+      /* Watches `path`, the `n`th root, until it is removed
+         (or we die), and says so in its events. */
+      auto const each = [&](std::uint32_t n,
+                            std::filesystem::path const& path,
+                            std::shared_ptr<std::atomic<bool>> const& kept)
+        noexcept -> bool
+      {
+        auto const living = [&]() noexcept { return *kept && is_living(); };
+        auto const stamped = sink_type{
+          [&callback, &sending, n](ev const& e)
+          {
+            auto _ = std::scoped_lock{sending};
+            if (n == 0)
+              callback(e);
+            else
+              callback({e.where, e.what, e.kind, e.when, e.clock, n});
+          }};
+#if defined(WATER_WATCHER_ADAPTER_WARTHOG)
+        return watch<Policy>(path, filter, stamped, living, &fut->counts);
+#else
+        return watch(path, filter, stamped, living);
+#endif
+      };
+      struct watching {
+        std::shared_ptr<std::atomic<bool>> kept;
+        std::future<bool> work;
+      };
+      auto all = std::vector<watching>{};
+      auto const start = [&](std::uint32_t n, std::filesystem::path const& p)
+      {
+        if (all.size() <= n) all.resize(n + 1);
+        auto kept = std::make_shared<std::atomic<bool>>(true);
+        all[n] = {kept, std::async(std::launch::async, each, n, p, kept)};
+      };
+      for (auto n = std::uint32_t{0}; n < roots.size(); ++n)
+        start(n, roots[n]);
+      /* Roots come and go while we live. */
+      while (is_living()) {
+        for (auto const& c : changes())
+          if (c.what == change::what::add)
+            start(c.root, c.path);
+          else if (c.root < all.size() && all[c.root].kept)
+            *all[c.root].kept = false;
+        std::this_thread::sleep_for(
+          std::chrono::milliseconds(std::max(Policy::delay_ms, 1)));
+      }
+      auto ok = true;
+      for (auto& one : all)
+        if (one.work.valid()) ok = one.work.get() && ok;
+      return ok;
+#endif
+    });
+
+  return fut;
 };
 
-/* @brief wtr/watcher/<d>/adapter/linux/fanotify/<a>/fns/close_system_resources
-   Close the file descriptors `watch_fd` and `event_fd`. */
-inline auto close_system_resources(system_resources&& sr) noexcept -> bool
+/*  @brief wtr/watcher/<d>/adapter/open
+    The same, for one path. */
+template<class Policy = ::wtr::watcher::policy, class Callback>
+inline auto open(std::filesystem::path const& path,
+                 ::wtr::watcher::filter const& filter,
+                 Callback const& user_callback,
+                 enum ::wtr::watcher::event::clock clock = Policy::clock,
+                 std::optional<::wtr::watcher::synthetic> stream = {}) noexcept
+  -> future::shared
 {
-  return close(sr.watch_fd) == 0 && close(sr.event_fd) == 0;
+  return open<Policy>(std::vector<std::filesystem::path>{path},
+                      filter,
+                      user_callback,
+                      clock,
+                      stream);
 };
 
-/*  @brief wtr/watcher/<d>/adapter/linux/fanotify/<a>/fns/promote
-    Promotes an event's metadata to a full path.
+/*  @brief wtr/watcher/<d>/adapter/add
+    Asks a running watcher to watch `path` as well, and
+    gives back its place among the watcher's roots, which
+    its events will say. Nothing, if the watcher was told
+    to stop. The watcher marks it on its own thread, the
+    next time it looks, which is after its next read or
+    within `Policy::delay_ms`. */
+inline auto add(future::shared const& fut,
+                std::filesystem::path const& path) noexcept
+  -> std::optional<std::uint32_t>
+{
+  auto _ = std::scoped_lock{fut->lk};
+  if (fut->closed) return std::nullopt;
+  auto const root = (std::uint32_t)fut->roots.size();
+  fut->roots.push_back(path);
+  fut->changes.push_back({change::what::add, root, path});
+  return root;
+};
+
+/*  @brief wtr/watcher/<d>/adapter/remove
+    Asks a running watcher to stop watching `path`, which
+    was one of its roots. Events for the other roots keep
+    coming as they were. Returns false if `path` isn't one
+    of its roots, or if the watcher was told to stop. */
+inline auto remove(future::shared const& fut,
+                   std::filesystem::path const& path) noexcept -> bool
+{
+  auto _ = std::scoped_lock{fut->lk};
+  if (fut->closed || path.empty()) return false;
+  auto const at = std::find(fut->roots.begin(), fut->roots.end(), path);
+  if (at == fut->roots.end()) return false;
+  at->clear();
+  fut->changes.push_back(
+    {change::what::remove, (std::uint32_t)(at - fut->roots.begin()), path});
+  return true;
+};
+
+/*  @brief wtr/watcher/<d>/adapter/stop
+    Tells a watcher to stop, without waiting for it to.
+    Returns false if it was already told. */
+inline auto stop(future::shared const& fut) noexcept -> bool
+{
+  auto _ = std::scoped_lock{fut->lk};
+  if (fut->closed) return false;
+  fut->closed = true;
+  return true;
+};
+
+/*  @brief wtr/watcher/<d>/adapter/join
+    Waits for a watcher which was told to stop to do so.
+    Returns whether it did so cleanly, or false if it was
+    already waited for. Only whoever stopped it (whose
+    `stop` said true) waits for it: its future can't be
+    waited on from two threads at once. */
+inline auto join(future::shared const& fut) noexcept -> bool
+{
+  return fut->work.valid() ? fut->work.get() : false;
+};
+
+inline auto close(future::shared const& fut) noexcept -> bool
+{
+  return stop(fut) ? join(fut) : false;
+};
+
+}  // namespace adapter
+}  // namespace watcher
+}  // namespace wtr
+}  // namespace detail
+
+/*  path */
+#include <filesystem>
+/*  function */
+#include <functional>
+/*  shared_ptr */
+#include <memory>
+/*  optional */
+#include <optional>
+/*  uint32_t */
+#include <cstdint>
+/*  move */
+#include <utility>
+/*  vector */
+#include <vector>
+/*  is_*,
+    invoke_result */
+#include <type_traits>
+/*  event
+    callback
+    filter
+    synthetic
+    adapter */
 
-    The shenanigans we do here depend on this event being
-    `FAN_EVENT_INFO_TYPE_DFID_NAME`. The kernel passes us
-    some info about the directory and the directory entry
-    (the filename) of this event that doesn't exist when
-    other event types are reported. In particular, we need
-    a file descriptor to the directory (which we use
-    `readlink` on) and a character string representing the
-    name of the directory entry.
-    TLDR: We need information for the full path of the event,
-    information which is only reported inside this `if`.
+namespace wtr {
+inline namespace watcher {
 
-    From the kernel:
-      Variable size struct for
-      dir file handle + child file handle + name
+/*  Contains a way to stop an instance of `watch()`.
+    This is the structure that we return from there.
+    It is intended to allow the `watch(args).close()`
+    syntax as well as an anonymous `watch(args)()`.
+    We define it up here so that editors can suggest
+    and complete the `.close()` function. Also because
+    we can't template a type inside a function.
 
-      [ Omitting definition of `fanotify_info` here ]
+    This thing is similar to an unnamed function object
+    containing a named method.
 
-      (struct fanotify_fh) dir_fh starts at
-      buf[0]
+    It also has a way to see what the watcher has done so
+    far, with `.metrics()`. See `metrics`.
 
-      (optional) dir2_fh starts at
-      buf[dir_fh_totlen]
+    It keeps the watcher's `adapter`, so that a `group` can
+    stop it along with others. See `group`.
 
-      (optional) file_fh starts at
-      buf[dir_fh_totlen + dir2_fh_totlen]
+    Roots can be added to, and removed from, the watcher
+    while it runs, with `.add_path()` and `.remove_path()`.
+    Adding gives back the new root's place among the roots,
+    which its events say in `root`. Nothing else is watched
+    again, or stops being watched, when they change. */
 
-      name starts at
-      buf[dir_fh_totlen + dir2_fh_totlen + file_fh_totlen]
-      ...
+template<class Fn>
+requires(std::is_nothrow_invocable_v<Fn>
+         and std::is_same_v<std::invoke_result_t<Fn>, bool>)
+struct _ {
+  Fn const close{};
 
-    The kernel guarentees that there is a null-terminated
-    character string to the event's directory entry
-    after the file handle to the directory.
-    Confusing, right? */
-// clang-format off
-// note at the end of file re. clang format
-inline auto promote(fanotify_event_metadata const* mtd) noexcept
-  -> std::tuple<bool,
-                std::filesystem::path,
-                enum ::wtr::watcher::event::what,
-                enum ::wtr::watcher::event::kind>
-{
-  namespace fs = ::std::filesystem;
-  using ev = ::wtr::watcher::event;
+  std::shared_ptr<::wtr::watcher::metrics const> const counts{};
 
-  auto path_imbue = [](char* path_accum,
-                       fanotify_event_info_fid const* dfid_info,
-                       file_handle* dir_fh,
-                       ssize_t dir_name_len = 0) noexcept -> void
-  {
-    char* name_info = (char*)(dfid_info + 1);
-    char* file_name = static_cast<char*>(
-      name_info + sizeof(file_handle) + sizeof(dir_fh->f_handle)
-      + sizeof(dir_fh->handle_bytes) + sizeof(dir_fh->handle_type));
+  ::detail::wtr::watcher::adapter::future::shared const adapter{};
 
-    if (file_name && std::strcmp(file_name, ".") != 0)
-      std::snprintf(path_accum + dir_name_len,
-                    PATH_MAX - dir_name_len,
-                    "/%s",
-                    file_name);
+  inline constexpr auto operator()() const noexcept -> bool
+  {
+    return this->close();
   };
 
-  auto dir_fid_info = ((fanotify_event_info_fid const*)(mtd + 1));
+  inline auto metrics() const noexcept
+    -> ::wtr::watcher::metrics::snapshot_type
+  {
+    return this->counts ? this->counts->snapshot()
+                        : ::wtr::watcher::metrics::snapshot_type{};
+  };
 
-  auto dir_fh = (file_handle*)(dir_fid_info->handle);
+  inline auto add_path(std::filesystem::path const& path) const noexcept
+    -> std::optional<std::uint32_t>
+  {
+    return this->adapter ? ::detail::wtr::watcher::adapter::add(this->adapter,
+                                                                 path)
+                         : std::nullopt;
+  };
 
-  auto what = mtd->mask & FAN_CREATE ? ev::what::create
-            : mtd->mask & FAN_DELETE ? ev::what::destroy
-            : mtd->mask & FAN_MODIFY ? ev::what::modify
-            : mtd->mask & FAN_MOVE   ? ev::what::rename
-                                     : ev::what::other;
+  inline auto remove_path(std::filesystem::path const& path) const noexcept
+    -> bool
+  {
+    return this->adapter
+        && ::detail::wtr::watcher::adapter::remove(this->adapter, path);
+  };
 
-  auto kind = mtd->mask & FAN_ONDIR ? ev::kind::dir : ev::kind::file;
+  inline constexpr _(
+    Fn&& fn,
+    std::shared_ptr<::wtr::watcher::metrics const> counts = {},
+    ::detail::wtr::watcher::adapter::future::shared adapter = {}) noexcept
+      : close{std::forward<Fn>(fn)}
+      , counts{std::move(counts)}
+      , adapter{std::move(adapter)} {};
 
-  /* We can get a path name, so get that and use it */
-  char path_buf[PATH_MAX];
-  int fd = open_by_handle_at(AT_FDCWD,
-                             dir_fh,
-                             O_RDONLY | O_CLOEXEC | O_PATH | O_NONBLOCK);
-  if (fd > 0) {
-    char fs_proc_path[128];
-    std::snprintf(fs_proc_path, sizeof(fs_proc_path), "/proc/self/fd/%d", fd);
-    ssize_t dirname_len =
-      readlink(fs_proc_path, path_buf, sizeof(path_buf) - sizeof('\0'));
-    close(fd);
+  inline constexpr ~_() = default;
+};
 
-    if (dirname_len > 0) {
-      /* Put the directory name in the path accumulator.
-         Passing `dirname_len` has the effect of putting
-         the event's filename in the path buffer as well. */
-      path_buf[dirname_len] = '\0';
-      path_imbue(path_buf, dir_fid_info, dir_fh, dirname_len);
+/*  How every `watch()` makes its `_`. There is one of these,
+    so every watcher has the same type, whichever callback
+    (or filter) it was given. */
+inline auto
+_from(::detail::wtr::watcher::adapter::future::shared adapter) noexcept
+{
+  return _{[adapter]() noexcept -> bool
+           { return ::detail::wtr::watcher::adapter::close(adapter); },
+           std::shared_ptr<::wtr::watcher::metrics const>{adapter,
+                                                          &adapter->counts},
+           adapter};
+}
 
-      return std::make_tuple(true,
-                             fs::path{std::move(path_buf)},
-                             what,
-                             kind);
-    }
+/*  @brief wtr/watcher/watch
 
-    else
-      return std::make_tuple(false, fs::path{}, what, kind);
-  }
-  else {
-    path_imbue(path_buf, dir_fid_info, dir_fh);
+    Returns an asyncronous filesystem watcher as a function
+    object. Calling the function object with `()` or `.close()`
+    will stop the watcher.
 
-    return std::make_tuple(true,
-                           fs::path{std::move(path_buf)},
-                           what,
-                           kind);
-  }
-};
+    Closing the watcher is the only blocking operation.
 
-// clang-format on
+    @param path:
+      The root path to watch for filesystem events.
 
-inline auto
-check_and_update(std::tuple<bool,
-                            std::filesystem::path,
-                            enum ::wtr::watcher::event::what,
-                            enum ::wtr::watcher::event::kind> const& r,
-                 system_resources& sr) noexcept
-  -> std::tuple<bool,
-                std::filesystem::path,
-                enum ::wtr::watcher::event::what,
-                enum ::wtr::watcher::event::kind> {
-    using ev = ::wtr::watcher::event;
+    @param living_cb (optional):
+      Something (such as a closure) to be called when events
+      occur in the path being watched.
 
-    auto [valid, path, what, kind] = r;
+    @param clock (optional):
+      Where the time of each event comes from. The system
+      clock, by default. See `event::clock`.
 
-    return std::make_tuple(
+    @param Policy (optional):
+      What the watcher is told when it is compiled, such
+      as the size of its buffers and which changes it
+      sends. Given as `watch<Policy>(path, callback)`. See
+      `policy`.
 
-      valid
+    This is an adaptor "switch" that chooses the ideal adaptor
+    for the host platform.
 
-        ? kind == ev::kind::dir
+    Every adapter monitors `path` for changes and invokes the
+    `callback` with an `event` object when they occur.
 
-          ? what == ev::what::create  ? mark(path, sr)
-          : what == ev::what::destroy ? unmark(path, sr)
-                                 : true
+    There are two things the user needs:
+      - The `watch` function
+      - The `event` object
 
-          : true
+    The watch function returns a function to stop its watcher.
 
-        : false,
+    Typical use looks like this:
 
-      path,
+    auto w = watch(".", [](event const& e) {
+      std::cout
+        << "where: " << e.where << "\n"
+        << "kind: "  << e.kind  << "\n"
+        << "what: "  << e.what  << "\n"
+        << "when: "  << e.when  << "\n"
+        << std::endl;
+    };
+    auto dead = w.close(); // w() also works
 
-      what,
+    That's it.
 
-      kind);
-  };
+    Happy hacking. */
 
-/*  @brief wtr/watcher/<d>/adapter/linux/fanotify/<a>/fns/send
-    Send events to the user.
+template<class Policy = policy>
+[[nodiscard("Returns a way to stop this watcher, for example: "
+            "auto w = watch(p, cb) ; w.close() // or w();")]]
 
-    This is the important part.
-    Most of the other code is
-    a layer of translation
-    between us and the kernel. */
 inline auto
-send(std::tuple<bool,
-                std::filesystem::path,
-                enum ::wtr::watcher::event::what,
-                enum ::wtr::watcher::event::kind> const& from_kernel,
-     ::wtr::watcher::event::callback const& callback) noexcept -> bool
+watch(std::filesystem::path const& path,
+      event::callback const& callback,
+      enum event::clock clock = Policy::clock) noexcept
 {
-  auto [ok, path, what, kind] = from_kernel;
+  using namespace ::detail::wtr::watcher::adapter;
 
-  return ok ? (callback({path, what, kind}), ok) : ok;
+  return _from(open<Policy>(path, filter{}, callback, clock));
 };
 
-/* @brief wtr/watcher/<d>/adapter/linux/fanotify/<a>/fns/recv
-   Reads through available (fanotify) filesystem events.
-   Discerns their path and type.
-   Calls the callback.
-   Returns false on eventful errors.
-   @note
-   The `metadata->fd` field contains either a file
-   descriptor or the value `FAN_NOFD`. File descriptors
-   are always greater than 0. `FAN_NOFD` represents an
-   event queue overflow for `fanotify` listeners which
-   are _not_ monitoring file handles, such as mount
-   monitors. The file handle is in the metadata when an
-   `fanotify` listener is monitoring events by their
-   file handles.
-   The `metadata->vers` field may differ between kernel
-   versions, so we check it against what we have been
-   compiled with. */
-inline auto recv(system_resources& sr,
-                 std::filesystem::path const& base_path,
-                 ::wtr::watcher::event::callback const& callback) noexcept
-  -> bool
-{
-  enum class state { ok, none, err };
+/*  @brief wtr/watcher/watch
+    Same as above, but only for the paths which `filter`
+    keeps. Paths are matched relative to `path`.
 
-  auto do_error = [&base_path,
-                   &callback](char const* const msg) noexcept -> bool
-  {
-    return (callback({std::string{msg} + "@" + base_path.string(),
-                      ::wtr::watcher::event::what::other,
-                      ::wtr::watcher::event::kind::watcher}),
-            false);
-  };
+    auto w = watch(".", filter{"*.cpp", "*.hpp"}, callback); */
 
-  /* Read some events. */
-  alignas(fanotify_event_metadata) char event_buf[event_buf_len];
-  auto event_read = read(sr.watch_fd, event_buf, sizeof(event_buf));
+template<class Policy = policy>
+[[nodiscard("Returns a way to stop this watcher, for example: "
+            "auto w = watch(p, f, cb) ; w.close() // or w();")]]
 
-  switch (event_read > 0    ? state::ok
-          : event_read == 0 ? state::none
-          : errno == EAGAIN ? state::none
-                            : state::err) {
-    case state::ok : {
-      /* Loop over everything in the event buffer. */
-      for (auto* mtd = (fanotify_event_metadata const*)event_buf;
-           FAN_EVENT_OK(mtd, event_read);
-           mtd = FAN_EVENT_NEXT(mtd, event_read))
-        if (mtd->fd == FAN_NOFD) [[likely]]
-          if (mtd->vers == FANOTIFY_METADATA_VERSION) [[likely]]
-            if (! (mtd->mask & FAN_Q_OVERFLOW)) [[likely]]
-              if (((fanotify_event_info_fid*)(mtd + 1))->hdr.info_type
-                  == FAN_EVENT_INFO_TYPE_DFID_NAME) [[likely]]
+inline auto
+watch(std::filesystem::path const& path,
+      filter const& filter,
+      event::callback const& callback,
+      enum event::clock clock = Policy::clock) noexcept
+{
+  using namespace ::detail::wtr::watcher::adapter;
 
-                /* Send the events we receive. */
-                return send(check_and_update(promote(mtd), sr), callback);
+  return _from(open<Policy>(path, filter, callback, clock));
+};
 
-              else
-                return ! do_error("w/self/event_info");
-            else
-              return do_error("e/sys/overflow");
-          else
-            return do_error("e/sys/kernel_version");
-        else
-          return do_error("e/sys/wrong_event_fd");
-    } break;
+/*  @brief wtr/watcher/watch
+    Same as above, for callbacks which aren't a
+    `std::function`, such as lambdas. The callback keeps
+    its own type all the way to the adapter, which calls
+    it directly, so a small one can be inlined into the
+    loop which reads events. (On Linux. Elsewhere, it is
+    kept in an `event::callback`.) Pass an `event::callback`
+    to use the overloads above instead. */
+
+template<class Policy = policy, class Callback>
+requires(std::is_invocable_v<Callback const&, event const&>
+         and not std::is_same_v<Callback, event::callback>)
+[[nodiscard("Returns a way to stop this watcher, for example: "
+            "auto w = watch(p, cb) ; w.close() // or w();")]]
 
-    case state::none : return true; break;
+inline auto
+watch(std::filesystem::path const& path,
+      Callback const& callback,
+      enum event::clock clock = Policy::clock) noexcept
+{
+  using namespace ::detail::wtr::watcher::adapter;
 
-    case state::err : return do_error("e/sys/read"); break;
-  }
+  return _from(open<Policy>(path, filter{}, callback, clock));
+};
 
-  /* Unreachable */
-  return false;
+template<class Policy = policy, class Callback>
+requires(std::is_invocable_v<Callback const&, event const&>
+         and not std::is_same_v<Callback, event::callback>)
+[[nodiscard("Returns a way to stop this watcher, for example: "
+            "auto w = watch(p, f, cb) ; w.close() // or w();")]]
+
+inline auto
+watch(std::filesystem::path const& path,
+      filter const& filter,
+      Callback const& callback,
+      enum event::clock clock = Policy::clock) noexcept
+{
+  using namespace ::detail::wtr::watcher::adapter;
+
+  return _from(open<Policy>(path, filter, callback, clock));
 };
 
-/*  @brief wtr/watcher/<d>/adapter/watch
-    Monitors `path` for changes.
-    Invokes `callback` with an `event` when they happen.
-    `watch` stops when asked to or irrecoverable errors occur.
-    All events, including errors, are passed to `callback`.
+/*  @brief wtr/watcher/watch
+    Same as above, but `callback` is given compact events,
+    which view their paths instead of owning them. Nothing
+    is allocated for them on Linux. Copy a path out (or make
+    an `event` from it) if it needs to outlive the callback.
+
+    auto w = watch(".", [](event::compact const& e) {
+      std::cout << e.where << "\n";
+    }); */
+
+template<class Policy = policy, class Callback>
+requires(std::is_invocable_v<Callback const&, event::compact const&>
+         and not std::is_invocable_v<Callback const&, event const&>)
+[[nodiscard("Returns a way to stop this watcher, for example: "
+            "auto w = watch(p, cb) ; w.close() // or w();")]]
 
-    @param path
-    A filesystem path to watch for events.
+inline auto
+watch(std::filesystem::path const& path,
+      Callback const& callback,
+      enum event::clock clock = Policy::clock) noexcept
+{
+  using namespace ::detail::wtr::watcher::adapter;
 
-    @param callback
-    A function to invoke with an `event` object
-    when the files being watched change.
+  return _from(open<Policy>(path, filter{}, callback, clock));
+};
 
-    @param is_living
-    A function to decide whether we're dead. */
-inline bool watch(std::filesystem::path const& path,
-                  ::wtr::watcher::event::callback const& callback,
-                  std::function<bool()> const& is_living) noexcept
+template<class Policy = policy, class Callback>
+requires(std::is_invocable_v<Callback const&, event::compact const&>
+         and not std::is_invocable_v<Callback const&, event const&>)
+[[nodiscard("Returns a way to stop this watcher, for example: "
+            "auto w = watch(p, f, cb) ; w.close() // or w();")]]
+
+inline auto
+watch(std::filesystem::path const& path,
+      filter const& filter,
+      Callback const& callback,
+      enum event::clock clock = Policy::clock) noexcept
 {
-  using ev = ::wtr::watcher::event;
+  using namespace ::detail::wtr::watcher::adapter;
 
-  auto done = [&path, &callback](system_resources&& sr) noexcept -> bool
-  {
-    return
+  return _from(open<Policy>(path, filter, callback, clock));
+};
 
-      close_system_resources(std::move(sr))
+/*  @brief wtr/watcher/watch
+    Same as above, but `callback` is given a view of each
+    read from the kernel, which is decoded as it is looked
+    at. See `batch`. There is no filter for batches: they
+    are what the kernel gave us.
+
+    auto w = watch(".", [](batch const& b) {
+      for (auto e : b) std::cout << e.name() << "\n";
+    }); */
+
+template<class Policy = policy, class Callback>
+requires(std::is_invocable_v<Callback, batch const&>
+         and not std::is_invocable_v<Callback, event const&>)
+[[nodiscard("Returns a way to stop this watcher, for example: "
+            "auto w = watch(p, cb) ; w.close() // or w();")]]
 
-        ? (callback({"s/self/die@" + path.string(), ev::what::other, ev::kind::watcher}),
-           true)
+inline auto
+watch(std::filesystem::path const& path,
+      Callback const& callback,
+      enum event::clock clock = Policy::clock) noexcept
+{
+  using namespace ::detail::wtr::watcher::adapter;
 
-        : (callback({"e/self/die@" + path.string(), ev::what::other, ev::kind::watcher}),
-           false);
-  };
+  return _from(open<Policy>(path, filter{}, callback, clock));
+};
 
-  auto do_error = [&path, &callback, &done](system_resources&& sr,
-                                            char const* const msg) -> bool
-  {
-    return (
-      callback(
-        {std::string{msg} + "@" + path.string(), ev::what::other, ev::kind::watcher}),
+/*  @brief wtr/watcher/watch
+    Same as above, for many paths at once, with one watcher.
+    On Linux, they share one kernel instance (and thread),
+    so a few hundred of them don't run into the limit on
+    how many of those we may have. Each event's `root` is
+    the place, in `roots`, of the path it happened beneath.
+    The filter is matched relative to each of them. The
+    callback can be any of the above, but one for batches
+    can't be given a filter.
+
+    auto const roots = std::vector<std::filesystem::path>{"a", "b"};
+    auto w = watch(roots, [&](event const& e) {
+      std::cout << roots[e.root] << ": " << e.where << "\n";
+    });
+
+    Where they overlap, an event is sent once, for the
+    deepest of them. Elsewhere, each path is watched on its
+    own thread, and its events are stamped the same way.
+    Either way, the callback is called from one thread at a
+    time, and needs no lock of its own for that. */
+template<class Policy = policy, class Callback>
+[[nodiscard("Returns a way to stop this watcher, for example: "
+            "auto w = watch(ps, cb) ; w.close() // or w();")]]
 
-      done(std::move(sr)),
+inline auto
+watch(std::vector<std::filesystem::path> const& roots,
+      Callback const& callback,
+      enum event::clock clock = Policy::clock) noexcept
+{
+  using namespace ::detail::wtr::watcher::adapter;
 
-      false);
-  };
+  return _from(open<Policy>(roots, filter{}, callback, clock));
+};
 
-  /*  While living, with
-      - System resources for fanotify and epoll
-      - An event list for receiving epoll events
+template<class Policy = policy, class Callback>
+requires(std::is_invocable_v<Callback const&, event const&>
+         or std::is_invocable_v<Callback const&, event::compact const&>)
+[[nodiscard("Returns a way to stop this watcher, for example: "
+            "auto w = watch(ps, f, cb) ; w.close() // or w();")]]
 
-      Do
-      - Await filesystem events
-      - Invoke `callback` on errors and events */
+inline auto
+watch(std::vector<std::filesystem::path> const& roots,
+      filter const& filter,
+      Callback const& callback,
+      enum event::clock clock = Policy::clock) noexcept
+{
+  using namespace ::detail::wtr::watcher::adapter;
 
-  auto sr = open_system_resources(path, callback);
+  return _from(open<Policy>(roots, filter, callback, clock));
+};
 
-  epoll_event event_recv_list[event_wait_queue_max];
+/*  @brief wtr/watcher/watch
+    Same as above, but the events are made up, as `stream`
+    describes, beneath `path`, instead of read from the
+    kernel. The callback can be any of the above. Which
+    watcher to make can be decided when we run: both have
+    the same type. See `synthetic`. Here too, a callback
+    for batches can't be given a filter.
+
+    auto w = fake ? watch(".", synthetic{.rate = 1e6}, callback)
+                  : watch(".", callback); */
+template<class Policy = policy, class Callback>
+[[nodiscard("Returns a way to stop this watcher, for example: "
+            "auto w = watch(p, s, cb) ; w.close() // or w();")]]
 
-  if (sr.valid) [[likely]] {
-    while (is_living()) [[likely]]
+inline auto
+watch(std::filesystem::path const& path,
+      synthetic const& stream,
+      Callback const& callback,
+      enum event::clock clock = Policy::clock) noexcept
+{
+  using namespace ::detail::wtr::watcher::adapter;
 
-    {
-      int event_count = epoll_wait(sr.event_fd,
-                                   event_recv_list,
-                                   event_wait_queue_max,
-                                   delay_ms);
-      if (event_count < 0)
-        return do_error(std::move(sr), "e/sys/epoll_wait");
+  return _from(open<Policy>(path, filter{}, callback, clock, stream));
+};
 
-      else if (event_count > 0) [[likely]]
-        for (int n = 0; n < event_count; n++)
-          if (event_recv_list[n].data.fd == sr.watch_fd) [[likely]]
-            if (is_living()) [[likely]]
-              if (! recv(sr, path, callback)) [[unlikely]]
-                return do_error(std::move(sr), "e/self/event_recv");
-    }
+template<class Policy = policy, class Callback>
+requires(std::is_invocable_v<Callback const&, event const&>
+         or std::is_invocable_v<Callback const&, event::compact const&>)
+[[nodiscard("Returns a way to stop this watcher, for example: "
+            "auto w = watch(p, f, s, cb) ; w.close() // or w();")]]
 
-    return done(std::move(sr));
-  }
+inline auto
+watch(std::filesystem::path const& path,
+      filter const& filter,
+      synthetic const& stream,
+      Callback const& callback,
+      enum event::clock clock = Policy::clock) noexcept
+{
+  using namespace ::detail::wtr::watcher::adapter;
 
-  else
-    return do_error(std::move(sr), "e/self/sys_resource");
+  return _from(open<Policy>(path, filter, callback, clock, stream));
 };
 
-// clang-format off
-// returning tuples is confusing clang format
+} /* namespace watcher */
+} /* namespace wtr   */
 
-}  // namespace fanotify
-}  // namespace adapter
-}  // namespace watcher
-}  // namespace wtr
-}  // namespace detail
+/*  size_t */
+#include <cstddef>
+/*  vector */
+#include <vector>
+/*  watch
+    adapter */
 
-// clang-format on
+namespace wtr {
+inline namespace watcher {
 
-#endif /* !defined(WATER_WATCHER_USE_WARTHOG) */
-#endif /* defined(WATER_WATCHER_PLATFORM_LINUX_KERNEL_GTE_5_9_0) \
-          && !defined(WATER_WATCHER_PLATFORM_ANDROID_ANY) */
+/*  @brief wtr/watcher/group
+    Watchers which are closed together.
 
-/*  @brief wtr/watcher/<d>/adapter/linux/inotify
-    The Linux `inotify` adapter. */
+    Closing a watcher waits for it to notice, which takes
+    as long as its policy's `delay_ms`, at most. Closing
+    watchers one after another waits that long for each.
+    A group tells every one of them to stop before it waits
+    for any, so they all notice at once, and closing a
+    thousand takes about as long as closing one.
 
-/*  WATER_WATCHER_PLATFORM_* */
+      auto g = group{};
+      for (auto const& p : paths) g.add(watch(p, callback));
+      auto closed = g.close();
 
-#if defined(WATER_WATCHER_PLATFORM_LINUX_KERNEL_GTE_2_7_0) \
-  || defined(WATER_WATCHER_PLATFORM_ANDROID_ANY)
-#if ! defined(WATER_WATCHER_USE_WARTHOG)
+    A watcher in a group can still be closed on its own,
+    even from another thread while the group is closing.
+    Whichever of them stops it first waits for it. Closing
+    one twice, either way, does nothing the second time,
+    and says false. */
+class group {
+  std::vector<::detail::wtr::watcher::adapter::future::shared> members{};
 
-#define WATER_WATCHER_ADAPTER_LINUX_INOTIFY
+public:
+  template<class Fn>
+  auto add(_<Fn> const& watcher) -> group&
+  {
+    if (watcher.adapter) this->members.push_back(watcher.adapter);
+    return *this;
+  }
 
-/*  EPOLL*
-    epoll_ctl
-    epoll_wait
-    epoll_event
-    epoll_create
-    epoll_create1 */
-#include <sys/epoll.h>
-/*  IN_*
-    inotify_init
-    inotify_init1
-    inotify_event
-    inotify_add_watch */
-#include <sys/inotify.h>
-/* open
-   read
-   close */
-#include <unistd.h>
-/*  path
-    is_directory
-    directory_options
-    recursive_directory_iterator */
+  auto size() const noexcept -> std::size_t { return this->members.size(); }
+
+  /*  Stops every watcher in the group, then waits for them.
+      Returns whether they all stopped cleanly. The group
+      is empty afterwards. */
+  auto close() noexcept -> bool
+  {
+    using ::detail::wtr::watcher::adapter::join;
+    using ::detail::wtr::watcher::adapter::stop;
+    auto stopped = std::vector<bool>{};
+    for (auto const& m : this->members) stopped.push_back(stop(m));
+    /* Only what we stopped is ours to wait for. Whoever
+       stopped the others waits for them. */
+    auto ok = true;
+    for (auto n = std::size_t{0}; n < this->members.size(); ++n)
+      ok = stopped[n] && join(this->members[n]) && ok;
+    this->members.clear();
+    return ok;
+  }
+
+  auto operator()() noexcept -> bool { return this->close(); }
+};
+
+} /* namespace watcher */
+} /* namespace wtr */
+
+/*  size_t */
+#include <cstddef>
+/*  uint32_t,
+    uint64_t */
+#include <cstdint>
+/*  path */
 #include <filesystem>
-/*  function */
+/*  function,
+    less */
 #include <functional>
-/*  tuple
-    make_tuple */
-#include <tuple>
-/*  error_code */
-#include <system_error>
+/*  map */
+#include <map>
+/*  unique_ptr,
+    make_unique */
+#include <memory>
+/*  basic_string_view */
+#include <string_view>
 /*  unordered_map */
 #include <unordered_map>
-/*  memcpy */
-#include <cstring>
-/*  event
-    callback */
+/*  move */
+#include <utility>
+/*  vector */
+#include <vector>
+/*  event */
 
 namespace detail {
 namespace wtr {
 namespace watcher {
-namespace adapter {
-namespace inotify {
+namespace stage {
 
-/*  @brief wtr/watcher/<d>/adapter/linux/inotify/<a>/constants
-    - delay
-        The delay, in milliseconds, while `epoll_wait` will
-        'sleep' for until we are woken up. We usually check
-        if we're still alive at that point.
-    - event_wait_queue_max
-        Number of events allowed to be given to do_event_recv
-        (returned by `epoll_wait`). Any number between 1
-        and some large number should be fine. We don't
-        lose events if we 'miss' them, the events are
-        still waiting in the next call to `epoll_wait`.
-    - event_buf_len:
-        For our event buffer, 4096 is a typical page size
-        and sufficiently large to hold a great many events.
-        That's a good thumb-rule.
-    - in_init_opt
-        Use non-blocking IO.
-    - in_watch_opt
-        Everything we can get.
-    @todo
-    - Measure perf of IN_ALL_EVENTS
-    - Handle move events properly.
-      - Use IN_MOVED_TO
-      - Use event::<something> */
-inline constexpr auto delay_ms = 16;
-inline constexpr auto event_wait_queue_max = 1;
-inline constexpr auto event_buf_len = 4096;
-inline constexpr auto in_init_opt = IN_NONBLOCK;
-inline constexpr auto in_watch_opt =
-  IN_CREATE | IN_MODIFY | IN_DELETE | IN_MOVED_FROM | IN_Q_OVERFLOW;
+/*  @brief wtr/watcher/<d>/stage/route
+    Sends each event to those who subscribed to a path it
+    happened beneath (or to the path itself), if they asked
+    for what happened and the kind of path it happened to.
 
-/*  @brief wtr/watcher/<d>/adapter/linux/inotify/<a>/types
-    - path_map_type
-        An alias for a map of file descriptors to paths.
-    - sys_resource_type
-        An object representing an inotify file descriptor,
-        an epoll file descriptor, an epoll configuration,
-        and whether or not the resources are valid */
-using path_map_type = std::unordered_map<int, std::filesystem::path>;
+    Subscriptions are kept in a tree, one level for each
+    component of their paths. An event walks down it along
+    its own path, and is sent to who is at each level it
+    passes. How long that takes depends on how deep the
+    path is, and on how many it is sent to, but not on how
+    many have subscribed.
 
-struct sys_resource_type {
-  bool valid;
-  int watch_fd;
-  int event_fd;
-  epoll_event event_conf;
-};
+    Messages from the watcher aren't beneath any path. They
+    are sent to everyone who asked for `kind::watcher`.
 
-/*  @brief wtr/watcher/<d>/adapter/linux/inotify/<a>/fns/do_path_map_create
-    If the path given is a directory
-      - find all directories above the base path given.
-      - ignore nonexistent directories.
-      - return a map of watch descriptors -> directories.
-    If `path` is a file
-      - return it as the only value in a map.
-      - the watch descriptor key should always be 1. */
-inline auto path_map(std::filesystem::path const& base_path,
-                     ::wtr::watcher::event::callback const& callback,
-                     sys_resource_type const& sr) noexcept -> path_map_type
-{
-  namespace fs = ::std::filesystem;
+    Paths are matched as they are, component by component:
+    they should be written the same way as the watcher's.
+
+    This isn't locked. Whoever has one does that. */
+class route {
+public:
+  using callback_type = ::wtr::watcher::event::compact::callback;
+
+  /*  What happened, and to which kinds of path, someone
+      wants to hear about. Everything, unless they say. */
+  struct mask {
+    std::uint32_t whats{~0u};
+    std::uint32_t kinds{~0u};
+
+    static auto of(std::vector<enum ::wtr::watcher::event::what> const& whats,
+                   std::vector<enum ::wtr::watcher::event::kind> const& kinds)
+      noexcept -> mask
+    {
+      auto m = mask{whats.empty() ? ~0u : 0u, kinds.empty() ? ~0u : 0u};
+      for (auto const w : whats) m.whats |= 1u << (unsigned)w;
+      for (auto const k : kinds) m.kinds |= 1u << (unsigned)k;
+      return m;
+    }
+
+    auto has(enum ::wtr::watcher::event::what w,
+             enum ::wtr::watcher::event::kind k) const noexcept -> bool
+    {
+      return (this->whats & 1u << (unsigned)w)
+          && (this->kinds & 1u << (unsigned)k);
+    }
+  };
+
+private:
   using ev = ::wtr::watcher::event;
-  using diter = fs::recursive_directory_iterator;
-  using dopt = fs::directory_options;
+  using string_type = std::filesystem::path::string_type;
+  using view_type =
+    std::basic_string_view<std::filesystem::path::value_type>;
 
-  /* Follow symlinks, ignore paths which we don't have permissions for. */
-  static constexpr auto fs_dir_opt =
-    dopt::skip_permission_denied & dopt::follow_directory_symlink;
+  static constexpr auto sep = std::filesystem::path::preferred_separator;
 
-  static constexpr auto path_map_reserve_count = 256;
+  struct entry {
+    std::uint64_t id{};
+    mask wants{};
+    callback_type callback{};
+  };
 
-  auto pm = path_map_type{};
-  pm.reserve(path_map_reserve_count);
+  struct node {
+    std::map<string_type, std::unique_ptr<node>, std::less<>> children{};
+    std::vector<entry> here{};
+    node* parent{};
+    string_type name{};
+  };
 
-  auto do_mark = [&](fs::path const& d) noexcept -> bool
+  node top{};
+  std::unordered_map<std::uint64_t, node*> nodes{};
+  std::uint64_t last_id{0};
+
+  /*  Calls `fn` with each component of `path`, from the
+      top: the root directory, if it has one, and then each
+      name. Stops, and says false, when `fn` does. */
+  template<class Fn>
+  static auto each_part(view_type path, Fn const& fn) noexcept -> bool
   {
-    int wd = inotify_add_watch(sr.watch_fd, d.c_str(), in_watch_opt);
-    return wd > 0 ? pm.emplace(wd, d).first != pm.end() : false;
-  };
+    if (path.starts_with(sep) && ! fn(path.substr(0, 1))) return false;
+    while (! path.empty()) {
+      auto const end = path.find(sep);
+      auto const part = path.substr(0, end);
+      if (! part.empty() && ! fn(part)) return false;
+      if (end == view_type::npos) break;
+      path.remove_prefix(end + 1);
+    }
+    return true;
+  }
 
-  try {
-    if (sr.valid)
-      if (do_mark(base_path))
-        if (fs::is_directory(base_path))
-          for (auto dir : diter(base_path, fs_dir_opt))
-            if (fs::is_directory(dir))
-              if (! do_mark(dir.path()))
-                callback({"w/sys/not_watched@" + base_path.string() + "@"
-                            + dir.path().string(),
-                          ev::what::other,
-                          ev::kind::watcher});
-  } catch (...) {}
+  /*  Sends `e` to everyone at `at`, and beneath it. */
+  static auto send_all(node const& at, ev::compact const& e) noexcept -> void
+  {
+    for (auto const& s : at.here)
+      if (s.wants.has(e.what, e.kind)) s.callback(e);
+    for (auto const& [_, child] : at.children) send_all(*child, e);
+  }
 
-  return pm;
-};
+public:
+  route() noexcept = default;
+  route(route const&) = delete;
+  route& operator=(route const&) = delete;
+
+  /*  Subscribes `callback` to what happens beneath `path`,
+      which `wants` has. Gives back what the subscription
+      is known by, to `remove` it with. */
+  auto add(view_type path,
+           callback_type callback,
+           mask wants = {~0u, ~0u}) noexcept
+    -> std::uint64_t
+  {
+    auto* at = &this->top;
+    each_part(path,
+              [&](view_type part) noexcept
+              {
+                auto found = at->children.find(part);
+                if (found == at->children.end())
+                  found = at->children
+                            .emplace(string_type{part},
+                                     std::make_unique<node>(
+                                       node{{}, {}, at, string_type{part}}))
+                            .first;
+                at = found->second.get();
+                return true;
+              });
+    auto const id = ++this->last_id;
+    at->here.push_back({id, wants, std::move(callback)});
+    this->nodes[id] = at;
+    return id;
+  }
 
-/*  @brief wtr/watcher/<d>/adapter/linux/inotify/<a>/fns/system_unfold
-    Produces a `sys_resource_type` with the file descriptors from
-    `inotify_init` and `epoll_create`. Invokes `callback` on errors. */
-inline auto
-system_unfold(::wtr::watcher::event::callback const& callback) noexcept
-  -> sys_resource_type
-{
-  auto do_error = [&callback](char const* const msg,
-                              int watch_fd,
-                              int event_fd = -1) noexcept -> sys_resource_type
+  /*  Removes the subscription known by `id`, and whatever
+      part of the tree only it needed. Says false if there
+      was no such subscription. */
+  auto remove(std::uint64_t id) noexcept -> bool
   {
-    callback({msg,
-              ::wtr::watcher::event::what::other,
-              ::wtr::watcher::event::kind::watcher});
-    return sys_resource_type{
-      .valid = false,
-      .watch_fd = watch_fd,
-      .event_fd = event_fd,
-      .event_conf = {.events = 0, .data = {.fd = watch_fd}}
-    };
+    auto const found = this->nodes.find(id);
+    if (found == this->nodes.end()) return false;
+    auto* at = found->second;
+    this->nodes.erase(found);
+    std::erase_if(at->here, [id](auto const& s) { return s.id == id; });
+    while (at->parent && at->here.empty() && at->children.empty()) {
+      auto* const parent = at->parent;
+      auto const name = at->name;
+      parent->children.erase(name);
+      at = parent;
+    }
+    return true;
+  }
+
+  /*  How many have subscribed. */
+  auto size() const noexcept -> std::size_t { return this->nodes.size(); }
+
+  auto operator()(ev::compact const& e) const noexcept -> void
+  {
+    if (e.kind == ev::kind::watcher) return send_all(this->top, e);
+    auto const* at = &this->top;
+    for (auto const& s : at->here)
+      if (s.wants.has(e.what, e.kind)) s.callback(e);
+    each_part(e.where,
+              [&](view_type part) noexcept
+              {
+                auto const found = at->children.find(part);
+                if (found == at->children.end()) return false;
+                at = found->second.get();
+                for (auto const& s : at->here)
+                  if (s.wants.has(e.what, e.kind)) s.callback(e);
+                return true;
+              });
+  }
+};
+
+} /* namespace stage */
+} /* namespace watcher */
+} /* namespace wtr */
+} /* namespace detail */
+
+/*  size_t */
+#include <cstddef>
+/*  uint64_t */
+#include <cstdint>
+/*  path */
+#include <filesystem>
+/*  make_shared,
+    shared_ptr */
+#include <memory>
+/*  mutex,
+    scoped_lock */
+#include <mutex>
+/*  is_invocable_v */
+#include <type_traits>
+/*  vector */
+#include <vector>
+/*  stage::route */
+/*  event */
+
+namespace wtr {
+inline namespace watcher {
+
+/*  @brief wtr/watcher/router
+    A callback which sends each event on to those who
+    subscribed to a path it happened beneath, and to what
+    happened and the kind of path it happened to.
+
+    Giving every consumer every event, and having each
+    throw away what it doesn't want, takes as long as there
+    are consumers. A router keeps them in a tree of path
+    components, so an event is sent on after a walk as deep
+    as its path, past everyone who didn't want it.
+
+      auto r = router{};
+      auto w = watch("/srv", r);
+      auto id = r.subscribe("/srv/app/config", callback,
+                            {.what = {event::what::modify}});
+      r.unsubscribe(id);
+
+    Paths are matched as they are written, component by
+    component, so subscribe to them in the same form as the
+    watcher's path. Messages from the watcher go to everyone
+    whose mask has `kind::watcher`, which it does unless it
+    says what kinds it wants.
+
+    A router can be copied. The copies are the same router,
+    so one can be given to `watch` and the other kept to
+    subscribe with. Events are sent on while it is locked,
+    so a callback can't subscribe, or unsubscribe, through
+    the router which called it. */
+class router {
+public:
+  /*  What happened, and to which kinds of path, someone
+      wants to hear about. Anything, where they don't say. */
+  struct mask {
+    std::vector<enum event::what> what{};
+    std::vector<enum event::kind> kind{};
   };
 
-  int watch_fd
-#if defined(WATER_WATCHER_PLATFORM_ANDROID_ANY)
-    = inotify_init();
-#elif defined(WATER_WATCHER_PLATFORM_LINUX_KERNEL_ANY)
-    = inotify_init1(in_init_opt);
-#endif
+private:
+  using route = ::detail::wtr::watcher::stage::route;
 
-  if (watch_fd >= 0) {
-    epoll_event event_conf{.events = EPOLLIN, .data{.fd = watch_fd}};
+  struct state {
+    mutable std::mutex lk{};
+    route routes{};
+  };
 
-    int event_fd
-#if defined(WATER_WATCHER_PLATFORM_ANDROID_ANY)
-      = epoll_create(event_wait_queue_max);
-#elif defined(WATER_WATCHER_PLATFORM_LINUX_KERNEL_ANY)
-      = epoll_create1(EPOLL_CLOEXEC);
-#endif
+  std::shared_ptr<state> self{std::make_shared<state>()};
 
-    if (event_fd >= 0)
-      if (epoll_ctl(event_fd, EPOLL_CTL_ADD, watch_fd, &event_conf) >= 0)
-        return sys_resource_type{.valid = true,
-                                 .watch_fd = watch_fd,
-                                 .event_fd = event_fd,
-                                 .event_conf = event_conf};
-      else
-        return do_error("e/sys/epoll_ctl", watch_fd, event_fd);
+public:
+  /*  Subscribes `callback` to what happens beneath `path`,
+      which `wants` has. Gives back what the subscription is
+      known by, to `unsubscribe` with. */
+  template<class Callback>
+  requires(std::is_invocable_v<Callback const&, event const&>
+           or std::is_invocable_v<Callback const&, event::compact const&>)
+  auto subscribe(std::filesystem::path const& path,
+                 Callback const& callback,
+                 mask const& wants = {}) const noexcept -> std::uint64_t
+  {
+    auto each = event::compact::callback{};
+    if constexpr (std::is_invocable_v<Callback const&, event const&>)
+      each = [callback](event::compact const& e) { callback(event{e}); };
     else
-      return do_error("e/sys/epoll_create", watch_fd, event_fd);
+      each = callback;
+
+    auto _ = std::scoped_lock{this->self->lk};
+    return this->self->routes.add(path.native(),
+                                  std::move(each),
+                                  route::mask::of(wants.what, wants.kind));
   }
-  else
-    return do_error("e/sys/inotify_init", watch_fd);
-}
 
-/*  @brief wtr/watcher/<d>/adapter/linux/inotify/<a>/fns/system_fold
-    Close the file descriptors `watch_fd` and `event_fd`. */
-inline auto system_fold(sys_resource_type& sr) noexcept -> bool
-{
-  return ! (close(sr.watch_fd) && close(sr.event_fd));
-}
+  /*  Says false if there was no such subscription. */
+  auto unsubscribe(std::uint64_t id) const noexcept -> bool
+  {
+    auto _ = std::scoped_lock{this->self->lk};
+    return this->self->routes.remove(id);
+  }
+
+  auto size() const noexcept -> std::size_t
+  {
+    auto _ = std::scoped_lock{this->self->lk};
+    return this->self->routes.size();
+  }
+
+  auto operator()(event::compact const& e) const noexcept -> void
+  {
+    auto _ = std::scoped_lock{this->self->lk};
+    this->self->routes(e);
+  }
+};
+
+} /* namespace watcher */
+} /* namespace wtr */
+
+/*  sort,
+    find,
+    find_if,
+    min */
+#include <algorithm>
+/*  uint64_t */
+#include <cstdint>
+/*  path,
+    weakly_canonical */
+#include <filesystem>
+/*  function */
+#include <functional>
+/*  mutex
+    scoped_lock */
+#include <mutex>
+/*  basic_string_view */
+#include <string_view>
+/*  error_code */
+#include <system_error>
+/*  exchange
+    move */
+#include <utility>
+/*  vector */
+#include <vector>
+/*  stage::route */
+/*  event
+    diag
+    with_diags
+    filter
+    adapter */
 
-/*  @brief wtr/watcher/<d>/adapter/linux/inotify/<a>/fns/do_event_recv
-    Reads through available (inotify) filesystem events.
-    Discerns their path and type.
-    Calls the callback.
-    Returns false on eventful errors.
+namespace detail {
+namespace wtr {
+namespace watcher {
+namespace share {
+
+/*  @brief wtr/watcher/<d>/share/registry
+    The shared watches in this process, and the one watcher
+    which they share.
+
+    The watcher watches as few roots as cover everyone's
+    paths: none of them is beneath another. A path beneath
+    one which is already watched costs nothing more than a
+    place in the list. A path above some which are watched
+    is added to the watcher, and those beneath it are then
+    removed from it, so their trees are never unwatched.
+    When a watch is closed, the roots are worked out again,
+    the same way, and the last one to close closes the
+    watcher.
+
+    Events are sent to each watch whose path they happened
+    beneath, and which wants what happened to that kind of
+    path, after its filter (relative to that path). They
+    find those watches by walking down a `stage::route`
+    along their path, past the watches they aren't for.
+    Warnings and errors from the watcher are sent to each
+    watch whose path they are about (above or beneath), or
+    to everyone if they aren't about a path. Whether the
+    watcher is alive, or not, is for us, not for them: it
+    is watching other roots than they asked for, which come
+    and go as they join and leave.
+
+    Everyone's callbacks are called on the watcher's thread,
+    one after another, while we hold our lock. A callback
+    can't open or close a shared watch.
+
+    There is one of these for each `Policy`. */
+template<class Policy>
+class registry {
+public:
+  using callback_type = ::wtr::watcher::event::compact::callback;
 
-    @todo
-    Return new directories when they appear,
-    Consider running and returning `find_dirs` from here.
-    Remove destroyed watches. */
-inline auto
-do_event_recv(int watch_fd,
-              path_map_type& pm,
-              std::filesystem::path const& base_path,
-              ::wtr::watcher::event::callback const& callback) noexcept -> bool
-{
-  namespace fs = ::std::filesystem;
+private:
+  using ev = ::wtr::watcher::event;
+  using string_type = std::filesystem::path::string_type;
+  using view_type =
+    std::basic_string_view<std::filesystem::path::value_type>;
 
-  alignas(inotify_event) char buf[event_buf_len];
+  static constexpr auto sep = std::filesystem::path::preferred_separator;
 
-  enum class state { eventful, eventless, error };
+  using route = ::detail::wtr::watcher::stage::route;
 
-  /*  While inotify has events pending, read them.
-      There might be several events from a single read.
+  struct subscriber {
+    std::uint64_t id{};
+    string_type path{};
+    route::mask wants{};
+    callback_type callback{};
+    ::wtr::watcher::diag::callback diags{};
+  };
 
-      Three possible states:
-       - eventful: there are events to read
-       - eventless: there are no events to read
-       - error: there was an error reading events
+  std::mutex lk{};
+  ::detail::wtr::watcher::adapter::future::shared watcher{};
+  std::vector<string_type> roots{};
+  std::vector<subscriber> subscribers{};
+  route routes{};
 
-      The EAGAIN "error" means there is nothing
-      to read. We count that as 'eventless'.
+  /*  Whether `path` is `root`, or beneath it. */
+  static auto beneath(view_type path, view_type root) noexcept -> bool
+  {
+    return path.starts_with(root)
+        && (path.size() == root.size() || path[root.size()] == sep
+            || root.ends_with(sep));
+  }
 
-      Forward events and errors to the user.
+  /*  As few paths as cover everyone's, none of them beneath
+      another. The shallowest are taken first. */
+  auto cover() const noexcept -> std::vector<string_type>
+  {
+    auto paths = std::vector<string_type>{};
+    for (auto const& s : this->subscribers) paths.push_back(s.path);
+    std::sort(paths.begin(),
+              paths.end(),
+              [](auto const& a, auto const& b)
+              {
+                return a.size() < b.size()
+                    || (a.size() == b.size() && a < b);
+              });
+    auto covered = std::vector<string_type>{};
+    for (auto const& p : paths) {
+      auto above = false;
+      for (auto const& c : covered) above = above || beneath(p, c);
+      if (! above) covered.push_back(p);
+    }
+    return covered;
+  }
 
-      Return when eventless. */
+  /*  Asks the watcher to watch the roots which now cover
+      everyone's paths, adding before removing. */
+  auto recover() noexcept -> void
+  {
+    using ::detail::wtr::watcher::adapter::add;
+    using ::detail::wtr::watcher::adapter::remove;
+    auto const covered = this->cover();
+    auto const has = [](auto const& in, auto const& p)
+    { return std::find(in.begin(), in.end(), p) != in.end(); };
+    for (auto const& p : covered)
+      if (! has(this->roots, p)) add(this->watcher, p);
+    for (auto const& p : this->roots)
+      if (! has(covered, p)) remove(this->watcher, p);
+    this->roots = covered;
+  }
 
-recurse:
+  /*  Sends `e` to everyone it is for. */
+  auto send(ev::compact const& e) noexcept -> void
+  {
+    auto _ = std::scoped_lock{this->lk};
+    auto mine = e;
+    mine.root = 0;
+    this->routes(mine);
+  }
 
-  ssize_t read_len = read(watch_fd, buf, event_buf_len);
+  /*  Sends what the watcher says to everyone it is about. */
+  auto say(::wtr::watcher::diag const& d) noexcept -> void
+  {
+    if (d.level == ::wtr::watcher::diag::level::status) return;
+    auto _ = std::scoped_lock{this->lk};
+    auto const message = d.message();
+    for (auto const& s : this->subscribers) {
+      if (! d.where.empty() && ! beneath(d.where, s.path)
+          && ! beneath(s.path, d.where))
+        continue;
+      if (! s.wants.has(d.what(), ev::kind::watcher)) continue;
+      if (s.diags)
+        s.diags(d);
+      else
+        s.callback({message, d.what(), ev::kind::watcher});
+    }
+  }
 
-  switch (read_len > 0      ? state::eventful
-          : read_len == 0   ? state::eventless
-          : errno == EAGAIN ? state::eventless
-                            : state::error) {
-    case state::eventful : {
-      /* Loop over all events in the buffer. */
-      auto this_event = (inotify_event*)buf;
-      while (this_event < (inotify_event*)(buf + read_len)) {
-        if (! (this_event->mask & IN_Q_OVERFLOW)) [[likely]] {
-          auto path =
-            pm.find(this_event->wd)->second / fs::path(this_event->name);
+  registry() noexcept = default;
 
-          auto kind = this_event->mask & IN_ISDIR
-                      ? ::wtr::watcher::event::kind::dir
-                      : ::wtr::watcher::event::kind::file;
+public:
+  registry(registry const&) = delete;
+  registry& operator=(registry const&) = delete;
 
-          auto what =
-            this_event->mask & IN_CREATE ? ::wtr::watcher::event::what::create
-            : this_event->mask & IN_DELETE
-              ? ::wtr::watcher::event::what::destroy
-            : this_event->mask & IN_MOVE   ? ::wtr::watcher::event::what::rename
-            : this_event->mask & IN_MODIFY ? ::wtr::watcher::event::what::modify
-                                           : ::wtr::watcher::event::what::other;
+  ~registry() noexcept
+  {
+    if (this->watcher) ::detail::wtr::watcher::adapter::close(this->watcher);
+  }
 
-          callback({path, what, kind});
+  static auto instance() noexcept -> registry&
+  {
+    static auto r = registry{};
+    return r;
+  }
 
-          if (kind == ::wtr::watcher::event::kind::dir
-              && what == ::wtr::watcher::event::what::create)
-            pm[inotify_add_watch(watch_fd, path.c_str(), in_watch_opt)] = path;
+  /*  Adds a watch on `path`, for what `wants` has, and
+      gives back what it is known by, to `leave` with. What
+      the watcher says goes to `diags`, if there are any, or
+      to `callback`. */
+  auto join(std::filesystem::path const& path,
+            ::wtr::watcher::filter const& filter,
+            callback_type callback,
+            ::wtr::watcher::diag::callback diags = {},
+            route::mask wants = {}) noexcept -> std::uint64_t
+  {
+    auto ec = std::error_code{};
+    auto real = std::filesystem::weakly_canonical(path, ec).native();
+    if (real.empty()) real = path.native();
+    while (real.size() > 1 && real.ends_with(sep)) real.pop_back();
+
+    /* Matched relative to `real`. */
+    auto const filtered =
+      [live = filter.loaded(real), skip = real.size(), callback](
+        ev::compact const& e) noexcept
+    {
+      auto rel = e.where.substr(std::min(skip, e.where.size()));
+      while (rel.starts_with(sep)) rel.remove_prefix(1);
+      if (live.keeps(rel, e.kind)) callback(e);
+    };
 
-          else if (kind == ::wtr::watcher::event::kind::dir
-                   && what == ::wtr::watcher::event::what::destroy) {
-            inotify_rm_watch(watch_fd, this_event->wd);
-            pm.erase(this_event->wd);
-          }
-        }
-        else
-          callback({"e/self/overflow@" + base_path.string(),
-                    ::wtr::watcher::event::what::other,
-                    ::wtr::watcher::event::kind::watcher});
+    auto _ = std::scoped_lock{this->lk};
+    auto const id = filter.empty() ? this->routes.add(real, callback, wants)
+                                   : this->routes.add(real, filtered, wants);
+    this->subscribers.push_back(
+      {id, real, wants, std::move(callback), std::move(diags)});
+    /* Opened with nothing to watch, it has nothing to say
+       yet, so it doesn't call us back while we hold the
+       lock. Its roots are added as they would be later. */
+    if (! this->watcher)
+      this->watcher = ::detail::wtr::watcher::adapter::open<Policy>(
+        std::vector<std::filesystem::path>{},
+        ::wtr::watcher::filter{},
+        ::wtr::watcher::with_diags(
+          [this](ev::compact const& e) noexcept { this->send(e); },
+          [this](::wtr::watcher::diag const& d) noexcept { this->say(d); }));
+    this->recover();
+    return id;
+  }
 
-        this_event += sizeof(inotify_event);
+  /*  Closes the watch known by `id`. The last one closes
+      the watcher, and says whether it closed cleanly. The
+      others say true. Anything closed already says false. */
+  auto leave(std::uint64_t id) noexcept -> bool
+  {
+    auto last = ::detail::wtr::watcher::adapter::future::shared{};
+    {
+      auto _ = std::scoped_lock{this->lk};
+      auto const at = std::find_if(this->subscribers.begin(),
+                                   this->subscribers.end(),
+                                   [id](auto const& s) { return s.id == id; });
+      if (at == this->subscribers.end()) return false;
+      this->subscribers.erase(at);
+      this->routes.remove(id);
+      if (! this->subscribers.empty()) {
+        this->recover();
+        return true;
       }
-      /* Same as `return do_event_recv(..., buf)`.
-         Our stopping condition is `eventless` or `error`. */
-      goto recurse;
+      this->roots.clear();
+      last = std::exchange(this->watcher, {});
     }
-
-    case state::error :
-      callback({"e/sys/read@" + base_path.string(),
-                ::wtr::watcher::event::what::other,
-                ::wtr::watcher::event::kind::watcher});
-      return false;
-
-    case state::eventless : return true;
+    /* Not while we hold the lock, which the watcher takes
+       to send what it has left. */
+    return ::detail::wtr::watcher::adapter::close(last);
   }
+};
 
-  /* Unreachable */
-  return false;
-}
+} /* namespace share */
+} /* namespace watcher */
+} /* namespace wtr */
+} /* namespace detail */
 
-/*  @brief wtr/watcher/<d>/adapter/watch
-    Monitors `path` for changes.
-    Invokes `callback` with an `event` when they happen.
-    `watch` stops when asked to or irrecoverable errors occur.
-    All events, including errors, are passed to `callback`.
+/*  uint64_t */
+#include <cstdint>
+/*  path */
+#include <filesystem>
+/*  is_invocable_v */
+#include <type_traits>
+/*  share::registry */
+/*  event
+    filter
+    router
+    policy
+    adapter */
 
-    @param path
-    A filesystem path to watch for events.
+namespace wtr {
+inline namespace watcher {
 
-    @param callback
-    A function to invoke with an `event` object
-    when the files being watched change.
+/*  @brief wtr/watcher/subscription
+    A way to close a shared watch. See `share`.
 
-    @param is_living
-    A function to decide whether we're dead. */
-inline bool watch(std::filesystem::path const& path,
-                  ::wtr::watcher::event::callback const& callback,
-                  std::function<bool()> const& is_living) noexcept
-{
-  using ev = ::wtr::watcher::event;
+    Closing one twice does nothing the second time, and
+    says false. */
+struct subscription {
+  std::uint64_t const id{};
+  bool (*const leave)(std::uint64_t) noexcept {};
 
-  auto do_error = [&path, &callback](bool clean, std::string&& msg) -> bool
+  inline auto close() const noexcept -> bool
   {
-    callback({msg + path.string(), ev::what::other, ev::kind::watcher});
+    return this->leave && this->leave(this->id);
+  };
 
-    if (clean)
-      callback({"s/self/die@" + path.string(), ev::what::other, ev::kind::watcher});
+  inline auto operator()() const noexcept -> bool { return this->close(); };
+};
 
-    else
-      callback({"e/self/die@" + path.string(), ev::what::other, ev::kind::watcher});
+/*  @brief wtr/watcher/share
+    Watches `path`, as `watch` does, but with the one
+    watcher this process shares among everything which
+    `share`s.
+
+    Parts of a program which don't know about each other
+    may watch the same trees, or trees inside each other,
+    such as `/srv/app` and `/srv/app/config`. With `watch`,
+    each of them has its own kernel instance, its own marks
+    on every directory and its own thread. With `share`,
+    they have one of each, and the marks are made once, for
+    the shallowest of the trees. Each is sent the events
+    beneath its own path, which its filter keeps (relative
+    to that path). The watcher is opened for the first one,
+    and closed when the last one is.
+
+    auto app = share("/srv/app", callback);
+    auto config = share("/srv/app/config", filter{"*.toml"}, other);
+    app.close(); // `config` keeps watching, without a gap
+
+    Events are sent from the watcher's thread, to one
+    callback after another. A callback can't open or close
+    a shared watch. Whether the watcher is alive isn't sent:
+    it changes what it is watching as others come and go.
+    Its warnings and errors are, to everyone they are about.
+
+    Shared watches with a different `Policy` share another
+    watcher, among themselves.
+
+    Events find the watches they are for by their path, so
+    sending one takes about as long with a thousand shared
+    watches as with one. See `router`. A watch can also ask
+    for only some of what happens, to some kinds of path:
+
+    auto s = share("/srv/app", filter{},
+                   {.what = {event::what::create}}, callback); */
+template<class Policy = policy, class Callback>
+requires(std::is_invocable_v<Callback const&, event const&>
+         or std::is_invocable_v<Callback const&, event::compact const&>)
+[[nodiscard("Returns a way to close this watch, for example: "
+            "auto s = share(p, f, m, cb) ; s.close() // or s();")]]
 
-    return false;
-  };
+inline auto
+share(std::filesystem::path const& path,
+      filter const& filter,
+      router::mask const& wants,
+      Callback const& callback) noexcept -> subscription
+{
+  using registry = ::detail::wtr::watcher::share::registry<Policy>;
 
-  /*  While living, with
-      - A lifetime the user hasn't ended
-      - A historical map of watch descriptors
-        to long paths (for event reporting)
-      - System resources for inotify and epoll
-      - An event buffer for events from epoll
+  auto each = event::compact::callback{};
+  if constexpr (std::is_invocable_v<Callback const&, event const&>)
+    each = [callback](event::compact const& e) { callback(event{e}); };
+  else
+    each = callback;
 
-      Do
-      - Await filesystem events
-      - Invoke `callback` on errors and events */
+  return {
+    registry::instance().join(
+      path,
+      filter,
+      each,
+      ::detail::wtr::watcher::adapter::diags_of(callback),
+      ::detail::wtr::watcher::stage::route::mask::of(wants.what, wants.kind)),
+    [](std::uint64_t id) noexcept { return registry::instance().leave(id); }};
+};
 
-  sys_resource_type sr = system_unfold(callback);
+template<class Policy = policy, class Callback>
+requires(std::is_invocable_v<Callback const&, event const&>
+         or std::is_invocable_v<Callback const&, event::compact const&>)
+[[nodiscard("Returns a way to close this watch, for example: "
+            "auto s = share(p, cb) ; s.close() // or s();")]]
+
+inline auto
+share(std::filesystem::path const& path,
+      filter const& filter,
+      Callback const& callback) noexcept -> subscription
+{
+  return share<Policy>(path, filter, {}, callback);
+};
 
-  epoll_event event_recv_list[event_wait_queue_max];
+template<class Policy = policy, class Callback>
+requires(std::is_invocable_v<Callback const&, event const&>
+         or std::is_invocable_v<Callback const&, event::compact const&>)
+[[nodiscard("Returns a way to close this watch, for example: "
+            "auto s = share(p, cb) ; s.close() // or s();")]]
 
-  auto pm = path_map(path, callback, sr);
+inline auto
+share(std::filesystem::path const& path, Callback const& callback) noexcept
+  -> subscription
+{
+  return share<Policy>(path, filter{}, {}, callback);
+};
 
-  if (sr.valid) [[likely]]
+} /* namespace watcher */
+} /* namespace wtr   */
 
-    if (pm.size() > 0) [[likely]] {
-      while (is_living()) [[likely]]
+/*  milliseconds */
+#include <chrono>
+/*  condition_variable */
+#include <condition_variable>
+/*  function */
+#include <functional>
+/*  mutex
+    unique_lock */
+#include <mutex>
+/*  thread */
+#include <thread>
 
-      {
-        int event_count = epoll_wait(sr.event_fd,
-                                     event_recv_list,
-                                     event_wait_queue_max,
-                                     delay_ms);
+namespace detail {
+namespace wtr {
+namespace watcher {
+namespace stage {
 
-        if (event_count < 0)
-          return do_error(system_fold(sr), "e/sys/epoll_wait@");
+/*  @brief wtr/watcher/<d>/stage/ticker
+    Calls `tick` every `period` on its own thread
+    until it is destroyed.
 
-        else if (event_count > 0) [[likely]]
-          for (int n = 0; n < event_count; n++)
-            if (event_recv_list[n].data.fd == sr.watch_fd) [[likely]]
-              if (! do_event_recv(sr.watch_fd, pm, path, callback)) [[unlikely]]
-                return do_error(system_fold(sr), "e/self/event_recv@");
-      }
+    Stages hold events back for some time. The adapters
+    only call us when there are events, so something
+    else needs to let the held events go when it gets
+    quiet. That's this.
 
-      callback({"s/self/die@" + path.string(), ev::what::destroy, ev::kind::watcher});
-      return system_fold(sr);
-    }
-    else
-      return do_error(system_fold(sr), "e/self/path_map@");
+    The thread is joined on destruction. The owner must
+    be sure that `tick` doesn't destroy the ticker. */
+class ticker {
+  std::mutex lk{};
+  std::condition_variable cv{};
+  bool stopped{false};
+  std::thread worker{};
 
-  else
-    return do_error(system_fold(sr), "e/self/sys_resource@");
-}
+public:
+  ticker(std::chrono::milliseconds period, std::function<void()> tick) noexcept
+      : worker{[this, period, tick{std::move(tick)}]
+               {
+                 auto lock = std::unique_lock{this->lk};
+                 while (! this->cv.wait_for(lock,
+                                            period,
+                                            [this] { return this->stopped; }))
+                 {
+                   lock.unlock();
+                   tick();
+                   lock.lock();
+                 }
+               }}
+  {}
+
+  ticker(ticker const&) = delete;
+  ticker& operator=(ticker const&) = delete;
+
+  ~ticker() noexcept
+  {
+    {
+      auto _ = std::scoped_lock{this->lk};
+      this->stopped = true;
+    }
+    this->cv.notify_all();
+    if (this->worker.joinable()) this->worker.join();
+  }
+};
 
-} /* namespace inotify */
-} /* namespace adapter */
+} /* namespace stage */
 } /* namespace watcher */
 } /* namespace wtr */
 } /* namespace detail */
 
-#endif /* !defined(WATER_WATCHER_USE_WARTHOG) */
-#endif /* defined(WATER_WATCHER_PLATFORM_LINUX_KERNEL_GTE_2_7_0) \
-          || defined(WATER_WATCHER_PLATFORM_ANDROID_ANY) */
+/*  max,
+    min */
+#include <algorithm>
+/*  milliseconds
+    steady_clock */
+#include <chrono>
+/*  uint32_t */
+#include <cstdint>
+/*  path */
+#include <filesystem>
+/*  less */
+#include <functional>
+/*  map */
+#include <map>
+/*  mutex
+    scoped_lock */
+#include <mutex>
+/*  basic_string_view */
+#include <string_view>
+/*  ticker */
+/*  event
+    callback */
 
-/*
-  @brief wtr/detail/wtr/watcher/adapter/linux
+namespace detail {
+namespace wtr {
+namespace watcher {
+namespace stage {
+
+/*  @brief wtr/watcher/<d>/stage/collapse
+    Folds the events in a destroyed, or newly created,
+    subtree into a single event for the subtree's root.
+
+    Destruction is reported from the leaves up, so we
+    hold `destroy` events back. When a directory is
+    destroyed, the (held) events beneath it are dropped
+    and the directory takes their place.
+
+    Creation is reported from the root down, so the
+    first directory we see created becomes a root, and
+    what is created beneath it is dropped. Anything else
+    which happens beneath it, such as a file being
+    written, is passed through.
+
+    Roots are let go when nothing has been folded into
+    them for `window`, when something other than what we
+    fold happens to them, or when the watcher dies. They
+    are never held for more than `window * longest` after
+    they were first seen, however busy their tree is.
+
+    Other events are passed through as they arrive, so
+    they may be seen before a (held) root. */
+class collapse {
+  using ev = ::wtr::watcher::event;
+  using clock = std::chrono::steady_clock;
+  using string_type = std::filesystem::path::string_type;
+  using view_type =
+    std::basic_string_view<std::filesystem::path::value_type>;
+
+  static constexpr auto sep = std::filesystem::path::preferred_separator;
+
+  struct root {
+    enum ev::kind kind;
+    long long when;
+    enum ev::clock clock;
+    std::uint32_t root_of;
+    clock::time_point deadline;
+    /* The latest `deadline` may be. */
+    clock::time_point until;
+
+    /* Holds on, for as long as we may, after what was
+       just folded into us. */
+    auto hold(clock::time_point deadline) noexcept -> void
+    {
+      this->deadline = std::min(deadline, this->until);
+    }
+  };
 
-  The Linux adapters.
-*/
+  /* How many windows a root may be held for, at most. */
+  static constexpr auto longest = 4;
 
-/* WATER_WATCHER_PLATFORM_* */
+  using root_map = std::map<string_type, root, std::less<>>;
 
-#if defined(WATER_WATCHER_PLATFORM_LINUX_KERNEL_GTE_2_7_0) \
-  || defined(WATER_WATCHER_PLATFORM_ANDROID_ANY)
-#if ! defined(WATER_WATCHER_USE_WARTHOG)
+  std::mutex lk{};
+  ev::callback const callback;
+  std::chrono::milliseconds const window;
+  root_map destroyed{};
+  root_map created{};
+  /* Declared last, so that it is stopped first. */
+  ticker tick;
 
-/* function */
-#include <functional>
-/* geteuid */
-#include <unistd.h>
-/* event
-   callback
-   inotify::watch
-   fanotify::watch */
+  /*  The root at, or above, `p`. */
+  static auto covering(root_map& m, view_type p) noexcept
+    -> root_map::iterator
+  {
+    if (! m.empty())
+      for (auto n = p.size(); n > 0 && n != view_type::npos;
+           n = p.rfind(sep, n - 1))
+        if (auto at = m.find(p.substr(0, n)); at != m.end()) return at;
+    return m.end();
+  }
 
-namespace detail {
-namespace wtr {
-namespace watcher {
-namespace adapter {
+  /*  Drops the roots strictly beneath `p`. */
+  static auto absorb(root_map& m, view_type p) noexcept -> void
+  {
+    auto beneath = string_type{p} + sep;
+    auto at = m.lower_bound(beneath);
+    while (at != m.end() && view_type{at->first}.starts_with(beneath))
+      at = m.erase(at);
+  }
 
-/*
-  @brief detail/wtr/watcher/adapter/watch
+  auto let_go(root_map& m, root_map::iterator at, enum ev::what what) noexcept
+    -> void
+  {
+    if (at != m.end()) {
+      auto const& r = at->second;
+      this->callback({at->first, what, r.kind, r.when, r.clock, r.root_of});
+      m.erase(at);
+    }
+  }
 
-  Monitors `path` for changes.
-  Invokes `callback` with an `event` when they happen.
-  `watch` stops when asked to or unrecoverable errors occur.
-  All events, including errors, are passed to `callback`.
+  auto let_go_all(clock::time_point until) noexcept -> void
+  {
+    for (auto at = this->created.begin(); at != this->created.end();)
+      if (at->second.deadline <= until)
+        this->let_go(this->created, at++, ev::what::create);
+      else
+        ++at;
+    for (auto at = this->destroyed.begin(); at != this->destroyed.end();)
+      if (at->second.deadline <= until)
+        this->let_go(this->destroyed, at++, ev::what::destroy);
+      else
+        ++at;
+  }
+
+public:
+  collapse(ev::callback const& callback,
+           std::chrono::milliseconds const& window) noexcept
+      : callback{callback},
+        window{window},
+        tick{std::max(window / 4, std::chrono::milliseconds(1)),
+             [this]
+             {
+               auto _ = std::scoped_lock{this->lk};
+               this->let_go_all(clock::now());
+             }}
+  {}
+
+  auto operator()(ev const& e) noexcept -> void
+  {
+    auto _ = std::scoped_lock{this->lk};
+
+    /* The last event is always from the watcher, and
+       it is always a `destroy` event. Nothing is held
+       past then. */
+    if (e.kind == ev::kind::watcher) {
+      if (e.what == ev::what::destroy)
+        this->let_go_all(clock::time_point::max());
+      return this->callback(e);
+    }
 
-  @param path
-    A filesystem path to watch for events.
+    auto const p = view_type{e.where.native()};
+    auto const now = clock::now();
+    auto const deadline = now + this->window;
+    auto const until = now + this->window * longest;
+
+    /* What is created strictly beneath a new root is part
+       of it. */
+    auto c = covering(this->created, p);
+    if (c != this->created.end()) {
+      if (c->first.size() == p.size())
+        this->let_go(this->created, c, ev::what::create);
+      else if (e.what == ev::what::create)
+        return c->second.hold(deadline);
+    }
 
-  @param callback
-    A function to invoke with an `event` object
-    when the files being watched change.
+    auto d = covering(this->destroyed, p);
 
-  @param is_living
-    A function to decide whether we're dead.
+    if (e.what == ev::what::destroy) {
+      if (d != this->destroyed.end()) return d->second.hold(deadline);
+      absorb(this->destroyed, p);
+      this->destroyed.insert_or_assign(
+        string_type{p},
+        root{e.kind, e.when, e.clock, e.root, deadline, until});
+      return;
+    }
 
-  @note
-  If we have a kernel that can use either `fanotify` or
-  `inotify`, then we will use `fanotify` if the user is
-  (effectively) root.
+    /* Some kernels tell us about a destroyed directory
+       twice: once from its parent and once from itself. */
+    if (e.what == ev::what::other && d != this->destroyed.end()) return;
 
-  If we can only use `fanotify` or `inotify`, then we'll
-  use them. We only use `inotify` on Android.
+    /* Something came back. It happened after the root
+       was destroyed, so the root must be seen first. */
+    this->let_go(this->destroyed, d, ev::what::destroy);
 
-  There should never be a system that can use `fanotify`,
-  but not `inotify`. It's just here for completeness.
-*/
+    if (e.what == ev::what::create && e.kind == ev::kind::dir)
+      this->created.emplace(
+        string_type{p},
+        root{e.kind, e.when, e.clock, e.root, deadline, until});
+
+    else
+      this->callback(e);
+  }
+};
+
+} /* namespace stage */
+} /* namespace watcher */
+} /* namespace wtr */
+} /* namespace detail */
+
+/*  milliseconds */
+#include <chrono>
+/*  make_shared */
+#include <memory>
+/*  stage::collapse */
+/*  event
+    callback */
 
-inline bool watch(std::filesystem::path const& path,
-                  ::wtr::watcher::event::callback const& callback,
-                  std::function<bool()> const& is_living) noexcept
-{
-  return
+namespace wtr {
+inline namespace watcher {
 
-#if defined(WATER_WATCHER_ADAPTER_LINUX_FANOTIFY) \
-  && defined(WATER_WATCHER_ADAPTER_LINUX_INOTIFY)
+/*  @brief wtr/watcher/collapse
 
-    geteuid() == 0 ? fanotify::watch(path, callback, is_living)
-                   : inotify::watch(path, callback, is_living);
+    Returns a callback which calls `callback` once for
+    a subtree which is destroyed, or created, all at once.
 
-#elif defined(WATER_WATCHER_ADAPTER_LINUX_FANOTIFY)
+    Removing a tree with half a million paths in it is
+    half a million `destroy` events. Through `collapse`,
+    it is one `destroy` event for the tree's root.
+    The same goes for `create` events when a tree is
+    populated, such as by extracting an archive.
 
-    fanotify::watch(path, callback, is_living);
+    Events are held back for up to `window` after the
+    last thing was folded into their root, and for no
+    more than four times that in all, so a tree which is
+    busy for a long while (a new directory which a log is
+    written to, say) is still seen. What happens in a new
+    tree, other than creation, is passed through as it
+    happens. Events from the watcher are never held back,
+    and everything is let go before the watcher's last
+    event.
 
-#elif defined(WATER_WATCHER_ADAPTER_LINUX_INOTIFY)
+    Typical use looks like this:
 
-    inotify::watch(path, callback, is_living);
+    auto w = watch(".", collapse([](event const& e) {
+      std::cout << e << std::endl;
+    }));
 
-#else
+    @param callback:
+      Something to call with the collapsed events.
 
-#error "Define 'WATER_WATCHER_USE_WARTHOG' on kernel versions < 2.7"
+    @param window (optional):
+      How long to wait for more events beneath a root.
+      A root is let go within four of these. */
+inline auto collapse(event::callback const& callback,
+                     std::chrono::milliseconds const& window =
+                       std::chrono::milliseconds(100)) noexcept
+  -> event::callback
+{
+  auto self =
+    std::make_shared<::detail::wtr::watcher::stage::collapse>(callback,
+                                                               window);
 
-#endif
-}
+  return [self](event const& ev) noexcept { (*self)(ev); };
+};
 
-} /* namespace adapter */
 } /* namespace watcher */
-} /* namespace wtr */
-} /* namespace detail */
+} /* namespace wtr   */
 
-#endif /* defined(WATER_WATCHER_PLATFORM_LINUX_KERNEL_GTE_2_7_0) \
-          || defined(WATER_WATCHER_PLATFORM_ANDROID_ANY) */
-#endif /* !defined(WATER_WATCHER_USE_WARTHOG) */
+/*  array */
+#include <array>
+/*  size_t */
+#include <cstddef>
+/*  uint64_t */
+#include <cstdint>
+/*  move */
+#include <utility>
+/*  vector */
+#include <vector>
 
-/*
-  @brief watcher/adapter/android
+namespace detail {
+namespace wtr {
+namespace watcher {
+namespace stage {
+
+/*  @brief wtr/watcher/<d>/stage/wheel
+    A hierarchical timing wheel.
+
+    Each level is a ring of `slot_count` slots. A slot on
+    level `n` spans `slot_count ^ n` ticks. Things which
+    expire soon are put on the lowest level. Things which
+    expire later are put higher up, and are moved down a
+    level (cascaded) whenever the level below comes around.
+
+    Scheduling is constant time. Advancing by a tick is
+    constant time, plus the time to expire or cascade what
+    is in that tick's slots. This holds up to (many)
+    millions of pending things, which a sorted container
+    or a list of timers would not.
+
+    There are `slot_count ^ level_count` ticks (about 16
+    million) within reach. Anything further out is put in
+    the furthest slot and rescheduled when it comes down. */
+template<class T>
+class wheel {
+  static constexpr unsigned level_bits = 6;
+  static constexpr unsigned level_count = 4;
+  static constexpr std::uint64_t slot_count = 1 << level_bits;
+  static constexpr std::uint64_t slot_mask = slot_count - 1;
+  static constexpr std::uint64_t reach = std::uint64_t{1}
+                                      << (level_bits * level_count);
+
+  struct entry {
+    std::uint64_t at;
+    T value;
+  };
 
-  The Android (Linux) `inotify` adapter.
-*/
+  using slot_type = std::vector<entry>;
 
-/* WATER_WATCHER_PLATFORM_* */
+  std::array<std::array<slot_type, slot_count>, level_count> levels{};
+  std::uint64_t now{0};
+  std::size_t count{0};
 
-#if defined(WATER_WATCHER_PLATFORM_ANDROID_ANY)
-#endif
+  auto place(entry&& e) noexcept -> void
+  {
+    auto const delta = e.at - this->now;
+    auto const at = delta < reach ? e.at : this->now + reach - 1;
+    auto level = 0u;
+    while (level + 1 < level_count
+           && delta >= (std::uint64_t{1} << (level_bits * (level + 1))))
+      ++level;
+    auto const slot = (at >> (level_bits * level)) & slot_mask;
+    this->levels[level][slot].emplace_back(std::move(e));
+  }
 
-/* WATER_WATCHER_PLATFORM_* */
+  /*  Move everything in the current slot of `level` down. */
+  auto cascade(unsigned level) noexcept -> void
+  {
+    auto const slot = (this->now >> (level_bits * level)) & slot_mask;
+    auto moving = slot_type{};
+    moving.swap(this->levels[level][slot]);
+    for (auto& e : moving) this->place(std::move(e));
+  }
 
-#if defined(WATER_WATCHER_PLATFORM_UNKNOWN) \
-  || defined(WATER_WATCHER_USE_WARTHOG)
+public:
+  /*  The number of pending things. */
+  auto size() const noexcept -> std::size_t { return this->count; }
 
-/*
-  @brief watcher/adapter/warthog
+  /*  The current tick. */
+  auto tick() const noexcept -> std::uint64_t { return this->now; }
 
-  A reasonably dumb adapter that works on any platform.
+  /*  Schedule `value` to expire at tick `at`.
+      Ticks in the past expire on the next tick. */
+  auto schedule(std::uint64_t at, T value) noexcept -> void
+  {
+    this->place({at > this->now ? at : this->now + 1, std::move(value)});
+    ++this->count;
+  }
 
-  This adapter beats `kqueue`, but it doesn't bean recieving
-  filesystem events directly from the OS.
+  /*  Advance to tick `to`, calling `expire(at, value)`
+      for everything which expires on the way. Things
+      expire in the order of their ticks. */
+  template<class Fn>
+  auto advance(std::uint64_t to, Fn&& expire) noexcept -> void
+  {
+    while (this->now < to) {
+      if (this->count == 0) {
+        this->now = to;
+        return;
+      }
 
-  This is the fallback adapter on platforms that either
-    - Only support `kqueue` (`warthog` beats `kqueue`)
-    - Only support the C++ standard library
-*/
+      ++this->now;
+
+      auto highest = 0u;
+      while (highest + 1 < level_count
+             && (this->now & ((std::uint64_t{1}
+                               << (level_bits * (highest + 1)))
+                              - 1))
+                  == 0)
+        ++highest;
+      for (auto level = highest; level > 0; --level) this->cascade(level);
+
+      auto expiring = slot_type{};
+      expiring.swap(this->levels[0][this->now & slot_mask]);
+      this->count -= expiring.size();
+      for (auto& e : expiring) expire(e.at, std::move(e.value));
+    }
+  }
+};
 
-/* milliseconds */
+} /* namespace stage */
+} /* namespace watcher */
+} /* namespace wtr */
+} /* namespace detail */
+
+/*  max */
+#include <algorithm>
+/*  milliseconds
+    steady_clock */
 #include <chrono>
-/* string */
-#include <string>
-/* filesystem::* */
+/*  uint32_t
+    uint64_t */
+#include <cstdint>
+/*  path */
 #include <filesystem>
-/* function */
-#include <functional>
-/* error_code */
-#include <system_error>
-/* this_thread::sleep_for */
-#include <thread>
-/* unordered_map */
+/*  mutex
+    scoped_lock */
+#include <mutex>
+/*  optional */
+#include <optional>
+/*  unordered_map */
 #include <unordered_map>
-/* event
-   callback */
+/*  ticker */
+/*  wheel */
+/*  event
+    callback */
 
 namespace detail {
 namespace wtr {
 namespace watcher {
-namespace adapter {
-namespace {
+namespace stage {
 
-/* clang-format off */
+/*  @brief wtr/watcher/<d>/stage/coalesce
+    Merges the events for a path which happen within
+    `window` of the first one into (at most) one event.
 
-inline constexpr std::filesystem::directory_options
-  scan_dir_options = 
-    /* This is ridiculous */
-    std::filesystem::directory_options::skip_permission_denied 
-    & std::filesystem::directory_options::follow_directory_symlink;
+    The merged event is sent `window` after the first
+    event for its path, with the first event's time.
 
-using bucket_type = std::unordered_map<std::string, std::filesystem::file_time_type>;
+      create  + modify  -> create
+      create  + destroy -> (nothing)
+      modify  + modify  -> modify
+      modify  + destroy -> destroy
+      destroy + create  -> modify
 
-/* clang-format on */
+    Anything else (a rename, a change of kind, or something
+    from the watcher) lets the held event go first and then
+    passes through. Nothing is held past the watcher's last
+    event.
 
-/*  @brief watcher/adapter/warthog/scan
-    - Scans `path` for changes.
-    - Updates our bucket to match the changes.
-    - Calls `send_event` when changes happen.
-    - Returns false if the file tree cannot be scanned. */
-inline bool scan(std::filesystem::path const& path,
-                 auto const& send_event,
-                 bucket_type& bucket) noexcept
-{
-  /* @brief watcher/adapter/warthog/scan_file
-     - Scans a (single) file for changes.
-     - Updates our bucket to match the changes.
-     - Calls `send_event` when changes happen.
-     - Returns false if the file cannot be scanned. */
-  auto const& scan_file = [&](std::filesystem::path const& file,
-                              auto const& send_event) -> bool
+    Deadlines are kept on a timing wheel, ticking every
+    `window / 8`. Merging and scheduling are constant time. */
+class coalesce {
+  using ev = ::wtr::watcher::event;
+  using clock = std::chrono::steady_clock;
+  using string_type = std::filesystem::path::string_type;
+
+  struct held {
+    enum ev::what what;
+    enum ev::kind kind;
+    long long when;
+    enum ev::clock clock;
+    std::uint32_t root;
+    std::uint64_t at;
+  };
+
+  std::mutex lk{};
+  ev::callback const callback;
+  clock::time_point const epoch{clock::now()};
+  clock::duration const resolution;
+  std::uint64_t const window_ticks;
+  std::unordered_map<string_type, held> pending{};
+  wheel<string_type> deadlines{};
+  /* Declared last, so that it is stopped first. */
+  ticker tick;
+
+  static auto merge(enum ev::what before, enum ev::what after) noexcept
+    -> std::optional<enum ev::what>
   {
-    using namespace ::wtr::watcher;
-    using std::filesystem::exists, std::filesystem::is_regular_file,
-      std::filesystem::last_write_time;
+    using w = enum ev::what;
+    /* clang-format off */
+    if      (before == w::create  && after == w::destroy) return std::nullopt;
+    else if (before == w::create  && after == w::modify)  return w::create;
+    else if (before == w::modify  && after == w::destroy) return w::destroy;
+    else if (before == w::destroy && after == w::create)  return w::modify;
+    else if (before == after)                             return before;
+    else                                                  return after;
+    /* clang-format on */
+  }
 
-    if (exists(file) && is_regular_file(file)) {
-      auto ec = std::error_code{};
-      /* grabbing the file's last write time */
-      auto const& timestamp = last_write_time(file, ec);
-      if (ec) {
-        /* the file changed while we were looking at it. so, we call the
-         * closure, indicating destruction, and remove it from the bucket. */
-        send_event(event{file, event::what::destroy, event::kind::file});
-        if (bucket.contains(file)) bucket.erase(file);
-      }
-      /* if it's not in our bucket, */
-      else if (! bucket.contains(file)) {
-        /* we put it in there and call the closure, indicating creation. */
-        bucket[file] = timestamp;
-        send_event(event{file, event::what::create, event::kind::file});
-      }
-      /* otherwise, it is already in our bucket. */
-      else {
-        /* we update the file's last write time, */
-        if (bucket[file] != timestamp) {
-          bucket[file] = timestamp;
-          /* and call the closure on them, indicating modification */
-          send_event(event{file, event::what::modify, event::kind::file});
-        }
-      }
-      return true;
-    } /* if the path doesn't exist, we nudge the callee with `false` */
-    else
-      return false;
-  };
+  static auto mergeable(enum ev::what w) noexcept -> bool
+  {
+    return w == ev::what::create || w == ev::what::modify
+        || w == ev::what::destroy;
+  }
 
-  /* @brief watcher/adapter/warthog/scan_directory
-     - Scans a (single) directory for changes.
-     - Updates our bucket to match the changes.
-     - Calls `send_event` when changes happen.
-     - Returns false if the directory cannot be scanned. */
-  auto const& scan_directory = [&](std::filesystem::path const& dir,
-                                   auto const& send_event) -> bool
+  auto ticks(clock::time_point t) const noexcept -> std::uint64_t
   {
-    using std::filesystem::recursive_directory_iterator,
-      std::filesystem::is_directory;
-    /* if this thing is a directory */
-    if (is_directory(dir)) {
-      /* try to iterate through its contents */
-      auto dir_it_ec = std::error_code{};
-      for (auto const& file :
-           recursive_directory_iterator(dir, scan_dir_options, dir_it_ec))
-        /* while handling errors */
-        if (dir_it_ec)
-          return false;
-        else
-          scan_file(file.path(), send_event);
-      return true;
-    }
-    else
-      return false;
-  };
+    return static_cast<std::uint64_t>((t - this->epoch) / this->resolution);
+  }
 
-  return scan_directory(path, send_event) ? true
-       : scan_file(path, send_event)      ? true
-                                          : false;
-};
+  auto let_go(string_type const& p, held const& h) noexcept -> void
+  {
+    this->callback({p, h.what, h.kind, h.when, h.clock, h.root});
+  }
 
-/* @brief wtr/watcher/warthog/tend_bucket
-   If the bucket is empty, try to populate it.
-   otherwise, prune it. */
-inline bool tend_bucket(std::filesystem::path const& path,
-                        auto const& send_event,
-                        bucket_type& bucket) noexcept
-{
-  /*  @brief watcher/adapter/warthog/populate
-      @param path - path to monitor for
-      Creates a file map, the "bucket", from `path`. */
-  auto const& populate = [&](std::filesystem::path const& path) -> bool
+  /*  Sends what has expired. Anything we see from the wheel
+      which we don't hold (anymore), or which was scheduled
+      for a different tick, was already let go. */
+  auto let_go_until(std::uint64_t to) noexcept -> void
   {
-    using std::filesystem::exists, std::filesystem::is_directory,
-      std::filesystem::recursive_directory_iterator,
-      std::filesystem::last_write_time;
-    /* this happens when a path was changed while we were reading it.
-     there is nothing to do here; we prune later. */
-    auto dir_it_ec = std::error_code{};
-    auto lwt_ec = std::error_code{};
-    if (exists(path)) {
-      /* this is a directory */
-      if (is_directory(path)) {
-        for (auto const& file :
-             recursive_directory_iterator(path, scan_dir_options, dir_it_ec)) {
-          if (! dir_it_ec) {
-            auto const& lwt = last_write_time(file, lwt_ec);
-            if (! lwt_ec)
-              bucket[file.path()] = lwt;
-            else
-              /* @todo use this practice elsewhere or make a fn for it
-                 otherwise, this might be confusing and inconsistent. */
-              bucket[file.path()] = last_write_time(path);
-          }
+    this->deadlines.advance(
+      to,
+      [this](std::uint64_t at, string_type&& p)
+      {
+        auto h = this->pending.find(p);
+        if (h != this->pending.end() && h->second.at == at) {
+          this->let_go(h->first, h->second);
+          this->pending.erase(h);
         }
-      }
-      /* this is a file */
-      else {
-        bucket[path] = last_write_time(path);
-      }
-    }
-    else {
-      return false;
-    }
-    return true;
-  };
+      });
+  }
 
-  /*  @brief watcher/adapter/warthog/prune
-      Removes files which no longer exist from our bucket. */
-  auto const& prune = [&](std::filesystem::path const& path,
-                          auto const& send_event) -> bool
+  auto let_go_all() noexcept -> void
   {
-    using namespace ::wtr::watcher;
-    using std::filesystem::exists, std::filesystem::is_regular_file,
-      std::filesystem::is_directory, std::filesystem::is_symlink;
+    this->let_go_until(this->ticks(clock::now()) + this->window_ticks + 1);
+  }
 
-    auto bucket_it = bucket.begin();
-    /* while looking through the bucket's contents, */
-    while (bucket_it != bucket.end()) {
-      /* check if the stuff in our bucket exists anymore. */
-      exists(bucket_it->first)
-        /* if so, move on. */
-        ? std::advance(bucket_it, 1)
-        /* if not, call the closure, indicating destruction,
-           and remove it from our bucket. */
-        : [&]()
-      {
-        send_event(event{bucket_it->first,
-                         event::what::destroy,
-                         is_regular_file(path) ? event::kind::file
-                         : is_directory(path)  ? event::kind::dir
-                         : is_symlink(path)    ? event::kind::sym_link
-                                               : event::kind::other});
-        /* bucket, erase it! */
-        bucket_it = bucket.erase(bucket_it);
-      }();
+public:
+  coalesce(ev::callback const& callback,
+           std::chrono::milliseconds const& window) noexcept
+      : callback{callback},
+        resolution{std::max<clock::duration>(window / 8,
+                                             std::chrono::milliseconds(1))},
+        window_ticks{static_cast<std::uint64_t>(
+          (window + resolution - clock::duration{1}) / resolution)},
+        tick{std::chrono::duration_cast<std::chrono::milliseconds>(
+               resolution),
+             [this]
+             {
+               auto _ = std::scoped_lock{this->lk};
+               this->let_go_until(this->ticks(clock::now()));
+             }}
+  {}
+
+  auto operator()(ev const& e) noexcept -> void
+  {
+    auto _ = std::scoped_lock{this->lk};
+
+    if (e.kind == ev::kind::watcher) {
+      if (e.what == ev::what::destroy) this->let_go_all();
+      return this->callback(e);
     }
-    return true;
-  };
 
-  return bucket.empty() ? populate(path)          ? true
-                        : prune(path, send_event) ? true
-                                                  : false
-                        : true;
-};
+    auto const& p = e.where.native();
+    auto h = this->pending.find(p);
 
-} /* namespace */
+    if (h != this->pending.end()) {
+      if (mergeable(e.what) && h->second.kind == e.kind) {
+        auto merged = merge(h->second.what, e.what);
+        if (merged.has_value())
+          h->second.what = merged.value();
+        else
+          this->pending.erase(h);
+        return;
+      }
+      else {
+        this->let_go(h->first, h->second);
+        this->pending.erase(h);
+      }
+    }
 
-/*
-  @brief watcher/adapter/warthog/watch
+    if (mergeable(e.what)) {
+      auto const at = this->ticks(clock::now()) + this->window_ticks;
+      this->pending.emplace(
+        p,
+        held{e.what, e.kind, e.when, e.clock, e.root, at});
+      this->deadlines.schedule(at, p);
+    }
 
-  @param path:
-   A path to watch for changes.
+    else
+      this->callback(e);
+  }
+};
 
-  @param callback:
-   A callback to perform when the files
-   being watched change.
+} /* namespace stage */
+} /* namespace watcher */
+} /* namespace wtr */
+} /* namespace detail */
 
-  Monitors `path` for changes.
+/*  milliseconds */
+#include <chrono>
+/*  make_shared */
+#include <memory>
+/*  stage::coalesce */
+/*  event
+    callback */
 
-  Calls `callback` with an `event` when they happen.
+namespace wtr {
+inline namespace watcher {
 
-  Unless it should stop, or errors present, `watch` recurses.
-*/
+/*  @brief wtr/watcher/coalesce
 
-inline bool watch(std::filesystem::path const& path,
-                  ::wtr::watcher::event::callback const& callback,
-                  std::function<bool()> const& is_living) noexcept
-{
-  using std::this_thread::sleep_for, std::chrono::milliseconds;
-  /* Sleep for `delay_ms`.
+    Returns a callback which calls `callback` once for
+    a burst of events on the same path.
 
-     Then, keep running if
-       - We are alive
-       - The bucket is doing well
-       - No errors occured while scanning
+    Editors and build tools tend to write to a file a
+    few times in a row. Through `coalesce`, a `create`
+    and a few `modify` events on a path within `window`
+    of each other are one `create` event.
 
-     Otherwise, stop and return false. */
+    Each path's (merged) event is sent `window` after the
+    first event on that path. Events from the watcher are
+    never held back, and everything is let go before the
+    watcher's last event.
 
-  bucket_type bucket;
+    This works with every adapter. It can be stacked
+    with the other stages, such as `collapse`.
 
-  static constexpr auto delay_ms = 16;
+    Typical use looks like this:
 
-  while (is_living()) {
-    if (! tend_bucket(path, callback, bucket)
-        || ! scan(path, callback, bucket)) {
-      callback(
-        {"e/self/die/bad_fs@" + path.string(), evw::destroy, evk::watcher});
+    auto w = watch(".", coalesce([](event const& e) {
+      std::cout << e << std::endl;
+    }));
 
-      return false;
-    }
-    else {
-      if constexpr (delay_ms > 0) sleep_for(milliseconds(delay_ms));
-    }
-  }
+    @param callback:
+      Something to call with the merged events.
 
-  callback({"s/self/die@" + path.string(), evw::destroy, evk::watcher});
+    @param window (optional):
+      How long to wait for more events on the same path. */
+inline auto coalesce(event::callback const& callback,
+                     std::chrono::milliseconds const& window =
+                       std::chrono::milliseconds(50)) noexcept
+  -> event::callback
+{
+  auto self =
+    std::make_shared<::detail::wtr::watcher::stage::coalesce>(callback,
+                                                               window);
 
-  return true;
-}
+  return [self](event const& ev) noexcept { (*self)(ev); };
+};
 
-} /* namespace adapter */
 } /* namespace watcher */
-} /* namespace wtr */
-} /* namespace detail */
-
-#endif /* defined(WATER_WATCHER_PLATFORM_UNKNOWN) \
-          || defined(WATER_WATCHER_USE_WARTHOG) */
+} /* namespace wtr   */
 
+/*  max */
+#include <algorithm>
+/*  milliseconds
+    steady_clock */
+#include <chrono>
+/*  uint32_t
+    uint64_t */
+#include <cstdint>
 /*  path */
 #include <filesystem>
-/*  async
-    future */
-#include <future>
-/*  shared_ptr
-    unique_ptr */
-#include <memory>
+/*  function */
+#include <functional>
 /*  mutex
     scoped_lock */
 #include <mutex>
+/*  optional */
+#include <optional>
+/*  basic_string_view */
+#include <string_view>
 /*  unordered_map */
 #include <unordered_map>
-/*  watch
-    event
+/*  exchange
+    move */
+#include <utility>
+/*  vector */
+#include <vector>
+/*  ticker */
+/*  wheel */
+/*  event
     callback */
 
 namespace detail {
 namespace wtr {
 namespace watcher {
-namespace adapter {
+namespace stage {
+
+/*  @brief wtr/watcher/<d>/stage/atomic_save
+    Folds the ways in which programs save a file "atomically"
+    into one `modify` event for the file which was saved.
+
+    Most programs save by writing a temporary file and then
+    renaming it over the target:
+
+      create  foo.tmp~
+      modify  foo.tmp~
+      rename  foo.tmp~
+      rename  foo        -> modify foo
+
+    Some (such as Vim, by default) move the target aside,
+    write a new one, and then remove the old one:
+
+      rename  foo
+      rename  foo~
+      create  foo
+      modify  foo
+      destroy foo~       -> modify foo
+
+    Whether a path is temporary is up to `is_temp`. Events on
+    temporary paths are held back. A rename is held back until
+    the next event, which is usually its other half.
+
+    Whatever has not turned into a save within `window` is let
+    go as it happened. So is everything, before the watcher's
+    last event. A temporary file which is created and then
+    destroyed within `window` is dropped, as is what happens
+    to a target just after it was saved (such as the `create`
+    some platforms report alongside the rename).
+
+    Kernels which merge the events for a name while they are
+    queued (fanotify) may leave nothing to recognize when the
+    steps of a save happen all at once. Those events are let
+    go as we see them. */
+class atomic_save {
+  using ev = ::wtr::watcher::event;
+  using clock = std::chrono::steady_clock;
+  using string_type = std::filesystem::path::string_type;
 
-struct future {
-  using shared = std::shared_ptr<future>;
+public:
+  using predicate = std::function<bool(std::filesystem::path const&)>;
 
-  mutable std::mutex lk{};
-  std::future<bool> work{};
-  bool closed{false};
-};
+private:
+  struct seen {
+    string_type where;
+    enum ev::what what;
+    enum ev::kind kind;
+    long long when;
+    enum ev::clock clock;
+    std::uint32_t root;
+  };
 
-inline auto open(std::filesystem::path const& path,
-                 ::wtr::watcher::event::callback const& callback) noexcept
-  -> future::shared
-{
-  auto fut = std::make_shared<future>();
+  /*  A temporary file, and what happened to it (and, if it
+      is a backup, what happened to the file it was moved
+      away from). */
+  struct held {
+    std::vector<seen> events;
+    std::uint64_t at;
+    bool created{false};
+    std::optional<string_type> replaces{};
+    bool replaced{false};
+  };
 
-  callback({"s/self/live@" + path.string(),
-            ::wtr::watcher::event::what::create,
-            ::wtr::watcher::event::kind::watcher});
-
-  fut->work = std::async(std::launch::async,
-                         [path, callback, fut]() noexcept -> bool
-                         {
-                           return watch(path,
-                                        callback,
-                                        [fut]() noexcept -> bool
-                                        {
-                                          auto _ = std::scoped_lock{fut->lk};
-                                          return ! fut->closed;
-                                        });
-                         });
+  struct moving {
+    seen from;
+    std::uint64_t at;
+  };
 
-  return fut;
-};
+  std::mutex lk{};
+  ev::callback const callback;
+  predicate const is_temp;
+  clock::time_point const epoch{clock::now()};
+  clock::duration const resolution;
+  std::uint64_t const window_ticks;
+  /*  Temporary paths in flight. */
+  std::unordered_map<string_type, held> temps{};
+  /*  Targets which were moved aside, to their backup. */
+  std::unordered_map<string_type, string_type> backups{};
+  /*  Targets which were just saved, until when. */
+  std::unordered_map<string_type, std::uint64_t> saved{};
+  /*  The first half of a rename. */
+  std::optional<moving> move{};
+  /*  The temporary path we saw last, if it was the last
+      thing we saw. */
+  std::optional<string_type> last_temp{};
+  wheel<string_type> deadlines{};
+  /* Declared last, so that it is stopped first. */
+  ticker tick;
+
+  auto ticks(clock::time_point t) const noexcept -> std::uint64_t
+  {
+    return static_cast<std::uint64_t>((t - this->epoch) / this->resolution);
+  }
 
-inline auto close(future::shared const& fut) noexcept -> bool
-{
-  if (! fut->closed) {
-    {
-      auto _ = std::scoped_lock{fut->lk};
-      fut->closed = true;
-    }
-    return fut->work.get();
+  auto deadline() noexcept -> std::uint64_t
+  {
+    return this->ticks(clock::now()) + this->window_ticks;
   }
 
-  else
-    return false;
-};
+  auto send(seen const& s) noexcept -> void
+  {
+    this->callback({s.where, s.what, s.kind, s.when, s.clock, s.root});
+  }
 
-}  // namespace adapter
-}  // namespace watcher
-}  // namespace wtr
-}  // namespace detail
+  auto send_saved(string_type const& p,
+                  enum ev::kind kind,
+                  long long when,
+                  enum ev::clock clock,
+                  std::uint32_t root) noexcept -> void
+  {
+    auto const at = this->deadline();
+    this->saved.insert_or_assign(p, at);
+    this->deadlines.schedule(at, p);
+    this->callback({p, ev::what::modify, kind, when, clock, root});
+  }
 
-/*  path */
-#include <filesystem>
-/*  function */
-#include <functional>
-/*  is_*,
-    invoke_result */
-#include <type_traits>
-/*  event
-    callback
-    adapter */
+  /*  Ends the life of a temporary path. If it was a backup
+      for a target which came back, the target was saved.
+      Otherwise, what happened is let go as it happened. */
+  auto let_go(std::unordered_map<string_type, held>::iterator h) noexcept
+    -> void
+  {
+    auto& t = h->second;
+    if (t.replaces.has_value()) this->backups.erase(t.replaces.value());
+    if (t.replaces.has_value() && t.replaced)
+      this->send_saved(t.replaces.value(),
+                       t.events.front().kind,
+                       t.events.back().when,
+                       t.events.back().clock,
+                       t.events.back().root);
+    else
+      for (auto const& s : t.events) this->send(s);
+    this->temps.erase(h);
+  }
 
-namespace wtr {
-inline namespace watcher {
+  auto let_go_move() noexcept -> void
+  {
+    if (this->move.has_value()) {
+      auto m = std::move(this->move.value());
+      this->move.reset();
+      auto h = this->temps.find(m.from.where);
+      if (h != this->temps.end()) {
+        h->second.events.push_back(std::move(m.from));
+        this->let_go(h);
+      }
+      else
+        this->send(m.from);
+    }
+  }
 
-/*  Contains a way to stop an instance of `watch()`.
-    This is the structure that we return from there.
-    It is intended to allow the `watch(args).close()`
-    syntax as well as an anonymous `watch(args)()`.
-    We define it up here so that editors can suggest
-    and complete the `.close()` function. Also because
-    we can't template a type inside a function.
+  auto let_go_until(std::uint64_t to) noexcept -> void
+  {
+    this->deadlines.advance(
+      to,
+      [this](std::uint64_t at, string_type&& p)
+      {
+        if (this->move.has_value() && this->move->at == at
+            && this->move->from.where == p)
+          this->let_go_move();
+        if (auto h = this->temps.find(p);
+            h != this->temps.end() && h->second.at == at)
+          this->let_go(h);
+        if (auto s = this->saved.find(p);
+            s != this->saved.end() && s->second == at)
+          this->saved.erase(s);
+      });
+  }
 
-    This thing is similar to an unnamed function object
-    containing a named method. */
+  auto let_go_all() noexcept -> void
+  {
+    this->let_go_move();
+    while (! this->temps.empty()) this->let_go(this->temps.begin());
+    this->saved.clear();
+  }
 
-template<class Fn>
-requires(std::is_nothrow_invocable_v<Fn>
-         and std::is_same_v<std::invoke_result_t<Fn>, bool>)
-struct _ {
-  Fn const close{};
+  /*  Both halves of a rename, from `from` to `to`. */
+  auto renamed(seen&& from, ev const& to) noexcept -> void
+  {
+    auto const& p = to.where.native();
+
+    /* A temporary file became the target. */
+    if (auto h = this->temps.find(from.where); h != this->temps.end()) {
+      if (h->second.replaces.has_value())
+        this->backups.erase(h->second.replaces.value());
+      this->temps.erase(h);
+      this->send_saved(p, to.kind, to.when, to.clock, to.root);
+    }
+    else if (this->is_temp(from.where))
+      this->send_saved(p, to.kind, to.when, to.clock, to.root);
+
+    /* The target was moved aside, to a backup. */
+    else if (this->is_temp(to.where) && ! this->backups.contains(from.where)) {
+      auto const at = this->deadline();
+      auto t = held{
+        {std::move(from), {p, to.what, to.kind, to.when, to.clock, to.root}},
+        at};
+      t.replaces = t.events.front().where;
+      /* Something else was moved here before. Whatever it
+         was, it isn't coming back as a save. */
+      if (auto h = this->temps.find(p); h != this->temps.end())
+        this->let_go(h);
+      this->backups.insert_or_assign(t.events.front().where, p);
+      this->temps.emplace(p, std::move(t));
+      this->deadlines.schedule(at, p);
+    }
 
-  inline constexpr auto operator()() const noexcept -> bool
+    else {
+      this->send(from);
+      this->callback(to);
+    }
+  }
+
+public:
+  atomic_save(ev::callback const& callback,
+              std::chrono::milliseconds const& window,
+              predicate const& is_temp) noexcept
+      : callback{callback},
+        is_temp{is_temp},
+        resolution{std::max<clock::duration>(window / 8,
+                                             std::chrono::milliseconds(1))},
+        window_ticks{static_cast<std::uint64_t>(
+          (window + resolution - clock::duration{1}) / resolution)},
+        tick{std::chrono::duration_cast<std::chrono::milliseconds>(
+               resolution),
+             [this]
+             {
+               auto _ = std::scoped_lock{this->lk};
+               this->let_go_until(this->ticks(clock::now()));
+             }}
+  {}
+
+  /*  Names which editors, downloaders, version control and
+      configuration management tools commonly write to
+      before renaming into place. */
+  static auto looks_temporary(std::filesystem::path const& p) noexcept -> bool
   {
-    return this->close();
-  };
+    using view_type =
+      std::basic_string_view<std::filesystem::path::value_type>;
+    auto const& s = p.native();
+    auto const sep = s.rfind(std::filesystem::path::preferred_separator);
+    auto const name =
+      view_type{s}.substr(sep == string_type::npos ? 0 : sep + 1);
+    auto const is = [name](char const* ascii) noexcept -> bool
+    {
+      auto i = std::size_t{0};
+      for (; ascii[i] != 0; ++i)
+        if (i >= name.size() || name[i] != ascii[i]) return false;
+      return i == name.size();
+    };
+    auto const starts = [name](char const* ascii) noexcept -> bool
+    {
+      for (auto i = std::size_t{0}; ascii[i] != 0; ++i)
+        if (i >= name.size() || name[i] != ascii[i]) return false;
+      return true;
+    };
+    auto const ends = [name](char const* ascii) noexcept -> bool
+    {
+      auto n = std::char_traits<char>::length(ascii);
+      if (n > name.size()) return false;
+      for (auto i = std::size_t{0}; i < n; ++i)
+        if (name[name.size() - n + i] != ascii[i]) return false;
+      return true;
+    };
+    auto const has = [name](char const* ascii) noexcept -> bool
+    {
+      auto n = std::char_traits<char>::length(ascii);
+      for (auto at = std::size_t{0}; at + n <= name.size(); ++at) {
+        auto i = std::size_t{0};
+        while (i < n && name[at + i] == ascii[i]) ++i;
+        if (i == n) return true;
+      }
+      return false;
+    };
+    return ends("~") || ends(".swp") || ends(".swx") || ends(".tmp")
+        || ends(".temp") || ends(".part") || has(".tmp.")
+        || starts(".#") || starts(".~") || starts(".goutputstream-")
+        || starts("tmp_obj_") || is("4913");
+  }
 
-  inline constexpr _(Fn&& fn) noexcept
-      : close{std::forward<Fn>(fn)} {};
+  auto operator()(ev const& e) noexcept -> void
+  {
+    auto _ = std::scoped_lock{this->lk};
 
-  inline constexpr ~_() = default;
-};
+    if (e.kind == ev::kind::watcher) {
+      if (e.what == ev::what::destroy) this->let_go_all();
+      return this->callback(e);
+    }
 
-/*  @brief wtr/watcher/watch
+    auto const& p = e.where.native();
+    auto after = std::exchange(this->last_temp, std::nullopt);
 
-    Returns an asyncronous filesystem watcher as a function
-    object. Calling the function object with `()` or `.close()`
-    will stop the watcher.
+    if (this->move.has_value()) {
+      if (e.what == ev::what::rename && this->move->from.where != p) {
+        auto from = std::move(this->move->from);
+        this->move.reset();
+        return this->renamed(std::move(from), e);
+      }
+      this->let_go_move();
+    }
 
-    Closing the watcher is the only blocking operation.
+    /* Echoes of a save, such as the target's `create`. */
+    if (auto s = this->saved.find(p); s != this->saved.end()) {
+      if (e.what == ev::what::create || e.what == ev::what::modify) return;
+      this->saved.erase(s);
+    }
 
-    @param path:
-      The root path to watch for filesystem events.
+    /* The target of a backup came back. */
+    if (auto b = this->backups.find(p); b != this->backups.end()) {
+      auto h = this->temps.find(b->second);
+      if (h == this->temps.end())
+        this->backups.erase(b);
+      else if (e.what == ev::what::create || e.what == ev::what::modify) {
+        h->second.replaced = true;
+        return;
+      }
+      else
+        this->let_go(h);
+    }
 
-    @param living_cb (optional):
-      Something (such as a closure) to be called when events
-      occur in the path being watched.
+    /* Some kernels merge the first half of a rename into the
+       temporary path's `create`. A rename which comes right
+       after a temporary path (and isn't of that path) is the
+       second half. */
+    if (e.what == ev::what::rename && after.has_value() && after != p) {
+      auto h = this->temps.find(after.value());
+      if (h != this->temps.end() && ! h->second.replaces.has_value()) {
+        this->temps.erase(h);
+        return this->send_saved(p, e.kind, e.when, e.clock, e.root);
+      }
+    }
 
-    This is an adaptor "switch" that chooses the ideal adaptor
-    for the host platform.
+    if (e.what == ev::what::rename) {
+      auto const at = this->deadline();
+      this->move = moving{{p, e.what, e.kind, e.when, e.clock, e.root}, at};
+      return this->deadlines.schedule(at, p);
+    }
 
-    Every adapter monitors `path` for changes and invokes the
-    `callback` with an `event` object when they occur.
+    auto h = this->temps.find(p);
+    if (h == this->temps.end()) {
+      if (e.what == ev::what::destroy || ! this->is_temp(e.where))
+        return this->callback(e);
+      auto const at = this->deadline();
+      h = this->temps.emplace(p, held{{}, at}).first;
+      this->deadlines.schedule(at, p);
+    }
 
-    There are two things the user needs:
-      - The `watch` function
-      - The `event` object
+    auto& t = h->second;
 
-    The watch function returns a function to stop its watcher.
+    if (e.what == ev::what::destroy) {
+      if (t.replaces.has_value() || ! t.created) {
+        t.events.push_back({p, e.what, e.kind, e.when, e.clock, e.root});
+        this->let_go(h);
+      }
+      else
+        this->temps.erase(h);
+      return;
+    }
 
-    Typical use looks like this:
+    this->last_temp = p;
+    if (e.what == ev::what::create) t.created = true;
+    if (t.events.empty() || t.events.back().what != e.what
+        || t.events.back().kind != e.kind)
+      t.events.push_back({p, e.what, e.kind, e.when, e.clock, e.root});
+  }
+};
 
-    auto w = watch(".", [](event const& e) {
-      std::cout
-        << "where: " << e.where << "\n"
-        << "kind: "  << e.kind  << "\n"
-        << "what: "  << e.what  << "\n"
-        << "when: "  << e.when  << "\n"
-        << std::endl;
-    };
-    auto dead = w.close(); // w() also works
+} /* namespace stage */
+} /* namespace watcher */
+} /* namespace wtr */
+} /* namespace detail */
 
-    That's it.
+/*  milliseconds */
+#include <chrono>
+/*  make_shared */
+#include <memory>
+/*  stage::atomic_save */
+/*  event
+    callback */
 
-    Happy hacking. */
+namespace wtr {
+inline namespace watcher {
 
-[[nodiscard("Returns a way to stop this watcher, for example: "
-            "auto w = watch(p, cb) ; w.close() // or w();")]]
+/*  @brief wtr/watcher/atomic_save
 
-inline auto
-watch(std::filesystem::path const& path,
-      event::callback const& callback) noexcept
+    Returns a callback which calls `callback` once, with a
+    `modify` event, when a file is saved "atomically".
+
+    Editors and configuration management tools tend to
+    save a file by writing a temporary file and renaming
+    it over the original, or by moving the original aside
+    and writing a new one. That is three to five events,
+    most of them for a path nobody cares about. Through
+    `atomic_save`, it is one `modify` event for the file
+    which was saved.
+
+    Events for temporary paths, and renames, are held back
+    for up to `window`. If they don't turn out to be part of
+    a save, they are let go as they happened. Events from
+    the watcher are never held back, and everything is let
+    go before the watcher's last event.
+
+    Typical use looks like this:
+
+    auto w = watch(".", atomic_save([](event const& e) {
+      if (e.what == event::what::modify) reload(e.where);
+    }));
+
+    @param callback:
+      Something to call with the events.
+
+    @param window (optional):
+      How long a save may take.
+
+    @param is_temp (optional):
+      Whether a path is temporary. By default, names such
+      as `foo~`, `foo.tmp`, `.foo.swp` and `.#foo` are. */
+inline auto atomic_save(
+  event::callback const& callback,
+  std::chrono::milliseconds const& window = std::chrono::milliseconds(100),
+  ::detail::wtr::watcher::stage::atomic_save::predicate const& is_temp =
+    ::detail::wtr::watcher::stage::atomic_save::looks_temporary) noexcept
+  -> event::callback
 {
-  using namespace ::detail::wtr::watcher::adapter;
+  auto self =
+    std::make_shared<::detail::wtr::watcher::stage::atomic_save>(callback,
+                                                                  window,
+                                                                  is_temp);
 
-  return _{[adapter{open(path, callback)}]() noexcept -> bool
-           { return close(adapter); }};
+  return [self](event const& ev) noexcept { (*self)(ev); };
 };
 
 } /* namespace watcher */
@@ -0,0 +1,153 @@
+/*  milliseconds,
+    steady_clock,
+    duration_cast */
+#include <chrono>
+/*  cout,
+    endl */
+#include <iostream>
+/*  string */
+#include <string>
+/*  vector */
+#include <vector>
+/*  REQUIRE,
+    TEST_CASE */
+#include <snitch/snitch.hpp>
+/*  watch,
+    event,
+    filter,
+    inotify::do_event_recv,
+    roots_type,
+    to_sink */
+#include <wtr/watcher.hpp>
+
+#if defined(WATER_WATCHER_ADAPTER_LINUX_INOTIFY)
+
+/*  pipe2,
+    write,
+    close */
+#include <unistd.h>
+/*  O_NONBLOCK */
+#include <fcntl.h>
+/*  memcpy */
+#include <cstring>
+/*  uint32_t */
+#include <cstdint>
+
+/*  A page of `inotify_event`s, as the kernel would give
+    them to us, for names in one watched directory. */
+auto synthetic_events() -> std::vector<char>
+{
+  auto buf = std::vector<char>{};
+  for (auto i = 0;; ++i) {
+    auto const name = "file_" + std::to_string(i) + ".txt";
+    auto const len = (name.size() + 1 + 15) / 16 * 16;
+    if (buf.size() + sizeof(inotify_event) + len > 4096) break;
+    auto ev = inotify_event{};
+    ev.wd = 1;
+    ev.mask = IN_MODIFY;
+    ev.len = static_cast<std::uint32_t>(len);
+    auto const at = buf.size();
+    buf.resize(at + sizeof(inotify_event) + len, '\0');
+    std::memcpy(buf.data() + at, &ev, sizeof(inotify_event));
+    std::memcpy(buf.data() + at + sizeof(inotify_event),
+                name.data(),
+                name.size());
+  }
+  return buf;
+}
+
+/*  Feeds `rounds` pages of events through the inotify
+    adapter's reading loop, from a pipe, to `sink`. Returns
+    how long that took. */
+template<class Sink>
+auto through_inotify(Sink const& sink, int rounds) -> std::chrono::nanoseconds
+{
+  namespace in = ::detail::wtr::watcher::adapter::inotify;
+  using clock = std::chrono::steady_clock;
+
+  int fds[2];
+  if (pipe2(fds, O_NONBLOCK) != 0) return {};
+
+  auto const page = synthetic_events();
+  auto sr = in::sys_resource_type{.valid = true,
+                                  .watch_fd = fds[0],
+                                  .event_fd = -1,
+                                  .event_conf = {}};
+  auto pm = in::path_map_type{};
+  pm[1] = in::watched_dir{"/some/watched/directory", {}};
+  auto where = std::string{};
+  auto roots = ::detail::wtr::watcher::adapter::roots_type{{"/some"}};
+
+  auto took = clock::duration{};
+  for (auto r = 0; r < rounds; ++r) {
+    if (write(fds[1], page.data(), page.size()) < 0) break;
+    auto const then = clock::now();
+    in::do_event_recv(sr, pm, where, roots, sink);
+    took += clock::now() - then;
+  }
+
+  close(fds[0]);
+  close(fds[1]);
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(took);
+}
+
+/*  Compares a callback which is called through a
+    `std::function` (as `event::callback` is) with the same
+    callback given to the adapter as itself, through the
+    loop which reads events. */
+TEST_CASE("Bench Dispatch", "[bench_dispatch]")
+{
+  using namespace ::wtr::watcher;
+  using ::detail::wtr::watcher::adapter::to_sink;
+
+  static constexpr auto round_count = 1 << 14;
+
+  static auto seen_erased = 0ull;
+  static auto seen_static = 0ull;
+
+  auto const count_erased = [](event::compact const& e)
+  { seen_erased += e.where.size(); };
+  auto const count_static = [](event::compact const& e)
+  { seen_static += e.where.size(); };
+
+  auto const erased_callback = event::compact::callback{count_erased};
+  auto const erased_sink = to_sink(erased_callback);
+  auto const static_sink = to_sink(count_static);
+
+  /* Warm up, so that neither goes first. */
+  through_inotify(erased_sink, round_count / 16);
+  through_inotify(static_sink, round_count / 16);
+  seen_erased = seen_static = 0;
+
+  auto const erased = through_inotify(erased_sink, round_count);
+  auto const direct = through_inotify(static_sink, round_count);
+
+  auto const events = [] {
+    auto n = 0ull;
+    auto const page = synthetic_events();
+    for (auto at = page.data(); at < page.data() + page.size();
+         at += sizeof(inotify_event) + ((inotify_event const*)at)->len)
+      ++n;
+    return n * round_count;
+  }();
+
+  auto const per_second = [](auto count, auto took)
+  { return took.count() > 0 ? double(count) * 1e9 / took.count() : 0.0; };
+
+  std::cout << "std::function: " << events
+            << " events/sec: " << per_second(events, erased) << std::endl
+            << "static: " << events
+            << " events/sec: " << per_second(events, direct) << std::endl;
+
+  REQUIRE(seen_erased > 0);
+  REQUIRE(seen_erased == seen_static);
+};
+
+#else
+
+TEST_CASE("Bench Dispatch", "[bench_dispatch]")
+{
+  std::cout << "Only the inotify adapter is measured." << std::endl;
+};
+
+#endif
@@ -0,0 +1,96 @@
+/*  milliseconds,
+    steady_clock,
+    duration_cast */
+#include <chrono>
+/*  cout,
+    endl */
+#include <iostream>
+/*  string */
+#include <string>
+/*  vector */
+#include <vector>
+/*  REQUIRE,
+    TEST_CASE */
+#include <snitch/snitch.hpp>
+/*  filter,
+    event */
+#include <wtr/watcher.hpp>
+
+/*  Paths shaped like a source tree: a few directories
+    deep, with names that the patterns below sometimes
+    match, sometimes almost match, and usually don't. */
+auto synthetic_paths(int count) -> std::vector<std::string>
+{
+  static char const* const dirs[] =
+    {"src", "include", "build", "node_modules", ".git", "test", "docs", "lib"};
+  static char const* const exts[] =
+    {".cpp", ".hpp", ".o", ".d", ".md", ".txt", ".json", ".log"};
+
+  auto paths = std::vector<std::string>{};
+  paths.reserve(static_cast<std::size_t>(count));
+  for (auto i = 0; i < count; ++i) {
+    auto p = std::string{};
+    for (auto d = 0; d < 1 + i % 5; ++d)
+      p += std::string{dirs[(i * 7 + d * 3) % 8]} + "/";
+    p += "file_" + std::to_string(i) + exts[(i * 5) % 8];
+    paths.push_back(std::move(p));
+  }
+  return paths;
+}
+
+/*  Walks whole paths from the root, and then only names
+    from a directory's (kept) state, which is what the
+    adapters do. */
+TEST_CASE("Bench Filter", "[bench_filter]")
+{
+  using namespace ::wtr::watcher;
+  using clock = std::chrono::steady_clock;
+
+  static constexpr auto path_count = 1 << 16;
+  static constexpr auto round_count = 32;
+
+  auto const paths = synthetic_paths(path_count);
+
+  auto f = filter{"*.cpp",
+                  "*.hpp",
+                  "docs/**/*.md",
+                  "!build/",
+                  "!node_modules/",
+                  "!.git/",
+                  "![Tt]est/**/*_[0-9].cpp"};
+
+  auto kept = 0ull;
+  auto then = clock::now();
+  for (auto r = 0; r < round_count; ++r)
+    for (auto const& p : paths) kept += f.keeps(p, event::kind::file);
+  auto const whole = clock::now() - then;
+
+  auto const dir = f.walk(f.start(), "src/include/");
+  auto names = std::vector<std::string>{};
+  for (auto const& p : paths) names.push_back(p.substr(p.rfind('/') + 1));
+
+  auto kept_names = 0ull;
+  then = clock::now();
+  for (auto r = 0; r < round_count; ++r)
+    for (auto const& n : names)
+      kept_names += f.keeps(f.walk(dir, n), event::kind::file);
+  auto const named = clock::now() - then;
+
+  auto const per_second = [](auto matches, auto took)
+  {
+    auto const ns =
+      std::chrono::duration_cast<std::chrono::nanoseconds>(took).count();
+    return ns > 0 ? static_cast<double>(matches) * 1e9 / ns : 0.0;
+  };
+
+  auto const matches = 1ull * path_count * round_count;
+
+  std::cout << "paths: " << matches << " matches/sec: "
+            << per_second(matches, whole) << std::endl
+            << "names: " << matches << " matches/sec: "
+            << per_second(matches, named) << std::endl;
+
+  REQUIRE(kept > 0);
+  REQUIRE(kept < matches);
+  REQUIRE(kept_names > 0);
+};
@@ -0,0 +1,245 @@
+/*  nanoseconds,
+    milliseconds,
+    steady_clock,
+    duration_cast */
+#include <chrono>
+/*  cout,
+    endl */
+#include <iostream>
+/*  ofstream */
+#include <fstream>
+/*  setw,
+    setprecision */
+#include <iomanip>
+/*  string */
+#include <string>
+/*  string_view */
+#include <string_view>
+/*  from_chars */
+#include <charconv>
+/*  sort */
+#include <algorithm>
+/*  thread */
+#include <thread>
+/*  atomic */
+#include <atomic>
+/*  unique_ptr */
+#include <memory>
+/*  vector */
+#include <vector>
+/*  path,
+    create_directories,
+    remove_all */
+#include <filesystem>
+/*  REQUIRE,
+    TEST_CASE */
+#include <snitch/snitch.hpp>
+/*  event,
+    policy */
+#include <wtr/watcher.hpp>
+/*  test_store_path,
+    adapter_names,
+    adapter_run */
+#include <test_watcher/test_watcher.hpp>
+
+using namespace ::wtr::test_watcher;
+
+inline auto steady_ns() noexcept -> long long
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+           std::chrono::steady_clock::now().time_since_epoch())
+    .count();
+}
+
+/*  A watcher which wakes up more often, and takes more from
+    each call to `epoll_wait`. Events don't wait for the
+    Linux adapters to wake up, so only the polling adapter
+    should be quicker. */
+struct prompt : ::wtr::watcher::policy {
+  static constexpr auto delay_ms = 1;
+  static constexpr auto wait_max = 16;
+};
+
+/*  The time each file was made, by its name (a number), and
+    how long after that its creation reached the callback.
+    Only the callback's thread writes `latency_ns`. */
+struct timeline {
+  std::unique_ptr<std::atomic<long long>[]> made_at;
+  std::size_t capacity;
+  std::atomic<std::size_t> made{0};
+
+  auto made_count() const noexcept -> std::size_t
+  {
+    return std::min(this->made.load(), this->capacity);
+  }
+  std::vector<long long> latency_ns{};
+
+  explicit timeline(std::size_t capacity)
+      : made_at{new std::atomic<long long>[capacity]},
+        capacity{capacity}
+  {
+    this->latency_ns.reserve(capacity);
+  }
+
+  auto seen(::wtr::watcher::event::compact const& e) noexcept -> void
+  {
+    using ::wtr::watcher::event;
+    auto const now = steady_ns();
+    if (e.what != event::what::create || e.kind != event::kind::file) return;
+    auto const name = e.where.substr(e.where.rfind('/') + 1);
+    auto id = std::size_t{};
+    auto const [_, ec] = std::from_chars(name.data(), name.data() + name.size(), id);
+    if (ec != std::errc{} || id >= this->capacity) return;
+    this->latency_ns.push_back(now - this->made_at[id].load());
+  }
+
+  /* The latency at `q` (from 0 to 1), in microseconds. */
+  auto at(double q) const -> double
+  {
+    if (this->latency_ns.empty()) return 0;
+    auto const n = (std::size_t)(q * double(this->latency_ns.size() - 1));
+    return double(this->latency_ns[n]) / 1e3;
+  }
+};
+
+/*  Makes files, each named by a number, in `store`, from
+    `thread_count` threads, at `rate` files per second
+    (shared between them; 0 is as fast as we can) for
+    `for_how_long`. Each file's time is kept before it is
+    made. */
+auto generate(std::filesystem::path const& store,
+              timeline& tl,
+              int thread_count,
+              double rate,
+              std::chrono::milliseconds for_how_long) -> void
+{
+  using clock = std::chrono::steady_clock;
+
+  auto const began = clock::now();
+  auto const until = began + for_how_long;
+
+  auto threads = std::vector<std::thread>{};
+  for (auto t = 0; t < thread_count; ++t)
+    threads.emplace_back(
+      [&, t]()
+      {
+        auto const interval = rate > 0
+                              ? std::chrono::duration<double>(thread_count / rate)
+                              : std::chrono::duration<double>(0);
+        for (auto k = 0ull;; ++k) {
+          auto const now = clock::now();
+          if (now >= until) break;
+          if (rate > 0) {
+            auto const due =
+              began
+              + std::chrono::duration_cast<clock::duration>(
+                interval * (double)k + interval * (double)t / thread_count);
+            if (due >= until) break;
+            if (due > now) std::this_thread::sleep_until(due);
+          }
+          /* Claim a name, then keep its time before it is
+             made, so that it is there before the event is. */
+          auto const id = tl.made.fetch_add(1);
+          if (id >= tl.capacity) break;
+          tl.made_at[id] = steady_ns();
+          std::ofstream{store / std::to_string(id)};
+        }
+      });
+  for (auto& t : threads) t.join();
+}
+
+/*  For each adapter we can run here, with the default
+    policy and one which waits less, the time from making a
+    file to its creation reaching the callback, at the median,
+    99th and 99.9th percentiles and at worst, when the
+    watcher is idle, moderately busy and saturated.
+
+    Events are stamped, and the adapters are woken, when
+    they happen. The polling adapter only sees them when it
+    scans, every `delay_ms`. */
+TEST_CASE("Bench Latency", "[bench_latency]")
+{
+  namespace fs = ::std::filesystem;
+  using namespace ::wtr::watcher;
+
+  struct load {
+    char const* name;
+    double rate;
+    int thread_count;
+    std::chrono::milliseconds for_how_long;
+  };
+
+  static constexpr load loads[] = {
+    {"idle",      20,     1, std::chrono::milliseconds(2000)},
+    {"moderate",  2'000,  2, std::chrono::milliseconds(1000)},
+    {"saturated", 0,      4, std::chrono::milliseconds(1000)},
+  };
+  static constexpr std::size_t most_files = 1 << 20;
+
+  auto const store = test_store_path / "bench_latency_store";
+
+  auto const row = [](auto const& name, auto const&... cols)
+  {
+    std::cout << std::left << std::setw(10) << name << std::right;
+    ((std::cout << std::setw(12) << cols), ...);
+    std::cout << std::endl;
+  };
+
+  std::cout << std::fixed << std::setprecision(1);
+  row("adapter",
+      "policy",
+      "load",
+      "events",
+      "p50 us",
+      "p99 us",
+      "p999 us",
+      "max us");
+
+  auto matched_all = true;
+
+  auto const measure = [&]<class Policy>(std::string_view adapter,
+                                         char const* policy_name,
+                                         load const& l)
+  {
+    fs::create_directories(store);
+    /* The polling adapter is ready once it sees a file. */
+    std::ofstream{store / "seed.txt"};
+
+    auto tl = timeline{most_files};
+    auto const seen = [&tl](event::compact const& e) noexcept { tl.seen(e); };
+    auto run = adapter_run<decltype(seen), Policy>{adapter, store, seen};
+    REQUIRE(run.ready());
+    /* Let the polling adapter take in what is already there. */
+    std::this_thread::sleep_for(std::chrono::milliseconds(4 * Policy::delay_ms));
+
+    generate(store, tl, l.thread_count, l.rate, l.for_how_long);
+    run.settle();
+    run.close();
+
+    std::sort(tl.latency_ns.begin(), tl.latency_ns.end());
+    if (l.rate > 0 && adapter != "warthog"
+        && tl.latency_ns.size() != tl.made_count())
+      matched_all = false;
+
+    row(adapter,
+        policy_name,
+        l.name,
+        tl.latency_ns.size(),
+        tl.at(0.5),
+        tl.at(0.99),
+        tl.at(0.999),
+        tl.at(1.0));
+
+    fs::remove_all(store);
+  };
+
+  for (auto const adapter : adapter_names())
+    for (auto const& l : loads) {
+      measure.operator()<policy>(adapter, "default", l);
+      measure.operator()<prompt>(adapter, "prompt", l);
+    }
+
+  fs::remove_all(test_store_path);
+
+  REQUIRE(matched_all);
+};
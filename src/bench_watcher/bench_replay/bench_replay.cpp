@@ -0,0 +1,174 @@
+/*  milliseconds,
+    steady_clock,
+    duration */
+#include <chrono>
+/*  getenv */
+#include <cstdlib>
+/*  fopen,
+    fclose */
+#include <cstdio>
+/*  cout,
+    endl */
+#include <iostream>
+/*  ofstream */
+#include <fstream>
+/*  setw,
+    setprecision */
+#include <iomanip>
+/*  string */
+#include <string>
+/*  thread */
+#include <thread>
+/*  path,
+    create_directories,
+    remove,
+    remove_all */
+#include <filesystem>
+/*  REQUIRE,
+    TEST_CASE */
+#include <snitch/snitch.hpp>
+/*  event,
+    policy,
+    metrics,
+    watch,
+    record,
+    recording,
+    play */
+#include <wtr/watcher.hpp>
+/*  test_store_path */
+#include <test_watcher/test_watcher.hpp>
+
+#if defined(__linux__) && ! defined(WATER_WATCHER_USE_WARTHOG)
+
+/*  getpid */
+#include <unistd.h>
+
+namespace adapter = ::detail::wtr::watcher::adapter;
+
+struct recorded : ::wtr::watcher::policy {
+  using sys = adapter::record;
+};
+
+/*  Watches `store` and records what the kernel says while
+    `file_count` files are made, written to, renamed and
+    removed there, and in directories made as we go. */
+auto record_session(std::filesystem::path const& store,
+                    std::filesystem::path const& to,
+                    int file_count) -> bool
+{
+  namespace fs = ::std::filesystem;
+  using namespace ::wtr::watcher;
+
+  fs::create_directories(store);
+  adapter::record::to = std::fopen(to.c_str(), "wb");
+  if (! adapter::record::to) return false;
+
+  auto w = watch<recorded>(store, [](event const&) noexcept {});
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+  for (auto i = 0; i < file_count; ++i) {
+    auto const dir = store / ("d" + std::to_string(i / 100));
+    if (i % 100 == 0) fs::create_directory(dir);
+    auto const file = dir / std::to_string(i);
+    std::ofstream{file} << "x";
+    if (i % 2 == 0) fs::rename(file, dir / ("r" + std::to_string(i)));
+    else fs::remove(file);
+  }
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(300));
+  auto const ok = w.close();
+  std::fclose(adapter::record::to);
+  adapter::record::to = nullptr;
+  fs::remove_all(store);
+  return ok;
+}
+
+/*  Plays a recording back through the adapter which made
+    it, over and over, without the kernel, and reports how
+    fast we decode, put paths together and send what it
+    holds. The same recording gives the same events each
+    time, so runs (and changes) can be compared exactly.
+
+    With `WTR_BENCH_TRACE` set to a file which exists, that
+    recording is played. If it doesn't exist, a session is
+    recorded there first, to be played again later. */
+TEST_CASE("Bench Replay", "[bench_replay]")
+{
+  namespace fs = ::std::filesystem;
+  using namespace ::wtr::watcher;
+  using namespace ::wtr::test_watcher;
+  using clock = std::chrono::steady_clock;
+
+  static constexpr auto file_count = 20'000;
+  static constexpr auto min_plays = 5;
+  static constexpr auto for_at_least = std::chrono::milliseconds(1000);
+
+  auto const given = std::getenv("WTR_BENCH_TRACE");
+  auto const rec_path =
+    given ? fs::path{given}
+          : fs::temp_directory_path()
+              / ("wtr_bench_replay." + std::to_string(getpid()) + ".rec");
+
+  if (! fs::exists(rec_path))
+    REQUIRE(record_session(test_store_path / "bench_replay_store",
+                           rec_path,
+                           file_count));
+
+  auto const rec = adapter::recording::load(rec_path);
+  if (! given) fs::remove(rec_path);
+  fs::remove_all(test_store_path);
+
+  auto bytes = 0ull;
+  auto reads = 0ull;
+  for (auto const& e : rec.entries)
+    if (e.type == adapter::recording::type::read) {
+      bytes += e.bytes.size();
+      reads += 1;
+    }
+
+  std::cout << "recording: " << rec_path.string() << "\n"
+            << "from: " << (rec.from_inotify() ? "inotify" : "fanotify")
+            << "\n"
+            << "entries: " << rec.entries.size() << "\n"
+            << "reads: " << reads << "\n"
+            << "bytes: " << bytes << std::endl;
+
+  REQUIRE(reads > 0);
+
+  auto events = 0ull;
+  auto const each = [&events](event::compact const&) noexcept { ++events; };
+
+  auto plays = 0;
+  auto first_events = 0ull;
+  auto deterministic = true;
+  auto const began = clock::now();
+  while (plays < min_plays || clock::now() - began < for_at_least) {
+    events = 0;
+    REQUIRE(adapter::play(rec, each));
+    if (plays++ == 0) first_events = events;
+    else if (events != first_events) deterministic = false;
+  }
+  auto const seconds =
+    std::chrono::duration<double>(clock::now() - began).count();
+  auto const total = double(first_events) * plays;
+
+  std::cout << std::fixed << std::setprecision(1)
+            << "plays: " << plays << "\n"
+            << "events per play: " << first_events << "\n"
+            << "events/s: " << total / seconds << "\n"
+            << "ns/event: " << seconds * 1e9 / total << "\n"
+            << "MB/s read: " << double(bytes) * plays / seconds / 1e6
+            << std::endl;
+
+  REQUIRE(first_events > 0);
+  REQUIRE(deterministic);
+};
+
+#else
+
+TEST_CASE("Bench Replay", "[bench_replay]")
+{
+  std::cout << "Bench Replay: only the Linux adapters record" << std::endl;
+};
+
+#endif
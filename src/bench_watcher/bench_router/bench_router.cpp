@@ -0,0 +1,86 @@
+/*  milliseconds,
+    steady_clock,
+    duration_cast */
+#include <chrono>
+/*  size_t */
+#include <cstddef>
+/*  cout,
+    endl */
+#include <iostream>
+/*  string */
+#include <string>
+/*  vector */
+#include <vector>
+/*  REQUIRE,
+    TEST_CASE */
+#include <snitch/snitch.hpp>
+/*  router,
+    event */
+#include <wtr/watcher.hpp>
+
+/*  The directory each subscriber watches: one of many,
+    three levels beneath `/srv`. */
+auto subscribed_path(int i) -> std::string
+{
+  return "/srv/" + std::to_string(i % 16) + "/" + std::to_string(i % 256)
+       + "/" + std::to_string(i);
+}
+
+/*  Routes the same events through a router with more and
+    more subscribers, and (for comparison) through a list
+    of them, each of which is asked whether it wants it, as
+    a watcher with many callbacks would. Each event is for
+    one subscriber, five levels down. */
+TEST_CASE("Bench Router", "[bench_router]")
+{
+  using namespace ::wtr::watcher;
+  using clock = std::chrono::steady_clock;
+
+  static constexpr auto event_count = 1 << 16;
+
+  auto const per_second = [](auto count, auto took)
+  {
+    auto const ns =
+      std::chrono::duration_cast<std::chrono::nanoseconds>(took).count();
+    return ns > 0 ? static_cast<double>(count) * 1e9 / ns : 0.0;
+  };
+
+  for (auto const subscribers : {1, 100, 10'000}) {
+    auto sent = std::size_t{0};
+    auto const each = [&](event::compact const&) { ++sent; };
+
+    auto r = router{};
+    auto paths = std::vector<std::string>{};
+    for (auto i = 0; i < subscribers; ++i) {
+      paths.push_back(subscribed_path(i));
+      r.subscribe(paths.back(), each);
+    }
+
+    auto wheres = std::vector<std::string>{};
+    for (auto i = 0; i < event_count; ++i)
+      wheres.push_back(subscribed_path(i % subscribers) + "/d/file_"
+                       + std::to_string(i));
+
+    auto then = clock::now();
+    for (auto const& w : wheres) r({w, event::what::modify, event::kind::file});
+    auto const routed = clock::now() - then;
+    auto const routed_sent = sent;
+
+    sent = 0;
+    then = clock::now();
+    for (auto const& w : wheres) {
+      auto const e = event::compact{w, event::what::modify, event::kind::file};
+      for (auto const& p : paths)
+        if (e.where.starts_with(p) && e.where[p.size()] == '/') each(e);
+    }
+    auto const scanned = clock::now() - then;
+
+    std::cout << "subscribers: " << subscribers
+              << " routed events/sec: " << per_second(event_count, routed)
+              << " scanned events/sec: " << per_second(event_count, scanned)
+              << std::endl;
+
+    REQUIRE(routed_sent == event_count);
+    REQUIRE(sent == event_count);
+  }
+};
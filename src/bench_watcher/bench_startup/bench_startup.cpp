@@ -0,0 +1,192 @@
+/*  milliseconds,
+    steady_clock,
+    duration */
+#include <chrono>
+/*  cout,
+    endl */
+#include <iostream>
+/*  ifstream */
+#include <fstream>
+/*  setw,
+    setprecision */
+#include <iomanip>
+/*  getenv */
+#include <cstdlib>
+/*  string,
+    stoul,
+    getline */
+#include <string>
+/*  string_view */
+#include <string_view>
+/*  vector */
+#include <vector>
+/*  path,
+    temp_directory_path,
+    create_directory,
+    remove_all */
+#include <filesystem>
+/*  REQUIRE,
+    TEST_CASE */
+#include <snitch/snitch.hpp>
+/*  event */
+#include <wtr/watcher.hpp>
+/*  adapter_names,
+    adapter_run */
+#include <test_watcher/test_watcher.hpp>
+
+#if defined(__GLIBC__)
+/*  mallinfo2 */
+#include <malloc.h>
+#endif
+
+using namespace ::wtr::test_watcher;
+
+/*  A tree with `fan_out` directories in each directory,
+    `depth` deep. */
+struct tree_shape {
+  unsigned long fan_out;
+  unsigned long depth;
+
+  auto dirs() const -> unsigned long
+  {
+    auto n = 0ul;
+    auto level = 1ul;
+    for (auto d = 0ul; d < this->depth; ++d) n += (level *= this->fan_out);
+    return n;
+  }
+};
+
+/*  The trees to measure, from `WTR_BENCH_TREES`, such as
+    "10x4,10x5,10x6,9x7" (about 10k, 100k, 1M and 5M
+    directories), or the two smallest of those. */
+auto tree_shapes() -> std::vector<tree_shape>
+{
+  auto const given = std::getenv("WTR_BENCH_TREES");
+  auto spec = std::string{given ? given : "10x4,10x5"};
+  auto shapes = std::vector<tree_shape>{};
+  for (auto at = std::size_t{0}; at < spec.size();) {
+    auto const end = std::min(spec.find(',', at), spec.size());
+    auto const one = spec.substr(at, end - at);
+    auto const x = one.find('x');
+    if (x != one.npos)
+      shapes.push_back(
+        {std::stoul(one.substr(0, x)), std::stoul(one.substr(x + 1))});
+    at = end + 1;
+  }
+  return shapes;
+}
+
+auto make_tree(std::filesystem::path const& at, tree_shape shape) -> void
+{
+  std::filesystem::create_directory(at);
+  if (shape.depth == 0) return;
+  for (auto i = 0ul; i < shape.fan_out; ++i)
+    make_tree(at / std::to_string(i), {shape.fan_out, shape.depth - 1});
+}
+
+/*  A field, in kB, from a file in `/proc` such as
+    `/proc/self/status`, or 0 if we can't read it. */
+auto proc_kb(char const* file, std::string_view field) -> long long
+{
+  auto in = std::ifstream{file};
+  for (auto line = std::string{}; std::getline(in, line);)
+    if (line.starts_with(field) && line.size() > field.size()
+        && line[field.size()] == ':')
+      return std::atoll(line.c_str() + field.size() + 1);
+  return 0;
+}
+
+/*  What is allocated on our heap now, in kB, or our
+    resident memory where we can't tell. */
+auto heap_kb() -> long long
+{
+#if defined(__GLIBC__) && __GLIBC_PREREQ(2, 33)
+  auto const mi = mallinfo2();
+  return (long long)(mi.uordblks + mi.hblkhd) / 1024;
+#else
+  return proc_kb("/proc/self/status", "VmRSS");
+#endif
+}
+
+/*  For each tree, and each adapter we can run here: how
+    long until the adapter is ready (has walked the tree
+    and is watching it), and how much of our heap and of
+    the kernel's slab it held, by what was given back when
+    it was closed. (Resident memory isn't given back when
+    each thread's arena is freed, so it says little.) The
+    slab is shared with everything else on the machine, so
+    it is only a rough measure of what the kernel keeps for
+    each watch.
+
+    The trees are made in the system's temporary directory,
+    and can be large: set `WTR_BENCH_TREES` for more than
+    the two smallest. */
+TEST_CASE("Bench Startup", "[bench_startup]")
+{
+  namespace fs = ::std::filesystem;
+  using namespace ::wtr::watcher;
+  using clock = std::chrono::steady_clock;
+
+  auto const root = fs::temp_directory_path() / "wtr_bench_startup";
+
+  auto const row = [](auto const& name, auto const&... cols)
+  {
+    std::cout << std::left << std::setw(10) << name << std::right;
+    ((std::cout << std::setw(14) << cols), ...);
+    std::cout << std::endl;
+  };
+
+  std::cout << std::fixed << std::setprecision(1);
+  row("adapter",
+      "tree",
+      "dirs",
+      "marks",
+      "ready ms",
+      "heap kB",
+      "slab kB",
+      "B/dir");
+
+  auto all_ready = true;
+
+  for (auto const shape : tree_shapes()) {
+    fs::remove_all(root);
+    auto const made_at = clock::now();
+    make_tree(root, shape);
+    std::cout << "made " << shape.dirs() << " directories in "
+              << std::chrono::duration<double>(clock::now() - made_at).count()
+              << " s" << std::endl;
+
+    for (auto const adapter : adapter_names()) {
+      auto const began = clock::now();
+
+      auto run =
+        adapter_run{adapter, root, [](event::compact const&) noexcept {}};
+      auto const ready = run.ready(std::chrono::milliseconds(600'000));
+
+      auto const took = clock::now() - began;
+      auto const heap_ready = heap_kb();
+      auto const slab_ready = proc_kb("/proc/meminfo", "Slab");
+      auto const marks = run.counts.marks.load();
+      run.close();
+
+      /* What the adapter held is what it gives back. */
+      auto const heap = heap_ready - heap_kb();
+      auto const slab = slab_ready - proc_kb("/proc/meminfo", "Slab");
+
+      if (! ready) all_ready = false;
+
+      row(adapter,
+          std::to_string(shape.fan_out) + "x" + std::to_string(shape.depth),
+          shape.dirs(),
+          marks,
+          std::chrono::duration<double, std::milli>(took).count(),
+          heap,
+          slab,
+          marks > 0 ? double(heap + slab) * 1024 / double(marks) : 0.0);
+    }
+  }
+
+  fs::remove_all(root);
+
+  REQUIRE(all_ready);
+};
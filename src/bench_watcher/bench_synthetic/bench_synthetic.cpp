@@ -0,0 +1,126 @@
+/*  milliseconds,
+    steady_clock,
+    duration */
+#include <chrono>
+/*  uint64_t */
+#include <cstdint>
+/*  cout,
+    endl */
+#include <iostream>
+/*  setw,
+    setprecision */
+#include <iomanip>
+/*  string */
+#include <string>
+/*  atomic */
+#include <atomic>
+/*  function */
+#include <functional>
+/*  thread */
+#include <thread>
+/*  path */
+#include <filesystem>
+/*  is_invocable_v */
+#include <type_traits>
+/*  REQUIRE,
+    TEST_CASE */
+#include <snitch/snitch.hpp>
+/*  event,
+    filter,
+    policy,
+    synthetic,
+    watch,
+    batch,
+    collapse,
+    coalesce */
+#include <wtr/watcher.hpp>
+
+using namespace ::wtr::watcher;
+
+/*  Times a synthetic watcher which makes `count` events
+    beneath a made up path, through `f` (unless they come
+    in batches), to `callback`.
+    Returns the seconds until the last of them was made,
+    and sent as far as the watcher's own thread takes them. */
+template<class Callback>
+auto timed(std::uint64_t count,
+           filter const& f,
+           Callback const& callback,
+           double skew = 0) -> double
+{
+  using clock = std::chrono::steady_clock;
+  auto const stream = synthetic{.count = count, .skew = skew};
+  auto const chunks = (count + stream.chunk - 1) / stream.chunk;
+  auto const began = clock::now();
+  auto const path = std::filesystem::path{"/wtr/bench_synthetic"};
+  /* Batches aren't filtered. */
+  auto w = [&]()
+  {
+    if constexpr (std::is_invocable_v<Callback const&, batch const&>)
+      return watch(path, stream, callback);
+    else
+      return watch(path, f, stream, callback);
+  }();
+  while (w.metrics().reads < chunks)
+    std::this_thread::sleep_for(std::chrono::microseconds(200));
+  auto const seconds =
+    std::chrono::duration<double>(clock::now() - began).count();
+  w.close();
+  return seconds;
+}
+
+/*  How fast the library takes made up events (no kernel, no
+    disk) from the adapter to the callback, for each sort of
+    callback and with the filters and stages in between, so
+    that we can see which of them is our bottleneck. */
+TEST_CASE("Bench Synthetic", "[bench_synthetic]")
+{
+  static constexpr auto count = 4'000'000ull;
+  static constexpr auto staged = 400'000ull;
+
+  auto seen = std::atomic<unsigned long long>{0};
+  auto const count_it = [&seen]() noexcept
+  { seen.fetch_add(1, std::memory_order_relaxed); };
+
+  auto const row = [](auto const& name, auto const&... cols)
+  {
+    std::cout << std::left << std::setw(22) << name << std::right;
+    ((std::cout << std::setw(14) << cols), ...);
+    std::cout << std::endl;
+  };
+
+  auto const report = [&](auto const& name, std::uint64_t made, double s)
+  {
+    row(name, made / s, s * 1e9 / made, seen.exchange(0));
+  };
+
+  std::cout << std::fixed << std::setprecision(1);
+  row("pipeline", "events/s", "ns/event", "delivered");
+
+  auto const compact_cb = [&](event::compact const& e) noexcept
+  {
+    if (e.kind != event::kind::watcher) count_it();
+  };
+  auto const event_cb = [&](event const& e) noexcept
+  {
+    if (e.kind != event::kind::watcher) count_it();
+  };
+  auto const function_cb = event::callback{event_cb};
+  auto const batch_cb = [&](batch const&) noexcept { count_it(); };
+
+  report("compact", count, timed(count, {}, compact_cb));
+  report("compact, zipf 1.2", count, timed(count, {}, compact_cb, 1.2));
+  report("event", count, timed(count, {}, event_cb));
+  report("std::function", count, timed(count, {}, function_cb));
+  report("batch", count, timed(count, {}, batch_cb));
+  report("filter *.cpp", count, timed(count, filter{"*.cpp"}, compact_cb));
+  report("filter, 4 globs",
+         count,
+         timed(count,
+               filter{"*.o", "!d1*/", "s1/**/f1*", "*.[ch]pp"},
+               compact_cb));
+  report("coalesce", staged, timed(staged, {}, coalesce(function_cb)));
+  report("collapse", staged, timed(staged, {}, collapse(function_cb)));
+
+  REQUIRE(true);
+};
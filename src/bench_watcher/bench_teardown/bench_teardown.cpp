@@ -0,0 +1,108 @@
+/*  milliseconds,
+    steady_clock,
+    duration */
+#include <chrono>
+/*  cout,
+    endl */
+#include <iostream>
+/*  ofstream */
+#include <fstream>
+/*  setw,
+    setprecision */
+#include <iomanip>
+/*  max */
+#include <algorithm>
+/*  sleep_for */
+#include <thread>
+/*  vector */
+#include <vector>
+/*  path,
+    create_directories,
+    remove_all */
+#include <filesystem>
+/*  REQUIRE,
+    TEST_CASE */
+#include <snitch/snitch.hpp>
+/*  test_store_path */
+#include <test_watcher/constant.hpp>
+/*  watch,
+    event,
+    group */
+#include <wtr/watcher.hpp>
+
+using namespace ::wtr::test_watcher;
+
+/*  How long closing `count` watchers takes, one after
+    another (with the time for each) and as a group.
+
+    Closing a watcher waits for it to notice, as long as
+    `delay_ms`. One after another, those waits add up. In
+    a group, they happen together.
+
+    The kernel limits how many inotify instances (and
+    fanotify groups) each user has, to 128 by default, so
+    we stay below that. */
+TEST_CASE("Bench Teardown", "[bench_teardown]")
+{
+  namespace fs = ::std::filesystem;
+  using namespace ::wtr::watcher;
+  using clock = std::chrono::steady_clock;
+  using ms = std::chrono::duration<double, std::milli>;
+
+  static constexpr int counts[] = {10, 50, 100};
+
+  auto const store = test_store_path / "bench_teardown_store";
+  fs::create_directories(store);
+  std::ofstream{store / "0.txt"};
+
+  auto const row = [](auto const& name, auto const&... cols)
+  {
+    std::cout << std::left << std::setw(10) << name << std::right;
+    ((std::cout << std::setw(14) << cols), ...);
+    std::cout << std::endl;
+  };
+
+  auto const open = [&store](int count)
+  {
+    auto watchers = std::vector<decltype(watch(store, [](event const&) {}))>{};
+    for (auto i = 0; i < count; ++i)
+      watchers.emplace_back(watch(store, [](event const&) {}));
+    /* Let them all start. */
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    return watchers;
+  };
+
+  std::cout << std::fixed << std::setprecision(2);
+  row("how", "watchers", "total ms", "mean ms", "max ms");
+
+  auto ok = true;
+
+  for (auto const count : counts) {
+    {
+      auto watchers = open(count);
+      auto total = ms{};
+      auto longest = ms{};
+      for (auto& w : watchers) {
+        auto const began = clock::now();
+        ok = w.close() && ok;
+        auto const took = ms(clock::now() - began);
+        total += took;
+        longest = std::max(longest, took);
+      }
+      row("each", count, total.count(), total.count() / count, longest.count());
+    }
+    {
+      auto watchers = open(count);
+      auto g = group{};
+      for (auto& w : watchers) g.add(w);
+      auto const began = clock::now();
+      ok = g.close() && ok;
+      auto const took = ms(clock::now() - began);
+      row("group", count, took.count(), took.count() / count, took.count());
+    }
+  }
+
+  fs::remove_all(test_store_path);
+
+  REQUIRE(ok);
+};
@@ -0,0 +1,216 @@
+/*  milliseconds,
+    steady_clock,
+    duration_cast */
+#include <chrono>
+/*  cout,
+    endl */
+#include <iostream>
+/*  ofstream */
+#include <fstream>
+/*  setw,
+    setprecision */
+#include <iomanip>
+/*  string */
+#include <string>
+/*  string_view */
+#include <string_view>
+/*  thread */
+#include <thread>
+/*  atomic */
+#include <atomic>
+/*  vector */
+#include <vector>
+/*  path,
+    create_directories,
+    remove,
+    remove_all */
+#include <filesystem>
+/*  REQUIRE,
+    TEST_CASE */
+#include <snitch/snitch.hpp>
+/*  event,
+    policy */
+#include <wtr/watcher.hpp>
+/*  test_store_path,
+    adapter_names,
+    adapter_run,
+    stress */
+#include <test_watcher/test_watcher.hpp>
+
+using namespace ::wtr::test_watcher;
+
+/*  What we asked for, and what we did. A rate of 0 is as
+    fast as we can. */
+struct generated {
+  double rate{};
+  unsigned long long ops{};
+  double seconds{};
+};
+
+/*  Creates, modifies and removes files from `thread_count`
+    threads, each in a directory of its own beneath `store`,
+    at `rate` operations per second (shared between them)
+    for `for_how_long`. Each operation should be seen as
+    one event. */
+auto generate(std::filesystem::path const& store,
+              int thread_count,
+              double rate,
+              std::chrono::milliseconds for_how_long) -> generated
+{
+  using clock = std::chrono::steady_clock;
+
+  auto ops = std::atomic<unsigned long long>{0};
+  auto const began = clock::now();
+  auto const until = began + for_how_long;
+
+  auto threads = std::vector<std::thread>{};
+  for (auto t = 0; t < thread_count; ++t)
+    threads.emplace_back(
+      [&, t]()
+      {
+        auto const dir = store / ("t" + std::to_string(t));
+        auto const interval = rate > 0
+                              ? std::chrono::duration<double>(thread_count / rate)
+                              : std::chrono::duration<double>(0);
+        auto k = 0ull;
+        for (auto now = clock::now(); now < until; now = clock::now(), ++k) {
+          if (rate > 0) {
+            auto const due = began
+                           + std::chrono::duration_cast<clock::duration>(
+                             interval * (double)k);
+            if (due > until) break;
+            if (due > now) std::this_thread::sleep_until(due);
+          }
+          auto const file = dir / std::to_string(k / 3);
+          switch (k % 3) {
+            case 0 : std::ofstream{file}; break;
+            case 1 : std::ofstream{file, std::ios::app} << "x"; break;
+            case 2 : std::filesystem::remove(file); break;
+          }
+        }
+        /* Whatever we left half done is finished, so that
+           every file we made is gone. */
+        auto const file = dir / std::to_string(k / 3);
+        if (k % 3 == 1) {
+          std::ofstream{file, std::ios::app} << "x";
+          ++k;
+        }
+        if (k % 3 == 2) {
+          std::filesystem::remove(file);
+          ++k;
+        }
+        ops += k;
+      });
+  for (auto& t : threads) t.join();
+
+  return {rate,
+          ops.load(),
+          std::chrono::duration<double>(clock::now() - began).count()};
+}
+
+/*  For each adapter we can run here, and for each rate,
+    from a few thousand operations per second to as many as
+    we can make: how many events were delivered (per second,
+    and out of how many we made), how often the kernel's
+    queue overflowed and how much of the watcher's CPU time
+    each event took. Where more than 1% are lost, the adapter
+    is saturated.
+
+    `fanotify` merges events on one file while they wait in
+    its queue, so some of what it "loses" was merged. It
+    also stops when its queue overflows. */
+TEST_CASE("Bench Throughput", "[bench_throughput]")
+{
+  namespace fs = ::std::filesystem;
+  using namespace ::wtr::watcher;
+
+  static constexpr auto thread_count = 4;
+  static constexpr auto for_how_long = std::chrono::milliseconds(1000);
+  static constexpr double rates[] = {1'000, 10'000, 50'000, 200'000, 0};
+
+  auto const store = test_store_path / "bench_throughput_store";
+
+  auto const row = [](auto const& name, auto const&... cols)
+  {
+    std::cout << std::left << std::setw(10) << name << std::right;
+    ((std::cout << std::setw(14) << cols), ...);
+    std::cout << std::endl;
+  };
+
+  std::cout << std::fixed << std::setprecision(1);
+  row("adapter",
+      "rate",
+      "ops/s",
+      "events/s",
+      "loss %",
+      "overflows",
+      "cpu ns/ev");
+
+  auto lowest_delivered = true;
+
+  for (auto const name : adapter_names()) {
+    auto saturated_at = -1.0;
+    for (auto const rate : rates) {
+      for (auto t = 0; t < thread_count; ++t)
+        fs::create_directories(store / ("t" + std::to_string(t)));
+      /* The polling adapter is ready once it sees a file. */
+      std::ofstream{store / "0.txt"};
+
+      auto delivered = std::atomic<unsigned long long>{0};
+      auto run = adapter_run{name,
+                             store,
+                             [&delivered](event::compact const&) noexcept
+                             { delivered.fetch_add(1, std::memory_order_relaxed); }};
+      REQUIRE(run.ready());
+
+      auto const made = generate(store, thread_count, rate, for_how_long);
+      run.settle();
+      run.close();
+
+      auto const events = delivered.load();
+      auto const loss = made.ops > events
+                        ? 100.0 * double(made.ops - events) / double(made.ops)
+                        : 0.0;
+      if (loss > 1.0 && saturated_at < 0) saturated_at = made.ops / made.seconds;
+      if (rate == rates[0] && events == 0) lowest_delivered = false;
+
+      row(name,
+          rate > 0 ? std::to_string((long)rate) : std::string{"max"},
+          made.ops / made.seconds,
+          events / made.seconds,
+          loss,
+          run.counts.overflows.load(),
+          events > 0 ? double(run.cpu_ns()) / double(events) : 0.0);
+
+      fs::remove_all(store);
+    }
+    if (saturated_at > 0)
+      std::cout << name << " saturated near " << saturated_at << " ops/s"
+                << std::endl;
+    else
+      std::cout << name << " kept up" << std::endl;
+
+    /* Whether what was lost at full speed was merged, or
+       really lost. `fanotify` merges everything which
+       happens to one name while it waits. */
+    if (name != "warthog") {
+      auto s = stress{store,
+                      {.threads = thread_count,
+                       .ops = 5'000,
+                       .merged = name == "fanotify"}};
+      auto run = adapter_run{name, store, s.callback()};
+      REQUIRE(run.ready());
+      s.run();
+      auto const r = s.verify();
+      run.close();
+      std::cout << name << " at full speed: " << r.ops << " cycles, "
+                << r.missing << " of " << r.expected << " missing, "
+                << r.unexpected << " unexpected" << std::endl;
+      fs::remove_all(store);
+    }
+  }
+
+  fs::remove_all(test_store_path);
+
+  REQUIRE(lowest_delivered);
+};
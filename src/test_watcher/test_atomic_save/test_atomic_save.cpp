@@ -0,0 +1,165 @@
+/*
+   Test Watcher
+   Atomic Save
+*/
+
+/* REQUIRE,
+   TEST_CASE */
+#include <snitch/snitch.hpp>
+/* event,
+   watch,
+   atomic_save */
+#include <wtr/watcher.hpp>
+/* test_store_path */
+#include <test_watcher/test_watcher.hpp>
+/* cout, endl */
+#include <iostream>
+/* ofstream */
+#include <fstream>
+/* vector */
+#include <vector>
+/* string */
+#include <string>
+/* milliseconds */
+#include <chrono>
+/* mutex */
+#include <mutex>
+/* sleep_for */
+#include <thread>
+/* path,
+   create_directories,
+   remove_all,
+   rename,
+   remove */
+#include <filesystem>
+
+/* Test that files saved through a temporary file, or
+   by moving the original aside, are seen as one
+   `modify` event for the file which was saved. */
+TEST_CASE("Atomic Save", "[atomic_save]")
+{
+  namespace fs = ::std::filesystem;
+  using namespace ::wtr::watcher;
+  using namespace ::wtr::test_watcher;
+
+  static constexpr auto title = "Atomic Save";
+  static constexpr auto path_count = 4;
+  static constexpr auto window = std::chrono::milliseconds(200);
+  static auto event_recv_list = std::vector<event>{};
+  static auto event_recv_list_mtx = std::mutex{};
+  static auto const store_path = test_store_path / "atomic_save_store";
+
+  std::cout << title << std::endl;
+
+  fs::create_directories(store_path);
+  REQUIRE(fs::exists(store_path));
+
+  auto const target = [](int i) { return store_path / std::to_string(i); };
+
+  for (int i = 0; i < path_count; ++i) std::ofstream{target(i)} << "old";
+
+  auto watcher = watch(store_path,
+                       atomic_save(
+                         [](event const& ev)
+                         {
+                           auto _ = std::scoped_lock{event_recv_list_mtx};
+                           std::cout << ev << std::endl;
+                           event_recv_list.push_back(ev);
+                         },
+                         window));
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+  /* Write a temporary file, then rename it over the target. */
+  for (int i = 0; i < path_count / 2; ++i) {
+    auto temp = target(i);
+    temp += ".tmp~";
+    std::ofstream{temp} << "new";
+    fs::rename(temp, target(i));
+  }
+
+  /* Move the target aside, write a new one, then remove the old one.
+     Some kernels merge events for a name while they are queued, so
+     we take a moment between each step, as an editor would. */
+  for (int i = path_count / 2; i < path_count; ++i) {
+    auto backup = target(i);
+    backup += "~";
+    fs::rename(target(i), backup);
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    std::ofstream{target(i)} << "new";
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    fs::remove(backup);
+  }
+
+  std::this_thread::sleep_for(window * 3);
+
+  REQUIRE(watcher.close());
+
+  fs::remove_all(test_store_path);
+  REQUIRE(! fs::exists(test_store_path));
+
+  for (auto const& ev : event_recv_list)
+    if (ev.kind != event::kind::watcher) {
+      auto const& name = ev.where.filename().string();
+      REQUIRE(name.find('~') == std::string::npos);
+    }
+
+  for (int i = 0; i < path_count; ++i) {
+    auto seen = 0;
+    for (auto const& ev : event_recv_list)
+      if (ev.where == target(i)) {
+        REQUIRE(ev.what == event::what::modify);
+        ++seen;
+      }
+    REQUIRE(seen == 1);
+  }
+
+  REQUIRE(event_recv_list.back().kind == event::kind::watcher);
+  REQUIRE(event_recv_list.back().what == event::what::destroy);
+};
+
+/* Test that a backup which something else was moved over
+   is let go, and that its target coming back afterwards is
+   seen as it happened. */
+TEST_CASE("Atomic Save Backup Replaced", "[atomic_save]")
+{
+  using namespace ::wtr::watcher;
+  using what = enum event::what;
+  using kind = enum event::kind;
+
+  static constexpr auto window = std::chrono::milliseconds(50);
+
+  auto mtx = std::mutex{};
+  auto seen = std::vector<event>{};
+  auto saving = atomic_save(
+    [&](event const& ev)
+    {
+      auto _ = std::scoped_lock{mtx};
+      seen.push_back(ev);
+    },
+    window);
+
+  /* mv x b~; mv y b~ */
+  saving({"/s/x", what::rename, kind::file});
+  saving({"/s/b~", what::rename, kind::file});
+  saving({"/s/y", what::rename, kind::file});
+  saving({"/s/b~", what::rename, kind::file});
+
+  std::this_thread::sleep_for(window * 3);
+
+  saving({"/s/x", what::create, kind::file});
+  saving({"/s/x", what::modify, kind::file});
+
+  auto _ = std::scoped_lock{mtx};
+  auto const count = [&](char const* where, enum event::what w)
+  {
+    auto n = 0;
+    for (auto const& ev : seen) n += ev.where == where && ev.what == w;
+    return n;
+  };
+  REQUIRE(count("/s/x", what::rename) == 1);
+  REQUIRE(count("/s/y", what::rename) == 1);
+  REQUIRE(count("/s/b~", what::rename) == 2);
+  REQUIRE(count("/s/x", what::create) == 1);
+  REQUIRE(count("/s/x", what::modify) == 1);
+};
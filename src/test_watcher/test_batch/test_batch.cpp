@@ -0,0 +1,163 @@
+/*
+   Test Watcher
+   Batch
+*/
+
+/* REQUIRE,
+   TEST_CASE */
+#include <snitch/snitch.hpp>
+/* event,
+   batch,
+   watch */
+#include <wtr/watcher.hpp>
+/* test_store_path,
+   seeded,
+   settle */
+#include <test_watcher/test_watcher.hpp>
+/* cout, endl */
+#include <iostream>
+/* ofstream */
+#include <fstream>
+/* vector */
+#include <vector>
+/* map */
+#include <map>
+/* string */
+#include <string>
+/* mutex */
+#include <mutex>
+/* path,
+   create_directory,
+   create_directories,
+   remove_all */
+#include <filesystem>
+
+/* Test that a batch of one event reads as that event. */
+TEST_CASE("Batch Of One", "[batch]")
+{
+  using namespace ::wtr::watcher;
+
+  auto const e = event{"/a/b.txt", event::what::create, event::kind::file};
+  auto const b = batch{e};
+  auto n = 0;
+  auto into = batch::string_type{};
+  for (auto entry : b) {
+    ++n;
+    REQUIRE(entry.what() == event::what::create);
+    REQUIRE(entry.kind() == event::kind::file);
+    REQUIRE(entry.name() == batch::view_type{e.where.filename().native()});
+    REQUIRE(entry.where(into));
+    REQUIRE(into == e.where.native());
+    REQUIRE(b.dir(entry.dir()) == batch::view_type{"/a"});
+  }
+  REQUIRE(n == 1);
+  REQUIRE(! b.empty());
+};
+
+/* Batches are what the kernel gave us: there is no filter
+   for them, for one root or for many. */
+namespace {
+using roots_type = std::vector<std::filesystem::path>;
+using batch_callback = decltype([](::wtr::watcher::batch const&) {});
+
+template<class Root, class Callback>
+concept filtered = requires(Root const& r, Callback const& cb) {
+  ::wtr::watcher::watch(r, ::wtr::watcher::filter{}, cb);
+};
+
+static_assert(! filtered<std::filesystem::path, batch_callback>);
+static_assert(! filtered<roots_type, batch_callback>);
+static_assert(filtered<roots_type, ::wtr::watcher::event::callback>);
+} /* namespace */
+
+/* Test that we see what happened through batches, that
+   things in the same directory have the same directory id
+   (and things in other directories don't), and that we
+   only put paths together when we ask for them. */
+TEST_CASE("Batch", "[batch]")
+{
+  namespace fs = ::std::filesystem;
+  using namespace ::wtr::watcher;
+  using namespace ::wtr::test_watcher;
+
+  static constexpr auto title = "Batch";
+  static auto names = std::vector<std::string>{};
+  static auto wheres = std::vector<std::string>{};
+  static auto dirs = std::map<std::string, batch::dir_id>{};
+  static auto dir_paths = std::map<std::string, std::string>{};
+  static auto last_kind = event::kind::other;
+  static auto last_what = event::what::other;
+  static auto mtx = std::mutex{};
+  static auto const store_path = test_store_path / "batch_store";
+
+  std::cout << title << std::endl;
+
+  seeded(store_path);
+  fs::create_directories(store_path / "sub");
+  REQUIRE(fs::exists(store_path / "sub"));
+
+  auto watcher = watch(store_path,
+                       [](batch const& b)
+                       {
+                         auto _ = std::scoped_lock{mtx};
+                         auto into = batch::string_type{};
+                         for (auto e : b) {
+                           last_kind = e.kind();
+                           last_what = e.what();
+                           if (e.kind() == event::kind::watcher) continue;
+                           names.emplace_back(e.name());
+                           dirs[names.back()] = e.dir();
+                           dir_paths[names.back()] = b.dir(e.dir());
+                           if (e.name() == "b.txt" && e.where(into))
+                             wheres.push_back(into);
+                         }
+                       });
+
+  /* Some adapters scan what is there before they notice
+     what changes. */
+  settle();
+
+  for (auto const& p : {"a.txt", "b.txt", "c.txt", "sub/d.txt"})
+    std::ofstream{store_path / p};
+
+  settle();
+
+  /* A new directory is watched, though its events went
+     out in a batch. */
+  fs::create_directory(store_path / "new");
+  settle();
+  std::ofstream{store_path / "new" / "e.txt"};
+  settle();
+
+  REQUIRE(watcher.close());
+
+  fs::remove_all(test_store_path);
+  REQUIRE(! fs::exists(test_store_path));
+
+  for (auto const& n : names) std::cout << n << std::endl;
+
+  auto seen = [](std::string const& n)
+  {
+    for (auto const& s : names)
+      if (s == n) return true;
+    return false;
+  };
+
+  REQUIRE(seen("a.txt"));
+  REQUIRE(seen("b.txt"));
+  REQUIRE(seen("c.txt"));
+  REQUIRE(seen("d.txt"));
+  REQUIRE(! wheres.empty());
+  REQUIRE(wheres.front() == (store_path / "b.txt").string());
+
+  REQUIRE(dirs["a.txt"] == dirs["b.txt"]);
+  REQUIRE(dirs["a.txt"] == dirs["c.txt"]);
+  REQUIRE(dirs["a.txt"] != dirs["d.txt"]);
+  REQUIRE(dir_paths["a.txt"] == store_path.string());
+  REQUIRE(dir_paths["d.txt"] == (store_path / "sub").string());
+  REQUIRE(seen("e.txt"));
+  REQUIRE(dir_paths["e.txt"] == (store_path / "new").string());
+
+  REQUIRE(last_kind == event::kind::watcher);
+  REQUIRE(last_what == event::what::destroy);
+};
@@ -0,0 +1,129 @@
+/*
+   Test Watcher
+   Clock
+*/
+
+/* REQUIRE,
+   TEST_CASE */
+#include <snitch/snitch.hpp>
+/* event,
+   watch,
+   coalesce */
+#include <wtr/watcher.hpp>
+/* test_store_path,
+   seeded,
+   settle */
+#include <test_watcher/test_watcher.hpp>
+/* cout, endl */
+#include <iostream>
+/* ofstream */
+#include <fstream>
+/* vector */
+#include <vector>
+/* milliseconds,
+   seconds */
+#include <chrono>
+/* mutex */
+#include <mutex>
+/* path,
+   remove_all */
+#include <filesystem>
+
+/* Test that each clock reads something sensible, and that
+   events say which clock they are from. */
+TEST_CASE("Clocks", "[clock]")
+{
+  using namespace ::wtr::watcher;
+  using std::chrono::duration_cast, std::chrono::nanoseconds;
+
+  auto const system_now = duration_cast<nanoseconds>(
+                            std::chrono::system_clock::now().time_since_epoch())
+                            .count();
+  auto const second = 1'000'000'000ll;
+
+  REQUIRE(event::now(event::clock::none) == 0);
+  REQUIRE(event::now(event::clock::system) >= system_now);
+  REQUIRE(event::now(event::clock::system) - system_now < second);
+  REQUIRE(event::now(event::clock::realtime_coarse) - system_now < second);
+  REQUIRE(system_now - event::now(event::clock::realtime_coarse) < second);
+
+  auto const mono = event::now(event::clock::monotonic_coarse);
+  REQUIRE(mono > 0);
+  REQUIRE(event::now(event::clock::monotonic_coarse) >= mono);
+
+  auto const e = event{"/a", event::what::create, event::kind::file};
+  REQUIRE(e.clock == event::clock::system);
+  auto const c = event::compact{"/a",
+                                event::what::create,
+                                event::kind::file,
+                                7,
+                                event::clock::none};
+  REQUIRE(event{c}.clock == event::clock::none);
+  REQUIRE(event::compact{event{c}}.clock == event::clock::none);
+};
+
+/* Test that the watcher stamps events from the clock we
+   ask for (where it can) and says which clock that was,
+   through a stage as well. */
+TEST_CASE("Clock", "[clock]")
+{
+  namespace fs = ::std::filesystem;
+  using namespace ::wtr::watcher;
+  using namespace ::wtr::test_watcher;
+
+  static constexpr auto title = "Clock";
+  static auto const store_path = test_store_path / "clock_store";
+  static constexpr auto second = 1'000'000'000ll;
+
+  std::cout << title << std::endl;
+
+  for (auto const clock : {event::clock::system,
+                           event::clock::realtime_coarse,
+                           event::clock::monotonic_coarse,
+                           event::clock::none}) {
+    static auto seen = std::vector<std::pair<long long, enum event::clock>>{};
+    static auto seen_mtx = std::mutex{};
+    seen.clear();
+
+    REQUIRE(fs::exists(seeded(store_path)));
+
+    auto const keep = [](event const& e)
+    {
+      if (e.kind == event::kind::watcher) return;
+      auto _ = std::scoped_lock{seen_mtx};
+      seen.emplace_back(e.when, e.clock);
+    };
+
+    auto plain = watch(store_path, keep, clock);
+    auto staged =
+      watch(store_path, coalesce(keep, std::chrono::milliseconds(10)), clock);
+
+    settle();
+
+    std::ofstream{store_path / "a.txt"} << "a";
+
+    settle();
+
+    REQUIRE(plain.close());
+    REQUIRE(staged.close());
+
+    fs::remove_all(test_store_path);
+    REQUIRE(! fs::exists(test_store_path));
+
+    REQUIRE(seen.size() >= 2);
+    for (auto const& [when, from] : seen) {
+      /* The other platforms only stamp from the system clock. */
+#if defined(__linux__) && ! defined(WATER_WATCHER_USE_WARTHOG)
+      REQUIRE(from == clock);
+#else
+      REQUIRE(from == event::clock::system);
+#endif
+      if (from == event::clock::none)
+        REQUIRE(when == 0);
+      else {
+        REQUIRE(when > 0);
+        REQUIRE(event::now(from) - when < 10 * second);
+      }
+    }
+  }
+};
@@ -0,0 +1,87 @@
+/*
+   Test Watcher
+   Coalesce
+*/
+
+/* REQUIRE,
+   TEST_CASE */
+#include <snitch/snitch.hpp>
+/* event,
+   watch,
+   coalesce */
+#include <wtr/watcher.hpp>
+/* test_store_path */
+#include <test_watcher/test_watcher.hpp>
+/* cout, endl */
+#include <iostream>
+/* ofstream */
+#include <fstream>
+/* vector */
+#include <vector>
+/* string */
+#include <string>
+/* milliseconds */
+#include <chrono>
+/* mutex */
+#include <mutex>
+/* sleep_for */
+#include <thread>
+/* path,
+   create_directories,
+   remove_all */
+#include <filesystem>
+
+/* Test that a burst of writes to a new file
+   is seen as one event for that file. */
+TEST_CASE("Coalesce", "[coalesce]")
+{
+  namespace fs = ::std::filesystem;
+  using namespace ::wtr::watcher;
+  using namespace ::wtr::test_watcher;
+
+  static constexpr auto title = "Coalesce";
+  static constexpr auto path_count = 4;
+  static constexpr auto write_count = 8;
+  static constexpr auto window = std::chrono::milliseconds(200);
+  static auto event_recv_list = std::vector<event>{};
+  static auto event_recv_list_mtx = std::mutex{};
+  static auto const store_path = test_store_path / "coalesce_store";
+
+  std::cout << title << std::endl;
+
+  fs::create_directories(store_path);
+  REQUIRE(fs::exists(store_path));
+
+  auto watcher = watch(store_path,
+                       coalesce(
+                         [](event const& ev)
+                         {
+                           auto _ = std::scoped_lock{event_recv_list_mtx};
+                           std::cout << ev << std::endl;
+                           event_recv_list.push_back(ev);
+                         },
+                         window));
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+  for (int i = 0; i < path_count; ++i)
+    for (int j = 0; j < write_count; ++j)
+      std::ofstream{store_path / std::to_string(i), std::ios::app} << j;
+
+  std::this_thread::sleep_for(window * 3);
+
+  REQUIRE(watcher.close());
+
+  fs::remove_all(test_store_path);
+  REQUIRE(! fs::exists(test_store_path));
+
+  for (int i = 0; i < path_count; ++i) {
+    auto seen = 0;
+    for (auto const& ev : event_recv_list)
+      if (ev.where == store_path / std::to_string(i)) ++seen;
+    REQUIRE(seen == 1);
+  }
+
+  REQUIRE(event_recv_list.back().kind == event::kind::watcher);
+  REQUIRE(event_recv_list.back().what == event::what::destroy);
+};
@@ -0,0 +1,175 @@
+/*
+   Test Watcher
+   Collapse
+*/
+
+/* REQUIRE,
+   TEST_CASE */
+#include <snitch/snitch.hpp>
+/* event,
+   watch,
+   collapse */
+#include <wtr/watcher.hpp>
+/* test_store_path,
+   seeded,
+   settle */
+#include <test_watcher/test_watcher.hpp>
+/* cout, endl */
+#include <iostream>
+/* ofstream */
+#include <fstream>
+/* vector */
+#include <vector>
+/* string */
+#include <string>
+/* milliseconds,
+   steady_clock */
+#include <chrono>
+/* mutex */
+#include <mutex>
+/* optional */
+#include <optional>
+/* sleep_for */
+#include <thread>
+/* path,
+   create_directories,
+   remove_all */
+#include <filesystem>
+
+/* Test that a tree which is created, and then destroyed,
+   all at once is seen as one event for each. */
+TEST_CASE("Collapse", "[collapse]")
+{
+  namespace fs = ::std::filesystem;
+  using namespace ::wtr::watcher;
+  using namespace ::wtr::test_watcher;
+
+  static constexpr auto title = "Collapse";
+  static constexpr auto dir_count = 8;
+  static constexpr auto file_count = 16;
+  static constexpr auto window = std::chrono::milliseconds(100);
+  static auto event_recv_list = std::vector<event>{};
+  static auto event_recv_list_mtx = std::mutex{};
+  static auto const store_path = test_store_path / "collapse_store";
+  static auto const tree_path = store_path / "tree";
+
+  std::cout << title << std::endl;
+
+  fs::create_directories(store_path);
+  REQUIRE(fs::exists(store_path));
+
+  auto watcher = watch(store_path,
+                       collapse(
+                         [](event const& ev)
+                         {
+                           auto _ = std::scoped_lock{event_recv_list_mtx};
+                           std::cout << ev << std::endl;
+                           event_recv_list.push_back(ev);
+                         },
+                         window));
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+  for (int i = 0; i < dir_count; ++i) {
+    auto const dir = tree_path / std::to_string(i);
+    fs::create_directories(dir);
+    for (int j = 0; j < file_count; ++j)
+      std::ofstream{dir / std::to_string(j)};
+  }
+
+  std::this_thread::sleep_for(window * 3);
+
+  fs::remove_all(tree_path);
+  REQUIRE(! fs::exists(tree_path));
+
+  std::this_thread::sleep_for(window * 3);
+
+  REQUIRE(watcher.close());
+
+  fs::remove_all(test_store_path);
+  REQUIRE(! fs::exists(test_store_path));
+
+  auto created = 0;
+  auto destroyed = 0;
+  auto beneath = 0;
+  for (auto const& ev : event_recv_list) {
+    if (ev.where == tree_path && ev.what == event::what::create) ++created;
+    if (ev.where == tree_path && ev.what == event::what::destroy) ++destroyed;
+    if (ev.where.string().starts_with((tree_path / "").string())) ++beneath;
+  }
+
+  REQUIRE(created == 1);
+  REQUIRE(destroyed == 1);
+  REQUIRE(beneath == 0);
+  REQUIRE(event_recv_list.back().kind == event::kind::watcher);
+  REQUIRE(event_recv_list.back().what == event::what::destroy);
+};
+
+/* Test that a new directory which is written to, steadily,
+   is seen while it is still being written to, and that
+   what is written is seen too, and that one in which new
+   files are made, steadily, is also seen while they are
+   still being made. */
+TEST_CASE("Collapse Busy Tree", "[collapse]")
+{
+  namespace fs = ::std::filesystem;
+  using namespace ::wtr::watcher;
+  using namespace ::wtr::test_watcher;
+  using clock = std::chrono::steady_clock;
+
+  static constexpr auto title = "Collapse Busy Tree";
+  static constexpr auto window = std::chrono::milliseconds(100);
+  static constexpr auto write_count = 20;
+  static auto created_at = std::optional<clock::time_point>{};
+  static auto spool_created_at = std::optional<clock::time_point>{};
+  static auto written = 0;
+  static auto mtx = std::mutex{};
+  static auto const store_path = test_store_path / "collapse_busy_store";
+  static auto const logs_path = store_path / "logs";
+  static auto const spool_path = store_path / "spool";
+
+  std::cout << title << std::endl;
+
+  REQUIRE(fs::exists(seeded(store_path)));
+
+  auto watcher = watch(store_path,
+                       collapse(
+                         [](event const& ev)
+                         {
+                           auto _ = std::scoped_lock{mtx};
+                           if (ev.where == logs_path
+                               && ev.what == event::what::create)
+                             created_at = clock::now();
+                           if (ev.where == spool_path
+                               && ev.what == event::what::create)
+                             spool_created_at = clock::now();
+                           if (ev.where == logs_path / "out"
+                               && ev.what == event::what::modify)
+                             ++written;
+                         },
+                         window));
+
+  settle();
+
+  fs::create_directories(logs_path);
+  fs::create_directories(spool_path);
+  for (auto i = 0; i < write_count; ++i) {
+    std::ofstream{logs_path / "out", std::ios::app} << i << std::endl;
+    std::ofstream{spool_path / std::to_string(i)};
+    std::this_thread::sleep_for(window / 2);
+  }
+  auto const done_writing = clock::now();
+
+  settle();
+  REQUIRE(watcher.close());
+
+  fs::remove_all(test_store_path);
+  REQUIRE(! fs::exists(test_store_path));
+
+  auto _ = std::scoped_lock{mtx};
+  REQUIRE(created_at.has_value());
+  REQUIRE(*created_at < done_writing);
+  REQUIRE(written > 0);
+  REQUIRE(spool_created_at.has_value());
+  REQUIRE(*spool_created_at < done_writing);
+};
@@ -0,0 +1,135 @@
+/*
+   Test Watcher
+   Compact
+*/
+
+/* REQUIRE,
+   TEST_CASE */
+#include <snitch/snitch.hpp>
+/* event,
+   watch */
+#include <wtr/watcher.hpp>
+/* test_store_path */
+#include <test_watcher/test_watcher.hpp>
+/* cout, endl */
+#include <iostream>
+/* ofstream */
+#include <fstream>
+/* vector */
+#include <vector>
+/* string */
+#include <string>
+/* atomic */
+#include <atomic>
+/* milliseconds */
+#include <chrono>
+/* malloc */
+#include <cstdlib>
+/* bad_alloc */
+#include <new>
+/* mutex */
+#include <mutex>
+/* sleep_for,
+   thread::id,
+   this_thread::get_id */
+#include <thread>
+/* is_trivially_copyable_v */
+#include <type_traits>
+/* path,
+   create_directories,
+   remove_all */
+#include <filesystem>
+
+/* Allocations made on the watcher's thread, once we know
+   which thread that is. The default `delete` frees what
+   `malloc` gives. */
+static auto watcher_thread = std::atomic<std::thread::id>{};
+static auto watcher_allocs = std::atomic<long>{0};
+
+auto operator new(std::size_t n) -> void*
+{
+  if (std::this_thread::get_id() == watcher_thread.load()) ++watcher_allocs;
+  if (auto p = std::malloc(n ? n : 1)) return p;
+  throw std::bad_alloc{};
+}
+
+/* Test that compact events are what events are, without
+   the path, and that they convert both ways. */
+TEST_CASE("Compact Conversions", "[compact]")
+{
+  using namespace ::wtr::watcher;
+
+  static_assert(std::is_trivially_copyable_v<event::compact>);
+
+  auto const e = event{"/a/b", event::what::modify, event::kind::file, 7};
+  auto const c = event::compact{e};
+  REQUIRE(c.where == e.where.native());
+  REQUIRE(c.what == e.what);
+  REQUIRE(c.kind == e.kind);
+  REQUIRE(c.when == 7);
+  REQUIRE(event{c} == e);
+};
+
+/* Test that, once warmed up, the adapter sends compact
+   events without allocating. */
+TEST_CASE("Compact", "[compact]")
+{
+  namespace fs = ::std::filesystem;
+  using namespace ::wtr::watcher;
+  using namespace ::wtr::test_watcher;
+
+  static constexpr auto title = "Compact";
+  static constexpr auto warm = 8;
+  static auto seen = std::atomic<long>{0};
+  static auto allocs_when_warm = std::atomic<long>{-1};
+  static auto last_where = std::string{};
+  static auto last_where_mtx = std::mutex{};
+  static auto const store_path = test_store_path / "compact_store";
+
+  std::cout << title << std::endl;
+
+  fs::create_directories(store_path);
+  REQUIRE(fs::exists(store_path));
+
+  auto watcher = watch(store_path,
+                       [](event::compact const& ev)
+                       {
+                         if (ev.kind == event::kind::watcher) return;
+                         watcher_thread.store(std::this_thread::get_id());
+                         if (++seen == warm)
+                           allocs_when_warm.store(watcher_allocs.load());
+                         /* Not in here: copying out is up to us. */
+                         auto _ = std::scoped_lock{last_where_mtx};
+                         auto const t = watcher_thread.exchange({});
+                         last_where.assign(ev.where.begin(), ev.where.end());
+                         watcher_thread.store(t);
+                       });
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+  auto file = std::ofstream{store_path / "a.txt"};
+  for (auto i = 0; i < 256; ++i) {
+    file << i << std::endl;
+    std::this_thread::sleep_for(std::chrono::microseconds(200));
+  }
+  file.close();
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+  auto const allocs_after = watcher_allocs.load();
+  watcher_thread.store({});
+
+  REQUIRE(watcher.close());
+
+  fs::remove_all(test_store_path);
+  REQUIRE(! fs::exists(test_store_path));
+
+  std::cout << seen.load() << " events, "
+            << allocs_after - allocs_when_warm.load()
+            << " allocations after the first " << warm << std::endl;
+
+  REQUIRE(seen.load() > warm * 2);
+  REQUIRE(allocs_when_warm.load() >= 0);
+  REQUIRE(allocs_after - allocs_when_warm.load() == 0);
+  REQUIRE(last_where == (store_path / "a.txt").string());
+};
@@ -0,0 +1,190 @@
+/*
+   Test Watcher
+   Diag
+*/
+
+/* REQUIRE,
+   TEST_CASE */
+#include <snitch/snitch.hpp>
+/* event,
+   diag,
+   watch,
+   with_diags */
+#include <wtr/watcher.hpp>
+/* test_store_path,
+   seeded,
+   settle */
+#include <test_watcher/test_watcher.hpp>
+/* cout, endl */
+#include <iostream>
+/* ofstream */
+#include <fstream>
+/* vector */
+#include <vector>
+/* string */
+#include <string>
+/* mutex */
+#include <mutex>
+/* path,
+   remove_all */
+#include <filesystem>
+/* EACCES */
+#include <cerrno>
+
+/* Test that a diagnostic says what its message says, and
+   that we can read one back from a message. */
+TEST_CASE("Diag Message", "[diag]")
+{
+  using namespace ::wtr::watcher;
+
+  auto const d = diag{.level = diag::level::warning,
+                      .code = diag::code::not_watched,
+                      .where = "/a",
+                      .also = "/a/b"};
+  REQUIRE(d.message() == "w/sys/not_watched@/a@/a/b");
+  REQUIRE(d.what() == event::what::other);
+
+  auto const e = event{d.message(), d.what(), event::kind::watcher};
+  auto const back = diag::of(e);
+  REQUIRE(back.level == diag::level::warning);
+  REQUIRE(back.code == diag::code::not_watched);
+  REQUIRE(back.where == "/a");
+  REQUIRE(back.also == "/a/b");
+
+  auto const err = diag{.level = diag::level::error,
+                        .code = diag::code::fanotify_init,
+                        .error = EACCES,
+                        .where = "/a"};
+  auto const err_back =
+    diag::of(event{err.message(), err.what(), event::kind::watcher});
+  REQUIRE(err_back.code == diag::code::fanotify_init);
+  REQUIRE(err_back.level == diag::level::error);
+  REQUIRE(err_back.where == "/a");
+
+  auto const die = diag::of(
+    event{"s/self/die@/a", event::what::destroy, event::kind::watcher});
+  REQUIRE(die.code == diag::code::die);
+  REQUIRE(die.level == diag::level::status);
+  REQUIRE(die.what() == event::what::destroy);
+};
+
+#if defined(WATER_WATCHER_ADAPTER_LINUX_INOTIFY) \
+  || defined(WATER_WATCHER_ADAPTER_LINUX_FANOTIFY)
+
+/* Test that many warnings of one sort are counted and sent
+   once to a diagnostic callback, and sent one by one as
+   messages otherwise. */
+TEST_CASE("Diag Tally", "[diag]")
+{
+  using namespace ::wtr::watcher;
+  using ::detail::wtr::watcher::adapter::sink;
+  using ::detail::wtr::watcher::adapter::tally;
+
+  static constexpr auto many = 100'000;
+
+  auto told = std::vector<diag>{};
+  auto also = std::string{};
+  auto messages = 0;
+
+  auto const counting = sink<>{
+    .each = [&](event::compact const&) { ++messages; },
+    .diags = [&](diag const& d)
+    {
+      told.push_back(d);
+      also = d.also;
+    },
+  };
+  auto const messaging = sink<>{
+    .each = [&](event::compact const&) { ++messages; },
+  };
+
+  auto counted = tally{};
+  auto messaged = tally{};
+  for (auto i = 0; i < many; ++i) {
+    auto const dir = "/a/" + std::to_string(i);
+    auto const d = diag{.level = diag::level::warning,
+                        .code = diag::code::not_watched,
+                        .where = "/a",
+                        .also = dir};
+    counted(counting, d);
+    messaged(messaging, d);
+  }
+  counted.done(counting);
+  messaged.done(messaging);
+
+  REQUIRE(told.size() == 1);
+  REQUIRE(told.front().count == many);
+  REQUIRE(told.front().code == diag::code::not_watched);
+  REQUIRE(also == "/a/0");
+  REQUIRE(messages == many);
+};
+
+#endif
+
+/* Test that a watcher with a diagnostic callback tells it
+   when it is alive and dead, and doesn't send those as
+   events, while a watcher without one still does. */
+TEST_CASE("Diag", "[diag]")
+{
+  namespace fs = ::std::filesystem;
+  using namespace ::wtr::watcher;
+  using namespace ::wtr::test_watcher;
+
+  static constexpr auto title = "Diag";
+  static auto const store_path = test_store_path / "diag_store";
+  static auto events = std::vector<event>{};
+  static auto plain_events = std::vector<event>{};
+  static auto diags = std::vector<enum diag::code>{};
+  static auto diag_wheres = std::vector<std::string>{};
+  static auto mtx = std::mutex{};
+
+  std::cout << title << std::endl;
+
+  REQUIRE(fs::exists(seeded(store_path)));
+
+  auto w = watch(store_path,
+                 with_diags(
+                   [](event const& e)
+                   {
+                     auto _ = std::scoped_lock{mtx};
+                     events.push_back(e);
+                   },
+                   [](diag const& d)
+                   {
+                     auto _ = std::scoped_lock{mtx};
+                     diags.push_back(d.code);
+                     diag_wheres.emplace_back(d.where);
+                   }));
+  auto plain = watch(store_path,
+                     [](event const& e)
+                     {
+                       auto _ = std::scoped_lock{mtx};
+                       plain_events.push_back(e);
+                     });
+
+  settle();
+
+  std::ofstream{store_path / "a.txt"};
+
+  settle();
+
+  REQUIRE(w.close());
+  REQUIRE(plain.close());
+
+  fs::remove_all(test_store_path);
+  REQUIRE(! fs::exists(test_store_path));
+
+  for (auto const& e : events) REQUIRE(e.kind != event::kind::watcher);
+  REQUIRE(! events.empty());
+
+  REQUIRE(diags.size() >= 2);
+  REQUIRE(diags.front() == diag::code::live);
+  REQUIRE(diags.back() == diag::code::die);
+  REQUIRE(diag_wheres.front() == store_path.string());
+  REQUIRE(diag_wheres.back() == store_path.string());
+
+  REQUIRE(plain_events.front().kind == event::kind::watcher);
+  REQUIRE(plain_events.back().kind == event::kind::watcher);
+  REQUIRE(plain_events.back().where.string()
+          == "s/self/die@" + store_path.string());
+};
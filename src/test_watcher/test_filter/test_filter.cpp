@@ -0,0 +1,149 @@
+/*
+   Test Watcher
+   Filter
+*/
+
+/* REQUIRE,
+   TEST_CASE */
+#include <snitch/snitch.hpp>
+/* event,
+   watch,
+   filter */
+#include <wtr/watcher.hpp>
+/* test_store_path */
+#include <test_watcher/test_watcher.hpp>
+/* cout, endl */
+#include <iostream>
+/* ofstream */
+#include <fstream>
+/* vector */
+#include <vector>
+/* string */
+#include <string>
+/* milliseconds */
+#include <chrono>
+/* mutex */
+#include <mutex>
+/* sleep_for */
+#include <thread>
+/* path,
+   create_directories,
+   remove_all */
+#include <filesystem>
+
+/* Test that patterns match what `.gitignore` would. */
+TEST_CASE("Filter Patterns", "[filter]")
+{
+  using namespace ::wtr::watcher;
+
+  auto const file = event::kind::file;
+  auto const dir = event::kind::dir;
+
+  auto objects = filter{"*.o", "!vendor/"};
+  REQUIRE(objects.keeps("x.o", file));
+  REQUIRE(objects.keeps("a/b/x.o", file));
+  REQUIRE(! objects.keeps("x.c", file));
+  REQUIRE(! objects.keeps("vendor", dir));
+  REQUIRE(! objects.keeps("vendor/x.o", file));
+  REQUIRE(! objects.keeps("a/vendor/x.o", file));
+
+  auto anchored = filter{"/top", "docs/*.md", "a/**/b"};
+  REQUIRE(anchored.keeps("top", file));
+  REQUIRE(! anchored.keeps("x/top", file));
+  REQUIRE(anchored.keeps("docs/a.md", file));
+  REQUIRE(! anchored.keeps("docs/x/a.md", file));
+  REQUIRE(! anchored.keeps("x/docs/a.md", file));
+  REQUIRE(anchored.keeps("a/b", file));
+  REQUIRE(anchored.keeps("a/x/y/b", file));
+  REQUIRE(! anchored.keeps("ab", file));
+  REQUIRE(! anchored.keeps("a/xb", file));
+  REQUIRE(! anchored.keeps("a/x/yb", file));
+
+  /* Names are matched whole, not by their ends. */
+  auto names = filter{"foo", "**/bar"};
+  REQUIRE(names.keeps("foo", file));
+  REQUIRE(names.keeps("a/foo", file));
+  REQUIRE(! names.keeps("xfoo", file));
+  REQUIRE(! names.keeps("a/xfoo", file));
+  REQUIRE(names.keeps("bar", file));
+  REQUIRE(names.keeps("a/b/bar", file));
+  REQUIRE(! names.keeps("xbar", file));
+  REQUIRE(! names.keeps("a/xbar", file));
+
+  auto sets = filter{"[a-c]?.txt", "!b?.txt", "\\*"};
+  REQUIRE(sets.keeps("a1.txt", file));
+  REQUIRE(! sets.keeps("b1.txt", file));
+  REQUIRE(! sets.keeps("d1.txt", file));
+  REQUIRE(sets.keeps("*", file));
+  REQUIRE(! sets.keeps("x", file));
+
+  auto dirs_only = filter{"!build/"};
+  REQUIRE(dirs_only.keeps("build", file));
+  REQUIRE(! dirs_only.keeps("build", dir));
+  REQUIRE(! dirs_only.keeps("build/x", file));
+  REQUIRE(! dirs_only.keeps("a/build/x", file));
+  REQUIRE(dirs_only.keeps("mybuild", dir));
+  REQUIRE(dirs_only.keeps("mybuild/x", file));
+
+  REQUIRE(filter{}.keeps("anything", file));
+};
+
+/* Test that we only see events for what a filter keeps. */
+TEST_CASE("Filter", "[filter]")
+{
+  namespace fs = ::std::filesystem;
+  using namespace ::wtr::watcher;
+  using namespace ::wtr::test_watcher;
+
+  static constexpr auto title = "Filter";
+  static auto event_recv_list = std::vector<event>{};
+  static auto event_recv_list_mtx = std::mutex{};
+  static auto const store_path = test_store_path / "filter_store";
+
+  std::cout << title << std::endl;
+
+  fs::create_directories(store_path);
+  REQUIRE(fs::exists(store_path));
+
+  auto watcher = watch(store_path,
+                       filter{"*.txt", "!skip/"},
+                       [](event const& ev)
+                       {
+                         auto _ = std::scoped_lock{event_recv_list_mtx};
+                         std::cout << ev << std::endl;
+                         event_recv_list.push_back(ev);
+                       });
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+  fs::create_directories(store_path / "skip");
+  fs::create_directories(store_path / "keep");
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+  for (auto const& p : {"a.txt", "b.log", "skip/c.txt", "keep/d.txt"})
+    std::ofstream{store_path / p};
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+  REQUIRE(watcher.close());
+
+  fs::remove_all(test_store_path);
+  REQUIRE(! fs::exists(test_store_path));
+
+  auto seen = [](fs::path const& p)
+  {
+    for (auto const& ev : event_recv_list)
+      if (ev.where == p) return true;
+    return false;
+  };
+
+  REQUIRE(seen(store_path / "a.txt"));
+  REQUIRE(seen(store_path / "keep" / "d.txt"));
+  REQUIRE(! seen(store_path / "b.log"));
+  REQUIRE(! seen(store_path / "keep"));
+  REQUIRE(! seen(store_path / "skip"));
+  REQUIRE(! seen(store_path / "skip" / "c.txt"));
+
+  REQUIRE(event_recv_list.back().kind == event::kind::watcher);
+  REQUIRE(event_recv_list.back().what == event::what::destroy);
+};
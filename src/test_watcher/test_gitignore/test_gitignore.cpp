@@ -0,0 +1,164 @@
+/*
+   Test Watcher
+   Gitignore
+*/
+
+/* REQUIRE,
+   TEST_CASE */
+#include <snitch/snitch.hpp>
+/* event,
+   watch,
+   filter */
+#include <wtr/watcher.hpp>
+/* test_store_path */
+#include <test_watcher/test_watcher.hpp>
+/* cout, endl */
+#include <iostream>
+/* ofstream */
+#include <fstream>
+/* vector */
+#include <vector>
+/* string */
+#include <string>
+/* milliseconds */
+#include <chrono>
+/* mutex */
+#include <mutex>
+/* sleep_for */
+#include <thread>
+/* path,
+   create_directories,
+   remove_all */
+#include <filesystem>
+
+/* Test that what the `.gitignore` files in a tree ignore
+   is what git would ignore. */
+TEST_CASE("Gitignore Patterns", "[gitignore]")
+{
+  namespace fs = ::std::filesystem;
+  using namespace ::wtr::watcher;
+  using namespace ::wtr::test_watcher;
+
+  auto const file = event::kind::file;
+  auto const dir = event::kind::dir;
+  auto const root = test_store_path / "gitignore_patterns_store";
+
+  fs::create_directories(root / "sub");
+  fs::create_directories(root / "build");
+  fs::create_directories(root / "src");
+  std::ofstream{root / ".gitignore"} << "# comment\n"
+                                        "\n"
+                                        "*.log\n"
+                                        "build/\n"
+                                        "!keep.log\n";
+  std::ofstream{root / "sub" / ".gitignore"} << "!*.log\n"
+                                                "/local\n";
+  std::ofstream{root / "build" / ".gitignore"} << "!x\n";
+  std::ofstream{root / "src" / ".gitignore"} << "out\n";
+
+  auto ignores = filter::gitignore().loaded(root);
+  REQUIRE(ignores.keeps("a.txt", file));
+  REQUIRE(! ignores.keeps("a.log", file));
+  REQUIRE(! ignores.keeps("x/a.log", file));
+  REQUIRE(ignores.keeps("keep.log", file));
+  REQUIRE(ignores.keeps("x/keep.log", file));
+  REQUIRE(! ignores.keeps("build", dir));
+  REQUIRE(! ignores.keeps("build/x", file));
+  REQUIRE(ignores.keeps("sub/a.log", file));
+  REQUIRE(! ignores.keeps("sub/local", file));
+  REQUIRE(ignores.keeps("sub/x/local", file));
+  REQUIRE(ignores.keeps("local", file));
+  REQUIRE(! ignores.keeps(".git", dir));
+  REQUIRE(! ignores.keeps(".git/config", file));
+  REQUIRE(! ignores.keeps("src/out", file));
+  REQUIRE(! ignores.keeps("src/a/out", file));
+  REQUIRE(ignores.keeps("out", file));
+
+  /* Names are matched whole, not by their ends. */
+  REQUIRE(ignores.keeps("mybuild", dir));
+  REQUIRE(ignores.keeps("mybuild/x", file));
+  REQUIRE(ignores.keeps("src/mybuild/x.c", file));
+  REQUIRE(ignores.keeps("src/layout", file));
+  REQUIRE(ignores.keeps("x.git", dir));
+  REQUIRE(ignores.keeps("x.git/y", file));
+
+  auto narrowed = filter::gitignore({"!*.txt"}).loaded(root);
+  REQUIRE(! narrowed.keeps("a.txt", file));
+  REQUIRE(narrowed.keeps("a.c", file));
+  REQUIRE(! narrowed.keeps("a.log", file));
+
+  REQUIRE(ignores.reloads(std::string_view{".gitignore"}));
+  REQUIRE(! ignores.reloads(std::string_view{"gitignore"}));
+  REQUIRE(! filter{}.reloads(std::string_view{".gitignore"}));
+
+  fs::remove_all(test_store_path);
+  REQUIRE(! fs::exists(test_store_path));
+};
+
+/* Test that we don't see events for what is ignored, and
+   that we follow the `.gitignore` files as they change. */
+TEST_CASE("Gitignore", "[gitignore]")
+{
+  namespace fs = ::std::filesystem;
+  using namespace ::wtr::watcher;
+  using namespace ::wtr::test_watcher;
+
+  static constexpr auto title = "Gitignore";
+  static auto event_recv_list = std::vector<event>{};
+  static auto event_recv_list_mtx = std::mutex{};
+  static auto const store_path = test_store_path / "gitignore_store";
+
+  std::cout << title << std::endl;
+
+  fs::create_directories(store_path / "ignored");
+  std::ofstream{store_path / ".gitignore"} << "*.log\n"
+                                              "ignored/\n";
+  REQUIRE(fs::exists(store_path));
+
+  auto watcher = watch(store_path,
+                       filter::gitignore(),
+                       [](event const& ev)
+                       {
+                         auto _ = std::scoped_lock{event_recv_list_mtx};
+                         std::cout << ev << std::endl;
+                         event_recv_list.push_back(ev);
+                       });
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+  for (auto const& p : {"a.txt", "b.log", "ignored/c.txt"})
+    std::ofstream{store_path / p};
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+  std::ofstream{store_path / ".gitignore"} << "*.log\n";
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+  for (auto const& p : {"ignored/d.txt", "e.log"})
+    std::ofstream{store_path / p};
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+  REQUIRE(watcher.close());
+
+  fs::remove_all(test_store_path);
+  REQUIRE(! fs::exists(test_store_path));
+
+  auto seen = [](fs::path const& p)
+  {
+    for (auto const& ev : event_recv_list)
+      if (ev.where == p) return true;
+    return false;
+  };
+
+  REQUIRE(seen(store_path / "a.txt"));
+  REQUIRE(seen(store_path / ".gitignore"));
+  REQUIRE(seen(store_path / "ignored" / "d.txt"));
+  REQUIRE(! seen(store_path / "b.log"));
+  REQUIRE(! seen(store_path / "e.log"));
+  REQUIRE(! seen(store_path / "ignored" / "c.txt"));
+
+  REQUIRE(event_recv_list.back().kind == event::kind::watcher);
+  REQUIRE(event_recv_list.back().what == event::what::destroy);
+};
@@ -0,0 +1,104 @@
+/*
+   Test Watcher
+   Group
+*/
+
+/* REQUIRE,
+   TEST_CASE */
+#include <snitch/snitch.hpp>
+/* event,
+   group,
+   watch */
+#include <wtr/watcher.hpp>
+/* test_store_path,
+   seeded,
+   settle */
+#include <test_watcher/test_watcher.hpp>
+/* cout, endl */
+#include <iostream>
+/* ofstream */
+#include <fstream>
+/* vector */
+#include <vector>
+/* milliseconds,
+   steady_clock */
+#include <chrono>
+/* thread */
+#include <thread>
+/* path,
+   remove_all */
+#include <filesystem>
+
+/* Test that a group closes all of its watchers, cleanly,
+   in about the time it takes to close one, and that
+   closing one of them again does nothing, even when it
+   was closed on its own while its group was closing. */
+TEST_CASE("Group", "[group]")
+{
+  namespace fs = ::std::filesystem;
+  using namespace ::wtr::watcher;
+  using namespace ::wtr::test_watcher;
+  using clock = std::chrono::steady_clock;
+
+  static constexpr auto title = "Group";
+  static constexpr auto watcher_count = 32;
+  static auto const store_path = test_store_path / "group_store";
+
+  std::cout << title << std::endl;
+
+  REQUIRE(fs::exists(seeded(store_path)));
+
+  auto g = group{};
+  auto watchers = std::vector<decltype(watch(store_path, [](event const&) {}))>{};
+  for (auto i = 0; i < watcher_count; ++i) {
+    watchers.emplace_back(watch(store_path, [](event const&) {}));
+    g.add(watchers.back());
+  }
+  REQUIRE(g.size() == watcher_count);
+
+  settle();
+
+  auto const began = clock::now();
+  REQUIRE(g.close());
+  auto const took = clock::now() - began;
+
+  std::cout << "closed " << watcher_count << " in "
+            << std::chrono::duration<double, std::milli>(took).count() << " ms"
+            << std::endl;
+
+  REQUIRE(g.size() == 0);
+  /* One at a time, each could wait for as long as `delay_ms`. */
+  REQUIRE(took < std::chrono::milliseconds(policy::delay_ms)
+                   * (watcher_count / 2));
+  for (auto& w : watchers) REQUIRE(! w.close());
+
+  /* A watcher closed on its own is closed once. */
+  auto one = watch(store_path, [](event const&) {});
+  auto other = watch(store_path, [](event const&) {});
+  auto h = group{};
+  h.add(one).add(other);
+  settle(std::chrono::milliseconds(50));
+  REQUIRE(one.close());
+  REQUIRE(! h.close());
+  REQUIRE(! other.close());
+
+  /* Closed on their own, on another thread, while their
+     group closes: each is waited for once, by one of them. */
+  auto racing = std::vector<decltype(watch(store_path, [](event const&) {}))>{};
+  auto r = group{};
+  for (auto i = 0; i < watcher_count; ++i) {
+    racing.emplace_back(watch(store_path, [](event const&) {}));
+    r.add(racing.back());
+  }
+  settle(std::chrono::milliseconds(50));
+  auto closer = std::thread{[&]()
+                            {
+                              for (auto& w : racing) w.close();
+                            }};
+  r.close();
+  closer.join();
+  for (auto& w : racing) REQUIRE(! w.close());
+
+  fs::remove_all(test_store_path);
+  REQUIRE(! fs::exists(test_store_path));
+};
@@ -0,0 +1,142 @@
+/*
+   Test Watcher
+   Live Roots
+*/
+
+/* REQUIRE,
+   TEST_CASE */
+#include <snitch/snitch.hpp>
+/* event,
+   watch */
+#include <wtr/watcher.hpp>
+/* test_store_path,
+   seeded,
+   seen_type,
+   settle,
+   wait_for */
+#include <test_watcher/test_watcher.hpp>
+/* cout, endl */
+#include <iostream>
+/* ofstream */
+#include <fstream>
+/* uint32_t */
+#include <cstdint>
+/* optional */
+#include <optional>
+/* vector */
+#include <vector>
+/* path,
+   remove_all */
+#include <filesystem>
+
+namespace {
+
+namespace fs = ::std::filesystem;
+using namespace ::wtr::watcher;
+
+} /* namespace */
+
+/* Test that roots can be added to, and removed from, a
+   watcher while it runs, that an added root's events say
+   where it was put, and that the other roots are watched
+   all the while. */
+TEST_CASE("Live Roots", "[live_roots]")
+{
+  using namespace ::wtr::test_watcher;
+
+  static constexpr auto title = "Live Roots";
+  static auto const store_path = test_store_path / "live_roots_store";
+
+  std::cout << title << std::endl;
+
+  /* Added, then the first removed. */
+  {
+    auto const a = seeded(store_path / "a");
+    auto const b = seeded(store_path / "b");
+
+    auto seen = seen_type{};
+    auto w = watch(std::vector<fs::path>{a}, seen.callback());
+    settle();
+
+    std::ofstream{a / "before"};
+    REQUIRE(wait_for(seen, a / "before"));
+
+    auto const added = w.add_path(b);
+    REQUIRE(added.has_value());
+    REQUIRE(*added == 1);
+    settle();
+
+    std::ofstream{b / "added"};
+    std::ofstream{a / "still"};
+    REQUIRE(wait_for(seen, b / "added"));
+    REQUIRE(wait_for(seen, a / "still"));
+    for (auto const r : seen.of(b / "added")) REQUIRE(r == 1);
+    for (auto const r : seen.of(a / "still")) REQUIRE(r == 0);
+
+    REQUIRE(w.remove_path(a));
+    REQUIRE(! w.remove_path(a));
+    REQUIRE(! w.remove_path(store_path / "never"));
+    settle();
+
+    std::ofstream{a / "after"};
+    std::ofstream{b / "after"};
+    REQUIRE(wait_for(seen, b / "after"));
+    settle();
+    REQUIRE(! seen.has(a / "after"));
+
+    REQUIRE(w.close());
+    REQUIRE(! w.add_path(a).has_value());
+    REQUIRE(! w.remove_path(b));
+  }
+
+  /* Nested: the outer root takes back what an inner root,
+     once removed, had. */
+  {
+    auto const outer = seeded(store_path / "outer");
+    auto const inner = seeded(outer / "inner");
+
+    auto seen = seen_type{};
+    auto w = watch(std::vector<fs::path>{outer}, seen.callback());
+    settle();
+
+    REQUIRE(w.add_path(inner) == std::optional<std::uint32_t>{1});
+    settle();
+
+    std::ofstream{inner / "b"};
+    REQUIRE(wait_for(seen, inner / "b"));
+#if ! defined(WATER_WATCHER_USE_WARTHOG)
+    settle();
+    REQUIRE(seen.of(inner / "b") == std::vector<std::uint32_t>{1});
+#endif
+
+    REQUIRE(w.remove_path(inner));
+    settle();
+
+    std::ofstream{inner / "c"};
+    REQUIRE(wait_for(seen, inner / "c"));
+    settle();
+    REQUIRE(seen.of(inner / "c") == std::vector<std::uint32_t>{0});
+
+    REQUIRE(w.close());
+  }
+
+  /* From nothing. */
+  {
+    auto const c = seeded(store_path / "c");
+
+    auto seen = seen_type{};
+    auto w = watch(std::vector<fs::path>{}, seen.callback());
+    settle();
+
+    REQUIRE(w.add_path(c) == std::optional<std::uint32_t>{0});
+    settle();
+
+    std::ofstream{c / "late"};
+    REQUIRE(wait_for(seen, c / "late"));
+
+    REQUIRE(w.close());
+  }
+
+  fs::remove_all(test_store_path);
+  REQUIRE(! fs::exists(test_store_path));
+};
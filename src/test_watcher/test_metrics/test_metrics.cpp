@@ -0,0 +1,125 @@
+/*
+   Test Watcher
+   Metrics
+*/
+
+/* REQUIRE,
+   TEST_CASE */
+#include <snitch/snitch.hpp>
+/* event,
+   metrics,
+   watch */
+#include <wtr/watcher.hpp>
+/* test_store_path,
+   seeded,
+   settle */
+#include <test_watcher/test_watcher.hpp>
+/* cout, endl */
+#include <iostream>
+/* ofstream */
+#include <fstream>
+/* string */
+#include <string>
+/* milliseconds */
+#include <chrono>
+/* atomic */
+#include <atomic>
+/* path,
+   create_directories,
+   remove_all */
+#include <filesystem>
+
+/* Test that histograms put values in the bucket for their
+   width, and that quantiles are read from those buckets. */
+TEST_CASE("Metrics Histogram", "[metrics]")
+{
+  using namespace ::wtr::watcher;
+
+  auto m = metrics{};
+  m.read_events.record(0);
+  m.read_events.record(1);
+  m.read_events.record(3);
+  m.read_events.record(1000);
+  for (auto i = 0; i < 130; ++i)
+    m.sent([] {});
+
+  auto const s = m.snapshot();
+  REQUIRE(s.read_events.buckets[0] == 1);
+  REQUIRE(s.read_events.buckets[1] == 1);
+  REQUIRE(s.read_events.buckets[2] == 1);
+  REQUIRE(s.read_events.buckets[10] == 1);
+  REQUIRE(s.read_events.count() == 4);
+  REQUIRE(s.read_events.quantile(0.5) == 1);
+  REQUIRE(s.read_events.quantile(1.0) == 1023);
+  REQUIRE(s.events == 130);
+  /* The 1st, 65th and 129th were timed. */
+  REQUIRE(s.callback_ns.count() == 3);
+  REQUIRE(metrics::snapshot_type{}.callback_ns.quantile(0.5) == 0);
+};
+
+/* Test that a watcher counts what it does, that we can see
+   those counts while it runs, and that they only go up. */
+TEST_CASE("Metrics", "[metrics]")
+{
+  namespace fs = ::std::filesystem;
+  using namespace ::wtr::watcher;
+  using namespace ::wtr::test_watcher;
+
+  static constexpr auto title = "Metrics";
+  static constexpr auto file_count = 200;
+  static auto const store_path = test_store_path / "metrics_store";
+  static auto seen = std::atomic<unsigned long long>{0};
+
+  std::cout << title << std::endl;
+
+  seeded(store_path);
+  fs::create_directories(store_path / "sub");
+  REQUIRE(fs::exists(store_path / "sub"));
+
+  auto w = watch(store_path,
+                 [](event const& e)
+                 {
+                   if (e.kind != event::kind::watcher)
+                     seen.fetch_add(1, std::memory_order_relaxed);
+                 });
+
+  settle();
+
+  auto const before = w.metrics();
+
+  for (auto i = 0; i < file_count; ++i)
+    std::ofstream{store_path / ("f" + std::to_string(i) + ".txt")} << "x";
+
+  settle(std::chrono::milliseconds(200));
+
+  auto const during = w.metrics();
+
+  REQUIRE(w.close());
+
+  auto const after = w.metrics();
+
+  fs::remove_all(test_store_path);
+  REQUIRE(! fs::exists(test_store_path));
+
+  std::cout << "events: " << after.events << "\n"
+            << "reads: " << after.reads << "\n"
+            << "bytes_read: " << after.bytes_read << "\n"
+            << "full_reads: " << after.full_reads << "\n"
+            << "marks: " << after.marks << "\n"
+            << "callback_ns p50: " << after.callback_ns.quantile(0.5) << "\n"
+            << "read_events p99: " << after.read_events.quantile(0.99)
+            << std::endl;
+
+  REQUIRE(during.events >= file_count);
+  REQUIRE(during.events >= before.events);
+  REQUIRE(after.events >= during.events);
+  REQUIRE(after.events == seen.load());
+  REQUIRE(after.callback_ns.count() > 0);
+  REQUIRE(after.overflows == 0);
+#if defined(__linux__) && ! defined(WATER_WATCHER_USE_WARTHOG)
+  REQUIRE(during.reads > before.reads);
+  REQUIRE(after.bytes_read > 0);
+  REQUIRE(after.marks >= 2);
+  REQUIRE(after.read_events.count() > 0);
+#endif
+};
@@ -0,0 +1,161 @@
+/*
+   Test Watcher
+   Multi Root
+*/
+
+/* REQUIRE,
+   TEST_CASE */
+#include <snitch/snitch.hpp>
+/* event,
+   filter,
+   watch */
+#include <wtr/watcher.hpp>
+/* test_store_path,
+   kernel_instances,
+   seeded,
+   seen_type,
+   settle,
+   wait_for */
+#include <test_watcher/test_watcher.hpp>
+/* cout, endl */
+#include <iostream>
+/* ofstream */
+#include <fstream>
+/* milliseconds,
+   microseconds,
+   steady_clock */
+#include <chrono>
+/* atomic */
+#include <atomic>
+/* uint32_t,
+   uint64_t */
+#include <cstdint>
+/* string,
+   to_string */
+#include <string>
+/* sleep_for */
+#include <thread>
+/* vector */
+#include <vector>
+/* path,
+   remove_all */
+#include <filesystem>
+
+namespace {
+
+namespace fs = ::std::filesystem;
+using namespace ::wtr::watcher;
+
+} /* namespace */
+
+/* Test that one watcher, given many roots, watches them all
+   with one kernel instance, more of them than we may have
+   instances, and says which root each event is from, with
+   the filter matched relative to that root. */
+TEST_CASE("Multi Root", "[multi_root]")
+{
+  using namespace ::wtr::test_watcher;
+
+  static constexpr auto title = "Multi Root";
+  static auto const store_path = test_store_path / "multi_root_store";
+
+#if defined(WATER_WATCHER_USE_WARTHOG)
+  /* Each root is polled on its own. */
+  static constexpr auto root_count = 8;
+#else
+  static constexpr auto root_count = 200;
+#endif
+
+  std::cout << title << std::endl;
+
+  auto roots = std::vector<fs::path>{};
+  for (auto n = 0; n < root_count; ++n)
+    roots.push_back(seeded(store_path / ("r" + std::to_string(n))));
+  REQUIRE(fs::exists(roots.back()));
+
+  {
+    auto seen = seen_type{};
+    auto const before = kernel_instances();
+    auto w = watch(roots, filter{"*.txt"}, seen.callback());
+    settle();
+    auto const during = kernel_instances();
+
+    std::cout << "kernel instances: " << before << " -> " << during
+              << std::endl;
+#if defined(__linux__) && ! defined(WATER_WATCHER_USE_WARTHOG)
+    REQUIRE(during == before + 1);
+#endif
+
+    for (auto const& root : roots) {
+      std::ofstream{root / "kept.txt"};
+      std::ofstream{root / "dropped.log"};
+    }
+    for (auto n = 0u; n < roots.size(); ++n) {
+      auto const kept = roots[n] / "kept.txt";
+      REQUIRE(wait_for(seen, kept));
+      for (auto const r : seen.of(kept)) REQUIRE(r == n);
+    }
+    REQUIRE(! seen.has(roots.front() / "dropped.log"));
+    REQUIRE(! seen.has(roots.back() / "dropped.log"));
+
+    REQUIRE(w.close());
+  }
+
+  /* However the roots are watched, the callback is called
+     from one thread at a time, and every call is counted. */
+  {
+    auto inside = std::atomic<bool>{false};
+    auto overlapped = std::atomic<bool>{false};
+    auto calls = std::atomic<std::uint64_t>{0};
+    auto w = watch(roots,
+                   [&](event const& e)
+                   {
+                     if (e.kind == event::kind::watcher) return;
+                     if (inside.exchange(true)) overlapped = true;
+                     std::this_thread::sleep_for(std::chrono::microseconds(50));
+                     calls.fetch_add(1);
+                     inside = false;
+                   });
+    settle();
+
+    for (auto n = 0; n < 8; ++n)
+      for (auto const& root : roots)
+        std::ofstream{root / ("many." + std::to_string(n))};
+    auto const until =
+      std::chrono::steady_clock::now() + std::chrono::milliseconds(5'000);
+    while (calls < roots.size() * 8 && std::chrono::steady_clock::now() < until)
+      settle(std::chrono::milliseconds(10));
+
+    REQUIRE(w.close());
+    REQUIRE(calls >= roots.size() * 8);
+    REQUIRE(! overlapped);
+    REQUIRE(w.metrics().events == calls);
+  }
+
+  /* Nested roots: what happens beneath both is sent once,
+     for the deepest of them. */
+  {
+    auto const outer = store_path / "outer";
+    auto const inner = seeded(outer / "inner");
+
+    auto seen = seen_type{};
+    auto w = watch(std::vector<fs::path>{outer, inner}, seen.callback());
+    settle();
+
+    std::ofstream{outer / "a"};
+    std::ofstream{inner / "b"};
+    REQUIRE(wait_for(seen, outer / "a"));
+    REQUIRE(wait_for(seen, inner / "b"));
+    settle();
+
+    REQUIRE(seen.of(outer / "a") == std::vector<std::uint32_t>{0});
+#if ! defined(WATER_WATCHER_USE_WARTHOG)
+    REQUIRE(seen.of(inner / "b") == std::vector<std::uint32_t>{1});
+#endif
+
+    REQUIRE(w.close());
+  }
+
+  fs::remove_all(test_store_path);
+  REQUIRE(! fs::exists(test_store_path));
+};
@@ -8,7 +8,9 @@
 #include <snitch/snitch.hpp>
 /* event */
 #include <wtr/watcher.hpp>
-/* watch_gather */
+/* watch_gather,
+   seeded,
+   settle */
 #include <test_watcher/test_watcher.hpp>
 /* get */
 #include <tuple>
@@ -153,3 +155,50 @@ TEST_CASE("New Directories", "[new_directories]")
 
   REQUIRE(event_sent_list.size() == event_recv_list.size());
 };
+
+/* Test that directories which are made and removed as fast
+   as we can only give us events for paths beneath where we
+   watch, even when they are gone before we look. */
+TEST_CASE("New Directories Churn", "[new_directories]")
+{
+  namespace fs = ::std::filesystem;
+  using namespace ::wtr::watcher;
+  using namespace ::wtr::test_watcher;
+
+  static constexpr auto title = "New Directories Churn";
+  static auto const store_path = test_store_path / "churn_store";
+
+  std::cout << title << std::endl;
+
+  auto seen = std::vector<std::string>{};
+  auto seen_mtx = std::mutex{};
+
+  seeded(store_path);
+  {
+    auto w = watch(store_path,
+                   [&](event const& e)
+                   {
+                     if (e.kind == event::kind::watcher) return;
+                     auto _ = std::scoped_lock{seen_mtx};
+                     seen.push_back(e.where.string());
+                   });
+    settle();
+
+    for (int i = 0; i < 300; ++i) {
+      auto const top = store_path / ("d" + std::to_string(i % 5));
+      fs::create_directories(top / "x" / "y");
+      fs::remove_all(top);
+    }
+
+    settle(std::chrono::milliseconds(300));
+    REQUIRE(w.close());
+  }
+
+  fs::remove_all(test_store_path);
+  REQUIRE(! fs::exists(test_store_path));
+
+  auto _ = std::scoped_lock{seen_mtx};
+  REQUIRE(! seen.empty());
+  for (auto const& where : seen)
+    REQUIRE(where.starts_with(store_path.string() + "/"));
+};
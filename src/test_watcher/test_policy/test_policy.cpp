@@ -0,0 +1,157 @@
+/*
+   Test Watcher
+   Policy
+*/
+
+/* REQUIRE,
+   TEST_CASE */
+#include <snitch/snitch.hpp>
+/* event,
+   watch,
+   policy */
+#include <wtr/watcher.hpp>
+/* test_store_path,
+   seeded,
+   settle */
+#include <test_watcher/test_watcher.hpp>
+/* cout, endl */
+#include <iostream>
+/* ofstream */
+#include <fstream>
+/* vector */
+#include <vector>
+/* milliseconds */
+#include <chrono>
+/* mutex */
+#include <mutex>
+/* path,
+   remove_all */
+#include <filesystem>
+
+namespace {
+
+using namespace ::wtr::watcher;
+
+/* Says nothing about itself, and nothing about what is
+   modified. */
+struct quiet : policy {
+  static constexpr auto status = false;
+
+  static constexpr auto watches(enum event::what w) noexcept -> bool
+  {
+    return w != event::what::modify;
+  }
+};
+
+/* Reads more at once, and waits for less time. */
+struct roomy : policy {
+  static constexpr auto buf_len = 1 << 16;
+  static constexpr auto wait_max = 8;
+  static constexpr auto delay_ms = 4;
+  static constexpr auto clock = event::clock::none;
+};
+
+} /* namespace */
+
+/* Test that the default policy is what a watcher does
+   without one. */
+TEST_CASE("Policy Defaults", "[policy]")
+{
+  REQUIRE(policy::buf_len == 4096);
+  REQUIRE(policy::wait_max == 1);
+  REQUIRE(policy::delay_ms == 16);
+  REQUIRE(policy::clock == event::clock::system);
+  REQUIRE(policy::status);
+  REQUIRE(policy::watches(event::what::modify));
+  REQUIRE(quiet::buf_len == policy::buf_len);
+  REQUIRE(! quiet::watches(event::what::modify));
+  REQUIRE(quiet::watches(event::what::create));
+};
+
+/* Test that watchers do what their policies say: one which
+   sends neither its status nor modifications, and one with
+   bigger buffers and another clock, which sends it all. */
+TEST_CASE("Policy", "[policy]")
+{
+  namespace fs = ::std::filesystem;
+  using namespace ::wtr::test_watcher;
+
+  static constexpr auto title = "Policy";
+  static auto const store_path = test_store_path / "policy_store";
+  static auto quiet_seen = std::vector<event>{};
+  static auto roomy_seen = std::vector<event>{};
+  static auto roots_seen = std::vector<event>{};
+  static auto mtx = std::mutex{};
+
+  std::cout << title << std::endl;
+
+  REQUIRE(fs::exists(seeded(store_path)));
+
+  auto const keep_into = [](std::vector<event>& into)
+  {
+    return [&into](event const& e)
+    {
+      auto _ = std::scoped_lock{mtx};
+      into.push_back(e);
+    };
+  };
+
+  auto q = watch<quiet>(store_path, keep_into(quiet_seen));
+  auto r = watch<roomy>(store_path, keep_into(roomy_seen));
+  /* One of which isn't there, which it doesn't tell us,
+     nor about another which it is given later. */
+  auto qs = watch<quiet>({store_path, store_path / "nowhere"},
+                         keep_into(roots_seen));
+  qs.add_path(store_path / "nor_here");
+
+  settle();
+
+  std::ofstream{store_path / "a.txt"};
+  settle(std::chrono::milliseconds(50));
+  std::ofstream{store_path / "a.txt"} << "a";
+
+  settle();
+
+  REQUIRE(q.close());
+  REQUIRE(r.close());
+  /* Whether a watcher with a root which isn't there closes
+     well depends on the platform. */
+  qs.close();
+
+  fs::remove_all(test_store_path);
+  REQUIRE(! fs::exists(test_store_path));
+
+  auto const count = [](std::vector<event> const& in, auto const& is)
+  {
+    auto n = 0;
+    for (auto const& e : in) n += is(e) ? 1 : 0;
+    return n;
+  };
+  auto const from_watcher = [](event const& e)
+  { return e.kind == event::kind::watcher; };
+  /* Errors are always sent. */
+  auto const told = [](event const& e)
+  {
+    return e.kind == event::kind::watcher
+        && ! e.where.string().starts_with("e/");
+  };
+  auto const modified = [](event const& e)
+  { return e.what == event::what::modify; };
+  auto const created = [](event const& e)
+  { return e.what == event::what::create && e.kind == event::kind::file; };
+
+  REQUIRE(count(quiet_seen, from_watcher) == 0);
+  REQUIRE(count(quiet_seen, modified) == 0);
+  REQUIRE(count(quiet_seen, created) > 0);
+  REQUIRE(count(roots_seen, told) == 0);
+  REQUIRE(count(roots_seen, created) > 0);
+
+  REQUIRE(count(roomy_seen, from_watcher) == 2);
+  REQUIRE(count(roomy_seen, modified) > 0);
+  REQUIRE(count(roomy_seen, created) > 0);
+  REQUIRE(roomy_seen.back().what == event::what::destroy);
+#if defined(__linux__) && ! defined(WATER_WATCHER_USE_WARTHOG)
+  for (auto const& e : roomy_seen)
+    if (! from_watcher(e)) REQUIRE(e.when == 0);
+#endif
+};
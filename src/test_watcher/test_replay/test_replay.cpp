@@ -0,0 +1,151 @@
+/*
+   Test Watcher
+   Replay
+*/
+
+/* REQUIRE,
+   TEST_CASE */
+#include <snitch/snitch.hpp>
+/* event,
+   policy,
+   watch,
+   record,
+   recording,
+   play */
+#include <wtr/watcher.hpp>
+/* test_store_path */
+#include <test_watcher/test_watcher.hpp>
+/* cout, endl */
+#include <iostream>
+/* ofstream */
+#include <fstream>
+/* fopen, fclose */
+#include <cstdio>
+/* mutex, scoped_lock */
+#include <mutex>
+/* string */
+#include <string>
+/* tuple */
+#include <tuple>
+/* vector */
+#include <vector>
+/* milliseconds */
+#include <chrono>
+/* sleep_for */
+#include <thread>
+/* path,
+   create_directories,
+   remove_all */
+#include <filesystem>
+
+#if defined(__linux__) && ! defined(WATER_WATCHER_USE_WARTHOG)
+
+/* getpid */
+#include <unistd.h>
+
+namespace {
+
+using sent_type =
+  std::vector<std::tuple<std::string,
+                         enum ::wtr::watcher::event::what,
+                         enum ::wtr::watcher::event::kind>>;
+
+struct recorded : ::wtr::watcher::policy {
+  using sys = ::detail::wtr::watcher::adapter::record;
+};
+
+} /* namespace */
+
+/* Test that a session, recorded as it happens and played
+   back afterwards, sends the same events in the same order,
+   new directories and all, without the kernel. */
+TEST_CASE("Replay", "[replay]")
+{
+  namespace fs = ::std::filesystem;
+  namespace adapter = ::detail::wtr::watcher::adapter;
+  using namespace ::wtr::watcher;
+  using namespace ::wtr::test_watcher;
+
+  static constexpr auto title = "Replay";
+  static constexpr auto file_count = 50;
+  static auto const store_path = test_store_path / "replay_store";
+  auto const rec_path =
+    fs::temp_directory_path()
+    / ("wtr_test_replay." + std::to_string(getpid()) + ".rec");
+
+  std::cout << title << std::endl;
+
+  fs::create_directories(store_path / "sub");
+  REQUIRE(fs::exists(store_path / "sub"));
+
+  auto lk = std::mutex{};
+  auto live = sent_type{};
+
+  adapter::record::to = std::fopen(rec_path.c_str(), "wb");
+  REQUIRE(adapter::record::to);
+
+  auto w = watch<recorded>(
+    store_path,
+    [&](event const& e)
+    {
+      auto _ = std::scoped_lock{lk};
+      if (e.kind != event::kind::watcher)
+        live.emplace_back(e.where.string(), e.what, e.kind);
+    });
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+  for (auto i = 0; i < file_count; ++i)
+    std::ofstream{store_path / "sub" / ("f" + std::to_string(i) + ".txt")}
+      << "x";
+  fs::create_directory(store_path / "new");
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  for (auto i = 0; i < file_count; ++i)
+    std::ofstream{store_path / "new" / ("g" + std::to_string(i) + ".txt")}
+      << "x";
+  fs::rename(store_path / "new" / "g0.txt", store_path / "new" / "h0.txt");
+  fs::remove(store_path / "sub" / "f0.txt");
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+  REQUIRE(w.close());
+  std::fclose(adapter::record::to);
+  adapter::record::to = nullptr;
+
+  auto const rec = adapter::recording::load(rec_path);
+  auto replayed = sent_type{};
+  auto counts = metrics{};
+  auto const played = adapter::play(
+    rec,
+    [&](event::compact const& e) noexcept
+    {
+      if (e.kind != event::kind::watcher)
+        replayed.emplace_back(std::string{e.where}, e.what, e.kind);
+    },
+    &counts);
+
+  fs::remove_all(test_store_path);
+  fs::remove(rec_path);
+  REQUIRE(! fs::exists(test_store_path));
+
+  std::cout << "entries: " << rec.entries.size() << "\n"
+            << "from: " << (rec.from_inotify() ? "inotify" : "fanotify")
+            << "\n"
+            << "live: " << live.size() << "\n"
+            << "replayed: " << replayed.size() << std::endl;
+
+  REQUIRE(played);
+  REQUIRE(rec.root() == store_path.native());
+  REQUIRE(live.size() >= 2 * file_count);
+  REQUIRE(counts.events.load() == replayed.size());
+  REQUIRE(replayed == live);
+};
+
+#else
+
+TEST_CASE("Replay", "[replay]")
+{
+  std::cout << "Replay: only the Linux adapters record" << std::endl;
+};
+
+#endif
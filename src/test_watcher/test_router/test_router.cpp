@@ -0,0 +1,120 @@
+/*
+   Test Watcher
+   Router
+*/
+
+/* REQUIRE,
+   TEST_CASE */
+#include <snitch/snitch.hpp>
+/* event,
+   router,
+   watch */
+#include <wtr/watcher.hpp>
+/* test_store_path,
+   seeded,
+   seen_type,
+   settle,
+   wait_for */
+#include <test_watcher/test_watcher.hpp>
+/* cout, endl */
+#include <iostream>
+/* ofstream */
+#include <fstream>
+/* string */
+#include <string>
+/* vector */
+#include <vector>
+/* path,
+   remove_all */
+#include <filesystem>
+
+namespace {
+
+namespace fs = ::std::filesystem;
+using namespace ::wtr::watcher;
+
+} /* namespace */
+
+/* Test that each event is sent to those who subscribed to
+   a path it happened beneath, by whole components, if their
+   mask has what happened and the kind of path, and that a
+   router can be given to a watcher. */
+TEST_CASE("Router", "[router]")
+{
+  using namespace ::wtr::test_watcher;
+  using what = enum event::what;
+  using kind = enum event::kind;
+
+  static constexpr auto title = "Router";
+  static auto const store_path = test_store_path / "router_store";
+
+  std::cout << title << std::endl;
+
+  {
+    auto r = router{};
+    auto srv = seen_type{};
+    auto app = seen_type{};
+    auto config = seen_type{};
+    auto other = seen_type{};
+
+    r.subscribe("/srv", srv.callback(), {.kind = {kind::dir}});
+    r.subscribe("/srv/app", app.callback());
+    auto const c = r.subscribe("/srv/app/config",
+                               config.callback(),
+                               {.what = {what::modify}});
+    r.subscribe("/other", other.callback());
+    REQUIRE(r.size() == 4);
+
+    r({"/srv/app/config/x", what::modify, kind::file});
+    r({"/srv/app/config/y", what::create, kind::file});
+    r({"/srv/apple", what::create, kind::dir});
+    r({"/srv/app", what::destroy, kind::dir});
+    r({"s/self/live@/srv", what::create, kind::watcher});
+
+    auto const srv_saw = std::vector<std::string>{"/srv/apple", "/srv/app"};
+    auto const app_saw = std::vector<std::string>{"/srv/app/config/x",
+                                                  "/srv/app/config/y",
+                                                  "/srv/app",
+                                                  "s/self/live@/srv"};
+    auto const config_saw = std::vector<std::string>{"/srv/app/config/x"};
+    auto const other_saw = std::vector<std::string>{"s/self/live@/srv"};
+    REQUIRE(srv.paths == srv_saw);
+    REQUIRE(app.paths == app_saw);
+    REQUIRE(config.paths == config_saw);
+    REQUIRE(other.paths == other_saw);
+
+    REQUIRE(r.unsubscribe(c));
+    REQUIRE(! r.unsubscribe(c));
+    REQUIRE(r.size() == 3);
+    r({"/srv/app/config/z", what::modify, kind::file});
+    REQUIRE(config.count() == 1);
+    REQUIRE(app.has("/srv/app/config/z"));
+  }
+
+  /* Given to a watcher. */
+  {
+    auto const a = seeded(store_path / "a");
+    auto const b = seeded(store_path / "b");
+
+    auto r = router{};
+    auto in_a = seen_type{};
+    auto in_b = seen_type{};
+    r.subscribe(a, in_a.callback());
+    r.subscribe(b, in_b.callback());
+
+    auto w = watch(store_path, r);
+    settle();
+
+    std::ofstream{a / "x"};
+    std::ofstream{b / "y"};
+    REQUIRE(wait_for(in_a, a / "x"));
+    REQUIRE(wait_for(in_b, b / "y"));
+    REQUIRE(! in_a.has(b / "y"));
+    REQUIRE(! in_b.has(a / "x"));
+
+    REQUIRE(w.close());
+  }
+
+  fs::remove_all(test_store_path);
+  REQUIRE(! fs::exists(test_store_path));
+};
@@ -0,0 +1,116 @@
+/*
+   Test Watcher
+   Share
+*/
+
+/* REQUIRE,
+   TEST_CASE */
+#include <snitch/snitch.hpp>
+/* event,
+   filter,
+   share */
+#include <wtr/watcher.hpp>
+/* test_store_path,
+   kernel_instances,
+   seeded,
+   seen_type,
+   settle,
+   wait_for */
+#include <test_watcher/test_watcher.hpp>
+/* cout, endl */
+#include <iostream>
+/* ofstream */
+#include <fstream>
+/* path,
+   canonical,
+   remove_all */
+#include <filesystem>
+
+namespace {
+
+namespace fs = ::std::filesystem;
+using namespace ::wtr::watcher;
+
+} /* namespace */
+
+/* Test that shared watches on trees inside each other share
+   one kernel instance, that each is sent what happened
+   beneath its own path (and what its filter keeps), that
+   closing the outer one leaves the inner one watching, and
+   that closing the last one closes the watcher. */
+TEST_CASE("Share", "[share]")
+{
+  using namespace ::wtr::test_watcher;
+
+  static constexpr auto title = "Share";
+  static auto const store_path = test_store_path / "share_store";
+
+  std::cout << title << std::endl;
+
+  /* As the watcher has them, with no links. */
+  auto const app = fs::canonical(seeded(store_path / "app"));
+  auto const config = fs::canonical(seeded(app / "config"));
+
+  auto const before = kernel_instances();
+
+  auto outer = seen_type{};
+  auto inner = seen_type{};
+  auto toml = seen_type{};
+  auto a = share(app, outer.callback());
+  auto b = share(config, inner.callback());
+  auto c = share(config, filter{"*.toml"}, toml.callback());
+  settle();
+
+  std::cout << "kernel instances: " << before << " -> " << kernel_instances()
+            << std::endl;
+#if defined(__linux__) && ! defined(WATER_WATCHER_USE_WARTHOG)
+  REQUIRE(kernel_instances() == before + 1);
+#endif
+
+  std::ofstream{app / "a"};
+  std::ofstream{config / "b.toml"};
+  std::ofstream{config / "c.log"};
+  REQUIRE(wait_for(outer, app / "a"));
+  REQUIRE(wait_for(outer, config / "b.toml"));
+  REQUIRE(wait_for(outer, config / "c.log"));
+  REQUIRE(wait_for(inner, config / "b.toml"));
+  REQUIRE(wait_for(inner, config / "c.log"));
+  REQUIRE(wait_for(toml, config / "b.toml"));
+  settle();
+  REQUIRE(! inner.has(app / "a"));
+  REQUIRE(! toml.has(app / "a"));
+  REQUIRE(! toml.has(config / "c.log"));
+
+  /* The outer watch goes, the inner ones stay. */
+  REQUIRE(a.close());
+  REQUIRE(! a.close());
+  settle();
+
+  std::ofstream{app / "d"};
+  std::ofstream{config / "e.toml"};
+  REQUIRE(wait_for(inner, config / "e.toml"));
+  REQUIRE(wait_for(toml, config / "e.toml"));
+  settle();
+  REQUIRE(! outer.has(app / "d"));
+  REQUIRE(! inner.has(app / "d"));
+#if defined(__linux__) && ! defined(WATER_WATCHER_USE_WARTHOG)
+  REQUIRE(kernel_instances() == before + 1);
+#endif
+
+  /* The last one closes the watcher. */
+  REQUIRE(b.close());
+  REQUIRE(c.close());
+  REQUIRE(! c());
+  REQUIRE(kernel_instances() == before);
+
+  /* And the next one opens another. */
+  auto again = seen_type{};
+  auto d = share(app, again.callback());
+  settle();
+  std::ofstream{app / "f"};
+  REQUIRE(wait_for(again, app / "f"));
+  REQUIRE(d.close());
+
+  fs::remove_all(test_store_path);
+  REQUIRE(! fs::exists(test_store_path));
+};
@@ -0,0 +1,87 @@
+/*
+   Test Watcher
+   Stress
+*/
+
+/* REQUIRE,
+   TEST_CASE */
+#include <snitch/snitch.hpp>
+/* event,
+   watch */
+#include <wtr/watcher.hpp>
+/* test_store_path,
+   stress */
+#include <test_watcher/test_watcher.hpp>
+/* cout, endl */
+#include <iostream>
+/* milliseconds */
+#include <chrono>
+/* sleep_for */
+#include <thread>
+/* path,
+   create_directories,
+   remove_all */
+#include <filesystem>
+
+#if defined(__linux__)
+/* geteuid */
+#include <unistd.h>
+#endif
+
+/* Test that, with many threads making, writing to, renaming
+   and removing files at once, everything they did is seen,
+   and nothing they didn't. */
+TEST_CASE("Stress", "[stress]")
+{
+  namespace fs = ::std::filesystem;
+  using namespace ::wtr::watcher;
+  using namespace ::wtr::test_watcher;
+
+  static constexpr auto title = "Stress";
+  static auto const store_path = test_store_path / "stress_store";
+
+  std::cout << title << std::endl;
+
+#if defined(WATER_WATCHER_USE_WARTHOG)
+  /* The polling adapter sees what is there when it looks,
+     not what happened in between. */
+  std::cout << "Stress: not for the polling adapter" << std::endl;
+#else
+  fs::create_directories(store_path);
+  REQUIRE(fs::exists(store_path));
+
+#if defined(__linux__)
+  /* Root is watched with `fanotify`, which merges events. */
+  auto const merged = geteuid() == 0;
+#else
+  auto const merged = false;
+#endif
+
+  auto s = stress{store_path, {.threads = 4, .ops = 1'000, .merged = merged}};
+  auto w = watch(store_path, s.callback());
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+  auto const ops = s.run();
+  auto const r = s.verify();
+
+  REQUIRE(w.close());
+
+  fs::remove_all(test_store_path);
+  REQUIRE(! fs::exists(test_store_path));
+
+  std::cout << "ops: " << r.ops << " in " << r.run_s << "s\n"
+            << "expected: " << r.expected << "\n"
+            << "seen: " << r.seen << "\n"
+            << "missing: " << r.missing << "\n"
+            << "unexpected: " << r.unexpected << "\n"
+            << "settled in: " << r.settle_s << "s" << std::endl;
+  for (auto const& m : r.missing_list) std::cout << "missing: " << m << "\n";
+  for (auto const& u : r.unexpected_list)
+    std::cout << "unexpected: " << u << "\n";
+
+  REQUIRE(ops == 4'000);
+  /* Each cycle touches two names, with four things. */
+  REQUIRE(r.expected == (merged ? 2 : 4) * 4'000);
+  REQUIRE(r.ok());
+#endif
+};
@@ -0,0 +1,147 @@
+/*
+   Test Watcher
+   Synthetic
+*/
+
+/* REQUIRE,
+   TEST_CASE */
+#include <snitch/snitch.hpp>
+/* event,
+   filter,
+   policy,
+   synthetic,
+   watch */
+#include <wtr/watcher.hpp>
+/* cout, endl */
+#include <iostream>
+/* string */
+#include <string>
+/* unordered_map */
+#include <unordered_map>
+/* max_element */
+#include <algorithm>
+/* milliseconds,
+   steady_clock */
+#include <chrono>
+/* mutex,
+   scoped_lock */
+#include <mutex>
+/* sleep_for */
+#include <thread>
+/* vector */
+#include <vector>
+
+namespace {
+
+using namespace ::wtr::watcher;
+
+struct only_modify : policy {
+  static constexpr auto watches(enum event::what w) noexcept -> bool
+  {
+    return w == event::what::modify;
+  }
+};
+
+/* What a watcher made of `stream`, once it has made it all. */
+template<class Policy = policy>
+auto made_of(synthetic const& stream, filter const& f = {})
+{
+  struct seen {
+    std::vector<std::string> where{};
+    std::vector<enum event::what> what{};
+    unsigned long long events{};
+    double ms{};
+  };
+
+  auto lk = std::mutex{};
+  auto s = seen{};
+  auto const began = std::chrono::steady_clock::now();
+  auto w = watch<Policy>("/wtr/synthetic",
+                         f,
+                         stream,
+                         [&](event::compact const& e) noexcept
+                         {
+                           if (e.kind == event::kind::watcher) return;
+                           auto _ = std::scoped_lock{lk};
+                           s.where.emplace_back(e.where);
+                           s.what.push_back(e.what);
+                         });
+  /* Until it has made all it will. */
+  for (auto last = ~0ull; w.metrics().reads != last;) {
+    last = w.metrics().reads;
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  }
+  s.ms = std::chrono::duration<double, std::milli>(
+           std::chrono::steady_clock::now() - began)
+           .count();
+  s.events = w.metrics().events;
+  REQUIRE(w.close());
+  return s;
+}
+
+} /* namespace */
+
+/* Test that a synthetic watcher makes as many events as it
+   was asked to, the same ones for the same seed, at about
+   the rate it was asked to, from a skewed distribution, and
+   that its filter and policy are followed. */
+TEST_CASE("Synthetic", "[synthetic]")
+{
+  static constexpr auto title = "Synthetic";
+  static constexpr auto count = 100'000ull;
+
+  std::cout << title << std::endl;
+
+  auto const a = made_of(synthetic{.count = count, .seed = 7});
+  auto const b = made_of(synthetic{.count = count, .seed = 7});
+  auto const c = made_of(synthetic{.count = count, .seed = 8});
+  REQUIRE(a.where.size() == count);
+  REQUIRE(a.events == count);
+  REQUIRE(a.where == b.where);
+  REQUIRE(a.what == b.what);
+  REQUIRE(a.where != c.where);
+  for (auto const& p : a.where) REQUIRE(p.starts_with("/wtr/synthetic/d"));
+
+  auto const cpp = made_of(synthetic{.count = count}, filter{"*.cpp"});
+  std::cout << "kept by *.cpp: " << cpp.where.size() << std::endl;
+  REQUIRE(cpp.where.size() > count / 8);
+  REQUIRE(cpp.where.size() < count / 2);
+  for (auto const& p : cpp.where) REQUIRE(p.ends_with(".cpp"));
+
+  auto const modified = made_of<only_modify>(synthetic{.count = count});
+  REQUIRE(modified.where.size() > 0);
+  REQUIRE(modified.where.size() < count);
+  for (auto const w : modified.what) REQUIRE(w == event::what::modify);
+
+  /* A uniform pick over 4096 files sees the hottest one a
+     few dozen times. Zipf's sees it thousands. */
+  auto const hottest = [](auto const& where)
+  {
+    auto seen = std::unordered_map<std::string, unsigned long long>{};
+    for (auto const& p : where) ++seen[p];
+    return std::max_element(seen.begin(),
+                            seen.end(),
+                            [](auto const& l, auto const& r)
+                            { return l.second < r.second; })
+      ->second;
+  };
+  auto const skewed = made_of(synthetic{.count = count, .skew = 1.2});
+  std::cout << "hottest, uniform: " << hottest(a.where) << "\n"
+            << "hottest, skewed: " << hottest(skewed.where) << std::endl;
+  REQUIRE(hottest(skewed.where) > 10 * hottest(a.where));
+
+  /* 2000 events at 20000 a second take 100ms. */
+  auto const paced = made_of(synthetic{.rate = 20'000, .count = 2'000});
+  std::cout << "paced ms: " << paced.ms << std::endl;
+  REQUIRE(paced.where.size() == 2'000);
+  REQUIRE(paced.ms >= 90);
+
+  /* Four bursts of 500, with 50ms between them. */
+  auto const bursts = made_of(synthetic{.count = 2'000,
+                                        .shape = synthetic::shape::bursts,
+                                        .burst = 500,
+                                        .pause_ms = 50});
+  std::cout << "bursts ms: " << bursts.ms << std::endl;
+  REQUIRE(bursts.where.size() == 2'000);
+  REQUIRE(bursts.ms >= 150);
+};
@@ -0,0 +1,167 @@
+/*
+   Test Watcher
+   Trace
+*/
+
+/* REQUIRE,
+   TEST_CASE */
+#include <snitch/snitch.hpp>
+/* event,
+   policy,
+   trace,
+   watch */
+#include <wtr/watcher.hpp>
+/* test_store_path,
+   seeded,
+   settle */
+#include <test_watcher/test_watcher.hpp>
+/* cout, endl */
+#include <iostream>
+/* ofstream */
+#include <fstream>
+/* string */
+#include <string>
+/* milliseconds */
+#include <chrono>
+/* atomic */
+#include <atomic>
+/* path,
+   create_directories,
+   remove_all */
+#include <filesystem>
+
+namespace {
+
+using count_type = std::atomic<unsigned long long>;
+
+/* Counts what each hook hears. */
+struct counting : ::wtr::watcher::trace {
+  static constexpr auto on = true;
+
+  static inline auto reads = count_type{0};
+  static inline auto bytes = count_type{0};
+  static inline auto decodes = count_type{0};
+  static inline auto sends_begun = count_type{0};
+  static inline auto sends_ended = count_type{0};
+  static inline auto marks = count_type{0};
+  static inline auto walks_begun = count_type{0};
+  static inline auto walks_ended = count_type{0};
+  static inline auto walked = count_type{0};
+
+  static auto read(long long n, long long) noexcept -> void
+  {
+    reads += 1;
+    if (n > 0) bytes += n;
+  }
+
+  static auto decoded(enum ::wtr::watcher::event::what,
+                      enum ::wtr::watcher::event::kind,
+                      std::size_t) noexcept -> void
+  {
+    decodes += 1;
+  }
+
+  static auto send_begin(enum ::wtr::watcher::event::what,
+                         enum ::wtr::watcher::event::kind) noexcept -> void
+  {
+    sends_begun += 1;
+  }
+
+  static auto send_end(long long ns) noexcept -> void
+  {
+    if (ns >= 0) sends_ended += 1;
+  }
+
+  static auto mark(std::filesystem::path const&, bool ok) noexcept -> void
+  {
+    if (ok) marks += 1;
+  }
+
+  static auto walk_begin(std::filesystem::path const&) noexcept -> void
+  {
+    walks_begun += 1;
+  }
+
+  static auto walk_end(std::filesystem::path const&,
+                       std::size_t n,
+                       long long) noexcept -> void
+  {
+    walks_ended += 1;
+    walked = n;
+  }
+};
+
+struct traced : ::wtr::watcher::policy {
+  using trace = counting;
+};
+
+} /* namespace */
+
+/* The default trace is off, and has nothing to time. */
+static_assert(! ::wtr::watcher::policy::trace::on);
+
+/* Test that a watcher with a trace tells it about its walk,
+   its reads, what it decodes and what it sends, and that
+   each send it begins, it ends. */
+TEST_CASE("Trace", "[trace]")
+{
+  namespace fs = ::std::filesystem;
+  using namespace ::wtr::watcher;
+  using namespace ::wtr::test_watcher;
+
+  static constexpr auto title = "Trace";
+  static constexpr auto file_count = 50;
+  static auto const store_path = test_store_path / "trace_store";
+  static auto seen = count_type{0};
+
+  std::cout << title << std::endl;
+
+  seeded(store_path);
+  fs::create_directories(store_path / "sub");
+  REQUIRE(fs::exists(store_path / "sub"));
+
+  auto w = watch<traced>(store_path,
+                         [](event const& e)
+                         {
+                           if (e.kind != event::kind::watcher)
+                             seen.fetch_add(1, std::memory_order_relaxed);
+                         });
+
+  settle();
+
+  for (auto i = 0; i < file_count; ++i)
+    std::ofstream{store_path / ("f" + std::to_string(i) + ".txt")} << "x";
+  fs::create_directory(store_path / "new");
+
+  settle(std::chrono::milliseconds(200));
+
+  REQUIRE(w.close());
+
+  fs::remove_all(test_store_path);
+  REQUIRE(! fs::exists(test_store_path));
+
+  std::cout << "reads: " << counting::reads << "\n"
+            << "bytes: " << counting::bytes << "\n"
+            << "decodes: " << counting::decodes << "\n"
+            << "sends: " << counting::sends_ended << "\n"
+            << "marks: " << counting::marks << "\n"
+            << "walks: " << counting::walks_ended << std::endl;
+
+  REQUIRE(seen.load() >= file_count);
+  REQUIRE(counting::sends_begun == seen.load());
+  REQUIRE(counting::sends_ended == seen.load());
+#if defined(__linux__) && ! defined(WATER_WATCHER_USE_WARTHOG)
+  REQUIRE(counting::walks_begun == 1);
+  REQUIRE(counting::walks_ended == 1);
+  REQUIRE(counting::walked >= 2);
+  /* Two for the walk, and one for the new directory. */
+  REQUIRE(counting::marks >= 3);
+  REQUIRE(counting::reads > 0);
+  REQUIRE(counting::bytes > 0);
+  REQUIRE(counting::decodes >= seen.load());
+#else
+  REQUIRE(counting::walks_begun == counting::walks_ended);
+  REQUIRE(counting::walks_ended >= 1);
+  REQUIRE(counting::decodes >= seen.load());
+#endif
+};
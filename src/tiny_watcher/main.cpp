@@ -13,7 +13,7 @@ int main()
     // std::cout << e << "," << std::endl;
 
     // And you can unfold the event like this:
-    // auto [where, kind, what, when] = e;
+    // auto [where, what, kind, when, clock, root] = e;
   };
 
   // Watch the current directory asynchronously.